@@ -17,14 +17,20 @@ layout (location = 0) in vec2 inUV;
 // Final screen color 
 layout (location = 0) out vec4 outFragcolor;
 
+// Size of the light cluster grid, see @LightClusterGrid.h
+#define CLUSTER_TILES_X 16
+#define CLUSTER_TILES_Y 9
+#define CLUSTER_SLICES 24
+
 // Lighting data Uniform buffer
 layout (binding = 6) uniform LightingData 
 {
     uint DirLightCount;
     uint PointLightCount;
+    float ClusterSliceScale;
+    float ClusterSliceBias;
 
 	DirLight DirLights[8];  // see @GeometrySubpass.h for the defintions of this
-    PointLight PointLights[128];
 } lights;
 
 // Camera info UBO that we will use for PBR
@@ -37,6 +43,37 @@ layout (binding = 7) uniform UBO
     float exposure;
 } ubo;
 
+// Every point light in the scene
+layout (std430, binding = 8) readonly buffer PointLightData
+{
+    PointLight PointLights[];
+} pointLights;
+
+// Offset and count of each cluster's lights in the light index list
+layout (std430, binding = 9) readonly buffer ClusterData
+{
+    uvec2 Clusters[];
+} clusters;
+
+layout (std430, binding = 10) readonly buffer LightIndexData
+{
+    uint LightIndices[];
+} lightIndices;
+
+// Find the cluster of a world position the same way that the CPU bins lights into them
+uint GetClusterIndex(vec3 worldPos)
+{
+    vec4 viewPos = ubo.modelview * vec4(worldPos, 1.0);
+    vec4 clipPos = ubo.projection * viewPos;
+    vec2 ndc = clipPos.xy / clipPos.w;
+
+    uvec2 tile = uvec2(clamp(floor((ndc * 0.5 + 0.5) * vec2(CLUSTER_TILES_X, CLUSTER_TILES_Y)), vec2(0.0), vec2(CLUSTER_TILES_X - 1, CLUSTER_TILES_Y - 1)));
+    float depth = max(-viewPos.z, 1e-6);
+    uint slice = uint(clamp(floor(log(depth) * lights.ClusterSliceScale + lights.ClusterSliceBias), 0.0, float(CLUSTER_SLICES - 1)));
+
+    return (slice * CLUSTER_TILES_Y + tile.y) * CLUSTER_TILES_X + tile.x;
+}
+
 void main() 
 {
 	// Get G-Buffer values
@@ -69,18 +106,22 @@ void main()
     }
 
 	// Point lights -------------------------
-    for(uint i = 0; i < lights.PointLightCount; i++)
+    // Only the lights binned into this pixel's cluster can reach it
+    uvec2 cluster = clusters.Clusters[GetClusterIndex(fragPos)];
+    for(uint i = 0; i < cluster.y; i++)
     {
+        PointLight light = pointLights.PointLights[lightIndices.LightIndices[cluster.x + i]];
+
         // Vector to light
-		vec3 L = lights.PointLights[i].Pos.xyz - fragPos;
+		vec3 L = light.Pos.xyz - fragPos;
 		// Distance from light to fragment position
 		float dist = length(L);
 
         // Only calculate lights that are in the range of this light
-        if(dist < lights.PointLights[i].Range)
+        if(dist < light.Range)
         {
             LightColor += CalculatePointLight( 
-                lights.PointLights[ i ], 
+                light, 
                 normal, 
                 fragPos,
                 ubo.camPos.xyz, 
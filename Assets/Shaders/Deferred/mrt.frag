@@ -23,7 +23,10 @@ layout (location = 4) out vec4 outRoughness;
 // Perturb normal, see http://www.thetenthplanet.de/archives/1180
 vec3 perturbNormal()
 {
-	vec3 tangentNormal = texture(samplerNormalMap, inUV).xyz * 2.0 - 1.0;
+	// Only XY are stored in BC5 normal maps, so rebuild Z from them
+	vec3 tangentNormal;
+	tangentNormal.xy = texture(samplerNormalMap, inUV).xy * 2.0 - 1.0;
+	tangentNormal.z = sqrt(max(1.0 - dot(tangentNormal.xy, tangentNormal.xy), 0.0));
 
 	vec3 q1 = dFdx(inWorldPos);
 	vec3 q2 = dFdy(inWorldPos);
@@ -0,0 +1,78 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Bindless variant of mrt.frag, every material's textures live in one array
+// and the material to draw with is pushed before each draw. See @BindlessMaterialTable
+
+// Indices of a material's textures in the texture array, see @BindlessMaterialData
+struct MaterialData
+{
+	uint albedo;
+	uint normal;
+	uint metal;
+	uint roughness;
+};
+
+layout (std430, set = 0, binding = 1) readonly buffer Materials
+{
+	MaterialData data[];
+} materials;
+
+// Every texture that a material uses, only the slots that are in use are written
+layout (set = 1, binding = 0) uniform sampler2D textures[];
+
+// The packed vertex shader has the first 32 bytes, see @VertexDequantize
+layout (push_constant) uniform DrawData
+{
+	layout (offset = 32) uint materialIndex;
+} draw;
+
+// Inputs from the mrt vert shader
+layout (location = 0) in vec3 inNormal;
+layout (location = 1) in vec2 inUV;
+layout (location = 2) in vec3 inColor;
+layout (location = 3) in vec3 inWorldPos;
+layout (location = 4) in vec3 inTangent;
+
+// Outputs set as the frame buffer
+layout (location = 0) out vec4 outPosition;
+layout (location = 1) out vec4 outNormal;
+layout (location = 2) out vec4 outAlbedo;
+layout (location = 3) out vec4 outMetal;
+layout (location = 4) out vec4 outRoughness;
+
+// Perturb normal, see http://www.thetenthplanet.de/archives/1180
+vec3 perturbNormal(sampler2D normalMap)
+{
+	// Only XY are stored in BC5 normal maps, so rebuild Z from them
+	vec3 tangentNormal;
+	tangentNormal.xy = texture(normalMap, inUV).xy * 2.0 - 1.0;
+	tangentNormal.z = sqrt(max(1.0 - dot(tangentNormal.xy, tangentNormal.xy), 0.0));
+
+	vec3 q1 = dFdx(inWorldPos);
+	vec3 q2 = dFdy(inWorldPos);
+	vec2 st1 = dFdx(inUV);
+	vec2 st2 = dFdy(inUV);
+
+	vec3 N = normalize(inNormal);
+	vec3 T = normalize(q1 * st2.t - q2 * st1.t);
+	vec3 B = -normalize(cross(N, T));
+	mat3 TBN = mat3(T, B, N);
+
+	return normalize(TBN * tangentNormal);
+}
+
+void main() 
+{
+	// The index is the same for the whole draw, so it doesn't need to be nonuniform
+	MaterialData mat = materials.data[draw.materialIndex];
+
+	// Use the perturbed normal for our calculations 
+	outNormal = vec4(perturbNormal(textures[mat.normal]), 1.0);
+
+	outPosition = vec4(inWorldPos, 1.0);
+	outAlbedo = texture(textures[mat.albedo], inUV);
+
+	outMetal = texture(textures[mat.metal], inUV);
+	outRoughness = texture(textures[mat.roughness], inUV);
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#version 450
+
+// Vertex bindings, see @PackedVertex in Vertex.h
+layout(location = 0) in vec3 inPos;
+layout(location = 2) in vec2 inTangent;
+layout(location = 3) in vec2 inNormal;
+layout(location = 4) in vec2 inUV;
+
+// Instance bindings, see @InstanceData in Vertex.h
+layout(location = 5) in mat4 inModel;
+
+layout (binding = 0) uniform UBO
+{
+	mat4 projection;
+	mat4 view;
+} ubo;
+
+// Bounds of the mesh that the positions are normalized to, see @VertexDequantize
+layout (push_constant) uniform Dequantize
+{
+	vec4 offset;
+	vec4 scale;
+} dequantize;
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) out vec2 outUV;
+layout (location = 2) out vec3 outColor;
+layout (location = 3) out vec3 outWorldPos;
+layout (location = 4) out vec3 outTangent;
+
+out gl_PerVertex
+{
+	vec4 gl_Position;
+};
+
+// Unfold a unit vector from the octahedron, see @VertexQuantization::DecodeOctahedral
+vec3 decodeOctahedral(vec2 oct)
+{
+	vec3 dir = vec3(oct, 1.0 - abs(oct.x) - abs(oct.y));
+	float fold = max(-dir.z, 0.0);
+	dir.xy += mix(vec2(fold), vec2(-fold), greaterThanEqual(dir.xy, vec2(0.0)));
+	return normalize(dir);
+}
+
+void main()
+{
+	// GL UV Coords to Vulkan coord space
+	outUV = inUV;
+	outUV.t = 1.0 - outUV.t;
+
+	// Packed meshes only exist when every vertex is white
+	outColor = vec3(1.0);
+
+	vec3 pos = dequantize.offset.xyz + inPos * dequantize.scale.xyz;
+	outWorldPos = (inModel * vec4(pos, 1.0)).rgb;
+	outNormal = mat3(inModel) * decodeOctahedral(inNormal);
+
+	gl_Position =  ubo.projection * ubo.view * vec4(outWorldPos, 1.0);
+	outTangent = normalize( decodeOctahedral(inTangent) * mat3(inModel) );
+}
@@ -163,7 +163,10 @@ vec3 CalculatePointLight( PointLightData light, vec3 normal, vec3 worldPos, vec3
 // Perturb normal, see http://www.thetenthplanet.de/archives/1180
 vec3 perturbNormal()
 {
-	vec3 tangentNormal = texture(normalMap, inTexCoord).xyz * 2.0 - 1.0;
+	// Only XY are stored in BC5 normal maps, so rebuild Z from them
+	vec3 tangentNormal;
+	tangentNormal.xy = texture(normalMap, inTexCoord).xy * 2.0 - 1.0;
+	tangentNormal.z = sqrt(max(1.0 - dot(tangentNormal.xy, tangentNormal.xy), 0.0));
 
 	vec3 q1 = dFdx(inWorldPos);
 	vec3 q2 = dFdy(inWorldPos);
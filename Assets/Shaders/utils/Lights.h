@@ -0,0 +1,16 @@
+// Light definitions for the forward shaders, the deferred pass has its own in LightingCalc.h
+
+struct DirectionalLightData
+{
+    vec4 DiffuseColor;
+    vec4 Direction;
+    float Intensity; 
+};
+
+struct PointLightData
+{
+    vec4 Color;
+    vec4 Pos;
+    float Intensity; 
+    float Range; 
+};
@@ -0,0 +1,57 @@
+## Compiles the engine's GLSL shaders to SPIR-V with glslangValidator, the same way that
+## the compileShaders.py scripts do. Every .vert and .frag in a folder is compiled to
+## <name>_vert.spv or <name>_frag.spv next to it, which is where the engine loads them from
+
+find_program( GLSLANG_VALIDATOR glslangValidator
+	HINTS $ENV{VK_BIN_PATH} $ENV{VULKAN_SDK}/bin $ENV{VULKAN_SDK}/Bin
+)
+
+if( GLSLANG_VALIDATOR )
+	message( STATUS "glslangValidator found: ${GLSLANG_VALIDATOR}" )
+else()
+	message( FATAL_ERROR "glslangValidator NOT FOUND! Set VK_BIN_PATH to the bin folder of the Vulkan SDK. Stopping" )
+endif()
+
+FUNCTION(FLING_COMPILE_SHADERS TargetName )
+
+	set( _spirv_list "" )
+	set( _shader_sources "" )
+
+	foreach( _shader_dir IN ITEMS ${ARGN} )
+		file( GLOB _shader_list ${_shader_dir}/*.vert ${_shader_dir}/*.frag )
+
+		# Shaders can include any header below their folder, so they are all dependencies
+		file( GLOB_RECURSE _shader_headers ${_shader_dir}/*.h )
+
+		foreach( _shader IN ITEMS ${_shader_list} )
+			get_filename_component( _shader_name "${_shader}" NAME_WE )
+			get_filename_component( _shader_ext "${_shader}" EXT )
+			string( SUBSTRING "${_shader_ext}" 1 -1 _shader_stage )
+
+			set( _spirv "${_shader_dir}/${_shader_name}_${_shader_stage}.spv" )
+
+			add_custom_command(
+				OUTPUT ${_spirv}
+				COMMAND ${GLSLANG_VALIDATOR} -V ${_shader} -o ${_spirv}
+				DEPENDS ${_shader} ${_shader_headers}
+				WORKING_DIRECTORY ${_shader_dir}
+				COMMENT "Compiling shader ${_shader_name}${_shader_ext}"
+			)
+
+			list( APPEND _spirv_list ${_spirv} )
+		endforeach()
+
+		list( APPEND _shader_sources ${_shader_list} ${_shader_headers} )
+	endforeach()
+
+	# Nested folders find the same headers more than once
+	list( REMOVE_DUPLICATES _shader_sources )
+
+	add_custom_target( ${TargetName} ALL DEPENDS ${_spirv_list} SOURCES ${_shader_sources} )
+
+ENDFUNCTION(FLING_COMPILE_SHADERS)
+
+# Example usage
+
+#FLING_COMPILE_SHADERS( MyShaders "${FLING_ROOT_DIR}/Assets/Shaders" )
+#add_dependencies( MyApp MyShaders )
@@ -6,6 +6,7 @@
 #include "ResourceManager.h"
 #include "FlingConfig.h"
 #include "NonCopyable.hpp"
+#include "JobSystem.h"
 #include "World.h"
 #include <nlohmann/json.hpp>
 #include <entt/entity/registry.hpp>
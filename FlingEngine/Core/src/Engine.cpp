@@ -36,6 +36,17 @@ namespace Fling
 			F_LOG_WARN("NO EngineConf.ini has been provided! This may result in unexpected behavior from Fling!");
 		}
 
+		// A job thread count of 0 will use every core
+		INT32 JobThreadCount = FlingConfig::GetInt("Engine", "JobThreadCount", 0);
+		if (JobThreadCount > 0)
+		{
+			JobSystem::Get().Init(static_cast<UINT32>(JobThreadCount));
+		}
+		else
+		{
+			JobSystem::Get().Init();
+		}
+
 		VulkanApp::Get().Init(
 			//static_cast<PipelineFlags>(PipelineFlags::DEFERRED),
 			static_cast<PipelineFlags>(PipelineFlags::DEFERRED | PipelineFlags::IMGUI),
@@ -90,6 +101,9 @@ namespace Fling
 				break;
 			}
 			
+			// Finish any async resources before we render with them
+			ResourceManager::Get().Update();
+
 			VkApp.Update(DeltaTime, g_Registry);
 
 			Timing.UpdateFps();
@@ -120,6 +134,7 @@ namespace Fling
         FlingConfig::Get().Shutdown();
 		Timing::Get().Shutdown();
 		VulkanApp::Get().Shutdown(g_Registry);
+		JobSystem::Get().Shutdown();
 
 		g_Registry.reset();
 	}
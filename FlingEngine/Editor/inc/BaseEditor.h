@@ -41,6 +41,7 @@ namespace Fling
 		bool m_DisplayComponentEditor = true;
 		bool m_DisplayWorldOutline = true;
 		bool m_DisplayWindowOptions = false;
+		bool m_DisplayOcclusionBuffer = false;
 
 		/** Component editor so that we can draw our component window */
 		entt::entity m_CompEditorEntityType = entt::null;
@@ -50,6 +51,9 @@ namespace Fling
 
 		void DrawGpuInfo();
 
+		/** Shows the depth buffer that the occlusion culler rasterized last frame */
+		void DrawOcclusionBuffer();
+
         void DrawWorldOutline(entt::registry& t_Reg);
 
         /** assumes that m_DisplayComponentEditor is true */
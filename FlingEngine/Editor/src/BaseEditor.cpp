@@ -4,6 +4,10 @@
 #include "BaseEditor.h"
 #include "VulkanApp.h"
 #include "PhyscialDevice.h"
+#include "DeviceMemoryAllocator.h"
+#include "OcclusionCuller.h"
+#include "LodSelector.h"
+#include "RenderPipeline.h"
 
 // We have to draw the ImGUI stuff somewhere, so we miind as well keep it all here!
 #include "Components/Transform.h"
@@ -23,9 +27,14 @@ namespace Fling
     {
         void Transform(Fling::Transform& t)
         {
-            ImGui::InputFloat3( "Position", ( float* ) &t.m_Pos );
-            ImGui::InputFloat3( "Scale", ( float* )  &t.m_Scale );
-            ImGui::InputFloat3( "Rotation", ( float* )  &t.m_Rotation );
+            bool Changed = ImGui::InputFloat3( "Position", ( float* ) &t.m_Pos );
+            Changed |= ImGui::InputFloat3( "Scale", ( float* )  &t.m_Scale );
+            Changed |= ImGui::InputFloat3( "Rotation", ( float* )  &t.m_Rotation );
+
+            if( Changed )
+            {
+                t.MarkDirty();
+            }
         }
 
         void PointLight(Fling::PointLight& t_Light)
@@ -75,6 +84,8 @@ namespace Fling
 
                     fileDialog.ClearSelected();
                 }
+
+                ImGui::Checkbox("Occluder", &t_MeshRend.m_IsOccluder);
             }
 
             // Material ----------------------
@@ -205,6 +216,11 @@ namespace Fling
         {
             DrawWindowOptions();
         }
+
+        if (m_DisplayOcclusionBuffer)
+        {
+            DrawOcclusionBuffer();
+        }
     }
 
     void BaseEditor::DrawWorldOutline(entt::registry& t_Reg)
@@ -358,6 +374,7 @@ namespace Fling
             if (ImGui::BeginMenu("Windows"))
             {
                 ImGui::Checkbox("GPU Info", &m_DisplayGPUInfo);
+                ImGui::Checkbox("Occlusion Buffer", &m_DisplayOcclusionBuffer);
                 ImGui::EndMenu();
             }
 
@@ -428,6 +445,131 @@ namespace Fling
             ImGui::Text("FPS: %f", frameTime);
             ImGui::PlotLines("FPS", &fpsGraph[0], fpsGraph.size(), 0, "", m_FrameTimeMin, m_FrameTimeMax, ImVec2(0, 80));
         }
+
+        // State changes that the subpasses recorded for the last frame
+        if (const RenderPipeline* Pipeline = VulkanApp::Get().GetRenderPipeline())
+        {
+            if (ImGui::TreeNode("Draw Calls"))
+            {
+                const DrawListStats Stats = Pipeline->GetDrawStats();
+                ImGui::Text("Draws: %u", Stats.Draws);
+                ImGui::Text("Pipeline Binds: %u", Stats.PipelineBinds);
+                ImGui::Text("Descriptor Set Binds: %u", Stats.DescriptorSetBinds);
+                ImGui::Text("Vertex Buffer Binds: %u", Stats.VertexBufferBinds);
+                ImGui::Text("Index Buffer Binds: %u", Stats.IndexBufferBinds);
+                ImGui::TreePop();
+            }
+        }
+
+        // Triangles drawn this frame with the levels of detail that were picked
+        if (LodSelector* Lods = VulkanApp::Get().GetLodSelector())
+        {
+            if (ImGui::TreeNode("Levels of Detail"))
+            {
+                bool Enabled = Lods->IsEnabled();
+                if (ImGui::Checkbox("Enabled", &Enabled))
+                {
+                    Lods->SetEnabled(Enabled);
+                }
+
+                float MaxError = Lods->GetMaxScreenError();
+                if (ImGui::SliderFloat("Max Screen Error", &MaxError, 0.0f, 0.02f, "%.4f"))
+                {
+                    Lods->SetMaxScreenError(MaxError);
+                }
+
+                ImGui::Text("Triangles: %llu / %llu",
+                    static_cast<unsigned long long>(Lods->GetTriangleCount()),
+                    static_cast<unsigned long long>(Lods->GetFullTriangleCount()));
+                for (UINT32 i = 0; i < MaxMeshLods; ++i)
+                {
+                    ImGui::Text("LOD %u: %u meshes", i, Lods->GetMeshCountAtLod(i));
+                }
+                ImGui::TreePop();
+            }
+        }
+
+        // Device memory usage
+        if (DeviceMemoryAllocator* Allocator = VulkanApp::Get().GetMemoryAllocator())
+        {
+            const float ToMB = 1.0f / (1024.0f * 1024.0f);
+            DeviceMemoryStats Total = Allocator->GetStats();
+            if (ImGui::TreeNode("Device Memory"))
+            {
+                ImGui::Text("Used: %.2f / %.2f MB", Total.UsedBytes * ToMB, Total.AllocatedBytes * ToMB);
+                ImGui::Text("Blocks: %u  Dedicated: %u  Allocations: %u", Total.BlockCount, Total.DedicatedAllocationCount, Total.AllocationCount);
+                ImGui::Separator();
+
+                for (UINT32 i = 0; i < Allocator->GetMemoryTypeCount(); ++i)
+                {
+                    DeviceMemoryStats TypeStats = Allocator->GetStats(i);
+                    if (TypeStats.AllocatedBytes == 0)
+                    {
+                        continue;
+                    }
+
+                    ImGui::Text("Type %u (flags 0x%x): %u blocks, %u allocs, %.2f / %.2f MB", 
+                        i, 
+                        Allocator->GetMemoryProperties().memoryTypes[i].propertyFlags,
+                        TypeStats.BlockCount + TypeStats.DedicatedAllocationCount, 
+                        TypeStats.AllocationCount, 
+                        TypeStats.UsedBytes * ToMB, 
+                        TypeStats.AllocatedBytes * ToMB
+                    );
+                }
+                ImGui::TreePop();
+            }
+        }
+        ImGui::End();
+    }
+
+    void BaseEditor::DrawOcclusionBuffer()
+    {
+        ImGui::Begin("Occlusion Buffer", &m_DisplayOcclusionBuffer);
+
+        OcclusionCuller* Culler = VulkanApp::Get().GetOcclusionCuller();
+        if (!Culler)
+        {
+            ImGui::End();
+            return;
+        }
+
+        bool Enabled = Culler->IsEnabled();
+        if (ImGui::Checkbox("Enabled", &Enabled))
+        {
+            Culler->SetEnabled(Enabled);
+        }
+
+        ImGui::Text("Occluders: %u  Occluded: %u  Visible: %u",
+            Culler->GetOccluderCount(),
+            Culler->GetOccludedCount(),
+            static_cast<UINT32>(Culler->GetVisibleEntities().size()));
+
+        static bool ShowTiles = false;
+        ImGui::Checkbox("Tile Max Depth", &ShowTiles);
+
+        // Draw the buffer as gray squares, near is white and the far plane is black
+        const OcclusionBuffer& Buffer = Culler->GetBuffer();
+        const UINT32 Step = ShowTiles ? 1 : 2;
+        const UINT32 Width = ShowTiles ? Buffer.GetTilesX() : Buffer.GetWidth() / Step;
+        const UINT32 Height = ShowTiles ? Buffer.GetTilesY() : Buffer.GetHeight() / Step;
+        const float CellSize = std::max(ImGui::GetContentRegionAvail().x / static_cast<float>(Width), 1.0f);
+        const ImVec2 CellDim = ShowTiles ? ImVec2(CellSize, CellSize * OcclusionBuffer::TileHeight / OcclusionBuffer::TileWidth) : ImVec2(CellSize, CellSize);
+
+        ImDrawList* DrawList = ImGui::GetWindowDrawList();
+        const ImVec2 Origin = ImGui::GetCursorScreenPos();
+        for (UINT32 y = 0; y < Height; ++y)
+        {
+            for (UINT32 x = 0; x < Width; ++x)
+            {
+                const float Depth = ShowTiles ? Buffer.GetTileMaxDepth(x, y) : Buffer.GetDepth(x * Step, y * Step);
+                const ImU32 Gray = static_cast<ImU32>((1.0f - glm::clamp(Depth, 0.0f, 1.0f)) * 255.0f);
+                const ImVec2 Min(Origin.x + x * CellDim.x, Origin.y + y * CellDim.y);
+                DrawList->AddRectFilled(Min, ImVec2(Min.x + CellDim.x, Min.y + CellDim.y), IM_COL32(Gray, Gray, Gray, 255));
+            }
+        }
+        ImGui::Dummy(ImVec2(Width * CellDim.x, Height * CellDim.y));
+
         ImGui::End();
     }
 }   // namespace Fling
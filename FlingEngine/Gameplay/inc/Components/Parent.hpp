@@ -0,0 +1,16 @@
+#pragma once
+
+#include <entt/entity/registry.hpp>
+
+namespace Fling
+{
+	/**
+	 * @brief	Attaches an entity's Transform to the Transform of another entity. The world
+	 *			matrix of the child becomes the parent's world matrix * the child's local matrix.
+	 * @see		TransformSystem
+	 */
+	struct Parent
+	{
+		entt::entity Entity = entt::null;
+	};
+}   // namespace Fling
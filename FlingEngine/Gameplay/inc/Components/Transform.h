@@ -2,13 +2,19 @@
 
 #include "Serilization.h"
 #include "FlingMath.h"
+#include "FlingTypes.h"
 
 namespace Fling
 {
     struct Transform
     {   
-        glm::mat4 GetWorldMatrix() const;
+        /** Translation * rotation * scale of this transform, without any parents */
+        glm::mat4 GetLocalMatrix() const;
 
+        /** The cached world matrix, updated once a frame by the TransformSystem */
+        inline glm::mat4 GetWorldMatrix() const { return m_worldMat; }
+
+        /** Set the world matrix to the local matrix right away, ignoring any parent */
 		static void CalculateWorldMatrix(Transform& t_Trans);
 
         bool operator==(const Transform &other) const;
@@ -27,11 +33,23 @@ namespace Fling
         void SetScale(const glm::vec3& t_Scale);
         void SetRotation(const glm::vec3& t_Rot);
 
+        /** True if the local matrix has changed since the world matrix was last calculated */
+        inline bool IsDirty() const { return m_IsDirty; }
+
+        /** Flag the world matrix to be recalculated, call this after writing to the members directly */
+        inline void MarkDirty() { m_IsDirty = true; }
+
     //private:
         glm::vec3 m_Pos { 0.0f, 0.0f, 0.0f };
         glm::vec3 m_Rotation { 0.0f, 0.0f, 0.0f };
         glm::vec3 m_Scale { 1.0f, 1.0f, 1.0f };
 		glm::mat4 m_worldMat {};
+
+        /** New transforms always need their world matrix calculated */
+        bool m_IsDirty = true;
+
+        /** TransformSystem frame that the world matrix last changed on, so children know to update */
+        UINT32 m_WorldChangedFrame = 0;
     };
     
     /** Serilazation to an archive */
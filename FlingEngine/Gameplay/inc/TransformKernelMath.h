@@ -0,0 +1,181 @@
+#pragma once
+
+// This header is included by the AVX2 kernel translation unit, which is compiled with AVX2
+// enabled. Keep it free of any other engine or library headers, otherwise their inline
+// functions could be compiled with AVX2 instructions and picked by the linker for every caller.
+#include <cstdint>
+
+namespace Fling
+{
+	/**
+	 * @brief	Transforms stored as separate arrays of components, so that a batch of them can be
+	 *			loaded into SIMD registers. Rotations are in degrees, the same as Transform.
+	 */
+	struct TransformStreams
+	{
+		const float* PosX = nullptr;
+		const float* PosY = nullptr;
+		const float* PosZ = nullptr;
+
+		const float* RotX = nullptr;
+		const float* RotY = nullptr;
+		const float* RotZ = nullptr;
+
+		const float* ScaleX = nullptr;
+		const float* ScaleY = nullptr;
+		const float* ScaleZ = nullptr;
+	};
+
+	namespace TransformKernels
+	{
+		namespace Detail
+		{
+			/**
+			 * @brief	Sine and cosine of radians in every lane. Uses a three part pi/2 to reduce to
+			 *			[-pi/4, pi/4] and the Cephes single precision polynomials.
+			 */
+			template<class L>
+			inline void SinCos(typename L::Float t_X, typename L::Float& t_OutSin, typename L::Float& t_OutCos)
+			{
+				using F = typename L::Float;
+				using I = typename L::Int;
+
+				const I Quadrant = L::RoundToInt(L::Mul(t_X, L::Set(0.636619772367581343f)));
+				const F Q = L::ToFloat(Quadrant);
+
+				F R = L::Sub(t_X, L::Mul(Q, L::Set(1.5703125f)));
+				R = L::Sub(R, L::Mul(Q, L::Set(4.837512969970703125e-4f)));
+				R = L::Sub(R, L::Mul(Q, L::Set(7.54978995489188216e-8f)));
+				const F R2 = L::Mul(R, R);
+
+				F S = L::MulAdd(R2, L::Set(-1.9515295891e-4f), L::Set(8.3321608736e-3f));
+				S = L::MulAdd(R2, S, L::Set(-1.6666654611e-1f));
+				S = L::MulAdd(L::Mul(R2, R), S, R);
+
+				F C = L::MulAdd(R2, L::Set(2.443315711809948e-5f), L::Set(-1.388731625493765e-3f));
+				C = L::MulAdd(R2, C, L::Set(4.166664568298827e-2f));
+				C = L::MulAdd(L::Mul(R2, R2), C, L::Sub(L::Set(1.0f), L::Mul(R2, L::Set(0.5f))));
+
+				// Odd quadrants swap sin and cos, and the sign of each flips every other quadrant
+				const auto Swap = L::TestBit(Quadrant, 1);
+				t_OutSin = L::FlipSign(L::Select(Swap, C, S), L::TestBit(Quadrant, 2));
+				t_OutCos = L::FlipSign(L::Select(Swap, S, C), L::TestBit(L::AddInt(Quadrant, 1), 2));
+			}
+
+			/**
+			 * @brief	Build L::Width world matrices starting at transform t_Index, the same as
+			 *			Transform::GetLocalMatrix does. t_Out points at the 16 floats of each matrix.
+			 */
+			template<class L>
+			inline void ComposeTRS(const TransformStreams& t_In, uint32_t t_Index, float* const* t_Out)
+			{
+				using F = typename L::Float;
+
+				const F DegToRad = L::Set(0.0174532925199432958f);
+
+				// glm::yawPitchRoll(y, x, z)
+				F SinYaw, CosYaw, SinPitch, CosPitch, SinRoll, CosRoll;
+				SinCos<L>(L::Mul(L::Load(t_In.RotY + t_Index), DegToRad), SinYaw, CosYaw);
+				SinCos<L>(L::Mul(L::Load(t_In.RotX + t_Index), DegToRad), SinPitch, CosPitch);
+				SinCos<L>(L::Mul(L::Load(t_In.RotZ + t_Index), DegToRad), SinRoll, CosRoll);
+
+				const F SinYawSinPitch = L::Mul(SinYaw, SinPitch);
+				const F CosYawSinPitch = L::Mul(CosYaw, SinPitch);
+
+				const F ScaleX = L::Load(t_In.ScaleX + t_Index);
+				const F ScaleY = L::Load(t_In.ScaleY + t_Index);
+				const F ScaleZ = L::Load(t_In.ScaleZ + t_Index);
+
+				// Column major, the same layout as glm::mat4
+				F Cols[16];
+				Cols[0] = L::Mul(L::MulAdd(SinYawSinPitch, SinRoll, L::Mul(CosYaw, CosRoll)), ScaleX);
+				Cols[1] = L::Mul(L::Mul(SinRoll, CosPitch), ScaleX);
+				Cols[2] = L::Mul(L::Sub(L::Mul(CosYawSinPitch, SinRoll), L::Mul(SinYaw, CosRoll)), ScaleX);
+				Cols[3] = L::Set(0.0f);
+
+				Cols[4] = L::Mul(L::Sub(L::Mul(SinYawSinPitch, CosRoll), L::Mul(CosYaw, SinRoll)), ScaleY);
+				Cols[5] = L::Mul(L::Mul(CosRoll, CosPitch), ScaleY);
+				Cols[6] = L::Mul(L::MulAdd(CosYawSinPitch, CosRoll, L::Mul(SinRoll, SinYaw)), ScaleY);
+				Cols[7] = L::Set(0.0f);
+
+				Cols[8] = L::Mul(L::Mul(SinYaw, CosPitch), ScaleZ);
+				Cols[9] = L::Mul(L::Set(-1.0f), L::Mul(SinPitch, ScaleZ));
+				Cols[10] = L::Mul(L::Mul(CosYaw, CosPitch), ScaleZ);
+				Cols[11] = L::Set(0.0f);
+
+				Cols[12] = L::Load(t_In.PosX + t_Index);
+				Cols[13] = L::Load(t_In.PosY + t_Index);
+				Cols[14] = L::Load(t_In.PosZ + t_Index);
+				Cols[15] = L::Set(1.0f);
+
+				// Transpose from one register per element to one matrix per lane
+				alignas(32) float Lanes[16][L::Width];
+				for (uint32_t e = 0; e < 16; ++e)
+				{
+					L::Store(Lanes[e], Cols[e]);
+				}
+				for (uint32_t l = 0; l < L::Width; ++l)
+				{
+					float* Mat = t_Out[l];
+					for (uint32_t e = 0; e < 16; ++e)
+					{
+						Mat[e] = Lanes[e][l];
+					}
+				}
+			}
+
+			/** Run ComposeTRS over every transform, padding out the last partial batch */
+			template<class L>
+			inline void UpdateWorldMatrices(const TransformStreams& t_In, uint32_t t_Count, float* const* t_Out)
+			{
+				uint32_t i = 0;
+				for (; i + L::Width <= t_Count; i += L::Width)
+				{
+					ComposeTRS<L>(t_In, i, t_Out + i);
+				}
+
+				if (i == t_Count)
+				{
+					return;
+				}
+
+				// Identity transforms in the unused lanes, and their results are thrown away
+				float Pad[9][L::Width];
+				float Discard[L::Width][16];
+				float* PadOut[L::Width];
+
+				const float* Streams[9] = {
+					t_In.PosX, t_In.PosY, t_In.PosZ,
+					t_In.RotX, t_In.RotY, t_In.RotZ,
+					t_In.ScaleX, t_In.ScaleY, t_In.ScaleZ
+				};
+
+				for (uint32_t l = 0; l < L::Width; ++l)
+				{
+					const bool Used = i + l < t_Count;
+					for (uint32_t s = 0; s < 9; ++s)
+					{
+						Pad[s][l] = Used ? Streams[s][i + l] : (s >= 6 ? 1.0f : 0.0f);
+					}
+					PadOut[l] = Used ? t_Out[i + l] : Discard[l];
+				}
+
+				TransformStreams Padded;
+				Padded.PosX = Pad[0];
+				Padded.PosY = Pad[1];
+				Padded.PosZ = Pad[2];
+				Padded.RotX = Pad[3];
+				Padded.RotY = Pad[4];
+				Padded.RotZ = Pad[5];
+				Padded.ScaleX = Pad[6];
+				Padded.ScaleY = Pad[7];
+				Padded.ScaleZ = Pad[8];
+
+				ComposeTRS<L>(Padded, 0, PadOut);
+			}
+
+			/** Defined in TransformKernelsAVX2.cpp, only call this if the CPU supports AVX2 and FMA */
+			void UpdateWorldMatricesAVX2(const TransformStreams& t_In, uint32_t t_Count, float* const* t_Out);
+		}   // namespace Detail
+	}   // namespace TransformKernels
+}   // namespace Fling
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "FlingMath.h"
+#include "TransformKernelMath.h"
+
+namespace Fling
+{
+	/**
+	 * @brief	Batched world matrix calculation. Transforms are gathered into TransformStreams and
+	 *			their matrices are built 4 or 8 at a time, using the widest instruction set that
+	 *			the CPU supports. Results match Transform::GetLocalMatrix to within a few ulps.
+	 */
+	namespace TransformKernels
+	{
+		enum class Isa : UINT8
+		{
+			Scalar,
+			SSE2,
+			AVX2,
+			Count
+		};
+
+		/** True if this build has the kernel and the CPU can run it */
+		bool IsSupported(Isa t_Isa);
+
+		/** The widest instruction set that is supported, checked once at runtime */
+		Isa GetBestIsa();
+
+		const char* GetIsaName(Isa t_Isa);
+
+		/**
+		 * @brief	Write the world matrix of each transform in t_In to the matrix pointed to by
+		 *			the same index in t_Out. Uses GetBestIsa.
+		 */
+		void UpdateWorldMatrices(const TransformStreams& t_In, UINT32 t_Count, glm::mat4* const* t_Out);
+
+		/** Same as above with a specific instruction set, which has to be supported */
+		void UpdateWorldMatrices(Isa t_Isa, const TransformStreams& t_In, UINT32 t_Count, glm::mat4* const* t_Out);
+	}   // namespace TransformKernels
+}   // namespace Fling
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "NonCopyable.hpp"
+#include "FlingTypes.h"
+#include "Components/Transform.h"
+#include "Components/Parent.hpp"
+
+#include <entt/entity/registry.hpp>
+#include <vector>
+
+namespace Fling
+{
+	/**
+	 * @brief	Updates the cached world matrix of every Transform once a frame. Only transforms
+	 *			that are dirty, or whose parent's world matrix changed this frame, are recalculated,
+	 *			so a static scene costs almost nothing.
+	 *
+	 *			Dirty root transforms are batched through the SIMD TransformKernels in parallel, then
+	 *			children are updated in order of their depth in the hierarchy so that a parent is
+	 *			always done before its children.
+	 */
+	class TransformSystem : public NonCopyable
+	{
+	public:
+
+		explicit TransformSystem(entt::registry& t_Reg);
+
+		~TransformSystem();
+
+		/** Recalculate the world matrices that need it. Call once a frame before rendering */
+		void Update(entt::registry& t_Reg);
+
+		/** Number of times Update has been called */
+		inline UINT32 GetFrame() const { return m_Frame; }
+
+	private:
+
+		void OnParentChanged(entt::entity t_Ent, entt::registry& t_Reg, Parent& t_Parent);
+
+		void OnParentRemoved(entt::entity t_Ent, entt::registry& t_Reg);
+
+		void OnTransformAdded(entt::entity t_Ent, entt::registry& t_Reg, Transform& t_Trans);
+
+		void OnTransformRemoved(entt::entity t_Ent, entt::registry& t_Reg);
+
+		/** Sort every entity with a Parent by how deep it is in the hierarchy */
+		void SortChildren(entt::registry& t_Reg);
+
+		entt::registry& m_Registry;
+
+		/** Entities with a parent, parents come before their children */
+		std::vector<entt::entity> m_SortedChildren;
+
+		/** Depth of each entity in m_SortedChildren, only used while sorting */
+		std::vector<std::pair<UINT32, entt::entity>> m_SortScratch;
+
+		/** Set when a parent is added, changed, or removed so that the children are sorted again */
+		bool m_HierarchyDirty = true;
+
+		UINT32 m_Frame = 0;
+	};
+}   // namespace Fling
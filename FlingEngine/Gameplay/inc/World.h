@@ -4,6 +4,7 @@
 #include "Level.h"
 #include "Game.h"
 #include "FlingConfig.h"
+#include "TransformSystem.h"
 
 #include <string>
 #include <fstream>
@@ -84,6 +85,9 @@ namespace Fling
 		/** The game will allow users to specify their own update/read/write functions */
 		Fling::Game* m_Game = nullptr;
 
+		/** Calculates the world matrices of every transform after the game has moved them */
+		TransformSystem m_TransformSystem;
+
 		/** Flag if the world should quit or not! */
 		UINT8 m_ShouldQuit = false;
     };
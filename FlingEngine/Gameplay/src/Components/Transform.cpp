@@ -23,7 +23,7 @@ namespace Fling
         return t_OutStream;
     }
 
-    glm::mat4 Transform::GetWorldMatrix() const
+    glm::mat4 Transform::GetLocalMatrix() const
     {
         // World = Scale * rot * pos
         glm::mat4 worldMat = glm::identity<glm::mat4>();
@@ -36,27 +36,24 @@ namespace Fling
 
 	void Transform::CalculateWorldMatrix(Transform& t_Trans)
 	{
-		//assert(t_OutMat);
-		//*t_OutMat = glm::translate(glm::mat4(1.0f), t_Trans.m_Pos);
-		//*t_OutMat = *t_OutMat * glm::yawPitchRoll(glm::radians(t_Trans.m_Rotation.y), glm::radians(t_Trans.m_Rotation.x), glm::radians(t_Trans.m_Rotation.z));
-		//*t_OutMat = glm::scale(*t_OutMat, t_Trans.m_Scale);
-		t_Trans.m_worldMat = glm::translate(glm::mat4(1.0f), t_Trans.m_Pos);;
-		t_Trans.m_worldMat= t_Trans.m_worldMat * glm::yawPitchRoll(glm::radians(t_Trans.m_Rotation.y), glm::radians(t_Trans.m_Rotation.x), glm::radians(t_Trans.m_Rotation.z));
-		t_Trans.m_worldMat = glm::scale(t_Trans.m_worldMat, t_Trans.m_Scale);
+		t_Trans.m_worldMat = t_Trans.GetLocalMatrix();
 	}
 
     void Transform::SetPos(const glm::vec3& t_Pos)
     {
         m_Pos = t_Pos;
+        m_IsDirty = true;
     }
 
     void Transform::SetScale(const glm::vec3& t_Scale)
     {
         m_Scale = t_Scale;
+        m_IsDirty = true;
     }
 
     void Transform::SetRotation(const glm::vec3& t_Rot)
     {
         m_Rotation = t_Rot;
+        m_IsDirty = true;
     }
 }   // namespace Fling
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include "pch.h"
+#include "TransformKernels.h"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#	define FLING_TRANSFORM_X86 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	include <emmintrin.h>
+#	define FLING_TRANSFORM_SSE2 1
+#endif
+
+#if FLING_TRANSFORM_X86 && defined(_MSC_VER)
+#	include <intrin.h>
+#endif
+
+namespace Fling
+{
+	namespace TransformKernels
+	{
+		namespace
+		{
+			struct ScalarLanes
+			{
+				using Float = float;
+				using Int = INT32;
+				using Mask = bool;
+				static constexpr UINT32 Width = 1;
+
+				static inline Float Set(float t_Val) { return t_Val; }
+				static inline Float Load(const float* t_Src) { return *t_Src; }
+				static inline void Store(float* t_Dst, Float t_Val) { *t_Dst = t_Val; }
+				static inline Float Add(Float a, Float b) { return a + b; }
+				static inline Float Sub(Float a, Float b) { return a - b; }
+				static inline Float Mul(Float a, Float b) { return a * b; }
+				static inline Float MulAdd(Float a, Float b, Float c) { return a * b + c; }
+				static inline Int RoundToInt(Float a) { return static_cast<Int>(std::lrint(a)); }
+				static inline Float ToFloat(Int a) { return static_cast<Float>(a); }
+				static inline Int AddInt(Int a, INT32 b) { return a + b; }
+				static inline Mask TestBit(Int a, INT32 t_Bit) { return (a & t_Bit) != 0; }
+				static inline Float Select(Mask m, Float a, Float b) { return m ? a : b; }
+				static inline Float FlipSign(Float a, Mask m) { return m ? -a : a; }
+			};
+
+#if FLING_TRANSFORM_SSE2
+			struct SSE2Lanes
+			{
+				using Float = __m128;
+				using Int = __m128i;
+				using Mask = __m128;
+				static constexpr UINT32 Width = 4;
+
+				static inline Float Set(float t_Val) { return _mm_set1_ps(t_Val); }
+				static inline Float Load(const float* t_Src) { return _mm_loadu_ps(t_Src); }
+				static inline void Store(float* t_Dst, Float t_Val) { _mm_store_ps(t_Dst, t_Val); }
+				static inline Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+				static inline Float Sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+				static inline Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+				static inline Float MulAdd(Float a, Float b, Float c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+				static inline Int RoundToInt(Float a) { return _mm_cvtps_epi32(a); }
+				static inline Float ToFloat(Int a) { return _mm_cvtepi32_ps(a); }
+				static inline Int AddInt(Int a, INT32 b) { return _mm_add_epi32(a, _mm_set1_epi32(b)); }
+				static inline Mask TestBit(Int a, INT32 t_Bit)
+				{
+					const __m128i Bit = _mm_set1_epi32(t_Bit);
+					return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(a, Bit), Bit));
+				}
+				static inline Float Select(Mask m, Float a, Float b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+				static inline Float FlipSign(Float a, Mask m) { return _mm_xor_ps(a, _mm_and_ps(m, _mm_set1_ps(-0.0f))); }
+			};
+#endif  // FLING_TRANSFORM_SSE2
+
+			bool CpuHasAVX2()
+			{
+#if FLING_TRANSFORM_X86 && defined(_MSC_VER)
+				int Info[4] = {};
+				__cpuid(Info, 0);
+				if (Info[0] < 7)
+				{
+					return false;
+				}
+
+				__cpuid(Info, 1);
+				const bool HasFMA = (Info[2] & (1 << 12)) != 0;
+				const bool HasOSXSave = (Info[2] & (1 << 27)) != 0;
+				if (!HasFMA || !HasOSXSave)
+				{
+					return false;
+				}
+
+				// The OS has to save the YMM registers on a context switch
+				if ((_xgetbv(0) & 0x6) != 0x6)
+				{
+					return false;
+				}
+
+				__cpuidex(Info, 7, 0);
+				return (Info[1] & (1 << 5)) != 0;
+#elif FLING_TRANSFORM_X86 && defined(__GNUC__)
+				__builtin_cpu_init();
+				return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+				return false;
+#endif
+			}
+
+			using KernelFunc = void(*)(const TransformStreams&, uint32_t, float* const*);
+
+			KernelFunc GetKernel(Isa t_Isa)
+			{
+				switch (t_Isa)
+				{
+#if FLING_TRANSFORM_X86
+				case Isa::AVX2:
+					return &Detail::UpdateWorldMatricesAVX2;
+#endif
+#if FLING_TRANSFORM_SSE2
+				case Isa::SSE2:
+					return &Detail::UpdateWorldMatrices<SSE2Lanes>;
+#endif
+				default:
+					return &Detail::UpdateWorldMatrices<ScalarLanes>;
+				}
+			}
+		}   // namespace
+
+		bool IsSupported(Isa t_Isa)
+		{
+			switch (t_Isa)
+			{
+			case Isa::Scalar:
+				return true;
+			case Isa::SSE2:
+#if FLING_TRANSFORM_SSE2
+				return true;
+#else
+				return false;
+#endif
+			case Isa::AVX2:
+			{
+				static const bool HasAVX2 = CpuHasAVX2();
+				return HasAVX2;
+			}
+			default:
+				return false;
+			}
+		}
+
+		Isa GetBestIsa()
+		{
+			static const Isa Best = IsSupported(Isa::AVX2) ? Isa::AVX2 : (IsSupported(Isa::SSE2) ? Isa::SSE2 : Isa::Scalar);
+			return Best;
+		}
+
+		const char* GetIsaName(Isa t_Isa)
+		{
+			switch (t_Isa)
+			{
+			case Isa::Scalar:	return "Scalar";
+			case Isa::SSE2:		return "SSE2";
+			case Isa::AVX2:		return "AVX2";
+			default:			return "Unknown";
+			}
+		}
+
+		void UpdateWorldMatrices(const TransformStreams& t_In, UINT32 t_Count, glm::mat4* const* t_Out)
+		{
+			static const KernelFunc Kernel = GetKernel(GetBestIsa());
+			Kernel(t_In, t_Count, reinterpret_cast<float* const*>(t_Out));
+		}
+
+		void UpdateWorldMatrices(Isa t_Isa, const TransformStreams& t_In, UINT32 t_Count, glm::mat4* const* t_Out)
+		{
+			assert(IsSupported(t_Isa));
+			GetKernel(t_Isa)(t_In, t_Count, reinterpret_cast<float* const*>(t_Out));
+		}
+	}   // namespace TransformKernels
+}   // namespace Fling
@@ -0,0 +1,54 @@
+// Compiled with AVX2 and FMA enabled (see CMakeLists.txt), and only called after
+// TransformKernels has checked that the CPU supports them. This file intentionally
+// does not include pch.h, see TransformKernelMath.h
+#include "TransformKernelMath.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+
+#include <immintrin.h>
+
+namespace Fling
+{
+	namespace TransformKernels
+	{
+		namespace
+		{
+			struct AVX2Lanes
+			{
+				using Float = __m256;
+				using Int = __m256i;
+				using Mask = __m256;
+				static constexpr uint32_t Width = 8;
+
+				static inline Float Set(float t_Val) { return _mm256_set1_ps(t_Val); }
+				static inline Float Load(const float* t_Src) { return _mm256_loadu_ps(t_Src); }
+				static inline void Store(float* t_Dst, Float t_Val) { _mm256_store_ps(t_Dst, t_Val); }
+				static inline Float Add(Float a, Float b) { return _mm256_add_ps(a, b); }
+				static inline Float Sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+				static inline Float Mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+				static inline Float MulAdd(Float a, Float b, Float c) { return _mm256_fmadd_ps(a, b, c); }
+				static inline Int RoundToInt(Float a) { return _mm256_cvtps_epi32(a); }
+				static inline Float ToFloat(Int a) { return _mm256_cvtepi32_ps(a); }
+				static inline Int AddInt(Int a, int32_t b) { return _mm256_add_epi32(a, _mm256_set1_epi32(b)); }
+				static inline Mask TestBit(Int a, int32_t t_Bit)
+				{
+					const __m256i Bit = _mm256_set1_epi32(t_Bit);
+					return _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(a, Bit), Bit));
+				}
+				static inline Float Select(Mask m, Float a, Float b) { return _mm256_blendv_ps(b, a, m); }
+				static inline Float FlipSign(Float a, Mask m) { return _mm256_xor_ps(a, _mm256_and_ps(m, _mm256_set1_ps(-0.0f))); }
+			};
+		}   // namespace
+
+		namespace Detail
+		{
+			void UpdateWorldMatricesAVX2(const TransformStreams& t_In, uint32_t t_Count, float* const* t_Out)
+			{
+				UpdateWorldMatrices<AVX2Lanes>(t_In, t_Count, t_Out);
+				_mm256_zeroupper();
+			}
+		}   // namespace Detail
+	}   // namespace TransformKernels
+}   // namespace Fling
+
+#endif
@@ -0,0 +1,213 @@
+#include "pch.h"
+#include "TransformSystem.h"
+#include "JobSystem.h"
+#include "TransformKernels.h"
+
+#include <algorithm>
+
+namespace Fling
+{
+	namespace
+	{
+		/** Dirty roots gathered from one job's range of transforms, updated together by the SIMD kernels */
+		struct DirtyRootBatch
+		{
+			static constexpr UINT32 Capacity = 64;
+
+			float Streams[9][Capacity];
+			Transform* Targets[Capacity];
+			glm::mat4* Out[Capacity];
+			UINT32 Count = 0;
+
+			void Add(Transform& t_Trans, UINT32 t_Frame)
+			{
+				Streams[0][Count] = t_Trans.m_Pos.x;
+				Streams[1][Count] = t_Trans.m_Pos.y;
+				Streams[2][Count] = t_Trans.m_Pos.z;
+				Streams[3][Count] = t_Trans.m_Rotation.x;
+				Streams[4][Count] = t_Trans.m_Rotation.y;
+				Streams[5][Count] = t_Trans.m_Rotation.z;
+				Streams[6][Count] = t_Trans.m_Scale.x;
+				Streams[7][Count] = t_Trans.m_Scale.y;
+				Streams[8][Count] = t_Trans.m_Scale.z;
+				Targets[Count] = &t_Trans;
+				Out[Count] = &t_Trans.m_worldMat;
+
+				if (++Count == Capacity)
+				{
+					Flush(t_Frame);
+				}
+			}
+
+			void Flush(UINT32 t_Frame)
+			{
+				if (Count == 0)
+				{
+					return;
+				}
+
+				TransformStreams In;
+				In.PosX = Streams[0];
+				In.PosY = Streams[1];
+				In.PosZ = Streams[2];
+				In.RotX = Streams[3];
+				In.RotY = Streams[4];
+				In.RotZ = Streams[5];
+				In.ScaleX = Streams[6];
+				In.ScaleY = Streams[7];
+				In.ScaleZ = Streams[8];
+
+				TransformKernels::UpdateWorldMatrices(In, Count, Out);
+
+				for (UINT32 i = 0; i < Count; ++i)
+				{
+					Targets[i]->m_IsDirty = false;
+					Targets[i]->m_WorldChangedFrame = t_Frame;
+				}
+				Count = 0;
+			}
+		};
+	}   // namespace
+
+	TransformSystem::TransformSystem(entt::registry& t_Reg)
+		: m_Registry(t_Reg)
+	{
+		m_Registry.on_construct<Parent>().connect<&TransformSystem::OnParentChanged>(*this);
+		m_Registry.on_replace<Parent>().connect<&TransformSystem::OnParentChanged>(*this);
+		m_Registry.on_destroy<Parent>().connect<&TransformSystem::OnParentRemoved>(*this);
+		m_Registry.on_construct<Transform>().connect<&TransformSystem::OnTransformAdded>(*this);
+		m_Registry.on_destroy<Transform>().connect<&TransformSystem::OnTransformRemoved>(*this);
+	}
+
+	TransformSystem::~TransformSystem()
+	{
+		m_Registry.on_construct<Parent>().disconnect<&TransformSystem::OnParentChanged>(*this);
+		m_Registry.on_replace<Parent>().disconnect<&TransformSystem::OnParentChanged>(*this);
+		m_Registry.on_destroy<Parent>().disconnect<&TransformSystem::OnParentRemoved>(*this);
+		m_Registry.on_construct<Transform>().disconnect<&TransformSystem::OnTransformAdded>(*this);
+		m_Registry.on_destroy<Transform>().disconnect<&TransformSystem::OnTransformRemoved>(*this);
+	}
+
+	void TransformSystem::Update(entt::registry& t_Reg)
+	{
+		++m_Frame;
+
+		if (m_HierarchyDirty)
+		{
+			SortChildren(t_Reg);
+			m_HierarchyDirty = false;
+		}
+
+		const UINT32 Frame = m_Frame;
+
+		// Roots only depend on themselves, so each job gathers the dirty ones in its range and
+		// updates them in batches
+		auto Transforms = t_Reg.view<Transform>();
+		const entt::entity* Entities = Transforms.data();
+		JobSystem::ParallelFor(static_cast<UINT32>(Transforms.size()), 256, [&](UINT32 t_Begin, UINT32 t_End)
+		{
+			DirtyRootBatch Batch;
+			for (UINT32 i = t_Begin; i < t_End; ++i)
+			{
+				Transform& Trans = Transforms.get(Entities[i]);
+				if (Trans.m_IsDirty && !t_Reg.has<Parent>(Entities[i]))
+				{
+					Batch.Add(Trans, Frame);
+				}
+			}
+			Batch.Flush(Frame);
+		});
+
+		// Children are sorted by depth, so their parent's world matrix is always up to date here
+		for (entt::entity Child : m_SortedChildren)
+		{
+			Transform& Trans = t_Reg.get<Transform>(Child);
+			const entt::entity ParentEnt = t_Reg.get<Parent>(Child).Entity;
+
+			const Transform* ParentTrans =
+				(t_Reg.valid(ParentEnt) && t_Reg.has<Transform>(ParentEnt)) ? &t_Reg.get<Transform>(ParentEnt) : nullptr;
+
+			const bool ParentChanged = ParentTrans && ParentTrans->m_WorldChangedFrame == Frame;
+			if (!Trans.m_IsDirty && !ParentChanged)
+			{
+				continue;
+			}
+
+			Trans.m_worldMat = ParentTrans ? ParentTrans->m_worldMat * Trans.GetLocalMatrix() : Trans.GetLocalMatrix();
+			Trans.m_IsDirty = false;
+			Trans.m_WorldChangedFrame = Frame;
+		}
+	}
+
+	void TransformSystem::SortChildren(entt::registry& t_Reg)
+	{
+		m_SortScratch.clear();
+
+		// Any chain longer than this must loop back on itself
+		const UINT32 MaxDepth = static_cast<UINT32>(t_Reg.size<Parent>());
+
+		t_Reg.view<Transform, Parent>().each([&](entt::entity t_Ent, Transform& t_Trans, Parent& t_Parent)
+		{
+			// A destroyed parent leaves the child as a root
+			if (!t_Reg.valid(t_Parent.Entity) || !t_Reg.has<Transform>(t_Parent.Entity))
+			{
+				t_Trans.MarkDirty();
+			}
+
+			UINT32 Depth = 0;
+			entt::entity Current = t_Parent.Entity;
+			while (t_Reg.valid(Current) && t_Reg.has<Parent>(Current))
+			{
+				if (++Depth > MaxDepth)
+				{
+					F_LOG_WARN("Transform hierarchy has a cycle, world matrices of the cycle will be wrong");
+					break;
+				}
+				Current = t_Reg.get<Parent>(Current).Entity;
+			}
+
+			m_SortScratch.emplace_back(Depth, t_Ent);
+		});
+
+		std::stable_sort(m_SortScratch.begin(), m_SortScratch.end(),
+			[](const std::pair<UINT32, entt::entity>& A, const std::pair<UINT32, entt::entity>& B) { return A.first < B.first; });
+
+		m_SortedChildren.resize(m_SortScratch.size());
+		for (size_t i = 0; i < m_SortScratch.size(); ++i)
+		{
+			m_SortedChildren[i] = m_SortScratch[i].second;
+		}
+	}
+
+	void TransformSystem::OnParentChanged(entt::entity t_Ent, entt::registry& t_Reg, Parent& t_Parent)
+	{
+		m_HierarchyDirty = true;
+		if (t_Reg.has<Transform>(t_Ent))
+		{
+			t_Reg.get<Transform>(t_Ent).MarkDirty();
+		}
+	}
+
+	void TransformSystem::OnParentRemoved(entt::entity t_Ent, entt::registry& t_Reg)
+	{
+		m_HierarchyDirty = true;
+		if (t_Reg.has<Transform>(t_Ent))
+		{
+			t_Reg.get<Transform>(t_Ent).MarkDirty();
+		}
+	}
+
+	void TransformSystem::OnTransformAdded(entt::entity t_Ent, entt::registry& t_Reg, Transform& t_Trans)
+	{
+		if (t_Reg.has<Parent>(t_Ent))
+		{
+			m_HierarchyDirty = true;
+		}
+	}
+
+	void TransformSystem::OnTransformRemoved(entt::entity t_Ent, entt::registry& t_Reg)
+	{
+		// Children of this entity need to become roots
+		m_HierarchyDirty = true;
+	}
+}   // namespace Fling
@@ -6,6 +6,7 @@ namespace Fling
 	World::World(entt::registry& t_Reg, Fling::Game* t_Game)
 		: m_Registry(t_Reg)
 		, m_Game(t_Game)
+		, m_TransformSystem(t_Reg)
 	{ }
 
     void World::Init()
@@ -29,11 +30,12 @@ namespace Fling
 	
     void World::Update(float t_DeltaTime)
     {
-		// TODO: Update any _world_ systems 
-
 		// The physics of our objects (position and what not)
 
 		// Once we are done with core updates, then call the game!
 		m_Game->Update(m_Registry, t_DeltaTime);
+
+		// Now that everything has moved, get the world matrices ready for rendering
+		m_TransformSystem.Update(m_Registry);
     }
 } // namespace Fling
\ No newline at end of file
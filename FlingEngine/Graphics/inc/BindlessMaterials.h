@@ -0,0 +1,69 @@
+#pragma once
+
+#include "FlingTypes.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace Fling
+{
+	class Texture;
+	class Material;
+	struct PBRTextures;
+
+	/** What the bindless G-Buffer shader knows about a material, see mrt_bindless.frag */
+	struct alignas(16) BindlessMaterialData
+	{
+		/** Slots in the bindless texture array */
+		UINT32 AlbedoIndex = 0;
+		UINT32 NormalIndex = 0;
+		UINT32 MetalIndex = 0;
+		UINT32 RoughnessIndex = 0;
+	};
+	static_assert(sizeof(BindlessMaterialData) == 16, "Bindless material layout has to match the shader's std430 struct");
+
+	/**
+	 * @brief	Hands out the slots of textures in the bindless texture array and the indices of
+	 *			materials in the material buffer. Slots are given out in order and never move, so
+	 *			only the ones past what was last written need to be uploaded.
+	 */
+	class BindlessMaterialTable
+	{
+	public:
+
+		/**
+		 * @param t_MaxTextures		Size of the texture array in the descriptor set
+		 * @param t_MaxMaterials	Number of materials the material buffer has room for
+		 */
+		BindlessMaterialTable(UINT32 t_MaxTextures, UINT32 t_MaxMaterials);
+
+		/** Slot of the texture, added the first time it's seen. Slot 0 once the array is full */
+		UINT32 AddTexture(Texture* t_Texture);
+
+		/**
+		 * @brief	Index of the material in the material buffer, added along with it's textures the
+		 *			first time it's seen. Index 0 once the buffer is full.
+		 */
+		UINT32 AddMaterial(const Material* t_Mat, const PBRTextures& t_Textures);
+
+		/** Textures in slot order */
+		FORCEINLINE const std::vector<Texture*>& GetTextures() const { return m_Textures; }
+
+		/** Materials in the order they go in the material buffer */
+		FORCEINLINE const std::vector<BindlessMaterialData>& GetMaterials() const { return m_Materials; }
+
+		FORCEINLINE UINT32 GetMaxTextures() const { return m_MaxTextures; }
+		FORCEINLINE UINT32 GetMaxMaterials() const { return m_MaxMaterials; }
+
+	private:
+
+		UINT32 m_MaxTextures = 0;
+		UINT32 m_MaxMaterials = 0;
+
+		std::vector<Texture*> m_Textures;
+		std::unordered_map<Texture*, UINT32> m_TextureSlots;
+
+		std::vector<BindlessMaterialData> m_Materials;
+		std::unordered_map<const Material*, UINT32> m_MaterialIndices;
+	};
+}   // namespace Fling
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "FlingTypes.h"
+
+#include <vector>
+
+namespace Fling
+{
+	/** GPU block compressed formats that the texture cooker can write. Every block is 4x4 pixels */
+	enum class BlockFormat : UINT32
+	{
+		/** RGB at 4 bits per pixel */
+		BC1 = 0,
+
+		/** BC1 color with a BC4 alpha, 8 bits per pixel */
+		BC3 = 1,
+
+		/** One channel at 4 bits per pixel */
+		BC4 = 2,
+
+		/** Two BC4 channels, used for the XY of normal maps */
+		BC5 = 3,
+
+		/** RGBA at 8 bits per pixel with much better quality than BC1 and BC3 */
+		BC7 = 4,
+	};
+
+	/**
+	 * @brief	CPU encoders and decoders for the BC formats. The decoders are only here to measure
+	 *			the quality of the encoders, the GPU does the decoding at runtime.
+	 */
+	namespace BlockCompression
+	{
+		static constexpr UINT32 BlockDim = 4;
+
+		/** Bytes in one 4x4 block */
+		UINT32 GetBlockSize(BlockFormat t_Format);
+
+		const char* GetFormatName(BlockFormat t_Format);
+
+		/** Number of RGBA channels that survive compression, BC4 only keeps R and BC5 keeps RG */
+		UINT32 GetChannelCount(BlockFormat t_Format);
+
+		/** Bytes needed for a whole image, partial blocks at the edges are padded to a full block */
+		UINT64 GetCompressedSize(BlockFormat t_Format, UINT32 t_Width, UINT32 t_Height);
+
+		/**
+		 * @brief	Encode 16 RGBA8 pixels in row order into a single block. BC7 only uses mode 6,
+		 *			which has one subset with RGBA endpoints and 16 interpolated colors.
+		 */
+		void EncodeBlock(BlockFormat t_Format, const UINT8 t_Pixels[64], UINT8* t_OutBlock);
+
+		/**
+		 * @brief	Decode a block into 16 RGBA8 pixels. Missing channels are 0 and a missing alpha
+		 *			is 255, the same as sampling on the GPU. Only BC7 mode 6 is supported.
+		 */
+		void DecodeBlock(BlockFormat t_Format, const UINT8* t_Block, UINT8 t_OutPixels[64]);
+
+		/**
+		 * @brief	Compress a whole RGBA8 image. Rows of blocks are split across the job system when
+		 *			called from a job thread. Partial blocks repeat the last row and column.
+		 */
+		void CompressImage(BlockFormat t_Format, const UINT8* t_Pixels, UINT32 t_Width, UINT32 t_Height, std::vector<UINT8>& t_OutBlocks);
+
+		void DecompressImage(BlockFormat t_Format, const UINT8* t_Blocks, UINT32 t_Width, UINT32 t_Height, std::vector<UINT8>& t_OutPixels);
+
+		/**
+		 * @brief	Peak signal to noise ratio of two RGBA8 images in dB, comparing only the first
+		 *			t_Channels channels of each pixel. Identical images are infinitely good.
+		 */
+		double ComputePSNR(const UINT8* t_A, const UINT8* t_B, UINT32 t_PixelCount, UINT32 t_Channels);
+
+	}   // namespace BlockCompression
+}   // namespace Fling
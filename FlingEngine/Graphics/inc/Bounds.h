@@ -0,0 +1,64 @@
+#pragma once
+
+#include "FlingMath.h"
+
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+
+namespace Fling
+{
+	/** Axis aligned bounding box. Starts inverted so that the first Expand sets it to the point */
+	struct BoundingBox
+	{
+		glm::vec3 Min { FLT_MAX };
+		glm::vec3 Max { -FLT_MAX };
+
+		inline void Expand(const glm::vec3& t_Point)
+		{
+			Min = glm::min(Min, t_Point);
+			Max = glm::max(Max, t_Point);
+		}
+
+		inline bool IsValid() const { return Min.x <= Max.x && Min.y <= Max.y && Min.z <= Max.z; }
+
+		inline glm::vec3 GetCenter() const { return (Min + Max) * 0.5f; }
+
+		/** Half the size of the box on each axis */
+		inline glm::vec3 GetExtents() const { return (Max - Min) * 0.5f; }
+	};
+
+	struct BoundingSphere
+	{
+		glm::vec3 Center {};
+		float Radius = 0.0f;
+
+		/** The sphere that encloses the box */
+		static inline BoundingSphere FromBox(const BoundingBox& t_Box)
+		{
+			BoundingSphere Sphere = {};
+			if (t_Box.IsValid())
+			{
+				Sphere.Center = t_Box.GetCenter();
+				Sphere.Radius = glm::length(t_Box.GetExtents());
+			}
+			return Sphere;
+		}
+
+		/**
+		 * @brief	Move this sphere into the space of the given matrix. Non uniform scale grows the
+		 *			radius by the largest axis so that the sphere still encloses the mesh
+		 */
+		inline BoundingSphere Transformed(const glm::mat4& t_Mat) const
+		{
+			const float ScaleSq = std::max(
+				glm::dot(glm::vec3(t_Mat[0]), glm::vec3(t_Mat[0])),
+				std::max(glm::dot(glm::vec3(t_Mat[1]), glm::vec3(t_Mat[1])), glm::dot(glm::vec3(t_Mat[2]), glm::vec3(t_Mat[2]))));
+
+			BoundingSphere Out = {};
+			Out.Center = glm::vec3(t_Mat * glm::vec4(Center, 1.0f));
+			Out.Radius = Radius * std::sqrt(ScaleSq);
+			return Out;
+		}
+	};
+}   // namespace Fling
@@ -2,11 +2,13 @@
 
 #include "FlingVulkan.h"
 #include "FlingExports.h"
+#include "DeviceMemoryAllocator.h"
 
 namespace Fling
 {
     /**
      * A Buffer represents a Vulkan buffer with a size, buffer pointer, and buffer memory. 
+     * The memory is sub allocated from the VulkanApp's DeviceMemoryAllocator.
      */
     class FLING_API Buffer
     {
@@ -18,7 +20,7 @@ namespace Fling
         Buffer()
             : m_Size(0)
             , m_Buffer(VK_NULL_HANDLE)
-            , m_BufferMemory(VK_NULL_HANDLE)
+            , m_Allocation{}
             , m_Descriptor{}
             , m_MappedMem(nullptr)
         {
@@ -34,12 +36,14 @@ namespace Fling
          * @param t_Usage         Vk usage flags for this buffer 
          * @param t_Properties     Vk props of this buffer, used to find the memory type
          * @param t_Data         Pointer to data that this buffer should map to, e.g. a staging buffer (Default = nullptr) 
+         * @param t_Strategy     How the memory is sub allocated, use Linear for short lived buffers
          */
         Buffer(
             const VkDeviceSize& t_Size,
             const VkBufferUsageFlags& t_Usage,
             const VkMemoryPropertyFlags& t_Properties,
-            const void* t_Data = nullptr
+            const void* t_Data = nullptr,
+            AllocationStrategy t_Strategy = AllocationStrategy::Buddy
         );
 
         /**
@@ -52,14 +56,18 @@ namespace Fling
 
         FORCEINLINE const VkBuffer& GetVkBuffer() const { return m_Buffer; }
 
-        FORCEINLINE const VkDeviceMemory& GetVkDeviceMemory() const { return m_BufferMemory; }
+        FORCEINLINE const VkDeviceMemory& GetVkDeviceMemory() const { return m_Allocation.Memory; }
+
+        /** The range of device memory that this buffer is bound to */
+        FORCEINLINE const DeviceAllocation& GetAllocation() const { return m_Allocation; }
 
         FORCEINLINE const VkDeviceSize& GetSize() const { return m_Size; }
 
         FORCEINLINE VkDescriptorBufferInfo& GetDescriptor() { return m_Descriptor; }
 
         /**
-         * @brief Copy the contents of the source buffer to the destination buffer using a single command
+         * @brief Copy the contents of the source buffer to the destination buffer with an upload batch and wait for it.
+         *        The source should be a host visible buffer that hasn't been used by a queue
          * 
          * @param t_SrcBuffer     Source buffer data
          * @param t_DstBuffer     Destination buffer data
@@ -78,17 +86,19 @@ namespace Fling
          * 
          * @return true     memory is not null and the size is greater than 0
          */
-        bool IsUsed() const { return m_BufferMemory != VK_NULL_HANDLE && m_Buffer != VK_NULL_HANDLE && m_Size; }
+        bool IsUsed() const { return m_Allocation.IsValid() && m_Buffer != VK_NULL_HANDLE && m_Size; }
 
         /**
-         * @brief Map the memory of this buffer to the given data
+         * @brief Point m_MappedMem at this buffer's memory. Host visible memory is persistently 
+         *        mapped by the allocator, so this does not call vkMapMemory
          *
-         * @param t_Data    Where to map this buffer's data to
+         * @param t_Size    Unused, the whole buffer is always mapped
+         * @param t_Offset  Offset from the start of this buffer
          */
         VkResult MapMemory(VkDeviceSize t_Size = VK_WHOLE_SIZE, VkDeviceSize t_Offset = 0);
         
         /**
-         * @brief Unmap this buffers memory from the Vulkan device
+         * @brief Stop using the mapped pointer of this buffer
          */
         void UnmapMemory();
         
@@ -100,19 +110,21 @@ namespace Fling
          * @param t_Properties memory properties
          * @param t_unmapBuffer flag to unmap buffer
          * @param t_Data data to map to buffer 
+         * @param t_Strategy how the memory is sub allocated
          */
         void CreateBuffer(
             const VkDeviceSize& t_size,
             const VkBufferUsageFlags& t_Usage,
             const VkMemoryPropertyFlags& t_Properties,
             bool t_unmapBuffer,
-            const void* t_Data = nullptr);
+            const void* t_Data = nullptr,
+            AllocationStrategy t_Strategy = AllocationStrategy::Buddy);
             
         /**
          * @brief Flush memory range to device 
          *
-         * @param t_size Size of the memory range to flush to
-         * @param t_offset offset from the beginning
+         * @param t_size Size of the memory range to flush to, VK_WHOLE_SIZE for the whole buffer
+         * @param t_offset offset from the beginning of this buffer
          */
         void Flush(VkDeviceSize t_size, VkDeviceSize t_offset);
     
@@ -126,8 +138,8 @@ namespace Fling
         /** Vulkan logical buffer object */
         VkBuffer m_Buffer;
 
-        /** Pointer to the physical device memory for this buffer */
-        VkDeviceMemory m_BufferMemory;
+        /** The device memory for this buffer, owned by the DeviceMemoryAllocator */
+        DeviceAllocation m_Allocation;
 
         /** The descriptor stores info about the offset, buffer, and; size of this */
         VkDescriptorBufferInfo m_Descriptor;
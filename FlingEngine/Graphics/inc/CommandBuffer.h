@@ -32,17 +32,36 @@ namespace Fling
 			Executable,
 		};
 
-		CommandBuffer(const LogicalDevice* t_Device, VkCommandPool t_CmdPool);
+		CommandBuffer(const LogicalDevice* t_Device, VkCommandPool t_CmdPool, VkCommandBufferLevel t_Level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
 		~CommandBuffer();
 
 		inline VkCommandBuffer GetHandle() const { return m_Handle; }
 		inline const LogicalDevice* GetDevice() const { return m_Device; }
 		inline const VkCommandPool& GetPoolHandle() const { return m_Pool; }
+		inline VkCommandBufferLevel GetLevel() const { return m_Level; }
 
 		/** Begin recording for this command buffer */
 		void Begin(VkCommandBufferUsageFlagBits t_Usage = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT);
 
-		void BeginRenderPass(FrameBuffer& t_frameBuf, const std::vector<VkClearValue>& t_ClearVales);
+		/**
+		 * @brief	Begin recording a secondary command buffer that will be executed inside of
+		 *			the given render pass. Secondary buffers do not inherit any state from
+		 *			the primary, so viewport, scissor and pipeline must be set again.
+		 *
+		 * @param t_RenderPass		Render pass that the primary buffer will execute this in
+		 * @param t_Subpass			Index of the subpass in the render pass
+		 * @param t_FrameBuffer		Frame buffer that will be used (VK_NULL_HANDLE if unknown)
+		 */
+		void BeginSecondary(VkRenderPass t_RenderPass, UINT32 t_Subpass, VkFramebuffer t_FrameBuffer = VK_NULL_HANDLE);
+
+		/**
+		 * @param t_Contents	Use VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS if the render pass
+		 *						contents will be recorded in secondary command buffers
+		 */
+		void BeginRenderPass(FrameBuffer& t_frameBuf, const std::vector<VkClearValue>& t_ClearVales, VkSubpassContents t_Contents = VK_SUBPASS_CONTENTS_INLINE);
+
+		/** Execute the given secondary command buffers from this primary command buffer */
+		void ExecuteCommands(const std::vector<VkCommandBuffer>& t_SecondaryBuffers);
 
 		void NextSubpass();
 
@@ -64,6 +83,8 @@ namespace Fling
 
 		const VkCommandPool m_Pool;
 
+		const VkCommandBufferLevel m_Level;
+
 		VkCommandBuffer m_Handle = VK_NULL_HANDLE;
 
 		// Keep track of the state of this command buffer
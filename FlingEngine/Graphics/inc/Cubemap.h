@@ -73,12 +73,12 @@ namespace Fling
              * 
              * @return const UINT32 
              */
-            UINT32 GetIndexCount() const { return m_Cube->GetIndexCount(); }
+            UINT32 GetIndexCount() const { return m_Cube->GetLod(0).IndexCount; }
 
             VkIndexType GetIndexType() const { return m_Cube->GetIndexType(); }
 
             VkImage GetImage() const { return m_Image; }
-            VkDeviceMemory GetImageMemory() const{ return m_ImageMemory; }
+            VkDeviceMemory GetImageMemory() const{ return m_ImageMemory.Memory; }
             VkDescriptorImageInfo& GetImageInfo() { return m_DescriptorImageInfo; }
 
         private:
@@ -104,7 +104,7 @@ namespace Fling
             VkImage m_Image;
             VkImageView m_Imageview;
             VkImageLayout m_ImageLayout;
-            VkDeviceMemory m_ImageMemory;
+            DeviceAllocation m_ImageMemory;
             VkSampler m_Sampler;
             
             VkDescriptorSetLayout m_DescriptorSetLayout;
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Subpass.h"
+#include "UniformRingBuffer.h"
+#include "DrawList.h"
 
 namespace Fling
 {
@@ -10,6 +12,7 @@ namespace Fling
 	struct MeshRenderer;
 	class Swapchain;
 	class FirstPersonCamera;
+	class FrustumCuller;
 
 	class DebugSubpass : public Subpass
 	{
@@ -20,6 +23,7 @@ namespace Fling
 			entt::registry& t_reg,
 			VkRenderPass t_GlobalRenderPass,
 			FirstPersonCamera* t_Cam,
+			const FrustumCuller* t_Culler,
 			std::shared_ptr<Fling::Shader> t_Vert,
 			std::shared_ptr<Fling::Shader> t_Frag
 		);
@@ -30,22 +34,35 @@ namespace Fling
 
 		void CreateDescriptorSets(VkDescriptorPool t_Pool, entt::registry& t_reg) override;
 
+		const char* GetName() const override { return "Debug"; }
+
+		void DeclareResources(RenderGraph& t_Graph, UINT32 t_Pass) override;
+
 		void PrepareAttachments() override;
 
 		void CreateGraphicsPipeline() override;
 
 		void CleanUp(entt::registry& t_reg) override;
 
+		DrawListStats GetDrawStats() const override { return m_DrawList.GetStats(); }
+
 	private:
 
 		void OnMeshRendererAdded(entt::entity t_Ent, entt::registry& t_Reg, MeshRenderer& t_MeshRend);
 
-		void CreateMeshDescriptorSet(MeshRenderer& t_MeshRend);
+		/** Create the descriptor set that every debug mesh shares if it doesn't exist yet */
+		void CreateDescriptorSet();
+
+		/** Max number of debug meshes that can be drawn in a frame */
+		static constexpr UINT32 MaxObjectsPerFrame = 1024;
 
 		VkRenderPass m_GlobalRenderPass = VK_NULL_HANDLE;
 
 		const FirstPersonCamera* m_Camera;
 
+		/** Visible meshes for this frame */
+		const FrustumCuller* m_Culler;
+
 		struct DebugUBO
 		{
 			glm::mat4 Projection;
@@ -53,5 +70,13 @@ namespace Fling
 		} m_Ubo;
 
 		VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
+
+		VkDescriptorSet m_DescriptorSet = VK_NULL_HANDLE;
+
+		/** Per object uniforms, bound with a dynamic offset */
+		std::unique_ptr<UniformRingBuffer> m_UniformRing;
+
+		/** Debug meshes of this frame, sorted to share binds */
+		DrawList m_DrawList;
 	};
 }   // namespace Fling
\ No newline at end of file
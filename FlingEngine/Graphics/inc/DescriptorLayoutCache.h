@@ -0,0 +1,88 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "FlingVulkan.h"
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Fling
+{
+	/**
+	 * @brief	Creates each distinct descriptor set layout and pipeline layout once and hands out
+	 *			the same object to every pipeline that asks for it. Pipelines that are built from
+	 *			shaders with the same interface end up with the same layouts, which also makes their
+	 *			descriptor sets interchangeable.
+	 *
+	 *			The cache owns every layout it creates, they are destroyed with it. Safe to call
+	 *			from any thread.
+	 */
+	class DescriptorLayoutCache
+	{
+	public:
+
+		struct SetLayoutKey
+		{
+			VkDescriptorSetLayoutCreateFlags Flags = 0;
+			std::vector<VkDescriptorSetLayoutBinding> Bindings;
+
+			/** Descriptor indexing flags of each binding, empty if none of them have any */
+			std::vector<VkDescriptorBindingFlagsEXT> BindingFlags;
+
+			bool operator==(const SetLayoutKey& t_Other) const;
+		};
+
+		struct PipelineLayoutKey
+		{
+			std::vector<VkDescriptorSetLayout> SetLayouts;
+			std::vector<VkPushConstantRange> PushConstantRanges;
+
+			bool operator==(const PipelineLayoutKey& t_Other) const;
+		};
+
+		struct KeyHash
+		{
+			size_t operator()(const SetLayoutKey& t_Key) const;
+			size_t operator()(const PipelineLayoutKey& t_Key) const;
+		};
+
+		explicit DescriptorLayoutCache(VkDevice t_Device);
+
+		~DescriptorLayoutCache();
+
+		/**
+		 * @brief	Get the layout for a set with the given bindings, creating it the first time. Bindings
+		 *			can be in any order. Immutable samplers are not supported.
+		 * @param t_BindingFlags	Descriptor indexing flags for each of t_Bindings, or empty
+		 */
+		VkDescriptorSetLayout GetSetLayout(
+			const std::vector<VkDescriptorSetLayoutBinding>& t_Bindings, 
+			VkDescriptorSetLayoutCreateFlags t_Flags = 0, 
+			const std::vector<VkDescriptorBindingFlagsEXT>& t_BindingFlags = {});
+
+		VkPipelineLayout GetPipelineLayout(const std::vector<VkDescriptorSetLayout>& t_SetLayouts, const std::vector<VkPushConstantRange>& t_PushConstantRanges);
+
+		/** Number of layouts that were actually created */
+		UINT32 GetSetLayoutCount() const;
+		UINT32 GetPipelineLayoutCount() const;
+
+		/** Number of layouts that were asked for, including the ones that already existed */
+		UINT32 GetRequestCount() const;
+
+		/** Put bindings in the order that the cache compares them in, along with their flags if there are any */
+		static void SortBindings(std::vector<VkDescriptorSetLayoutBinding>& t_Bindings, std::vector<VkDescriptorBindingFlagsEXT>* t_BindingFlags = nullptr);
+
+	private:
+
+		VkDevice m_Device = VK_NULL_HANDLE;
+
+		mutable std::mutex m_Mutex;
+
+		std::unordered_map<SetLayoutKey, VkDescriptorSetLayout, KeyHash> m_SetLayouts;
+
+		std::unordered_map<PipelineLayoutKey, VkPipelineLayout, KeyHash> m_PipelineLayouts;
+
+		UINT32 m_RequestCount = 0;
+	};
+}   // namespace Fling
@@ -0,0 +1,343 @@
+#pragma once
+
+#include "FlingVulkan.h"
+#include "FlingTypes.h"
+
+#include <vector>
+#include <map>
+#include <set>
+#include <memory>
+#include <mutex>
+#include <functional>
+
+namespace Fling
+{
+	class MemoryBlock;
+
+	/** How the memory of a block is divided up between allocations */
+	enum class AllocationStrategy : UINT8
+	{
+		/** Power of 2 buddy allocator for general, long lived resources */
+		Buddy,
+
+		/** Bump allocator that only rewinds once every allocation in the block is freed. Use for transient memory like staging buffers */
+		Linear,
+	};
+
+	/**
+	 * @brief	Linear resources (buffers and linear tiled images) can't share a bufferImageGranularity
+	 *			page with optimal tiled images, so they are kept in separate blocks
+	 */
+	enum class ResourceLayout : UINT8
+	{
+		Linear,
+		Optimal,
+	};
+
+	/**
+	 * @brief	A range of device memory that was given out by the DeviceMemoryAllocator. Bind resources
+	 *			with Memory at Offset.
+	 */
+	struct DeviceAllocation
+	{
+		VkDeviceMemory Memory = VK_NULL_HANDLE;
+
+		VkDeviceSize Offset = 0;
+
+		VkDeviceSize Size = 0;
+
+		/** Pointer to the start of this allocation if the memory is host visible, blocks are persistently mapped */
+		void* MappedData = nullptr;
+
+		UINT32 MemoryTypeIndex = ~0u;
+
+		/** The block this was sub allocated from, null if this is a dedicated allocation */
+		MemoryBlock* Block = nullptr;
+
+		FORCEINLINE bool IsValid() const { return Memory != VK_NULL_HANDLE; }
+	};
+
+	/**
+	 * @brief	Usage stats of a single memory type, or of all of them
+	 */
+	struct DeviceMemoryStats
+	{
+		UINT32 BlockCount = 0;
+
+		UINT32 DedicatedAllocationCount = 0;
+
+		UINT32 AllocationCount = 0;
+
+		/** Bytes allocated from the driver */
+		VkDeviceSize AllocatedBytes = 0;
+
+		/** Bytes that were requested by allocations */
+		VkDeviceSize UsedBytes = 0;
+	};
+
+	/** Tuning of the DeviceMemoryAllocator */
+	struct DeviceMemoryConfig
+	{
+		/** Size of each block, must be a power of 2 */
+		VkDeviceSize BlockSize = 64ull * 1024ull * 1024ull;
+
+		/** Smallest buddy node, must be a power of 2 */
+		VkDeviceSize MinAllocationSize = 256;
+	};
+
+	/**
+	 * @brief	The driver calls the allocator makes. Replace this to test the allocator without a device.
+	 */
+	class DeviceMemoryBackend
+	{
+	public:
+
+		virtual ~DeviceMemoryBackend() = default;
+
+		/** @return The new memory or VK_NULL_HANDLE if the allocation failed */
+		virtual VkDeviceMemory AllocateMemory(UINT32 t_MemoryTypeIndex, VkDeviceSize t_Size) = 0;
+
+		virtual void FreeMemory(VkDeviceMemory t_Memory) = 0;
+
+		virtual void* MapMemory(VkDeviceMemory t_Memory) = 0;
+
+		virtual void UnmapMemory(VkDeviceMemory t_Memory) = 0;
+	};
+
+	/** Backend that goes straight to the Vulkan device */
+	class VulkanMemoryBackend : public DeviceMemoryBackend
+	{
+	public:
+
+		explicit VulkanMemoryBackend(VkDevice t_Device) : m_Device(t_Device) {}
+
+		virtual VkDeviceMemory AllocateMemory(UINT32 t_MemoryTypeIndex, VkDeviceSize t_Size) override;
+
+		virtual void FreeMemory(VkDeviceMemory t_Memory) override;
+
+		virtual void* MapMemory(VkDeviceMemory t_Memory) override;
+
+		virtual void UnmapMemory(VkDeviceMemory t_Memory) override;
+
+	private:
+
+		VkDevice m_Device = VK_NULL_HANDLE;
+	};
+
+	/**
+	 * @brief	Hands out offsets inside of a single block of memory. Does not know anything about Vulkan.
+	 */
+	class BlockSubAllocator
+	{
+	public:
+
+		virtual ~BlockSubAllocator() = default;
+
+		/**
+		 * @param t_Alignment 	Must be a power of 2
+		 * @return True if there was space for the allocation
+		 */
+		virtual bool Allocate(VkDeviceSize t_Size, VkDeviceSize t_Alignment, VkDeviceSize& t_OutOffset) = 0;
+
+		virtual void Free(VkDeviceSize t_Offset) = 0;
+
+		/** Bytes that can't be given to other allocations, including any rounding */
+		virtual VkDeviceSize GetReservedSize() const = 0;
+
+		virtual UINT32 GetAllocationCount() const = 0;
+
+		FORCEINLINE bool IsEmpty() const { return GetAllocationCount() == 0; }
+	};
+
+	/**
+	 * @brief	Buddy allocator, every allocation is rounded up to a power of 2 node inside of the
+	 *			block. Freed nodes are merged with their buddy so fragmentation stays low.
+	 */
+	class BuddySubAllocator : public BlockSubAllocator
+	{
+	public:
+
+		/**
+		 * @param t_Size 		Size of the block, must be a power of 2
+		 * @param t_MinNodeSize Smallest node that is handed out, must be a power of 2
+		 */
+		BuddySubAllocator(VkDeviceSize t_Size, VkDeviceSize t_MinNodeSize);
+
+		virtual bool Allocate(VkDeviceSize t_Size, VkDeviceSize t_Alignment, VkDeviceSize& t_OutOffset) override;
+
+		virtual void Free(VkDeviceSize t_Offset) override;
+
+		virtual VkDeviceSize GetReservedSize() const override { return m_ReservedSize; }
+
+		virtual UINT32 GetAllocationCount() const override { return static_cast<UINT32>(m_AllocatedLevels.size()); }
+
+	private:
+
+		FORCEINLINE VkDeviceSize GetNodeSize(UINT32 t_Level) const { return m_Size >> t_Level; }
+
+		VkDeviceSize m_Size = 0;
+
+		/** Level 0 is the whole block, each level down halves the node size */
+		UINT32 m_LevelCount = 0;
+
+		/** Offsets of the free nodes at each level */
+		std::vector<std::set<VkDeviceSize>> m_FreeLists;
+
+		/** Level of each allocated node by it's offset */
+		std::map<VkDeviceSize, UINT32> m_AllocatedLevels;
+
+		VkDeviceSize m_ReservedSize = 0;
+	};
+
+	/**
+	 * @brief	Bump allocator that rewinds to the start of the block once it is empty
+	 */
+	class LinearSubAllocator : public BlockSubAllocator
+	{
+	public:
+
+		explicit LinearSubAllocator(VkDeviceSize t_Size) : m_Size(t_Size) {}
+
+		virtual bool Allocate(VkDeviceSize t_Size, VkDeviceSize t_Alignment, VkDeviceSize& t_OutOffset) override;
+
+		virtual void Free(VkDeviceSize t_Offset) override;
+
+		virtual VkDeviceSize GetReservedSize() const override { return m_Head; }
+
+		virtual UINT32 GetAllocationCount() const override { return m_AllocationCount; }
+
+	private:
+
+		VkDeviceSize m_Size = 0;
+
+		VkDeviceSize m_Head = 0;
+
+		UINT32 m_AllocationCount = 0;
+	};
+
+	/**
+	 * @brief	Sub allocates device memory out of large blocks per memory type instead of having a
+	 *			vkAllocateMemory for every buffer and image. Host visible blocks stay mapped for
+	 *			their whole lifetime. Allocations that are larger than half of a block get their
+	 *			own dedicated memory.
+	 *
+	 *			Thread safe.
+	 */
+	class DeviceMemoryAllocator
+	{
+	public:
+
+		using Config = DeviceMemoryConfig;
+
+		/**
+		 * @brief Called when defragmentation wants to move an allocation. The owner has to copy it's data to
+		 *			the new allocation, rebind it's resource and update it's copy of the allocation, then return
+		 *			true. Returning false keeps the old allocation. Must not call back into the allocator.
+		 */
+		using MoveCallback = std::function<bool(const DeviceAllocation& t_From, const DeviceAllocation& t_To)>;
+
+		/**
+		 * @param t_MemoryProperties 	Memory types and heaps of the physical device
+		 * @param t_NonCoherentAtomSize Alignment of flushed ranges in host visible, non coherent memory
+		 * @param t_Backend 			The driver calls to use, takes ownership
+		 */
+		DeviceMemoryAllocator(
+			const VkPhysicalDeviceMemoryProperties& t_MemoryProperties,
+			VkDeviceSize t_NonCoherentAtomSize,
+			std::unique_ptr<DeviceMemoryBackend> t_Backend,
+			const Config& t_Config = Config {}
+		);
+
+		/** Frees every block, warns about any allocations that are still alive */
+		~DeviceMemoryAllocator();
+
+		DeviceMemoryAllocator(const DeviceMemoryAllocator&) = delete;
+		DeviceMemoryAllocator& operator=(const DeviceMemoryAllocator&) = delete;
+
+		/**
+		 * @brief	Allocate memory for a resource with the given requirements
+		 * @return	True if the allocation succeeded
+		 */
+		bool Allocate(
+			const VkMemoryRequirements& t_Requirements,
+			VkMemoryPropertyFlags t_Properties,
+			ResourceLayout t_Layout,
+			DeviceAllocation& t_OutAllocation,
+			AllocationStrategy t_Strategy = AllocationStrategy::Buddy
+		);
+
+		/** Free the allocation and reset it */
+		void Free(DeviceAllocation& t_Allocation);
+
+		/** Let defragmentation move this allocation by calling the given callback */
+		void SetMoveCallback(const DeviceAllocation& t_Allocation, MoveCallback t_Callback);
+
+		/**
+		 * @brief	Try to empty the least used buddy block of each pool by moving any allocations that
+		 *			have a move callback into other blocks. Empty blocks are given back to the driver.
+		 *			Call when the GPU is not using any of the movable resources.
+		 * @return	The number of allocations that were moved
+		 */
+		UINT32 Defragment(UINT32 t_MaxMoves = ~0u);
+
+		/** Index of the first memory type that is allowed by the type bits and has all of the properties, or ~0u */
+		UINT32 FindMemoryType(UINT32 t_TypeBits, VkMemoryPropertyFlags t_Properties) const;
+
+		DeviceMemoryStats GetStats() const;
+
+		DeviceMemoryStats GetStats(UINT32 t_MemoryTypeIndex) const;
+
+		FORCEINLINE UINT32 GetMemoryTypeCount() const { return m_MemoryProperties.memoryTypeCount; }
+
+		FORCEINLINE const VkPhysicalDeviceMemoryProperties& GetMemoryProperties() const { return m_MemoryProperties; }
+
+	private:
+
+		/** All blocks with the same memory type, layout and strategy */
+		struct MemoryPool
+		{
+			std::vector<std::unique_ptr<MemoryBlock>> Blocks;
+		};
+
+		struct DedicatedAllocation
+		{
+			VkDeviceSize Size = 0;
+			UINT32 MemoryTypeIndex = 0;
+		};
+
+		/** Size of the blocks of a memory type, smaller than the config for small heaps */
+		VkDeviceSize GetBlockSize(UINT32 t_MemoryTypeIndex) const;
+
+		static UINT32 GetPoolIndex(UINT32 t_MemoryTypeIndex, ResourceLayout t_Layout, AllocationStrategy t_Strategy);
+
+		/** Create a block and map it if it is host visible. Returns null if the backend is out of memory */
+		MemoryBlock* CreateBlock(UINT32 t_PoolIndex, UINT32 t_MemoryTypeIndex, AllocationStrategy t_Strategy);
+
+		void DestroyBlock(std::unique_ptr<MemoryBlock>& t_Block);
+
+		/** Try to allocate from any block of the pool other than t_Exclude, without creating new ones */
+		bool AllocateFromPool(MemoryPool& t_Pool, VkDeviceSize t_Size, VkDeviceSize t_Alignment, const MemoryBlock* t_Exclude, DeviceAllocation& t_OutAllocation);
+
+		bool AllocateDedicated(UINT32 t_MemoryTypeIndex, VkDeviceSize t_Size, DeviceAllocation& t_OutAllocation);
+
+		void FreeFromBlock(DeviceAllocation& t_Allocation);
+
+		/** Free empty blocks of the pool, other than one that is kept around to avoid thrashing if t_KeepEmptyBlock is set */
+		void TrimPool(MemoryPool& t_Pool, bool t_KeepEmptyBlock = true);
+
+		VkPhysicalDeviceMemoryProperties m_MemoryProperties {};
+
+		VkDeviceSize m_NonCoherentAtomSize = 1;
+
+		std::unique_ptr<DeviceMemoryBackend> m_Backend;
+
+		Config m_Config;
+
+		/** Indexed by memory type, then layout, then strategy */
+		std::vector<MemoryPool> m_Pools;
+
+		std::map<VkDeviceMemory, DedicatedAllocation> m_DedicatedAllocations;
+
+		mutable std::mutex m_Mutex;
+	};
+}   // namespace Fling
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "FlingVulkan.h"
+#include "FlingTypes.h"
+
+#include <vector>
+
+namespace Fling
+{
+	class CommandBuffer;
+
+	/** Everything that recording a single indexed draw needs */
+	struct DrawCommand
+	{
+		VkPipeline Pipeline = VK_NULL_HANDLE;
+		VkPipelineLayout PipelineLayout = VK_NULL_HANDLE;
+
+		/** Bound to set 0, VK_NULL_HANDLE to leave the bound set alone */
+		VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;
+		UINT32 DynamicOffsetCount = 0;
+		UINT32 DynamicOffset = 0;
+
+		VkBuffer VertexBuffer = VK_NULL_HANDLE;
+		VkBuffer IndexBuffer = VK_NULL_HANDLE;
+		VkIndexType IndexType = VK_INDEX_TYPE_UINT32;
+
+		UINT32 IndexCount = 0;
+		UINT32 FirstIndex = 0;
+		UINT32 InstanceCount = 1;
+		UINT32 FirstInstance = 0;
+	};
+
+	/** State changes and draws that were recorded into a command buffer */
+	struct DrawListStats
+	{
+		UINT32 PipelineBinds = 0;
+		UINT32 DescriptorSetBinds = 0;
+		UINT32 VertexBufferBinds = 0;
+		UINT32 IndexBufferBinds = 0;
+		UINT32 Draws = 0;
+
+		DrawListStats& operator+=(const DrawListStats& t_Other)
+		{
+			PipelineBinds += t_Other.PipelineBinds;
+			DescriptorSetBinds += t_Other.DescriptorSetBinds;
+			VertexBufferBinds += t_Other.VertexBufferBinds;
+			IndexBufferBinds += t_Other.IndexBufferBinds;
+			Draws += t_Other.Draws;
+			return *this;
+		}
+	};
+
+	/**
+	 * @brief	The state that is bound in a command buffer while it is recorded, so that binds which match
+	 *			it can be skipped. Every bind that does have to be recorded is counted in the stats
+	 */
+	class DrawStateTracker
+	{
+	public:
+
+		/** @return True if the pipeline has to be bound. Changing the pipeline forgets the bound descriptor set */
+		bool SetPipeline(VkPipeline t_Pipeline, VkPipelineLayout t_Layout);
+
+		/** @return True if the set has to be bound to set 0 with this dynamic offset */
+		bool SetDescriptorSet(VkDescriptorSet t_Set, UINT32 t_DynamicOffset = 0);
+
+		/** @return True if the buffer has to be bound to vertex binding 0 */
+		bool SetVertexBuffer(VkBuffer t_Buffer);
+
+		/** @return True if the index buffer has to be bound */
+		bool SetIndexBuffer(VkBuffer t_Buffer, VkIndexType t_IndexType);
+
+		inline void AddDraw() { ++m_Stats.Draws; }
+
+		/** Count a bind that is recorded outside of the tracked state */
+		inline DrawListStats& GetStats() { return m_Stats; }
+		inline const DrawListStats& GetStats() const { return m_Stats; }
+
+	private:
+
+		VkPipeline m_Pipeline = VK_NULL_HANDLE;
+		VkPipelineLayout m_Layout = VK_NULL_HANDLE;
+		VkDescriptorSet m_Set = VK_NULL_HANDLE;
+		UINT32 m_DynamicOffset = 0;
+		VkBuffer m_VertexBuffer = VK_NULL_HANDLE;
+		VkBuffer m_IndexBuffer = VK_NULL_HANDLE;
+		VkIndexType m_IndexType = VK_INDEX_TYPE_UINT32;
+
+		DrawListStats m_Stats = {};
+	};
+
+	/** A draw's sort key and where it's command is in the list */
+	struct DrawListItem
+	{
+		UINT64 Key = 0;
+		UINT32 Command = 0;
+	};
+
+	/**
+	 * @brief	Draws that a subpass collects over a frame, then sorts by a packed 64 bit key and
+	 *			records in that order. From the top bit down the key holds the pass, pipeline,
+	 *			material, mesh and view depth, so the most expensive state changes the least often
+	 *			and draws that share all of their state go front to back.
+	 *
+	 *			Recording skips any bind that matches the state that is already bound, the ids in
+	 *			the key only decide the order.
+	 */
+	class DrawList
+	{
+	public:
+
+		static constexpr UINT32 PassBits = 4;
+		static constexpr UINT32 PipelineBits = 12;
+		static constexpr UINT32 MaterialBits = 16;
+		static constexpr UINT32 MeshBits = 16;
+		static constexpr UINT32 DepthBits = 16;
+
+		/** Lists shorter than this are sorted with a comparison sort */
+		static constexpr UINT32 MinRadixSortCount = 256;
+
+		/** Fewest items that each job of the radix sort gets */
+		static constexpr UINT32 MinRadixChunkSize = 4096;
+
+		/**
+		 * @brief	Pack a sort key. Ids are masked to the bits of their field
+		 * @param t_Depth	Distance along the view direction, closer draws sort first
+		 */
+		static UINT64 MakeKey(UINT32 t_Pass, UINT32 t_Pipeline, UINT32 t_Material, UINT32 t_Mesh, float t_Depth);
+
+		/**
+		 * @brief	Small id of an object for a field of the key. Different objects can share an id, which
+		 *			only costs an extra bind because recording compares the real state
+		 */
+		static UINT32 GetSortId(const void* t_Object, UINT32 t_Bits);
+
+		/** Depth quantized to DepthBits, in the same order as the distances */
+		static UINT32 QuantizeDepth(float t_Depth);
+
+		/**
+		 * @brief	Stable least significant digit radix sort by key, a byte at a time. Each pass counts
+		 *			and scatters contiguous chunks on the job system. Bytes that are the same in every
+		 *			key are skipped
+		 * @param t_Scratch		Space for the passes to scatter into, resized to fit
+		 */
+		static void RadixSort(std::vector<DrawListItem>& t_Items, std::vector<DrawListItem>& t_Scratch);
+
+		/** Remove every draw, keeps the memory for the next frame */
+		void Clear();
+
+		void Add(UINT64 t_Key, const DrawCommand& t_Command);
+
+		void Sort();
+
+		/** Record every draw in key order and count the binds that it took */
+		void Record(CommandBuffer& t_CmdBuf);
+
+		inline UINT32 GetSize() const { return static_cast<UINT32>(m_Items.size()); }
+
+		/** Draws in the order that they will be recorded, after Sort */
+		inline const std::vector<DrawListItem>& GetItems() const { return m_Items; }
+
+		inline const DrawCommand& GetCommand(UINT32 t_Index) const { return m_Commands[t_Index]; }
+
+		/** Counters from the last Record */
+		inline const DrawListStats& GetStats() const { return m_Stats; }
+
+	private:
+
+		std::vector<DrawListItem> m_Items;
+		std::vector<DrawListItem> m_Scratch;
+		std::vector<DrawCommand> m_Commands;
+
+		DrawListStats m_Stats = {};
+	};
+}   // namespace Fling
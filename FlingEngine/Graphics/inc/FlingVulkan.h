@@ -33,7 +33,8 @@ namespace Fling
 
 	namespace VkConfig
 	{
-		static const int MAX_FRAMES_IN_FLIGHT = 2;
+		/** Most frames that can be in flight, the Vulkan config picks how many actually are */
+		static const int MAX_FRAMES_IN_FLIGHT = 3;
 	}
 
 }   // namespace Fling
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "FlingVulkan.h"
 #include "FlingTypes.h"
+#include "DeviceMemoryAllocator.h"
 #include <vector>
 #include <memory>
 
@@ -45,7 +46,7 @@ namespace Fling
 		inline VkImage GetImageHandle() const { return m_Image; }
 		inline VkImageView GetViewHandle() const { return m_ImageView; }
 		inline VkFormat GetFormat() const { return m_Format; }
-		inline VkDeviceMemory GetMemoryHandle() const { return m_Memory; }
+		inline VkDeviceMemory GetMemoryHandle() const { return m_Memory.Memory; }
 		inline VkSampleCountFlagBits GetSampleCount() const { return m_Samples; }
 		inline VkImageSubresourceRange GetSubresourceRange() const { return m_SubresourceRange; }
 		inline VkAttachmentDescription GetDescription() const { return m_Description; }
@@ -53,7 +54,7 @@ namespace Fling
 	private:
 
 		VkImage m_Image = VK_NULL_HANDLE;
-		VkDeviceMemory m_Memory = VK_NULL_HANDLE;
+		DeviceAllocation m_Memory = {};
 		VkImageView m_ImageView = VK_NULL_HANDLE;
 		VkFormat m_Format = {};
 		VkSampleCountFlagBits m_Samples{ VK_SAMPLE_COUNT_1_BIT };
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "FlingMath.h"
+#include "Bounds.h"
+
+namespace Fling
+{
+	/**
+	 * @brief	Six planes of a camera's view volume for culling. Plane normals point inward,
+	 *			so a point is inside if it is in front of all of them.
+	 */
+	class Frustum
+	{
+	public:
+
+		enum Plane : UINT32
+		{
+			Left,
+			Right,
+			Bottom,
+			Top,
+			Near,
+			Far,
+			Count
+		};
+
+		Frustum() = default;
+
+		/**
+		 * @brief	Extract the planes from a view projection matrix. Expects a 0 to 1 depth range,
+		 *			see GLM_FORCE_DEPTH_ZERO_TO_ONE in FlingMath.h
+		 */
+		explicit Frustum(const glm::mat4& t_ViewProj);
+
+		/** Normalized plane (xyz is the normal, w the distance) */
+		inline const glm::vec4& GetPlane(Plane t_Plane) const { return m_Planes[t_Plane]; }
+
+		/** True if any part of the sphere is inside of the frustum */
+		bool Intersects(const BoundingSphere& t_Sphere) const;
+
+		/** True if any part of the box is inside of the frustum */
+		bool Intersects(const BoundingBox& t_Box) const;
+
+		/**
+		 * @brief	Test spheres stored as separate arrays of components against the frustum, 4 or 8
+		 *			at a time depending on if the engine was built with SSE or AVX.
+		 *
+		 * @param t_OutVisible	Indices of the visible spheres are written here, must have room for t_Count
+		 * @return	Number of visible spheres
+		 */
+		UINT32 CullSpheres(
+			const float* t_X,
+			const float* t_Y,
+			const float* t_Z,
+			const float* t_Radius,
+			UINT32 t_Count,
+			UINT32* t_OutVisible) const;
+
+	private:
+
+		glm::vec4 m_Planes[Plane::Count] = {};
+	};
+}   // namespace Fling
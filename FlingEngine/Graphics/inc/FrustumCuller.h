@@ -0,0 +1,53 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "Frustum.h"
+
+#include <entt/entity/registry.hpp>
+#include <vector>
+
+namespace Fling
+{
+	class Camera;
+
+	/**
+	 * @brief	Culling stage that runs before any command recording. Tests the bounding sphere of
+	 *			every entity with a Transform and MeshRenderer against the camera and keeps a
+	 *			compact list of the ones that are visible for the subpasses to draw.
+	 *
+	 *			Uses the world matrices cached by the TransformSystem, so it has to run after
+	 *			the world has been updated.
+	 */
+	class FrustumCuller
+	{
+	public:
+
+		/** Cull against the view projection of the camera */
+		void Cull(entt::registry& t_Reg, const Camera& t_Camera);
+
+		void Cull(entt::registry& t_Reg, const Frustum& t_Frustum);
+
+		/** Entities that passed the last cull, in the order that the registry has them */
+		inline const std::vector<entt::entity>& GetVisibleEntities() const { return m_Visible; }
+
+		/** Number of meshes that were tested in the last cull */
+		inline UINT32 GetCandidateCount() const { return static_cast<UINT32>(m_Candidates.size()); }
+
+		inline const Frustum& GetFrustum() const { return m_Frustum; }
+
+	private:
+
+		Frustum m_Frustum;
+
+		std::vector<entt::entity> m_Candidates;
+
+		/** World space bounding spheres of the candidates, split up for SIMD */
+		std::vector<float> m_X;
+		std::vector<float> m_Y;
+		std::vector<float> m_Z;
+		std::vector<float> m_Radius;
+
+		std::vector<UINT32> m_VisibleIndices;
+		std::vector<entt::entity> m_Visible;
+	};
+}   // namespace Fling
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Subpass.h"
+#include "LightClusterGrid.h"
 
 #include "Lighting/DirectionalLight.hpp"
 #include "Lighting/PointLight.hpp"
@@ -28,19 +29,27 @@ namespace Fling
 		/** Dir Lights */
 		static const UINT32 MaxDirectionalLights = 8;
 
-		/** Point Lights */
-		static const UINT32 MaxPointLights = 128;
+		/** Point Lights, these are binned into clusters so only the ones near a pixel are shaded */
+		static const UINT32 MaxPointLights = 4096;
+
+		/** Lights past this in a single cluster are dropped */
+		static const UINT32 MaxLightsPerCluster = 128;
 	};
 
-	/** Uniform buffer for passing lights to our final screen pass */
+	/** 
+	* @brief	Uniform buffer for passing lights to our final screen pass. Point lights and the
+	*			clusters that they are binned into go in storage buffers
+	*/
 	struct LightingUbo
 	{
 		alignas(4) UINT32 DirLightCount = 0;
 		alignas(4) UINT32 PointLightCount = 0;
 
-		alignas(16) DirectionalLight DirLightBuffer[DeferredLightSettings::MaxDirectionalLights] = {};
+		/** The slice of a view depth is floor(log(Depth) * ClusterSliceScale + ClusterSliceBias) */
+		alignas(4) float ClusterSliceScale = 0.0f;
+		alignas(4) float ClusterSliceBias = 0.0f;
 
-		alignas(16) PointLight PointLightBuffer[DeferredLightSettings::MaxPointLights] = {};
+		alignas(16) DirectionalLight DirLightBuffer[DeferredLightSettings::MaxDirectionalLights] = {};
 	};
 
 	struct CameraInfoUbo
@@ -78,6 +87,10 @@ namespace Fling
 
 		void CreateDescriptorSets(VkDescriptorPool t_Pool, entt::registry& t_reg) override;
 
+		const char* GetName() const override { return "Deferred Lighting"; }
+
+		void DeclareResources(RenderGraph& t_Graph, UINT32 t_Pass) override;
+
 		/** 
 		* @param t_FrameBuffer	The swap chain frame buffer
 		*/
@@ -87,7 +100,8 @@ namespace Fling
 
 		void OnPointLightAdded(entt::entity t_Ent, entt::registry& t_Reg, PointLight& t_Light);
 
-		void UpdateLightingUBO(entt::registry& t_Reg, UINT32 t_ActiveFrame);
+		/** Copy the lights to this frame's buffers and bin the point lights into clusters */
+		void UpdateLightingBuffers(entt::registry& t_Reg, UINT32 t_ActiveFrame);
 
 		// Global render pass for frame buffer writes
 		std::shared_ptr<Model> m_QuadModel;
@@ -99,15 +113,23 @@ namespace Fling
 		/** The offscreen frame buffer that has the G Buffer attachments */
 		FrameBuffer* m_OffscreenFrameBuf = nullptr;
 
-		// Descriptor sets and Uniform buffers -- one per swap image
+		// Descriptor sets and Uniform buffers -- one per frame in flight
 		std::vector<VkDescriptorSet> m_DescriptorSets;
 		std::vector<Buffer*> m_LightingUboBuffers;
 		std::vector<Buffer*> m_CameraUboBuffers;
+		std::vector<Buffer*> m_PointLightBuffers;
+		std::vector<Buffer*> m_ClusterBuffers;
+		std::vector<Buffer*> m_LightIndexBuffers;
 
 		std::vector<Buffer*> m_QuadUboBuffer;
 
 		LightingUbo m_LightingUBO = {};
 
 		CameraInfoUbo m_CamInfoUBO = {};
+
+		LightClusterGrid m_LightClusters { DeferredLightSettings::MaxLightsPerCluster };
+
+		/** World space position and range of every point light for binning */
+		std::vector<glm::vec4> m_PointLightSpheres;
 	};
 }   // namespace Fling
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "FlingVulkan.h"
+
+#include <vector>
+
+namespace Fling
+{
+	class LogicalDevice;
+	class CommandBuffer;
+
+	/**
+	 * @brief	Measures how long the GPU spends on each frame with timestamp queries. The timestamps are
+	 *			written by two small command buffers that are submitted first and last in every frame, so
+	 *			subpasses that reuse their recorded command buffers don't have to know about them.
+	 *
+	 *			Results of a frame are read back after its fence has been waited on, which never stalls.
+	 */
+	class GpuFrameTimer
+	{
+	public:
+
+		/**
+		 * @param t_Pool		Pool that the timestamp command buffers are allocated from
+		 * @param t_FrameCount	Number of frames in flight
+		 */
+		GpuFrameTimer(const LogicalDevice* t_Device, VkCommandPool t_Pool, UINT32 t_FrameCount);
+
+		~GpuFrameTimer();
+
+		/** False if the graphics queue can't write timestamps, the command buffers are null then */
+		FORCEINLINE bool IsSupported() const { return m_QueryPool != VK_NULL_HANDLE; }
+
+		/** Submit before every other command buffer of the frame */
+		VkCommandBuffer GetBeginCommandBuffer(UINT32 t_Frame) const;
+
+		/** Submit after every other command buffer of the frame */
+		VkCommandBuffer GetEndCommandBuffer(UINT32 t_Frame) const;
+
+		/** Call when a frame's command buffers have been submitted, so that it's results are read next time */
+		void OnSubmitted(UINT32 t_Frame);
+
+		/**
+		 * @brief	Get how long the GPU took the last time this frame was drawn. Only call after waiting on the frame's fence.
+		 * @return	False if there is no result, because the frame hasn't been submitted yet or timestamps aren't supported
+		 */
+		bool ReadFrameTime(UINT32 t_Frame, float& t_OutMilliseconds);
+
+		/**
+		 * @brief	Convert two timestamps into milliseconds. Only the valid bits are compared, so a counter that
+		 *			wrapped around between them still gives the right time.
+		 * @param t_TimestampPeriod		Nanoseconds per tick, from the device limits
+		 */
+		static float TicksToMilliseconds(UINT64 t_Begin, UINT64 t_End, UINT32 t_ValidBits, float t_TimestampPeriod);
+
+	private:
+
+		const LogicalDevice* m_Device = nullptr;
+
+		/** Two queries per frame, the begin and end timestamps */
+		VkQueryPool m_QueryPool = VK_NULL_HANDLE;
+
+		/** Recorded once, they write to the same queries every time they are submitted */
+		std::vector<CommandBuffer*> m_BeginCmdBufs;
+		std::vector<CommandBuffer*> m_EndCmdBufs;
+
+		/** Frames that have been submitted since their results were last read */
+		std::vector<bool> m_Pending;
+
+		UINT32 m_ValidBits = 0;
+
+		float m_TimestampPeriod = 0.0f;
+	};
+}   // namespace Fling
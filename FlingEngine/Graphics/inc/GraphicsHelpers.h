@@ -30,7 +30,7 @@ namespace Fling
         */
         UINT32 FindMemoryType(VkPhysicalDevice t_PhysicalDevice, UINT32 t_Filter, VkMemoryPropertyFlags t_Props);
 
-        void CreateBuffer(VkDevice t_Device, VkPhysicalDevice t_PhysicalDevice, VkDeviceSize t_Size, VkBufferUsageFlags t_Usage, VkMemoryPropertyFlags t_Properties, VkBuffer& t_Buffer, VkDeviceMemory& t_BuffMemory);
+        void CreateBuffer(VkDevice t_Device, VkPhysicalDevice t_PhysicalDevice, VkDeviceSize t_Size, VkBufferUsageFlags t_Usage, VkMemoryPropertyFlags t_Properties, VkBuffer& t_Buffer, DeviceAllocation& t_BuffMemory);
 
         VkCommandBuffer BeginSingleTimeCommands();
         
@@ -45,7 +45,7 @@ namespace Fling
             VkImageUsageFlags t_Useage,
             VkMemoryPropertyFlags t_Props,
             VkImage& t_Image,
-            VkDeviceMemory& t_Memory,
+            DeviceAllocation& t_Memory,
 			VkSampleCountFlagBits t_NumSamples = VK_SAMPLE_COUNT_1_BIT
         );
 
@@ -64,7 +64,7 @@ namespace Fling
             VkMemoryPropertyFlags t_Props,
             VkImageCreateFlags t_flags,
             VkImage& t_Image,
-            VkDeviceMemory& t_Memory,
+            DeviceAllocation& t_Memory,
             VkSampleCountFlagBits t_NumSamples = VK_SAMPLE_COUNT_1_BIT
         );
 
@@ -104,14 +104,19 @@ namespace Fling
             VkCommandPoolCreateFlags t_flags
         );
 
+        /** Create a command pool for a queue family other than graphics */
+        void CreateCommandPool(
+            VkCommandPool* t_commandPool,
+            VkCommandPoolCreateFlags t_flags,
+            UINT32 t_QueueFamily
+        );
+
         void CreateCommandBuffers(
             VkCommandBuffer* t_commandBuffer,
             UINT32 t_commandBufferCount,
             VkCommandPool& t_commandPool
         );
 
-        void CreatePipelineCache(VkPipelineCache& t_PipelineCache);
-
         VkShaderModule CreateShaderModule(std::shared_ptr<File> t_ShaderCode);
 
         /**
@@ -129,6 +134,19 @@ namespace Fling
             UINT32 t_MipLevels = 1
         );
 
+        /**
+         * @brief    Record an image layout transition into the given command buffer instead of
+         *           submitting a single time command
+         */
+        void TransitionImageLayout(
+            VkCommandBuffer t_CommandBuffer,
+            VkImage t_Image, 
+            VkFormat t_Format, 
+            VkImageLayout t_oldLayout, 
+            VkImageLayout t_NewLayout,
+            UINT32 t_MipLevels = 1
+        );
+
         /**
          * @brief    Returns true if the given format has a stencil component 
          */
@@ -24,7 +24,9 @@ namespace Fling
             Depth t_Depth = Depth::ReadWrite,
             VkPrimitiveTopology t_Topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
             VkCullModeFlags t_CullMode = VK_CULL_MODE_BACK_BIT,
-            VkFrontFace t_FrontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE);
+            VkFrontFace t_FrontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+            UINT32 t_DynamicUniformMask = 0,
+            UINT32 t_RuntimeArraySize = 0);
 
         void BindGraphicsPipeline(const VkCommandBuffer& t_CommandBuffer);
         void CreateGraphicsPipeline(VkRenderPass& t_RenderPass, Multisampler* t_Sampler);
@@ -36,11 +38,24 @@ namespace Fling
         VkPolygonMode GetPolygonMode() const { return m_PolygonMode; }
         VkCullModeFlags GetCullMode() const { return m_CullMode; }
         VkFrontFace GetFrontFace() const { return m_FrontFace; }
-        const VkDescriptorSetLayout& GetDescriptorSetLayout() const { return m_DescriptorSetLayout; }
+        const VkDescriptorSetLayout& GetDescriptorSetLayout() const { return m_DescriptorSetLayouts[0]; }
+        const std::vector<VkDescriptorSetLayout>& GetDescriptorSetLayouts() const { return m_DescriptorSetLayouts; }
         const VkPipeline& GetPipeline() const { return m_Pipeline; }
         const VkPipelineLayout& GetPipelineLayout() const { return m_PipelineLayout; }
         const VkPipelineBindPoint& GetPipelineBindPoint() const { return m_PipelineBindPoint; }
 
+        /**
+         * @brief   Find a descriptor by the name it has in any of the shaders
+         * @return  nullptr if no stage declares it
+         */
+        const ShaderBinding* FindBinding(const std::string& t_Name) const;
+
+        /** Binding index of a descriptor that one of the shaders has to declare */
+        UINT32 GetBinding(const std::string& t_Name) const;
+
+        /** Every stage that can see the push constants, which is what they have to be pushed with */
+        VkShaderStageFlags GetPushConstantStages() const;
+
         ~GraphicsPipeline();
 
         void CreateAttributes(Multisampler* t_Sampler);
@@ -56,14 +71,18 @@ namespace Fling
         VkFrontFace m_FrontFace;
 
         VkPipeline m_Pipeline = VK_NULL_HANDLE;
-        VkPipelineCache m_PipelineCache = VK_NULL_HANDLE;
         VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
         VkPipelineBindPoint m_PipelineBindPoint;
 
 		VkGraphicsPipelineCreateInfo m_PipelineCreateInfo = {};
 
-        VkDescriptorSetLayout m_DescriptorSetLayout;
+        /** Layouts for every set the shaders use, owned by the layout cache */
+        std::vector<VkDescriptorSetLayout> m_DescriptorSetLayouts;
         VkPipelineVertexInputStateCreateInfo m_VertexInputStateCreateInfo = {};
+        /** If true the pipeline reads per instance data (see InstanceData) from vertex binding 1 */
+        bool m_Instanced = false;
+        /** Layout of the vertices on binding 0 */
+        VertexFormat m_VertexFormat = VertexFormat::Full;
         VkPipelineInputAssemblyStateCreateInfo m_InputAssemblyState = {};
         VkPipelineRasterizationStateCreateInfo m_RasterizationState = {};
         std::vector<VkPipelineColorBlendAttachmentState> m_ColorBlendAttachmentStates;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Subpass.h"
+#include "DeviceMemoryAllocator.h"
 
 namespace Fling
 {
@@ -30,10 +31,17 @@ namespace Fling
 
 		void CreateDescriptorSets(VkDescriptorPool t_Pool, entt::registry& t_reg) override;
 
+		const char* GetName() const override { return "ImGui"; }
+
+		void DeclareResources(RenderGraph& t_Graph, UINT32 t_Pass) override;
+
 		void PrepareAttachments() override;
 
 		void CreateGraphicsPipeline() override;
 
+		/** The font texture is uploaded with single time commands, which can't be recorded from a job */
+		bool CanCreatePipelineInParallel() const override { return false; }
+
 		void CleanUp(entt::registry& t_reg) override;
 
 	private:
@@ -42,9 +50,9 @@ namespace Fling
 
 		void PrepareResources();
 
-		void BuildCommandBuffer(VkCommandBuffer t_commandBuffer);
+		void BuildCommandBuffer(VkCommandBuffer t_commandBuffer, UINT32 t_ActiveFrameInFlight);
 
-		void UpdateUniforms();
+		void UpdateUniforms(UINT32 t_ActiveFrameInFlight);
 
 		struct PushConstBlock
 		{
@@ -52,12 +60,20 @@ namespace Fling
 			glm::vec2 translate;
 		} pushConstBlock;
 
-		std::unique_ptr<class Buffer> m_vertexBuffer;
-		std::unique_ptr<class Buffer> m_indexBuffer;
+		/** Vertex and index buffers of the UI geometry for one frame in flight */
+		struct FrameGeometry
+		{
+			std::unique_ptr<class Buffer> vertexBuffer;
+			std::unique_ptr<class Buffer> indexBuffer;
+			INT32 vertexCount = 0;
+			INT32 indexCount = 0;
+		};
+
+		/** The GPU could still be drawing the UI of other frames, so each one writes to it's own buffers */
+		std::vector<FrameGeometry> m_FrameGeometry;
 
 		VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
 		VkDescriptorSetLayout m_descriptorSetLayout = VK_NULL_HANDLE;
-		VkPipelineCache m_pipelineCache  = VK_NULL_HANDLE;
 		VkPipelineLayout m_pipelineLayout  = VK_NULL_HANDLE;
 		VkPipeline m_pipeLine = VK_NULL_HANDLE;
 
@@ -65,7 +81,7 @@ namespace Fling
 
 		FlingWindow* m_Window = nullptr;
 
-		VkDeviceMemory m_fontMemory = VK_NULL_HANDLE;
+		DeviceAllocation m_fontMemory = {};
 		VkImage m_fontImage = VK_NULL_HANDLE;
 		VkImageView m_fontImageView = VK_NULL_HANDLE;
 		VkSampler m_sampler = VK_NULL_HANDLE;
@@ -73,9 +89,6 @@ namespace Fling
 		/** Instance of the editor that we will get what commands to build from */
 		std::shared_ptr<Fling::BaseEditor> m_Editor;
 
-		INT32 m_vertexCount = 0;
-		INT32 m_indexCount = 0;
-
 		VkRenderPass m_GlobalRenderPass = VK_NULL_HANDLE;
 	};
 }   // namespace Fling
\ No newline at end of file
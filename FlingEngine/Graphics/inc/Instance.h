@@ -12,7 +12,11 @@ namespace Fling
     {
     public:
 
-        explicit Instance();
+        /**
+         * @param t_Presentable  If this instance needs the window system extensions to present to a surface.
+         *                       Headless instances can only render off screen
+         */
+        explicit Instance(bool t_Presentable = true);
 
         ~Instance();
 
@@ -37,6 +41,9 @@ namespace Fling
          */
         UINT8 m_EnableValidationLayers : 1;
 
+        /** If GLFW's surface extensions were requested */
+        UINT8 m_Presentable : 1;
+
         /**
          * @brief Create the VkInstance of this object and application information
          */
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "FlingMath.h"
+
+#include <vector>
+
+namespace Fling
+{
+	/** Where the lights of a cluster start in the light index list and how many there are. Matches a uvec2 in the shader */
+	struct LightCluster
+	{
+		UINT32 Offset = 0;
+		UINT32 Count = 0;
+	};
+
+	/**
+	 * @brief	Splits the view frustum into froxels, screen tiles that are sliced up exponentially
+	 *			along the view depth, and bins point lights into every froxel that their range touches.
+	 *			Lighting then only has to look at the lights in the cluster of each pixel instead of
+	 *			every light in the scene.
+	 *
+	 *			Tiles are laid out in NDC so that the grid doesn't depend on the resolution, the shader
+	 *			finds the cluster of a pixel with the same projection. @see deferred.frag
+	 */
+	class LightClusterGrid
+	{
+	public:
+
+		/** These have to match the defines in deferred.frag */
+		static constexpr UINT32 TilesX = 16;
+		static constexpr UINT32 TilesY = 9;
+		static constexpr UINT32 Slices = 24;
+		static constexpr UINT32 ClusterCount = TilesX * TilesY * Slices;
+
+		/** @param t_MaxLightsPerCluster	Lights past this in a single cluster are dropped */
+		explicit LightClusterGrid(UINT32 t_MaxLightsPerCluster = 128);
+
+		/**
+		 * @brief	Bin the lights for a frame. Lights are binned in parallel with the job system.
+		 * @param t_Lights		World space position of each light in xyz and it's range in w
+		 * @param t_Near		View depth that the first slice starts at
+		 * @param t_Far			View depth that the last slice ends at, lights past it are skipped
+		 */
+		void Build(const glm::mat4& t_View, const glm::mat4& t_Proj, float t_Near, float t_Far, const glm::vec4* t_Lights, UINT32 t_Count);
+
+		/** Slice that a view depth is in, depths outside of the near and far plane are clamped */
+		UINT32 GetSlice(float t_Depth) const;
+
+		/** Cluster of a view space position, the same way that the shader finds it */
+		UINT32 FindCluster(const glm::vec3& t_ViewPos) const;
+
+		static FORCEINLINE UINT32 GetClusterIndex(UINT32 t_X, UINT32 t_Y, UINT32 t_Slice) { return (t_Slice * TilesY + t_Y) * TilesX + t_X; }
+
+		/** One entry per cluster, index them with GetClusterIndex */
+		FORCEINLINE const std::vector<LightCluster>& GetClusters() const { return m_Clusters; }
+
+		/** Indices into the lights given to Build, each cluster's are in ascending order */
+		FORCEINLINE const std::vector<UINT32>& GetLightIndices() const { return m_LightIndices; }
+
+		FORCEINLINE UINT32 GetMaxLightsPerCluster() const { return m_MaxLightsPerCluster; }
+
+		/** The most light indices that a build can output */
+		FORCEINLINE UINT32 GetMaxLightIndices() const { return ClusterCount * m_MaxLightsPerCluster; }
+
+		/** How many times a light was dropped from a full cluster in the last build */
+		FORCEINLINE UINT32 GetOverflowCount() const { return m_OverflowCount; }
+
+		/** The slice of a view depth is floor(log(Depth) * Scale + Bias) */
+		FORCEINLINE float GetSliceScale() const { return m_SliceScale; }
+		FORCEINLINE float GetSliceBias() const { return m_SliceBias; }
+
+	private:
+
+		/** The part of the grid that a light can touch */
+		struct LightBounds
+		{
+			glm::vec3 ViewPos;
+			float Radius;
+			UINT32 MinSlice, MaxSlice;
+			UINT32 MinX, MaxX;
+			UINT32 MinY, MaxY;
+		};
+
+		/** Rebuild the view space boxes of the clusters if the projection has changed */
+		void UpdateClusterBounds(const glm::mat4& t_Proj, float t_Near, float t_Far);
+
+		/** Find the slices and tiles that the bounding box of a light covers */
+		bool CalculateLightBounds(const glm::vec4& t_ViewSphere, LightBounds& t_Out) const;
+
+		UINT32 m_MaxLightsPerCluster = 0;
+
+		glm::mat4 m_Proj = glm::mat4(0.0f);
+		float m_Near = 0.0f;
+		float m_Far = 0.0f;
+		float m_SliceScale = 0.0f;
+		float m_SliceBias = 0.0f;
+
+		/** View space bounding box of every cluster */
+		std::vector<glm::vec3> m_ClusterMin;
+		std::vector<glm::vec3> m_ClusterMax;
+
+		std::vector<LightBounds> m_LightBounds;
+		std::vector<UINT8> m_IsLightVisible;
+
+		/** Fixed size list for every cluster that the lights get binned into before they are packed */
+		std::vector<UINT32> m_BinnedIndices;
+		std::vector<UINT32> m_BinnedCounts;
+		std::vector<UINT32> m_SliceOverflow;
+
+		std::vector<LightCluster> m_Clusters;
+		std::vector<UINT32> m_LightIndices;
+		UINT32 m_OverflowCount = 0;
+	};
+}   // namespace Fling
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "FlingMath.h"
+#include "MeshSimplifier.h"
+
+#include <entt/entity/registry.hpp>
+#include <vector>
+
+namespace Fling
+{
+	class Camera;
+
+	/**
+	 * @brief	Picks the level of detail of every visible mesh from how big it is on screen, after
+	 *			culling and before the offscreen pass writes it's draws. The level is kept on the
+	 *			MeshRenderer so that meshes near a switch don't flicker between two levels.
+	 */
+	class LodSelector
+	{
+	public:
+
+		/**
+		 * @param t_MaxScreenError	How far a level may be from the full mesh on screen, as a fraction of
+		 *							the screen height
+		 * @param t_Hysteresis		Fraction of t_MaxScreenError that a mesh has to be under before it
+		 *							switches to a coarser level
+		 */
+		LodSelector(float t_MaxScreenError = 0.002f, float t_Hysteresis = 0.25f);
+
+		/**
+		 * @brief	The coarsest level whose error fits on screen. Switching to a coarser level than the
+		 *			current one needs the error to be under the hysteresis band, so a mesh that sits right
+		 *			on the edge keeps it's level
+		 * @param t_ScreenSize		Radius of the bounding sphere over the distance, scaled by the focal length
+		 * @param t_Radius			Radius of the bounding sphere in the same space as the errors of the levels
+		 */
+		static UINT32 SelectLod(
+			const MeshLod* t_Lods,
+			UINT32 t_LodCount,
+			float t_ScreenSize,
+			float t_Radius,
+			UINT32 t_CurrentLod,
+			float t_MaxScreenError,
+			float t_Hysteresis);
+
+		/** Select with the view projection of the camera */
+		void Select(entt::registry& t_Reg, const Camera& t_Camera, const std::vector<entt::entity>& t_Visible);
+
+		/** @param t_Visible	Entities with a Transform and MeshRenderer that passed culling */
+		void Select(entt::registry& t_Reg, const glm::mat4& t_ViewProj, const std::vector<entt::entity>& t_Visible);
+
+		/** Triangles that the visible meshes draw with the levels that were picked */
+		inline UINT64 GetTriangleCount() const { return m_TriangleCount; }
+
+		/** Triangles that the visible meshes would draw if every one of them used the full mesh */
+		inline UINT64 GetFullTriangleCount() const { return m_FullTriangleCount; }
+
+		/** Visible meshes that were drawn with each level of detail */
+		inline UINT32 GetMeshCountAtLod(UINT32 t_Lod) const { return m_MeshCountAtLod[t_Lod]; }
+
+		/** When disabled every mesh is drawn with the full mesh */
+		inline void SetEnabled(bool t_Enabled) { m_IsEnabled = t_Enabled; }
+		inline bool IsEnabled() const { return m_IsEnabled; }
+
+		inline void SetMaxScreenError(float t_Error) { m_MaxScreenError = t_Error; }
+		inline float GetMaxScreenError() const { return m_MaxScreenError; }
+
+	private:
+
+		float m_MaxScreenError = 0.0f;
+		float m_Hysteresis = 0.0f;
+		bool m_IsEnabled = true;
+
+		UINT64 m_TriangleCount = 0;
+		UINT64 m_FullTriangleCount = 0;
+		UINT32 m_MeshCountAtLod[MaxMeshLods] = {};
+	};
+}   // namespace Fling
@@ -2,6 +2,8 @@
 
 #include "FlingVulkan.h"
 
+#include <vector>
+
 namespace Fling
 {
 	class PhysicalDevice;
@@ -14,6 +16,7 @@ namespace Fling
     {
     public:
 
+        /** @param t_Surface  Surface the present queue has to support, VK_NULL_HANDLE for a headless device that never presents */
         explicit LogicalDevice(class Instance* t_Instance, class PhysicalDevice* t_PhysDevice, const VkSurfaceKHR t_Surface);
 
         ~LogicalDevice();
@@ -23,6 +26,9 @@ namespace Fling
 		const VkQueue& GetGraphicsQueue() const { return m_GraphicsQueue; }
 		const VkQueue& GetPresentQueue() const { return m_PresentQueue; }
 
+		/** Queue that uploads are copied on. The same as the graphics queue if there is no dedicated transfer family */
+		const VkQueue& GetTransferQueue() const { return m_TransferQueue; }
+
 		const VkQueueFlags& GetSupportedQueues() const { return m_SupportedQueues; }
 
 		const PhysicalDevice* GetPhysicalDevice() const { return m_PhysicalDevice; }
@@ -30,9 +36,20 @@ namespace Fling
 
 		UINT32 GetGraphicsFamily() const { return m_GraphicsFamily; }
 		UINT32 GetPresentFamily() const { return m_PresentFamily; }
+		UINT32 GetTransferFamily() const { return m_TransferFamily; }
+
+		/** True if copies run on a different queue family, resources have to change owners before graphics can use them */
+		bool HasTransferQueue() const { return m_TransferFamily != m_GraphicsFamily; }
 
 		void WaitForIdle();
 
+		/**
+		 * @brief	Pick the queue family that uploads should be copied on. Families that can only copy are
+		 *			usually DMA engines that run next to graphics work, then any other non graphics family.
+		 * @return	t_GraphicsFamily if no other family can copy
+		 */
+		static UINT32 FindTransferFamily(const std::vector<VkQueueFamilyProperties>& t_Families, UINT32 t_GraphicsFamily);
+
 
     private:
 
@@ -49,6 +66,9 @@ namespace Fling
         /** Handle to the presentation queue */
         VkQueue m_PresentQueue = VK_NULL_HANDLE;
 
+        /** Handle to the queue that uploads are copied on */
+        VkQueue m_TransferQueue = VK_NULL_HANDLE;
+
 		/** Queue families */
 		VkQueueFlags m_SupportedQueues{};
 		UINT32 m_GraphicsFamily = 0;
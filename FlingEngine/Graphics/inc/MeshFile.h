@@ -0,0 +1,128 @@
+#pragma once
+
+#include "Vertex.h"
+#include "Bounds.h"
+#include "MappedFile.h"
+#include "MeshSimplifier.h"
+
+#include <string>
+#include <vector>
+
+namespace Fling
+{
+	/**
+	 * @brief	Header at the start of a cooked .flmesh file. The vertex and index data follow it
+	 *			exactly as they are uploaded to the GPU.
+	 */
+	struct MeshFileHeader
+	{
+		UINT32 Magic = 0;
+		UINT32 Version = 0;
+
+		/** Size of a vertex when the file was cooked, files with a different vertex layout are stale */
+		UINT32 VertexStride = 0;
+
+		/** VertexFormat of the vertex data */
+		UINT32 VertexFormat = 0;
+
+		/** Number of entries in Lods that are used */
+		UINT32 LodCount = 0;
+
+		UINT32 VertexCount = 0;
+		UINT32 IndexCount = 0;
+
+		/** 2 if every index fits in 16 bits, otherwise 4 */
+		UINT32 IndexSize = 0;
+
+		/** Byte offsets of the data from the start of the file */
+		UINT64 VertexOffset = 0;
+		UINT64 IndexOffset = 0;
+
+		float BoundsMin[3] = {};
+		float BoundsMax[3] = {};
+
+		/** Index ranges of every level of detail, the first one is the full mesh */
+		MeshLod Lods[MaxMeshLods] = {};
+	};
+
+	static_assert(sizeof(MeshFileHeader) == 120, "The mesh file header is written to disk, keep it the same size");
+
+	/**
+	 * @brief	A cooked mesh file that is mapped into memory. The vertices and indices can be
+	 *			copied straight into a staging buffer without any parsing.
+	 * @see		MeshImporter::Cook
+	 */
+	class MeshFile : public NonCopyable
+	{
+	public:
+
+		/** "FLMS" */
+		static constexpr UINT32 Magic = 0x534D4C46;
+
+		/** Bump this whenever the layout of the file or the vertex format changes */
+		static constexpr UINT32 Version = 5;
+
+		static constexpr const char* Extension = ".flmesh";
+
+		/** Data is aligned to this in the file so that the mapped vertices can be read in place */
+		static constexpr UINT64 DataAlignment = 16;
+
+		/**
+		 * @brief	Write a cooked mesh file, with 16 bit indices if they fit
+		 * @param t_Format	Packed vertices are quantized to the bounds, see VertexQuantization
+		 * @param t_Lods	Index ranges of each level of detail, empty if every index is the full mesh
+		 * @return	True if the whole file was written
+		 */
+		static bool Write(
+			const std::string& t_FilePath,
+			const std::vector<Vertex>& t_Verts,
+			const std::vector<UINT32>& t_Indices,
+			const BoundingBox& t_Bounds,
+			VertexFormat t_Format = VertexFormat::Full,
+			const std::vector<MeshLod>& t_Lods = {});
+
+		/** Path of the cooked file for a source model, which sits next to it with the .flmesh extension */
+		static std::string GetCookedPath(const std::string& t_SourcePath);
+
+		/** True if the cooked file exists and is at least as new as the source model */
+		static bool IsUpToDate(const std::string& t_SourcePath, const std::string& t_CookedPath);
+
+		MeshFile() = default;
+		~MeshFile() = default;
+
+		/**
+		 * @brief	Map a cooked mesh file and check that it can be used by this build
+		 * @return	False if the file is missing, has an old version or is truncated
+		 */
+		bool Open(const std::string& t_FilePath);
+
+		void Close();
+
+		FORCEINLINE bool IsOpen() const { return m_Header != nullptr; }
+
+		FORCEINLINE UINT32 GetVertexCount() const { return m_Header->VertexCount; }
+		FORCEINLINE UINT32 GetIndexCount() const { return m_Header->IndexCount; }
+
+		FORCEINLINE VertexFormat GetVertexFormat() const { return static_cast<VertexFormat>(m_Header->VertexFormat); }
+
+		/** Vertices that are GetVertexStride(GetVertexFormat()) bytes each */
+		FORCEINLINE const void* GetVertexData() const { return m_File.GetData() + m_Header->VertexOffset; }
+
+		FORCEINLINE const Vertex* GetVertices() const { assert(GetVertexFormat() == VertexFormat::Full); return reinterpret_cast<const Vertex*>(GetVertexData()); }
+
+		/** Indices that are GetIndexSize bytes each */
+		FORCEINLINE const void* GetIndexData() const { return m_File.GetData() + m_Header->IndexOffset; }
+		FORCEINLINE UINT32 GetIndexSize() const { return m_Header->IndexSize; }
+
+		FORCEINLINE UINT32 GetLodCount() const { return m_Header->LodCount; }
+		FORCEINLINE const MeshLod& GetLod(UINT32 t_Lod) const { assert(t_Lod < GetLodCount()); return m_Header->Lods[t_Lod]; }
+
+		BoundingBox GetBounds() const;
+
+	private:
+
+		MappedFile m_File;
+
+		const MeshFileHeader* m_Header = nullptr;
+	};
+}   // namespace Fling
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Vertex.h"
+#include "Bounds.h"
+#include "MeshOptimizer.h"
+
+#include <string>
+#include <vector>
+
+namespace Fling
+{
+	/**
+	 * @brief	Turns source models into the vertices and indices that the renderer uses. Used by
+	 *			the mesh cooker ahead of time and by models that don't have a cooked file yet.
+	 *			None of this touches Vulkan, so it is safe to call from any thread.
+	 */
+	namespace MeshImporter
+	{
+		/** Where the normals of an imported mesh come from */
+		enum class NormalMode : UINT8
+		{
+			/** Use the normals in the file, vertices that don't have one get a smooth normal */
+			FromFile,
+
+			/** Ignore the normals in the file and smooth every vertex */
+			Smooth,
+		};
+
+		/**
+		 * @brief	Parse a text OBJ file. Vertices without a normal are left with a zero normal
+		 * @return	False if the file could not be loaded or has no triangles
+		 */
+		bool LoadObj(const std::string& t_FilePath, std::vector<Vertex>& t_OutVerts, std::vector<UINT32>& t_OutIndices);
+
+		/**
+		 * @brief	Give every vertex with a zero normal the angle weighted average of the faces around
+		 *			its position. Vertices that already have a normal are left alone
+		 */
+		void CalculateSmoothNormals(Vertex* t_Verts, UINT32 t_NumVerts, const UINT32* t_Indices, UINT32 t_NumIndices);
+
+		/**
+		 * @brief	Calculate MikkTSpace style tangents: the U direction of each triangle corner is made
+		 *			orthogonal to the vertex normal and weighted by the corner angle. Runs on the job
+		 *			system when called from a job thread and gives the same result on any number of threads
+		 */
+		void CalculateVertexTangents(Vertex* t_Verts, UINT32 t_NumVerts, const UINT32* t_Indices, UINT32 t_NumIndices);
+
+		BoundingBox CalculateBounds(const std::vector<Vertex>& t_Verts);
+
+		/**
+		 * @brief	Load a source model and run it through the whole import pipeline: weld identical
+		 *			vertices, reorder for the vertex cache and vertex fetch and calculate normals and tangents
+		 * @see		MeshOptimizer::Optimize
+		 */
+		bool Import(const std::string& t_FilePath, std::vector<Vertex>& t_OutVerts, std::vector<UINT32>& t_OutIndices, MeshOptimizeStats* t_OutStats = nullptr, NormalMode t_Normals = NormalMode::FromFile);
+
+		/**
+		 * @brief	Import a source model and write it out as a cooked .flmesh file, with packed
+		 *			vertices if the model doesn't use vertex colors and simplified levels of detail
+		 * @see		MeshFile
+		 */
+		bool Cook(const std::string& t_SourcePath, const std::string& t_CookedPath, NormalMode t_Normals = NormalMode::FromFile);
+
+	}   // namespace MeshImporter
+}   // namespace Fling
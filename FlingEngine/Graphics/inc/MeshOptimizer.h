@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Vertex.h"
+
+#include <vector>
+
+namespace Fling
+{
+	/** What the import pipeline did to a mesh */
+	struct MeshOptimizeStats
+	{
+		/** One vertex per index, as it comes out of the obj */
+		UINT32 SourceVertexCount = 0;
+
+		/** Vertices left after welding identical ones */
+		UINT32 VertexCount = 0;
+
+		UINT32 IndexCount = 0;
+
+		/** Average cache miss ratio (vertex shader runs per triangle) of the welded mesh, before and after reordering */
+		float ACMRBefore = 0.0f;
+		float ACMRAfter = 0.0f;
+	};
+
+	/**
+	 * @brief	Offline optimizations for indexed triangle lists that cut down on vertex shader
+	 *			runs and vertex fetch cache misses on the GPU.
+	 */
+	namespace MeshOptimizer
+	{
+		/** Size of the post transform cache that we optimize for and measure with */
+		static constexpr UINT32 DefaultCacheSize = 16;
+
+		/**
+		 * @brief	Merge vertices that are exactly the same and remap the indices to them
+		 * @return	Number of vertices left
+		 */
+		UINT32 WeldVertices(std::vector<Vertex>& t_Verts, std::vector<UINT32>& t_Indices);
+
+		/**
+		 * @brief	Reorder triangles so that vertices are reused while they are still in the post
+		 *			transform cache, using Tipsify (Sander et al. 2007)
+		 */
+		void OptimizeVertexCache(UINT32* t_Indices, UINT32 t_IndexCount, UINT32 t_VertexCount, UINT32 t_CacheSize = DefaultCacheSize);
+
+		/**
+		 * @brief	Reorder vertices into the order that the indices first use them, so that vertex
+		 *			fetches walk through memory. Vertices that aren't used are dropped.
+		 * @return	Number of vertices left
+		 */
+		UINT32 OptimizeVertexFetch(std::vector<Vertex>& t_Verts, std::vector<UINT32>& t_Indices);
+
+		/** Average cache miss ratio of the indices with a FIFO cache, 3 is the worst and 0.5 is about the best */
+		float CalculateACMR(const UINT32* t_Indices, UINT32 t_IndexCount, UINT32 t_VertexCount, UINT32 t_CacheSize = DefaultCacheSize);
+
+		/** True if every index fits in a 16 bit index buffer */
+		FORCEINLINE bool CanUse16BitIndices(UINT32 t_VertexCount) { return t_VertexCount <= 0x10000; }
+
+		/** Weld, then reorder for the vertex cache and vertex fetch */
+		void Optimize(std::vector<Vertex>& t_Verts, std::vector<UINT32>& t_Indices, MeshOptimizeStats* t_OutStats = nullptr);
+
+	}   // namespace MeshOptimizer
+}   // namespace Fling
@@ -29,11 +29,24 @@ namespace Fling
         /** Pointer to the material that this mesh renderer uses */
         Material* m_Material = nullptr;
 
-        /** We need a uniform buffer per-swap chain image */
-        Buffer* m_UniformBuffer = nullptr;
-
+        /** 
+         * Descriptor set that this mesh is drawn with. It is shared by every mesh with the same material
+         * and owned by the subpass that draws it, per object uniforms are bound with a dynamic offset
+         */
         VkDescriptorSet m_DescriptorSet  = VK_NULL_HANDLE;
 
+        /** Index of the instanced draw that the offscreen pass draws this mesh with, UINT32_MAX if it isn't drawn */
+        UINT32 m_BatchIndex = UINT32_MAX;
+
+        /** Level of detail of the model that this mesh was last drawn with. @see LodSelector */
+        UINT8 m_LodIndex = 0;
+
+        /** 
+         * Always rasterize this mesh into the occlusion buffer to hide what is behind it, meshes that are big on 
+         * screen are picked as occluders anyway. Only flag solid meshes like walls and floors. @see OcclusionCuller
+         */
+        bool m_IsOccluder = false;
+
         void Release();
 
         bool operator==(const MeshRenderer& other) const;
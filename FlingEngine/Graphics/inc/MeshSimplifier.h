@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Vertex.h"
+
+#include <vector>
+
+namespace Fling
+{
+	/** Most levels of detail that a model can have, including the full mesh */
+	static constexpr UINT32 MaxMeshLods = 4;
+
+	/** A range of a model's index buffer that draws one level of detail. Every level shares the vertex buffer */
+	struct MeshLod
+	{
+		UINT32 FirstIndex = 0;
+		UINT32 IndexCount = 0;
+
+		/** No vertex of the full mesh is further than this from the triangles of this level, in model space */
+		float Error = 0.0f;
+	};
+
+	/**
+	 * @brief	Builds simplified versions of a mesh for drawing it when it is small on screen. Edges
+	 *			are collapsed in order of their quadric error (Garland and Heckbert 1997) onto one of
+	 *			their vertices, so every level uses the vertices of the full mesh. Vertices on an open
+	 *			border or on an attribute seam never move, which keeps the UVs and hard edges intact.
+	 */
+	namespace MeshSimplifier
+	{
+		/**
+		 * @brief	Collapse edges until there are at most t_TargetIndexCount indices left or the quadric
+		 *			error of the next collapse is over t_MaxError
+		 * @param t_OutIndices	Triangles of the simplified mesh, indexing the same vertices
+		 * @return	Error of the simplified mesh, which no vertex of the source mesh is further than from the
+		 *			simplified triangles. In the same units as the vertex positions
+		 */
+		float Simplify(
+			const Vertex* t_Verts,
+			UINT32 t_NumVerts,
+			const UINT32* t_Indices,
+			UINT32 t_NumIndices,
+			UINT32 t_TargetIndexCount,
+			float t_MaxError,
+			std::vector<UINT32>& t_OutIndices);
+
+		/**
+		 * @brief	Simplify a mesh to half of the triangles for each level and add the levels to the end
+		 *			of the indices. Stops early once a level can't remove enough triangles to be worth it
+		 * @param t_OutLods		Index ranges of every level, the first one is the full mesh
+		 * @return	Number of levels
+		 */
+		UINT32 GenerateLods(const std::vector<Vertex>& t_Verts, std::vector<UINT32>& t_Indices, std::vector<MeshLod>& t_OutLods, UINT32 t_MaxLods = MaxMeshLods);
+
+	}   // namespace MeshSimplifier
+}   // namespace Fling
@@ -4,9 +4,14 @@
 
 #include "Buffer.h"
 #include "Vertex.h"
+#include "Bounds.h"
+#include "VertexQuantization.h"
+#include "MeshSimplifier.h"
 
 namespace Fling
 {
+	class MeshFile;
+
 	/**
 	 * @brief 	A model represents a 3D model (.obj files for now) with vertices
 	 * 			and indecies. A model has a vertex and index buffer and can be 
@@ -18,6 +23,9 @@ namespace Fling
 
 		static std::shared_ptr<Fling::Model> Create(Guid t_ID);
 
+		/** Start loading a model in the background. It will have no buffers until it is ready */
+		static std::shared_ptr<Fling::Model> CreateAsync(Guid t_ID);
+
 		/** Creates a quad primitive model */
 		static std::shared_ptr<Fling::Model> Quad();
 
@@ -27,6 +35,9 @@ namespace Fling
 		 */
 		Model(Guid t_ID);
 
+		/** Construct a model that will be loaded by the ResourceManager's loading threads */
+		Model(Guid t_ID, AsyncLoadTag);
+
 		/**
 		 * @param	t_ID The GUID that represents a unique name for this model. It's up to the user to ensure uniqueness
 		 */
@@ -37,30 +48,80 @@ namespace Fling
 		FORCEINLINE Buffer* GetVertexBuffer() const { return m_VertexBuffer; }
 		FORCEINLINE Buffer* GetIndexBuffer() const { return m_IndexBuffer; }
 
+		/** CPU copy of the vertices. Empty if the model was loaded from a cooked file, which goes straight to the GPU */
 		FORCEINLINE const std::vector<Vertex>& GetVerts() const { return m_Verts; }
+
+		/** CPU copy of the indices of every level of detail, always kept so that the model can be rasterized as an occluder */
 		FORCEINLINE const std::vector<UINT32>& GetIndices() const { return m_Indices; }
 
-		FORCEINLINE UINT32 GetIndexCount() const { return static_cast<UINT32>(m_Indices.size()); }
-		FORCEINLINE UINT32 GetVertexCount() const { return static_cast<UINT32>(m_Verts.size()); }
+		/** Model space position of every vertex for rasterizing this model as an occluder. @see OcclusionCuller */
+		FORCEINLINE const std::vector<glm::vec3>& GetOccluderPositions() const { return m_OccluderPositions; }
+
+		/** Number of indices in the index buffer, including every level of detail */
+		FORCEINLINE UINT32 GetIndexCount() const { return m_IndexCount; }
+		FORCEINLINE UINT32 GetVertexCount() const { return m_VertexCount; }
+
+		/** Levels of detail in the index buffer, level 0 is the full mesh and every level after it has about half the triangles */
+		FORCEINLINE UINT32 GetLodCount() const { return static_cast<UINT32>(m_Lods.size()); }
+		FORCEINLINE const MeshLod& GetLod(UINT32 t_Lod) const { assert(t_Lod < m_Lods.size()); return m_Lods[t_Lod]; }
+		FORCEINLINE const std::vector<MeshLod>& GetLods() const { return m_Lods; }
+
+		/** Layout of the vertex buffer. Cooked models without vertex colors are packed */
+		FORCEINLINE VertexFormat GetVertexFormat() const { return m_VertexFormat; }
+
+		/** Push constants that unpack the positions of a packed vertex buffer */
+		FORCEINLINE VertexDequantize GetDequantize() const { return VertexQuantization::GetDequantize(m_Bounds); }
+
+		/** 16 bit if every index fits, which halves the size of the index buffer */
+		FORCEINLINE VkIndexType GetIndexType() const { return m_IndexType; }
+
+		/** Bounds of the vertices in model space, calculated when the model is loaded */
+		FORCEINLINE const BoundingBox& GetBounds() const { return m_Bounds; }
+		FORCEINLINE const BoundingSphere& GetBoundingSphere() const { return m_BoundingSphere; }
+
+	protected:
 
-		constexpr static VkIndexType GetIndexType() { return VK_INDEX_TYPE_UINT32; }
+		/**
+		 * @brief	Map the cooked .flmesh file of this model if it is up to date, otherwise parse
+		 *			the obj file and calculate tangents
+		 */
+		virtual bool LoadFromDisk() override;
+
+		virtual bool RequiresUpload() const override { return true; }
+
+		/** Create the vertex and index buffers and record the copies from staging memory */
+		virtual void RecordUpload(UploadBatch& t_Batch) override;
 
 	private:
 
+		/** Create the vertex and index buffers and block until they are uploaded */
 		void CreateBuffers();
 
-		static void CalculateVertexTangents(Vertex* verts, UINT32 numVerts, UINT32* indices, UINT32 numIndices);
+		void CalculateBounds();
+
+		/** Keep the positions and indices of a cooked file around for occlusion culling */
+		void CopyOccluderMesh(const MeshFile& t_File);
 
 		std::vector<Vertex> m_Verts;
 		std::vector<UINT32> m_Indices;
+		std::vector<glm::vec3> m_OccluderPositions;
+		std::vector<MeshLod> m_Lods;
+
+		/** Mapped cooked file that the buffers are uploaded from, closed once the staging copies are made */
+		std::unique_ptr<MeshFile> m_MeshFile;
+
+		UINT32 m_VertexCount = 0;
+		UINT32 m_IndexCount = 0;
+
+		VkIndexType m_IndexType = VK_INDEX_TYPE_UINT32;
+
+		VertexFormat m_VertexFormat = VertexFormat::Full;
 
 		Buffer* m_VertexBuffer = nullptr;
 		Buffer* m_IndexBuffer = nullptr;
 
-		/**
-		 * @brief	Load this model from Tiny Obj loader
-		 */
-		void LoadModel();
+		BoundingBox m_Bounds = {};
+		BoundingSphere m_BoundingSphere = {};
 
     };
 }   // namespace Fling
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "FlingVulkan.h"
 #include "Platform.h"       // for FORCEINLINE
+#include "DeviceMemoryAllocator.h"
 
 namespace Fling
 {
@@ -40,7 +41,7 @@ namespace Fling
 
     private:
         VkImage m_ColorImage = VK_NULL_HANDLE;
-        VkDeviceMemory m_ColorImageMemory = VK_NULL_HANDLE;
+        DeviceAllocation m_ColorImageMemory = {};
         VkImageView m_ColorImageView = VK_NULL_HANDLE;
 
 		/** The max sample count allowed on this device. Calculated in PhysicalDevice ctor */
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "FlingMath.h"
+#include "Bounds.h"
+
+#include <vector>
+
+namespace Fling
+{
+	/** An occluder triangle in screen space, set up for rasterizing */
+	struct OccluderTriangle
+	{
+		/** Pixels that the triangle can cover, max is exclusive */
+		INT32 MinX, MinY, MaxX, MaxY;
+
+		/** Edge functions, a pixel center is inside if A * x + B * y + C >= 0 for all three */
+		float EdgeA[3];
+		float EdgeB[3];
+		float EdgeC[3];
+
+		/** Depth plane, Depth = DepthA * x + DepthB * y + DepthC */
+		float DepthA, DepthB, DepthC;
+
+		/** Closest depth of the corners, the plane is clamped to it outside of the triangle */
+		float MinDepth;
+	};
+
+	/**
+	 * @brief	Low resolution depth buffer that occluders are rasterized into on the CPU. Pixels are
+	 *			split into tiles that are rasterized in parallel with the job system, 4 pixels at a
+	 *			time with SSE. Every tile keeps the furthest depth in it so that bounding boxes can
+	 *			skip whole tiles that are covered.
+	 *
+	 *			Depth is 0 at the near plane and 1 at the far plane, like the GPU. Rows go top to
+	 *			bottom so the buffer can be shown as an image.
+	 */
+	class OcclusionBuffer
+	{
+	public:
+
+		static constexpr UINT32 TileWidth = 32;
+		static constexpr UINT32 TileHeight = 8;
+
+		/** The size is rounded up to a whole number of tiles */
+		OcclusionBuffer(UINT32 t_Width, UINT32 t_Height);
+
+		/**
+		 * @brief	Clip the triangles of a mesh to the near plane and set them up for rasterizing.
+		 *			Only reads the buffer size, so occluders can be set up in parallel.
+		 * @param t_Out		The triangles are added to the end of this
+		 */
+		void SetupTriangles(
+			const glm::mat4& t_WorldViewProj,
+			const glm::vec3* t_Positions,
+			const UINT32* t_Indices,
+			UINT32 t_IndexCount,
+			std::vector<OccluderTriangle>& t_Out) const;
+
+		/** Clear the buffer to the far plane and rasterize every list of triangles into it */
+		void Rasterize(const std::vector<OccluderTriangle>* t_Lists, UINT32 t_ListCount);
+
+		/** True if any part of the box could be in front of the occluders. Boxes that cross the near plane are always visible */
+		bool IsVisible(const glm::mat4& t_WorldViewProj, const BoundingBox& t_Box) const;
+
+		/** True if any pixel in the rectangle is at or behind the depth. The max corner is exclusive */
+		bool IsRectVisible(UINT32 t_MinX, UINT32 t_MinY, UINT32 t_MaxX, UINT32 t_MaxY, float t_Depth) const;
+
+		FORCEINLINE UINT32 GetWidth() const { return m_Width; }
+		FORCEINLINE UINT32 GetHeight() const { return m_Height; }
+		FORCEINLINE UINT32 GetTilesX() const { return m_TilesX; }
+		FORCEINLINE UINT32 GetTilesY() const { return m_TilesY; }
+
+		FORCEINLINE float GetDepth(UINT32 t_X, UINT32 t_Y) const { return m_Depth[t_Y * m_Width + t_X]; }
+
+		/** Furthest depth of any pixel in the tile */
+		FORCEINLINE float GetTileMaxDepth(UINT32 t_TileX, UINT32 t_TileY) const { return m_TileMaxDepth[t_TileY * m_TilesX + t_TileX]; }
+
+		/** Every pixel, row by row */
+		FORCEINLINE const std::vector<float>& GetDepthData() const { return m_Depth; }
+
+	private:
+
+		void AddTriangle(const glm::vec4& t_A, const glm::vec4& t_B, const glm::vec4& t_C, std::vector<OccluderTriangle>& t_Out) const;
+
+		void RasterizeTile(UINT32 t_Tile);
+
+		UINT32 m_Width = 0;
+		UINT32 m_Height = 0;
+		UINT32 m_TilesX = 0;
+		UINT32 m_TilesY = 0;
+
+		std::vector<float> m_Depth;
+		std::vector<float> m_TileMaxDepth;
+
+		/** Triangles that overlap each tile */
+		std::vector<std::vector<const OccluderTriangle*>> m_TileBins;
+	};
+}   // namespace Fling
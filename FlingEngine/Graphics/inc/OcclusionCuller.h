@@ -0,0 +1,74 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "OcclusionBuffer.h"
+
+#include <entt/entity/registry.hpp>
+#include <vector>
+
+namespace Fling
+{
+	class Camera;
+
+	/**
+	 * @brief	Culling stage that runs after the frustum culler. Rasterizes the biggest meshes on
+	 *			screen, and any MeshRenderer flagged as an occluder, into a small depth buffer on
+	 *			the CPU and drops every mesh whose bounding box is entirely behind them.
+	 *
+	 *			The visible list keeps the order of the candidates, so with nothing in the way it is
+	 *			the same as the frustum culler's.
+	 */
+	class OcclusionCuller
+	{
+	public:
+
+		/**
+		 * @param t_Width				Width of the depth buffer in pixels
+		 * @param t_Height				Height of the depth buffer in pixels
+		 * @param t_MaxOccluders		Most meshes that are rasterized each frame
+		 * @param t_MinOccluderSize		Screen size that a mesh's bounding sphere needs to be picked as an
+		 *								occluder, as a fraction of the screen height
+		 */
+		OcclusionCuller(UINT32 t_Width = 256, UINT32 t_Height = 144, UINT32 t_MaxOccluders = 32, float t_MinOccluderSize = 0.2f);
+
+		/** Cull against the view projection of the camera */
+		void Cull(entt::registry& t_Reg, const Camera& t_Camera, const std::vector<entt::entity>& t_Candidates);
+
+		/** @param t_Candidates		Entities with a Transform and MeshRenderer that passed frustum culling */
+		void Cull(entt::registry& t_Reg, const glm::mat4& t_ViewProj, const std::vector<entt::entity>& t_Candidates);
+
+		/** Entities that passed the last cull, in the order of the candidates */
+		inline const std::vector<entt::entity>& GetVisibleEntities() const { return m_Visible; }
+
+		/** Depth buffer of the last cull, for debugging */
+		inline const OcclusionBuffer& GetBuffer() const { return m_Buffer; }
+
+		inline UINT32 GetOccluderCount() const { return static_cast<UINT32>(m_Occluders.size()); }
+
+		/** Number of candidates that were behind the occluders */
+		inline UINT32 GetOccludedCount() const { return m_OccludedCount; }
+
+		/** When disabled every candidate is visible and nothing is rasterized */
+		inline void SetEnabled(bool t_Enabled) { m_IsEnabled = t_Enabled; }
+		inline bool IsEnabled() const { return m_IsEnabled; }
+
+	private:
+
+		OcclusionBuffer m_Buffer;
+
+		UINT32 m_MaxOccluders = 0;
+		float m_MinOccluderSize = 0.0f;
+		bool m_IsEnabled = true;
+
+		/** Candidates that are rasterized this frame, biggest first */
+		std::vector<UINT32> m_Occluders;
+		std::vector<float> m_ScreenSizes;
+
+		/** Screen space triangles of each occluder */
+		std::vector<std::vector<OccluderTriangle>> m_Triangles;
+
+		std::vector<UINT8> m_IsVisible;
+		std::vector<entt::entity> m_Visible;
+		UINT32 m_OccludedCount = 0;
+	};
+}   // namespace Fling
@@ -1,6 +1,13 @@
 #pragma once
 
 #include "Subpass.h"
+#include "Buffer.h"
+#include "BindlessMaterials.h"
+#include "MeshSimplifier.h"
+#include "DrawList.h"
+
+#include <mutex>
+#include <unordered_map>
 
 namespace Fling
 {
@@ -8,36 +15,126 @@ namespace Fling
 	class LogicalDevice;
 	class FrameBuffer;	
 	struct MeshRenderer;
+	class Material;
+	class Model;
 	class Swapchain;
 	class FirstPersonCamera;
+	class OcclusionCuller;
+	class GraphicsPipeline;
 
-	/** UBO for mesh data */
+	/** UBO for the view data, model matrices come from the instance buffer */
 	struct alignas(16) OffscreenUBO
 	{
 		glm::mat4 Projection;
-		glm::mat4 Model;
 		glm::mat4 View;
-		glm::vec3 ObjPos;
 	};
 
-	// Uses the MRT shaders (mulitple render targets)
+	/**
+	 * @brief	Every mesh with the same model and material is drawn with one indirect instanced
+	 *			draw per level of detail of the model. Batches only change when mesh renderers do, the
+	 *			number of instances that each level draws is written to the indirect buffer every frame.
+	 */
+	struct OffscreenInstanceBatch
+	{
+		Fling::Model* Model = nullptr;
+
+		/** The material's descriptor set for each frame in flight, null when bindless is used */
+		const VkDescriptorSet* DescriptorSets = nullptr;
+
+		/** Index in the bindless material buffer, pushed before the draw when bindless is used */
+		UINT32 MaterialIndex = 0;
+
+		/** Index of the first instance slot of this batch in a frame's instance data */
+		UINT32 FirstInstance = 0;
+
+		/** Number of meshes in the batch, which is the most instances it could draw in a frame */
+		UINT32 Capacity = 0;
+
+		/** Meshes that passed culling this frame */
+		UINT32 InstanceCount = 0;
+
+		/** The instance slots of each level of detail are next to each other, in level order */
+		UINT32 LodFirstInstance[MaxMeshLods] = {};
+		UINT32 LodInstanceCount[MaxMeshLods] = {};
+	};
+
+	struct OffscreenInstanceBatchKey
+	{
+		const Fling::Model* Model = nullptr;
+		const Material* Mat = nullptr;
+
+		bool operator==(const OffscreenInstanceBatchKey& t_Other) const { return Model == t_Other.Model && Mat == t_Other.Mat; }
+	};
+
+	struct OffscreenInstanceBatchKeyHash
+	{
+		size_t operator()(const OffscreenInstanceBatchKey& t_Key) const
+		{
+			return std::hash<const void*>()(t_Key.Model) ^ (std::hash<const void*>()(t_Key.Mat) << 1);
+		}
+	};
+
+	/**
+	 * @brief	Resources owned by a single command recording thread. Command pools
+	 *			cannot be used from more than one thread at a time, so each worker
+	 *			allocates its secondary command buffers from its own pool.
+	 */
+	struct OffscreenRecordingThread
+	{
+		VkCommandPool CommandPool = VK_NULL_HANDLE;
+
+		/** Secondary command buffers for each frame in flight, grown as chunks need them */
+		std::vector<std::vector<CommandBuffer*>> SecondaryCmdBufs;
+
+		/** How many secondary buffers this thread has used for the frame currently being recorded */
+		UINT32 UsedCount = 0;
+	};
+
+	/**
+	 * Uses the MRT shaders (mulitple render targets)
+	 *
+	 * The G-Buffer command buffers of each frame in flight are recorded once and submitted again
+	 * every frame. They only get recorded again when a MeshRenderer is added, removed or replaced,
+	 * or when a resource finishes loading. Every frame only the view uniforms, the model matrices
+	 * of the visible meshes and the indirect draw counts are written, so moving or culling meshes
+	 * never has to record anything.
+	 *
+	 * With bindless materials every texture is in one descriptor array and every material is in one
+	 * storage buffer. The same two descriptor sets are bound for every draw and the material is picked
+	 * with a push constant, instead of binding a descriptor set per material.
+	 */
 	class OffscreenSubpass : public Subpass
 	{
 	public:
+		/** The G-Buffer has its own frame buffer, so t_Swap can be null to record without a window. @see VulkanApp::InitHeadless */
 		OffscreenSubpass(
 			const LogicalDevice* t_Dev,
 			const Swapchain* t_Swap,
 			entt::registry& t_reg,
 			FirstPersonCamera* t_Cam,
+			const OcclusionCuller* t_Culler,
 			std::shared_ptr<Fling::Shader> t_Vert,
-			std::shared_ptr<Fling::Shader> t_Frag
+			std::shared_ptr<Fling::Shader> t_Frag,
+			std::shared_ptr<Fling::Shader> t_PackedVert,
+			UINT32 t_BindlessTextureCount = 0
 		);
 
 		virtual ~OffscreenSubpass();
 
+		/** Names of the G-Buffer color attachments in the render graph, in attachment order */
+		static constexpr UINT32 GBufferColorCount = 5;
+		static constexpr const char* GBufferColorNames[GBufferColorCount] = { "GBuffer.Position", "GBuffer.Normal", "GBuffer.Albedo", "GBuffer.Metal", "GBuffer.Roughness" };
+
+		/** Most textures and materials the bindless descriptors are created for */
+		static constexpr UINT32 MaxBindlessTextures = 4096;
+		static constexpr UINT32 MaxBindlessMaterials = 1024;
+
+		/** True if materials are drawn from the bindless texture array, see mrt_bindless.frag */
+		bool IsBindless() const { return m_BindlessTable != nullptr; }
+
 		FrameBuffer* GetOffscreenFrameBuffer() const { return m_OffscreenFrameBuf; }
 
-		void Draw(CommandBuffer& t_CmdBuf, VkFramebuffer t_PresentFrameBuf, UINT32 t_ActiveSwapImage, entt::registry& t_reg, float DeltaTime) override;
+		void Draw(CommandBuffer& t_CmdBuf, VkFramebuffer t_PresentFrameBuf, UINT32 t_ActiveFrame, entt::registry& t_reg, float DeltaTime) override;
 
 		void CreateDescriptorSets(VkDescriptorPool t_Pool, entt::registry& t_reg) override;
 
@@ -45,37 +142,163 @@ namespace Fling
 
 		void CreateGraphicsPipeline() override;
 
-		void GatherPresentDependencies(
-			std::vector<CommandBuffer*>& t_CmdBuffs,
-			std::vector<VkSemaphore>& t_Deps,
-			UINT32 t_ActiveFrameIndex,
-			UINT32 t_CurrentFrameInFlight) override;
+		const char* GetName() const override { return "G-Buffer"; }
+
+		void DeclareResources(RenderGraph& t_Graph, UINT32 t_Pass) override;
+
+		CommandBuffer* GetCommandBuffer(UINT32 t_ActiveFrame) override { return m_OffscreenCmdBufs[t_ActiveFrame]; }
 
 		void CleanUp(entt::registry& t_reg) override;
 
+		/** The command buffers are only recorded again when the batches change, every frame replays the same binds */
+		DrawListStats GetDrawStats() const override { return m_DrawStats; }
+
 	private:
 
 		void OnMeshRendererAdded(entt::entity t_Ent, entt::registry& t_Reg, MeshRenderer& t_MeshRend);
 
-		void OnMeshRendererDestroyed(entt::registry& t_Reg, MeshRenderer& t_MeshRend);
+		void OnMeshRendererReplaced(entt::entity t_Ent, entt::registry& t_Reg, MeshRenderer& t_MeshRend);
+
+		void OnMeshRendererDestroyed(entt::entity t_Ent, entt::registry& t_Reg);
+
+		/**
+		 * @brief	Get the descriptor sets that every mesh with this material shares, one for each frame in
+		 *			flight, creating them if needed. The array stays valid until CleanUp. Thread safe.
+		 */
+		const VkDescriptorSet* GetMaterialDescriptorSets(const Material* t_Mat);
+
+		/** Point a material descriptor set at the view buffer and the material's textures */
+		void WriteMaterialDescriptorSet(VkDescriptorSet t_Set, const Material& t_Mat);
 
-		void CreateMeshDescriptorSet(MeshRenderer& t_MeshRend, VkDescriptorPool t_Pool, FrameBuffer& t_FrameBuf);
+		/** Allocate the bindless descriptor sets and point them at the view and material buffers */
+		void CreateBindlessDescriptorSets();
 
-		void BuildOffscreenCommandBuffer(entt::registry& t_reg, UINT32 t_ActiveFrameInFlight);
+		/** Write the materials and the texture slots of this frame's array that were added since the last call */
+		void UpdateBindlessDescriptors(UINT32 t_ActiveFrame);
 
-		// We need an offscreen semaphore for each possible frame in flight because the swap chain
-		// presentation will depend on this command buffer being complete
-		std::vector<VkSemaphore> m_OffscreenSemaphores;
+		/** Set the fixed function state of the G-Buffer and create the pipeline for one vertex format */
+		void CreateGBufferPipeline(GraphicsPipeline* t_Pipeline, VertexFormat t_Format);
+
+		/** Record the G-Buffer command buffer of a frame in flight with the current batches */
+		void BuildOffscreenCommandBuffer(UINT32 t_ActiveFrame);
+
+		/**
+		 * @brief	Get the next unused secondary command buffer of a recording thread.
+		 *			Only call this from the worker thread that owns t_ThreadIndex
+		 */
+		CommandBuffer* GetSecondaryCommandBuffer(UINT32 t_ThreadIndex, UINT32 t_ActiveFrame);
+
+		/** Bucket every mesh that can be drawn into m_Batches and make sure the frame buffers can hold them */
+		void RebuildBatches(entt::registry& t_reg);
+
+		/** Write the view uniforms, instance data and indirect draws of the visible meshes for a frame in flight */
+		void WriteFrameData(entt::registry& t_reg, UINT32 t_ActiveFrame);
+
+		/** Minimum number of batches to give to a recording thread, below this it isn't worth the overhead */
+		static constexpr size_t MinBatchesPerChunk = 64;
 
 		VkCommandPool m_CommandPool = VK_NULL_HANDLE;
 
+		/**
+		 * Variant of the MRT pipeline for models with packed vertices, which unpacks the positions
+		 * with push constants. Material descriptor sets work with both pipelines
+		 */
+		std::shared_ptr<Fling::Shader> m_PackedVertexShader;
+		std::unique_ptr<GraphicsPipeline> m_PackedPipeline;
+
 		// Offscreen command buffers for populating the GBuffer
 		std::vector<CommandBuffer*> m_OffscreenCmdBufs;
 
 		FrameBuffer* m_OffscreenFrameBuf = nullptr;
 
+		/** Graph that this pass was declared to, for the barriers before the G-Buffer render pass */
+		const RenderGraph* m_RenderGraph = nullptr;
+		UINT32 m_GraphPass = 0;
+
 		const FirstPersonCamera* m_Camera;
 
+		/** Visible meshes for this frame */
+		const OcclusionCuller* m_Culler;
+
 		VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
+
+		/** Guards allocating descriptor sets from m_DescriptorPool during parallel recording */
+		std::mutex m_DescriptorPoolMutex;
+
+		/**
+		 * Descriptor sets of each material, one per frame in flight so that a frame can point it's sets at
+		 * loaded textures while the other frames are still reading theirs
+		 */
+		std::unordered_map<const Material*, std::vector<VkDescriptorSet>> m_MaterialDescriptorSets;
+
+		// Bindless materials -------
+		/** Null when the device doesn't support descriptor indexing */
+		std::unique_ptr<BindlessMaterialTable> m_BindlessTable;
+
+		/** Persistently mapped array of BindlessMaterialData */
+		std::unique_ptr<Buffer> m_MaterialBuffer;
+
+		/** Pool for the texture array, which has to be updatable after it has been bound */
+		VkDescriptorPool m_BindlessPool = VK_NULL_HANDLE;
+
+		/** Set 0 has the view uniforms and materials, it is shared by every frame */
+		VkDescriptorSet m_BindlessViewSet = VK_NULL_HANDLE;
+
+		/** Set 1 has the texture array, each frame in flight has it's own */
+		std::vector<VkDescriptorSet> m_BindlessTextureSets;
+
+		/** How much of each frame's texture array has been written, textures are all written again when image views change */
+		std::vector<UINT32> m_WrittenTextureCounts;
+		UINT32 m_WrittenMaterialCount = 0;
+
+		/**
+		 * Persistently mapped buffers with a fixed region for each frame in flight, so the recorded
+		 * command buffers can keep pointing at the same offsets while the contents change every frame
+		 */
+		std::unique_ptr<Buffer> m_ViewBuffer;
+		std::unique_ptr<Buffer> m_InstanceBuffer;
+		std::unique_ptr<Buffer> m_IndirectBuffer;
+
+		/** Size of each frame's view uniforms, aligned for a dynamic offset */
+		VkDeviceSize m_ViewStride = 0;
+
+		/** Instances and batches that each frame's region has room for, every batch has an indirect draw for each level of detail */
+		UINT32 m_InstanceCapacity = 0;
+		UINT32 m_BatchCapacity = 0;
+
+		/** Instanced draws, only rebuilt when mesh renderers or resources change */
+		std::vector<OffscreenInstanceBatch> m_Batches;
+		std::unordered_map<OffscreenInstanceBatchKey, UINT32, OffscreenInstanceBatchKeyHash> m_BatchLookup;
+
+		/** Instance slot of each visible mesh this frame, UINT32_MAX if it isn't drawn by this pass */
+		std::vector<UINT32> m_InstanceSlots;
+
+		/** Level of detail that each visible mesh is drawn with this frame */
+		std::vector<UINT8> m_InstanceLods;
+
+		/** Sort keys of the batches, so that batches with the same pipeline, material and model are recorded together */
+		std::vector<DrawListItem> m_BatchOrder;
+		std::vector<DrawListItem> m_BatchOrderScratch;
+
+		/** Binds and draws of the last recorded command buffer */
+		DrawListStats m_DrawStats = {};
+
+		/** Set by the mesh renderer signals when m_Batches needs to be rebuilt */
+		bool m_BatchesDirty = true;
+
+		/** Incremented every time the batches are rebuilt */
+		UINT64 m_BatchVersion = 0;
+
+		/** Batch version that each frame's command buffer was recorded with */
+		std::vector<UINT64> m_RecordedVersions;
+
+		/** Resource manager load generation that the batches were last rebuilt at */
+		UINT64 m_LastLoadGeneration = 0;
+
+		/** Resource manager load generation that each frame's descriptor sets were last written at */
+		std::vector<UINT64> m_WrittenLoadGenerations;
+
+		/** Per job system thread recording resources, indexed by JobSystem::GetThreadIndex */
+		std::vector<OffscreenRecordingThread> m_RecordingThreads;
 	};
 }   // namespace Fling
\ No newline at end of file
@@ -22,6 +22,7 @@ namespace Fling
 
 		const VkPhysicalDeviceProperties& GetDeviceProps() const { return m_DeviceProperties; }
         const VkPhysicalDeviceFeatures& GetDeivceFeatures() const { return m_DeviceFeatures; } 
+		const VkPhysicalDeviceMemoryProperties& GetMemoryProperties() const { return m_MemoryProperties; }
 
         /**
          * @brief Get a string representing the device vendor
@@ -45,6 +46,16 @@ namespace Fling
 
 		VkBool32 GetSupportedDepthFormat(VkFormat* depthFormat) const;
 
+		/**
+		 * @brief	True if the device has VK_EXT_descriptor_indexing with everything that bindless
+		 *			materials need: runtime sized arrays of sampled images that are partially bound
+		 *			and can be updated after they are bound
+		 */
+		bool SupportsBindless() const { return m_SupportsBindless; }
+
+		/** Most sampled images a single update after bind descriptor set can hold, 0 without bindless support */
+		UINT32 GetMaxBindlessTextures() const { return m_MaxBindlessTextures; }
+
     private:
 
 		/**
@@ -53,6 +64,9 @@ namespace Fling
 		 */
 		VkPhysicalDevice ChooseBestPhyscialDevice(std::vector<VkPhysicalDevice>& t_AvailableDevices);
 
+		/** Check for descriptor indexing support and limits */
+		void QueryBindlessSupport();
+
         /** The Vulkan physical device */
         VkPhysicalDevice m_PhysicalDevice = VK_NULL_HANDLE;
 
@@ -66,5 +80,8 @@ namespace Fling
 
 		/** The max supported MSSA level on this device */
 		VkSampleCountFlagBits m_MSAASamples = VK_SAMPLE_COUNT_1_BIT;
+
+		bool m_SupportsBindless = false;
+		UINT32 m_MaxBindlessTextures = 0;
     };
 }   // namespace Fling
\ No newline at end of file
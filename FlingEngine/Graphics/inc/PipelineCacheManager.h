@@ -0,0 +1,115 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "FlingVulkan.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace Fling
+{
+	/**
+	 * @brief	Written in front of the driver's pipeline cache data. The driver data is only valid on
+	 *			the same GPU with the same driver, so anything else is thrown away on load.
+	 */
+	struct PipelineCacheFileHeader
+	{
+		UINT32 Magic;
+		UINT32 Version;
+		UINT32 VendorID;
+		UINT32 DeviceID;
+		UINT32 DriverVersion;
+		UINT32 DataSize;
+		UINT64 DataHash;
+		UINT8 PipelineCacheUUID[VK_UUID_SIZE];
+
+		/** How long creating the pipelines took when there was no cache, so warm starts can compare against it */
+		UINT64 ColdCreationMicroseconds;
+	};
+	static_assert(sizeof(PipelineCacheFileHeader) == 56, "Pipeline cache header layout changed, bump the version");
+
+	/**
+	 * @brief	Owns the VkPipelineCache that every graphics pipeline is created with. The cache is
+	 *			loaded from the engine config directory on startup and saved back on shutdown, so that
+	 *			only the first launch on a machine pays for the driver compiling every pipeline.
+	 *
+	 *			Pipelines can be created from any thread, the driver synchronizes access to the cache.
+	 */
+	class PipelineCacheManager
+	{
+	public:
+
+		static constexpr UINT32 Magic = 0x43504C46;	// "FLPC"
+		static constexpr UINT32 Version = 1;
+		static constexpr const char* FileName = "PipelineCache.bin";
+
+		/**
+		 * @param t_Props		Properties of the device that the cache is for
+		 * @param t_FilePath	Where the cache is loaded from and saved to
+		 */
+		PipelineCacheManager(VkDevice t_Device, const VkPhysicalDeviceProperties& t_Props, const std::string& t_FilePath);
+
+		/** Saves the cache before destroying it */
+		~PipelineCacheManager();
+
+		/** Write the current contents of the cache to disk */
+		bool Save();
+
+		/** Create pipelines with the shared cache and add the time it took to the creation stats */
+		VkResult CreateGraphicsPipelines(const VkGraphicsPipelineCreateInfo* t_CreateInfos, UINT32 t_Count, VkPipeline* t_OutPipelines);
+
+		/**
+		 * @brief	Log the time spent creating pipelines so far and whether the cache was warm. The first
+		 *			report of a cold start is saved as the cold time that warm starts are compared to.
+		 */
+		void ReportCreationTime();
+
+		FORCEINLINE VkPipelineCache GetVkPipelineCache() const { return m_PipelineCache; }
+
+		/** True if usable cache data was loaded from disk */
+		FORCEINLINE bool IsWarm() const { return m_IsWarm; }
+
+		FORCEINLINE UINT32 GetCreatedPipelineCount() const { return m_CreatedCount.load(std::memory_order_relaxed); }
+
+		/** Total time spent inside of the driver creating pipelines, summed over every thread */
+		FORCEINLINE UINT64 GetCreationMicroseconds() const { return m_CreationMicroseconds.load(std::memory_order_relaxed); }
+
+		/**
+		 * @brief	Wrap the driver's cache data with a header for the given device
+		 * @param t_OutFile		The bytes to write to disk
+		 */
+		static void Serialize(const VkPhysicalDeviceProperties& t_Props, const std::vector<UINT8>& t_CacheData, UINT64 t_ColdMicroseconds, std::vector<UINT8>& t_OutFile);
+
+		/**
+		 * @brief	Check that a cache file was written for the given device and driver and isn't corrupt.
+		 *			The driver's own header inside of the data has to match the device as well.
+		 * @return	Pointer to the driver data inside of t_File, or nullptr if it can't be used
+		 */
+		static const UINT8* Validate(const UINT8* t_File, size_t t_FileSize, const VkPhysicalDeviceProperties& t_Props, const PipelineCacheFileHeader** t_OutHeader = nullptr);
+
+		static UINT64 HashData(const UINT8* t_Data, size_t t_Size);
+
+	private:
+
+		/** Read the file and return the driver data in it, empty if there is none or it is stale */
+		std::vector<UINT8> Load();
+
+		VkDevice m_Device = VK_NULL_HANDLE;
+
+		VkPhysicalDeviceProperties m_DeviceProps = {};
+
+		std::string m_FilePath;
+
+		VkPipelineCache m_PipelineCache = VK_NULL_HANDLE;
+
+		bool m_IsWarm = false;
+
+		/** Cold creation time from the file, or the one measured this run if it started cold */
+		UINT64 m_ColdMicroseconds = 0;
+
+		std::atomic<UINT32> m_CreatedCount { 0 };
+
+		std::atomic<UINT64> m_CreationMicroseconds { 0 };
+	};
+}   // namespace Fling
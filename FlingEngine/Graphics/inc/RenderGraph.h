@@ -0,0 +1,250 @@
+#pragma once
+
+#include "FlingVulkan.h"
+#include "FlingTypes.h"
+#include "DeviceMemoryAllocator.h"
+#include "NonCopyable.hpp"
+
+#include <string>
+#include <vector>
+
+namespace Fling
+{
+	class LogicalDevice;
+
+	/** How a pass uses a texture. Decides the pipeline stages, access masks and image layout of the access */
+	enum class RenderGraphUsage : UINT8
+	{
+		/** The contents are not needed, only valid as the initial usage of an imported texture */
+		Undefined,
+		ColorAttachment,
+		DepthAttachment,
+		/** Read only depth attachment that can also be sampled */
+		DepthRead,
+		ShaderRead,
+		StorageRead,
+		StorageWrite,
+		TransferSrc,
+		TransferDst,
+		Present,
+
+		Count
+	};
+
+	/** Handle to a version of a graph texture. Every write to a texture creates a new version */
+	struct RenderGraphResource
+	{
+		static constexpr UINT32 InvalidIndex = UINT32_MAX;
+
+		UINT32 Index = InvalidIndex;
+		UINT32 Version = 0;
+
+		FORCEINLINE bool IsValid() const { return Index != InvalidIndex; }
+	};
+
+	struct RenderGraphTextureDesc
+	{
+		UINT32 Width = 0;
+		UINT32 Height = 0;
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+
+		/**
+		 * Memory that a transient texture needs. Filled in from the image's memory requirements when
+		 * the transient resources are created, set it yourself to compile without a device.
+		 */
+		VkDeviceSize Size = 0;
+		VkDeviceSize Alignment = 1;
+	};
+
+	/** A texture that is either owned by the graph (transient) or imported from somewhere else */
+	struct RenderGraphTexture
+	{
+		std::string Name;
+		RenderGraphTextureDesc Desc = {};
+
+		bool IsImported = false;
+
+		/** Usage that an imported texture is in at the start of the frame */
+		RenderGraphUsage InitialUsage = RenderGraphUsage::Undefined;
+
+		/** Number of versions, each write adds one */
+		UINT32 VersionCount = 1;
+
+		// Set by Compile ------
+		/** Execution order positions of the first and last passes that use this texture */
+		UINT32 FirstUse = UINT32_MAX;
+		UINT32 LastUse = 0;
+
+		/** Usage flags that the image needs for every access to it */
+		VkImageUsageFlags ImageUsage = 0;
+
+		/** Offset into the transient memory, transient textures with overlapping ranges alias each other */
+		VkDeviceSize MemoryOffset = 0;
+
+		/** Transient textures that used the same memory earlier in the frame */
+		std::vector<UINT32> AliasedTextures;
+
+		// Device resources ------
+		VkImage Image = VK_NULL_HANDLE;
+		VkImageView View = VK_NULL_HANDLE;
+		VkImageAspectFlags Aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+
+		FORCEINLINE bool IsUsed() const { return FirstUse != UINT32_MAX; }
+	};
+
+	struct RenderGraphAccess
+	{
+		UINT32 Texture = RenderGraphResource::InvalidIndex;
+
+		/** Version that is read, or the version that is written over */
+		UINT32 Version = 0;
+
+		RenderGraphUsage Usage = RenderGraphUsage::Undefined;
+
+		/** Usage that the pass leaves the texture in, for render passes that transition their attachments */
+		RenderGraphUsage EndUsage = RenderGraphUsage::Undefined;
+
+		bool IsWrite = false;
+	};
+
+	/** A pipeline barrier that has to be recorded before a pass */
+	struct RenderGraphBarrier
+	{
+		UINT32 Texture = RenderGraphResource::InvalidIndex;
+
+		/** Pass that last used the texture, UINT32_MAX if it comes from before the frame or from aliased memory */
+		UINT32 SrcPass = UINT32_MAX;
+
+		VkPipelineStageFlags SrcStages = 0;
+		VkPipelineStageFlags DstStages = 0;
+		VkAccessFlags SrcAccess = 0;
+		VkAccessFlags DstAccess = 0;
+		VkImageLayout OldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkImageLayout NewLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	};
+
+	struct RenderGraphPass
+	{
+		std::string Name;
+		std::vector<RenderGraphAccess> Accesses;
+
+		/** Passes with side effects are never culled, even if nothing reads what they write */
+		bool HasSideEffects = false;
+
+		// Set by Compile ------
+		bool IsCulled = false;
+
+		/** Passes on the same level do not depend on each other and can be recorded in parallel */
+		UINT32 Level = 0;
+
+		std::vector<RenderGraphBarrier> Barriers;
+	};
+
+	/**
+	 * @brief	Passes declare which textures they read and write, and the graph works out the order
+	 *			to run them in, the barriers and layout transitions between them and which transient
+	 *			textures can share memory. Passes are ordered by the versions of the textures they
+	 *			use, not by the order that they were added in.
+	 *
+	 *			Compiling does not touch the device, so it can be tested without one.
+	 */
+	class RenderGraph : public NonCopyable
+	{
+	public:
+
+		RenderGraph() = default;
+		~RenderGraph();
+
+		/** @return Index of the new pass */
+		UINT32 AddPass(const std::string& t_Name, bool t_HasSideEffects = false);
+
+		/** Add a texture whose memory is owned by the graph and only lives for the frame */
+		RenderGraphResource CreateTexture(const std::string& t_Name, const RenderGraphTextureDesc& t_Desc);
+
+		/**
+		 * @brief	Add a texture that is owned by something else. Writing to an imported texture keeps
+		 *			the pass from being culled.
+		 * @param t_Image	Can be null if the image changes every frame, @see SetImage
+		 */
+		RenderGraphResource ImportTexture(
+			const std::string& t_Name,
+			const RenderGraphTextureDesc& t_Desc,
+			VkImage t_Image = VK_NULL_HANDLE,
+			VkImageAspectFlags t_Aspect = VK_IMAGE_ASPECT_COLOR_BIT,
+			RenderGraphUsage t_InitialUsage = RenderGraphUsage::Undefined
+		);
+
+		/** @return The latest version of the texture with the given name, or an invalid handle */
+		RenderGraphResource FindTexture(const std::string& t_Name) const;
+
+		/** Read a version of a texture, the pass runs after the pass that wrote that version */
+		void Read(UINT32 t_Pass, RenderGraphResource t_Texture, RenderGraphUsage t_Usage);
+
+		/**
+		 * @brief	Write the latest version of a texture
+		 * @param t_EndUsage	Usage that the pass leaves the texture in if it isn't t_Usage, like the
+		 *						final layout of a render pass attachment
+		 * @return	The new version that later passes should use
+		 */
+		RenderGraphResource Write(UINT32 t_Pass, RenderGraphResource t_Texture, RenderGraphUsage t_Usage, RenderGraphUsage t_EndUsage = RenderGraphUsage::Undefined);
+
+		/**
+		 * @brief	Cull passes that nothing needs, sort the rest, place barriers and alias transient memory
+		 * @return	False if the passes depend on each other in a cycle
+		 */
+		bool Compile();
+
+		/** Create and bind the transient images of a compiled graph, aliased in a single allocation */
+		void CreateTransientResources(const LogicalDevice* t_Device, DeviceMemoryAllocator* t_Allocator);
+
+		void DestroyTransientResources();
+
+		/** Point an imported texture at an image, for textures like the swap chain that change every frame */
+		void SetImage(RenderGraphResource t_Texture, VkImage t_Image);
+
+		/** Record the barriers that a pass needs. Barriers of textures without an image are skipped */
+		void RecordBarriers(VkCommandBuffer t_CmdBuf, UINT32 t_Pass) const;
+
+		/** Pass indices in the order they should run, culled passes are left out */
+		FORCEINLINE const std::vector<UINT32>& GetExecutionOrder() const { return m_ExecutionOrder; }
+
+		/** Pass indices of each level, in execution order */
+		FORCEINLINE const std::vector<std::vector<UINT32>>& GetLevels() const { return m_Levels; }
+
+		FORCEINLINE const RenderGraphPass& GetPass(UINT32 t_Pass) const { return m_Passes[t_Pass]; }
+		FORCEINLINE const RenderGraphTexture& GetTexture(RenderGraphResource t_Texture) const { return m_Textures[t_Texture.Index]; }
+		FORCEINLINE UINT32 GetPassCount() const { return static_cast<UINT32>(m_Passes.size()); }
+
+		/** Bytes of memory that all of the transient textures need after aliasing */
+		FORCEINLINE VkDeviceSize GetTransientMemorySize() const { return m_TransientMemorySize; }
+
+		/** Whether the usage only reads the texture */
+		static bool IsReadOnly(RenderGraphUsage t_Usage);
+
+		static VkImageLayout GetLayout(RenderGraphUsage t_Usage);
+
+	private:
+
+		/** Find which passes have to run for the imported textures and side effects */
+		void CullPasses(const std::vector<std::vector<UINT32>>& t_DataDeps);
+
+		/** Sort the passes by level, @return false if there is a cycle */
+		bool SortPasses(const std::vector<std::vector<UINT32>>& t_Deps);
+
+		void AliasTransientMemory();
+
+		void PlaceBarriers();
+
+		std::vector<RenderGraphPass> m_Passes;
+		std::vector<RenderGraphTexture> m_Textures;
+
+		std::vector<UINT32> m_ExecutionOrder;
+		std::vector<std::vector<UINT32>> m_Levels;
+
+		VkDeviceSize m_TransientMemorySize = 0;
+
+		const LogicalDevice* m_Device = nullptr;
+		DeviceMemoryAllocator* m_Allocator = nullptr;
+		DeviceAllocation m_TransientMemory = {};
+	};
+}   // namespace Fling
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Subpass.h"
+#include "RenderGraph.h"
 #include "NonCopyable.hpp"
 #include <entt/entity/registry.hpp>
 
@@ -10,29 +11,47 @@ namespace Fling
 	class LogicalDevice;
 	class Swapchain;
 	class FrameBuffer;
+	class DeviceMemoryAllocator;
 	struct MeshRenderer;
 
 	/**
-	* @brief	A render pipeline encapsulates the functionality of a 
-	* 
+	* @brief	A render pipeline owns the subpasses that draw a frame. Each subpass declares the textures
+	*			it reads and writes to a render graph, which decides the order they run in and the
+	*			barriers between them.
+	*
+	*			Subpasses without their own command buffer draw into the swap chain render pass, the rest
+	*			are submitted before or after the swap chain command buffer in graph order.
 	*/
 	class RenderPipeline : public NonCopyable
 	{
 	public:
 
-		RenderPipeline(entt::registry& t_Reg, LogicalDevice* t_dev, Swapchain* t_Swap, std::vector<std::unique_ptr<Subpass>>& t_Subpasses);
+		RenderPipeline(entt::registry& t_Reg, LogicalDevice* t_dev, Swapchain* t_Swap, DeviceMemoryAllocator* t_Allocator, std::vector<std::unique_ptr<Subpass>>& t_Subpasses);
 		~RenderPipeline();
 
-		void Draw(CommandBuffer& t_CmdBuf, VkFramebuffer t_PresentFrameBuf, UINT32 t_ActiveFrameInFlight, entt::registry& t_Reg, float DeltaTime);
+		/**
+		 * @brief	Run the subpasses that record their own command buffers. Subpasses on the same level of the
+		 *			graph do not depend on each other, so they are run in parallel.
+		 */
+		void RecordCommandBuffers(UINT32 t_ActiveFrame, entt::registry& t_Reg, float DeltaTime);
+
+		/** Record the barriers of the subpasses that draw into the swap chain render pass, before it begins */
+		void RecordBarriers(CommandBuffer& t_CmdBuf, UINT32 t_ActiveSwapImage);
 
-		/** Given a frame index, get any semaphores that the swap chain command buffer needs to wait for */
-		void GatherPresentDependencies(std::vector<CommandBuffer*>& t_CmdBuffs, std::vector<VkSemaphore>& t_Deps, UINT32 t_ActiveFrameIndex, UINT32 t_CurrentFrameInFlight);
+		/** Draw the subpasses that draw into the swap chain render pass, in graph order */
+		void Draw(CommandBuffer& t_CmdBuf, VkFramebuffer t_PresentFrameBuf, UINT32 t_ActiveFrame, entt::registry& t_Reg, float DeltaTime);
 
-		void GatherPresentBuffers(std::vector<CommandBuffer*>& t_CmdBuffs, UINT32 t_ActiveFrameIndex);
+		/** Command buffers of the subpasses that record their own, split by which side of the swap chain command buffer they go on */
+		void GatherCommandBuffers(std::vector<CommandBuffer*>& t_Before, std::vector<CommandBuffer*>& t_After, UINT32 t_ActiveFrame);
 
 		/** Clean up any allocated VK resources that may have been set in a sub pass and need the registry */
 		void CleanUp(entt::registry& t_reg);
 
+		FORCEINLINE const RenderGraph& GetRenderGraph() const { return m_RenderGraph; }
+
+		/** Binds and draws of every subpass for the last frame */
+		DrawListStats GetDrawStats() const;
+
 	private:
 
 		/**
@@ -40,8 +59,26 @@ namespace Fling
 		*/
 		void CreateDescriptors(entt::registry& t_Reg);
 
+		/** Declare every subpass to the render graph and compile it */
+		void BuildRenderGraph(DeviceMemoryAllocator* t_Allocator);
+
 		std::vector<std::unique_ptr<Subpass>> m_Subpasses;
 
+		RenderGraph m_RenderGraph;
+
+		/** The swap chain image, which changes every frame */
+		RenderGraphResource m_Backbuffer = {};
+
+		/** Subpass of each render graph pass */
+		std::vector<Subpass*> m_PassSubpasses;
+
+		/** Graph passes that draw into the swap chain render pass, in execution order */
+		std::vector<UINT32> m_InlinePasses;
+
+		/** Graph passes with their own command buffer that run before and after the swap chain render pass */
+		std::vector<UINT32> m_PassesBefore;
+		std::vector<UINT32> m_PassesAfter;
+
 		VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
 
 		const LogicalDevice* m_Device;
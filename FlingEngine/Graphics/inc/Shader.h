@@ -2,11 +2,8 @@
 
 #include "FlingVulkan.h"
 
-#include "spirv_cross.hpp"
-#include "spirv_glsl.hpp"
-#include "spirv.h"
-
 #include "Resource.h"
+#include "ShaderReflection.h"
 #include "FlingExports.h"
 #include <fstream>
 #include <vector>
@@ -91,26 +88,32 @@ namespace Fling
         VkShaderModule GetShaderModule() const { return m_Module; }
 
         /** get the Vulkan stage bit flags that we should bind to */
-		VkShaderStageFlagBits GetStage() const { return m_Stage; }
+		VkShaderStageFlagBits GetStage() const { return m_Reflection.Stage; }
+
+		/** True if the shader declares a push constant block */
+		bool UsesPushConstants() const { return m_Reflection.PushConstantSize > 0; }
+
+		/** Descriptors, push constants and vertex inputs that the shader declares */
+		const ShaderReflection& GetReflection() const { return m_Reflection; }
 
 		/**
 		* @breif	Release any resrources created by this shader (the module)
 		*/
 		void Release();
 
-		static VkDescriptorSetLayout CreateSetLayout(VkDevice t_Dev, std::vector<Shader*>& t_Shaders, bool t_SupportPushDescriptor = false);
-
-		static VkPipelineLayout CreatePipelineLayout(VkDevice t_Dev, VkDescriptorSetLayout t_SetLayout, VkShaderStageFlags t_PushConstantStages, size_t t_PushConstantSize);
+		/**
+		 * @brief	Get the descriptor set layouts and pipeline layout for a set of pipeline stages
+		 *			from the layout cache. Shaders with the same interface get the same layouts.
+		 * @param t_DynamicUniformMask 	Bit mask of uniform buffer bindings that should be created as 
+		 *								VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, reflection can't tell them apart
+		 * @param t_RuntimeArraySize	Descriptor count of runtime sized arrays. Their sets are created to be
+		 *								updated after they are bound and the arrays don't have to be filled
+		 * @param t_OutSetLayouts		One layout for each set up to the highest one used, always at least one
+		 */
+		static VkPipelineLayout GetLayouts(const std::vector<Shader*>& t_Shaders, UINT32 t_DynamicUniformMask, UINT32 t_RuntimeArraySize, std::vector<VkDescriptorSetLayout>& t_OutSetLayouts);
 
     private:
 
-		static UINT32 GatherResources(const std::vector<Shader*>& t_Shaders, VkDescriptorType(&t_ResourceTypes)[32]);
-
-        /**
-         * @brief Compiles this shader with SPRIV-Cross
-         */
-        void ParseReflectionData(const UINT32* t_Code, UINT32 t_Size);
-
         /** Creates the shader modules  */
         VkResult CreateShaderModule(std::vector<char>& t_ShaderCode);
 
@@ -122,23 +125,10 @@ namespace Fling
         /** The shader module created by this shader */
         VkShaderModule m_Module = VK_NULL_HANDLE;
 
-		// Shader reflection data ----------
-		UINT32 m_ResourceMask {};
-
-		/** The types of descriptors that are used by this shader */
-		VkDescriptorType m_ResourceTypes[32] {};
-
-        /** The stage in the pipeline that this shader is in */
-        VkShaderStageFlagBits m_Stage = VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT;
+		/** Reflection data parsed from the SPIR-V */
+		ShaderReflection m_Reflection;
 		
 		const LogicalDevice* m_Device;
-
-		bool m_UsesPushConstants = false;
-
-		// Sizes that can be used by a compute pipeline
-		UINT32 localSizeX {};
-		UINT32 localSizeY {};
-		UINT32 localSizeZ {};
     };
     
 }   // namespace Fling
\ No newline at end of file
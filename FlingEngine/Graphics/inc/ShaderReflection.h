@@ -0,0 +1,81 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "FlingVulkan.h"
+
+#include <string>
+#include <vector>
+
+namespace Fling
+{
+	/** A descriptor that a shader declares */
+	struct ShaderBinding
+	{
+		UINT32 Set = 0;
+		UINT32 Binding = 0;
+		VkDescriptorType Type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+
+		/** Number of descriptors in the binding, 0 for runtime sized arrays */
+		UINT32 Count = 1;
+
+		/** Size of the block in bytes for uniform and storage buffers */
+		UINT32 Size = 0;
+
+		/** Name of the variable in the shader, or of the block type if the variable doesn't have one */
+		std::string Name;
+	};
+
+	/** A vertex attribute that a vertex shader reads. Matrices take up a location for each column */
+	struct ShaderVertexInput
+	{
+		UINT32 Location = 0;
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+		std::string Name;
+	};
+
+	/**
+	 * @brief	Everything a pipeline needs to know about a shader to build its layouts, read straight
+	 *			from the SPIR-V. Names come from the debug info, which glslangValidator keeps by default.
+	 */
+	struct ShaderReflection
+	{
+		VkShaderStageFlagBits Stage = VK_SHADER_STAGE_VERTEX_BIT;
+
+		/** Bindings ordered by set and then binding */
+		std::vector<ShaderBinding> Bindings;
+
+		/** Inputs ordered by location. Only filled in for vertex shaders */
+		std::vector<ShaderVertexInput> VertexInputs;
+
+		/** Bytes of the push constant block that the shader uses, 0 if it doesn't have one */
+		UINT32 PushConstantOffset = 0;
+		UINT32 PushConstantSize = 0;
+
+		/** Sizes that can be used by a compute pipeline */
+		UINT32 LocalSize[3] = {};
+
+		/**
+		 * @brief	Parse a SPIR-V module
+		 * @param t_WordCount	Size of the code in 32 bit words
+		 * @return	False if the code isn't valid SPIR-V or uses something that can't be reflected
+		 */
+		static bool Parse(const UINT32* t_Code, size_t t_WordCount, ShaderReflection& t_Out);
+
+		const ShaderBinding* FindBinding(const std::string& t_Name) const;
+
+		/** One past the highest descriptor set used, 0 if the shader has no descriptors */
+		UINT32 GetSetCount() const;
+
+		/**
+		 * @brief	Merge the bindings of one set across every stage of a pipeline into layout bindings.
+		 *			Stages that share a binding have to agree on its type.
+		 * @param t_DynamicUniformMask	Uniform buffer bindings that are bound with a dynamic offset,
+		 *								reflection can't tell them apart from regular uniform buffers
+		 * @return	False if two stages declare the same binding differently
+		 */
+		static bool GetSetBindings(const std::vector<const ShaderReflection*>& t_Stages, UINT32 t_Set, UINT32 t_DynamicUniformMask, std::vector<VkDescriptorSetLayoutBinding>& t_OutBindings);
+
+		/** A single push constant range covering the blocks of every stage, empty if no stage uses one */
+		static void GetPushConstantRanges(const std::vector<const ShaderReflection*>& t_Stages, std::vector<VkPushConstantRange>& t_OutRanges);
+	};
+}   // namespace Fling
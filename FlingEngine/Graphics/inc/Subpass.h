@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Shader.h"
+#include "DrawList.h"
 #include "NonCopyable.hpp"
 
 #include <entt/entity/registry.hpp>
@@ -13,19 +14,26 @@ namespace Fling
 	class FrameBuffer;
 	class Swapchain;
 	class GraphicsPipeline;
+	class RenderGraph;
 
 	/**
 	* @breif	A subpass represents one part of a RenderPipeline. Each subpass should 
 	*			can add attachments to the frame buffer, build it's own command buffers, 
 	*			and create its own descriptors. When overriding this class, add any additional
 	*			uniform buffers or bindings you may need into the child class. 
+	*			The order that subpasses run in comes from the textures that they declare to the
+	*			render graph.
 	* 
 	* @see GeometrySubpass for an example
 	*/
 	class Subpass : public NonCopyable
 	{
 	public:
-		Subpass(const LogicalDevice* t_Dev, const Swapchain* t_Swap, std::shared_ptr<Fling::Shader> t_Vert, std::shared_ptr<Fling::Shader> t_Frag);
+		/**
+		 * @param t_DynamicUniformMask 	Uniform buffer bindings that are bound with a dynamic offset
+		 * @param t_RuntimeArraySize	Descriptor count of any runtime sized arrays in the shaders
+		 */
+		Subpass(const LogicalDevice* t_Dev, const Swapchain* t_Swap, std::shared_ptr<Fling::Shader> t_Vert, std::shared_ptr<Fling::Shader> t_Frag, UINT32 t_DynamicUniformMask = 0, UINT32 t_RuntimeArraySize = 0);
 		
 		virtual ~Subpass();
 
@@ -34,6 +42,13 @@ namespace Fling
 
 		virtual void CreateGraphicsPipeline() = 0;
 
+		/**
+		 * @brief	Subpasses create their pipelines at the same time on the job system. Return false if
+		 *			CreateGraphicsPipeline does more than build pipelines, like uploading textures, and it
+		 *			will be called on the main thread instead.
+		 */
+		virtual bool CanCreatePipelineInParallel() const { return true; }
+
 		virtual void Draw(CommandBuffer& t_CmdBuf, VkFramebuffer t_PresentFrameBuf, UINT32 t_ActiveFrameInFlight, entt::registry& t_reg, float DeltaTime) = 0;
 
 		/** Cleanup any allocated resources that you may need a registry for */
@@ -46,18 +61,27 @@ namespace Fling
 		*/		
 		virtual void CreateDescriptorSets(VkDescriptorPool t_Pool, entt::registry& t_reg) = 0;
 		
+		/** Name of this subpass' pass in the render graph */
+		virtual const char* GetName() const = 0;
+
 		/**
-		 * @brief	If a subpass has a command buffer that the final swap chain presentation is dependent on, 
-		 *			then add it this vector. The Deferred offscreen GBuffer is an example of this
+		 * @brief	Declare the textures that this subpass reads and writes as pass t_Pass of the render graph.
+		 *			Textures written by earlier subpasses can be found by name.
 		 */
-		virtual void GatherPresentDependencies(std::vector<CommandBuffer*>& t_CmdBuffs, std::vector<VkSemaphore>& t_Deps, UINT32 t_ActiveFrameIndex, UINT32 t_CurrentFrameInFlight) {}
-		
+		virtual void DeclareResources(RenderGraph& t_Graph, UINT32 t_Pass) = 0;
+
 		/**
-		* @brief	If a subpass has an additional command buffer to add to the final swap chain draw submission
-		*			but it is not dependent on it, then add it here. ImGUI is an example of this
-		*/
-		virtual void GatherPresentBuffers(std::vector<CommandBuffer*>& t_CmdBuffs, UINT32 t_ActiveFrameIndex) {}
+		 * @brief	If a subpass records its own command buffer instead of drawing into the swap chain render
+		 *			pass, return it here. It is submitted before or after the swap chain command buffer depending
+		 *			on where the render graph puts the pass. The Deferred offscreen GBuffer is an example of this
+		 */
+		virtual CommandBuffer* GetCommandBuffer(UINT32 t_ActiveFrame) { return nullptr; }
+
+		/** Binds and draws that this subpass recorded for the last frame */
+		virtual DrawListStats GetDrawStats() const { return {}; }
 
+		/** Name of the swap chain image in the render graph, subpasses that draw to the screen write to it */
+		static constexpr const char* BackbufferName = "Backbuffer";
 
 		inline GraphicsPipeline* GetGraphicsPipeline() const noexcept { return m_GraphicsPipeline; }
 		inline const std::vector<VkClearValue>& GetClearValues() const { return m_ClearValues; }
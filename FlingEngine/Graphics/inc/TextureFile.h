@@ -0,0 +1,114 @@
+#pragma once
+
+#include "FlingVulkan.h"
+#include "BlockCompression.h"
+#include "MappedFile.h"
+
+#include <string>
+#include <vector>
+
+namespace Fling
+{
+	/**
+	 * @brief	Header at the start of a cooked .fltex file, laid out like a trimmed down KTX2 header.
+	 *			A TextureFileLevel for every mip follows it, then the compressed blocks of each mip.
+	 */
+	struct TextureFileHeader
+	{
+		UINT32 Magic = 0;
+		UINT32 Version = 0;
+
+		/** The VkFormat to create the image with, like the vkFormat of KTX2 */
+		UINT32 Format = 0;
+
+		/** BlockFormat of the data */
+		UINT32 BlockFormat = 0;
+
+		UINT32 Width = 0;
+		UINT32 Height = 0;
+		UINT32 MipCount = 0;
+		UINT32 Reserved = 0;
+	};
+
+	static_assert(sizeof(TextureFileHeader) == 32, "The texture file header is written to disk, keep it the same size");
+
+	/** Where the blocks of one mip level are in the file */
+	struct TextureFileLevel
+	{
+		UINT64 Offset = 0;
+		UINT64 Size = 0;
+	};
+
+	/**
+	 * @brief	A cooked texture that is mapped into memory. Every mip level is already compressed, so
+	 *			the whole chain is copied into a staging buffer without any decoding or mip blits.
+	 * @see		TextureImporter::Cook
+	 */
+	class TextureFile : public NonCopyable
+	{
+	public:
+
+		/** "FLTX" */
+		static constexpr UINT32 Magic = 0x58544C46;
+
+		/** Bump this whenever the layout of the file or the encoders change */
+		static constexpr UINT32 Version = 1;
+
+		static constexpr const char* Extension = ".fltex";
+
+		/** Mip levels start on this alignment, which covers the texel block size of every BC format */
+		static constexpr UINT64 DataAlignment = 16;
+
+		/** The Vulkan format that the GPU samples the blocks of a BlockFormat with */
+		static VkFormat GetVkFormat(BlockFormat t_Format);
+
+		/**
+		 * @brief	Write a cooked texture file
+		 * @param t_Levels	Compressed blocks of every mip level, starting with the full size image
+		 * @return	True if the whole file was written
+		 */
+		static bool Write(const std::string& t_FilePath, BlockFormat t_Format, UINT32 t_Width, UINT32 t_Height, const std::vector<std::vector<UINT8>>& t_Levels);
+
+		/** Path of the cooked file for a source image, which sits next to it with the .fltex extension */
+		static std::string GetCookedPath(const std::string& t_SourcePath);
+
+		/** True if the cooked file exists and is at least as new as the source image */
+		static bool IsUpToDate(const std::string& t_SourcePath, const std::string& t_CookedPath);
+
+		TextureFile() = default;
+		~TextureFile() = default;
+
+		/**
+		 * @brief	Map a cooked texture file and check that it can be used by this build
+		 * @return	False if the file is missing, has an old version or is truncated
+		 */
+		bool Open(const std::string& t_FilePath);
+
+		void Close();
+
+		FORCEINLINE bool IsOpen() const { return m_Header != nullptr; }
+
+		FORCEINLINE UINT32 GetWidth() const { return m_Header->Width; }
+		FORCEINLINE UINT32 GetHeight() const { return m_Header->Height; }
+		FORCEINLINE UINT32 GetMipCount() const { return m_Header->MipCount; }
+
+		FORCEINLINE BlockFormat GetBlockFormat() const { return static_cast<BlockFormat>(m_Header->BlockFormat); }
+		FORCEINLINE VkFormat GetVkFormat() const { return static_cast<VkFormat>(m_Header->Format); }
+
+		FORCEINLINE const TextureFileLevel& GetLevel(UINT32 t_Mip) const { return m_Levels[t_Mip]; }
+
+		FORCEINLINE const UINT8* GetLevelData(UINT32 t_Mip) const { return m_File.GetData() + m_Levels[t_Mip].Offset; }
+
+		/** The blocks of every mip level, which are stored back to back from GetLevel(0).Offset */
+		FORCEINLINE const UINT8* GetData() const { return GetLevelData(0); }
+		UINT64 GetDataSize() const;
+
+	private:
+
+		MappedFile m_File;
+
+		const TextureFileHeader* m_Header = nullptr;
+
+		const TextureFileLevel* m_Levels = nullptr;
+	};
+}   // namespace Fling
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "BlockCompression.h"
+
+#include <string>
+#include <vector>
+
+namespace Fling
+{
+	/** What a texture is sampled as, which decides how it is filtered and compressed */
+	enum class TextureUsage : UINT8
+	{
+		/** Albedo and anything else with RGBA color, BC7 */
+		Color,
+
+		/** Tangent space normal map, BC5 with the Z rebuilt in the shader */
+		Normal,
+
+		/** Single channel masks like metal and roughness, BC4 */
+		Mask,
+	};
+
+	/** One level of a mip chain as RGBA8 pixels */
+	struct TextureMip
+	{
+		UINT32 Width = 0;
+		UINT32 Height = 0;
+		std::vector<UINT8> Pixels;
+	};
+
+	/** What cooking a texture did */
+	struct TextureCookStats
+	{
+		BlockFormat Format = BlockFormat::BC7;
+		UINT32 MipCount = 0;
+
+		/** Bytes of every mip level as RGBA8 and after compression */
+		UINT64 SourceSize = 0;
+		UINT64 CompressedSize = 0;
+
+		/** PSNR in dB of the full size mip over the channels that the format keeps */
+		double PSNR = 0.0;
+	};
+
+	/**
+	 * @brief	Turns source images into compressed mip chains ahead of time, so that textures don't
+	 *			need to decode pngs or blit mips at runtime. Used by the texture cooker.
+	 */
+	namespace TextureImporter
+	{
+		/**
+		 * @brief	The block format for a texture. Color textures use BC7 unless compact colors are
+		 *			asked for, in which case they use BC1, or BC3 if any pixel isn't opaque.
+		 */
+		BlockFormat SelectBlockFormat(TextureUsage t_Usage, const TextureMip& t_Image, bool t_CompactColor);
+
+		/**
+		 * @brief	Downsample with a box filter down to 1x1, the same chain that the runtime mip
+		 *			blits make. Normal maps are renormalized at every level.
+		 * @param t_Image	Full size level, which becomes the first level of the chain
+		 */
+		void GenerateMips(TextureMip t_Image, TextureUsage t_Usage, std::vector<TextureMip>& t_OutMips);
+
+		/**
+		 * @brief	Load a source image, build its mip chain, compress every level and write it out as
+		 *			a cooked .fltex file
+		 * @see		TextureFile
+		 */
+		bool Cook(const std::string& t_SourcePath, const std::string& t_CookedPath, TextureUsage t_Usage, bool t_CompactColor = false, TextureCookStats* t_OutStats = nullptr);
+
+	}   // namespace TextureImporter
+}   // namespace Fling
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "FlingVulkan.h"
+#include "FlingTypes.h"
+#include "RingAllocator.h"
+
+#include <memory>
+#include <mutex>
+#include <cstring>
+
+namespace Fling
+{
+    class Buffer;
+
+    /**
+     * @brief   A persistently mapped uniform buffer that per object uniforms are written into every
+     *          frame. Each object gets an aligned slice that is bound with a dynamic offset, so every
+     *          object can share one buffer and one descriptor set
+     *          (VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) instead of having their own.
+     *
+     *          Can also be created with other buffer usages for per frame data like instance buffers.
+     */
+    class UniformRingBuffer
+    {
+    public:
+
+        /**
+         * @param t_SizePerFrame    Max bytes of uniforms that can be written in a single frame
+         * @param t_FrameCount      Number of frames that the GPU could still be reading from
+         * @param t_Usage           Usage of the buffer. Slices are only aligned to the uniform offset 
+         *                          alignment if this has VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT
+         */
+        UniformRingBuffer(
+            VkDeviceSize t_SizePerFrame, 
+            UINT32 t_FrameCount = VkConfig::MAX_FRAMES_IN_FLIGHT,
+            VkBufferUsageFlags t_Usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+
+        ~UniformRingBuffer();
+
+        /** Call once at the start of every frame before allocating, frees the slices of the oldest frame */
+        void BeginFrame();
+
+        /**
+         * @brief   Allocate a slice of the buffer for this frame. Thread safe.
+         *
+         * @param t_Size                Size of the slice, rounded up to the uniform buffer offset alignment
+         * @param t_OutDynamicOffset    Offset to give to vkCmdBindDescriptorSets
+         * @return  Pointer to the mapped slice or nullptr if this frame is out of space
+         */
+        void* Allocate(VkDeviceSize t_Size, UINT32& t_OutDynamicOffset);
+
+        /** Copy the given uniform data into a new slice. Thread safe. @return False if out of space */
+        template<class T>
+        bool Push(const T& t_Data, UINT32& t_OutDynamicOffset);
+
+        /**
+         * @brief   Size that a slice could take up on any device, for sizing the ring before it exists.
+         *          256 is the largest minUniformBufferOffsetAlignment that the spec allows.
+         */
+        static constexpr VkDeviceSize MaxSliceSize(VkDeviceSize t_Size) { return (t_Size + 255) & ~VkDeviceSize(255); }
+
+        /** Round a size up to the min uniform buffer offset alignment of the device */
+        inline VkDeviceSize AlignSize(VkDeviceSize t_Size) const { return (t_Size + m_Alignment - 1) & ~(m_Alignment - 1); }
+
+        inline VkDeviceSize GetAlignment() const { return m_Alignment; }
+
+        inline Buffer* GetBuffer() const { return m_Buffer.get(); }
+
+        /**
+         * @brief   Get the buffer info for a dynamic uniform descriptor that reads t_Range bytes from
+         *          each slice. The returned pointer is valid until the next call.
+         */
+        VkDescriptorBufferInfo* GetDescriptorInfo(VkDeviceSize t_Range);
+
+    private:
+
+        std::unique_ptr<Buffer> m_Buffer;
+
+        RingAllocator m_Ring;
+
+        VkDeviceSize m_Alignment = 1;
+
+        VkDescriptorBufferInfo m_DescriptorInfo = {};
+
+        /** Command buffers are recorded on multiple threads, and each of them allocates slices */
+        std::mutex m_Mutex;
+    };
+
+    template<class T>
+    inline bool UniformRingBuffer::Push(const T& t_Data, UINT32& t_OutDynamicOffset)
+    {
+        void* Data = Allocate(sizeof(T), t_OutDynamicOffset);
+        if (!Data)
+        {
+            return false;
+        }
+        memcpy(Data, &t_Data, sizeof(T));
+        return true;
+    }
+}   // namespace Fling
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "FlingVulkan.h"
+#include "Buffer.h"
+#include "UploadContext.h"
+
+#include <vector>
+#include <memory>
+
+namespace Fling
+{
+	/**
+	 * @brief	A single submit worth of GPU uploads. Resources copy their data into the upload context's
+	 *			staging ring and record their copies into a batch, which keeps the staging memory in use
+	 *			until the GPU is done with it. Many resources can be uploaded with one submit and no queue wait.
+	 *
+	 *			Copies are recorded on the transfer queue when there is a dedicated one. Resources that the
+	 *			copies write to have to be handed over to the graphics queue with CopyBuffer or TransferImage,
+	 *			which record the queue family ownership transfers.
+	 *
+	 *			Batches must be created and submitted from the main thread because they share the upload
+	 *			context's command pools. @see UploadContext
+	 */
+	class UploadBatch
+	{
+	public:
+
+		/** Staging alignment that works for copies into buffers and into 4 byte or block compressed images */
+		static constexpr VkDeviceSize DefaultStagingAlignment = 16;
+
+		/** Allocate and begin recording the command buffers for this batch */
+		UploadBatch();
+
+		/** Waits for the batch if it was submitted and frees its staging memory */
+		~UploadBatch();
+
+		UploadBatch(const UploadBatch&) = delete;
+		UploadBatch& operator=(const UploadBatch&) = delete;
+
+		/** Copies are recorded here. Only transfer commands can be used on it */
+		FORCEINLINE VkCommandBuffer GetCommandBuffer() const { return m_CommandBuffer; }
+
+		/**
+		 * @brief	Runs on the graphics queue after every copy in this batch, for work like blitting mip maps.
+		 *			The same command buffer as GetCommandBuffer if there is no dedicated transfer queue.
+		 */
+		FORCEINLINE VkCommandBuffer GetGraphicsCommandBuffer() const { return m_GraphicsCommandBuffer; }
+
+		/**
+		 * @brief	Get staging memory that stays alive until this batch has finished executing. Write the
+		 *			data to upload to the returned pointer before submitting.
+		 * @param t_Alignment	Alignment of the offset, copies into images need a multiple of the texel size
+		 */
+		StagingAllocation AllocateStaging(VkDeviceSize t_Size, VkDeviceSize t_Alignment = DefaultStagingAlignment);
+
+		/** Allocate staging memory and copy the data into it */
+		StagingAllocation StageData(const void* t_Data, VkDeviceSize t_Size, VkDeviceSize t_Alignment = DefaultStagingAlignment);
+
+		/** Record a copy from staging memory to the start of the destination, and give the destination to the graphics queue */
+		void CopyBuffer(const StagingAllocation& t_Src, Buffer* t_DstBuffer, VkDeviceSize t_Size);
+
+		/**
+		 * @brief	Give an image that the copies wrote to to the graphics queue and move it into the layout it
+		 *			will be used in. Record this after the copies into the image, graphics command buffer
+		 *			work on the image has to come after it.
+		 */
+		void TransferImage(VkImage t_Image, VkImageLayout t_OldLayout, VkImageLayout t_NewLayout, UINT32 t_MipLevels = 1, UINT32 t_LayerCount = 1);
+
+		/** End recording and submit this batch */
+		void Submit();
+
+		/** True if this batch has been submitted and the GPU has finished executing it */
+		bool IsComplete() const;
+
+		/** Block until the GPU has finished executing this batch */
+		void Wait() const;
+
+		/** Submit this batch and block until it has finished */
+		void SubmitAndWait();
+
+		FORCEINLINE bool IsSubmitted() const { return m_IsSubmitted; }
+
+	private:
+
+		UploadContext* m_Context = nullptr;
+
+		/** Owner of this batch's staging memory in the ring */
+		UINT64 m_BatchId = 0;
+
+		VkCommandBuffer m_CommandBuffer = VK_NULL_HANDLE;
+
+		VkCommandBuffer m_GraphicsCommandBuffer = VK_NULL_HANDLE;
+
+		/** Signaled by the copies for the graphics queue to wait on, only used with a dedicated transfer queue */
+		VkSemaphore m_CopiesComplete = VK_NULL_HANDLE;
+
+		/** Signaled when everything in the batch has finished */
+		VkFence m_Fence = VK_NULL_HANDLE;
+
+		/** Uploads that didn't fit in the staging ring get a buffer of their own */
+		std::vector<std::unique_ptr<Buffer>> m_StagingBuffers;
+
+		bool m_IsSubmitted = false;
+	};
+}   // namespace Fling
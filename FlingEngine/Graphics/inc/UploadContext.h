@@ -0,0 +1,95 @@
+#pragma once
+
+#include "FlingTypes.h"
+#include "FlingVulkan.h"
+#include "BatchRingAllocator.h"
+
+namespace Fling
+{
+	class LogicalDevice;
+	class Buffer;
+
+	/** A range of staging memory that copies can read from */
+	struct StagingAllocation
+	{
+		VkBuffer Buffer = VK_NULL_HANDLE;
+
+		VkDeviceSize Offset = 0;
+
+		/** Mapped pointer to the start of the range, write the data to upload here */
+		void* Data = nullptr;
+	};
+
+	/**
+	 * @brief	Everything that upload batches share. Owns a persistently mapped staging ring that every
+	 *			batch copies out of, so uploading a resource doesn't need a buffer allocation of its own,
+	 *			and the command pools of the queues that uploads run on.
+	 *
+	 *			Copies go on the dedicated transfer queue when the logical device found one, anything that
+	 *			needs graphics (like blitting mip maps) runs after them on the graphics queue.
+	 *
+	 *			Main thread only, just like the batches. @see UploadBatch
+	 */
+	class UploadContext
+	{
+	public:
+
+		/** @param t_StagingSize	Size of the staging ring in bytes */
+		UploadContext(LogicalDevice* t_Device, VkDeviceSize t_StagingSize);
+
+		/** Every batch has to be destroyed before this */
+		~UploadContext();
+
+		UploadContext(const UploadContext&) = delete;
+		UploadContext& operator=(const UploadContext&) = delete;
+
+		/** Get a new ID for a batch to allocate staging memory with */
+		FORCEINLINE UINT64 BeginBatch() { return m_NextBatch++; }
+
+		/**
+		 * @brief	Take a range from the staging ring that stays in use until the batch is released
+		 * @param t_Alignment	Alignment of the offset, does not have to be a power of 2
+		 * @return	False if the ring doesn't have enough space left
+		 */
+		bool AllocateStaging(UINT64 t_Batch, VkDeviceSize t_Size, VkDeviceSize t_Alignment, StagingAllocation& t_OutAllocation);
+
+		/** Give back everything a batch took from the staging ring. Only call after the GPU is done with it */
+		void ReleaseBatch(UINT64 t_Batch);
+
+		FORCEINLINE bool HasTransferQueue() const { return m_TransferFamily != m_GraphicsFamily; }
+
+		FORCEINLINE UINT32 GetTransferFamily() const { return m_TransferFamily; }
+		FORCEINLINE UINT32 GetGraphicsFamily() const { return m_GraphicsFamily; }
+
+		FORCEINLINE VkQueue GetTransferQueue() const { return m_TransferQueue; }
+		FORCEINLINE VkQueue GetGraphicsQueue() const { return m_GraphicsQueue; }
+
+		/** The same pool as the graphics one if there is no dedicated transfer queue */
+		FORCEINLINE VkCommandPool GetTransferPool() const { return HasTransferQueue() ? m_TransferPool : m_GraphicsPool; }
+		FORCEINLINE VkCommandPool GetGraphicsPool() const { return m_GraphicsPool; }
+
+		FORCEINLINE VkDeviceSize GetStagingCapacity() const { return m_Ring.GetCapacity(); }
+		FORCEINLINE VkDeviceSize GetStagingUsedSize() const { return m_Ring.GetUsedSize(); }
+
+	private:
+
+		LogicalDevice* m_Device = nullptr;
+
+		/** Host visible and coherent, the allocator keeps it mapped */
+		Buffer* m_StagingBuffer = nullptr;
+
+		BatchRingAllocator m_Ring;
+
+		UINT64 m_NextBatch = 0;
+
+		UINT32 m_TransferFamily = 0;
+		UINT32 m_GraphicsFamily = 0;
+
+		VkQueue m_TransferQueue = VK_NULL_HANDLE;
+		VkQueue m_GraphicsQueue = VK_NULL_HANDLE;
+
+		/** Only created if there is a dedicated transfer queue */
+		VkCommandPool m_TransferPool = VK_NULL_HANDLE;
+		VkCommandPool m_GraphicsPool = VK_NULL_HANDLE;
+	};
+}   // namespace Fling
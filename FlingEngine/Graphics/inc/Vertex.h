@@ -2,8 +2,30 @@
 
 #include "FlingVulkan.h"
 
+#include <algorithm>
+
 namespace Fling
 {
+    /**
+    * Per instance data that instanced draws read from a second vertex binding
+    */
+    struct InstanceData
+    {
+        glm::mat4 Model {};
+    };
+
+    /**
+    * Layout of the vertices in a model's vertex buffer, which picks the pipeline it is drawn with
+    */
+    enum class VertexFormat : UINT32
+    {
+        /** Vertex, full precision floats */
+        Full = 0,
+
+        /** PackedVertex, quantized when the model is cooked. See VertexQuantization */
+        Packed = 1,
+    };
+
     /**
     * Basic Vertex outline for use with our vertex buffers
     */
@@ -17,7 +39,7 @@ namespace Fling
 
 		bool operator==(const Vertex& other) const 
 		{
-			return Pos == other.Pos && Color == other.Color && TexCoord == other.TexCoord && Tangent == other.Tangent;
+			return Pos == other.Pos && Color == other.Color && TexCoord == other.TexCoord && Tangent == other.Tangent && Normal == other.Normal;
 		}
 
 		/**
@@ -33,7 +55,7 @@ namespace Fling
             return bindingDescription;
         }
 
-		//#TODO Use shader reflection to get our bindings for this vertex instead
+		/** Everything a vertex can provide, GraphicsPipeline drops the attributes the shader does not read */
         static std::array<VkVertexInputAttributeDescription, 5> GetAttributeDescriptions()
         {
             std::array<VkVertexInputAttributeDescription, 5> attributeDescriptions = {};
@@ -66,7 +88,127 @@ namespace Fling
             return attributeDescriptions;
         }
 
+		/**
+		 * @brief	Gets the shader bindings of a vertex plus the per instance data on binding 1
+		 */
+		static std::array<VkVertexInputBindingDescription, 2> GetInstancedBindingDescriptions()
+		{
+			std::array<VkVertexInputBindingDescription, 2> bindingDescriptions = {};
+			bindingDescriptions[0] = GetBindingDescription();
+
+			bindingDescriptions[1].binding = 1;
+			bindingDescriptions[1].stride = sizeof(InstanceData);
+			bindingDescriptions[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+			return bindingDescriptions;
+		}
+
+		/**
+		 * @brief	Vertex attributes followed by the model matrix of the instance, which takes up
+		 *			one location for each column
+		 */
+		static std::array<VkVertexInputAttributeDescription, 9> GetInstancedAttributeDescriptions()
+		{
+			std::array<VkVertexInputAttributeDescription, 9> attributeDescriptions = {};
+			std::array<VkVertexInputAttributeDescription, 5> vertexAttributes = GetAttributeDescriptions();
+			std::copy(vertexAttributes.begin(), vertexAttributes.end(), attributeDescriptions.begin());
+
+			for (UINT32 i = 0; i < 4; ++i)
+			{
+				VkVertexInputAttributeDescription& column = attributeDescriptions[vertexAttributes.size() + i];
+				column.binding = 1;
+				column.location = static_cast<UINT32>(vertexAttributes.size()) + i;
+				column.format = VK_FORMAT_R32G32B32A32_SFLOAT;
+				column.offset = offsetof(InstanceData, Model) + sizeof(glm::vec4) * i;
+			}
+
+			return attributeDescriptions;
+		}
+
+    };
+
+    /**
+    * Quantized vertex for meshes that don't use vertex colors. Positions are 16 bit normalized
+    * inside the bounds of the mesh, normals and tangents are octahedral encoded and UVs are
+    * half floats. Locations match Vertex without the color, see mrt_instanced_packed.vert
+    */
+    struct PackedVertex
+    {
+        /** x, y and z relative to the mesh bounds, w is padding */
+        UINT16 Pos[4] {};
+        INT16 Normal[2] {};
+        INT16 Tangent[2] {};
+        UINT16 TexCoord[2] {};
+
+        static VkVertexInputBindingDescription GetBindingDescription()
+        {
+            VkVertexInputBindingDescription bindingDescription = {};
+            bindingDescription.binding = 0;
+            bindingDescription.stride = sizeof(PackedVertex);
+            bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+            return bindingDescription;
+        }
+
+        static std::array<VkVertexInputAttributeDescription, 4> GetAttributeDescriptions()
+        {
+            std::array<VkVertexInputAttributeDescription, 4> attributeDescriptions = {};
+
+            // 3 component 16 bit formats are not required to be supported for vertex buffers
+            attributeDescriptions[0].binding = 0;
+            attributeDescriptions[0].location = 0;
+            attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+            attributeDescriptions[0].offset = offsetof(PackedVertex, Pos);
+
+            attributeDescriptions[1].binding = 0;
+            attributeDescriptions[1].location = 2;
+            attributeDescriptions[1].format = VK_FORMAT_R16G16_SNORM;
+            attributeDescriptions[1].offset = offsetof(PackedVertex, Tangent);
+
+            attributeDescriptions[2].binding = 0;
+            attributeDescriptions[2].location = 3;
+            attributeDescriptions[2].format = VK_FORMAT_R16G16_SNORM;
+            attributeDescriptions[2].offset = offsetof(PackedVertex, Normal);
+
+            attributeDescriptions[3].binding = 0;
+            attributeDescriptions[3].location = 4;
+            attributeDescriptions[3].format = VK_FORMAT_R16G16_SFLOAT;
+            attributeDescriptions[3].offset = offsetof(PackedVertex, TexCoord);
+
+            return attributeDescriptions;
+        }
+
+        static std::array<VkVertexInputBindingDescription, 2> GetInstancedBindingDescriptions()
+        {
+            std::array<VkVertexInputBindingDescription, 2> bindingDescriptions = Vertex::GetInstancedBindingDescriptions();
+            bindingDescriptions[0] = GetBindingDescription();
+
+            return bindingDescriptions;
+        }
+
+        /**
+         * @brief	Packed vertex attributes followed by the model matrix of the instance on the
+         *			same locations that Vertex uses
+         */
+        static std::array<VkVertexInputAttributeDescription, 8> GetInstancedAttributeDescriptions()
+        {
+            std::array<VkVertexInputAttributeDescription, 8> attributeDescriptions = {};
+            std::array<VkVertexInputAttributeDescription, 4> vertexAttributes = GetAttributeDescriptions();
+            std::array<VkVertexInputAttributeDescription, 9> fullAttributes = Vertex::GetInstancedAttributeDescriptions();
+            std::copy(vertexAttributes.begin(), vertexAttributes.end(), attributeDescriptions.begin());
+            std::copy(fullAttributes.end() - 4, fullAttributes.end(), attributeDescriptions.begin() + vertexAttributes.size());
+
+            return attributeDescriptions;
+        }
     };
+
+    static_assert(sizeof(PackedVertex) == 20, "Packed vertices are uploaded as is, keep them tightly packed");
+
+    /** Size of a single vertex in a vertex buffer of the given format */
+    FORCEINLINE UINT32 GetVertexStride(VertexFormat t_Format)
+    {
+        return t_Format == VertexFormat::Packed ? sizeof(PackedVertex) : sizeof(Vertex);
+    }
 }   // namespace Fling
 
 // Hash function for a vertex so that we can put thing std::maps and what not
@@ -77,9 +219,10 @@ namespace std
 	{
 		size_t operator()(Fling::Vertex const& vertex) const
 		{
-			return	((hash<glm::vec3>()(vertex.Pos) ^
+			return	((((hash<glm::vec3>()(vertex.Pos) ^
 					(hash<glm::vec3>()(vertex.Color) << 1)) >> 1) ^
-					(hash<glm::vec2>()(vertex.TexCoord) << 1);
+					(hash<glm::vec2>()(vertex.TexCoord) << 1)) >> 1) ^
+					(hash<glm::vec3>()(vertex.Normal) << 1);
 		}
 	};
 }
\ No newline at end of file
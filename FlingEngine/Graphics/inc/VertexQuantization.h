@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Vertex.h"
+#include "Bounds.h"
+
+#include <vector>
+
+namespace Fling
+{
+	/**
+	 * @brief	Push constants of the packed vertex shaders that turn the 16 bit normalized
+	 *			positions back into model space. Position = Offset + Packed * Scale
+	 */
+	struct VertexDequantize
+	{
+		glm::vec4 Offset {};
+		glm::vec4 Scale { 1.0f };
+	};
+
+	/**
+	 * @brief	Encoding and decoding between Vertex and PackedVertex. Decoding matches what
+	 *			vertex fetch and mrt_instanced_packed.vert do on the GPU, so it is only needed
+	 *			to check the precision of a packed mesh on the CPU.
+	 */
+	namespace VertexQuantization
+	{
+		/** Round a float to the nearest half float, values out of range become infinity */
+		UINT16 FloatToHalf(float t_Value);
+
+		float HalfToFloat(UINT16 t_Half);
+
+		/** Project a unit vector onto an octahedron and unfold it into two 16 bit normalized values */
+		void EncodeOctahedral(const glm::vec3& t_Dir, INT16 t_OutOct[2]);
+
+		/** Unit vector of two 16 bit normalized octahedral values */
+		glm::vec3 DecodeOctahedral(const INT16 t_Oct[2]);
+
+		/** Map the bounds of a mesh to the 0 to 1 range of the packed positions */
+		VertexDequantize GetDequantize(const BoundingBox& t_Bounds);
+
+		/** Packed vertices have no color, so only meshes that leave every vertex white can use them */
+		bool CanPack(const std::vector<Vertex>& t_Verts);
+
+		PackedVertex Pack(const Vertex& t_Vert, const VertexDequantize& t_Dequantize);
+
+		/** The vertex as the packed shaders see it, with a white color */
+		Vertex Unpack(const PackedVertex& t_Vert, const VertexDequantize& t_Dequantize);
+
+		void PackVertices(const std::vector<Vertex>& t_Verts, const VertexDequantize& t_Dequantize, std::vector<PackedVertex>& t_OutVerts);
+
+	}   // namespace VertexQuantization
+}   // namespace Fling
@@ -30,6 +30,14 @@ namespace Fling
 	class FirstPersonCamera;
 	class DepthBuffer;
 	class BaseEditor;
+	class DeviceMemoryAllocator;
+	class FrustumCuller;
+	class OcclusionCuller;
+	class LodSelector;
+	class PipelineCacheManager;
+	class DescriptorLayoutCache;
+	class GpuFrameTimer;
+	class UploadContext;
 
 	/**
 	* @brief	Core rendering functionality of the Fling Engine. Controls what Render pipelines 
@@ -40,6 +48,14 @@ namespace Fling
     public:
 
 		void Init(PipelineFlags t_Conf, entt::registry& t_Reg, std::shared_ptr<Fling::BaseEditor> t_Editor);
+
+		/**
+		* @brief	Prepare the devices and per frame resources without a window, surface or swap chain.
+		*			Nothing can be presented, but subpasses can be created and record their command buffers.
+		*			Shutdown cleans up the same way as a normal Init
+		*/
+		void InitHeadless();
+
 		void Shutdown(entt::registry& t_Reg);
 
 		/** 
@@ -58,7 +74,18 @@ namespace Fling
 		inline LogicalDevice* GetLogicalDevice() const { return m_LogicalDevice; }
 		inline PhysicalDevice* GetPhysicalDevice() const { return m_PhysicalDevice; }
 		inline const VkCommandPool GetCommandPool() const { return m_CommandPool; }
+		inline DeviceMemoryAllocator* GetMemoryAllocator() const { return m_MemoryAllocator; }
 		inline FirstPersonCamera* GetCamera() const { return m_Camera; }
+		inline const FrustumCuller* GetFrustumCuller() const { return m_FrustumCuller; }
+		inline OcclusionCuller* GetOcclusionCuller() const { return m_OcclusionCuller; }
+		inline LodSelector* GetLodSelector() const { return m_LodSelector; }
+		inline const RenderPipeline* GetRenderPipeline() const { return m_RenderPipeline; }
+		inline PipelineCacheManager* GetPipelineCacheManager() const { return m_PipelineCache; }
+		inline DescriptorLayoutCache* GetLayoutCache() const { return m_LayoutCache; }
+		inline UploadContext* GetUploadContext() const { return m_UploadContext; }
+
+		/** Number of frames that the CPU can record ahead of the GPU. Per frame resources should have this many copies */
+		inline UINT32 GetFramesInFlight() const { return m_FramesInFlight; }
 
 	protected:
 		void Init() override {}
@@ -72,6 +99,12 @@ namespace Fling
 		*/
 		void Prepare();
 
+		/** Create the physical and logical devices along with the allocator and caches that every resource uses */
+		void PrepareDevices();
+
+		/** Create the command pool, frame sync, camera and culling that every frame in flight uses */
+		void PrepareFrameResources(float t_AspectRatio);
+
 		/**
 		* @breif	Create semaphores for available swap chain images and fences 
 		*			for the current frame in flight
@@ -103,6 +136,11 @@ namespace Fling
 		Instance* m_Instance = nullptr;
 		LogicalDevice* m_LogicalDevice = nullptr;
 		PhysicalDevice* m_PhysicalDevice = nullptr;
+		DeviceMemoryAllocator* m_MemoryAllocator = nullptr;
+		/** Every graphics pipeline is created with this cache, which is kept on disk between runs */
+		PipelineCacheManager* m_PipelineCache = nullptr;
+		/** Descriptor set and pipeline layouts built from shader reflection, shared between pipelines */
+		DescriptorLayoutCache* m_LayoutCache = nullptr;
 		FlingWindow* m_CurrentWindow = nullptr;
 		
 		// Swap chain related stuff ---------------------------------------------------------------------
@@ -119,7 +157,7 @@ namespace Fling
 		// Stages that the swap chain needs to wait on in order to present
 		VkPipelineStageFlags m_WaitStages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 
-		/** Keep a vector of command buffers that we want to use so that we can have one for each active frame */
+		/** Keep a vector of command buffers that we want to use so that we can have one for each frame in flight */
 		std::vector<CommandBuffer*> m_DrawCmdBuffers;
 
 		/** Synchronization primitives for drawing the frame. @see VulkanApp::CreateFrameSyncResources */
@@ -134,14 +172,31 @@ namespace Fling
 		and is updated every Update of the vulkan app. */
 		size_t CurrentFrameIndex = 0;
 
+		/** Set by FramesInFlight in the Vulkan config, up to VkConfig::MAX_FRAMES_IN_FLIGHT */
+		UINT32 m_FramesInFlight = 2;
+
+		/** Measures how long the GPU takes for each frame */
+		GpuFrameTimer* m_FrameTimer = nullptr;
+
 		// Command Buffer pool
 		VkCommandPool m_CommandPool = VK_NULL_HANDLE;
 
-		std::vector<RenderPipeline*> m_RenderPipelines;
+		/** Staging memory and queues that every upload batch uses */
+		UploadContext* m_UploadContext = nullptr;
+
+		/** Every subpass that draws a frame, ordered by its render graph */
+		RenderPipeline* m_RenderPipeline = nullptr;
 
 		/** The Vulkan app will specify the current camera and be limited to one for now */
 		FirstPersonCamera* m_Camera = nullptr;
 
-		// #TODO VMA Allocator
+		/** Finds the meshes that are visible to the camera before any subpass records commands */
+		FrustumCuller* m_FrustumCuller = nullptr;
+
+		/** Removes the meshes that passed frustum culling but are hidden behind big occluders */
+		OcclusionCuller* m_OcclusionCuller = nullptr;
+
+		/** Picks the level of detail that each visible mesh is drawn with */
+		LodSelector* m_LodSelector = nullptr;
     };
 }   // namespace Fling
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "pch.h"
+#include "BindlessMaterials.h"
+#include "Material.h"
+
+namespace Fling
+{
+	BindlessMaterialTable::BindlessMaterialTable(UINT32 t_MaxTextures, UINT32 t_MaxMaterials)
+		: m_MaxTextures(t_MaxTextures)
+		, m_MaxMaterials(t_MaxMaterials)
+	{
+		assert(m_MaxTextures > 0 && m_MaxMaterials > 0);
+	}
+
+	UINT32 BindlessMaterialTable::AddTexture(Texture* t_Texture)
+	{
+		assert(t_Texture);
+
+		auto It = m_TextureSlots.find(t_Texture);
+		if (It != m_TextureSlots.end())
+		{
+			return It->second;
+		}
+
+		if (m_Textures.size() >= m_MaxTextures)
+		{
+			F_LOG_WARN("Bindless texture array is full ({} textures), sampling slot 0 instead", m_MaxTextures);
+			return 0;
+		}
+
+		const UINT32 Slot = static_cast<UINT32>(m_Textures.size());
+		m_Textures.push_back(t_Texture);
+		m_TextureSlots.emplace(t_Texture, Slot);
+		return Slot;
+	}
+
+	UINT32 BindlessMaterialTable::AddMaterial(const Material* t_Mat, const PBRTextures& t_Textures)
+	{
+		auto It = m_MaterialIndices.find(t_Mat);
+		if (It != m_MaterialIndices.end())
+		{
+			return It->second;
+		}
+
+		if (m_Materials.size() >= m_MaxMaterials)
+		{
+			F_LOG_WARN("Bindless material buffer is full ({} materials), using material 0 instead", m_MaxMaterials);
+			return 0;
+		}
+
+		BindlessMaterialData Data = {};
+		Data.AlbedoIndex = AddTexture(t_Textures.m_AlbedoTexture);
+		Data.NormalIndex = AddTexture(t_Textures.m_NormalTexture);
+		Data.MetalIndex = AddTexture(t_Textures.m_MetalTexture);
+		Data.RoughnessIndex = AddTexture(t_Textures.m_RoughnessTexture);
+
+		const UINT32 Index = static_cast<UINT32>(m_Materials.size());
+		m_Materials.push_back(Data);
+		m_MaterialIndices.emplace(t_Mat, Index);
+		return Index;
+	}
+}   // namespace Fling
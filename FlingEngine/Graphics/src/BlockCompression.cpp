@@ -0,0 +1,860 @@
+#include "pch.h"
+#include "BlockCompression.h"
+#include "JobSystem.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace Fling
+{
+	namespace BlockCompression
+	{
+		namespace
+		{
+			/** Rows of blocks given to each job */
+			constexpr UINT32 RowGrain = 4;
+
+			/** Interpolation weights of the 4 bit BC7 indices, out of 64 */
+			constexpr UINT32 BC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+			/** Least squares refinement passes of the endpoints after the first guess */
+			constexpr UINT32 RefineIterations = 2;
+
+			/** Writes bits into a block from the least significant bit of the first byte up */
+			struct BitWriter
+			{
+				UINT8* Data;
+				UINT32 Pos = 0;
+
+				void Write(UINT32 t_Value, UINT32 t_Bits)
+				{
+					for (UINT32 i = 0; i < t_Bits; ++i, ++Pos)
+					{
+						if ((t_Value >> i) & 1)
+						{
+							Data[Pos >> 3] |= static_cast<UINT8>(1 << (Pos & 7));
+						}
+					}
+				}
+			};
+
+			struct BitReader
+			{
+				const UINT8* Data;
+				UINT32 Pos = 0;
+
+				UINT32 Read(UINT32 t_Bits)
+				{
+					UINT32 Value = 0;
+					for (UINT32 i = 0; i < t_Bits; ++i, ++Pos)
+					{
+						Value |= static_cast<UINT32>((Data[Pos >> 3] >> (Pos & 7)) & 1) << i;
+					}
+					return Value;
+				}
+			};
+
+			/**
+			 * @brief	Mean and direction of the most variance of the first Dims channels of the pixels,
+			 *			found with a few power iterations on the covariance
+			 */
+			template<UINT32 Dims>
+			void PrincipalAxis(const UINT8 t_Pixels[64], float t_OutMean[Dims], float t_OutAxis[Dims])
+			{
+				for (UINT32 c = 0; c < Dims; ++c)
+				{
+					float Sum = 0.0f;
+					for (UINT32 i = 0; i < 16; ++i)
+					{
+						Sum += t_Pixels[i * 4 + c];
+					}
+					t_OutMean[c] = Sum / 16.0f;
+				}
+
+				float Covariance[Dims][Dims] = {};
+				for (UINT32 i = 0; i < 16; ++i)
+				{
+					float Delta[Dims];
+					for (UINT32 c = 0; c < Dims; ++c)
+					{
+						Delta[c] = t_Pixels[i * 4 + c] - t_OutMean[c];
+					}
+					for (UINT32 a = 0; a < Dims; ++a)
+					{
+						for (UINT32 b = 0; b < Dims; ++b)
+						{
+							Covariance[a][b] += Delta[a] * Delta[b];
+						}
+					}
+				}
+
+				for (UINT32 c = 0; c < Dims; ++c)
+				{
+					t_OutAxis[c] = 1.0f;
+				}
+				for (UINT32 Iteration = 0; Iteration < 8; ++Iteration)
+				{
+					float Next[Dims] = {};
+					float Length = 0.0f;
+					for (UINT32 a = 0; a < Dims; ++a)
+					{
+						for (UINT32 b = 0; b < Dims; ++b)
+						{
+							Next[a] += Covariance[a][b] * t_OutAxis[b];
+						}
+						Length = std::max(Length, std::abs(Next[a]));
+					}
+
+					// Flat blocks have no axis, any direction will do
+					if (Length <= 0.0f)
+					{
+						return;
+					}
+					for (UINT32 c = 0; c < Dims; ++c)
+					{
+						t_OutAxis[c] = Next[c] / Length;
+					}
+				}
+			}
+
+			/**
+			 * @brief	Fit the two endpoints to the pixels with the given weights of the second endpoint,
+			 *			which minimizes the squared error for those weights
+			 * @return	False if every pixel has the same weight and the endpoints can't be solved for
+			 */
+			template<UINT32 Dims>
+			bool LeastSquaresEndpoints(const UINT8 t_Pixels[64], const float t_Weights[16], float t_OutE0[Dims], float t_OutE1[Dims])
+			{
+				float AA = 0.0f;
+				float AB = 0.0f;
+				float BB = 0.0f;
+				float AX[Dims] = {};
+				float BX[Dims] = {};
+				for (UINT32 i = 0; i < 16; ++i)
+				{
+					const float B = t_Weights[i];
+					const float A = 1.0f - B;
+					AA += A * A;
+					AB += A * B;
+					BB += B * B;
+					for (UINT32 c = 0; c < Dims; ++c)
+					{
+						AX[c] += A * t_Pixels[i * 4 + c];
+						BX[c] += B * t_Pixels[i * 4 + c];
+					}
+				}
+
+				const float Det = AA * BB - AB * AB;
+				if (std::abs(Det) < 1e-6f)
+				{
+					return false;
+				}
+				for (UINT32 c = 0; c < Dims; ++c)
+				{
+					t_OutE0[c] = (AX[c] * BB - BX[c] * AB) / Det;
+					t_OutE1[c] = (BX[c] * AA - AX[c] * AB) / Det;
+				}
+				return true;
+			}
+
+			// BC1 ------------------------------------------------------------------------
+
+			UINT16 To565(const float t_Color[3])
+			{
+				const UINT32 R = static_cast<UINT32>(glm::clamp(t_Color[0] * 31.0f / 255.0f + 0.5f, 0.0f, 31.0f));
+				const UINT32 G = static_cast<UINT32>(glm::clamp(t_Color[1] * 63.0f / 255.0f + 0.5f, 0.0f, 63.0f));
+				const UINT32 B = static_cast<UINT32>(glm::clamp(t_Color[2] * 31.0f / 255.0f + 0.5f, 0.0f, 31.0f));
+				return static_cast<UINT16>((R << 11) | (G << 5) | B);
+			}
+
+			void From565(UINT16 t_Color, UINT32 t_Out[3])
+			{
+				const UINT32 R = (t_Color >> 11) & 31;
+				const UINT32 G = (t_Color >> 5) & 63;
+				const UINT32 B = t_Color & 31;
+				t_Out[0] = (R << 3) | (R >> 2);
+				t_Out[1] = (G << 2) | (G >> 4);
+				t_Out[2] = (B << 3) | (B >> 2);
+			}
+
+			/** The colors that the indices of a BC1 block pick from. The 4th color is transparent black in 3 color mode */
+			void BC1Palette(UINT16 t_C0, UINT16 t_C1, UINT32 t_Out[4][4])
+			{
+				From565(t_C0, t_Out[0]);
+				From565(t_C1, t_Out[1]);
+				t_Out[0][3] = t_Out[1][3] = 255;
+				for (UINT32 c = 0; c < 3; ++c)
+				{
+					if (t_C0 > t_C1)
+					{
+						t_Out[2][c] = (2 * t_Out[0][c] + t_Out[1][c] + 1) / 3;
+						t_Out[3][c] = (t_Out[0][c] + 2 * t_Out[1][c] + 1) / 3;
+					}
+					else
+					{
+						t_Out[2][c] = (t_Out[0][c] + t_Out[1][c] + 1) / 2;
+						t_Out[3][c] = 0;
+					}
+				}
+				t_Out[2][3] = 255;
+				t_Out[3][3] = t_C0 > t_C1 ? 255 : 0;
+			}
+
+			/** Pick the closest palette color for every pixel, returning the total squared error */
+			UINT32 BC1Indices(const UINT8 t_Pixels[64], UINT16 t_C0, UINT16 t_C1, UINT32& t_OutIndices)
+			{
+				UINT32 Palette[4][4];
+				BC1Palette(t_C0, t_C1, Palette);
+
+				// 3 color mode is only used for solid blocks, where index 0 is exact
+				const UINT32 PaletteSize = t_C0 > t_C1 ? 4 : 1;
+
+				UINT32 Error = 0;
+				t_OutIndices = 0;
+				for (UINT32 i = 0; i < 16; ++i)
+				{
+					UINT32 Best = 0;
+					UINT32 BestError = std::numeric_limits<UINT32>::max();
+					for (UINT32 p = 0; p < PaletteSize; ++p)
+					{
+						UINT32 PixelError = 0;
+						for (UINT32 c = 0; c < 3; ++c)
+						{
+							const INT32 Delta = static_cast<INT32>(t_Pixels[i * 4 + c]) - static_cast<INT32>(Palette[p][c]);
+							PixelError += static_cast<UINT32>(Delta * Delta);
+						}
+						if (PixelError < BestError)
+						{
+							BestError = PixelError;
+							Best = p;
+						}
+					}
+					t_OutIndices |= Best << (i * 2);
+					Error += BestError;
+				}
+				return Error;
+			}
+
+			void EncodeBC1(const UINT8 t_Pixels[64], UINT8 t_Out[8])
+			{
+				float Mean[3];
+				float Axis[3];
+				PrincipalAxis<3>(t_Pixels, Mean, Axis);
+
+				float MinT = std::numeric_limits<float>::max();
+				float MaxT = -std::numeric_limits<float>::max();
+				const float AxisLengthSq = Axis[0] * Axis[0] + Axis[1] * Axis[1] + Axis[2] * Axis[2];
+				for (UINT32 i = 0; i < 16; ++i)
+				{
+					float T = 0.0f;
+					for (UINT32 c = 0; c < 3; ++c)
+					{
+						T += (t_Pixels[i * 4 + c] - Mean[c]) * Axis[c];
+					}
+					T /= AxisLengthSq;
+					MinT = std::min(MinT, T);
+					MaxT = std::max(MaxT, T);
+				}
+
+				// Pull the ends in a little, the extremes are better served by the interpolated colors
+				const float Inset = (MaxT - MinT) / 16.0f;
+				float E0[3];
+				float E1[3];
+				for (UINT32 c = 0; c < 3; ++c)
+				{
+					E0[c] = Mean[c] + (MaxT - Inset) * Axis[c];
+					E1[c] = Mean[c] + (MinT + Inset) * Axis[c];
+				}
+
+				UINT16 BestC0 = 0;
+				UINT16 BestC1 = 0;
+				UINT32 BestIndices = 0;
+				UINT32 BestError = std::numeric_limits<UINT32>::max();
+				for (UINT32 Iteration = 0; Iteration <= RefineIterations; ++Iteration)
+				{
+					UINT16 C0 = To565(E0);
+					UINT16 C1 = To565(E1);
+					if (C0 < C1)
+					{
+						std::swap(C0, C1);
+					}
+
+					UINT32 Indices = 0;
+					const UINT32 Error = BC1Indices(t_Pixels, C0, C1, Indices);
+					if (Error < BestError)
+					{
+						BestError = Error;
+						BestC0 = C0;
+						BestC1 = C1;
+						BestIndices = Indices;
+					}
+					if (BestError == 0 || C0 == C1)
+					{
+						break;
+					}
+
+					// Refit the endpoints to the indices that were picked
+					static const float IndexWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+					float Weights[16];
+					for (UINT32 i = 0; i < 16; ++i)
+					{
+						Weights[i] = IndexWeights[(Indices >> (i * 2)) & 3];
+					}
+					if (!LeastSquaresEndpoints<3>(t_Pixels, Weights, E0, E1))
+					{
+						break;
+					}
+				}
+
+				t_Out[0] = static_cast<UINT8>(BestC0 & 0xFF);
+				t_Out[1] = static_cast<UINT8>(BestC0 >> 8);
+				t_Out[2] = static_cast<UINT8>(BestC1 & 0xFF);
+				t_Out[3] = static_cast<UINT8>(BestC1 >> 8);
+				std::memcpy(t_Out + 4, &BestIndices, sizeof(BestIndices));
+			}
+
+			void DecodeBC1(const UINT8 t_Block[8], UINT8 t_OutPixels[64])
+			{
+				const UINT16 C0 = static_cast<UINT16>(t_Block[0] | (t_Block[1] << 8));
+				const UINT16 C1 = static_cast<UINT16>(t_Block[2] | (t_Block[3] << 8));
+				UINT32 Palette[4][4];
+				BC1Palette(C0, C1, Palette);
+
+				UINT32 Indices = 0;
+				std::memcpy(&Indices, t_Block + 4, sizeof(Indices));
+				for (UINT32 i = 0; i < 16; ++i)
+				{
+					const UINT32 Index = (Indices >> (i * 2)) & 3;
+					for (UINT32 c = 0; c < 4; ++c)
+					{
+						t_OutPixels[i * 4 + c] = static_cast<UINT8>(Palette[Index][c]);
+					}
+				}
+			}
+
+			// BC4 ------------------------------------------------------------------------
+
+			/** 8 interpolated values when R0 > R1, otherwise 6 and then 0 and 255 */
+			void BC4Palette(UINT32 t_R0, UINT32 t_R1, UINT32 t_Out[8])
+			{
+				t_Out[0] = t_R0;
+				t_Out[1] = t_R1;
+				if (t_R0 > t_R1)
+				{
+					for (UINT32 i = 1; i < 7; ++i)
+					{
+						t_Out[i + 1] = ((7 - i) * t_R0 + i * t_R1 + 3) / 7;
+					}
+				}
+				else
+				{
+					for (UINT32 i = 1; i < 5; ++i)
+					{
+						t_Out[i + 1] = ((5 - i) * t_R0 + i * t_R1 + 2) / 5;
+					}
+					t_Out[6] = 0;
+					t_Out[7] = 255;
+				}
+			}
+
+			/** Pick the closest palette value for every pixel, returning the total squared error */
+			UINT32 BC4Indices(const UINT8 t_Pixels[64], UINT32 t_Channel, UINT32 t_R0, UINT32 t_R1, UINT64& t_OutIndices)
+			{
+				UINT32 Palette[8];
+				BC4Palette(t_R0, t_R1, Palette);
+
+				UINT32 Error = 0;
+				t_OutIndices = 0;
+				for (UINT32 i = 0; i < 16; ++i)
+				{
+					const INT32 Value = t_Pixels[i * 4 + t_Channel];
+					UINT64 Best = 0;
+					INT32 BestError = std::numeric_limits<INT32>::max();
+					for (UINT32 p = 0; p < 8; ++p)
+					{
+						const INT32 Delta = Value - static_cast<INT32>(Palette[p]);
+						if (Delta * Delta < BestError)
+						{
+							BestError = Delta * Delta;
+							Best = p;
+						}
+					}
+					t_OutIndices |= Best << (i * 3);
+					Error += static_cast<UINT32>(BestError);
+				}
+				return Error;
+			}
+
+			void EncodeBC4(const UINT8 t_Pixels[64], UINT32 t_Channel, UINT8 t_Out[8])
+			{
+				UINT32 Min = 255;
+				UINT32 Max = 0;
+				for (UINT32 i = 0; i < 16; ++i)
+				{
+					Min = std::min<UINT32>(Min, t_Pixels[i * 4 + t_Channel]);
+					Max = std::max<UINT32>(Max, t_Pixels[i * 4 + t_Channel]);
+				}
+
+				UINT32 BestR0 = Max;
+				UINT32 BestR1 = Min;
+				UINT64 BestIndices = 0;
+				UINT32 BestError = BC4Indices(t_Pixels, t_Channel, Max, Min, BestIndices);
+				UINT64 Indices = BestIndices;
+				for (UINT32 Iteration = 0; Iteration < RefineIterations && BestError > 0; ++Iteration)
+				{
+					// Refit the endpoints to the indices that were picked, 0 and 1 are the ends and the rest are in sevenths
+					float Weights[16];
+					for (UINT32 i = 0; i < 16; ++i)
+					{
+						const UINT32 Index = static_cast<UINT32>(Indices >> (i * 3)) & 7;
+						Weights[i] = Index < 2 ? static_cast<float>(Index) : (Index - 1) / 7.0f;
+					}
+
+					float E0[1];
+					float E1[1];
+					if (!LeastSquaresEndpoints<1>(t_Pixels + t_Channel, Weights, E0, E1))
+					{
+						break;
+					}
+
+					UINT32 R0 = static_cast<UINT32>(glm::clamp(E0[0] + 0.5f, 0.0f, 255.0f));
+					UINT32 R1 = static_cast<UINT32>(glm::clamp(E1[0] + 0.5f, 0.0f, 255.0f));
+					if (R0 < R1)
+					{
+						std::swap(R0, R1);
+					}
+					if (R0 == R1)
+					{
+						break;
+					}
+
+					const UINT32 Error = BC4Indices(t_Pixels, t_Channel, R0, R1, Indices);
+					if (Error >= BestError)
+					{
+						break;
+					}
+					BestError = Error;
+					BestR0 = R0;
+					BestR1 = R1;
+					BestIndices = Indices;
+				}
+
+				t_Out[0] = static_cast<UINT8>(BestR0);
+				t_Out[1] = static_cast<UINT8>(BestR1);
+				for (UINT32 b = 0; b < 6; ++b)
+				{
+					t_Out[2 + b] = static_cast<UINT8>(BestIndices >> (b * 8));
+				}
+			}
+
+			void DecodeBC4(const UINT8 t_Block[8], UINT32 t_Channel, UINT8 t_OutPixels[64])
+			{
+				UINT32 Palette[8];
+				BC4Palette(t_Block[0], t_Block[1], Palette);
+
+				UINT64 Indices = 0;
+				for (UINT32 b = 0; b < 6; ++b)
+				{
+					Indices |= static_cast<UINT64>(t_Block[2 + b]) << (b * 8);
+				}
+				for (UINT32 i = 0; i < 16; ++i)
+				{
+					t_OutPixels[i * 4 + t_Channel] = static_cast<UINT8>(Palette[(Indices >> (i * 3)) & 7]);
+				}
+			}
+
+			// BC7 mode 6 -----------------------------------------------------------------
+
+			/** 7 bit endpoints with a shared low bit per endpoint, expanded to 8 bits */
+			struct BC7Endpoints
+			{
+				UINT8 E0[4];
+				UINT8 E1[4];
+				UINT32 P0;
+				UINT32 P1;
+				UINT8 Indices[16];
+			};
+
+			void QuantizeBC7(const float t_E0[4], const float t_E1[4], UINT32 t_P0, UINT32 t_P1, BC7Endpoints& t_Out)
+			{
+				t_Out.P0 = t_P0;
+				t_Out.P1 = t_P1;
+				for (UINT32 c = 0; c < 4; ++c)
+				{
+					const UINT32 Q0 = static_cast<UINT32>(glm::clamp((t_E0[c] - t_P0) / 2.0f + 0.5f, 0.0f, 127.0f));
+					const UINT32 Q1 = static_cast<UINT32>(glm::clamp((t_E1[c] - t_P1) / 2.0f + 0.5f, 0.0f, 127.0f));
+					t_Out.E0[c] = static_cast<UINT8>((Q0 << 1) | t_P0);
+					t_Out.E1[c] = static_cast<UINT8>((Q1 << 1) | t_P1);
+				}
+			}
+
+			void BC7Palette(const UINT8 t_E0[4], const UINT8 t_E1[4], UINT32 t_Out[16][4])
+			{
+				for (UINT32 i = 0; i < 16; ++i)
+				{
+					for (UINT32 c = 0; c < 4; ++c)
+					{
+						t_Out[i][c] = ((64 - BC7Weights[i]) * t_E0[c] + BC7Weights[i] * t_E1[c] + 32) >> 6;
+					}
+				}
+			}
+
+			UINT32 PaletteError(const UINT8* t_Pixel, const UINT32 t_Color[4])
+			{
+				UINT32 Error = 0;
+				for (UINT32 c = 0; c < 4; ++c)
+				{
+					const INT32 Delta = static_cast<INT32>(t_Pixel[c]) - static_cast<INT32>(t_Color[c]);
+					Error += static_cast<UINT32>(Delta * Delta);
+				}
+				return Error;
+			}
+
+			/**
+			 * @brief	Pick the closest palette color for every pixel, returning the total squared error.
+			 *			The palette is a line, so only the entries next to the pixel's projection onto it
+			 *			need to be checked.
+			 */
+			UINT32 BC7Indices(const UINT8 t_Pixels[64], BC7Endpoints& t_Endpoints)
+			{
+				UINT32 Palette[16][4];
+				BC7Palette(t_Endpoints.E0, t_Endpoints.E1, Palette);
+
+				INT32 Dir[4];
+				INT32 LengthSq = 0;
+				for (UINT32 c = 0; c < 4; ++c)
+				{
+					Dir[c] = static_cast<INT32>(t_Endpoints.E1[c]) - static_cast<INT32>(t_Endpoints.E0[c]);
+					LengthSq += Dir[c] * Dir[c];
+				}
+
+				UINT32 Error = 0;
+				for (UINT32 i = 0; i < 16; ++i)
+				{
+					const UINT8* Pixel = t_Pixels + i * 4;
+
+					UINT32 Guess = 0;
+					if (LengthSq > 0)
+					{
+						INT32 Dot = 0;
+						for (UINT32 c = 0; c < 4; ++c)
+						{
+							Dot += (static_cast<INT32>(Pixel[c]) - static_cast<INT32>(t_Endpoints.E0[c])) * Dir[c];
+						}
+						const float Weight = glm::clamp(static_cast<float>(Dot) / LengthSq, 0.0f, 1.0f) * 15.0f;
+						Guess = static_cast<UINT32>(Weight + 0.5f);
+					}
+
+					UINT32 Best = Guess;
+					UINT32 BestError = PaletteError(Pixel, Palette[Guess]);
+					const UINT32 First = Guess > 0 ? Guess - 1 : 0;
+					const UINT32 Last = std::min(Guess + 1, 15u);
+					for (UINT32 p = First; p <= Last; ++p)
+					{
+						const UINT32 PixelError = PaletteError(Pixel, Palette[p]);
+						if (PixelError < BestError)
+						{
+							BestError = PixelError;
+							Best = p;
+						}
+					}
+					t_Endpoints.Indices[i] = static_cast<UINT8>(Best);
+					Error += BestError;
+				}
+				return Error;
+			}
+
+			/** Try every combination of the shared low bits and keep the best one */
+			UINT32 FitBC7(const UINT8 t_Pixels[64], const float t_E0[4], const float t_E1[4], BC7Endpoints& t_Best, UINT32 t_BestError)
+			{
+				for (UINT32 P = 0; P < 4; ++P)
+				{
+					BC7Endpoints Candidate;
+					QuantizeBC7(t_E0, t_E1, P & 1, P >> 1, Candidate);
+					const UINT32 Error = BC7Indices(t_Pixels, Candidate);
+					if (Error < t_BestError)
+					{
+						t_BestError = Error;
+						t_Best = Candidate;
+					}
+				}
+				return t_BestError;
+			}
+
+			void EncodeBC7(const UINT8 t_Pixels[64], UINT8 t_Out[16])
+			{
+				float Mean[4];
+				float Axis[4];
+				PrincipalAxis<4>(t_Pixels, Mean, Axis);
+
+				float MinT = std::numeric_limits<float>::max();
+				float MaxT = -std::numeric_limits<float>::max();
+				const float AxisLengthSq = Axis[0] * Axis[0] + Axis[1] * Axis[1] + Axis[2] * Axis[2] + Axis[3] * Axis[3];
+				for (UINT32 i = 0; i < 16; ++i)
+				{
+					float T = 0.0f;
+					for (UINT32 c = 0; c < 4; ++c)
+					{
+						T += (t_Pixels[i * 4 + c] - Mean[c]) * Axis[c];
+					}
+					T /= AxisLengthSq;
+					MinT = std::min(MinT, T);
+					MaxT = std::max(MaxT, T);
+				}
+
+				float E0[4];
+				float E1[4];
+				for (UINT32 c = 0; c < 4; ++c)
+				{
+					E0[c] = Mean[c] + MinT * Axis[c];
+					E1[c] = Mean[c] + MaxT * Axis[c];
+				}
+
+				BC7Endpoints Best = {};
+				UINT32 BestError = FitBC7(t_Pixels, E0, E1, Best, std::numeric_limits<UINT32>::max());
+				for (UINT32 Iteration = 0; Iteration < RefineIterations && BestError > 0; ++Iteration)
+				{
+					float Weights[16];
+					for (UINT32 i = 0; i < 16; ++i)
+					{
+						Weights[i] = BC7Weights[Best.Indices[i]] / 64.0f;
+					}
+					if (!LeastSquaresEndpoints<4>(t_Pixels, Weights, E0, E1))
+					{
+						break;
+					}
+					BestError = FitBC7(t_Pixels, E0, E1, Best, BestError);
+				}
+
+				// The top bit of the first index is implied to be 0, so swap the ends if it isn't
+				if (Best.Indices[0] & 8)
+				{
+					std::swap(Best.E0, Best.E1);
+					std::swap(Best.P0, Best.P1);
+					for (UINT8& Index : Best.Indices)
+					{
+						Index = static_cast<UINT8>(15 - Index);
+					}
+				}
+
+				std::memset(t_Out, 0, 16);
+				BitWriter Writer { t_Out };
+				Writer.Write(1 << 6, 7);
+				for (UINT32 c = 0; c < 4; ++c)
+				{
+					Writer.Write(Best.E0[c] >> 1, 7);
+					Writer.Write(Best.E1[c] >> 1, 7);
+				}
+				Writer.Write(Best.P0, 1);
+				Writer.Write(Best.P1, 1);
+				Writer.Write(Best.Indices[0], 3);
+				for (UINT32 i = 1; i < 16; ++i)
+				{
+					Writer.Write(Best.Indices[i], 4);
+				}
+			}
+
+			void DecodeBC7(const UINT8 t_Block[16], UINT8 t_OutPixels[64])
+			{
+				BitReader Reader { t_Block };
+				if (Reader.Read(7) != (1 << 6))
+				{
+					// Not a mode 6 block, which the encoder never writes
+					std::memset(t_OutPixels, 0, 64);
+					return;
+				}
+
+				UINT8 E0[4];
+				UINT8 E1[4];
+				for (UINT32 c = 0; c < 4; ++c)
+				{
+					E0[c] = static_cast<UINT8>(Reader.Read(7) << 1);
+					E1[c] = static_cast<UINT8>(Reader.Read(7) << 1);
+				}
+				const UINT32 P0 = Reader.Read(1);
+				const UINT32 P1 = Reader.Read(1);
+				for (UINT32 c = 0; c < 4; ++c)
+				{
+					E0[c] |= P0;
+					E1[c] |= P1;
+				}
+
+				UINT32 Palette[16][4];
+				BC7Palette(E0, E1, Palette);
+				for (UINT32 i = 0; i < 16; ++i)
+				{
+					const UINT32 Index = Reader.Read(i == 0 ? 3 : 4);
+					for (UINT32 c = 0; c < 4; ++c)
+					{
+						t_OutPixels[i * 4 + c] = static_cast<UINT8>(Palette[Index][c]);
+					}
+				}
+			}
+		}
+
+		UINT32 GetBlockSize(BlockFormat t_Format)
+		{
+			return (t_Format == BlockFormat::BC1 || t_Format == BlockFormat::BC4) ? 8 : 16;
+		}
+
+		const char* GetFormatName(BlockFormat t_Format)
+		{
+			switch (t_Format)
+			{
+			case BlockFormat::BC1:	return "BC1";
+			case BlockFormat::BC3:	return "BC3";
+			case BlockFormat::BC4:	return "BC4";
+			case BlockFormat::BC5:	return "BC5";
+			case BlockFormat::BC7:	return "BC7";
+			}
+			return "Unknown";
+		}
+
+		UINT32 GetChannelCount(BlockFormat t_Format)
+		{
+			switch (t_Format)
+			{
+			case BlockFormat::BC1:	return 3;
+			case BlockFormat::BC4:	return 1;
+			case BlockFormat::BC5:	return 2;
+			default:				return 4;
+			}
+		}
+
+		UINT64 GetCompressedSize(BlockFormat t_Format, UINT32 t_Width, UINT32 t_Height)
+		{
+			const UINT64 BlocksX = (t_Width + BlockDim - 1) / BlockDim;
+			const UINT64 BlocksY = (t_Height + BlockDim - 1) / BlockDim;
+			return BlocksX * BlocksY * GetBlockSize(t_Format);
+		}
+
+		void EncodeBlock(BlockFormat t_Format, const UINT8 t_Pixels[64], UINT8* t_OutBlock)
+		{
+			switch (t_Format)
+			{
+			case BlockFormat::BC1:
+				EncodeBC1(t_Pixels, t_OutBlock);
+				break;
+			case BlockFormat::BC3:
+				EncodeBC4(t_Pixels, 3, t_OutBlock);
+				EncodeBC1(t_Pixels, t_OutBlock + 8);
+				break;
+			case BlockFormat::BC4:
+				EncodeBC4(t_Pixels, 0, t_OutBlock);
+				break;
+			case BlockFormat::BC5:
+				EncodeBC4(t_Pixels, 0, t_OutBlock);
+				EncodeBC4(t_Pixels, 1, t_OutBlock + 8);
+				break;
+			case BlockFormat::BC7:
+				EncodeBC7(t_Pixels, t_OutBlock);
+				break;
+			}
+		}
+
+		void DecodeBlock(BlockFormat t_Format, const UINT8* t_Block, UINT8 t_OutPixels[64])
+		{
+			// Channels that the format doesn't have read as 0, with an opaque alpha
+			for (UINT32 i = 0; i < 16; ++i)
+			{
+				t_OutPixels[i * 4 + 0] = t_OutPixels[i * 4 + 1] = t_OutPixels[i * 4 + 2] = 0;
+				t_OutPixels[i * 4 + 3] = 255;
+			}
+
+			switch (t_Format)
+			{
+			case BlockFormat::BC1:
+				DecodeBC1(t_Block, t_OutPixels);
+				break;
+			case BlockFormat::BC3:
+				DecodeBC1(t_Block + 8, t_OutPixels);
+				DecodeBC4(t_Block, 3, t_OutPixels);
+				break;
+			case BlockFormat::BC4:
+				DecodeBC4(t_Block, 0, t_OutPixels);
+				break;
+			case BlockFormat::BC5:
+				DecodeBC4(t_Block, 0, t_OutPixels);
+				DecodeBC4(t_Block + 8, 1, t_OutPixels);
+				break;
+			case BlockFormat::BC7:
+				DecodeBC7(t_Block, t_OutPixels);
+				break;
+			}
+		}
+
+		void CompressImage(BlockFormat t_Format, const UINT8* t_Pixels, UINT32 t_Width, UINT32 t_Height, std::vector<UINT8>& t_OutBlocks)
+		{
+			const UINT32 BlocksX = (t_Width + BlockDim - 1) / BlockDim;
+			const UINT32 BlocksY = (t_Height + BlockDim - 1) / BlockDim;
+			const UINT32 BlockSize = GetBlockSize(t_Format);
+			t_OutBlocks.assign(static_cast<size_t>(BlocksX) * BlocksY * BlockSize, 0);
+
+			JobSystem::ParallelFor(BlocksY, RowGrain, [&](UINT32 t_Begin, UINT32 t_End)
+			{
+				UINT8 Block[64];
+				for (UINT32 by = t_Begin; by < t_End; ++by)
+				{
+					for (UINT32 bx = 0; bx < BlocksX; ++bx)
+					{
+						for (UINT32 y = 0; y < BlockDim; ++y)
+						{
+							const UINT32 SourceY = std::min(by * BlockDim + y, t_Height - 1);
+							for (UINT32 x = 0; x < BlockDim; ++x)
+							{
+								const UINT32 SourceX = std::min(bx * BlockDim + x, t_Width - 1);
+								std::memcpy(Block + (y * BlockDim + x) * 4, t_Pixels + (static_cast<size_t>(SourceY) * t_Width + SourceX) * 4, 4);
+							}
+						}
+						EncodeBlock(t_Format, Block, t_OutBlocks.data() + (static_cast<size_t>(by) * BlocksX + bx) * BlockSize);
+					}
+				}
+			});
+		}
+
+		void DecompressImage(BlockFormat t_Format, const UINT8* t_Blocks, UINT32 t_Width, UINT32 t_Height, std::vector<UINT8>& t_OutPixels)
+		{
+			const UINT32 BlocksX = (t_Width + BlockDim - 1) / BlockDim;
+			const UINT32 BlocksY = (t_Height + BlockDim - 1) / BlockDim;
+			const UINT32 BlockSize = GetBlockSize(t_Format);
+			t_OutPixels.resize(static_cast<size_t>(t_Width) * t_Height * 4);
+
+			UINT8 Block[64];
+			for (UINT32 by = 0; by < BlocksY; ++by)
+			{
+				for (UINT32 bx = 0; bx < BlocksX; ++bx)
+				{
+					DecodeBlock(t_Format, t_Blocks + (static_cast<size_t>(by) * BlocksX + bx) * BlockSize, Block);
+					for (UINT32 y = 0; y < BlockDim && by * BlockDim + y < t_Height; ++y)
+					{
+						for (UINT32 x = 0; x < BlockDim && bx * BlockDim + x < t_Width; ++x)
+						{
+							std::memcpy(t_OutPixels.data() + (static_cast<size_t>(by * BlockDim + y) * t_Width + bx * BlockDim + x) * 4, Block + (y * BlockDim + x) * 4, 4);
+						}
+					}
+				}
+			}
+		}
+
+		double ComputePSNR(const UINT8* t_A, const UINT8* t_B, UINT32 t_PixelCount, UINT32 t_Channels)
+		{
+			double SquaredError = 0.0;
+			for (UINT32 i = 0; i < t_PixelCount; ++i)
+			{
+				for (UINT32 c = 0; c < t_Channels; ++c)
+				{
+					const double Delta = static_cast<double>(t_A[i * 4 + c]) - static_cast<double>(t_B[i * 4 + c]);
+					SquaredError += Delta * Delta;
+				}
+			}
+
+			if (SquaredError <= 0.0)
+			{
+				return std::numeric_limits<double>::infinity();
+			}
+			const double MeanSquaredError = SquaredError / (static_cast<double>(t_PixelCount) * t_Channels);
+			return 10.0 * std::log10(255.0 * 255.0 / MeanSquaredError);
+		}
+	}   // namespace BlockCompression
+}   // namespace Fling
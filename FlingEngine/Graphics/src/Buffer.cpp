@@ -4,15 +4,16 @@
 #include "VulkanApp.h"	// #TODO Pass in the devices by arg and not using this singleton
 #include "LogicalDevice.h"
 #include "PhyscialDevice.h"
+#include "UploadBatch.h"
 
 namespace Fling
 {
-    Buffer::Buffer(const VkDeviceSize& size, const VkBufferUsageFlags& t_Usage, const VkMemoryPropertyFlags& t_Properties, const void* t_Data)
+    Buffer::Buffer(const VkDeviceSize& size, const VkBufferUsageFlags& t_Usage, const VkMemoryPropertyFlags& t_Properties, const void* t_Data, AllocationStrategy t_Strategy)
 		: m_Size(size)
 		, m_Buffer(VK_NULL_HANDLE)
-		, m_BufferMemory(VK_NULL_HANDLE)
+		, m_Allocation{}
 	{
-		CreateBuffer(m_Size, t_Usage, t_Properties, false, t_Data);
+		CreateBuffer(m_Size, t_Usage, t_Properties, false, t_Data, t_Strategy);
 
         m_Descriptor = {};
         m_Descriptor.buffer = m_Buffer;
@@ -27,7 +28,7 @@ namespace Fling
 			m_MappedMem = t_Other.m_MappedMem;
 			m_Size = t_Other.m_Size;
 			m_Buffer = t_Other.m_Buffer;
-			m_BufferMemory = t_Other.m_BufferMemory;
+			m_Allocation = t_Other.m_Allocation;
 			m_Descriptor = t_Other.m_Descriptor;
 		}
 	}
@@ -44,22 +45,20 @@ namespace Fling
 
 	VkResult Buffer::MapMemory(VkDeviceSize t_Size, VkDeviceSize t_Offset)
 	{
-		LogicalDevice* Dev = VulkanApp::Get().GetLogicalDevice();
-		assert(Dev);
-		VkDevice Device = Dev->GetVkDevice();
-		return vkMapMemory(Device, m_BufferMemory, t_Offset, t_Size, 0, &m_MappedMem);
+		if (!m_Allocation.MappedData)
+		{
+			F_LOG_ERROR("Trying to map a buffer that is not host visible!");
+			return VK_ERROR_MEMORY_MAP_FAILED;
+		}
+
+		m_MappedMem = static_cast<char*>(m_Allocation.MappedData) + t_Offset;
+		return VK_SUCCESS;
 	}
 
 	void Buffer::UnmapMemory()
 	{
-		if (m_MappedMem)
-		{
-			LogicalDevice* Dev = VulkanApp::Get().GetLogicalDevice();
-			assert(Dev);
-			VkDevice Device = Dev->GetVkDevice();			
-			vkUnmapMemory(Device, m_BufferMemory);
-			m_MappedMem = nullptr;
-		}
+		// The allocator keeps the block mapped until it is freed
+		m_MappedMem = nullptr;
 	}
 
 	void Buffer::CreateBuffer(
@@ -67,15 +66,15 @@ namespace Fling
 		const VkBufferUsageFlags & t_Usage, 
 		const VkMemoryPropertyFlags & t_Properties, 
 		bool  t_unmapBuffer,
-		const void * t_Data)
+		const void * t_Data,
+		AllocationStrategy t_Strategy)
 	{
 		LogicalDevice* Dev = VulkanApp::Get().GetLogicalDevice();
 		assert(Dev);
 		VkDevice Device = Dev->GetVkDevice();
 
-		PhysicalDevice* Phys = VulkanApp::Get().GetPhysicalDevice();
-		assert(Phys);
-		VkPhysicalDevice PhysicalDevice = Phys->GetVkPhysicalDevice();
+		DeviceMemoryAllocator* Allocator = VulkanApp::Get().GetMemoryAllocator();
+		assert(Allocator);
 
 		VkBufferCreateInfo bufferInfo = {};
 		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -92,19 +91,17 @@ namespace Fling
 		VkMemoryRequirements MemRequirments = {};
 		vkGetBufferMemoryRequirements(Device, m_Buffer, &MemRequirments);
 
-		VkMemoryAllocateInfo AllocInfo = {};
-		AllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		AllocInfo.allocationSize = MemRequirments.size;
-		//Using VK_MEMORY_PROPERTY_HOST_COHERENT_BIT may cause worse perf,
-		//we could use explicit flushing with vkFlushMappedMemoryRanges
-		AllocInfo.memoryTypeIndex = GraphicsHelpers::FindMemoryType(PhysicalDevice, MemRequirments.memoryTypeBits, t_Properties);
-
-		//Allocate the vertex buffer memory
-		if (vkAllocateMemory(Device, &AllocInfo, nullptr, &m_BufferMemory) != VK_SUCCESS)
+		//Sub allocate from a block of the right memory type instead of a vkAllocateMemory per buffer
+		if (!Allocator->Allocate(MemRequirments, t_Properties, ResourceLayout::Linear, m_Allocation, t_Strategy))
 		{
 			F_LOG_FATAL("Failed to alocate buffer memory!");
 		}
 
+		if ((vkBindBufferMemory(Device, m_Buffer, m_Allocation.Memory, m_Allocation.Offset) != VK_SUCCESS))
+		{
+			F_LOG_FATAL("Failed to bind buffer memory!");
+		}
+
 		//Map this buffer and copy the data to the given data pointer if one was specified
 		if (t_Data)
 		{
@@ -113,12 +110,7 @@ namespace Fling
 
 			if ((t_Properties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) == 0)
 			{
-				VkMappedMemoryRange MappedRange{};
-				MappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-				MappedRange.memory = m_BufferMemory;
-				MappedRange.offset = 0;
-				MappedRange.size = m_Size;
-				vkFlushMappedMemoryRanges(Device, 1, &MappedRange);
+				Flush(VK_WHOLE_SIZE, 0);
 			}
 
 			if (t_unmapBuffer)
@@ -126,27 +118,19 @@ namespace Fling
 				UnmapMemory();
 			}
 		}
-
-		if ((vkBindBufferMemory(Device, m_Buffer, m_BufferMemory, 0) != VK_SUCCESS))
-		{
-			F_LOG_FATAL("Failed to bind buffer memory!");
-		}
 	}
 	
 	void Buffer::CopyBuffer(Buffer* t_SrcBuffer, Buffer* t_DstBuffer, VkDeviceSize t_Size)
 	{
 		assert(t_SrcBuffer && t_SrcBuffer->IsUsed() && t_DstBuffer && t_DstBuffer->IsUsed());
 
-		// #TODO: Replace this graphics helper with a command buffer wrapper that handles the creation for us
-		VkCommandBuffer commandBuffer = GraphicsHelpers::BeginSingleTimeCommands();
+		// The source is read on the transfer queue, so it has to be host written memory that no other queue owns
+		StagingAllocation Src = {};
+		Src.Buffer = t_SrcBuffer->GetVkBuffer();
 
-		VkBufferCopy copyRegion = {};
-		copyRegion.srcOffset = 0; // Optional
-		copyRegion.dstOffset = 0; // Optional
-		copyRegion.size = t_Size;
-		vkCmdCopyBuffer(commandBuffer, t_SrcBuffer->GetVkBuffer(), t_DstBuffer->GetVkBuffer(), 1, &copyRegion);
-
-		GraphicsHelpers::EndSingleTimeCommands(commandBuffer);
+		UploadBatch Batch;
+		Batch.CopyBuffer(Src, t_DstBuffer, t_Size);
+		Batch.SubmitAndWait();
 	}
 
 	void Buffer::Flush(VkDeviceSize t_size, VkDeviceSize t_offset)
@@ -155,11 +139,25 @@ namespace Fling
 		assert(Dev);
 		VkDevice LogicalDevice = Dev->GetVkDevice();
 
+		// Coherent memory is visible to the device without flushing
+		const VkPhysicalDeviceMemoryProperties& MemProps = VulkanApp::Get().GetMemoryAllocator()->GetMemoryProperties();
+		if (MemProps.memoryTypes[m_Allocation.MemoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+		{
+			return;
+		}
+
+		// The buffer only owns part of the memory block, so flush the range of our allocation. The
+		// allocator pads non coherent allocations to the atom size so that this can't touch any others
+		const VkDeviceSize AtomSize = VulkanApp::Get().GetPhysicalDevice()->GetDeviceProps().limits.nonCoherentAtomSize;
+		const VkDeviceSize AllocationEnd = m_Allocation.Offset + m_Allocation.Size;
+		const VkDeviceSize Start = m_Allocation.Offset + (t_offset / AtomSize) * AtomSize;
+		const VkDeviceSize End = t_size == VK_WHOLE_SIZE ? AllocationEnd : std::min(AllocationEnd, ((m_Allocation.Offset + t_offset + t_size + AtomSize - 1) / AtomSize) * AtomSize);
+
 		VkMappedMemoryRange mappedRange = {};
 		mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-		mappedRange.memory = m_BufferMemory;
-		mappedRange.offset = t_offset;
-		mappedRange.size = t_size;
+		mappedRange.memory = m_Allocation.Memory;
+		mappedRange.offset = Start;
+		mappedRange.size = End - Start;
 		if (vkFlushMappedMemoryRanges(LogicalDevice, 1, &mappedRange) != VK_SUCCESS)
 		{
 			F_LOG_ERROR("Mapped buffer could not flush memory");
@@ -180,10 +178,9 @@ namespace Fling
 			m_Buffer = nullptr;
 		}
 
-		if(m_BufferMemory)
+		if(m_Allocation.IsValid())
 		{
-			vkFreeMemory(Device, m_BufferMemory, nullptr);
-			m_BufferMemory = nullptr;
+			VulkanApp::Get().GetMemoryAllocator()->Free(m_Allocation);
 		}
 	}
 
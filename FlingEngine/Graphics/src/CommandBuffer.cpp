@@ -6,16 +6,17 @@
 
 namespace Fling
 {
-	CommandBuffer::CommandBuffer(const LogicalDevice* t_Device, VkCommandPool t_CmdPool)
+	CommandBuffer::CommandBuffer(const LogicalDevice* t_Device, VkCommandPool t_CmdPool, VkCommandBufferLevel t_Level)
 		: m_Device(t_Device)
 		, m_Pool(t_CmdPool)
+		, m_Level(t_Level)
 	{
 		assert(m_Device);
 		VkCommandBufferAllocateInfo allocate_info{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
 
 		allocate_info.commandPool = m_Pool;
 		allocate_info.commandBufferCount = 1;
-		allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocate_info.level = m_Level;
 
 		VkResult result = vkAllocateCommandBuffers(m_Device->GetVkDevice(), &allocate_info, &m_Handle);
 
@@ -48,7 +49,27 @@ namespace Fling
 		VK_CHECK_RESULT(vkBeginCommandBuffer(GetHandle(), &beginInfo));
 	}
 
-	void CommandBuffer::BeginRenderPass(FrameBuffer& t_frameBuf, const std::vector<VkClearValue>& t_ClearVales)
+	void CommandBuffer::BeginSecondary(VkRenderPass t_RenderPass, UINT32 t_Subpass, VkFramebuffer t_FrameBuffer)
+	{
+		assert(!IsRecording());
+		assert(m_Level == VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+		m_State = State::Recording;
+
+		VkCommandBufferInheritanceInfo inheritanceInfo = {};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = t_RenderPass;
+		inheritanceInfo.subpass = t_Subpass;
+		inheritanceInfo.framebuffer = t_FrameBuffer;
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		VK_CHECK_RESULT(vkBeginCommandBuffer(GetHandle(), &beginInfo));
+	}
+
+	void CommandBuffer::BeginRenderPass(FrameBuffer& t_frameBuf, const std::vector<VkClearValue>& t_ClearVales, VkSubpassContents t_Contents)
 	{
 		VkRenderPassBeginInfo begin_info{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
 		// Frame buf info
@@ -64,7 +85,17 @@ namespace Fling
 		begin_info.clearValueCount = to_u32(t_ClearVales.size());
 		begin_info.pClearValues = t_ClearVales.data();
 
-		vkCmdBeginRenderPass(GetHandle(), &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(GetHandle(), &begin_info, t_Contents);
+	}
+
+	void CommandBuffer::ExecuteCommands(const std::vector<VkCommandBuffer>& t_SecondaryBuffers)
+	{
+		assert(m_Level == VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+		if (!t_SecondaryBuffers.empty())
+		{
+			vkCmdExecuteCommands(GetHandle(), to_u32(t_SecondaryBuffers.size()), t_SecondaryBuffers.data());
+		}
 	}
 
 	void CommandBuffer::NextSubpass()
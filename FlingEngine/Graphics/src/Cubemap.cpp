@@ -5,6 +5,7 @@
 #include "PhyscialDevice.h"
 #include "HDRImage.h"
 #include "VulkanApp.h"
+#include "UploadBatch.h"
 
 namespace Fling
 {
@@ -44,10 +45,9 @@ namespace Fling
 
     Cubemap::~Cubemap()
     {
-        if (m_ImageMemory)
+        if (m_ImageMemory.IsValid())
         {
-            vkFreeMemory(m_Device->GetVkDevice(), m_ImageMemory, nullptr);
-            m_ImageMemory = nullptr;
+            VulkanApp::Get().GetMemoryAllocator()->Free(m_ImageMemory);
         }
 
         if (m_GraphicsPipeline)
@@ -114,15 +114,9 @@ namespace Fling
         //m_MipLevels = 1.0f;
         m_Format = image->GetVkImageFormat();
 
-        std::unique_ptr<Buffer> stagingBuffer = std::make_unique<Buffer>();
-        stagingBuffer->CreateBuffer(m_ImageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_SHARING_MODE_EXCLUSIVE, true);
-        stagingBuffer->MapMemory();
-
-        float* pixelDst = (float*)(stagingBuffer->m_MappedMem);
-        const float* pixels = image->GetPixelData();
-        memcpy(pixelDst, pixels, m_ImageSize);
-
-        stagingBuffer->UnmapMemory();
+        // Copies into the image have to start on a whole texel, which is 3 half floats
+        UploadBatch Batch;
+        StagingAllocation Staging = Batch.StageData(image->GetPixelData(), m_ImageSize, 12);
 
 
         GraphicsHelpers::CreateVkImage(
@@ -140,7 +134,7 @@ namespace Fling
             m_Image,
             m_ImageMemory);
 
-        VkCommandBuffer copyCmd = GraphicsHelpers::BeginSingleTimeCommands();
+        VkCommandBuffer copyCmd = Batch.GetCommandBuffer();
 
         std::vector< VkBufferImageCopy> bufferCopyRegions;
         VkDeviceSize offset = 0;
@@ -155,7 +149,7 @@ namespace Fling
             bufferCopyRegion.imageExtent.width = image->GetWidth();
             bufferCopyRegion.imageExtent.height = image->GetHeight();
             bufferCopyRegion.imageExtent.depth = 1;
-            bufferCopyRegion.bufferOffset = offset;
+            bufferCopyRegion.bufferOffset = Staging.Offset + offset;
 
             bufferCopyRegions.push_back(bufferCopyRegion);
 
@@ -183,7 +177,7 @@ namespace Fling
         // Copy the cube map faces from the staging buffer to the optimal tiled image
         vkCmdCopyBufferToImage(
             copyCmd,
-            stagingBuffer->GetVkBuffer(),
+            Staging.Buffer,
             m_Image,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
             static_cast<uint32_t>(bufferCopyRegions.size()),
@@ -192,16 +186,8 @@ namespace Fling
 
         // Change texture image layout to shader read after all faces have been copied
         m_ImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        GraphicsHelpers::SetImageLayout(
-            copyCmd,
-            m_Image,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            m_ImageLayout,
-            subresourceRange,
-            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
-
-        GraphicsHelpers::EndSingleTimeCommands(copyCmd);
+        Batch.TransferImage(m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, m_ImageLayout, m_MipLevels, 6);
+        Batch.SubmitAndWait();
 
         // Create sampler
         VkSamplerCreateInfo sampler = Initializers::SamplerCreateInfo();
@@ -271,11 +257,11 @@ namespace Fling
         m_Format = images[0]->GetVkImageFormat();
 
 
-        std::unique_ptr<Buffer> stagingBuffer = std::make_unique<Buffer>();
-        stagingBuffer->CreateBuffer(m_ImageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_SHARING_MODE_EXCLUSIVE, true);
-        stagingBuffer->MapMemory();
+        // Every face goes in the same staging range, one after the other
+        UploadBatch Batch;
+        StagingAllocation Staging = Batch.AllocateStaging(m_ImageSize);
 
-        stbi_uc* pixelDst = (stbi_uc*)(stagingBuffer->m_MappedMem);
+        stbi_uc* pixelDst = static_cast<stbi_uc*>(Staging.Data);
         for (size_t i = 0; i < 6; i++)
         {
             const stbi_uc* pixels = images[i]->GetPixelData();
@@ -283,8 +269,6 @@ namespace Fling
             pixelDst += m_LayerSize;
         }
 
-        stagingBuffer->UnmapMemory();
-
         GraphicsHelpers::CreateVkImage(
 			m_Device->GetVkDevice(),
             images[0]->GetWidth(),
@@ -300,7 +284,7 @@ namespace Fling
             m_Image,
             m_ImageMemory);
 
-        VkCommandBuffer copyCmd = GraphicsHelpers::BeginSingleTimeCommands();
+        VkCommandBuffer copyCmd = Batch.GetCommandBuffer();
 
         std::vector< VkBufferImageCopy> bufferCopyRegions;
         VkDeviceSize offset = 0;
@@ -315,7 +299,7 @@ namespace Fling
             bufferCopyRegion.imageExtent.width = images[face]->GetWidth();
             bufferCopyRegion.imageExtent.height = images[face]->GetHeight();
             bufferCopyRegion.imageExtent.depth = 1;
-            bufferCopyRegion.bufferOffset = offset;
+            bufferCopyRegion.bufferOffset = Staging.Offset + offset;
 
             bufferCopyRegions.push_back(bufferCopyRegion);
 
@@ -343,7 +327,7 @@ namespace Fling
         // Copy the cube map faces from the staging buffer to the optimal tiled image
         vkCmdCopyBufferToImage(
             copyCmd,
-            stagingBuffer->GetVkBuffer(),
+            Staging.Buffer,
             m_Image,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
             static_cast<uint32_t>(bufferCopyRegions.size()),
@@ -352,16 +336,8 @@ namespace Fling
 
         // Change texture image layout to shader read after all faces have been copied
         m_ImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        GraphicsHelpers::SetImageLayout(
-            copyCmd,
-            m_Image,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            m_ImageLayout,
-            subresourceRange,
-            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
-
-        GraphicsHelpers::EndSingleTimeCommands(copyCmd);
+        Batch.TransferImage(m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, m_ImageLayout, m_MipLevels, 6);
+        Batch.SubmitAndWait();
 
         // Create sampler
         VkSamplerCreateInfo sampler = Initializers::SamplerCreateInfo();
@@ -506,6 +482,12 @@ namespace Fling
 
     void Cubemap::BindCmdBuffer(VkCommandBuffer& t_CommandBuffer)
     {
+        // The cube model may still be loading if something else requested it async
+        if (!m_Cube->IsReady())
+        {
+            return;
+        }
+
         vkCmdBindDescriptorSets(
             t_CommandBuffer, 
             VK_PIPELINE_BIND_POINT_GRAPHICS, 
@@ -5,11 +5,14 @@
 #include "LogicalDevice.h"
 #include "GraphicsHelpers.h"
 #include "Components/Transform.h"
+#include "RenderGraph.h"
 #include "MeshRenderer.h"
 #include "SwapChain.h"
 #include "UniformBufferObject.h"
 #include "FirstPersonCamera.h"
 #include "FlingVulkan.h"
+#include "FrustumCuller.h"
+#include "VulkanApp.h"
 
 #define FRAME_BUF_DIM 2048
 
@@ -21,14 +24,22 @@ namespace Fling
 		entt::registry& t_reg,
 		VkRenderPass t_GlobalRenderPass,
 		FirstPersonCamera* t_Cam,
+		const FrustumCuller* t_Culler,
 		std::shared_ptr<Fling::Shader> t_Vert,
 		std::shared_ptr<Fling::Shader> t_Frag)
-		: Subpass(t_Dev, t_Swap, t_Vert, t_Frag)
+		: Subpass(t_Dev, t_Swap, t_Vert, t_Frag, /* t_DynamicUniformMask */ 1 << 0)
 		, m_GlobalRenderPass(t_GlobalRenderPass)
 		, m_Camera(t_Cam)
+		, m_Culler(t_Culler)
 	{
+		assert(m_Camera && m_Culler);
+
 		t_reg.on_construct<MeshRenderer>().connect<&DebugSubpass::OnMeshRendererAdded>(*this);
 
+		m_UniformRing = std::make_unique<UniformRingBuffer>(
+			MaxObjectsPerFrame * UniformRingBuffer::MaxSliceSize(sizeof(DebugUBO)), 
+			VulkanApp::Get().GetFramesInFlight());
+
 		PrepareAttachments();
 	}
 
@@ -39,61 +50,87 @@ namespace Fling
 
 	void DebugSubpass::Draw(CommandBuffer& t_CmdBuf, VkFramebuffer t_PresentFrameBuf, UINT32 t_ActiveFrameInFlight, entt::registry& t_reg, float DeltaTime)
 	{
-		// For every mesh bind it's model and descriptor set info
-		auto RenderGroup = t_reg.group<Transform>(entt::get<MeshRenderer, entt::tag<"Debug"_hs>>);
-
 		// Invert the project value to match the proper coordinate space compared to OpenGL
 		m_Ubo.Projection = m_Camera->GetProjectionMatrix();
 		m_Ubo.Projection[1][1] *= -1.0f;
-		VkDeviceSize offsets[1] = { 0 };
+		const glm::mat4 View = m_Camera->GetViewMatrix();
+
+		// The slices from the last time this frame was in flight are free now
+		m_UniformRing->BeginFrame();
+		m_DrawList.Clear();
 
-		RenderGroup.less([&](entt::entity ent, Transform& t_trans, MeshRenderer& t_MeshRend)
+		const VkPipeline Pipeline = m_GraphicsPipeline->GetPipeline();
+		const UINT32 PipelineId = DrawList::GetSortId(Pipeline, DrawList::PipelineBits);
+
+		// Every visible debug mesh is added to the draw list with it's own slice of the uniforms
+		for (entt::entity Ent : m_Culler->GetVisibleEntities())
 		{
+			if (!t_reg.has<entt::tag<"Debug"_hs>>(Ent))
+			{
+				continue;
+			}
+
+			const Transform& t_trans = t_reg.get<Transform>(Ent);
+			MeshRenderer& t_MeshRend = t_reg.get<MeshRenderer>(Ent);
 			Fling::Model* Model = t_MeshRend.m_Model;
-			if (!Model)
+
+			// The debug shaders only read full vertices
+			if (!Model || Model->GetVertexFormat() != VertexFormat::Full)
 			{
-				return;
+				continue;
 			}
 
-			// Update the UBO
-			Transform::CalculateWorldMatrix(t_trans);
-			m_Ubo.Model = t_trans.GetWorldMatrix();
+			// Update the UBO, the culler has already calculated the world matrix
+			m_Ubo.Model = t_trans.GetWorldMat();
 
-			// Memcpy to the buffer
-			Buffer* buf = t_MeshRend.m_UniformBuffer;
-			memcpy(
-				buf->m_MappedMem,
-				&m_Ubo,
-				buf->GetSize()
-			);
+			// Write it to this mesh's slice of the ring buffer
+			UINT32 DynamicOffset = 0;
+			if (!m_UniformRing->Push(m_Ubo, DynamicOffset))
+			{
+				F_LOG_WARN("Debug subpass is out of uniform buffer space, skipping meshes");
+				break;
+			}
 
-			// If the mesh has no descriptor sets, then build them
-			// #TODO Investigate a better way to do this, probably by just moving the 
-			// descriptors off of the mesh
+			// The descriptor set is shared by every debug mesh
 			if (t_MeshRend.m_DescriptorSet == VK_NULL_HANDLE)
 			{
-				CreateMeshDescriptorSet(t_MeshRend);
+				CreateDescriptorSet();
+				t_MeshRend.m_DescriptorSet = m_DescriptorSet;
 			}
 
-			// Bind the descriptor set for rendering a mesh using the dynamic offset
-			vkCmdBindDescriptorSets(
-				t_CmdBuf.GetHandle(),
-				VK_PIPELINE_BIND_POINT_GRAPHICS,
-				m_GraphicsPipeline->GetPipelineLayout(),
-				0,
-				1,
-				&t_MeshRend.m_DescriptorSet,
-				0,
-				nullptr);
+			DrawCommand Command = {};
+			Command.Pipeline = Pipeline;
+			Command.PipelineLayout = m_GraphicsPipeline->GetPipelineLayout();
+			Command.DescriptorSet = t_MeshRend.m_DescriptorSet;
+			Command.DynamicOffsetCount = 1;
+			Command.DynamicOffset = DynamicOffset;
+			Command.VertexBuffer = Model->GetVertexBuffer()->GetVkBuffer();
+			Command.IndexBuffer = Model->GetIndexBuffer()->GetVkBuffer();
+			Command.IndexType = Model->GetIndexType();
+			// Render the full mesh, the levels of detail after it are in the same index buffer
+			Command.IndexCount = Model->GetLod(0).IndexCount;
+
+			// The camera looks down -z, so the depth of the mesh's origin is the negated view z
+			const float Depth = -(View * m_Ubo.Model[3]).z;
+			m_DrawList.Add(
+				DrawList::MakeKey(
+					0,
+					PipelineId,
+					DrawList::GetSortId(t_MeshRend.m_DescriptorSet, DrawList::MaterialBits),
+					DrawList::GetSortId(Model, DrawList::MeshBits),
+					Depth),
+				Command);
+		}
 
-			vkCmdBindPipeline(t_CmdBuf.GetHandle(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicsPipeline->GetPipeline());
+		// Meshes that share a model are drawn next to each other, so their buffers are only bound once
+		m_DrawList.Sort();
+		m_DrawList.Record(t_CmdBuf);
+	}
 
-			VkBuffer vertexBuffers[1] = { Model->GetVertexBuffer()->GetVkBuffer() };
-			// Render the mesh
-			vkCmdBindVertexBuffers(t_CmdBuf.GetHandle(), 0, 1, vertexBuffers, offsets);
-			vkCmdBindIndexBuffer(t_CmdBuf.GetHandle(), Model->GetIndexBuffer()->GetVkBuffer(), 0, Model->GetIndexType());
-			vkCmdDrawIndexed(t_CmdBuf.GetHandle(), Model->GetIndexCount(), 1, 0, 0, 0);
-		});
+	void DebugSubpass::DeclareResources(RenderGraph& t_Graph, UINT32 t_Pass)
+	{
+		// Debug bounds are drawn over the lit scene
+		t_Graph.Write(t_Pass, t_Graph.FindTexture(BackbufferName), RenderGraphUsage::ColorAttachment);
 	}
 
 	void DebugSubpass::CreateDescriptorSets(VkDescriptorPool t_Pool, entt::registry& t_reg)
@@ -101,30 +138,30 @@ namespace Fling
 		
 	}
 
-	void DebugSubpass::CreateMeshDescriptorSet(MeshRenderer& t_MeshRend)
+	void DebugSubpass::CreateDescriptorSet()
 	{
-		// Only allocate new descriptor sets if there are none
-		// Some may exist if entt decides to re-use the component
-		if (t_MeshRend.m_DescriptorSet == VK_NULL_HANDLE)
+		if (m_DescriptorSet != VK_NULL_HANDLE)
 		{
-			VkDescriptorSetLayout layout = m_GraphicsPipeline->GetDescriptorSetLayout();
-			VkDescriptorSetAllocateInfo allocInfo = {};
-			allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-			// If we have specified a specific pool then use that, otherwise use the one on the mesh
-			allocInfo.descriptorPool = m_DescriptorPool;
-			allocInfo.descriptorSetCount = 1;
-			allocInfo.pSetLayouts = &layout;
-
-			VK_CHECK_RESULT(vkAllocateDescriptorSets(m_Device->GetVkDevice(), &allocInfo, &t_MeshRend.m_DescriptorSet));
+			return;
 		}
 
+		VkDescriptorSetLayout layout = m_GraphicsPipeline->GetDescriptorSetLayout();
+		VkDescriptorSetAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = m_DescriptorPool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &layout;
+
+		VK_CHECK_RESULT(vkAllocateDescriptorSets(m_Device->GetVkDevice(), &allocInfo, &m_DescriptorSet));
+
 		std::vector<VkWriteDescriptorSet> writeDescriptorSets =
 		{
-			// 0: UBO
-			Initializers::WriteDescriptorSetUniform(
-				t_MeshRend.m_UniformBuffer,
-				t_MeshRend.m_DescriptorSet,
-				0
+			// 0: Dynamic UBO, each mesh binds it's own slice
+			Initializers::WriteDescriptorSet(
+				m_DescriptorSet,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+				0,
+				m_UniformRing->GetDescriptorInfo(sizeof(DebugUBO))
 			),
 		};
 
@@ -138,7 +175,8 @@ namespace Fling
 
 		std::vector<VkDescriptorPoolSize> poolSizes =
 		{
-			Initializers::DescriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 		DescriptorCount),			
+			Initializers::DescriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 		DescriptorCount),
+			Initializers::DescriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, DescriptorCount),
 		};
 
 		VkDescriptorPoolCreateInfo poolInfo = {};
@@ -173,7 +211,10 @@ namespace Fling
 		{
 			vkDestroyDescriptorPool(m_Device->GetVkDevice(), m_DescriptorPool, nullptr);
 			m_DescriptorPool = VK_NULL_HANDLE;
+			m_DescriptorSet = VK_NULL_HANDLE;
 		}
+
+		m_UniformRing.reset();
 	}
 
 	void DebugSubpass::OnMeshRendererAdded(entt::entity t_Ent, entt::registry& t_Reg, MeshRenderer& t_MeshRend)
@@ -186,14 +227,7 @@ namespace Fling
 
 		t_Reg.assign<entt::tag<"Debug"_hs >>(t_Ent);
 
-		// Initialize and map the UBO of each mesh renderer
-		if (t_MeshRend.m_UniformBuffer == nullptr)
-		{
-			VkDeviceSize bufferSize = sizeof(DebugUBO);
-			t_MeshRend.m_UniformBuffer = new Buffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-			t_MeshRend.m_UniformBuffer->MapMemory(bufferSize);
-		}
-
-		CreateMeshDescriptorSet(t_MeshRend);
+		CreateDescriptorSet();
+		t_MeshRend.m_DescriptorSet = m_DescriptorSet;
 	}
 }   // namespace Fling
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "DepthBuffer.h"
 #include "GraphicsHelpers.h"
 #include "LogicalDevice.h"
+#include "VulkanApp.h"
 
 namespace Fling
 {
@@ -18,7 +19,7 @@ namespace Fling
 	{
 		// Everything HAS to be null in order to create it again.
 		// If not then cleanup was not properly called at some point
-		assert(m_Image == VK_NULL_HANDLE && m_Memory == VK_NULL_HANDLE && m_ImageView == VK_NULL_HANDLE);
+		assert(m_Image == VK_NULL_HANDLE && !m_Memory.IsValid() && m_ImageView == VK_NULL_HANDLE);
 		
 		// Find the depth format for to for the buffer
 		m_Format = DepthBuffer::GetDepthBufferFormat();
@@ -53,10 +54,9 @@ namespace Fling
 			vkDestroyImage(Device, m_Image, nullptr);
 			m_Image = VK_NULL_HANDLE;
 		}
-		if (m_Memory)
+		if (m_Memory.IsValid())
 		{
-			vkFreeMemory(Device, m_Memory, nullptr);
-			m_Memory = VK_NULL_HANDLE;
+			VulkanApp::Get().GetMemoryAllocator()->Free(m_Memory);
 		}
 	}
 
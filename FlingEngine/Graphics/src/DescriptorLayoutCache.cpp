@@ -0,0 +1,229 @@
+#include "pch.h"
+#include "DescriptorLayoutCache.h"
+
+#include <algorithm>
+
+namespace Fling
+{
+	namespace
+	{
+		void HashCombine(size_t& t_Seed, UINT64 t_Value)
+		{
+			t_Seed ^= std::hash<UINT64>()(t_Value) + 0x9e3779b97f4a7c15ull + (t_Seed << 6) + (t_Seed >> 2);
+		}
+	}
+
+	bool DescriptorLayoutCache::SetLayoutKey::operator==(const SetLayoutKey& t_Other) const
+	{
+		if (Flags != t_Other.Flags || Bindings.size() != t_Other.Bindings.size() || BindingFlags != t_Other.BindingFlags)
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < Bindings.size(); ++i)
+		{
+			const VkDescriptorSetLayoutBinding& A = Bindings[i];
+			const VkDescriptorSetLayoutBinding& B = t_Other.Bindings[i];
+			if (A.binding != B.binding || A.descriptorType != B.descriptorType || A.descriptorCount != B.descriptorCount || A.stageFlags != B.stageFlags)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool DescriptorLayoutCache::PipelineLayoutKey::operator==(const PipelineLayoutKey& t_Other) const
+	{
+		if (SetLayouts != t_Other.SetLayouts || PushConstantRanges.size() != t_Other.PushConstantRanges.size())
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < PushConstantRanges.size(); ++i)
+		{
+			const VkPushConstantRange& A = PushConstantRanges[i];
+			const VkPushConstantRange& B = t_Other.PushConstantRanges[i];
+			if (A.stageFlags != B.stageFlags || A.offset != B.offset || A.size != B.size)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	size_t DescriptorLayoutCache::KeyHash::operator()(const SetLayoutKey& t_Key) const
+	{
+		size_t Hash = 0;
+		HashCombine(Hash, t_Key.Flags);
+		for (const VkDescriptorSetLayoutBinding& Binding : t_Key.Bindings)
+		{
+			HashCombine(Hash, (static_cast<UINT64>(Binding.binding) << 32) | static_cast<UINT64>(Binding.descriptorType));
+			HashCombine(Hash, (static_cast<UINT64>(Binding.descriptorCount) << 32) | static_cast<UINT64>(Binding.stageFlags));
+		}
+		for (VkDescriptorBindingFlagsEXT BindingFlags : t_Key.BindingFlags)
+		{
+			HashCombine(Hash, BindingFlags);
+		}
+		return Hash;
+	}
+
+	size_t DescriptorLayoutCache::KeyHash::operator()(const PipelineLayoutKey& t_Key) const
+	{
+		size_t Hash = 0;
+		for (VkDescriptorSetLayout Layout : t_Key.SetLayouts)
+		{
+			HashCombine(Hash, (UINT64)Layout);
+		}
+		for (const VkPushConstantRange& Range : t_Key.PushConstantRanges)
+		{
+			HashCombine(Hash, (static_cast<UINT64>(Range.stageFlags) << 32) | Range.offset);
+			HashCombine(Hash, Range.size);
+		}
+		return Hash;
+	}
+
+	DescriptorLayoutCache::DescriptorLayoutCache(VkDevice t_Device)
+		: m_Device(t_Device)
+	{
+	}
+
+	DescriptorLayoutCache::~DescriptorLayoutCache()
+	{
+		for (const auto& Layout : m_PipelineLayouts)
+		{
+			vkDestroyPipelineLayout(m_Device, Layout.second, nullptr);
+		}
+
+		for (const auto& Layout : m_SetLayouts)
+		{
+			vkDestroyDescriptorSetLayout(m_Device, Layout.second, nullptr);
+		}
+	}
+
+	void DescriptorLayoutCache::SortBindings(std::vector<VkDescriptorSetLayoutBinding>& t_Bindings, std::vector<VkDescriptorBindingFlagsEXT>* t_BindingFlags)
+	{
+		if (!t_BindingFlags || t_BindingFlags->empty())
+		{
+			std::sort(t_Bindings.begin(), t_Bindings.end(), [](const VkDescriptorSetLayoutBinding& A, const VkDescriptorSetLayoutBinding& B)
+			{
+				return A.binding < B.binding;
+			});
+			return;
+		}
+
+		// Flags have to stay with their binding
+		assert(t_BindingFlags->size() == t_Bindings.size());
+		std::vector<std::pair<VkDescriptorSetLayoutBinding, VkDescriptorBindingFlagsEXT>> Pairs(t_Bindings.size());
+		for (size_t i = 0; i < t_Bindings.size(); ++i)
+		{
+			Pairs[i] = { t_Bindings[i], (*t_BindingFlags)[i] };
+		}
+
+		std::sort(Pairs.begin(), Pairs.end(), [](const auto& A, const auto& B)
+		{
+			return A.first.binding < B.first.binding;
+		});
+
+		for (size_t i = 0; i < Pairs.size(); ++i)
+		{
+			t_Bindings[i] = Pairs[i].first;
+			(*t_BindingFlags)[i] = Pairs[i].second;
+		}
+	}
+
+	VkDescriptorSetLayout DescriptorLayoutCache::GetSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& t_Bindings, VkDescriptorSetLayoutCreateFlags t_Flags, const std::vector<VkDescriptorBindingFlagsEXT>& t_BindingFlags)
+	{
+		assert(t_BindingFlags.empty() || t_BindingFlags.size() == t_Bindings.size());
+
+		SetLayoutKey Key;
+		Key.Flags = t_Flags;
+		Key.Bindings = t_Bindings;
+		Key.BindingFlags = t_BindingFlags;
+		SortBindings(Key.Bindings, &Key.BindingFlags);
+
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		++m_RequestCount;
+
+		auto It = m_SetLayouts.find(Key);
+		if (It != m_SetLayouts.end())
+		{
+			return It->second;
+		}
+
+		for (const VkDescriptorSetLayoutBinding& Binding : Key.Bindings)
+		{
+			assert(Binding.pImmutableSamplers == nullptr && "Immutable samplers are not part of the cache key");
+		}
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfoEXT FlagsInfo = {};
+		FlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+		FlagsInfo.bindingCount = static_cast<UINT32>(Key.BindingFlags.size());
+		FlagsInfo.pBindingFlags = Key.BindingFlags.data();
+
+		VkDescriptorSetLayoutCreateInfo CreateInfo = {};
+		CreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		CreateInfo.pNext = Key.BindingFlags.empty() ? nullptr : &FlagsInfo;
+		CreateInfo.flags = t_Flags;
+		CreateInfo.bindingCount = static_cast<UINT32>(Key.Bindings.size());
+		CreateInfo.pBindings = Key.Bindings.data();
+
+		VkDescriptorSetLayout Layout = VK_NULL_HANDLE;
+		if (vkCreateDescriptorSetLayout(m_Device, &CreateInfo, nullptr, &Layout) != VK_SUCCESS)
+		{
+			F_LOG_FATAL("Failed to create descriptor set layout!");
+		}
+
+		m_SetLayouts.emplace(std::move(Key), Layout);
+		return Layout;
+	}
+
+	VkPipelineLayout DescriptorLayoutCache::GetPipelineLayout(const std::vector<VkDescriptorSetLayout>& t_SetLayouts, const std::vector<VkPushConstantRange>& t_PushConstantRanges)
+	{
+		PipelineLayoutKey Key;
+		Key.SetLayouts = t_SetLayouts;
+		Key.PushConstantRanges = t_PushConstantRanges;
+
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		++m_RequestCount;
+
+		auto It = m_PipelineLayouts.find(Key);
+		if (It != m_PipelineLayouts.end())
+		{
+			return It->second;
+		}
+
+		VkPipelineLayoutCreateInfo CreateInfo = {};
+		CreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		CreateInfo.setLayoutCount = static_cast<UINT32>(Key.SetLayouts.size());
+		CreateInfo.pSetLayouts = Key.SetLayouts.data();
+		CreateInfo.pushConstantRangeCount = static_cast<UINT32>(Key.PushConstantRanges.size());
+		CreateInfo.pPushConstantRanges = Key.PushConstantRanges.data();
+
+		VkPipelineLayout Layout = VK_NULL_HANDLE;
+		if (vkCreatePipelineLayout(m_Device, &CreateInfo, nullptr, &Layout) != VK_SUCCESS)
+		{
+			F_LOG_FATAL("Failed to create pipeline layout!");
+		}
+
+		m_PipelineLayouts.emplace(std::move(Key), Layout);
+		return Layout;
+	}
+
+	UINT32 DescriptorLayoutCache::GetSetLayoutCount() const
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		return static_cast<UINT32>(m_SetLayouts.size());
+	}
+
+	UINT32 DescriptorLayoutCache::GetPipelineLayoutCount() const
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		return static_cast<UINT32>(m_PipelineLayouts.size());
+	}
+
+	UINT32 DescriptorLayoutCache::GetRequestCount() const
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		return m_RequestCount;
+	}
+}   // namespace Fling
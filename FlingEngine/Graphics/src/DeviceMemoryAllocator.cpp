@@ -0,0 +1,646 @@
+#include "pch.h"
+#include "DeviceMemoryAllocator.h"
+
+namespace Fling
+{
+	/** A single allocation from the driver that is divided up between resources */
+	class MemoryBlock
+	{
+	public:
+
+		struct AllocationRecord
+		{
+			VkDeviceSize Size = 0;
+			VkDeviceSize Alignment = 1;
+			DeviceMemoryAllocator::MoveCallback OnMove;
+		};
+
+		VkDeviceMemory Memory = VK_NULL_HANDLE;
+
+		VkDeviceSize Size = 0;
+
+		UINT32 MemoryTypeIndex = 0;
+
+		UINT32 PoolIndex = 0;
+
+		AllocationStrategy Strategy = AllocationStrategy::Buddy;
+
+		void* MappedData = nullptr;
+
+		std::unique_ptr<BlockSubAllocator> SubAllocator;
+
+		/** Every live allocation in this block by it's offset */
+		std::map<VkDeviceSize, AllocationRecord> Allocations;
+
+		VkDeviceSize UsedBytes = 0;
+	};
+
+	namespace
+	{
+		FORCEINLINE VkDeviceSize AlignUp(VkDeviceSize t_Value, VkDeviceSize t_Alignment)
+		{
+			return (t_Value + t_Alignment - 1) & ~(t_Alignment - 1);
+		}
+
+		FORCEINLINE bool IsPowerOfTwo(VkDeviceSize t_Value)
+		{
+			return t_Value != 0 && (t_Value & (t_Value - 1)) == 0;
+		}
+
+		DeviceAllocation MakeAllocation(MemoryBlock& t_Block, VkDeviceSize t_Offset, VkDeviceSize t_Size)
+		{
+			DeviceAllocation Alloc = {};
+			Alloc.Memory = t_Block.Memory;
+			Alloc.Offset = t_Offset;
+			Alloc.Size = t_Size;
+			Alloc.MappedData = t_Block.MappedData ? static_cast<char*>(t_Block.MappedData) + t_Offset : nullptr;
+			Alloc.MemoryTypeIndex = t_Block.MemoryTypeIndex;
+			Alloc.Block = &t_Block;
+			return Alloc;
+		}
+
+		bool AllocateFromBlock(MemoryBlock& t_Block, VkDeviceSize t_Size, VkDeviceSize t_Alignment, DeviceAllocation& t_OutAllocation)
+		{
+			VkDeviceSize Offset = 0;
+			if (!t_Block.SubAllocator->Allocate(t_Size, t_Alignment, Offset))
+			{
+				return false;
+			}
+
+			MemoryBlock::AllocationRecord& Record = t_Block.Allocations[Offset];
+			Record.Size = t_Size;
+			Record.Alignment = t_Alignment;
+			t_Block.UsedBytes += t_Size;
+
+			t_OutAllocation = MakeAllocation(t_Block, Offset, t_Size);
+			return true;
+		}
+	}   // namespace
+
+	// Vulkan backend ----------------------------------
+
+	VkDeviceMemory VulkanMemoryBackend::AllocateMemory(UINT32 t_MemoryTypeIndex, VkDeviceSize t_Size)
+	{
+		VkMemoryAllocateInfo AllocInfo = {};
+		AllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		AllocInfo.allocationSize = t_Size;
+		AllocInfo.memoryTypeIndex = t_MemoryTypeIndex;
+
+		VkDeviceMemory Memory = VK_NULL_HANDLE;
+		if (vkAllocateMemory(m_Device, &AllocInfo, nullptr, &Memory) != VK_SUCCESS)
+		{
+			return VK_NULL_HANDLE;
+		}
+		return Memory;
+	}
+
+	void VulkanMemoryBackend::FreeMemory(VkDeviceMemory t_Memory)
+	{
+		vkFreeMemory(m_Device, t_Memory, nullptr);
+	}
+
+	void* VulkanMemoryBackend::MapMemory(VkDeviceMemory t_Memory)
+	{
+		void* Data = nullptr;
+		if (vkMapMemory(m_Device, t_Memory, 0, VK_WHOLE_SIZE, 0, &Data) != VK_SUCCESS)
+		{
+			F_LOG_ERROR("Failed to map device memory block!");
+			return nullptr;
+		}
+		return Data;
+	}
+
+	void VulkanMemoryBackend::UnmapMemory(VkDeviceMemory t_Memory)
+	{
+		vkUnmapMemory(m_Device, t_Memory);
+	}
+
+	// Buddy sub allocator ----------------------------------
+
+	BuddySubAllocator::BuddySubAllocator(VkDeviceSize t_Size, VkDeviceSize t_MinNodeSize)
+		: m_Size(t_Size)
+	{
+		assert(IsPowerOfTwo(t_Size) && IsPowerOfTwo(t_MinNodeSize) && t_MinNodeSize <= t_Size);
+
+		for (VkDeviceSize NodeSize = t_Size; NodeSize >= t_MinNodeSize; NodeSize >>= 1)
+		{
+			++m_LevelCount;
+		}
+
+		m_FreeLists.resize(m_LevelCount);
+		m_FreeLists[0].insert(0);
+	}
+
+	bool BuddySubAllocator::Allocate(VkDeviceSize t_Size, VkDeviceSize t_Alignment, VkDeviceSize& t_OutOffset)
+	{
+		assert(IsPowerOfTwo(t_Alignment));
+
+		// Nodes are aligned to their own size, so a node that is at least as big as the alignment is aligned
+		const VkDeviceSize Needed = std::max(t_Size, t_Alignment);
+		if (Needed > m_Size)
+		{
+			return false;
+		}
+
+		// Find the smallest node size that fits
+		UINT32 Level = m_LevelCount - 1;
+		while (Level > 0 && GetNodeSize(Level) < Needed)
+		{
+			--Level;
+		}
+
+		// Find the closest level with a free node that we can split down
+		INT32 FreeLevel = static_cast<INT32>(Level);
+		while (FreeLevel >= 0 && m_FreeLists[FreeLevel].empty())
+		{
+			--FreeLevel;
+		}
+
+		if (FreeLevel < 0)
+		{
+			return false;
+		}
+
+		// Use the lowest offset to keep allocations packed at the start of the block
+		const VkDeviceSize Offset = *m_FreeLists[FreeLevel].begin();
+		m_FreeLists[FreeLevel].erase(m_FreeLists[FreeLevel].begin());
+
+		// Keep the first half of every split and free the second
+		for (UINT32 Split = static_cast<UINT32>(FreeLevel) + 1; Split <= Level; ++Split)
+		{
+			m_FreeLists[Split].insert(Offset + GetNodeSize(Split));
+		}
+
+		m_AllocatedLevels[Offset] = Level;
+		m_ReservedSize += GetNodeSize(Level);
+
+		t_OutOffset = Offset;
+		return true;
+	}
+
+	void BuddySubAllocator::Free(VkDeviceSize t_Offset)
+	{
+		auto It = m_AllocatedLevels.find(t_Offset);
+		assert(It != m_AllocatedLevels.end() && "Freeing an offset that was not allocated!");
+
+		UINT32 Level = It->second;
+		m_AllocatedLevels.erase(It);
+		m_ReservedSize -= GetNodeSize(Level);
+
+		// Merge with our buddy for as long as it is free
+		VkDeviceSize Offset = t_Offset;
+		while (Level > 0)
+		{
+			const VkDeviceSize Buddy = Offset ^ GetNodeSize(Level);
+			auto BuddyIt = m_FreeLists[Level].find(Buddy);
+			if (BuddyIt == m_FreeLists[Level].end())
+			{
+				break;
+			}
+
+			m_FreeLists[Level].erase(BuddyIt);
+			Offset = std::min(Offset, Buddy);
+			--Level;
+		}
+
+		m_FreeLists[Level].insert(Offset);
+	}
+
+	// Linear sub allocator ----------------------------------
+
+	bool LinearSubAllocator::Allocate(VkDeviceSize t_Size, VkDeviceSize t_Alignment, VkDeviceSize& t_OutOffset)
+	{
+		assert(IsPowerOfTwo(t_Alignment));
+
+		const VkDeviceSize Offset = AlignUp(m_Head, t_Alignment);
+		if (Offset + t_Size > m_Size)
+		{
+			return false;
+		}
+
+		m_Head = Offset + t_Size;
+		++m_AllocationCount;
+
+		t_OutOffset = Offset;
+		return true;
+	}
+
+	void LinearSubAllocator::Free(VkDeviceSize t_Offset)
+	{
+		assert(m_AllocationCount > 0 && t_Offset < m_Head);
+
+		// Memory can only be reused once everything in the block is done with it
+		if (--m_AllocationCount == 0)
+		{
+			m_Head = 0;
+		}
+	}
+
+	// Device memory allocator ----------------------------------
+
+	DeviceMemoryAllocator::DeviceMemoryAllocator(
+		const VkPhysicalDeviceMemoryProperties& t_MemoryProperties,
+		VkDeviceSize t_NonCoherentAtomSize,
+		std::unique_ptr<DeviceMemoryBackend> t_Backend,
+		const Config& t_Config)
+		: m_MemoryProperties(t_MemoryProperties)
+		, m_NonCoherentAtomSize(std::max<VkDeviceSize>(t_NonCoherentAtomSize, 1))
+		, m_Backend(std::move(t_Backend))
+		, m_Config(t_Config)
+	{
+		assert(m_Backend);
+		assert(IsPowerOfTwo(m_Config.BlockSize) && IsPowerOfTwo(m_Config.MinAllocationSize));
+
+		m_Pools.resize(GetPoolIndex(m_MemoryProperties.memoryTypeCount, ResourceLayout::Linear, AllocationStrategy::Buddy));
+	}
+
+	DeviceMemoryAllocator::~DeviceMemoryAllocator()
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+
+		for (MemoryPool& Pool : m_Pools)
+		{
+			for (std::unique_ptr<MemoryBlock>& Block : Pool.Blocks)
+			{
+				if (!Block->Allocations.empty())
+				{
+					F_LOG_WARN("Device memory block is destroyed with {} allocations still alive!", Block->Allocations.size());
+				}
+				DestroyBlock(Block);
+			}
+			Pool.Blocks.clear();
+		}
+
+		for (auto& Dedicated : m_DedicatedAllocations)
+		{
+			F_LOG_WARN("Dedicated device memory allocation of {} bytes was never freed!", Dedicated.second.Size);
+			m_Backend->FreeMemory(Dedicated.first);
+		}
+		m_DedicatedAllocations.clear();
+	}
+
+	bool DeviceMemoryAllocator::Allocate(
+		const VkMemoryRequirements& t_Requirements,
+		VkMemoryPropertyFlags t_Properties,
+		ResourceLayout t_Layout,
+		DeviceAllocation& t_OutAllocation,
+		AllocationStrategy t_Strategy)
+	{
+		t_OutAllocation = {};
+
+		const UINT32 TypeIndex = FindMemoryType(t_Requirements.memoryTypeBits, t_Properties);
+		if (TypeIndex == ~0u)
+		{
+			F_LOG_ERROR("Failed to find a suitable memory type for an allocation of {} bytes!", t_Requirements.size);
+			return false;
+		}
+
+		VkDeviceSize Size = t_Requirements.size;
+		VkDeviceSize Alignment = std::max<VkDeviceSize>(t_Requirements.alignment, 1);
+
+		// Flushed ranges of non coherent memory have to line up with the atom size, so
+		// make sure that two allocations never share one
+		const VkMemoryPropertyFlags TypeFlags = m_MemoryProperties.memoryTypes[TypeIndex].propertyFlags;
+		if ((TypeFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(TypeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+		{
+			Alignment = std::max(Alignment, m_NonCoherentAtomSize);
+			Size = AlignUp(Size, m_NonCoherentAtomSize);
+		}
+
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+
+		// Large resources would waste most of a block, give them their own memory
+		if (Size > GetBlockSize(TypeIndex) / 2)
+		{
+			return AllocateDedicated(TypeIndex, Size, t_OutAllocation);
+		}
+
+		const UINT32 PoolIndex = GetPoolIndex(TypeIndex, t_Layout, t_Strategy);
+		if (AllocateFromPool(m_Pools[PoolIndex], Size, Alignment, nullptr, t_OutAllocation))
+		{
+			return true;
+		}
+
+		if (MemoryBlock* NewBlock = CreateBlock(PoolIndex, TypeIndex, t_Strategy))
+		{
+			return AllocateFromBlock(*NewBlock, Size, Alignment, t_OutAllocation);
+		}
+
+		// There is not enough memory for a whole block, try for just what we need
+		return AllocateDedicated(TypeIndex, Size, t_OutAllocation);
+	}
+
+	void DeviceMemoryAllocator::Free(DeviceAllocation& t_Allocation)
+	{
+		if (!t_Allocation.IsValid())
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+
+		if (t_Allocation.Block)
+		{
+			const UINT32 PoolIndex = t_Allocation.Block->PoolIndex;
+			FreeFromBlock(t_Allocation);
+			TrimPool(m_Pools[PoolIndex]);
+		}
+		else
+		{
+			auto It = m_DedicatedAllocations.find(t_Allocation.Memory);
+			assert(It != m_DedicatedAllocations.end() && "Freeing memory that was not allocated by this allocator!");
+			m_DedicatedAllocations.erase(It);
+
+			if (t_Allocation.MappedData)
+			{
+				m_Backend->UnmapMemory(t_Allocation.Memory);
+			}
+			m_Backend->FreeMemory(t_Allocation.Memory);
+		}
+
+		t_Allocation = {};
+	}
+
+	void DeviceMemoryAllocator::SetMoveCallback(const DeviceAllocation& t_Allocation, MoveCallback t_Callback)
+	{
+		// Dedicated allocations are never moved
+		if (!t_Allocation.Block)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		auto It = t_Allocation.Block->Allocations.find(t_Allocation.Offset);
+		assert(It != t_Allocation.Block->Allocations.end());
+		It->second.OnMove = std::move(t_Callback);
+	}
+
+	UINT32 DeviceMemoryAllocator::Defragment(UINT32 t_MaxMoves)
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		UINT32 MoveCount = 0;
+
+		for (MemoryPool& Pool : m_Pools)
+		{
+			// Linear blocks rewind on their own once they are empty
+			if (Pool.Blocks.size() < 2 || Pool.Blocks.front()->Strategy == AllocationStrategy::Linear)
+			{
+				continue;
+			}
+
+			// Try and empty out the block with the least amount of memory in use
+			MemoryBlock* Source = nullptr;
+			for (std::unique_ptr<MemoryBlock>& Block : Pool.Blocks)
+			{
+				if (!Block->Allocations.empty() && (!Source || Block->SubAllocator->GetReservedSize() < Source->SubAllocator->GetReservedSize()))
+				{
+					Source = Block.get();
+				}
+			}
+
+			if (!Source)
+			{
+				continue;
+			}
+
+			std::vector<VkDeviceSize> MovableOffsets;
+			for (const auto& Alloc : Source->Allocations)
+			{
+				if (Alloc.second.OnMove)
+				{
+					MovableOffsets.emplace_back(Alloc.first);
+				}
+			}
+
+			for (VkDeviceSize Offset : MovableOffsets)
+			{
+				if (MoveCount >= t_MaxMoves)
+				{
+					break;
+				}
+
+				MemoryBlock::AllocationRecord& Record = Source->Allocations[Offset];
+				DeviceAllocation From = MakeAllocation(*Source, Offset, Record.Size);
+				DeviceAllocation To = {};
+
+				if (!AllocateFromPool(Pool, Record.Size, Record.Alignment, Source, To))
+				{
+					continue;
+				}
+
+				if (Record.OnMove(From, To))
+				{
+					To.Block->Allocations[To.Offset].OnMove = std::move(Record.OnMove);
+					FreeFromBlock(From);
+					++MoveCount;
+				}
+				else
+				{
+					FreeFromBlock(To);
+				}
+			}
+
+			// Give back the block that we emptied
+			TrimPool(Pool, false);
+		}
+
+		return MoveCount;
+	}
+
+	UINT32 DeviceMemoryAllocator::FindMemoryType(UINT32 t_TypeBits, VkMemoryPropertyFlags t_Properties) const
+	{
+		for (UINT32 i = 0; i < m_MemoryProperties.memoryTypeCount; ++i)
+		{
+			if ((t_TypeBits & (1u << i)) && (m_MemoryProperties.memoryTypes[i].propertyFlags & t_Properties) == t_Properties)
+			{
+				return i;
+			}
+		}
+		return ~0u;
+	}
+
+	DeviceMemoryStats DeviceMemoryAllocator::GetStats() const
+	{
+		DeviceMemoryStats Total = {};
+		for (UINT32 i = 0; i < m_MemoryProperties.memoryTypeCount; ++i)
+		{
+			DeviceMemoryStats TypeStats = GetStats(i);
+			Total.BlockCount += TypeStats.BlockCount;
+			Total.DedicatedAllocationCount += TypeStats.DedicatedAllocationCount;
+			Total.AllocationCount += TypeStats.AllocationCount;
+			Total.AllocatedBytes += TypeStats.AllocatedBytes;
+			Total.UsedBytes += TypeStats.UsedBytes;
+		}
+		return Total;
+	}
+
+	DeviceMemoryStats DeviceMemoryAllocator::GetStats(UINT32 t_MemoryTypeIndex) const
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		DeviceMemoryStats Stats = {};
+
+		const UINT32 FirstPool = GetPoolIndex(t_MemoryTypeIndex, ResourceLayout::Linear, AllocationStrategy::Buddy);
+		const UINT32 LastPool = GetPoolIndex(t_MemoryTypeIndex + 1, ResourceLayout::Linear, AllocationStrategy::Buddy);
+		for (UINT32 i = FirstPool; i < LastPool && i < m_Pools.size(); ++i)
+		{
+			for (const std::unique_ptr<MemoryBlock>& Block : m_Pools[i].Blocks)
+			{
+				++Stats.BlockCount;
+				Stats.AllocationCount += static_cast<UINT32>(Block->Allocations.size());
+				Stats.AllocatedBytes += Block->Size;
+				Stats.UsedBytes += Block->UsedBytes;
+			}
+		}
+
+		for (const auto& Dedicated : m_DedicatedAllocations)
+		{
+			if (Dedicated.second.MemoryTypeIndex == t_MemoryTypeIndex)
+			{
+				++Stats.DedicatedAllocationCount;
+				++Stats.AllocationCount;
+				Stats.AllocatedBytes += Dedicated.second.Size;
+				Stats.UsedBytes += Dedicated.second.Size;
+			}
+		}
+
+		return Stats;
+	}
+
+	UINT32 DeviceMemoryAllocator::GetPoolIndex(UINT32 t_MemoryTypeIndex, ResourceLayout t_Layout, AllocationStrategy t_Strategy)
+	{
+		return t_MemoryTypeIndex * 4 + static_cast<UINT32>(t_Layout) * 2 + static_cast<UINT32>(t_Strategy);
+	}
+
+	VkDeviceSize DeviceMemoryAllocator::GetBlockSize(UINT32 t_MemoryTypeIndex) const
+	{
+		// Don't let a single block take up a large part of a small heap
+		const UINT32 HeapIndex = m_MemoryProperties.memoryTypes[t_MemoryTypeIndex].heapIndex;
+		const VkDeviceSize HeapSize = m_MemoryProperties.memoryHeaps[HeapIndex].size;
+
+		VkDeviceSize BlockSize = m_Config.BlockSize;
+		while (BlockSize > HeapSize / 8 && BlockSize > m_Config.MinAllocationSize * 2)
+		{
+			BlockSize >>= 1;
+		}
+		return BlockSize;
+	}
+
+	MemoryBlock* DeviceMemoryAllocator::CreateBlock(UINT32 t_PoolIndex, UINT32 t_MemoryTypeIndex, AllocationStrategy t_Strategy)
+	{
+		const VkMemoryType& Type = m_MemoryProperties.memoryTypes[t_MemoryTypeIndex];
+		const VkDeviceSize BlockSize = GetBlockSize(t_MemoryTypeIndex);
+
+		VkDeviceMemory Memory = m_Backend->AllocateMemory(t_MemoryTypeIndex, BlockSize);
+		if (Memory == VK_NULL_HANDLE)
+		{
+			F_LOG_WARN("Failed to allocate a device memory block of {} bytes", BlockSize);
+			return nullptr;
+		}
+
+		std::unique_ptr<MemoryBlock> Block = std::make_unique<MemoryBlock>();
+		Block->Memory = Memory;
+		Block->Size = BlockSize;
+		Block->MemoryTypeIndex = t_MemoryTypeIndex;
+		Block->PoolIndex = t_PoolIndex;
+		Block->Strategy = t_Strategy;
+
+		if (t_Strategy == AllocationStrategy::Linear)
+		{
+			Block->SubAllocator = std::make_unique<LinearSubAllocator>(BlockSize);
+		}
+		else
+		{
+			Block->SubAllocator = std::make_unique<BuddySubAllocator>(BlockSize, m_Config.MinAllocationSize);
+		}
+
+		if (Type.propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		{
+			Block->MappedData = m_Backend->MapMemory(Memory);
+		}
+
+		m_Pools[t_PoolIndex].Blocks.emplace_back(std::move(Block));
+		return m_Pools[t_PoolIndex].Blocks.back().get();
+	}
+
+	void DeviceMemoryAllocator::DestroyBlock(std::unique_ptr<MemoryBlock>& t_Block)
+	{
+		if (t_Block->MappedData)
+		{
+			m_Backend->UnmapMemory(t_Block->Memory);
+		}
+		m_Backend->FreeMemory(t_Block->Memory);
+		t_Block.reset();
+	}
+
+	bool DeviceMemoryAllocator::AllocateFromPool(MemoryPool& t_Pool, VkDeviceSize t_Size, VkDeviceSize t_Alignment, const MemoryBlock* t_Exclude, DeviceAllocation& t_OutAllocation)
+	{
+		for (std::unique_ptr<MemoryBlock>& Block : t_Pool.Blocks)
+		{
+			if (Block.get() != t_Exclude && AllocateFromBlock(*Block, t_Size, t_Alignment, t_OutAllocation))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool DeviceMemoryAllocator::AllocateDedicated(UINT32 t_MemoryTypeIndex, VkDeviceSize t_Size, DeviceAllocation& t_OutAllocation)
+	{
+		VkDeviceMemory Memory = m_Backend->AllocateMemory(t_MemoryTypeIndex, t_Size);
+		if (Memory == VK_NULL_HANDLE)
+		{
+			F_LOG_ERROR("Out of device memory! Failed to allocate {} bytes", t_Size);
+			return false;
+		}
+
+		m_DedicatedAllocations[Memory] = { t_Size, t_MemoryTypeIndex };
+
+		t_OutAllocation = {};
+		t_OutAllocation.Memory = Memory;
+		t_OutAllocation.Size = t_Size;
+		t_OutAllocation.MemoryTypeIndex = t_MemoryTypeIndex;
+
+		if (m_MemoryProperties.memoryTypes[t_MemoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		{
+			t_OutAllocation.MappedData = m_Backend->MapMemory(Memory);
+		}
+		return true;
+	}
+
+	void DeviceMemoryAllocator::FreeFromBlock(DeviceAllocation& t_Allocation)
+	{
+		MemoryBlock* Block = t_Allocation.Block;
+		assert(Block);
+
+		auto It = Block->Allocations.find(t_Allocation.Offset);
+		assert(It != Block->Allocations.end() && "Freeing memory that was not allocated by this allocator!");
+
+		Block->UsedBytes -= It->second.Size;
+		Block->Allocations.erase(It);
+		Block->SubAllocator->Free(t_Allocation.Offset);
+	}
+
+	void DeviceMemoryAllocator::TrimPool(MemoryPool& t_Pool, bool t_KeepEmptyBlock)
+	{
+		bool KeptEmptyBlock = !t_KeepEmptyBlock;
+		for (auto It = t_Pool.Blocks.begin(); It != t_Pool.Blocks.end();)
+		{
+			if ((*It)->SubAllocator->IsEmpty())
+			{
+				if (!KeptEmptyBlock)
+				{
+					KeptEmptyBlock = true;
+					++It;
+					continue;
+				}
+
+				DestroyBlock(*It);
+				It = t_Pool.Blocks.erase(It);
+			}
+			else
+			{
+				++It;
+			}
+		}
+	}
+}   // namespace Fling
@@ -0,0 +1,261 @@
+#include "pch.h"
+#include "DrawList.h"
+#include "CommandBuffer.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace Fling
+{
+	namespace
+	{
+		constexpr UINT64 FieldMask(UINT32 t_Bits)
+		{
+			return (UINT64(1) << t_Bits) - 1;
+		}
+
+		static_assert(DrawList::PassBits + DrawList::PipelineBits + DrawList::MaterialBits + DrawList::MeshBits + DrawList::DepthBits == 64, "Sort key fields have to fill the key");
+	}
+
+	UINT64 DrawList::MakeKey(UINT32 t_Pass, UINT32 t_Pipeline, UINT32 t_Material, UINT32 t_Mesh, float t_Depth)
+	{
+		UINT64 Key = t_Pass & FieldMask(PassBits);
+		Key = (Key << PipelineBits) | (t_Pipeline & FieldMask(PipelineBits));
+		Key = (Key << MaterialBits) | (t_Material & FieldMask(MaterialBits));
+		Key = (Key << MeshBits) | (t_Mesh & FieldMask(MeshBits));
+		Key = (Key << DepthBits) | QuantizeDepth(t_Depth);
+		return Key;
+	}
+
+	UINT32 DrawList::GetSortId(const void* t_Object, UINT32 t_Bits)
+	{
+		if (t_Bits == 0)
+		{
+			return 0;
+		}
+
+		// Fibonacci hashing spreads the aligned pointer bits out over the top of the product
+		const UINT64 Hash = static_cast<UINT64>(reinterpret_cast<uintptr_t>(t_Object)) * 0x9E3779B97F4A7C15ull;
+		return static_cast<UINT32>(Hash >> (64 - t_Bits));
+	}
+
+	UINT32 DrawList::QuantizeDepth(float t_Depth)
+	{
+		// Positive floats have the same order as their bits, so the top bits are a log scale of the depth
+		if (!(t_Depth > 0.0f))
+		{
+			return 0;
+		}
+
+		UINT32 Bits = 0;
+		std::memcpy(&Bits, &t_Depth, sizeof(Bits));
+		return Bits >> (32 - DepthBits);
+	}
+
+	void DrawList::RadixSort(std::vector<DrawListItem>& t_Items, std::vector<DrawListItem>& t_Scratch)
+	{
+		const UINT32 Count = static_cast<UINT32>(t_Items.size());
+		if (Count < MinRadixSortCount)
+		{
+			std::stable_sort(t_Items.begin(), t_Items.end(), [](const DrawListItem& t_A, const DrawListItem& t_B) { return t_A.Key < t_B.Key; });
+			return;
+		}
+
+		// Bytes that are the same in every key don't change the order
+		UINT64 AllSet = ~UINT64(0);
+		UINT64 AnySet = 0;
+		for (const DrawListItem& Item : t_Items)
+		{
+			AllSet &= Item.Key;
+			AnySet |= Item.Key;
+		}
+		const UINT64 Differs = AllSet ^ AnySet;
+
+		// Every pass splits the items into the same chunks, one job each
+		const UINT32 ThreadCount = std::max<UINT32>(JobSystem::Get().GetThreadCount(), 1);
+		const UINT32 ChunkCount = std::max<UINT32>(std::min<UINT32>(ThreadCount, Count / MinRadixChunkSize), 1);
+		std::vector<std::array<UINT32, 256>> Offsets(ChunkCount);
+
+		t_Scratch.resize(Count);
+		DrawListItem* Src = t_Items.data();
+		DrawListItem* Dst = t_Scratch.data();
+
+		for (UINT32 Shift = 0; Shift < 64; Shift += 8)
+		{
+			if (((Differs >> Shift) & 0xFF) == 0)
+			{
+				continue;
+			}
+
+			JobSystem::ParallelFor(ChunkCount, 1, [&](UINT32 t_Begin, UINT32 t_End)
+			{
+				for (UINT32 Chunk = t_Begin; Chunk < t_End; ++Chunk)
+				{
+					std::array<UINT32, 256>& Histogram = Offsets[Chunk];
+					Histogram.fill(0);
+
+					const UINT32 First = static_cast<UINT32>(static_cast<UINT64>(Count) * Chunk / ChunkCount);
+					const UINT32 Last = static_cast<UINT32>(static_cast<UINT64>(Count) * (Chunk + 1) / ChunkCount);
+					for (UINT32 i = First; i < Last; ++i)
+					{
+						++Histogram[(Src[i].Key >> Shift) & 0xFF];
+					}
+				}
+			});
+
+			// Each chunk writes a digit after the chunks before it, which keeps the sort stable
+			UINT32 Offset = 0;
+			for (UINT32 Digit = 0; Digit < 256; ++Digit)
+			{
+				for (UINT32 Chunk = 0; Chunk < ChunkCount; ++Chunk)
+				{
+					const UINT32 DigitCount = Offsets[Chunk][Digit];
+					Offsets[Chunk][Digit] = Offset;
+					Offset += DigitCount;
+				}
+			}
+
+			JobSystem::ParallelFor(ChunkCount, 1, [&](UINT32 t_Begin, UINT32 t_End)
+			{
+				for (UINT32 Chunk = t_Begin; Chunk < t_End; ++Chunk)
+				{
+					std::array<UINT32, 256>& ChunkOffsets = Offsets[Chunk];
+
+					const UINT32 First = static_cast<UINT32>(static_cast<UINT64>(Count) * Chunk / ChunkCount);
+					const UINT32 Last = static_cast<UINT32>(static_cast<UINT64>(Count) * (Chunk + 1) / ChunkCount);
+					for (UINT32 i = First; i < Last; ++i)
+					{
+						Dst[ChunkOffsets[(Src[i].Key >> Shift) & 0xFF]++] = Src[i];
+					}
+				}
+			});
+
+			std::swap(Src, Dst);
+		}
+
+		// An odd number of passes leaves the sorted items in the scratch space
+		if (Src != t_Items.data())
+		{
+			t_Items.swap(t_Scratch);
+		}
+	}
+
+	void DrawList::Clear()
+	{
+		m_Items.clear();
+		m_Commands.clear();
+	}
+
+	void DrawList::Add(UINT64 t_Key, const DrawCommand& t_Command)
+	{
+		m_Items.push_back({ t_Key, static_cast<UINT32>(m_Commands.size()) });
+		m_Commands.push_back(t_Command);
+	}
+
+	void DrawList::Sort()
+	{
+		RadixSort(m_Items, m_Scratch);
+	}
+
+	void DrawList::Record(CommandBuffer& t_CmdBuf)
+	{
+		VkCommandBuffer CmdHandle = t_CmdBuf.GetHandle();
+		VkDeviceSize Offsets[1] = { 0 };
+
+		// Nothing that was bound before the list is trusted
+		DrawStateTracker State;
+
+		for (const DrawListItem& Item : m_Items)
+		{
+			const DrawCommand& Draw = m_Commands[Item.Command];
+
+			if (State.SetPipeline(Draw.Pipeline, Draw.PipelineLayout))
+			{
+				t_CmdBuf.BindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, Draw.Pipeline);
+			}
+
+			if (Draw.DescriptorSet != VK_NULL_HANDLE && State.SetDescriptorSet(Draw.DescriptorSet, Draw.DynamicOffsetCount > 0 ? Draw.DynamicOffset : 0))
+			{
+				vkCmdBindDescriptorSets(
+					CmdHandle,
+					VK_PIPELINE_BIND_POINT_GRAPHICS,
+					Draw.PipelineLayout,
+					0,
+					1,
+					&Draw.DescriptorSet,
+					Draw.DynamicOffsetCount,
+					&Draw.DynamicOffset);
+			}
+
+			if (State.SetVertexBuffer(Draw.VertexBuffer))
+			{
+				vkCmdBindVertexBuffers(CmdHandle, 0, 1, &Draw.VertexBuffer, Offsets);
+			}
+
+			if (State.SetIndexBuffer(Draw.IndexBuffer, Draw.IndexType))
+			{
+				vkCmdBindIndexBuffer(CmdHandle, Draw.IndexBuffer, 0, Draw.IndexType);
+			}
+
+			vkCmdDrawIndexed(CmdHandle, Draw.IndexCount, Draw.InstanceCount, Draw.FirstIndex, 0, Draw.FirstInstance);
+			State.AddDraw();
+		}
+
+		m_Stats = State.GetStats();
+	}
+
+	bool DrawStateTracker::SetPipeline(VkPipeline t_Pipeline, VkPipelineLayout t_Layout)
+	{
+		if (t_Pipeline == m_Pipeline && t_Layout == m_Layout)
+		{
+			return false;
+		}
+
+		// Sets only stay bound across compatible layouts, so don't trust them after any change
+		m_Pipeline = t_Pipeline;
+		m_Layout = t_Layout;
+		m_Set = VK_NULL_HANDLE;
+		++m_Stats.PipelineBinds;
+		return true;
+	}
+
+	bool DrawStateTracker::SetDescriptorSet(VkDescriptorSet t_Set, UINT32 t_DynamicOffset)
+	{
+		if (t_Set == m_Set && t_DynamicOffset == m_DynamicOffset)
+		{
+			return false;
+		}
+
+		m_Set = t_Set;
+		m_DynamicOffset = t_DynamicOffset;
+		++m_Stats.DescriptorSetBinds;
+		return true;
+	}
+
+	bool DrawStateTracker::SetVertexBuffer(VkBuffer t_Buffer)
+	{
+		if (t_Buffer == m_VertexBuffer)
+		{
+			return false;
+		}
+
+		m_VertexBuffer = t_Buffer;
+		++m_Stats.VertexBufferBinds;
+		return true;
+	}
+
+	bool DrawStateTracker::SetIndexBuffer(VkBuffer t_Buffer, VkIndexType t_IndexType)
+	{
+		if (t_Buffer == m_IndexBuffer && t_IndexType == m_IndexType)
+		{
+			return false;
+		}
+
+		m_IndexBuffer = t_Buffer;
+		m_IndexType = t_IndexType;
+		++m_Stats.IndexBufferBinds;
+		return true;
+	}
+}   // namespace Fling
@@ -1,5 +1,6 @@
 #include "FrameBuffer.h"
 #include "GraphicsHelpers.h"
+#include "VulkanApp.h"
 
 namespace Fling
 {
@@ -103,9 +104,9 @@ namespace Fling
 			vkDestroyImageView(m_Device, m_ImageView, nullptr);
 		}
 
-		if (m_Memory != VK_NULL_HANDLE)
+		if (m_Memory.IsValid())
 		{
-			vkFreeMemory(m_Device, m_Memory, nullptr);
+			VulkanApp::Get().GetMemoryAllocator()->Free(m_Memory);
 		}
 	}
 
@@ -245,9 +246,12 @@ namespace Fling
 		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
 		dependencies[0].dstSubpass = 0;
 		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		// Frames in flight share the attachments, so the depth tests wait for the previous frame as well
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
 		dependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-		dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependencies[0].dstAccessMask = 
+			VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | 
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 		dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
 
 		dependencies[1].srcSubpass = 0;
@@ -0,0 +1,181 @@
+#include "pch.h"
+#include "Frustum.h"
+
+#if defined(__AVX__)
+#	include <immintrin.h>
+#	define FLING_FRUSTUM_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	include <emmintrin.h>
+#	define FLING_FRUSTUM_SSE 1
+#endif
+
+namespace Fling
+{
+	Frustum::Frustum(const glm::mat4& t_ViewProj)
+	{
+		// Gribb/Hartmann plane extraction, done on the rows of the matrix. GLM is column major
+		const glm::vec4 Row0 = { t_ViewProj[0][0], t_ViewProj[1][0], t_ViewProj[2][0], t_ViewProj[3][0] };
+		const glm::vec4 Row1 = { t_ViewProj[0][1], t_ViewProj[1][1], t_ViewProj[2][1], t_ViewProj[3][1] };
+		const glm::vec4 Row2 = { t_ViewProj[0][2], t_ViewProj[1][2], t_ViewProj[2][2], t_ViewProj[3][2] };
+		const glm::vec4 Row3 = { t_ViewProj[0][3], t_ViewProj[1][3], t_ViewProj[2][3], t_ViewProj[3][3] };
+
+		m_Planes[Left] = Row3 + Row0;
+		m_Planes[Right] = Row3 - Row0;
+		m_Planes[Bottom] = Row3 + Row1;
+		m_Planes[Top] = Row3 - Row1;
+		// Depth is 0 to 1, so the near plane is just z >= 0
+		m_Planes[Near] = Row2;
+		m_Planes[Far] = Row3 - Row2;
+
+		for (glm::vec4& P : m_Planes)
+		{
+			const float Len = glm::length(glm::vec3(P));
+			if (Len > 0.0f)
+			{
+				P /= Len;
+			}
+		}
+	}
+
+	bool Frustum::Intersects(const BoundingSphere& t_Sphere) const
+	{
+		for (const glm::vec4& P : m_Planes)
+		{
+			if (glm::dot(glm::vec3(P), t_Sphere.Center) + P.w < -t_Sphere.Radius)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool Frustum::Intersects(const BoundingBox& t_Box) const
+	{
+		for (const glm::vec4& P : m_Planes)
+		{
+			// The corner of the box that is furthest along the plane normal
+			const glm::vec3 Positive = {
+				P.x >= 0.0f ? t_Box.Max.x : t_Box.Min.x,
+				P.y >= 0.0f ? t_Box.Max.y : t_Box.Min.y,
+				P.z >= 0.0f ? t_Box.Max.z : t_Box.Min.z
+			};
+
+			if (glm::dot(glm::vec3(P), Positive) + P.w < 0.0f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	UINT32 Frustum::CullSpheres(
+		const float* t_X,
+		const float* t_Y,
+		const float* t_Z,
+		const float* t_Radius,
+		UINT32 t_Count,
+		UINT32* t_OutVisible) const
+	{
+		UINT32 VisibleCount = 0;
+		UINT32 i = 0;
+
+#if FLING_FRUSTUM_AVX
+
+		__m256 PlaneX[Plane::Count], PlaneY[Plane::Count], PlaneZ[Plane::Count], PlaneW[Plane::Count];
+		for (UINT32 p = 0; p < Plane::Count; ++p)
+		{
+			PlaneX[p] = _mm256_set1_ps(m_Planes[p].x);
+			PlaneY[p] = _mm256_set1_ps(m_Planes[p].y);
+			PlaneZ[p] = _mm256_set1_ps(m_Planes[p].z);
+			PlaneW[p] = _mm256_set1_ps(m_Planes[p].w);
+		}
+
+		for (; i + 8 <= t_Count; i += 8)
+		{
+			const __m256 X = _mm256_loadu_ps(t_X + i);
+			const __m256 Y = _mm256_loadu_ps(t_Y + i);
+			const __m256 Z = _mm256_loadu_ps(t_Z + i);
+			const __m256 NegRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(t_Radius + i));
+
+			// A sphere is outside if it is entirely behind any plane
+			__m256 Inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (UINT32 p = 0; p < Plane::Count; ++p)
+			{
+				__m256 Dist = _mm256_add_ps(_mm256_mul_ps(X, PlaneX[p]), PlaneW[p]);
+				Dist = _mm256_add_ps(Dist, _mm256_mul_ps(Y, PlaneY[p]));
+				Dist = _mm256_add_ps(Dist, _mm256_mul_ps(Z, PlaneZ[p]));
+				Inside = _mm256_and_ps(Inside, _mm256_cmp_ps(Dist, NegRadius, _CMP_GE_OQ));
+			}
+
+			UINT32 Mask = static_cast<UINT32>(_mm256_movemask_ps(Inside));
+			for (UINT32 Lane = 0; Mask != 0; ++Lane, Mask >>= 1)
+			{
+				if (Mask & 1u)
+				{
+					t_OutVisible[VisibleCount++] = i + Lane;
+				}
+			}
+		}
+
+#elif FLING_FRUSTUM_SSE
+
+		__m128 PlaneX[Plane::Count], PlaneY[Plane::Count], PlaneZ[Plane::Count], PlaneW[Plane::Count];
+		for (UINT32 p = 0; p < Plane::Count; ++p)
+		{
+			PlaneX[p] = _mm_set1_ps(m_Planes[p].x);
+			PlaneY[p] = _mm_set1_ps(m_Planes[p].y);
+			PlaneZ[p] = _mm_set1_ps(m_Planes[p].z);
+			PlaneW[p] = _mm_set1_ps(m_Planes[p].w);
+		}
+
+		for (; i + 4 <= t_Count; i += 4)
+		{
+			const __m128 X = _mm_loadu_ps(t_X + i);
+			const __m128 Y = _mm_loadu_ps(t_Y + i);
+			const __m128 Z = _mm_loadu_ps(t_Z + i);
+			const __m128 NegRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(t_Radius + i));
+
+			// A sphere is outside if it is entirely behind any plane
+			__m128 Inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (UINT32 p = 0; p < Plane::Count; ++p)
+			{
+				__m128 Dist = _mm_add_ps(_mm_mul_ps(X, PlaneX[p]), PlaneW[p]);
+				Dist = _mm_add_ps(Dist, _mm_mul_ps(Y, PlaneY[p]));
+				Dist = _mm_add_ps(Dist, _mm_mul_ps(Z, PlaneZ[p]));
+				Inside = _mm_and_ps(Inside, _mm_cmpge_ps(Dist, NegRadius));
+			}
+
+			UINT32 Mask = static_cast<UINT32>(_mm_movemask_ps(Inside));
+			for (UINT32 Lane = 0; Mask != 0; ++Lane, Mask >>= 1)
+			{
+				if (Mask & 1u)
+				{
+					t_OutVisible[VisibleCount++] = i + Lane;
+				}
+			}
+		}
+
+#endif
+
+		// Whatever doesn't fill a full SIMD register
+		for (; i < t_Count; ++i)
+		{
+			bool Inside = true;
+			for (const glm::vec4& P : m_Planes)
+			{
+				if (P.x * t_X[i] + P.w + P.y * t_Y[i] + P.z * t_Z[i] < -t_Radius[i])
+				{
+					Inside = false;
+					break;
+				}
+			}
+
+			if (Inside)
+			{
+				t_OutVisible[VisibleCount++] = i;
+			}
+		}
+
+		return VisibleCount;
+	}
+}   // namespace Fling
@@ -0,0 +1,65 @@
+#include "pch.h"
+#include "FrustumCuller.h"
+#include "Camera.h"
+#include "Components/Transform.h"
+#include "MeshRenderer.h"
+#include "JobSystem.h"
+
+namespace Fling
+{
+	void FrustumCuller::Cull(entt::registry& t_Reg, const Camera& t_Camera)
+	{
+		Cull(t_Reg, Frustum(t_Camera.GetProjectionMatrix() * t_Camera.GetViewMatrix()));
+	}
+
+	void FrustumCuller::Cull(entt::registry& t_Reg, const Frustum& t_Frustum)
+	{
+		m_Frustum = t_Frustum;
+
+		m_Candidates.clear();
+		t_Reg.view<Transform, MeshRenderer>().each([&](entt::entity t_Ent, Transform&, MeshRenderer&)
+		{
+			m_Candidates.emplace_back(t_Ent);
+		});
+
+		const UINT32 Count = static_cast<UINT32>(m_Candidates.size());
+		m_X.resize(Count);
+		m_Y.resize(Count);
+		m_Z.resize(Count);
+		m_Radius.resize(Count);
+		m_VisibleIndices.resize(Count);
+
+		// Move every model's sphere into world space
+		JobSystem::ParallelFor(Count, 256, [&](UINT32 t_Begin, UINT32 t_End)
+		{
+			for (UINT32 i = t_Begin; i < t_End; ++i)
+			{
+				const Transform& Trans = t_Reg.get<Transform>(m_Candidates[i]);
+				const MeshRenderer& MeshRend = t_Reg.get<MeshRenderer>(m_Candidates[i]);
+
+				const Model* Model = MeshRend.m_Model;
+				if (!Model || !Model->IsReady())
+				{
+					// Nothing to draw, make sure that it fails every plane
+					m_X[i] = m_Y[i] = m_Z[i] = 0.0f;
+					m_Radius[i] = -FLT_MAX;
+					continue;
+				}
+
+				const BoundingSphere Sphere = Model->GetBoundingSphere().Transformed(Trans.GetWorldMat());
+				m_X[i] = Sphere.Center.x;
+				m_Y[i] = Sphere.Center.y;
+				m_Z[i] = Sphere.Center.z;
+				m_Radius[i] = Sphere.Radius;
+			}
+		});
+
+		const UINT32 VisibleCount = m_Frustum.CullSpheres(m_X.data(), m_Y.data(), m_Z.data(), m_Radius.data(), Count, m_VisibleIndices.data());
+
+		m_Visible.resize(VisibleCount);
+		for (UINT32 i = 0; i < VisibleCount; ++i)
+		{
+			m_Visible[i] = m_Candidates[m_VisibleIndices[i]];
+		}
+	}
+}   // namespace Fling
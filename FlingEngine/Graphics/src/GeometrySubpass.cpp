@@ -12,6 +12,8 @@
 #include "OffscreenSubpass.h"
 #include "FirstPersonCamera.h"
 #include "Components/Transform.h"
+#include "RenderGraph.h"
+#include "VulkanApp.h"
 
 namespace Fling
 {
@@ -41,31 +43,31 @@ namespace Fling
 		// Initializes the lighting UBO buffers  --------
 		static_assert (sizeof(LightingUbo) < VULKAN_UBO_SIZE, "UBO size must be within the Vulkan Spec!");
 
-		VkDeviceSize bufferSize = sizeof(m_LightingUBO);
-
-		m_LightingUboBuffers.resize(m_SwapChain->GetImageCount());
-		for (size_t i = 0; i < m_LightingUboBuffers.size(); i++)
+		auto CreateMappedBuffers = [](std::vector<Buffer*>& t_Buffers, VkDeviceSize t_Size, VkBufferUsageFlags t_Usage)
 		{
-			m_LightingUboBuffers[i] = new Buffer(
-				bufferSize,
-				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			t_Buffers.resize(VulkanApp::Get().GetFramesInFlight());
+			for (size_t i = 0; i < t_Buffers.size(); i++)
+			{
+				t_Buffers[i] = new Buffer(
+					t_Size,
+					t_Usage,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
-			m_LightingUboBuffers[i]->MapMemory(bufferSize);
-		}
+				t_Buffers[i]->MapMemory(t_Size);
+			}
+		};
+
+		CreateMappedBuffers(m_LightingUboBuffers, sizeof(m_LightingUBO), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
 
 		// Build camera UBO's
-		bufferSize = sizeof(m_CamInfoUBO);
-		m_CameraUboBuffers.resize(m_SwapChain->GetImageCount());
-		for (size_t i = 0; i < m_CameraUboBuffers.size(); i++)
-		{
-			m_CameraUboBuffers[i] = new Buffer(
-				bufferSize,
-				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		CreateMappedBuffers(m_CameraUboBuffers, sizeof(m_CamInfoUBO), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
 
-			m_CameraUboBuffers[i]->MapMemory(bufferSize);
-		}
+		// Point lights and their clusters are too big for a UBO
+		CreateMappedBuffers(m_PointLightBuffers, sizeof(PointLight) * DeferredLightSettings::MaxPointLights, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		CreateMappedBuffers(m_ClusterBuffers, sizeof(LightCluster) * LightClusterGrid::ClusterCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		CreateMappedBuffers(m_LightIndexBuffers, sizeof(UINT32) * m_LightClusters.GetMaxLightIndices(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+		m_PointLightSpheres.reserve(DeferredLightSettings::MaxPointLights);
 
 		t_reg.on_construct<PointLight>().connect<&GeometrySubpass::OnPointLightAdded>(*this);
 	}
@@ -90,13 +92,16 @@ namespace Fling
 		ClearBufferVector(m_LightingUboBuffers);
 		ClearBufferVector(m_QuadUboBuffer);
 		ClearBufferVector(m_CameraUboBuffers);
+		ClearBufferVector(m_PointLightBuffers);
+		ClearBufferVector(m_ClusterBuffers);
+		ClearBufferVector(m_LightIndexBuffers);
 
 		// Clean up any allocated descriptor sets
 	}
 
 	void GeometrySubpass::Draw(CommandBuffer& t_CmdBuf, VkFramebuffer t_PresentFrameBuf, UINT32 t_ActiveFrameInFlight, entt::registry& t_reg, float DeltaTime)
 	{
-		UpdateLightingUBO(t_reg, t_ActiveFrameInFlight);
+		UpdateLightingBuffers(t_reg, t_ActiveFrameInFlight);
 
 		// Update camera UBO's		
 		{
@@ -132,23 +137,47 @@ namespace Fling
 		vkCmdDrawIndexed(t_CmdBuf.GetHandle(), m_QuadModel->GetIndexCount(), 1, 0, 0, 1);
 	}
 
+	void GeometrySubpass::DeclareResources(RenderGraph& t_Graph, UINT32 t_Pass)
+	{
+		// Light the G-Buffer that the offscreen pass filled in
+		for (const char* Name : OffscreenSubpass::GBufferColorNames)
+		{
+			t_Graph.Read(t_Pass, t_Graph.FindTexture(Name), RenderGraphUsage::ShaderRead);
+		}
+
+		t_Graph.Write(t_Pass, t_Graph.FindTexture(BackbufferName), RenderGraphUsage::ColorAttachment);
+	}
+
 	void GeometrySubpass::CreateDescriptorSets(VkDescriptorPool t_Pool, entt::registry& t_reg)
 	{
 		assert(m_OffscreenFrameBuf);
 
-		size_t ImageCount = m_SwapChain->GetImageCount();
-		m_DescriptorSets.resize(ImageCount);
+		// Each frame in flight reads it's own lighting and camera buffers
+		const UINT32 FrameCount = VulkanApp::Get().GetFramesInFlight();
+		m_DescriptorSets.resize(FrameCount);
 
-		std::vector<VkDescriptorSetLayout> layouts(ImageCount, m_GraphicsPipeline->GetDescriptorSetLayout());
+		std::vector<VkDescriptorSetLayout> layouts(FrameCount, m_GraphicsPipeline->GetDescriptorSetLayout());
 		VkDescriptorSetAllocateInfo allocInfo = {};
 		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
 		// If we have specified a specific pool then use that, otherwise use the one on the mesh
 		allocInfo.descriptorPool = t_Pool;
-		allocInfo.descriptorSetCount = static_cast<UINT32>(ImageCount);
+		allocInfo.descriptorSetCount = FrameCount;
 		allocInfo.pSetLayouts = layouts.data();
 
 		VK_CHECK_RESULT(vkAllocateDescriptorSets(m_Device->GetVkDevice(), &allocInfo, m_DescriptorSets.data()));
 
+		// Look the bindings up by name so that the shader can move them around
+		const UINT32 PositionBinding = m_GraphicsPipeline->GetBinding("samplerposition");
+		const UINT32 NormalBinding = m_GraphicsPipeline->GetBinding("samplerNormal");
+		const UINT32 AlbedoBinding = m_GraphicsPipeline->GetBinding("samplerAlbedo");
+		const UINT32 MetalBinding = m_GraphicsPipeline->GetBinding("samplerMetal");
+		const UINT32 RoughnessBinding = m_GraphicsPipeline->GetBinding("samplerRoughness");
+		const UINT32 LightingBinding = m_GraphicsPipeline->GetBinding("lights");
+		const UINT32 CameraBinding = m_GraphicsPipeline->GetBinding("ubo");
+		const UINT32 PointLightBinding = m_GraphicsPipeline->GetBinding("pointLights");
+		const UINT32 ClusterBinding = m_GraphicsPipeline->GetBinding("clusters");
+		const UINT32 LightIndexBinding = m_GraphicsPipeline->GetBinding("lightIndices");
+
 		for (size_t i = 0; i < m_DescriptorSets.size(); ++i)
 		{
 			// Create the image info's for the write sets to reference
@@ -185,49 +214,68 @@ namespace Fling
 
 			std::vector<VkWriteDescriptorSet> writeDescriptorSets =
 			{
-				// 1 : Position sampler
+				// Position sampler
 				Initializers::WriteDescriptorSet(
 					m_DescriptorSets[i],
 					VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-					1,
+					PositionBinding,
 					&texDescriptorPosition),
-				// 2 : Normal sampler
+				// Normal sampler
 				Initializers::WriteDescriptorSet(
 					m_DescriptorSets[i],
 					VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-					2,
+					NormalBinding,
 					&texDescriptorNormal),
-				// 3 : Albedo sampler
+				// Albedo sampler
 				Initializers::WriteDescriptorSet(
 					m_DescriptorSets[i],
 					VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-					3,
+					AlbedoBinding,
 					&texDescriptorAlbedo),
 
-				// 4 : Metal sampler
+				// Metal sampler
 				Initializers::WriteDescriptorSet(
 					m_DescriptorSets[i],
 					VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-					4,
+					MetalBinding,
 					&texDescriptorMetal),
-				// 5 : Roughness sampler
+				// Roughness sampler
 				Initializers::WriteDescriptorSet(
 					m_DescriptorSets[i],
 					VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-					5,
+					RoughnessBinding,
 					&texDescriptorRough),
 
-				// 6 : Lighting UBO to the fragment shader
+				// Lighting UBO to the fragment shader
 				Initializers::WriteDescriptorSetUniform(
 					m_LightingUboBuffers[i],
 					m_DescriptorSets[i],
-					6
+					LightingBinding
 				),
-				// 7 : Camera UBO to the fragment shader
+				// Camera UBO to the fragment shader
 				Initializers::WriteDescriptorSetUniform(
 					m_CameraUboBuffers[i],
 					m_DescriptorSets[i],
-					7
+					CameraBinding
+				),
+				// Point lights and the lists of them for each cluster
+				Initializers::WriteDescriptorSet(
+					m_DescriptorSets[i],
+					VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+					PointLightBinding,
+					&m_PointLightBuffers[i]->GetDescriptor()
+				),
+				Initializers::WriteDescriptorSet(
+					m_DescriptorSets[i],
+					VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+					ClusterBinding,
+					&m_ClusterBuffers[i]->GetDescriptor()
+				),
+				Initializers::WriteDescriptorSet(
+					m_DescriptorSets[i],
+					VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+					LightIndexBinding,
+					&m_LightIndexBuffers[i]->GetDescriptor()
 				),
 			};
 
@@ -290,7 +338,7 @@ namespace Fling
 #endif	// FLING_DEBUG
 	}
 
-	void GeometrySubpass::UpdateLightingUBO(entt::registry& t_Reg, UINT32 t_ActiveFrame)
+	void GeometrySubpass::UpdateLightingBuffers(entt::registry& t_Reg, UINT32 t_ActiveFrame)
 	{
 		auto PointLightView = t_Reg.view<PointLight, Transform>();
 		auto DirectionalLightView = t_Reg.view<DirectionalLight>();
@@ -312,6 +360,9 @@ namespace Fling
 		CurLightCount = 0;
 
 		// Point lights ---------------------
+		PointLight* PointLightBuffer = static_cast<PointLight*>(m_PointLightBuffers[t_ActiveFrame]->m_MappedMem);
+		m_PointLightSpheres.clear();
+
 		for (auto entity : PointLightView)
 		{
 			if (CurLightCount < DeferredLightSettings::MaxPointLights)
@@ -321,13 +372,31 @@ namespace Fling
 
 				Light.SetPos(glm::vec4(Trans.GetPos(), 1.0f));
 				// Copy the point light info to the buffer
-				memcpy((m_LightingUBO.PointLightBuffer + (CurLightCount++)), &Light, sizeof(PointLight));
+				memcpy((PointLightBuffer + (CurLightCount++)), &Light, sizeof(PointLight));
+				m_PointLightSpheres.emplace_back(Trans.GetPos(), Light.Range);
 			}
 		}
 
-		// Memcpy to the buffer
 		m_LightingUBO.PointLightCount = CurLightCount;
-		
+
+		// Bin the point lights into clusters for the shader to look up
+		m_LightClusters.Build(
+			m_Camera->GetViewMatrix(),
+			m_Camera->GetProjectionMatrix(),
+			m_Camera->GetNearPlane(),
+			m_Camera->GetFarPlane(),
+			m_PointLightSpheres.data(),
+			CurLightCount);
+
+		m_LightingUBO.ClusterSliceScale = m_LightClusters.GetSliceScale();
+		m_LightingUBO.ClusterSliceBias = m_LightClusters.GetSliceBias();
+
+		const std::vector<LightCluster>& Clusters = m_LightClusters.GetClusters();
+		const std::vector<UINT32>& LightIndices = m_LightClusters.GetLightIndices();
+		memcpy(m_ClusterBuffers[t_ActiveFrame]->m_MappedMem, Clusters.data(), sizeof(LightCluster) * Clusters.size());
+		memcpy(m_LightIndexBuffers[t_ActiveFrame]->m_MappedMem, LightIndices.data(), sizeof(UINT32) * LightIndices.size());
+
+		// Memcpy to the buffer
 		memcpy(
 			m_LightingUboBuffers[t_ActiveFrame]->m_MappedMem,
 			&m_LightingUBO,
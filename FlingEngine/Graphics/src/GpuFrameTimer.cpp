@@ -0,0 +1,123 @@
+#include "pch.h"
+#include "GpuFrameTimer.h"
+#include "CommandBuffer.h"
+#include "LogicalDevice.h"
+#include "PhyscialDevice.h"
+
+namespace Fling
+{
+	GpuFrameTimer::GpuFrameTimer(const LogicalDevice* t_Device, VkCommandPool t_Pool, UINT32 t_FrameCount)
+		: m_Device(t_Device)
+	{
+		assert(m_Device);
+
+		const PhysicalDevice* PhysDevice = m_Device->GetPhysicalDevice();
+		m_TimestampPeriod = PhysDevice->GetDeviceProps().limits.timestampPeriod;
+
+		UINT32 FamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(PhysDevice->GetVkPhysicalDevice(), &FamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> Families(FamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(PhysDevice->GetVkPhysicalDevice(), &FamilyCount, Families.data());
+
+		if (m_Device->GetGraphicsFamily() < FamilyCount)
+		{
+			m_ValidBits = Families[m_Device->GetGraphicsFamily()].timestampValidBits;
+		}
+
+		if (m_ValidBits == 0 || m_TimestampPeriod <= 0.0f)
+		{
+			F_LOG_WARN("The graphics queue can't write timestamps, GPU frame times won't be measured");
+			return;
+		}
+
+		VkQueryPoolCreateInfo PoolInfo = {};
+		PoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		PoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		PoolInfo.queryCount = t_FrameCount * 2;
+		if (vkCreateQueryPool(m_Device->GetVkDevice(), &PoolInfo, nullptr, &m_QueryPool) != VK_SUCCESS)
+		{
+			F_LOG_WARN("Failed to create the timestamp query pool, GPU frame times won't be measured");
+			m_QueryPool = VK_NULL_HANDLE;
+			return;
+		}
+
+		m_Pending.resize(t_FrameCount, false);
+		for (UINT32 i = 0; i < t_FrameCount; ++i)
+		{
+			CommandBuffer* Begin = m_BeginCmdBufs.emplace_back(new CommandBuffer(m_Device, t_Pool));
+			Begin->Begin();
+			vkCmdResetQueryPool(Begin->GetHandle(), m_QueryPool, i * 2, 2);
+			vkCmdWriteTimestamp(Begin->GetHandle(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_QueryPool, i * 2);
+			Begin->End();
+
+			// Bottom of pipe waits for everything submitted before it in the frame to finish
+			CommandBuffer* End = m_EndCmdBufs.emplace_back(new CommandBuffer(m_Device, t_Pool));
+			End->Begin();
+			vkCmdWriteTimestamp(End->GetHandle(), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_QueryPool, i * 2 + 1);
+			End->End();
+		}
+	}
+
+	GpuFrameTimer::~GpuFrameTimer()
+	{
+		for (CommandBuffer* CmdBuf : m_BeginCmdBufs)
+		{
+			delete CmdBuf;
+		}
+		m_BeginCmdBufs.clear();
+
+		for (CommandBuffer* CmdBuf : m_EndCmdBufs)
+		{
+			delete CmdBuf;
+		}
+		m_EndCmdBufs.clear();
+
+		if (m_QueryPool != VK_NULL_HANDLE)
+		{
+			vkDestroyQueryPool(m_Device->GetVkDevice(), m_QueryPool, nullptr);
+		}
+	}
+
+	VkCommandBuffer GpuFrameTimer::GetBeginCommandBuffer(UINT32 t_Frame) const
+	{
+		return IsSupported() ? m_BeginCmdBufs[t_Frame]->GetHandle() : VK_NULL_HANDLE;
+	}
+
+	VkCommandBuffer GpuFrameTimer::GetEndCommandBuffer(UINT32 t_Frame) const
+	{
+		return IsSupported() ? m_EndCmdBufs[t_Frame]->GetHandle() : VK_NULL_HANDLE;
+	}
+
+	void GpuFrameTimer::OnSubmitted(UINT32 t_Frame)
+	{
+		if (IsSupported())
+		{
+			m_Pending[t_Frame] = true;
+		}
+	}
+
+	bool GpuFrameTimer::ReadFrameTime(UINT32 t_Frame, float& t_OutMilliseconds)
+	{
+		if (!IsSupported() || !m_Pending[t_Frame])
+		{
+			return false;
+		}
+		m_Pending[t_Frame] = false;
+
+		UINT64 Timestamps[2] = {};
+		if (vkGetQueryPoolResults(m_Device->GetVkDevice(), m_QueryPool, t_Frame * 2, 2, sizeof(Timestamps), Timestamps, sizeof(UINT64), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+		{
+			return false;
+		}
+
+		t_OutMilliseconds = TicksToMilliseconds(Timestamps[0], Timestamps[1], m_ValidBits, m_TimestampPeriod);
+		return true;
+	}
+
+	float GpuFrameTimer::TicksToMilliseconds(UINT64 t_Begin, UINT64 t_End, UINT32 t_ValidBits, float t_TimestampPeriod)
+	{
+		const UINT64 Mask = t_ValidBits >= 64 ? ~0ull : ((1ull << t_ValidBits) - 1);
+		const UINT64 Ticks = (t_End - t_Begin) & Mask;
+		return static_cast<float>(static_cast<double>(Ticks) * t_TimestampPeriod / 1000000.0);
+	}
+}   // namespace Fling
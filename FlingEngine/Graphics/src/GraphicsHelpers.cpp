@@ -27,7 +27,7 @@ namespace Fling
             return 0;
         }
 
-        void CreateBuffer(VkDevice t_Device, VkPhysicalDevice t_PhysicalDevice, VkDeviceSize t_Size, VkBufferUsageFlags t_Usage, VkMemoryPropertyFlags t_Properties, VkBuffer& t_Buffer, VkDeviceMemory& t_BuffMemory)
+        void CreateBuffer(VkDevice t_Device, VkPhysicalDevice t_PhysicalDevice, VkDeviceSize t_Size, VkBufferUsageFlags t_Usage, VkMemoryPropertyFlags t_Properties, VkBuffer& t_Buffer, DeviceAllocation& t_BuffMemory)
         {
             // Create a buffer
             VkBufferCreateInfo bufferInfo = {};
@@ -45,21 +45,13 @@ namespace Fling
             VkMemoryRequirements MemRequirments = {};
             vkGetBufferMemoryRequirements(t_Device, t_Buffer, &MemRequirments);
 
-            VkMemoryAllocateInfo AllocInfo = {};
-            AllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-            AllocInfo.allocationSize = MemRequirments.size;
             // Using VK_MEMORY_PROPERTY_HOST_COHERENT_BIT may cause worse perf,
             // we could use explicit flushing with vkFlushMappedMemoryRanges
-            AllocInfo.memoryTypeIndex = GraphicsHelpers::FindMemoryType(t_PhysicalDevice, MemRequirments.memoryTypeBits, t_Properties);
-
-            // Allocate the vertex buffer memory
-            // #TODO Don't call vkAllocateMemory every time, we should use a custom allocator or
-            // VulkanMemoryAllocator library
-            if (vkAllocateMemory(t_Device, &AllocInfo, nullptr, &t_BuffMemory) != VK_SUCCESS)
+            if (!VulkanApp::Get().GetMemoryAllocator()->Allocate(MemRequirments, t_Properties, ResourceLayout::Linear, t_BuffMemory))
             {
                 F_LOG_FATAL("Failed to alocate buffer memory!");
             }
-            vkBindBufferMemory(t_Device, t_Buffer, t_BuffMemory, 0);
+            vkBindBufferMemory(t_Device, t_Buffer, t_BuffMemory.Memory, t_BuffMemory.Offset);
         }
 
         VkCommandBuffer BeginSingleTimeCommands()
@@ -116,7 +108,7 @@ namespace Fling
             VkImageUsageFlags t_Useage, 
             VkMemoryPropertyFlags t_Props, 
             VkImage& t_Image,
-            VkDeviceMemory& t_Memory,
+            DeviceAllocation& t_Memory,
 			VkSampleCountFlagBits t_NumSamples
         )
         {
@@ -151,14 +143,13 @@ namespace Fling
             VkMemoryPropertyFlags t_Props, 
             VkImageCreateFlags t_flags,
             VkImage& t_Image, 
-            VkDeviceMemory& t_Memory, 
+            DeviceAllocation& t_Memory, 
             VkSampleCountFlagBits t_NumSamples
             )
         {
             VkDevice Device = t_Dev;
-			PhysicalDevice* Phys = VulkanApp::Get().GetPhysicalDevice();
-			assert(Phys);
-            VkPhysicalDevice PhysDevice = Phys->GetVkPhysicalDevice();
+			DeviceMemoryAllocator* Allocator = VulkanApp::Get().GetMemoryAllocator();
+			assert(Allocator);
 
             VkImageCreateInfo imageInfo = {};
             imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -187,17 +178,14 @@ namespace Fling
             VkMemoryRequirements memRequirements;
             vkGetImageMemoryRequirements(Device, t_Image, &memRequirements);
 
-            VkMemoryAllocateInfo allocInfo = {};
-            allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-            allocInfo.allocationSize = memRequirements.size;
-            allocInfo.memoryTypeIndex = GraphicsHelpers::FindMemoryType(PhysDevice, memRequirements.memoryTypeBits, t_Props);
-
-            if (vkAllocateMemory(Device, &allocInfo, nullptr, &t_Memory) != VK_SUCCESS)
+            // Optimal tiled images can't share a bufferImageGranularity page with buffers
+            const ResourceLayout Layout = t_Tiling == VK_IMAGE_TILING_OPTIMAL ? ResourceLayout::Optimal : ResourceLayout::Linear;
+            if (!Allocator->Allocate(memRequirements, t_Props, Layout, t_Memory))
             {
                 F_LOG_FATAL("Failed to allocate image memory!");
             }
 
-            VK_CHECK_RESULT(vkBindImageMemory(Device, t_Image, t_Memory, 0));
+            VK_CHECK_RESULT(vkBindImageMemory(Device, t_Image, t_Memory.Memory, t_Memory.Offset));
         }
 
 		VkSemaphore CreateSemaphore(VkDevice t_Dev)
@@ -390,14 +378,18 @@ namespace Fling
         }
 
         void CreateCommandPool(VkCommandPool * t_commandPool, VkCommandPoolCreateFlags t_flags)
+        {
+            CreateCommandPool(t_commandPool, t_flags, VulkanApp::Get().GetLogicalDevice()->GetGraphicsFamily());
+        }
+
+        void CreateCommandPool(VkCommandPool* t_commandPool, VkCommandPoolCreateFlags t_flags, UINT32 t_QueueFamily)
         {
             LogicalDevice* logicalDevice = VulkanApp::Get().GetLogicalDevice();
 
             VkCommandPoolCreateInfo commandPoolCreateInfo = {};
-            UINT32 GraphicsFamily = logicalDevice->GetGraphicsFamily();
             commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
             commandPoolCreateInfo.flags = t_flags;
-            commandPoolCreateInfo.queueFamilyIndex = GraphicsFamily;
+            commandPoolCreateInfo.queueFamilyIndex = t_QueueFamily;
 
             if (vkCreateCommandPool(logicalDevice->GetVkDevice(), &commandPoolCreateInfo, nullptr, t_commandPool) != VK_SUCCESS)
             {
@@ -424,21 +416,23 @@ namespace Fling
 
         }
 
-        void CreatePipelineCache(VkPipelineCache& t_PipelineCache)
+        void TransitionImageLayout(
+            VkImage t_Image, 
+            VkFormat t_Format, 
+            VkImageLayout t_oldLayout, 
+            VkImageLayout t_NewLayout,
+            UINT32 t_MipLevels /* = 1 */
+        )
         {
-			LogicalDevice* Dev = VulkanApp::Get().GetLogicalDevice();
-			assert(Dev);
-			VkDevice Device = Dev->GetVkDevice();
+            VkCommandBuffer commandBuffer = GraphicsHelpers::BeginSingleTimeCommands();
 
-            VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
-            pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-            if (vkCreatePipelineCache(Device, &pipelineCacheCreateInfo, nullptr, &t_PipelineCache) != VK_SUCCESS)
-            {
-                F_LOG_FATAL("Failed to create pipeline cache");
-            }
+            TransitionImageLayout(commandBuffer, t_Image, t_Format, t_oldLayout, t_NewLayout, t_MipLevels);
+
+            GraphicsHelpers::EndSingleTimeCommands(commandBuffer);
         }
 
         void TransitionImageLayout(
+            VkCommandBuffer t_CommandBuffer,
             VkImage t_Image, 
             VkFormat t_Format, 
             VkImageLayout t_oldLayout, 
@@ -446,8 +440,6 @@ namespace Fling
             UINT32 t_MipLevels /* = 1 */
         )
         {
-            VkCommandBuffer commandBuffer = GraphicsHelpers::BeginSingleTimeCommands();
-
             VkImageMemoryBarrier barrier = {};
             barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
             barrier.oldLayout = t_oldLayout;
@@ -517,15 +509,13 @@ namespace Fling
             }
 
             vkCmdPipelineBarrier(
-                commandBuffer,
+                t_CommandBuffer,
                 SourceStage, DestinationStage,
                 0,
                 0, nullptr,
                 0, nullptr,
                 1, &barrier
             );
-
-            GraphicsHelpers::EndSingleTimeCommands(commandBuffer);
         }
 
         VkImageView CreateVkImageView(
@@ -1,5 +1,9 @@
 #include "GraphicsPipeline.h"
 #include "GraphicsHelpers.h"
+#include "PipelineCacheManager.h"
+#include "VulkanApp.h"
+
+#include <algorithm>
 
 namespace Fling
 {
@@ -12,7 +16,9 @@ namespace Fling
         Depth t_Depth,
         VkPrimitiveTopology t_Topology,
         VkCullModeFlags t_CullMode,
-        VkFrontFace t_FrontFace) :
+        VkFrontFace t_FrontFace,
+        UINT32 t_DynamicUniformMask,
+        UINT32 t_RuntimeArraySize) :
         m_Shaders(t_Shaders),
         m_Device(t_LogicalDevice),
         m_PolygonMode(t_Mode),
@@ -21,8 +27,8 @@ namespace Fling
         m_CullMode(t_CullMode),
         m_FrontFace(t_FrontFace)
     {
-		m_DescriptorSetLayout = Shader::CreateSetLayout(m_Device, m_Shaders);
-		m_PipelineLayout = Shader::CreatePipelineLayout(m_Device, m_DescriptorSetLayout, 0, 0);
+		// Pipelines whose shaders have the same interface get the same layouts back
+		m_PipelineLayout = Shader::GetLayouts(m_Shaders, t_DynamicUniformMask, t_RuntimeArraySize, m_DescriptorSetLayouts);
 		
 		CreateAttributes(nullptr);
     }
@@ -95,9 +101,6 @@ namespace Fling
 
     void GraphicsPipeline::CreateGraphicsPipeline(VkRenderPass& t_RenderPass, Multisampler* t_Sampler)
     {
-        // Pipeline Cache
-        GraphicsHelpers::CreatePipelineCache(m_PipelineCache);
-
         // Shader stages 
         std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
 
@@ -115,12 +118,67 @@ namespace Fling
         }
 
         // Vertex Input 
-        VkVertexInputBindingDescription BindingDescription = Vertex::GetBindingDescription();
-        std::array<VkVertexInputAttributeDescription, 5> AttributeDescriptions = Vertex::GetAttributeDescriptions();
+        std::vector<VkVertexInputBindingDescription> BindingDescriptions;
+        std::vector<VkVertexInputAttributeDescription> AttributeDescriptions;
+        if (m_Instanced && m_VertexFormat == VertexFormat::Packed)
+        {
+            std::array<VkVertexInputBindingDescription, 2> Bindings = PackedVertex::GetInstancedBindingDescriptions();
+            std::array<VkVertexInputAttributeDescription, 8> Attributes = PackedVertex::GetInstancedAttributeDescriptions();
+            BindingDescriptions.assign(Bindings.begin(), Bindings.end());
+            AttributeDescriptions.assign(Attributes.begin(), Attributes.end());
+        }
+        else if (m_Instanced)
+        {
+            std::array<VkVertexInputBindingDescription, 2> Bindings = Vertex::GetInstancedBindingDescriptions();
+            std::array<VkVertexInputAttributeDescription, 9> Attributes = Vertex::GetInstancedAttributeDescriptions();
+            BindingDescriptions.assign(Bindings.begin(), Bindings.end());
+            AttributeDescriptions.assign(Attributes.begin(), Attributes.end());
+        }
+        else if (m_VertexFormat == VertexFormat::Packed)
+        {
+            std::array<VkVertexInputAttributeDescription, 4> Attributes = PackedVertex::GetAttributeDescriptions();
+            BindingDescriptions.emplace_back(PackedVertex::GetBindingDescription());
+            AttributeDescriptions.assign(Attributes.begin(), Attributes.end());
+        }
+        else
+        {
+            std::array<VkVertexInputAttributeDescription, 5> Attributes = Vertex::GetAttributeDescriptions();
+            BindingDescriptions.emplace_back(Vertex::GetBindingDescription());
+            AttributeDescriptions.assign(Attributes.begin(), Attributes.end());
+        }
+
+        // Only hand the vertex shader the attributes that it reads, and make sure that it gets all of them
+        for (const Shader* shader : m_Shaders)
+        {
+            if (shader->GetStage() != VK_SHADER_STAGE_VERTEX_BIT)
+            {
+                continue;
+            }
+
+            const std::vector<ShaderVertexInput>& Inputs = shader->GetReflection().VertexInputs;
+            AttributeDescriptions.erase(
+                std::remove_if(AttributeDescriptions.begin(), AttributeDescriptions.end(), [&Inputs](const VkVertexInputAttributeDescription& Attribute)
+                {
+                    return std::none_of(Inputs.begin(), Inputs.end(), [&Attribute](const ShaderVertexInput& Input) { return Input.Location == Attribute.location; });
+                }),
+                AttributeDescriptions.end());
+
+            for (const ShaderVertexInput& Input : Inputs)
+            {
+                const bool Provided = std::any_of(AttributeDescriptions.begin(), AttributeDescriptions.end(), [&Input](const VkVertexInputAttributeDescription& Attribute)
+                {
+                    return Attribute.location == Input.Location;
+                });
+                if (!Provided)
+                {
+                    F_LOG_ERROR("Vertex shader {} reads '{}' at location {}, which the vertex format doesn't have", shader->GetFilepathReleativeToAssets(), Input.Name, Input.Location);
+                }
+            }
+        }
 
         m_VertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        m_VertexInputStateCreateInfo.vertexBindingDescriptionCount = 1;
-        m_VertexInputStateCreateInfo.pVertexBindingDescriptions = &BindingDescription;
+        m_VertexInputStateCreateInfo.vertexBindingDescriptionCount = static_cast<UINT32>(BindingDescriptions.size());
+        m_VertexInputStateCreateInfo.pVertexBindingDescriptions = BindingDescriptions.data();
         m_VertexInputStateCreateInfo.vertexAttributeDescriptionCount = static_cast<UINT32>(AttributeDescriptions.size());
         m_VertexInputStateCreateInfo.pVertexAttributeDescriptions = AttributeDescriptions.data();
 
@@ -142,17 +200,51 @@ namespace Fling
         m_PipelineCreateInfo.renderPass = t_RenderPass;
         m_PipelineCreateInfo.subpass = 0;
 
-        if (vkCreateGraphicsPipelines(m_Device, m_PipelineCache, 1, &m_PipelineCreateInfo, nullptr, &m_Pipeline) != VK_SUCCESS)
+        // Every pipeline shares the engine's cache, so pipelines built on a previous run come back quickly
+        PipelineCacheManager* Cache = VulkanApp::Get().GetPipelineCacheManager();
+        assert(Cache);
+        if (Cache->CreateGraphicsPipelines(&m_PipelineCreateInfo, 1, &m_Pipeline) != VK_SUCCESS)
         {
             F_LOG_FATAL("Failed to create graphics pipeline");
         }
     }
 
+    const ShaderBinding* GraphicsPipeline::FindBinding(const std::string& t_Name) const
+    {
+        for (const Shader* shader : m_Shaders)
+        {
+            if (const ShaderBinding* Binding = shader->GetReflection().FindBinding(t_Name))
+            {
+                return Binding;
+            }
+        }
+        return nullptr;
+    }
+
+    UINT32 GraphicsPipeline::GetBinding(const std::string& t_Name) const
+    {
+        const ShaderBinding* Binding = FindBinding(t_Name);
+        assert(Binding && "None of the pipeline's shaders declare this descriptor");
+        return Binding ? Binding->Binding : 0;
+    }
+
+    VkShaderStageFlags GraphicsPipeline::GetPushConstantStages() const
+    {
+        // The layout has a single range that every stage with push constants shares
+        VkShaderStageFlags Stages = 0;
+        for (const Shader* shader : m_Shaders)
+        {
+            if (shader->UsesPushConstants())
+            {
+                Stages |= shader->GetStage();
+            }
+        }
+        return Stages;
+    }
+
     GraphicsPipeline::~GraphicsPipeline()
     {
-        vkDestroyPipelineLayout(m_Device, m_PipelineLayout, nullptr);
+        // The layouts belong to the layout cache
         vkDestroyPipeline(m_Device, m_Pipeline, nullptr);
-        vkDestroyDescriptorSetLayout(m_Device, m_DescriptorSetLayout, nullptr);
-        vkDestroyPipelineCache(m_Device, m_PipelineCache, nullptr);
     }
 }
\ No newline at end of file
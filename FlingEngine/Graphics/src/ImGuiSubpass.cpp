@@ -5,12 +5,16 @@
 #include "LogicalDevice.h"
 #include "GraphicsHelpers.h"
 #include "Components/Transform.h"
+#include "RenderGraph.h"
 #include "MeshRenderer.h"
 #include "SwapChain.h"
 #include "UniformBufferObject.h"
 #include "FirstPersonCamera.h"
 #include "FlingVulkan.h"
 #include "BaseEditor.h"
+#include "VulkanApp.h"
+#include "PipelineCacheManager.h"
+#include "UploadBatch.h"
 
 #include <imgui.h>
 #include <algorithm>
@@ -59,9 +63,8 @@ namespace Fling
 
 		vkDestroyImage(logicalDevice, m_fontImage, nullptr);
 		vkDestroyImageView(logicalDevice, m_fontImageView, nullptr);
-		vkFreeMemory(logicalDevice, m_fontMemory, nullptr);
+		VulkanApp::Get().GetMemoryAllocator()->Free(m_fontMemory);
 		vkDestroySampler(logicalDevice, m_sampler, nullptr);
-		vkDestroyPipelineCache(logicalDevice, m_pipelineCache, nullptr);
 		vkDestroyPipeline(logicalDevice, m_pipeLine, nullptr);
 		vkDestroyPipelineLayout(logicalDevice, m_pipelineLayout, nullptr);
 		vkDestroyDescriptorPool(logicalDevice, m_descriptorPool, nullptr);
@@ -79,14 +82,15 @@ namespace Fling
 
 		ImGui::Render();
 
-		UpdateUniforms();
+		UpdateUniforms(t_ActiveFrameInFlight);
 
-		BuildCommandBuffer(t_CmdBuf.GetHandle());
+		BuildCommandBuffer(t_CmdBuf.GetHandle(), t_ActiveFrameInFlight);
 	}
 
-	void ImGuiSubpass::BuildCommandBuffer(VkCommandBuffer t_commandBuffer)
+	void ImGuiSubpass::BuildCommandBuffer(VkCommandBuffer t_commandBuffer, UINT32 t_ActiveFrameInFlight)
 	{
 		ImGuiIO& io = ImGui::GetIO();
+		const FrameGeometry& Geometry = m_FrameGeometry[t_ActiveFrameInFlight];
 
 
 		vkCmdBindDescriptorSets(t_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &m_descriptorSet, 0, nullptr);
@@ -126,12 +130,12 @@ namespace Fling
 				t_commandBuffer,
 				0,
 				1,
-				&m_vertexBuffer->GetVkBuffer(),
+				&Geometry.vertexBuffer->GetVkBuffer(),
 				offsets);
 
 			vkCmdBindIndexBuffer(
 				t_commandBuffer,
-				m_indexBuffer->GetVkBuffer(),
+				Geometry.indexBuffer->GetVkBuffer(),
 				0,
 				VK_INDEX_TYPE_UINT16);
 
@@ -156,6 +160,12 @@ namespace Fling
 		}
 	}
 
+	void ImGuiSubpass::DeclareResources(RenderGraph& t_Graph, UINT32 t_Pass)
+	{
+		// The UI is drawn on top of everything else in the swap chain render pass
+		t_Graph.Write(t_Pass, t_Graph.FindTexture(BackbufferName), RenderGraphUsage::ColorAttachment);
+	}
+
 	void ImGuiSubpass::CreateDescriptorSets(VkDescriptorPool t_Pool, entt::registry& t_reg)
 	{
 		
@@ -193,14 +203,11 @@ namespace Fling
 			VK_IMAGE_ASPECT_COLOR_BIT
 		);
 
-		Buffer stagingBuffer = Buffer(
-			uploadSize,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			fontData);
+		UploadBatch Batch;
+		StagingAllocation Staging = Batch.StageData(fontData, uploadSize);
 
 		//Copy buffer data to font image
-		VkCommandBuffer copycmd = GraphicsHelpers::BeginSingleTimeCommands();
+		VkCommandBuffer copycmd = Batch.GetCommandBuffer();
 
 		GraphicsHelpers::SetImageLayout(
 			copycmd,
@@ -213,6 +220,7 @@ namespace Fling
 
 		//Copy
 		VkBufferImageCopy bufferCopyRegion = {};
+		bufferCopyRegion.bufferOffset = Staging.Offset;
 		bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 		bufferCopyRegion.imageSubresource.layerCount = 1;
 		bufferCopyRegion.imageExtent.width = texWidth;
@@ -221,23 +229,15 @@ namespace Fling
 
 		vkCmdCopyBufferToImage(
 			copycmd,
-			stagingBuffer.GetVkBuffer(),
+			Staging.Buffer,
 			m_fontImage,
 			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 			1,
 			&bufferCopyRegion
 		);
 
-		GraphicsHelpers::SetImageLayout(
-			copycmd,
-			m_fontImage,
-			VK_IMAGE_ASPECT_COLOR_BIT,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-			VK_PIPELINE_STAGE_TRANSFER_BIT,
-			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
-
-		GraphicsHelpers::EndSingleTimeCommands(copycmd);
+		Batch.TransferImage(m_fontImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		Batch.SubmitAndWait();
 
 		Fling::GraphicsHelpers::CreateVkSampler(
 			VK_FILTER_LINEAR,
@@ -297,14 +297,6 @@ namespace Fling
 
 		vkUpdateDescriptorSets(logicalDevice, static_cast<UINT32>(writeDescriptorSet.size()), writeDescriptorSet.data(), 0, nullptr);
 
-		//Pipeline cache --------------------------------------------------------
-		VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
-		pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-		if (vkCreatePipelineCache(logicalDevice, &pipelineCacheCreateInfo, nullptr, &m_pipelineCache) != VK_SUCCESS)
-		{
-			F_LOG_ERROR("Could not create pipeline cache for imgui");
-		}
-
 		//Pipeline layout
 		//Push constants for UI rendering 
 		VkPushConstantRange pushConstantRange = Initializers::PushConstantRange(VK_SHADER_STAGE_VERTEX_BIT, sizeof(PushConstBlock), 0);
@@ -406,7 +398,7 @@ namespace Fling
 
 		pipelineCreateInfo.pVertexInputState = &vertexInputState;
 
-		if (vkCreateGraphicsPipelines(logicalDevice, m_pipelineCache, 1, &pipelineCreateInfo, nullptr, &m_pipeLine) != VK_SUCCESS)
+		if (VulkanApp::Get().GetPipelineCacheManager()->CreateGraphicsPipelines(&pipelineCreateInfo, 1, &m_pipeLine) != VK_SUCCESS)
 		{
 			F_LOG_ERROR("Could not create graphics pipeline for imgui");
 		}
@@ -435,13 +427,18 @@ namespace Fling
 	void ImGuiSubpass::PrepareResources()
 	{
 		// Create vert and index buffers for use with imgui geometry
-		m_indexBuffer = std::make_unique<Buffer>();
-		m_vertexBuffer = std::make_unique<Buffer>();
+		m_FrameGeometry.resize(VulkanApp::Get().GetFramesInFlight());
+		for (FrameGeometry& Geometry : m_FrameGeometry)
+		{
+			Geometry.indexBuffer = std::make_unique<Buffer>();
+			Geometry.vertexBuffer = std::make_unique<Buffer>();
+		}
 	}
 	
-	void ImGuiSubpass::UpdateUniforms()
+	void ImGuiSubpass::UpdateUniforms(UINT32 t_ActiveFrameInFlight)
 	{
 		ImDrawData* imDrawData = ImGui::GetDrawData();
+		FrameGeometry& Geometry = m_FrameGeometry[t_ActiveFrameInFlight];
 
 		VkDeviceSize vertexBufferSize = imDrawData->TotalVtxCount * sizeof(ImDrawVert);
 		VkDeviceSize indexBufferSize = imDrawData->TotalIdxCount * sizeof(ImDrawIdx);
@@ -451,30 +448,30 @@ namespace Fling
 			return;
 		}
 
-		if ((m_vertexBuffer->GetVkBuffer() == VK_NULL_HANDLE) ||
-			(m_vertexCount != imDrawData->TotalVtxCount))
+		if ((Geometry.vertexBuffer->GetVkBuffer() == VK_NULL_HANDLE) ||
+			(Geometry.vertexCount != imDrawData->TotalVtxCount))
 		{
-			m_vertexBuffer->UnmapMemory();
-			m_vertexBuffer->Release();
+			Geometry.vertexBuffer->UnmapMemory();
+			Geometry.vertexBuffer->Release();
 
-			m_vertexBuffer->CreateBuffer(vertexBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
-			m_vertexCount = imDrawData->TotalVtxCount;
-			m_vertexBuffer->MapMemory();
+			Geometry.vertexBuffer->CreateBuffer(vertexBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
+			Geometry.vertexCount = imDrawData->TotalVtxCount;
+			Geometry.vertexBuffer->MapMemory();
 		}
 
-		if ((m_indexBuffer->GetVkBuffer() == VK_NULL_HANDLE) ||
-			(m_indexCount < imDrawData->TotalIdxCount))
+		if ((Geometry.indexBuffer->GetVkBuffer() == VK_NULL_HANDLE) ||
+			(Geometry.indexCount < imDrawData->TotalIdxCount))
 		{
-			m_indexBuffer->UnmapMemory();
-			m_indexBuffer->Release();
+			Geometry.indexBuffer->UnmapMemory();
+			Geometry.indexBuffer->Release();
 
-			m_indexBuffer->CreateBuffer(indexBufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
-			m_indexCount = imDrawData->TotalIdxCount;
-			m_indexBuffer->MapMemory();
+			Geometry.indexBuffer->CreateBuffer(indexBufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
+			Geometry.indexCount = imDrawData->TotalIdxCount;
+			Geometry.indexBuffer->MapMemory();
 		}
 
-		ImDrawVert* vtxDst = (ImDrawVert*)m_vertexBuffer->m_MappedMem;
-		ImDrawIdx* idxDst = (ImDrawIdx*)m_indexBuffer->m_MappedMem;
+		ImDrawVert* vtxDst = (ImDrawVert*)Geometry.vertexBuffer->m_MappedMem;
+		ImDrawIdx* idxDst = (ImDrawIdx*)Geometry.indexBuffer->m_MappedMem;
 
 		for (int n = 0; n < imDrawData->CmdListsCount; ++n) {
 			const ImDrawList* cmd_list = imDrawData->CmdLists[n];
@@ -484,7 +481,7 @@ namespace Fling
 			idxDst += cmd_list->IdxBuffer.Size;
 		}
 
-		m_vertexBuffer->Flush(VK_WHOLE_SIZE, 0);
-		m_indexBuffer->Flush(VK_WHOLE_SIZE, 0);
+		Geometry.vertexBuffer->Flush(VK_WHOLE_SIZE, 0);
+		Geometry.indexBuffer->Flush(VK_WHOLE_SIZE, 0);
 	}
 }   // namespace Fling
\ No newline at end of file
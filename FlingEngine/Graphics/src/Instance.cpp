@@ -5,8 +5,9 @@
 
 namespace Fling
 {
-    Instance::Instance()
+    Instance::Instance(bool t_Presentable)
     {
+        m_Presentable = t_Presentable;
         m_EnableValidationLayers = FlingConfig::GetBool("Vulkan", "EnableValidationLayers", false);
 		F_LOG_TRACE("[Renderer] m_EnableValidationLayers is {}", (m_EnableValidationLayers ? "TRUE" : "FALSE"));
 
@@ -33,7 +34,8 @@ namespace Fling
 		appInfo.applicationVersion = VK_MAKE_VERSION(Version::EngineVersion.Major, Version::EngineVersion.Minor, Version::EngineVersion.Patch);
 		appInfo.pEngineName = "Fling Engine";
 		appInfo.engineVersion = VK_MAKE_VERSION(Version::EngineVersion.Major, Version::EngineVersion.Minor, Version::EngineVersion.Patch);
-		appInfo.apiVersion = VK_API_VERSION_1_0;
+		// 1.1 for vkGetPhysicalDeviceFeatures2, which is how optional features like descriptor indexing are found
+		appInfo.apiVersion = VK_API_VERSION_1_1;
 
 		// Instance creation info, similar to how DX11 worked
 		VkInstanceCreateInfo createInfo = {};
@@ -110,11 +112,17 @@ namespace Fling
 
     std::vector<const char*> Instance::GetRequiredExtensions()
 	{
-		UINT32 glfwExtensionCount = 0;
-		const char** glfwExtensions;
-		glfwExtensions = glfwGetRequiredInstanceExtensions( &glfwExtensionCount );
+		std::vector<const char*> extensions;
 
-		std::vector<const char*> extensions( glfwExtensions, glfwExtensions + glfwExtensionCount );
+		// There is no window to get a surface from without GLFW
+		if( m_Presentable )
+		{
+			UINT32 glfwExtensionCount = 0;
+			const char** glfwExtensions;
+			glfwExtensions = glfwGetRequiredInstanceExtensions( &glfwExtensionCount );
+
+			extensions.assign( glfwExtensions, glfwExtensions + glfwExtensionCount );
+		}
 
 		if( m_EnableValidationLayers ) 
 		{
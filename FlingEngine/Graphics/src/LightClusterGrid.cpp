@@ -0,0 +1,250 @@
+#include "pch.h"
+#include "LightClusterGrid.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace Fling
+{
+	namespace
+	{
+		/** Tile that an NDC coordinate falls in, clamped to the grid */
+		UINT32 NdcToTile(float t_Ndc, UINT32 t_TileCount)
+		{
+			const float Tile = std::floor((t_Ndc * 0.5f + 0.5f) * static_cast<float>(t_TileCount));
+			return static_cast<UINT32>(glm::clamp(Tile, 0.0f, static_cast<float>(t_TileCount - 1)));
+		}
+
+		bool SphereIntersectsBox(const glm::vec3& t_Center, float t_Radius, const glm::vec3& t_Min, const glm::vec3& t_Max)
+		{
+			const glm::vec3 Delta = glm::clamp(t_Center, t_Min, t_Max) - t_Center;
+			return glm::dot(Delta, Delta) <= t_Radius * t_Radius;
+		}
+	}
+
+	LightClusterGrid::LightClusterGrid(UINT32 t_MaxLightsPerCluster)
+		: m_MaxLightsPerCluster(t_MaxLightsPerCluster)
+	{
+		assert(m_MaxLightsPerCluster > 0);
+
+		m_ClusterMin.resize(ClusterCount);
+		m_ClusterMax.resize(ClusterCount);
+		m_BinnedIndices.resize(GetMaxLightIndices());
+		m_BinnedCounts.resize(ClusterCount);
+		m_SliceOverflow.resize(Slices);
+		m_Clusters.resize(ClusterCount);
+	}
+
+	void LightClusterGrid::Build(const glm::mat4& t_View, const glm::mat4& t_Proj, float t_Near, float t_Far, const glm::vec4* t_Lights, UINT32 t_Count)
+	{
+		assert(t_Near > 0.0f && t_Far > t_Near);
+		assert(t_Lights || t_Count == 0);
+
+		UpdateClusterBounds(t_Proj, t_Near, t_Far);
+
+		m_LightBounds.resize(t_Count);
+		m_IsLightVisible.resize(t_Count);
+
+		// Find the part of the grid that every light covers
+		JobSystem::ParallelFor(t_Count, 256, [&](UINT32 t_Begin, UINT32 t_End)
+		{
+			for (UINT32 i = t_Begin; i < t_End; ++i)
+			{
+				const glm::vec4 ViewPos = t_View * glm::vec4(glm::vec3(t_Lights[i]), 1.0f);
+				m_IsLightVisible[i] = CalculateLightBounds(glm::vec4(glm::vec3(ViewPos), t_Lights[i].w), m_LightBounds[i]) ? 1 : 0;
+			}
+		});
+
+		// Every slice owns it's clusters so slices can be binned without any locking. Lights are
+		// visited in order, which keeps each cluster's list sorted
+		JobSystem::ParallelFor(Slices, 1, [&](UINT32 t_Begin, UINT32 t_End)
+		{
+			for (UINT32 Slice = t_Begin; Slice < t_End; ++Slice)
+			{
+				UINT32* Counts = m_BinnedCounts.data() + GetClusterIndex(0, 0, Slice);
+				std::fill(Counts, Counts + TilesX * TilesY, 0);
+
+				UINT32 Overflow = 0;
+				for (UINT32 i = 0; i < t_Count; ++i)
+				{
+					const LightBounds& Bounds = m_LightBounds[i];
+					if (!m_IsLightVisible[i] || Slice < Bounds.MinSlice || Slice > Bounds.MaxSlice)
+					{
+						continue;
+					}
+
+					for (UINT32 y = Bounds.MinY; y <= Bounds.MaxY; ++y)
+					{
+						for (UINT32 x = Bounds.MinX; x <= Bounds.MaxX; ++x)
+						{
+							const UINT32 Cluster = GetClusterIndex(x, y, Slice);
+							if (!SphereIntersectsBox(Bounds.ViewPos, Bounds.Radius, m_ClusterMin[Cluster], m_ClusterMax[Cluster]))
+							{
+								continue;
+							}
+
+							UINT32& Count = m_BinnedCounts[Cluster];
+							if (Count < m_MaxLightsPerCluster)
+							{
+								m_BinnedIndices[Cluster * m_MaxLightsPerCluster + Count++] = i;
+							}
+							else
+							{
+								++Overflow;
+							}
+						}
+					}
+				}
+				m_SliceOverflow[Slice] = Overflow;
+			}
+		});
+
+		// Pack the lists together so that only the used part has to go to the GPU
+		UINT32 Total = 0;
+		for (UINT32 c = 0; c < ClusterCount; ++c)
+		{
+			m_Clusters[c].Offset = Total;
+			m_Clusters[c].Count = m_BinnedCounts[c];
+			Total += m_BinnedCounts[c];
+		}
+
+		m_LightIndices.resize(Total);
+		JobSystem::ParallelFor(ClusterCount, 256, [&](UINT32 t_Begin, UINT32 t_End)
+		{
+			for (UINT32 c = t_Begin; c < t_End; ++c)
+			{
+				const UINT32* Binned = m_BinnedIndices.data() + c * m_MaxLightsPerCluster;
+				std::copy(Binned, Binned + m_Clusters[c].Count, m_LightIndices.data() + m_Clusters[c].Offset);
+			}
+		});
+
+		m_OverflowCount = std::accumulate(m_SliceOverflow.begin(), m_SliceOverflow.end(), 0u);
+	}
+
+	UINT32 LightClusterGrid::GetSlice(float t_Depth) const
+	{
+		if (t_Depth <= m_Near)
+		{
+			return 0;
+		}
+
+		const float Slice = std::floor(std::log(t_Depth) * m_SliceScale + m_SliceBias);
+		return static_cast<UINT32>(glm::clamp(Slice, 0.0f, static_cast<float>(Slices - 1)));
+	}
+
+	UINT32 LightClusterGrid::FindCluster(const glm::vec3& t_ViewPos) const
+	{
+		const glm::vec4 Clip = m_Proj * glm::vec4(t_ViewPos, 1.0f);
+		return GetClusterIndex(
+			NdcToTile(Clip.x / Clip.w, TilesX),
+			NdcToTile(Clip.y / Clip.w, TilesY),
+			GetSlice(-t_ViewPos.z));
+	}
+
+	void LightClusterGrid::UpdateClusterBounds(const glm::mat4& t_Proj, float t_Near, float t_Far)
+	{
+		if (t_Proj == m_Proj && t_Near == m_Near && t_Far == m_Far)
+		{
+			return;
+		}
+
+		m_Proj = t_Proj;
+		m_Near = t_Near;
+		m_Far = t_Far;
+
+		const float LogRatio = std::log(t_Far / t_Near);
+		m_SliceScale = static_cast<float>(Slices) / LogRatio;
+		m_SliceBias = -static_cast<float>(Slices) * std::log(t_Near) / LogRatio;
+
+		// View space direction through every tile corner, scaled to a depth of 1
+		const glm::mat4 InvProj = glm::inverse(t_Proj);
+		std::vector<glm::vec3> Corners((TilesX + 1) * (TilesY + 1));
+		for (UINT32 y = 0; y <= TilesY; ++y)
+		{
+			for (UINT32 x = 0; x <= TilesX; ++x)
+			{
+				const glm::vec4 Ndc(
+					static_cast<float>(x) / TilesX * 2.0f - 1.0f,
+					static_cast<float>(y) / TilesY * 2.0f - 1.0f,
+					0.0f,
+					1.0f);
+
+				glm::vec4 Pos = InvProj * Ndc;
+				Pos /= Pos.w;
+				Corners[y * (TilesX + 1) + x] = glm::vec3(Pos) / -Pos.z;
+			}
+		}
+
+		for (UINT32 Slice = 0; Slice < Slices; ++Slice)
+		{
+			const float SliceNear = t_Near * std::pow(t_Far / t_Near, static_cast<float>(Slice) / Slices);
+			const float SliceFar = t_Near * std::pow(t_Far / t_Near, static_cast<float>(Slice + 1) / Slices);
+
+			for (UINT32 y = 0; y < TilesY; ++y)
+			{
+				for (UINT32 x = 0; x < TilesX; ++x)
+				{
+					glm::vec3 Min(FLT_MAX);
+					glm::vec3 Max(-FLT_MAX);
+					for (UINT32 c = 0; c < 4; ++c)
+					{
+						const glm::vec3& Dir = Corners[(y + (c >> 1)) * (TilesX + 1) + x + (c & 1)];
+						Min = glm::min(Min, glm::min(Dir * SliceNear, Dir * SliceFar));
+						Max = glm::max(Max, glm::max(Dir * SliceNear, Dir * SliceFar));
+					}
+
+					const UINT32 Cluster = GetClusterIndex(x, y, Slice);
+					m_ClusterMin[Cluster] = Min;
+					m_ClusterMax[Cluster] = Max;
+				}
+			}
+		}
+	}
+
+	bool LightClusterGrid::CalculateLightBounds(const glm::vec4& t_ViewSphere, LightBounds& t_Out) const
+	{
+		const glm::vec3 Center(t_ViewSphere);
+		const float Radius = t_ViewSphere.w;
+
+		// The camera looks down -Z
+		const float MinDepth = std::max(-Center.z - Radius, m_Near);
+		const float MaxDepth = std::min(-Center.z + Radius, m_Far);
+		if (Radius <= 0.0f || MinDepth > MaxDepth)
+		{
+			return false;
+		}
+
+		// Project the light's bounding box, clamped to the depth range so that every corner is in front of the camera
+		glm::vec2 NdcMin(FLT_MAX);
+		glm::vec2 NdcMax(-FLT_MAX);
+		for (UINT32 c = 0; c < 8; ++c)
+		{
+			const glm::vec4 Corner(
+				(c & 1) ? Center.x + Radius : Center.x - Radius,
+				(c & 2) ? Center.y + Radius : Center.y - Radius,
+				(c & 4) ? -MaxDepth : -MinDepth,
+				1.0f);
+
+			const glm::vec4 Clip = m_Proj * Corner;
+			const glm::vec2 Ndc = glm::vec2(Clip) / Clip.w;
+			NdcMin = glm::min(NdcMin, Ndc);
+			NdcMax = glm::max(NdcMax, Ndc);
+		}
+
+		if (NdcMax.x < -1.0f || NdcMin.x > 1.0f || NdcMax.y < -1.0f || NdcMin.y > 1.0f)
+		{
+			return false;
+		}
+
+		t_Out.ViewPos = Center;
+		t_Out.Radius = Radius;
+		t_Out.MinSlice = GetSlice(MinDepth);
+		t_Out.MaxSlice = GetSlice(MaxDepth);
+		t_Out.MinX = NdcToTile(NdcMin.x, TilesX);
+		t_Out.MaxX = NdcToTile(NdcMax.x, TilesX);
+		t_Out.MinY = NdcToTile(NdcMin.y, TilesY);
+		t_Out.MaxY = NdcToTile(NdcMax.y, TilesY);
+		return true;
+	}
+}   // namespace Fling
@@ -0,0 +1,100 @@
+#include "pch.h"
+#include "LodSelector.h"
+#include "Camera.h"
+#include "Components/Transform.h"
+#include "MeshRenderer.h"
+#include "JobSystem.h"
+
+namespace Fling
+{
+	LodSelector::LodSelector(float t_MaxScreenError, float t_Hysteresis)
+		: m_MaxScreenError(t_MaxScreenError)
+		, m_Hysteresis(t_Hysteresis)
+	{
+	}
+
+	UINT32 LodSelector::SelectLod(
+		const MeshLod* t_Lods,
+		UINT32 t_LodCount,
+		float t_ScreenSize,
+		float t_Radius,
+		UINT32 t_CurrentLod,
+		float t_MaxScreenError,
+		float t_Hysteresis)
+	{
+		if (t_LodCount <= 1 || t_Radius <= 0.0f)
+		{
+			return 0;
+		}
+
+		// The error of a level is in model space, scaling it the same way as the radius puts it on screen
+		const float ErrorScale = t_ScreenSize / t_Radius;
+		for (UINT32 Lod = t_LodCount - 1; Lod > 0; --Lod)
+		{
+			const float MaxError = Lod > t_CurrentLod ? t_MaxScreenError * (1.0f - t_Hysteresis) : t_MaxScreenError;
+			if (t_Lods[Lod].Error * ErrorScale <= MaxError)
+			{
+				return Lod;
+			}
+		}
+		return 0;
+	}
+
+	void LodSelector::Select(entt::registry& t_Reg, const Camera& t_Camera, const std::vector<entt::entity>& t_Visible)
+	{
+		Select(t_Reg, t_Camera.GetProjectionMatrix() * t_Camera.GetViewMatrix(), t_Visible);
+	}
+
+	void LodSelector::Select(entt::registry& t_Reg, const glm::mat4& t_ViewProj, const std::vector<entt::entity>& t_Visible)
+	{
+		const UINT32 Count = static_cast<UINT32>(t_Visible.size());
+
+		// The y row of the view projection is the view's up axis scaled by the focal length
+		const float FocalLength = glm::length(glm::vec3(t_ViewProj[0][1], t_ViewProj[1][1], t_ViewProj[2][1]));
+
+		// Every mesh only writes to it's own MeshRenderer
+		JobSystem::ParallelFor(Count, 256, [&](UINT32 t_Begin, UINT32 t_End)
+		{
+			for (UINT32 i = t_Begin; i < t_End; ++i)
+			{
+				MeshRenderer& MeshRend = t_Reg.get<MeshRenderer>(t_Visible[i]);
+				const Model* Model = MeshRend.m_Model;
+				if (!m_IsEnabled || !Model || !Model->IsReady() || Model->GetLodCount() <= 1)
+				{
+					MeshRend.m_LodIndex = 0;
+					continue;
+				}
+
+				const BoundingSphere& ModelSphere = Model->GetBoundingSphere();
+				const BoundingSphere Sphere = ModelSphere.Transformed(t_Reg.get<Transform>(t_Visible[i]).GetWorldMat());
+				const float Depth = (t_ViewProj * glm::vec4(Sphere.Center, 1.0f)).w;
+				const float ScreenSize = Sphere.Radius * FocalLength / std::max(Depth, Sphere.Radius);
+
+				MeshRend.m_LodIndex = static_cast<UINT8>(SelectLod(
+					Model->GetLods().data(),
+					Model->GetLodCount(),
+					ScreenSize,
+					ModelSphere.Radius,
+					MeshRend.m_LodIndex,
+					m_MaxScreenError,
+					m_Hysteresis));
+			}
+		});
+
+		m_TriangleCount = 0;
+		m_FullTriangleCount = 0;
+		std::fill(std::begin(m_MeshCountAtLod), std::end(m_MeshCountAtLod), 0);
+		for (entt::entity Ent : t_Visible)
+		{
+			const MeshRenderer& MeshRend = t_Reg.get<MeshRenderer>(Ent);
+			if (!MeshRend.m_Model || !MeshRend.m_Model->IsReady())
+			{
+				continue;
+			}
+
+			++m_MeshCountAtLod[MeshRend.m_LodIndex];
+			m_TriangleCount += MeshRend.m_Model->GetLod(MeshRend.m_LodIndex).IndexCount / 3;
+			m_FullTriangleCount += MeshRend.m_Model->GetLod(0).IndexCount / 3;
+		}
+	}
+}   // namespace Fling
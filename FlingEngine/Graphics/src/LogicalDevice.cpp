@@ -2,6 +2,7 @@
 #include "LogicalDevice.h"
 #include "Instance.h"
 #include "PhyscialDevice.h"
+#include "FlingConfig.h"
 
 namespace Fling
 {
@@ -38,9 +39,12 @@ namespace Fling
 				m_SupportedQueues |= VK_QUEUE_GRAPHICS_BIT;
 			}
 
-			// Check for presentation support.
-			VkBool32 presentSupport;
-			vkGetPhysicalDeviceSurfaceSupportKHR(m_PhysicalDevice->GetVkPhysicalDevice(), i, m_Surface, &presentSupport);
+			// Check for presentation support. Headless devices don't have a surface to present to
+			VkBool32 presentSupport = VK_FALSE;
+			if (m_Surface != VK_NULL_HANDLE)
+			{
+				vkGetPhysicalDeviceSurfaceSupportKHR(m_PhysicalDevice->GetVkPhysicalDevice(), i, m_Surface, &presentSupport);
+			}
 
 			if (QueueFamilies[i].queueCount > 0 && presentSupport)
 			{
@@ -60,7 +64,6 @@ namespace Fling
 			if (QueueFamilies[i].queueFlags & VK_QUEUE_TRANSFER_BIT)
 			{
 				transferFamily = i;
-				m_TransferFamily = i;
 				m_SupportedQueues |= VK_QUEUE_TRANSFER_BIT;
 			}
 
@@ -74,11 +77,51 @@ namespace Fling
 		{
 			F_LOG_FATAL("Failed to find queue family supporting VK_QUEUE_GRAPHICS_BIT");
 		}
+
+		if (m_Surface == VK_NULL_HANDLE)
+		{
+			m_PresentFamily = m_GraphicsFamily;
+		}
+
+		// Uploads can be copied while the graphics queue is busy drawing
+		m_TransferFamily = m_GraphicsFamily;
+		if (FlingConfig::GetBool("Vulkan", "UseTransferQueue", true))
+		{
+			m_TransferFamily = FindTransferFamily(QueueFamilies, m_GraphicsFamily);
+		}
+		F_LOG_TRACE("[Renderer] Uploads use queue family {}{}", m_TransferFamily, (HasTransferQueue() ? "" : " (graphics)"));
+	}
+
+	UINT32 LogicalDevice::FindTransferFamily(const std::vector<VkQueueFamilyProperties>& t_Families, UINT32 t_GraphicsFamily)
+	{
+		// Graphics and compute families can always copy, even if they don't say so
+		const VkQueueFlags CopyFlags = VK_QUEUE_TRANSFER_BIT | VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
+
+		UINT32 Fallback = t_GraphicsFamily;
+		for (UINT32 i = 0; i < static_cast<UINT32>(t_Families.size()); ++i)
+		{
+			const VkQueueFlags Flags = t_Families[i].queueFlags;
+			if (i == t_GraphicsFamily || t_Families[i].queueCount == 0 || (Flags & CopyFlags) == 0 || (Flags & VK_QUEUE_GRAPHICS_BIT))
+			{
+				continue;
+			}
+
+			if ((Flags & VK_QUEUE_COMPUTE_BIT) == 0)
+			{
+				return i;
+			}
+
+			if (Fallback == t_GraphicsFamily)
+			{
+				Fallback = i;
+			}
+		}
+		return Fallback;
 	}
 
 	void LogicalDevice::CreateDevice()
     {
-        std::set<UINT32> UniqueQueueFamilies = { m_GraphicsFamily, m_PresentFamily };
+        std::set<UINT32> UniqueQueueFamilies = { m_GraphicsFamily, m_PresentFamily, m_TransferFamily };
 
         // Generate the CreatinInfo for each queue family 
 		std::vector<VkDeviceQueueCreateInfo> QueueCreateInfos;
@@ -97,18 +140,42 @@ namespace Fling
         VkPhysicalDeviceFeatures DevicesFeatures = {};
 		DevicesFeatures.samplerAnisotropy = VK_TRUE;
 		DevicesFeatures.sampleRateShading = VK_TRUE;
+		// Instanced batches are drawn with indirect draws that start at their own first instance
+		DevicesFeatures.drawIndirectFirstInstance = VK_TRUE;
+		// Cooked textures are BC compressed, devices without it fall back to the source images
+		DevicesFeatures.textureCompressionBC = m_PhysicalDevice->GetDeivceFeatures().textureCompressionBC;
+
 
+        // Nothing is presented without a surface, so there is no swap chain either
+        std::vector<const char*> Extensions;
+        if (m_Surface != VK_NULL_HANDLE)
+        {
+            Extensions = m_Instance->GetEnabledExtensions();
+        }
+
+		// Bindless materials only need the parts of descriptor indexing that the physical device checked for
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT IndexingFeatures = {};
+		IndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+		if (m_PhysicalDevice->SupportsBindless())
+		{
+			IndexingFeatures.runtimeDescriptorArray = VK_TRUE;
+			IndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+			IndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+			IndexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+			Extensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+		}
 
         // Device creation 
         VkDeviceCreateInfo CreateInfo = {};
         CreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        CreateInfo.pNext = m_PhysicalDevice->SupportsBindless() ? &IndexingFeatures : nullptr;
         CreateInfo.queueCreateInfoCount = static_cast<UINT32>(QueueCreateInfos.size());
         CreateInfo.pQueueCreateInfos = QueueCreateInfos.data();
         CreateInfo.pEnabledFeatures = &DevicesFeatures;
 
         // Set the enabled extensions
-        CreateInfo.enabledExtensionCount = static_cast<UINT32>(m_Instance->GetEnabledExtensions().size());
-        CreateInfo.ppEnabledExtensionNames = m_Instance->GetEnabledExtensions().data();
+        CreateInfo.enabledExtensionCount = static_cast<UINT32>(Extensions.size());
+        CreateInfo.ppEnabledExtensionNames = Extensions.data();
 
         if( m_Instance->IsValidationEnabled() ) 
         {
@@ -127,6 +194,7 @@ namespace Fling
 
         vkGetDeviceQueue(m_Device, m_GraphicsFamily, 0, &m_GraphicsQueue);
         vkGetDeviceQueue(m_Device, m_PresentFamily, 0, &m_PresentQueue);
+        vkGetDeviceQueue(m_Device, m_TransferFamily, 0, &m_TransferQueue);
     }
 
 	void LogicalDevice::WaitForIdle()
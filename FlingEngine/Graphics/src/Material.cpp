@@ -43,21 +43,22 @@ namespace Fling
 			}
 
             // Load Textures -------------
+			// These will use the placeholder texture until they have been uploaded
             // Albedo
             const std::string& AlbedoPath = m_JsonData["albedo"];
-            m_Textures.m_AlbedoTexture = Texture::Create(HS(AlbedoPath.c_str())).get();
+            m_Textures.m_AlbedoTexture = Texture::CreateAsync(HS(AlbedoPath.c_str())).get();
 
             // Normal
             const std::string& NormalPath = m_JsonData["normal"];
-            m_Textures.m_NormalTexture = Texture::Create(HS(NormalPath.c_str())).get();
+            m_Textures.m_NormalTexture = Texture::CreateAsync(HS(NormalPath.c_str())).get();
 
             // Metal
             const std::string& MetalPath = m_JsonData["metal"];
-            m_Textures.m_MetalTexture = Texture::Create(HS(MetalPath.c_str())).get();
+            m_Textures.m_MetalTexture = Texture::CreateAsync(HS(MetalPath.c_str())).get();
 
             // Rough
             const std::string& RoughPath = m_JsonData["rough"];
-            m_Textures.m_RoughnessTexture = Texture::Create(HS(RoughPath.c_str())).get();
+            m_Textures.m_RoughnessTexture = Texture::CreateAsync(HS(RoughPath.c_str())).get();
         }
         catch (std::exception& e)
         {
@@ -0,0 +1,204 @@
+#include "pch.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+#include "VertexQuantization.h"
+
+#include <algorithm>
+#include <fstream>
+#include <filesystem>
+
+namespace Fling
+{
+	namespace
+	{
+		UINT64 AlignUp(UINT64 t_Value, UINT64 t_Alignment)
+		{
+			return (t_Value + t_Alignment - 1) & ~(t_Alignment - 1);
+		}
+
+		void WritePadding(std::ofstream& t_File, UINT64 t_To)
+		{
+			static const char Zeros[MeshFile::DataAlignment] = {};
+			const UINT64 Pos = static_cast<UINT64>(t_File.tellp());
+			if (t_To > Pos)
+			{
+				t_File.write(Zeros, static_cast<std::streamsize>(t_To - Pos));
+			}
+		}
+
+		template<typename T>
+		bool AreIndicesInRange(const UINT8* t_Data, UINT32 t_IndexCount, UINT32 t_VertexCount)
+		{
+			const T* Indices = reinterpret_cast<const T*>(t_Data);
+			return std::all_of(Indices, Indices + t_IndexCount, [t_VertexCount](T t_Index) { return t_Index < t_VertexCount; });
+		}
+	}
+
+	bool MeshFile::Write(
+		const std::string& t_FilePath,
+		const std::vector<Vertex>& t_Verts,
+		const std::vector<UINT32>& t_Indices,
+		const BoundingBox& t_Bounds,
+		VertexFormat t_Format,
+		const std::vector<MeshLod>& t_Lods)
+	{
+		assert(t_Lods.size() <= MaxMeshLods);
+
+		const UINT32 VertexStride = GetVertexStride(t_Format);
+
+		MeshFileHeader Header = {};
+		Header.Magic = Magic;
+		Header.Version = Version;
+		Header.VertexStride = VertexStride;
+		Header.VertexFormat = static_cast<UINT32>(t_Format);
+		Header.VertexCount = static_cast<UINT32>(t_Verts.size());
+		Header.IndexCount = static_cast<UINT32>(t_Indices.size());
+		Header.IndexSize = MeshOptimizer::CanUse16BitIndices(Header.VertexCount) ? sizeof(UINT16) : sizeof(UINT32);
+		Header.VertexOffset = AlignUp(sizeof(MeshFileHeader), DataAlignment);
+		Header.IndexOffset = AlignUp(Header.VertexOffset + static_cast<UINT64>(VertexStride) * t_Verts.size(), DataAlignment);
+		for (UINT32 i = 0; i < 3; ++i)
+		{
+			Header.BoundsMin[i] = t_Bounds.Min[i];
+			Header.BoundsMax[i] = t_Bounds.Max[i];
+		}
+
+		if (t_Lods.empty())
+		{
+			Header.LodCount = 1;
+			Header.Lods[0].IndexCount = Header.IndexCount;
+		}
+		else
+		{
+			Header.LodCount = static_cast<UINT32>(t_Lods.size());
+			std::copy(t_Lods.begin(), t_Lods.end(), Header.Lods);
+		}
+
+		std::ofstream File(t_FilePath, std::ios::binary | std::ios::trunc);
+		if (!File.is_open())
+		{
+			F_LOG_ERROR("Failed to open {} for writing", t_FilePath);
+			return false;
+		}
+
+		File.write(reinterpret_cast<const char*>(&Header), sizeof(Header));
+		WritePadding(File, Header.VertexOffset);
+		if (t_Format == VertexFormat::Packed)
+		{
+			std::vector<PackedVertex> Packed;
+			VertexQuantization::PackVertices(t_Verts, VertexQuantization::GetDequantize(t_Bounds), Packed);
+			File.write(reinterpret_cast<const char*>(Packed.data()), static_cast<std::streamsize>(sizeof(PackedVertex) * Packed.size()));
+		}
+		else
+		{
+			File.write(reinterpret_cast<const char*>(t_Verts.data()), static_cast<std::streamsize>(sizeof(Vertex) * t_Verts.size()));
+		}
+		WritePadding(File, Header.IndexOffset);
+		if (Header.IndexSize == sizeof(UINT16))
+		{
+			const std::vector<UINT16> ShortIndices(t_Indices.begin(), t_Indices.end());
+			File.write(reinterpret_cast<const char*>(ShortIndices.data()), static_cast<std::streamsize>(sizeof(UINT16) * ShortIndices.size()));
+		}
+		else
+		{
+			File.write(reinterpret_cast<const char*>(t_Indices.data()), static_cast<std::streamsize>(sizeof(UINT32) * t_Indices.size()));
+		}
+
+		return File.good();
+	}
+
+	std::string MeshFile::GetCookedPath(const std::string& t_SourcePath)
+	{
+		return std::filesystem::path(t_SourcePath).replace_extension(Extension).string();
+	}
+
+	bool MeshFile::IsUpToDate(const std::string& t_SourcePath, const std::string& t_CookedPath)
+	{
+		std::error_code Error;
+		const auto CookedTime = std::filesystem::last_write_time(t_CookedPath, Error);
+		if (Error)
+		{
+			return false;
+		}
+
+		// Shipped builds may only have the cooked file
+		const auto SourceTime = std::filesystem::last_write_time(t_SourcePath, Error);
+		return Error || CookedTime >= SourceTime;
+	}
+
+	bool MeshFile::Open(const std::string& t_FilePath)
+	{
+		Close();
+
+		if (!m_File.Open(t_FilePath) || m_File.GetSize() < sizeof(MeshFileHeader))
+		{
+			m_File.Close();
+			return false;
+		}
+
+		const MeshFileHeader* Header = reinterpret_cast<const MeshFileHeader*>(m_File.GetData());
+		const VertexFormat Format = static_cast<VertexFormat>(Header->VertexFormat);
+		if (Header->Magic != Magic || Header->Version != Version ||
+			(Format != VertexFormat::Full && Format != VertexFormat::Packed) || Header->VertexStride != GetVertexStride(Format) ||
+			(Header->IndexSize != sizeof(UINT16) && Header->IndexSize != sizeof(UINT32)) ||
+			Header->LodCount == 0 || Header->LodCount > MaxMeshLods)
+		{
+			F_LOG_WARN("Cooked mesh {} is from an older version and needs to be cooked again", t_FilePath);
+			m_File.Close();
+			return false;
+		}
+
+		const UINT64 FileSize = static_cast<UINT64>(m_File.GetSize());
+		const UINT64 VertexEnd = Header->VertexOffset + static_cast<UINT64>(Header->VertexCount) * Header->VertexStride;
+		const UINT64 IndexEnd = Header->IndexOffset + static_cast<UINT64>(Header->IndexCount) * Header->IndexSize;
+		if (Header->VertexOffset % DataAlignment != 0 || Header->IndexOffset % DataAlignment != 0 ||
+			VertexEnd > FileSize || IndexEnd > FileSize)
+		{
+			F_LOG_ERROR("Cooked mesh {} is truncated or corrupt", t_FilePath);
+			m_File.Close();
+			return false;
+		}
+
+		for (UINT32 i = 0; i < Header->LodCount; ++i)
+		{
+			const MeshLod& Lod = Header->Lods[i];
+			if (static_cast<UINT64>(Lod.FirstIndex) + Lod.IndexCount > Header->IndexCount)
+			{
+				F_LOG_ERROR("Cooked mesh {} has a level of detail past the end of its indices", t_FilePath);
+				m_File.Close();
+				return false;
+			}
+		}
+
+		// An index past the vertices would be read out of bounds by the GPU and by the occlusion rasterizer
+		const UINT8* IndexData = m_File.GetData() + Header->IndexOffset;
+		const bool IndicesInRange = Header->IndexSize == sizeof(UINT16) ?
+			AreIndicesInRange<UINT16>(IndexData, Header->IndexCount, Header->VertexCount) :
+			AreIndicesInRange<UINT32>(IndexData, Header->IndexCount, Header->VertexCount);
+		if (!IndicesInRange)
+		{
+			F_LOG_ERROR("Cooked mesh {} has an index past the end of its vertices", t_FilePath);
+			m_File.Close();
+			return false;
+		}
+
+		m_Header = Header;
+		return true;
+	}
+
+	void MeshFile::Close()
+	{
+		m_Header = nullptr;
+		m_File.Close();
+	}
+
+	BoundingBox MeshFile::GetBounds() const
+	{
+		BoundingBox Bounds = {};
+		for (UINT32 i = 0; i < 3; ++i)
+		{
+			Bounds.Min[i] = m_Header->BoundsMin[i];
+			Bounds.Max[i] = m_Header->BoundsMax[i];
+		}
+		return Bounds;
+	}
+}   // namespace Fling
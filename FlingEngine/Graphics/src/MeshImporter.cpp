@@ -0,0 +1,329 @@
+#include "pch.h"
+#include "MeshImporter.h"
+#include "MeshFile.h"
+#include "VertexQuantization.h"
+#include "MeshSimplifier.h"
+#include "JobSystem.h"
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+namespace Fling
+{
+	namespace MeshImporter
+	{
+		namespace
+		{
+			/** Triangles smaller than this in UV space have no tangent direction of their own */
+			constexpr float MinUVArea = FLT_MIN;
+
+			/** Number of triangles given to each job when generating normals and tangents */
+			constexpr UINT32 TriangleGrain = 4096;
+			constexpr UINT32 VertexGrain = 4096;
+
+			/** Angle between two edges leaving the same corner, zero if either is degenerate */
+			float CornerAngle(const glm::vec3& t_EdgeA, const glm::vec3& t_EdgeB)
+			{
+				const float LengthSq = glm::dot(t_EdgeA, t_EdgeA) * glm::dot(t_EdgeB, t_EdgeB);
+				if (LengthSq <= 0.0f)
+				{
+					return 0.0f;
+				}
+				return std::acos(glm::clamp(glm::dot(t_EdgeA, t_EdgeB) / std::sqrt(LengthSq), -1.0f, 1.0f));
+			}
+
+			/**
+			 * @brief	Bucket the corners of a triangle list by a key per corner, like the vertex or the
+			 *			position that it uses. The corners of each key stay in index order, so summing over
+			 *			them gives the same result no matter how many threads did the work.
+			 */
+			void GroupCorners(const UINT32* t_Keys, UINT32 t_NumCorners, UINT32 t_NumKeys, std::vector<UINT32>& t_OutOffsets, std::vector<UINT32>& t_OutCorners)
+			{
+				t_OutOffsets.assign(t_NumKeys + 1, 0);
+				for (UINT32 i = 0; i < t_NumCorners; ++i)
+				{
+					++t_OutOffsets[t_Keys[i] + 1];
+				}
+				for (UINT32 k = 0; k < t_NumKeys; ++k)
+				{
+					t_OutOffsets[k + 1] += t_OutOffsets[k];
+				}
+
+				t_OutCorners.resize(t_NumCorners);
+				std::vector<UINT32> Fill(t_OutOffsets.begin(), t_OutOffsets.end() - 1);
+				for (UINT32 i = 0; i < t_NumCorners; ++i)
+				{
+					t_OutCorners[Fill[t_Keys[i]]++] = i;
+				}
+			}
+
+			/** Any unit vector that is perpendicular to the given one */
+			glm::vec3 GetPerpendicular(const glm::vec3& t_Dir)
+			{
+				const glm::vec3 Axis = std::abs(t_Dir.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+				return glm::normalize(glm::cross(t_Dir, Axis));
+			}
+		}
+
+		bool LoadObj(const std::string& t_FilePath, std::vector<Vertex>& t_OutVerts, std::vector<UINT32>& t_OutIndices)
+		{
+			tinyobj::attrib_t attrib;
+			std::vector<tinyobj::shape_t> shapes;
+			std::vector<tinyobj::material_t> materials;
+			std::string warn;
+			std::string err;
+
+			// Load the model from tiny obj
+			if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, t_FilePath.c_str()))
+			{
+				F_LOG_ERROR("Failed to load model: {} {}", warn, err);
+				return false;
+			}
+
+			// Parse all shapes to get the verts and indecies of this object
+			for (const tinyobj::shape_t& shape : shapes)
+			{
+				for (const tinyobj::index_t& index : shape.mesh.indices)
+				{
+					Vertex vertex = {};
+					vertex.Pos =
+					{
+						attrib.vertices[3 * index.vertex_index + 0],
+						attrib.vertices[3 * index.vertex_index + 1],
+						attrib.vertices[3 * index.vertex_index + 2]
+					};
+
+					// Normals and UVs are optional in an obj. Missing normals are left at zero
+					// so that CalculateSmoothNormals can fill them in
+					if (index.normal_index >= 0)
+					{
+						vertex.Normal =
+						{
+							attrib.normals[3 * index.normal_index + 0],
+							attrib.normals[3 * index.normal_index + 1],
+							attrib.normals[3 * index.normal_index + 2]
+						};
+					}
+
+					if (index.texcoord_index >= 0)
+					{
+						vertex.TexCoord =
+						{
+							attrib.texcoords[2 * index.texcoord_index + 0],
+							attrib.texcoords[2 * index.texcoord_index + 1]
+						};
+					}
+
+					vertex.Color = { 1.0f, 1.0f, 1.0f };
+
+					t_OutVerts.push_back(vertex);
+					t_OutIndices.push_back(static_cast<UINT32>(t_OutIndices.size()));
+				}
+			}
+
+			return !t_OutVerts.empty();
+		}
+
+		void CalculateSmoothNormals(Vertex* t_Verts, UINT32 t_NumVerts, const UINT32* t_Indices, UINT32 t_NumIndices)
+		{
+			const glm::vec3 Zero(0.0f);
+			if (std::none_of(t_Verts, t_Verts + t_NumVerts, [&Zero](const Vertex& t_Vert) { return t_Vert.Normal == Zero; }))
+			{
+				return;
+			}
+
+			// Vertices at the same position are smoothed together, even if they are split by their UVs
+			std::unordered_map<glm::vec3, UINT32> PositionLookup;
+			std::vector<UINT32> PositionOfVertex(t_NumVerts);
+			for (UINT32 v = 0; v < t_NumVerts; ++v)
+			{
+				PositionOfVertex[v] = PositionLookup.emplace(t_Verts[v].Pos, static_cast<UINT32>(PositionLookup.size())).first->second;
+			}
+			const UINT32 NumPositions = static_cast<UINT32>(PositionLookup.size());
+
+			const UINT32 NumTris = t_NumIndices / 3;
+			std::vector<UINT32> CornerPositions(NumTris * 3);
+			std::vector<glm::vec3> CornerNormals(NumTris * 3);
+
+			// Face normal of every triangle weighted by the angle of each corner
+			JobSystem::ParallelFor(NumTris, TriangleGrain, [&](UINT32 t_Begin, UINT32 t_End)
+			{
+				for (UINT32 t = t_Begin; t < t_End; ++t)
+				{
+					const glm::vec3 P[3] = { t_Verts[t_Indices[t * 3 + 0]].Pos, t_Verts[t_Indices[t * 3 + 1]].Pos, t_Verts[t_Indices[t * 3 + 2]].Pos };
+					const glm::vec3 Cross = glm::cross(P[1] - P[0], P[2] - P[0]);
+					const float Length = glm::length(Cross);
+					const glm::vec3 FaceNormal = Length > 0.0f ? Cross / Length : Zero;
+
+					for (UINT32 c = 0; c < 3; ++c)
+					{
+						CornerPositions[t * 3 + c] = PositionOfVertex[t_Indices[t * 3 + c]];
+						CornerNormals[t * 3 + c] = FaceNormal * CornerAngle(P[(c + 1) % 3] - P[c], P[(c + 2) % 3] - P[c]);
+					}
+				}
+			});
+
+			std::vector<UINT32> Offsets;
+			std::vector<UINT32> Corners;
+			GroupCorners(CornerPositions.data(), NumTris * 3, NumPositions, Offsets, Corners);
+
+			std::vector<glm::vec3> PositionNormals(NumPositions);
+			JobSystem::ParallelFor(NumPositions, VertexGrain, [&](UINT32 t_Begin, UINT32 t_End)
+			{
+				for (UINT32 p = t_Begin; p < t_End; ++p)
+				{
+					glm::vec3 Sum = Zero;
+					for (UINT32 i = Offsets[p]; i < Offsets[p + 1]; ++i)
+					{
+						Sum += CornerNormals[Corners[i]];
+					}
+
+					// Points that only touch degenerate triangles still need a valid normal
+					const float Length = glm::length(Sum);
+					PositionNormals[p] = Length > 0.0f ? Sum / Length : glm::vec3(0.0f, 0.0f, 1.0f);
+				}
+			});
+
+			for (UINT32 v = 0; v < t_NumVerts; ++v)
+			{
+				if (t_Verts[v].Normal == Zero)
+				{
+					t_Verts[v].Normal = PositionNormals[PositionOfVertex[v]];
+				}
+			}
+		}
+
+		void CalculateVertexTangents(Vertex* verts, UINT32 numVerts, const UINT32* indices, UINT32 numIndices)
+		{
+			const UINT32 NumTris = numIndices / 3;
+			std::vector<glm::vec3> CornerTangents(NumTris * 3);
+
+			// Tangent of every triangle corner, the same way that MikkTSpace does it. The direction of
+			// increasing U is projected onto the plane of the corner's normal and weighted by the
+			// angle of the corner in that plane
+			JobSystem::ParallelFor(NumTris, TriangleGrain, [&](UINT32 t_Begin, UINT32 t_End)
+			{
+				for (UINT32 t = t_Begin; t < t_End; ++t)
+				{
+					const Vertex* V[3] = { &verts[indices[t * 3 + 0]], &verts[indices[t * 3 + 1]], &verts[indices[t * 3 + 2]] };
+
+					const glm::vec3 D1 = V[1]->Pos - V[0]->Pos;
+					const glm::vec3 D2 = V[2]->Pos - V[0]->Pos;
+					const glm::vec2 T21 = V[1]->TexCoord - V[0]->TexCoord;
+					const glm::vec2 T31 = V[2]->TexCoord - V[0]->TexCoord;
+
+					// Mirrored UVs flip the winding in UV space, which would flip the tangent
+					const float SignedUVArea = T21.x * T31.y - T21.y * T31.x;
+					const glm::vec3 FaceTangent = (D1 * T31.y - D2 * T21.y) * (SignedUVArea < 0.0f ? -1.0f : 1.0f);
+
+					for (UINT32 c = 0; c < 3; ++c)
+					{
+						glm::vec3& Out = CornerTangents[t * 3 + c];
+						Out = glm::vec3(0.0f);
+						if (std::abs(SignedUVArea) <= MinUVArea)
+						{
+							continue;
+						}
+
+						const glm::vec3& N = V[c]->Normal;
+						const glm::vec3 Tangent = FaceTangent - N * glm::dot(N, FaceTangent);
+						const float Length = glm::length(Tangent);
+						if (Length <= 0.0f)
+						{
+							continue;
+						}
+
+						glm::vec3 EdgeA = V[(c + 1) % 3]->Pos - V[c]->Pos;
+						glm::vec3 EdgeB = V[(c + 2) % 3]->Pos - V[c]->Pos;
+						EdgeA -= N * glm::dot(N, EdgeA);
+						EdgeB -= N * glm::dot(N, EdgeB);
+
+						Out = Tangent * (CornerAngle(EdgeA, EdgeB) / Length);
+					}
+				}
+			});
+
+			// Welded vertices get the tangents of every triangle that shares them
+			std::vector<UINT32> Offsets;
+			std::vector<UINT32> Corners;
+			GroupCorners(indices, NumTris * 3, numVerts, Offsets, Corners);
+
+			JobSystem::ParallelFor(numVerts, VertexGrain, [&](UINT32 t_Begin, UINT32 t_End)
+			{
+				for (UINT32 v = t_Begin; v < t_End; ++v)
+				{
+					glm::vec3 Sum(0.0f);
+					for (UINT32 i = Offsets[v]; i < Offsets[v + 1]; ++i)
+					{
+						Sum += CornerTangents[Corners[i]];
+					}
+
+					// Vertices without any UV area around them get any tangent that is orthogonal to the normal
+					const float Length = glm::length(Sum);
+					verts[v].Tangent = Length > 0.0f ? Sum / Length : GetPerpendicular(verts[v].Normal);
+				}
+			});
+		}
+
+		BoundingBox CalculateBounds(const std::vector<Vertex>& t_Verts)
+		{
+			BoundingBox Bounds = {};
+			for (const Vertex& Vert : t_Verts)
+			{
+				Bounds.Expand(Vert.Pos);
+			}
+			return Bounds;
+		}
+
+		bool Import(const std::string& t_FilePath, std::vector<Vertex>& t_OutVerts, std::vector<UINT32>& t_OutIndices, MeshOptimizeStats* t_OutStats, NormalMode t_Normals)
+		{
+			if (!LoadObj(t_FilePath, t_OutVerts, t_OutIndices))
+			{
+				return false;
+			}
+
+			// Without the normals of the file the hard edges weld together and get smoothed
+			if (t_Normals == NormalMode::Smooth)
+			{
+				for (Vertex& Vert : t_OutVerts)
+				{
+					Vert.Normal = glm::vec3(0.0f);
+				}
+			}
+
+			// Welded vertices share the normals and tangents of every triangle around them
+			MeshOptimizer::Optimize(t_OutVerts, t_OutIndices, t_OutStats);
+			CalculateSmoothNormals(t_OutVerts.data(), static_cast<UINT32>(t_OutVerts.size()), t_OutIndices.data(), static_cast<UINT32>(t_OutIndices.size()));
+			CalculateVertexTangents(t_OutVerts.data(), static_cast<UINT32>(t_OutVerts.size()), t_OutIndices.data(), static_cast<UINT32>(t_OutIndices.size()));
+
+			return true;
+		}
+
+		bool Cook(const std::string& t_SourcePath, const std::string& t_CookedPath, NormalMode t_Normals)
+		{
+			std::vector<Vertex> Verts;
+			std::vector<UINT32> Indices;
+			MeshOptimizeStats Stats = {};
+			if (!Import(t_SourcePath, Verts, Indices, &Stats, t_Normals))
+			{
+				return false;
+			}
+
+			// Meshes without vertex colors are quantized, which makes each vertex less than half the size
+			const VertexFormat Format = VertexQuantization::CanPack(Verts) ? VertexFormat::Packed : VertexFormat::Full;
+
+			// Simplified levels go after the full mesh in the same index buffer
+			std::vector<MeshLod> Lods;
+			MeshSimplifier::GenerateLods(Verts, Indices, Lods);
+
+			F_LOG_TRACE("{}: {} -> {} vertices, ACMR {:.3f} -> {:.3f}, {} bytes per vertex, {} levels of detail", t_SourcePath, Stats.SourceVertexCount, Stats.VertexCount, Stats.ACMRBefore, Stats.ACMRAfter, GetVertexStride(Format), Lods.size());
+
+			if (!MeshFile::Write(t_CookedPath, Verts, Indices, CalculateBounds(Verts), Format, Lods))
+			{
+				F_LOG_ERROR("Failed to write cooked mesh {}", t_CookedPath);
+				return false;
+			}
+			return true;
+		}
+	}   // namespace MeshImporter
+}   // namespace Fling
@@ -0,0 +1,250 @@
+#include "pch.h"
+#include "MeshOptimizer.h"
+
+namespace Fling
+{
+	namespace MeshOptimizer
+	{
+		UINT32 WeldVertices(std::vector<Vertex>& t_Verts, std::vector<UINT32>& t_Indices)
+		{
+			static constexpr UINT32 Empty = UINT32_MAX;
+
+			// Open addressing table of unique vertex indices, kept at most half full
+			size_t TableSize = 1;
+			while (TableSize < t_Verts.size() * 2)
+			{
+				TableSize <<= 1;
+			}
+			const size_t Mask = TableSize - 1;
+			std::vector<UINT32> Table(TableSize, Empty);
+
+			std::hash<Vertex> Hasher;
+			std::vector<UINT32> Remap(t_Verts.size());
+			UINT32 UniqueCount = 0;
+
+			for (size_t i = 0; i < t_Verts.size(); ++i)
+			{
+				const Vertex& Vert = t_Verts[i];
+				size_t Slot = Hasher(Vert) & Mask;
+				while (Table[Slot] != Empty && !(t_Verts[Table[Slot]] == Vert))
+				{
+					Slot = (Slot + 1) & Mask;
+				}
+
+				if (Table[Slot] == Empty)
+				{
+					// Unique vertices are compacted to the front as we go, so the table can point into the same array
+					t_Verts[UniqueCount] = Vert;
+					Table[Slot] = UniqueCount++;
+				}
+				Remap[i] = Table[Slot];
+			}
+
+			t_Verts.resize(UniqueCount);
+			for (UINT32& Index : t_Indices)
+			{
+				Index = Remap[Index];
+			}
+
+			return UniqueCount;
+		}
+
+		void OptimizeVertexCache(UINT32* t_Indices, UINT32 t_IndexCount, UINT32 t_VertexCount, UINT32 t_CacheSize)
+		{
+			const UINT32 TriCount = t_IndexCount / 3;
+			if (TriCount == 0 || t_VertexCount == 0)
+			{
+				return;
+			}
+
+			// Triangles that use each vertex, in a compact adjacency array
+			std::vector<UINT32> AdjacencyOffsets(t_VertexCount + 1, 0);
+			for (UINT32 i = 0; i < TriCount * 3; ++i)
+			{
+				++AdjacencyOffsets[t_Indices[i] + 1];
+			}
+			for (UINT32 v = 0; v < t_VertexCount; ++v)
+			{
+				AdjacencyOffsets[v + 1] += AdjacencyOffsets[v];
+			}
+
+			std::vector<UINT32> Adjacency(TriCount * 3);
+			std::vector<UINT32> Fill(AdjacencyOffsets.begin(), AdjacencyOffsets.end() - 1);
+			for (UINT32 t = 0; t < TriCount; ++t)
+			{
+				for (UINT32 c = 0; c < 3; ++c)
+				{
+					const UINT32 V = t_Indices[t * 3 + c];
+					Adjacency[Fill[V]++] = t;
+				}
+			}
+
+			// Number of triangles that still have to be emitted for each vertex
+			std::vector<UINT32> LiveTriangles(t_VertexCount);
+			for (UINT32 v = 0; v < t_VertexCount; ++v)
+			{
+				LiveTriangles[v] = AdjacencyOffsets[v + 1] - AdjacencyOffsets[v];
+			}
+
+			std::vector<UINT32> CacheTime(t_VertexCount, 0);
+			std::vector<bool> Emitted(TriCount, false);
+			std::vector<UINT32> DeadEnds;
+			std::vector<UINT32> Candidates;
+			std::vector<UINT32> Output;
+			Output.reserve(TriCount * 3);
+
+			UINT32 TimeStamp = t_CacheSize + 1;
+			UINT32 Cursor = 0;
+			INT64 Fanning = 0;
+
+			while (Fanning >= 0)
+			{
+				const UINT32 F = static_cast<UINT32>(Fanning);
+				Candidates.clear();
+
+				// Emit every triangle around the fanning vertex
+				for (UINT32 a = AdjacencyOffsets[F]; a < AdjacencyOffsets[F + 1]; ++a)
+				{
+					const UINT32 Tri = Adjacency[a];
+					if (Emitted[Tri])
+					{
+						continue;
+					}
+
+					for (UINT32 c = 0; c < 3; ++c)
+					{
+						const UINT32 V = t_Indices[Tri * 3 + c];
+						Output.push_back(V);
+						DeadEnds.push_back(V);
+						Candidates.push_back(V);
+						--LiveTriangles[V];
+
+						// Not in the cache anymore, so this is a miss that puts it back in
+						if (TimeStamp - CacheTime[V] > t_CacheSize)
+						{
+							CacheTime[V] = TimeStamp++;
+						}
+					}
+					Emitted[Tri] = true;
+				}
+
+				// Pick the candidate that will still be in the cache once its remaining triangles are emitted, oldest first
+				Fanning = -1;
+				UINT32 BestPriority = 0;
+				for (UINT32 V : Candidates)
+				{
+					if (LiveTriangles[V] == 0)
+					{
+						continue;
+					}
+
+					UINT32 Priority = 0;
+					if (TimeStamp - CacheTime[V] + 2 * LiveTriangles[V] <= t_CacheSize)
+					{
+						Priority = TimeStamp - CacheTime[V];
+					}
+
+					if (Fanning < 0 || Priority > BestPriority)
+					{
+						BestPriority = Priority;
+						Fanning = V;
+					}
+				}
+
+				if (Fanning >= 0)
+				{
+					continue;
+				}
+
+				// Dead end, try the recently used vertices and then walk through the rest in order
+				while (!DeadEnds.empty() && Fanning < 0)
+				{
+					const UINT32 V = DeadEnds.back();
+					DeadEnds.pop_back();
+					if (LiveTriangles[V] > 0)
+					{
+						Fanning = V;
+					}
+				}
+
+				while (Fanning < 0 && Cursor < t_VertexCount)
+				{
+					if (LiveTriangles[Cursor] > 0)
+					{
+						Fanning = Cursor;
+					}
+					++Cursor;
+				}
+			}
+
+			std::copy(Output.begin(), Output.end(), t_Indices);
+		}
+
+		UINT32 OptimizeVertexFetch(std::vector<Vertex>& t_Verts, std::vector<UINT32>& t_Indices)
+		{
+			static constexpr UINT32 Unused = UINT32_MAX;
+
+			std::vector<UINT32> Remap(t_Verts.size(), Unused);
+			std::vector<Vertex> Reordered;
+			Reordered.reserve(t_Verts.size());
+
+			for (UINT32& Index : t_Indices)
+			{
+				if (Remap[Index] == Unused)
+				{
+					Remap[Index] = static_cast<UINT32>(Reordered.size());
+					Reordered.push_back(t_Verts[Index]);
+				}
+				Index = Remap[Index];
+			}
+
+			t_Verts.swap(Reordered);
+			return static_cast<UINT32>(t_Verts.size());
+		}
+
+		float CalculateACMR(const UINT32* t_Indices, UINT32 t_IndexCount, UINT32 t_VertexCount, UINT32 t_CacheSize)
+		{
+			const UINT32 TriCount = t_IndexCount / 3;
+			if (TriCount == 0)
+			{
+				return 0.0f;
+			}
+
+			// A vertex is in the FIFO if it was put in less than t_CacheSize misses ago
+			std::vector<UINT32> CacheTime(t_VertexCount, 0);
+			UINT32 Misses = 0;
+			for (UINT32 i = 0; i < TriCount * 3; ++i)
+			{
+				const UINT32 V = t_Indices[i];
+				if (CacheTime[V] == 0 || Misses - CacheTime[V] >= t_CacheSize)
+				{
+					++Misses;
+					CacheTime[V] = Misses;
+				}
+			}
+
+			return static_cast<float>(Misses) / static_cast<float>(TriCount);
+		}
+
+		void Optimize(std::vector<Vertex>& t_Verts, std::vector<UINT32>& t_Indices, MeshOptimizeStats* t_OutStats)
+		{
+			const UINT32 SourceVertexCount = static_cast<UINT32>(t_Verts.size());
+			const UINT32 IndexCount = static_cast<UINT32>(t_Indices.size());
+
+			UINT32 VertexCount = WeldVertices(t_Verts, t_Indices);
+			const float ACMRBefore = CalculateACMR(t_Indices.data(), IndexCount, VertexCount);
+
+			OptimizeVertexCache(t_Indices.data(), IndexCount, VertexCount);
+			VertexCount = OptimizeVertexFetch(t_Verts, t_Indices);
+
+			if (t_OutStats)
+			{
+				t_OutStats->SourceVertexCount = SourceVertexCount;
+				t_OutStats->VertexCount = VertexCount;
+				t_OutStats->IndexCount = IndexCount;
+				t_OutStats->ACMRBefore = ACMRBefore;
+				t_OutStats->ACMRAfter = CalculateACMR(t_Indices.data(), IndexCount, VertexCount);
+			}
+		}
+	}   // namespace MeshOptimizer
+}   // namespace Fling
@@ -34,11 +34,8 @@ namespace Fling
 
 	void MeshRenderer::Release()
 	{
-		if (m_UniformBuffer)
-		{
-			delete m_UniformBuffer;
-			m_UniformBuffer = nullptr;
-		}
+		// The descriptor set belongs to the subpass, so just forget about it
+		m_DescriptorSet = VK_NULL_HANDLE;
 	}
 
 	bool MeshRenderer::operator==(const MeshRenderer& other) const
@@ -53,8 +50,8 @@ namespace Fling
 
 	void MeshRenderer::LoadModelFromPath(const std::string t_MeshPath)
 	{
-		// Load the model
-		m_Model = Model::Create(entt::hashed_string{ t_MeshPath.c_str() }).get();
+		// Load the model in the background, subpasses will skip it until it is ready
+		m_Model = Model::CreateAsync(entt::hashed_string{ t_MeshPath.c_str() }).get();
 		assert(m_Model);
 	}
 
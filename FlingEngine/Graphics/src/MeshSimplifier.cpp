@@ -0,0 +1,478 @@
+#include "pch.h"
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+#include <numeric>
+
+namespace Fling
+{
+	namespace MeshSimplifier
+	{
+		namespace
+		{
+			/** Levels that keep more than this much of the level before them are dropped */
+			constexpr float MinLodReduction = 0.8f;
+
+			/** Collapses that turn a triangle further than this (cosine of the angle between the normals) are rejected */
+			constexpr float MinNormalDot = 0.1f;
+
+			/**
+			 * Sum of squared distances to a set of planes, weighted by the area of the triangle that each
+			 * plane came from. Kept in doubles because the terms cancel out close to the surface
+			 */
+			struct Quadric
+			{
+				double A00 = 0.0, A01 = 0.0, A02 = 0.0, A11 = 0.0, A12 = 0.0, A22 = 0.0;
+				double B0 = 0.0, B1 = 0.0, B2 = 0.0;
+				double C = 0.0;
+				double Weight = 0.0;
+
+				void AddPlane(const glm::vec3& t_Normal, float t_Distance, float t_Weight)
+				{
+					const double X = t_Normal.x, Y = t_Normal.y, Z = t_Normal.z, D = t_Distance, W = t_Weight;
+					A00 += W * X * X; A01 += W * X * Y; A02 += W * X * Z;
+					A11 += W * Y * Y; A12 += W * Y * Z;
+					A22 += W * Z * Z;
+					B0 += W * X * D; B1 += W * Y * D; B2 += W * Z * D;
+					C += W * D * D;
+					Weight += W;
+				}
+
+				void Add(const Quadric& t_Other)
+				{
+					A00 += t_Other.A00; A01 += t_Other.A01; A02 += t_Other.A02;
+					A11 += t_Other.A11; A12 += t_Other.A12;
+					A22 += t_Other.A22;
+					B0 += t_Other.B0; B1 += t_Other.B1; B2 += t_Other.B2;
+					C += t_Other.C;
+					Weight += t_Other.Weight;
+				}
+
+				/** Weighted squared distance of a point to the planes */
+				double Evaluate(const glm::vec3& t_Pos) const
+				{
+					const double X = t_Pos.x, Y = t_Pos.y, Z = t_Pos.z;
+					const double Result =
+						A00 * X * X + 2.0 * A01 * X * Y + 2.0 * A02 * X * Z +
+						A11 * Y * Y + 2.0 * A12 * Y * Z +
+						A22 * Z * Z +
+						2.0 * (B0 * X + B1 * Y + B2 * Z) + C;
+					return std::max(Result, 0.0);
+				}
+			};
+
+			/** Squared distance that moving a vertex onto another one adds, averaged over the area of both */
+			float GetCollapseCost(const Quadric& t_From, const Quadric& t_To, const glm::vec3& t_Pos)
+			{
+				const double Weight = t_From.Weight + t_To.Weight;
+				if (Weight <= 0.0)
+				{
+					return 0.0f;
+				}
+				return static_cast<float>((t_From.Evaluate(t_Pos) + t_To.Evaluate(t_Pos)) / Weight);
+			}
+
+			struct Collapse
+			{
+				UINT32 From;
+				UINT32 To;
+				float Cost;
+			};
+
+			UINT64 GetEdgeKey(UINT32 t_A, UINT32 t_B)
+			{
+				return t_A < t_B ? (static_cast<UINT64>(t_A) << 32) | t_B : (static_cast<UINT64>(t_B) << 32) | t_A;
+			}
+
+			/**
+			 * @brief	Vertices that share a position with another vertex are on a seam, and edges that only have
+			 *			one triangle are on a border. Moving either of those would open a crack in the mesh
+			 */
+			void FindLockedVertices(const Vertex* t_Verts, UINT32 t_NumVerts, const UINT32* t_Indices, UINT32 t_NumIndices, std::vector<bool>& t_OutLocked)
+			{
+				std::unordered_map<glm::vec3, UINT32> PositionLookup;
+				std::vector<UINT32> PositionOfVertex(t_NumVerts);
+				std::vector<UINT32> VertsAtPosition;
+				for (UINT32 v = 0; v < t_NumVerts; ++v)
+				{
+					auto Inserted = PositionLookup.emplace(t_Verts[v].Pos, static_cast<UINT32>(VertsAtPosition.size()));
+					if (Inserted.second)
+					{
+						VertsAtPosition.emplace_back(0);
+					}
+					PositionOfVertex[v] = Inserted.first->second;
+					++VertsAtPosition[Inserted.first->second];
+				}
+
+				// Count the triangles on every edge by position, so that the two sides of a seam count as one edge
+				std::unordered_map<UINT64, UINT32> EdgeTriangles;
+				for (UINT32 i = 0; i + 2 < t_NumIndices; i += 3)
+				{
+					for (UINT32 c = 0; c < 3; ++c)
+					{
+						++EdgeTriangles[GetEdgeKey(PositionOfVertex[t_Indices[i + c]], PositionOfVertex[t_Indices[i + (c + 1) % 3]])];
+					}
+				}
+
+				std::vector<bool> PositionLocked(VertsAtPosition.size(), false);
+				for (const auto& Edge : EdgeTriangles)
+				{
+					if (Edge.second != 2)
+					{
+						PositionLocked[static_cast<UINT32>(Edge.first >> 32)] = true;
+						PositionLocked[static_cast<UINT32>(Edge.first & 0xFFFFFFFF)] = true;
+					}
+				}
+
+				t_OutLocked.resize(t_NumVerts);
+				for (UINT32 v = 0; v < t_NumVerts; ++v)
+				{
+					const UINT32 Pos = PositionOfVertex[v];
+					t_OutLocked[v] = PositionLocked[Pos] || VertsAtPosition[Pos] > 1;
+				}
+			}
+
+			/** Distance from a point to the closest point on a triangle */
+			float GetDistanceToTriangle(const glm::vec3& t_Point, const glm::vec3& t_A, const glm::vec3& t_B, const glm::vec3& t_C)
+			{
+				auto DistanceToEdge = [&t_Point](const glm::vec3& t_From, const glm::vec3& t_To)
+				{
+					const glm::vec3 Edge = t_To - t_From;
+					const float LengthSq = glm::dot(Edge, Edge);
+					const float T = LengthSq > 0.0f ? glm::clamp(glm::dot(t_Point - t_From, Edge) / LengthSq, 0.0f, 1.0f) : 0.0f;
+					return glm::length(t_Point - (t_From + Edge * T));
+				};
+
+				const glm::vec3 Cross = glm::cross(t_B - t_A, t_C - t_A);
+				const float Length = glm::length(Cross);
+				if (Length > 0.0f)
+				{
+					// Inside of every edge means the closest point is on the face
+					const glm::vec3 Normal = Cross / Length;
+					const float PlaneDistance = glm::dot(t_Point - t_A, Normal);
+					const glm::vec3 Projected = t_Point - Normal * PlaneDistance;
+					if (glm::dot(glm::cross(t_B - t_A, Projected - t_A), Normal) >= 0.0f &&
+						glm::dot(glm::cross(t_C - t_B, Projected - t_B), Normal) >= 0.0f &&
+						glm::dot(glm::cross(t_A - t_C, Projected - t_C), Normal) >= 0.0f)
+					{
+						return std::abs(PlaneDistance);
+					}
+				}
+
+				return std::min(DistanceToEdge(t_A, t_B), std::min(DistanceToEdge(t_B, t_C), DistanceToEdge(t_C, t_A)));
+			}
+
+			/** Triangles around each vertex as a compact adjacency array */
+			void BuildAdjacency(const std::vector<UINT32>& t_Indices, UINT32 t_NumVerts, std::vector<UINT32>& t_OutOffsets, std::vector<UINT32>& t_OutTriangles)
+			{
+				t_OutOffsets.assign(t_NumVerts + 1, 0);
+				for (UINT32 Index : t_Indices)
+				{
+					++t_OutOffsets[Index + 1];
+				}
+				for (UINT32 v = 0; v < t_NumVerts; ++v)
+				{
+					t_OutOffsets[v + 1] += t_OutOffsets[v];
+				}
+
+				t_OutTriangles.resize(t_Indices.size());
+				std::vector<UINT32> Fill(t_OutOffsets.begin(), t_OutOffsets.end() - 1);
+				for (UINT32 i = 0; i < static_cast<UINT32>(t_Indices.size()); ++i)
+				{
+					t_OutTriangles[Fill[t_Indices[i]]++] = i / 3;
+				}
+			}
+		}
+
+		float Simplify(
+			const Vertex* t_Verts,
+			UINT32 t_NumVerts,
+			const UINT32* t_Indices,
+			UINT32 t_NumIndices,
+			UINT32 t_TargetIndexCount,
+			float t_MaxError,
+			std::vector<UINT32>& t_OutIndices)
+		{
+			t_OutIndices.assign(t_Indices, t_Indices + (t_NumIndices / 3) * 3);
+			if (t_OutIndices.size() <= t_TargetIndexCount)
+			{
+				return 0.0f;
+			}
+
+			std::vector<bool> Locked;
+			FindLockedVertices(t_Verts, t_NumVerts, t_OutIndices.data(), static_cast<UINT32>(t_OutIndices.size()), Locked);
+
+			// Every vertex starts with the planes of the triangles around it
+			std::vector<Quadric> Quadrics(t_NumVerts);
+			for (size_t i = 0; i < t_OutIndices.size(); i += 3)
+			{
+				const glm::vec3& P0 = t_Verts[t_OutIndices[i + 0]].Pos;
+				const glm::vec3 Cross = glm::cross(t_Verts[t_OutIndices[i + 1]].Pos - P0, t_Verts[t_OutIndices[i + 2]].Pos - P0);
+				const float Length = glm::length(Cross);
+				if (Length <= 0.0f)
+				{
+					continue;
+				}
+
+				const glm::vec3 Normal = Cross / Length;
+				for (UINT32 c = 0; c < 3; ++c)
+				{
+					Quadrics[t_OutIndices[i + c]].AddPlane(Normal, -glm::dot(Normal, P0), Length * 0.5f);
+				}
+			}
+
+			const float MaxCost = t_MaxError * t_MaxError;
+
+			// The vertex that each vertex was collapsed onto
+			std::vector<UINT32> CollapsedTo(t_NumVerts);
+			std::iota(CollapsedTo.begin(), CollapsedTo.end(), 0);
+
+			std::vector<UINT32> AdjacencyOffsets;
+			std::vector<UINT32> Adjacency;
+			std::vector<Collapse> Collapses;
+			std::vector<bool> Touched;
+			std::vector<UINT32> Neighbours;
+
+			// Every pass collapses edges that don't touch each other, cheapest first, until enough triangles are gone
+			while (t_OutIndices.size() > t_TargetIndexCount)
+			{
+				BuildAdjacency(t_OutIndices, t_NumVerts, AdjacencyOffsets, Adjacency);
+
+				// The cheapest edge out of every vertex that can move
+				Collapses.clear();
+				for (UINT32 v = 0; v < t_NumVerts; ++v)
+				{
+					if (Locked[v] || AdjacencyOffsets[v] == AdjacencyOffsets[v + 1])
+					{
+						continue;
+					}
+
+					Collapse Best = { v, v, FLT_MAX };
+					for (UINT32 a = AdjacencyOffsets[v]; a < AdjacencyOffsets[v + 1]; ++a)
+					{
+						const UINT32* Tri = t_OutIndices.data() + Adjacency[a] * 3;
+						for (UINT32 c = 0; c < 3; ++c)
+						{
+							if (Tri[c] == v)
+							{
+								continue;
+							}
+
+							const float Cost = GetCollapseCost(Quadrics[v], Quadrics[Tri[c]], t_Verts[Tri[c]].Pos);
+							if (Cost < Best.Cost)
+							{
+								Best = { v, Tri[c], Cost };
+							}
+						}
+					}
+
+					if (Best.To != v && Best.Cost <= MaxCost)
+					{
+						Collapses.emplace_back(Best);
+					}
+				}
+
+				if (Collapses.empty())
+				{
+					break;
+				}
+
+				std::sort(Collapses.begin(), Collapses.end(), [](const Collapse& t_A, const Collapse& t_B)
+				{
+					return t_A.Cost < t_B.Cost || (t_A.Cost == t_B.Cost && t_A.From < t_B.From);
+				});
+
+				// Each collapse of an interior vertex removes two triangles
+				const size_t TrianglesToRemove = (t_OutIndices.size() - t_TargetIndexCount + 2) / 3;
+				size_t RemovedTriangles = 0;
+				Touched.assign(t_NumVerts, false);
+
+				for (const Collapse& Col : Collapses)
+				{
+					if (RemovedTriangles >= TrianglesToRemove)
+					{
+						break;
+					}
+					if (Touched[Col.From] || Touched[Col.To])
+					{
+						continue;
+					}
+
+					// The vertices around both ends may only share the two that are across the edge, otherwise
+					// the collapse would fold the mesh onto itself
+					Neighbours.clear();
+					UINT32 SharedTriangles = 0;
+					for (UINT32 a = AdjacencyOffsets[Col.From]; a < AdjacencyOffsets[Col.From + 1]; ++a)
+					{
+						const UINT32* Tri = t_OutIndices.data() + Adjacency[a] * 3;
+						SharedTriangles += (Tri[0] == Col.To || Tri[1] == Col.To || Tri[2] == Col.To) ? 1 : 0;
+						for (UINT32 c = 0; c < 3; ++c)
+						{
+							if (Tri[c] != Col.From && Tri[c] != Col.To)
+							{
+								Neighbours.emplace_back(Tri[c]);
+							}
+						}
+					}
+					std::sort(Neighbours.begin(), Neighbours.end());
+					Neighbours.erase(std::unique(Neighbours.begin(), Neighbours.end()), Neighbours.end());
+
+					UINT32 SharedNeighbours = 0;
+					for (UINT32 a = AdjacencyOffsets[Col.To]; a < AdjacencyOffsets[Col.To + 1]; ++a)
+					{
+						const UINT32* Tri = t_OutIndices.data() + Adjacency[a] * 3;
+						for (UINT32 c = 0; c < 3; ++c)
+						{
+							if (Tri[c] != Col.To && std::binary_search(Neighbours.begin(), Neighbours.end(), Tri[c]))
+							{
+								++SharedNeighbours;
+							}
+						}
+					}
+
+					// Each neighbour across the edge is found twice, once in each triangle around To that has it
+					if (SharedTriangles != 2 || SharedNeighbours > 2 * SharedTriangles)
+					{
+						continue;
+					}
+
+					// Triangles that move may not flip over or become slivers
+					bool Flips = false;
+					for (UINT32 a = AdjacencyOffsets[Col.From]; a < AdjacencyOffsets[Col.From + 1] && !Flips; ++a)
+					{
+						const UINT32* Tri = t_OutIndices.data() + Adjacency[a] * 3;
+						if (Tri[0] == Col.To || Tri[1] == Col.To || Tri[2] == Col.To)
+						{
+							continue;
+						}
+
+						glm::vec3 Before[3];
+						glm::vec3 After[3];
+						for (UINT32 c = 0; c < 3; ++c)
+						{
+							Before[c] = t_Verts[Tri[c]].Pos;
+							After[c] = t_Verts[Tri[c] == Col.From ? Col.To : Tri[c]].Pos;
+						}
+
+						const glm::vec3 NormalBefore = glm::cross(Before[1] - Before[0], Before[2] - Before[0]);
+						const glm::vec3 NormalAfter = glm::cross(After[1] - After[0], After[2] - After[0]);
+						Flips = glm::dot(NormalBefore, NormalAfter) <= MinNormalDot * glm::length(NormalBefore) * glm::length(NormalAfter);
+					}
+					if (Flips)
+					{
+						continue;
+					}
+
+					// Nothing around the moved triangles can collapse again this pass, their adjacency is out of date
+					Touched[Col.From] = true;
+					Touched[Col.To] = true;
+					for (UINT32 Neighbour : Neighbours)
+					{
+						Touched[Neighbour] = true;
+					}
+
+					for (UINT32 a = AdjacencyOffsets[Col.From]; a < AdjacencyOffsets[Col.From + 1]; ++a)
+					{
+						UINT32* Tri = t_OutIndices.data() + Adjacency[a] * 3;
+						for (UINT32 c = 0; c < 3; ++c)
+						{
+							if (Tri[c] == Col.From)
+							{
+								Tri[c] = Col.To;
+							}
+						}
+					}
+
+					Quadrics[Col.To].Add(Quadrics[Col.From]);
+					CollapsedTo[Col.From] = Col.To;
+					RemovedTriangles += SharedTriangles;
+				}
+
+				if (RemovedTriangles == 0)
+				{
+					break;
+				}
+
+				// Drop the triangles that collapsed down to a line
+				size_t Write = 0;
+				for (size_t i = 0; i < t_OutIndices.size(); i += 3)
+				{
+					const UINT32 A = t_OutIndices[i], B = t_OutIndices[i + 1], C = t_OutIndices[i + 2];
+					if (A != B && B != C && A != C)
+					{
+						t_OutIndices[Write++] = A;
+						t_OutIndices[Write++] = B;
+						t_OutIndices[Write++] = C;
+					}
+				}
+				t_OutIndices.resize(Write);
+			}
+
+			// The quadrics only estimate the error, so measure how far every vertex of the source mesh is from
+			// the triangles around where it ended up. The closest triangle could be further away than that, so
+			// this is an upper bound on the distance to the simplified mesh
+			BuildAdjacency(t_OutIndices, t_NumVerts, AdjacencyOffsets, Adjacency);
+			float Error = 0.0f;
+			for (UINT32 v = 0; v < t_NumVerts; ++v)
+			{
+				UINT32 Target = v;
+				while (CollapsedTo[Target] != Target)
+				{
+					Target = CollapsedTo[Target];
+				}
+				if (Target == v)
+				{
+					continue;
+				}
+				CollapsedTo[v] = Target;
+
+				float Distance = FLT_MAX;
+				for (UINT32 a = AdjacencyOffsets[Target]; a < AdjacencyOffsets[Target + 1]; ++a)
+				{
+					const UINT32* Tri = t_OutIndices.data() + Adjacency[a] * 3;
+					Distance = std::min(Distance, GetDistanceToTriangle(t_Verts[v].Pos, t_Verts[Tri[0]].Pos, t_Verts[Tri[1]].Pos, t_Verts[Tri[2]].Pos));
+				}
+				if (Distance != FLT_MAX)
+				{
+					Error = std::max(Error, Distance);
+				}
+			}
+
+			return Error;
+		}
+
+		UINT32 GenerateLods(const std::vector<Vertex>& t_Verts, std::vector<UINT32>& t_Indices, std::vector<MeshLod>& t_OutLods, UINT32 t_MaxLods)
+		{
+			const UINT32 IndexCount = static_cast<UINT32>(t_Indices.size());
+			const UINT32 VertexCount = static_cast<UINT32>(t_Verts.size());
+
+			t_OutLods.clear();
+			t_OutLods.push_back({ 0, IndexCount, 0.0f });
+
+			// Every level is simplified from the full mesh so that the errors don't build up
+			const std::vector<UINT32> Source(t_Indices.begin(), t_Indices.end());
+			std::vector<UINT32> Simplified;
+			for (UINT32 Level = 1; Level < std::min(t_MaxLods, MaxMeshLods); ++Level)
+			{
+				const MeshLod& Previous = t_OutLods.back();
+				const UINT32 Target = ((IndexCount >> Level) / 3) * 3;
+				const float Error = Simplify(t_Verts.data(), VertexCount, Source.data(), IndexCount, Target, FLT_MAX, Simplified);
+				if (Simplified.empty() || static_cast<float>(Simplified.size()) > static_cast<float>(Previous.IndexCount) * MinLodReduction)
+				{
+					break;
+				}
+
+				MeshOptimizer::OptimizeVertexCache(Simplified.data(), static_cast<UINT32>(Simplified.size()), VertexCount);
+
+				MeshLod Lod = {};
+				Lod.FirstIndex = static_cast<UINT32>(t_Indices.size());
+				Lod.IndexCount = static_cast<UINT32>(Simplified.size());
+				Lod.Error = std::max(Error, Previous.Error);
+				t_Indices.insert(t_Indices.end(), Simplified.begin(), Simplified.end());
+				t_OutLods.push_back(Lod);
+			}
+
+			return static_cast<UINT32>(t_OutLods.size());
+		}
+	}   // namespace MeshSimplifier
+}   // namespace Fling
@@ -1,9 +1,10 @@
 #include "pch.h"
 #include "Model.h"
-
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tiny_obj_loader.h>
+#include "MeshFile.h"
+#include "MeshImporter.h"
+#include "MeshOptimizer.h"
 #include "ResourceManager.h"
+#include "UploadBatch.h"
 
 namespace Fling
 {
@@ -12,6 +13,11 @@ namespace Fling
 		return ResourceManager::LoadResource<Model>(t_ID);
 	}
 
+	std::shared_ptr<Fling::Model> Model::CreateAsync(Guid t_ID)
+	{
+		return ResourceManager::LoadResourceAsync<Model>(t_ID);
+	}
+
 	std::shared_ptr<Fling::Model> Model::Quad()
 	{
 		std::vector<Vertex> Verts;
@@ -76,7 +82,19 @@ namespace Fling
 	Model::Model(Guid t_ID)
 		: Resource(t_ID)
 	{
-		LoadModel();
+		if (LoadFromDisk())
+		{
+			CreateBuffers();
+		}
+		else
+		{
+			m_LoadState = LoadState::Failed;
+		}
+	}
+
+	Model::Model(Guid t_ID, AsyncLoadTag)
+		: Resource(t_ID)
+	{
 	}
 
 	Model::Model(Guid t_ID, std::vector<Vertex>& t_Verts, std::vector<UINT32> t_Indecies)
@@ -84,8 +102,13 @@ namespace Fling
 	{
 		m_Verts = t_Verts;
 		m_Indices = t_Indecies;
+		m_VertexCount = static_cast<UINT32>(m_Verts.size());
+		m_IndexCount = static_cast<UINT32>(m_Indices.size());
+		m_IndexType = MeshOptimizer::CanUse16BitIndices(m_VertexCount) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+		m_Lods = { { 0, m_IndexCount, 0.0f } };
 
-		CalculateVertexTangents(m_Verts.data(), static_cast<UINT32>(m_Verts.size()), m_Indices.data(), static_cast<UINT32>(m_Indices.size()));
+		MeshImporter::CalculateVertexTangents(m_Verts.data(), m_VertexCount, m_Indices.data(), m_IndexCount);
+		CalculateBounds();
 		CreateBuffers();
 	}
 
@@ -96,137 +119,129 @@ namespace Fling
 		delete m_IndexBuffer;
 	}
 
-	void Model::LoadModel()
+	bool Model::LoadFromDisk()
 	{
 		const std::string FilePath = GetFilepathReleativeToAssets();
-		tinyobj::attrib_t attrib;
-		std::vector<tinyobj::shape_t> shapes;
-		std::vector<tinyobj::material_t> materials;
-		std::string warn;
-		std::string err;
-
-		// Load the model from tiny obj
-		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, FilePath.c_str()))
-		{
-			F_LOG_ERROR("Failed to load model: {} {}", warn, err);
-			
-			return;
-		}
+		const std::string CookedPath = MeshFile::GetCookedPath(FilePath);
 
-		// Parse all shapes to get the verts and indecies of this object
-		for (const tinyobj::shape_t& shape : shapes)
+		if (MeshFile::IsUpToDate(FilePath, CookedPath))
 		{
-			for (const tinyobj::index_t& index : shape.mesh.indices) 
+			std::unique_ptr<MeshFile> Cooked = std::make_unique<MeshFile>();
+			if (Cooked->Open(CookedPath))
 			{
-				Vertex vertex = {};
-				vertex.Pos = 
+				m_VertexCount = Cooked->GetVertexCount();
+				m_IndexCount = Cooked->GetIndexCount();
+				m_IndexType = Cooked->GetIndexSize() == sizeof(UINT16) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+				m_VertexFormat = Cooked->GetVertexFormat();
+				m_Bounds = Cooked->GetBounds();
+				m_BoundingSphere = BoundingSphere::FromBox(m_Bounds);
+				m_Lods.resize(Cooked->GetLodCount());
+				for (UINT32 i = 0; i < Cooked->GetLodCount(); ++i)
 				{
-					attrib.vertices[3 * index.vertex_index + 0],
-					attrib.vertices[3 * index.vertex_index + 1],
-					attrib.vertices[3 * index.vertex_index + 2]
-				};
+					m_Lods[i] = Cooked->GetLod(i);
+				}
+				CopyOccluderMesh(*Cooked);
+				m_MeshFile = std::move(Cooked);
 
-				vertex.Normal = 
-				{
-					attrib.normals[3 * index.normal_index + 0],
-					attrib.normals[3 * index.normal_index + 1],
-					attrib.normals[3 * index.normal_index + 2]
-				};
-
-				vertex.TexCoord = 
-				{
-					attrib.texcoords[2 * index.texcoord_index + 0],
-					attrib.texcoords[2 * index.texcoord_index + 1]
-				};
-
-				vertex.Color = { 1.0f, 1.0f, 1.0f };
-
-				m_Verts.push_back(vertex);
-				m_Indices.push_back(m_Indices.size());
+				return m_VertexCount > 0;
 			}
 		}
 
-		// Calculate our tangent vectors for this model
-		CalculateVertexTangents(m_Verts.data(), static_cast<UINT32>(m_Verts.size()), m_Indices.data(), static_cast<UINT32>(m_Indices.size()));
+		// Fall back to the text obj if this model hasn't been cooked
+		if (!MeshImporter::Import(FilePath, m_Verts, m_Indices))
+		{
+			return false;
+		}
+		MeshSimplifier::GenerateLods(m_Verts, m_Indices, m_Lods);
+		m_VertexCount = static_cast<UINT32>(m_Verts.size());
+		m_IndexCount = static_cast<UINT32>(m_Indices.size());
+		m_IndexType = MeshOptimizer::CanUse16BitIndices(m_VertexCount) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+		CalculateBounds();
 
-		CreateBuffers();
+		return true;
 	}
 
 	void Model::CreateBuffers()
 	{
+		UploadBatch Batch;
+		RecordUpload(Batch);
+		Batch.SubmitAndWait();
+	}
+
+	void Model::RecordUpload(UploadBatch& t_Batch)
+	{
+		// Cooked files are already in the layout of the buffers, so copy straight out of the mapping
+		const void* VertData = m_MeshFile ? m_MeshFile->GetVertexData() : m_Verts.data();
+		const void* IndexData = m_MeshFile ? m_MeshFile->GetIndexData() : m_Indices.data();
+
+		// Pack the indices down if they all fit in 16 bits
+		std::vector<UINT16> ShortIndices;
+		if (!m_MeshFile && m_IndexType == VK_INDEX_TYPE_UINT16)
+		{
+			ShortIndices.assign(m_Indices.begin(), m_Indices.end());
+			IndexData = ShortIndices.data();
+		}
+
 		// Create vertex buffer
-		VkDeviceSize VertBufferSize = sizeof(m_Verts[0]) * m_Verts.size();
-		// We use a staging buffer to get to a more optimial memory layout for the GPU
-		Buffer VertexStagingBuffer(VertBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_Verts.data());
+		VkDeviceSize VertBufferSize = static_cast<VkDeviceSize>(GetVertexStride(m_VertexFormat)) * GetVertexCount();
+		// We use staging memory to get to a more optimial memory layout for the GPU
+		StagingAllocation VertexStaging = t_Batch.StageData(VertData, VertBufferSize);
 		m_VertexBuffer = new Buffer(VertBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-		Buffer::CopyBuffer(&VertexStagingBuffer, m_VertexBuffer, VertBufferSize);
+		t_Batch.CopyBuffer(VertexStaging, m_VertexBuffer, VertBufferSize);
 
 		// Create Index buffer
-		VkDeviceSize IndexBufferSize = sizeof(m_Indices[0]) * GetIndexCount();
-		Buffer IndexStagingBuffer(IndexBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_Indices.data());
+		VkDeviceSize IndexBufferSize = (m_IndexType == VK_INDEX_TYPE_UINT16 ? sizeof(UINT16) : sizeof(UINT32)) * GetIndexCount();
+		StagingAllocation IndexStaging = t_Batch.StageData(IndexData, IndexBufferSize);
 		m_IndexBuffer = new Buffer(IndexBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-		Buffer::CopyBuffer(&IndexStagingBuffer, m_IndexBuffer, IndexBufferSize);
+		t_Batch.CopyBuffer(IndexStaging, m_IndexBuffer, IndexBufferSize);
+
+		// The staging memory has its own copy now
+		m_MeshFile.reset();
 	}
 
-	void Model::CalculateVertexTangents(Vertex* verts, UINT32 numVerts, UINT32* indices, UINT32 numIndices)
+	void Model::CalculateBounds()
 	{
-		// Calculate tangents one whole triangle at a time
-		for ( size_t i = 0; i < numVerts;)
+		m_Bounds = MeshImporter::CalculateBounds(m_Verts);
+		m_BoundingSphere = BoundingSphere::FromBox(m_Bounds);
+
+		m_OccluderPositions.resize(m_Verts.size());
+		for (size_t i = 0; i < m_Verts.size(); ++i)
 		{
-			// Grab indices and vertices of first triangle
-			UINT32 i1 = indices [ i++ ];
-			UINT32 i2 = indices [ i++ ];
-			UINT32 i3 = indices [ i++ ];
-			Vertex* v1 = &verts [ i1 ];
-			Vertex* v2 = &verts [ i2 ];
-			Vertex* v3 = &verts [ i3 ];
-
-			// Calculate vectors relative to triangle positions
-			float x1 = v2->Pos.x - v1->Pos.x;
-			float y1 = v2->Pos.y - v1->Pos.y;
-			float z1 = v2->Pos.z - v1->Pos.z;
-
-			float x2 = v3->Pos.x - v1->Pos.x;
-			float y2 = v3->Pos.y - v1->Pos.y;
-			float z2 = v3->Pos.z - v1->Pos.z;
-
-			// Do the same for vectors relative to triangle uv's
-			float s1 = v2->TexCoord.x - v1->TexCoord.x;
-			float t1 = v2->TexCoord.y - v1->TexCoord.y;
-
-			float s2 = v3->TexCoord.x - v1->TexCoord.x;
-			float t2 = v3->TexCoord.y - v1->TexCoord.y;
-
-			// Create vectors for tangent calculation
-			float r = 1.0f / ( s1 * t2 - s2 * t1 );
-
-			float tx = ( t2 * x1 - t1 * x2 ) * r;
-			float ty = ( t2 * y1 - t1 * y2 ) * r;
-			float tz = ( t2 * z1 - t1 * z2 ) * r;
-
-			// Adjust tangents of each vert of the triangle
-			v1->Tangent.x += tx;
-			v1->Tangent.y += ty;
-			v1->Tangent.z += tz;
-
-			v2->Tangent.x += tx;
-			v2->Tangent.y += ty;
-			v2->Tangent.z += tz;
-
-			v3->Tangent.x += tx;
-			v3->Tangent.y += ty;
-			v3->Tangent.z += tz;
+			m_OccluderPositions[i] = m_Verts[i].Pos;
 		}
+	}
 
-		// Ensure all of the tangents are orthogonal to the normals
-		for ( size_t i = 0; i < numVerts; i++ )
+	void Model::CopyOccluderMesh(const MeshFile& t_File)
+	{
+		m_OccluderPositions.resize(t_File.GetVertexCount());
+		if (t_File.GetVertexFormat() == VertexFormat::Packed)
 		{
-			// Tangent = Normal ( T - N * Dot( N, T ) )
-			glm::vec3 norm = verts [ i ].Normal;
-			glm::vec3 tan = verts [ i ].Tangent;
+			const PackedVertex* Packed = static_cast<const PackedVertex*>(t_File.GetVertexData());
+			const VertexDequantize Dequantize = VertexQuantization::GetDequantize(m_Bounds);
+			for (UINT32 i = 0; i < t_File.GetVertexCount(); ++i)
+			{
+				m_OccluderPositions[i] = VertexQuantization::Unpack(Packed[i], Dequantize).Pos;
+			}
+		}
+		else
+		{
+			const Vertex* Verts = t_File.GetVertices();
+			for (UINT32 i = 0; i < t_File.GetVertexCount(); ++i)
+			{
+				m_OccluderPositions[i] = Verts[i].Pos;
+			}
+		}
 
-			tan = glm::normalize( tan - norm * glm::dot( norm, tan ) );
-			verts [ i ].Tangent = tan;
+		m_Indices.resize(t_File.GetIndexCount());
+		if (t_File.GetIndexSize() == sizeof(UINT16))
+		{
+			const UINT16* Indices = static_cast<const UINT16*>(t_File.GetIndexData());
+			std::copy(Indices, Indices + t_File.GetIndexCount(), m_Indices.begin());
+		}
+		else
+		{
+			const UINT32* Indices = static_cast<const UINT32*>(t_File.GetIndexData());
+			std::copy(Indices, Indices + t_File.GetIndexCount(), m_Indices.begin());
 		}
 	}
 }	// namespace Fling
\ No newline at end of file
@@ -0,0 +1,353 @@
+#include "pch.h"
+#include "OcclusionBuffer.h"
+#include "JobSystem.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	include <emmintrin.h>
+#	define FLING_OCCLUSION_SSE 1
+#endif
+
+namespace Fling
+{
+	namespace
+	{
+		/** Pulls boxes a little towards the camera so that rounding can't hide a mesh behind it's own faces */
+		constexpr float BoxDepthBias = 1e-6f;
+	}
+
+	OcclusionBuffer::OcclusionBuffer(UINT32 t_Width, UINT32 t_Height)
+	{
+		m_TilesX = std::max((t_Width + TileWidth - 1) / TileWidth, 1u);
+		m_TilesY = std::max((t_Height + TileHeight - 1) / TileHeight, 1u);
+		m_Width = m_TilesX * TileWidth;
+		m_Height = m_TilesY * TileHeight;
+
+		m_Depth.resize(m_Width * m_Height, 1.0f);
+		m_TileMaxDepth.resize(m_TilesX * m_TilesY, 1.0f);
+		m_TileBins.resize(m_TilesX * m_TilesY);
+	}
+
+	void OcclusionBuffer::SetupTriangles(
+		const glm::mat4& t_WorldViewProj,
+		const glm::vec3* t_Positions,
+		const UINT32* t_Indices,
+		UINT32 t_IndexCount,
+		std::vector<OccluderTriangle>& t_Out) const
+	{
+		for (UINT32 i = 0; i + 2 < t_IndexCount; i += 3)
+		{
+			glm::vec4 Clip[3];
+			UINT32 InFrontCount = 0;
+			for (UINT32 k = 0; k < 3; ++k)
+			{
+				Clip[k] = t_WorldViewProj * glm::vec4(t_Positions[t_Indices[i + k]], 1.0f);
+				InFrontCount += Clip[k].z >= 0.0f ? 1 : 0;
+			}
+
+			if (InFrontCount == 3)
+			{
+				AddTriangle(Clip[0], Clip[1], Clip[2], t_Out);
+			}
+			else if (InFrontCount > 0)
+			{
+				// Clip to the near plane, which is z >= 0 with a 0 to 1 depth range
+				glm::vec4 Poly[4];
+				UINT32 PolyCount = 0;
+				for (UINT32 k = 0; k < 3; ++k)
+				{
+					const glm::vec4& Cur = Clip[k];
+					const glm::vec4& Next = Clip[(k + 1) % 3];
+					if (Cur.z >= 0.0f)
+					{
+						Poly[PolyCount++] = Cur;
+					}
+					if ((Cur.z >= 0.0f) != (Next.z >= 0.0f))
+					{
+						Poly[PolyCount++] = Cur + (Next - Cur) * (Cur.z / (Cur.z - Next.z));
+					}
+				}
+
+				for (UINT32 v = 1; v + 1 < PolyCount; ++v)
+				{
+					AddTriangle(Poly[0], Poly[v], Poly[v + 1], t_Out);
+				}
+			}
+		}
+	}
+
+	void OcclusionBuffer::AddTriangle(const glm::vec4& t_A, const glm::vec4& t_B, const glm::vec4& t_C, std::vector<OccluderTriangle>& t_Out) const
+	{
+		if (t_A.w <= 0.0f || t_B.w <= 0.0f || t_C.w <= 0.0f)
+		{
+			return;
+		}
+
+		// Pixel coordinates with y going down the screen
+		const float HalfWidth = m_Width * 0.5f;
+		const float HalfHeight = m_Height * 0.5f;
+		glm::vec3 V[3];
+		const glm::vec4* Clip[3] = { &t_A, &t_B, &t_C };
+		for (UINT32 k = 0; k < 3; ++k)
+		{
+			const float InvW = 1.0f / Clip[k]->w;
+			V[k] = glm::vec3((Clip[k]->x * InvW + 1.0f) * HalfWidth, (1.0f - Clip[k]->y * InvW) * HalfHeight, Clip[k]->z * InvW);
+		}
+
+		const float Area = (V[1].x - V[0].x) * (V[2].y - V[0].y) - (V[2].x - V[0].x) * (V[1].y - V[0].y);
+		const float MinDepth = std::min(V[0].z, std::min(V[1].z, V[2].z));
+		if (std::abs(Area) < 1e-6f || MinDepth > 1.0f)
+		{
+			return;
+		}
+
+		// Pixels with a center inside of the bounds
+		OccluderTriangle Tri = {};
+		Tri.MinX = std::max(static_cast<INT32>(std::ceil(std::min(V[0].x, std::min(V[1].x, V[2].x)) - 0.5f)), 0);
+		Tri.MinY = std::max(static_cast<INT32>(std::ceil(std::min(V[0].y, std::min(V[1].y, V[2].y)) - 0.5f)), 0);
+		Tri.MaxX = std::min(static_cast<INT32>(std::floor(std::max(V[0].x, std::max(V[1].x, V[2].x)) - 0.5f)) + 1, static_cast<INT32>(m_Width));
+		Tri.MaxY = std::min(static_cast<INT32>(std::floor(std::max(V[0].y, std::max(V[1].y, V[2].y)) - 0.5f)) + 1, static_cast<INT32>(m_Height));
+		if (Tri.MinX >= Tri.MaxX || Tri.MinY >= Tri.MaxY)
+		{
+			return;
+		}
+
+		// Flip the edges of back facing triangles so that the inside is always positive, occluders are double sided
+		const float Sign = Area > 0.0f ? -1.0f : 1.0f;
+		for (UINT32 k = 0; k < 3; ++k)
+		{
+			const glm::vec3& From = V[k];
+			const glm::vec3& To = V[(k + 1) % 3];
+			Tri.EdgeA[k] = (To.y - From.y) * Sign;
+			Tri.EdgeB[k] = (From.x - To.x) * Sign;
+			Tri.EdgeC[k] = -(Tri.EdgeA[k] * From.x + Tri.EdgeB[k] * From.y);
+		}
+
+		const float DepthX1 = V[1].z - V[0].z;
+		const float DepthX2 = V[2].z - V[0].z;
+		Tri.DepthA = (DepthX1 * (V[2].y - V[0].y) - DepthX2 * (V[1].y - V[0].y)) / Area;
+		Tri.DepthB = (DepthX2 * (V[1].x - V[0].x) - DepthX1 * (V[2].x - V[0].x)) / Area;
+		Tri.DepthC = V[0].z - Tri.DepthA * V[0].x - Tri.DepthB * V[0].y;
+		Tri.MinDepth = MinDepth;
+
+		t_Out.emplace_back(Tri);
+	}
+
+	void OcclusionBuffer::Rasterize(const std::vector<OccluderTriangle>* t_Lists, UINT32 t_ListCount)
+	{
+		for (std::vector<const OccluderTriangle*>& Bin : m_TileBins)
+		{
+			Bin.clear();
+		}
+
+		// Bin the triangles so that every tile only looks at the ones that touch it
+		for (UINT32 l = 0; l < t_ListCount; ++l)
+		{
+			for (const OccluderTriangle& Tri : t_Lists[l])
+			{
+				const UINT32 MaxTileX = static_cast<UINT32>(Tri.MaxX - 1) / TileWidth;
+				const UINT32 MaxTileY = static_cast<UINT32>(Tri.MaxY - 1) / TileHeight;
+				for (UINT32 y = static_cast<UINT32>(Tri.MinY) / TileHeight; y <= MaxTileY; ++y)
+				{
+					for (UINT32 x = static_cast<UINT32>(Tri.MinX) / TileWidth; x <= MaxTileX; ++x)
+					{
+						m_TileBins[y * m_TilesX + x].emplace_back(&Tri);
+					}
+				}
+			}
+		}
+
+		// Tiles don't share any pixels, so they can be rasterized at the same time
+		JobSystem::ParallelFor(m_TilesX * m_TilesY, 1, [&](UINT32 t_Begin, UINT32 t_End)
+		{
+			for (UINT32 t = t_Begin; t < t_End; ++t)
+			{
+				RasterizeTile(t);
+			}
+		});
+	}
+
+	void OcclusionBuffer::RasterizeTile(UINT32 t_Tile)
+	{
+		const INT32 TileX = static_cast<INT32>((t_Tile % m_TilesX) * TileWidth);
+		const INT32 TileY = static_cast<INT32>((t_Tile / m_TilesX) * TileHeight);
+
+		for (INT32 y = TileY; y < TileY + static_cast<INT32>(TileHeight); ++y)
+		{
+			std::fill_n(m_Depth.data() + y * m_Width + TileX, TileWidth, 1.0f);
+		}
+
+		for (const OccluderTriangle* Tri : m_TileBins[t_Tile])
+		{
+			// Start on a multiple of 4 so that every step is a full SIMD register inside of the tile
+			const INT32 MinX = std::max(Tri->MinX, TileX) & ~3;
+			const INT32 MaxX = std::min(Tri->MaxX, TileX + static_cast<INT32>(TileWidth));
+			const INT32 MinY = std::max(Tri->MinY, TileY);
+			const INT32 MaxY = std::min(Tri->MaxY, TileY + static_cast<INT32>(TileHeight));
+
+			for (INT32 y = MinY; y < MaxY; ++y)
+			{
+				const float CenterY = static_cast<float>(y) + 0.5f;
+				float* Row = m_Depth.data() + y * m_Width;
+
+#if FLING_OCCLUSION_SSE
+
+				const __m128 Edge0Row = _mm_set1_ps(Tri->EdgeB[0] * CenterY + Tri->EdgeC[0]);
+				const __m128 Edge1Row = _mm_set1_ps(Tri->EdgeB[1] * CenterY + Tri->EdgeC[1]);
+				const __m128 Edge2Row = _mm_set1_ps(Tri->EdgeB[2] * CenterY + Tri->EdgeC[2]);
+				const __m128 DepthRow = _mm_set1_ps(Tri->DepthB * CenterY + Tri->DepthC);
+				const __m128 Edge0A = _mm_set1_ps(Tri->EdgeA[0]);
+				const __m128 Edge1A = _mm_set1_ps(Tri->EdgeA[1]);
+				const __m128 Edge2A = _mm_set1_ps(Tri->EdgeA[2]);
+				const __m128 DepthA = _mm_set1_ps(Tri->DepthA);
+				const __m128 MinDepth = _mm_set1_ps(Tri->MinDepth);
+				const __m128 Zero = _mm_setzero_ps();
+				const __m128 CenterOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+				for (INT32 x = MinX; x < MaxX; x += 4)
+				{
+					const __m128 CenterX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), CenterOffsets);
+
+					__m128 Inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(Edge0A, CenterX), Edge0Row), Zero);
+					Inside = _mm_and_ps(Inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(Edge1A, CenterX), Edge1Row), Zero));
+					Inside = _mm_and_ps(Inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(Edge2A, CenterX), Edge2Row), Zero));
+					if (_mm_movemask_ps(Inside) == 0)
+					{
+						continue;
+					}
+
+					const __m128 Depth = _mm_max_ps(_mm_add_ps(_mm_mul_ps(DepthA, CenterX), DepthRow), MinDepth);
+					const __m128 Old = _mm_loadu_ps(Row + x);
+					_mm_storeu_ps(Row + x, _mm_or_ps(_mm_and_ps(Inside, _mm_min_ps(Old, Depth)), _mm_andnot_ps(Inside, Old)));
+				}
+
+#else
+
+				for (INT32 x = MinX; x < MaxX; ++x)
+				{
+					const float CenterX = static_cast<float>(x) + 0.5f;
+					bool Inside = true;
+					for (UINT32 k = 0; k < 3; ++k)
+					{
+						Inside &= Tri->EdgeA[k] * CenterX + Tri->EdgeB[k] * CenterY + Tri->EdgeC[k] >= 0.0f;
+					}
+
+					if (Inside)
+					{
+						const float Depth = std::max(Tri->DepthA * CenterX + Tri->DepthB * CenterY + Tri->DepthC, Tri->MinDepth);
+						Row[x] = std::min(Row[x], Depth);
+					}
+				}
+
+#endif
+			}
+		}
+
+		float MaxDepth = 0.0f;
+		for (INT32 y = TileY; y < TileY + static_cast<INT32>(TileHeight); ++y)
+		{
+			const float* Row = m_Depth.data() + y * m_Width + TileX;
+			MaxDepth = std::max(MaxDepth, *std::max_element(Row, Row + TileWidth));
+		}
+		m_TileMaxDepth[t_Tile] = MaxDepth;
+	}
+
+	bool OcclusionBuffer::IsVisible(const glm::mat4& t_WorldViewProj, const BoundingBox& t_Box) const
+	{
+		glm::vec2 NdcMin(FLT_MAX);
+		glm::vec2 NdcMax(-FLT_MAX);
+		float MinDepth = FLT_MAX;
+
+		for (UINT32 c = 0; c < 8; ++c)
+		{
+			const glm::vec4 Corner(
+				(c & 1) ? t_Box.Max.x : t_Box.Min.x,
+				(c & 2) ? t_Box.Max.y : t_Box.Min.y,
+				(c & 4) ? t_Box.Max.z : t_Box.Min.z,
+				1.0f);
+
+			const glm::vec4 Clip = t_WorldViewProj * Corner;
+			if (Clip.z < 0.0f || Clip.w <= 0.0f)
+			{
+				// The camera could be inside of the box
+				return true;
+			}
+
+			const glm::vec2 Ndc = glm::vec2(Clip) / Clip.w;
+			NdcMin = glm::min(NdcMin, Ndc);
+			NdcMax = glm::max(NdcMax, Ndc);
+			MinDepth = std::min(MinDepth, Clip.z / Clip.w);
+		}
+
+		// Every pixel that the box touches, rows go down the screen
+		const INT32 MinX = std::max(static_cast<INT32>(std::floor((NdcMin.x + 1.0f) * 0.5f * m_Width)), 0);
+		const INT32 MaxX = std::min(static_cast<INT32>(std::ceil((NdcMax.x + 1.0f) * 0.5f * m_Width)), static_cast<INT32>(m_Width));
+		const INT32 MinY = std::max(static_cast<INT32>(std::floor((1.0f - NdcMax.y) * 0.5f * m_Height)), 0);
+		const INT32 MaxY = std::min(static_cast<INT32>(std::ceil((1.0f - NdcMin.y) * 0.5f * m_Height)), static_cast<INT32>(m_Height));
+		if (MinX >= MaxX || MinY >= MaxY)
+		{
+			// Off the edge of the buffer, so nothing here can be hiding it
+			return true;
+		}
+
+		return IsRectVisible(MinX, MinY, MaxX, MaxY, MinDepth - BoxDepthBias);
+	}
+
+	bool OcclusionBuffer::IsRectVisible(UINT32 t_MinX, UINT32 t_MinY, UINT32 t_MaxX, UINT32 t_MaxY, float t_Depth) const
+	{
+		assert(t_MaxX <= m_Width && t_MaxY <= m_Height);
+		if (t_MinX >= t_MaxX || t_MinY >= t_MaxY)
+		{
+			return false;
+		}
+
+		const UINT32 MaxTileX = (t_MaxX - 1) / TileWidth;
+		const UINT32 MaxTileY = (t_MaxY - 1) / TileHeight;
+		for (UINT32 TileY = t_MinY / TileHeight; TileY <= MaxTileY; ++TileY)
+		{
+			for (UINT32 TileX = t_MinX / TileWidth; TileX <= MaxTileX; ++TileX)
+			{
+				// The whole tile is in front
+				if (GetTileMaxDepth(TileX, TileY) < t_Depth)
+				{
+					continue;
+				}
+
+				const UINT32 MinX = std::max(t_MinX, TileX * TileWidth) & ~3u;
+				const UINT32 MaxX = std::min(t_MaxX, (TileX + 1) * TileWidth);
+				const UINT32 MinY = std::max(t_MinY, TileY * TileHeight);
+				const UINT32 MaxY = std::min(t_MaxY, (TileY + 1) * TileHeight);
+
+				for (UINT32 y = MinY; y < MaxY; ++y)
+				{
+					const float* Row = m_Depth.data() + y * m_Width;
+
+#if FLING_OCCLUSION_SSE
+
+					// Pixels past the edge of the rectangle are still in the tile, testing them is just a little conservative
+					const __m128 Depth = _mm_set1_ps(t_Depth);
+					for (UINT32 x = MinX; x < MaxX; x += 4)
+					{
+						if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(Row + x), Depth)) != 0)
+						{
+							return true;
+						}
+					}
+
+#else
+
+					for (UINT32 x = MinX; x < MaxX; ++x)
+					{
+						if (Row[x] >= t_Depth)
+						{
+							return true;
+						}
+					}
+
+#endif
+				}
+			}
+		}
+
+		return false;
+	}
+}   // namespace Fling
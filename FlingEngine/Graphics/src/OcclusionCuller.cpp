@@ -0,0 +1,138 @@
+#include "pch.h"
+#include "OcclusionCuller.h"
+#include "Camera.h"
+#include "Components/Transform.h"
+#include "MeshRenderer.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cfloat>
+
+namespace Fling
+{
+	OcclusionCuller::OcclusionCuller(UINT32 t_Width, UINT32 t_Height, UINT32 t_MaxOccluders, float t_MinOccluderSize)
+		: m_Buffer(t_Width, t_Height)
+		, m_MaxOccluders(t_MaxOccluders)
+		, m_MinOccluderSize(t_MinOccluderSize)
+	{
+	}
+
+	void OcclusionCuller::Cull(entt::registry& t_Reg, const Camera& t_Camera, const std::vector<entt::entity>& t_Candidates)
+	{
+		Cull(t_Reg, t_Camera.GetProjectionMatrix() * t_Camera.GetViewMatrix(), t_Candidates);
+	}
+
+	void OcclusionCuller::Cull(entt::registry& t_Reg, const glm::mat4& t_ViewProj, const std::vector<entt::entity>& t_Candidates)
+	{
+		m_Occluders.clear();
+		m_OccludedCount = 0;
+
+		if (!m_IsEnabled)
+		{
+			m_Visible = t_Candidates;
+			return;
+		}
+
+		const UINT32 Count = static_cast<UINT32>(t_Candidates.size());
+		m_ScreenSizes.resize(Count);
+		m_IsVisible.resize(Count);
+
+		// The y row of the view projection is the view's up axis scaled by the focal length
+		const float FocalLength = glm::length(glm::vec3(t_ViewProj[0][1], t_ViewProj[1][1], t_ViewProj[2][1]));
+
+		// Find how much of the screen each mesh covers
+		JobSystem::ParallelFor(Count, 256, [&](UINT32 t_Begin, UINT32 t_End)
+		{
+			for (UINT32 i = t_Begin; i < t_End; ++i)
+			{
+				const MeshRenderer& MeshRend = t_Reg.get<MeshRenderer>(t_Candidates[i]);
+				const Model* Model = MeshRend.m_Model;
+				if (!Model || !Model->IsReady() || Model->GetOccluderPositions().empty())
+				{
+					m_ScreenSizes[i] = -1.0f;
+					continue;
+				}
+
+				if (MeshRend.m_IsOccluder)
+				{
+					m_ScreenSizes[i] = FLT_MAX;
+					continue;
+				}
+
+				// Diameter of the bounding sphere over the height of the screen
+				const BoundingSphere Sphere = Model->GetBoundingSphere().Transformed(t_Reg.get<Transform>(t_Candidates[i]).GetWorldMat());
+				const float Depth = (t_ViewProj * glm::vec4(Sphere.Center, 1.0f)).w;
+				m_ScreenSizes[i] = Sphere.Radius * FocalLength / std::max(Depth, Sphere.Radius);
+			}
+		});
+
+		// Flagged occluders come first, then the biggest meshes on screen
+		for (UINT32 i = 0; i < Count; ++i)
+		{
+			if (m_ScreenSizes[i] >= m_MinOccluderSize)
+			{
+				m_Occluders.emplace_back(i);
+			}
+		}
+		std::sort(m_Occluders.begin(), m_Occluders.end(), [&](UINT32 t_A, UINT32 t_B) { return m_ScreenSizes[t_A] > m_ScreenSizes[t_B]; });
+		if (m_Occluders.size() > m_MaxOccluders)
+		{
+			m_Occluders.resize(m_MaxOccluders);
+		}
+
+		const UINT32 OccluderCount = static_cast<UINT32>(m_Occluders.size());
+		if (m_Triangles.size() < OccluderCount)
+		{
+			m_Triangles.resize(OccluderCount);
+		}
+
+		// Occluders are set up in parallel, then the buffer rasterizes it's tiles in parallel
+		JobSystem::ParallelFor(OccluderCount, 1, [&](UINT32 t_Begin, UINT32 t_End)
+		{
+			for (UINT32 o = t_Begin; o < t_End; ++o)
+			{
+				const entt::entity Ent = t_Candidates[m_Occluders[o]];
+				const Model* Model = t_Reg.get<MeshRenderer>(Ent).m_Model;
+				// Simplified levels can bulge out past the real mesh, so only the full mesh is safe to hide things with
+				const MeshLod& Lod = Model->GetLod(0);
+
+				m_Triangles[o].clear();
+				m_Buffer.SetupTriangles(
+					t_ViewProj * t_Reg.get<Transform>(Ent).GetWorldMat(),
+					Model->GetOccluderPositions().data(),
+					Model->GetIndices().data() + Lod.FirstIndex,
+					Lod.IndexCount,
+					m_Triangles[o]);
+			}
+		});
+
+		m_Buffer.Rasterize(m_Triangles.data(), OccluderCount);
+
+		// Test the bounding box of every candidate against the occluders
+		JobSystem::ParallelFor(Count, 64, [&](UINT32 t_Begin, UINT32 t_End)
+		{
+			for (UINT32 i = t_Begin; i < t_End; ++i)
+			{
+				const Model* Model = t_Reg.get<MeshRenderer>(t_Candidates[i]).m_Model;
+				if (OccluderCount == 0 || !Model || !Model->IsReady())
+				{
+					m_IsVisible[i] = 1;
+					continue;
+				}
+
+				const glm::mat4 WorldViewProj = t_ViewProj * t_Reg.get<Transform>(t_Candidates[i]).GetWorldMat();
+				m_IsVisible[i] = m_Buffer.IsVisible(WorldViewProj, Model->GetBounds()) ? 1 : 0;
+			}
+		});
+
+		m_Visible.clear();
+		for (UINT32 i = 0; i < Count; ++i)
+		{
+			if (m_IsVisible[i])
+			{
+				m_Visible.emplace_back(t_Candidates[i]);
+			}
+		}
+		m_OccludedCount = Count - static_cast<UINT32>(m_Visible.size());
+	}
+}   // namespace Fling
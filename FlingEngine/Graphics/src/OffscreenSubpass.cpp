@@ -10,6 +10,16 @@
 #include "UniformBufferObject.h"
 #include "FirstPersonCamera.h"
 #include "FlingVulkan.h"
+#include "OcclusionCuller.h"
+#include "JobSystem.h"
+#include "ResourceManager.h"
+#include "Vertex.h"
+#include "RenderGraph.h"
+#include "GraphicsPipeline.h"
+#include "VertexQuantization.h"
+#include "Texture.h"
+#include "Material.h"
+#include "VulkanApp.h"
 
 #define FRAME_BUF_DIM 2048
 
@@ -20,14 +30,36 @@ namespace Fling
 		const Swapchain* t_Swap,
 		entt::registry& t_reg,
 		FirstPersonCamera* t_Cam,
+		const OcclusionCuller* t_Culler,
 		std::shared_ptr<Fling::Shader> t_Vert,
-		std::shared_ptr<Fling::Shader> t_Frag)
-		: Subpass(t_Dev, t_Swap, t_Vert, t_Frag)
+		std::shared_ptr<Fling::Shader> t_Frag,
+		std::shared_ptr<Fling::Shader> t_PackedVert,
+		UINT32 t_BindlessTextureCount)
+		: Subpass(t_Dev, t_Swap, t_Vert, t_Frag, /* t_DynamicUniformMask */ 1 << 0, t_BindlessTextureCount)
+		, m_PackedVertexShader(t_PackedVert)
 		, m_Camera(t_Cam)
+		, m_Culler(t_Culler)
 	{
-		assert(m_Camera);
-
+		assert(m_Camera && m_Culler && m_PackedVertexShader);
+
+		m_PackedPipeline = std::make_unique<GraphicsPipeline>(
+			std::vector<Shader*> { m_PackedVertexShader.get(), m_FragShader.get() },
+			m_Device->GetVkDevice(),
+			VK_POLYGON_MODE_FILL,
+			GraphicsPipeline::Depth::ReadWrite,
+			VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+			VK_CULL_MODE_BACK_BIT,
+			VK_FRONT_FACE_COUNTER_CLOCKWISE,
+			/* t_DynamicUniformMask */ 1 << 0,
+			t_BindlessTextureCount);
+
+		// The push constant range comes from the shader, it has to hold what we push for packed models
+		assert(m_PackedVertexShader->GetReflection().PushConstantSize >= sizeof(VertexDequantize));
+
+		// Any change to the mesh renderers changes what the G-Buffer command buffers draw
 		t_reg.on_construct<MeshRenderer>().connect<&OffscreenSubpass::OnMeshRendererAdded>(*this);
+		t_reg.on_replace<MeshRenderer>().connect<&OffscreenSubpass::OnMeshRendererReplaced>(*this);
+		t_reg.on_destroy<MeshRenderer>().connect<&OffscreenSubpass::OnMeshRendererDestroyed>(*this);
 
 		// Set the clear values for the G Buffer
 		m_ClearValues.resize(6);
@@ -35,35 +67,56 @@ namespace Fling
 		m_ClearValues[2].color = m_ClearValues[3].color = m_ClearValues[4].color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
 		m_ClearValues[5].depthStencil = { 1.0f, 0 };
 
-		// Build offscreen semaphores -------
-		m_OffscreenSemaphores.resize(VkConfig::MAX_FRAMES_IN_FLIGHT);
-		for (INT32 i = 0; i < VkConfig::MAX_FRAMES_IN_FLIGHT; i++)
-		{
-			m_OffscreenSemaphores[i] = GraphicsHelpers::CreateSemaphore(m_Device->GetVkDevice());
-		}
-
 		GraphicsHelpers::CreateCommandPool(&m_CommandPool, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
 
-		// Build offscreen command buffers
-		m_OffscreenCmdBufs.resize(m_SwapChain->GetImageCount());
+		// Build offscreen command buffers, they are recorded the first time each frame is drawn
+		m_OffscreenCmdBufs.resize(VulkanApp::Get().GetFramesInFlight());
+		m_RecordedVersions.resize(VulkanApp::Get().GetFramesInFlight(), 0);
+		m_WrittenLoadGenerations.resize(VulkanApp::Get().GetFramesInFlight(), 0);
 		for (size_t i = 0; i < m_OffscreenCmdBufs.size(); ++i)
 		{
 			m_OffscreenCmdBufs[i] = new Fling::CommandBuffer(m_Device, m_CommandPool);
 			assert(m_OffscreenCmdBufs[i] != nullptr);
 		}
 
-		// Tell the Vulkan app that the draw command buffers need to WAIT on this offscreen semaphore
+		// Every job system thread could record part of the G-Buffer pass, and each one
+		// needs it's own command pool to do so
+		m_RecordingThreads.resize(JobSystem::Get().GetThreadCount());
+		for (OffscreenRecordingThread& Thread : m_RecordingThreads)
+		{
+			GraphicsHelpers::CreateCommandPool(&Thread.CommandPool, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+			Thread.SecondaryCmdBufs.resize(VulkanApp::Get().GetFramesInFlight());
+		}
+		F_LOG_TRACE("Offscreen pass recording with {} threads", m_RecordingThreads.size());
+
+		// Only the view data is a uniform, every mesh gets it's model matrix from the instance buffer
+		const VkDeviceSize UniformAlignment = std::max<VkDeviceSize>(
+			m_Device->GetPhysicalDevice()->GetDeviceProps().limits.minUniformBufferOffsetAlignment, 1);
+		m_ViewStride = (sizeof(OffscreenUBO) + UniformAlignment - 1) & ~(UniformAlignment - 1);
+
+		m_ViewBuffer = std::make_unique<Buffer>(
+			m_ViewStride * VulkanApp::Get().GetFramesInFlight(),
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		m_ViewBuffer->MapMemory();
+
+		if (t_BindlessTextureCount > 0)
+		{
+			m_BindlessTable = std::make_unique<BindlessMaterialTable>(t_BindlessTextureCount, MaxBindlessMaterials);
+
+			m_MaterialBuffer = std::make_unique<Buffer>(
+				sizeof(BindlessMaterialData) * MaxBindlessMaterials,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			m_MaterialBuffer->MapMemory();
+			F_LOG_TRACE("Offscreen pass using bindless materials with {} texture slots", t_BindlessTextureCount);
+		}
+
 		PrepareAttachments();
 	}
 
 	OffscreenSubpass::~OffscreenSubpass()
 	{
-		// Destroy any allocated semaphores
-		for (size_t i = 0; i < m_OffscreenSemaphores.size(); ++i)
-		{
-			vkDestroySemaphore(m_Device->GetVkDevice(), m_OffscreenSemaphores[i], nullptr);
-		}
-
 		// Clean up command buffers we used
 		for (CommandBuffer* CmdBuf : m_OffscreenCmdBufs)
 		{
@@ -77,6 +130,20 @@ namespace Fling
 
 		vkDestroyCommandPool(m_Device->GetVkDevice(), m_CommandPool, nullptr);
 
+		for (OffscreenRecordingThread& Thread : m_RecordingThreads)
+		{
+			for (std::vector<CommandBuffer*>& FrameBufs : Thread.SecondaryCmdBufs)
+			{
+				for (CommandBuffer* CmdBuf : FrameBufs)
+				{
+					delete CmdBuf;
+				}
+				FrameBufs.clear();
+			}
+			vkDestroyCommandPool(m_Device->GetVkDevice(), Thread.CommandPool, nullptr);
+		}
+		m_RecordingThreads.clear();
+
 		if (m_OffscreenFrameBuf)
 		{
 			delete m_OffscreenFrameBuf;
@@ -87,17 +154,277 @@ namespace Fling
 	void OffscreenSubpass::Draw(
 		CommandBuffer& t_CmdBuf, 
 		VkFramebuffer t_PresentFrameBuf, 
-		UINT32 t_ActiveSwapImage, 
+		UINT32 t_ActiveFrame, 
 		entt::registry& t_reg, 
 		float DeltaTime)
 	{
-		// If the dirty stack has something in it then process that and rebuild cmd buffers
+		assert(m_GraphicsPipeline);
 
-		// Otherwise we don't need to build the offscreen cmd bufs every time
+		// Models that finished loading can be drawn now
+		const UINT64 LoadGeneration = ResourceManager::Get().GetLoadGeneration();
+		if (LoadGeneration != m_LastLoadGeneration)
+		{
+			m_LastLoadGeneration = LoadGeneration;
+			m_BatchesDirty = true;
+		}
 
-		assert(m_GraphicsPipeline);
-		// Don't use the given command buffer, instead build the OFFSCREEN command buffer
-		CommandBuffer* OffscreenCmdBuf = m_OffscreenCmdBufs[t_ActiveSwapImage];
+		if (m_BatchesDirty)
+		{
+			RebuildBatches(t_reg);
+		}
+
+		// Textures that finished loading have new image views. The GPU is done with this frame, so it's
+		// descriptor sets can point at them while the other frames in flight keep reading their own
+		bool HasWrittenSets = false;
+		if (m_WrittenLoadGenerations[t_ActiveFrame] != LoadGeneration)
+		{
+			m_WrittenLoadGenerations[t_ActiveFrame] = LoadGeneration;
+			{
+				std::lock_guard<std::mutex> lock(m_DescriptorPoolMutex);
+				for (const auto& MatSets : m_MaterialDescriptorSets)
+				{
+					WriteMaterialDescriptorSet(MatSets.second[t_ActiveFrame], *MatSets.first);
+				}
+			}
+			if (IsBindless())
+			{
+				m_WrittenTextureCounts[t_ActiveFrame] = 0;
+			}
+
+			// Writing a set invalidates the command buffers that it was bound in
+			HasWrittenSets = true;
+		}
+
+		// New materials from the rebuild only add slots past the ones that are in use
+		if (IsBindless())
+		{
+			UpdateBindlessDescriptors(t_ActiveFrame);
+		}
+
+		// Moving and culling meshes only changes what is in the buffers
+		WriteFrameData(t_reg, t_ActiveFrame);
+
+		// Only record again if the batches or this frame's sets have changed since this frame was last recorded
+		if (HasWrittenSets || m_RecordedVersions[t_ActiveFrame] != m_BatchVersion)
+		{
+			BuildOffscreenCommandBuffer(t_ActiveFrame);
+			m_RecordedVersions[t_ActiveFrame] = m_BatchVersion;
+		}
+	}
+
+	void OffscreenSubpass::RebuildBatches(entt::registry& t_reg)
+	{
+		m_BatchesDirty = false;
+		++m_BatchVersion;
+
+		m_Batches.clear();
+		m_BatchLookup.clear();
+
+		// Bucket every mesh that this pass draws by it's model and material
+		UINT32 InstanceCount = 0;
+		auto MeshView = t_reg.view<MeshRenderer, entt::tag<"Default"_hs>>();
+		for (entt::entity Ent : MeshView)
+		{
+			MeshRenderer& MeshRend = MeshView.get<MeshRenderer>(Ent);
+			MeshRend.m_BatchIndex = UINT32_MAX;
+
+			Fling::Model* Model = MeshRend.m_Model;
+			if (!Model || !Model->IsReady())
+			{
+				continue;
+			}
+
+			auto Inserted = m_BatchLookup.emplace(OffscreenInstanceBatchKey { Model, MeshRend.m_Material }, static_cast<UINT32>(m_Batches.size()));
+			if (Inserted.second)
+			{
+				OffscreenInstanceBatch& Batch = m_Batches.emplace_back();
+				Batch.Model = Model;
+
+				if (IsBindless())
+				{
+					const Material* Mat = MeshRend.m_Material ? MeshRend.m_Material : Material::GetDefaultMat().get();
+					Batch.MaterialIndex = m_BindlessTable->AddMaterial(Mat, Mat->GetPBRTextures());
+				}
+				else
+				{
+					// Meshes share the descriptor sets of their material
+					Batch.DescriptorSets = GetMaterialDescriptorSets(MeshRend.m_Material);
+				}
+			}
+
+			MeshRend.m_BatchIndex = Inserted.first->second;
+			++m_Batches[MeshRend.m_BatchIndex].Capacity;
+			++InstanceCount;
+		}
+
+		// Order the batches by their state so that recording them binds as little as it can
+		m_BatchOrder.clear();
+		for (UINT32 i = 0; i < static_cast<UINT32>(m_Batches.size()); ++i)
+		{
+			const OffscreenInstanceBatch& Batch = m_Batches[i];
+			const UINT32 PipelineId = Batch.Model->GetVertexFormat() == VertexFormat::Packed ? 1 : 0;
+			// Bindless materials are a push constant, so only the descriptor sets of bound materials are worth grouping
+			const UINT32 MaterialId = IsBindless() ? 0 : DrawList::GetSortId(Batch.DescriptorSets, DrawList::MaterialBits);
+			m_BatchOrder.push_back({ DrawList::MakeKey(0, PipelineId, MaterialId, DrawList::GetSortId(Batch.Model, DrawList::MeshBits), 0.0f), i });
+		}
+		DrawList::RadixSort(m_BatchOrder, m_BatchOrderScratch);
+
+		std::vector<OffscreenInstanceBatch> SortedBatches(m_Batches.size());
+		std::vector<UINT32> NewBatchIndex(m_Batches.size());
+		for (UINT32 i = 0; i < static_cast<UINT32>(m_BatchOrder.size()); ++i)
+		{
+			SortedBatches[i] = m_Batches[m_BatchOrder[i].Command];
+			NewBatchIndex[m_BatchOrder[i].Command] = i;
+		}
+		m_Batches.swap(SortedBatches);
+
+		for (auto& Lookup : m_BatchLookup)
+		{
+			Lookup.second = NewBatchIndex[Lookup.second];
+		}
+		for (entt::entity Ent : MeshView)
+		{
+			MeshRenderer& MeshRend = MeshView.get<MeshRenderer>(Ent);
+			if (MeshRend.m_BatchIndex != UINT32_MAX)
+			{
+				MeshRend.m_BatchIndex = NewBatchIndex[MeshRend.m_BatchIndex];
+			}
+		}
+
+		// Each batch gets enough contiguous instance slots for all of it's meshes
+		UINT32 FirstInstance = 0;
+		for (OffscreenInstanceBatch& Batch : m_Batches)
+		{
+			Batch.FirstInstance = FirstInstance;
+			FirstInstance += Batch.Capacity;
+		}
+
+		const UINT32 BatchCount = static_cast<UINT32>(m_Batches.size());
+		if (InstanceCount <= m_InstanceCapacity && BatchCount <= m_BatchCapacity && m_InstanceBuffer && m_IndirectBuffer)
+		{
+			return;
+		}
+
+		// The recorded command buffers of every frame point at the old buffers
+		vkDeviceWaitIdle(m_Device->GetVkDevice());
+
+		const VkDeviceSize FrameCount = VulkanApp::Get().GetFramesInFlight();
+		m_InstanceCapacity = std::max<UINT32>(std::max(InstanceCount, m_InstanceCapacity * 2), 64);
+		m_BatchCapacity = std::max<UINT32>(std::max(BatchCount, m_BatchCapacity * 2), 16);
+
+		m_InstanceBuffer = std::make_unique<Buffer>(
+			FrameCount * m_InstanceCapacity * sizeof(InstanceData),
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		m_InstanceBuffer->MapMemory();
+
+		m_IndirectBuffer = std::make_unique<Buffer>(
+			FrameCount * m_BatchCapacity * MaxMeshLods * sizeof(VkDrawIndexedIndirectCommand),
+			VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		m_IndirectBuffer->MapMemory();
+	}
+
+	void OffscreenSubpass::WriteFrameData(entt::registry& t_reg, UINT32 t_ActiveFrame)
+	{
+		OffscreenUBO* ViewUBO = reinterpret_cast<OffscreenUBO*>(static_cast<char*>(m_ViewBuffer->m_MappedMem) + m_ViewStride * t_ActiveFrame);
+		// Invert the project value to match the proper coordinate space compared to OpenGL
+		ViewUBO->Projection = m_Camera->GetProjectionMatrix();
+		ViewUBO->Projection[1][1] *= -1.0f;
+		ViewUBO->View = m_Camera->GetViewMatrix();
+
+		// Only the meshes that survived culling are drawn
+		const std::vector<entt::entity>& Visible = m_Culler->GetVisibleEntities();
+		const size_t MeshCount = Visible.size();
+		m_InstanceSlots.resize(MeshCount);
+		m_InstanceLods.resize(MeshCount);
+
+		for (OffscreenInstanceBatch& Batch : m_Batches)
+		{
+			Batch.InstanceCount = 0;
+			std::fill(std::begin(Batch.LodInstanceCount), std::end(Batch.LodInstanceCount), 0);
+		}
+
+		// Count the instances of every level first, so that each level can get a contiguous range of the batch's slots
+		for (size_t i = 0; i < MeshCount; ++i)
+		{
+			m_InstanceSlots[i] = UINT32_MAX;
+			if (!t_reg.has<entt::tag<"Default"_hs>>(Visible[i]))
+			{
+				continue;
+			}
+
+			const MeshRenderer& MeshRend = t_reg.get<MeshRenderer>(Visible[i]);
+			if (MeshRend.m_BatchIndex == UINT32_MAX)
+			{
+				continue;
+			}
+
+			OffscreenInstanceBatch& Batch = m_Batches[MeshRend.m_BatchIndex];
+			assert(Batch.InstanceCount < Batch.Capacity);
+			++Batch.InstanceCount;
+
+			const UINT32 Lod = std::min<UINT32>(MeshRend.m_LodIndex, Batch.Model->GetLodCount() - 1);
+			++Batch.LodInstanceCount[Lod];
+			m_InstanceLods[i] = static_cast<UINT8>(Lod);
+			m_InstanceSlots[i] = MeshRend.m_BatchIndex;
+		}
+
+		for (OffscreenInstanceBatch& Batch : m_Batches)
+		{
+			UINT32 FirstInstance = Batch.FirstInstance;
+			for (UINT32 Lod = 0; Lod < MaxMeshLods; ++Lod)
+			{
+				Batch.LodFirstInstance[Lod] = FirstInstance;
+				FirstInstance += Batch.LodInstanceCount[Lod];
+				Batch.LodInstanceCount[Lod] = 0;
+			}
+		}
+
+		for (size_t i = 0; i < MeshCount; ++i)
+		{
+			if (m_InstanceSlots[i] != UINT32_MAX)
+			{
+				OffscreenInstanceBatch& Batch = m_Batches[m_InstanceSlots[i]];
+				const UINT32 Lod = m_InstanceLods[i];
+				m_InstanceSlots[i] = Batch.LodFirstInstance[Lod] + Batch.LodInstanceCount[Lod]++;
+			}
+		}
+
+		InstanceData* Instances = reinterpret_cast<InstanceData*>(m_InstanceBuffer->m_MappedMem) + static_cast<size_t>(m_InstanceCapacity) * t_ActiveFrame;
+
+		// Every mesh knows where it's instance goes, so the world matrices can be copied in parallel
+		JobSystem::ParallelFor(static_cast<UINT32>(MeshCount), 256, [&](UINT32 t_Begin, UINT32 t_End)
+		{
+			for (UINT32 i = t_Begin; i < t_End; ++i)
+			{
+				if (m_InstanceSlots[i] != UINT32_MAX)
+				{
+					Instances[m_InstanceSlots[i]].Model = t_reg.get<Transform>(Visible[i]).GetWorldMat();
+				}
+			}
+		});
+
+		// Batches and levels with nothing visible are still in the command buffer, they just draw zero instances
+		VkDrawIndexedIndirectCommand* Draws = reinterpret_cast<VkDrawIndexedIndirectCommand*>(m_IndirectBuffer->m_MappedMem) + static_cast<size_t>(m_BatchCapacity) * MaxMeshLods * t_ActiveFrame;
+		for (size_t i = 0; i < m_Batches.size(); ++i)
+		{
+			const OffscreenInstanceBatch& Batch = m_Batches[i];
+			for (UINT32 Lod = 0; Lod < Batch.Model->GetLodCount(); ++Lod)
+			{
+				VkDrawIndexedIndirectCommand& Draw = Draws[i * MaxMeshLods + Lod];
+				Draw.indexCount = Batch.Model->GetLod(Lod).IndexCount;
+				Draw.instanceCount = Batch.LodInstanceCount[Lod];
+				Draw.firstIndex = Batch.Model->GetLod(Lod).FirstIndex;
+				Draw.vertexOffset = 0;
+				Draw.firstInstance = Batch.LodFirstInstance[Lod];
+			}
+		}
+	}
+
+	void OffscreenSubpass::BuildOffscreenCommandBuffer(UINT32 t_ActiveFrame)
+	{
+		CommandBuffer* OffscreenCmdBuf = m_OffscreenCmdBufs[t_ActiveFrame];
 		assert(OffscreenCmdBuf);
 
 		// Set viewport and scissors to the offscreen frame buffer
@@ -114,145 +441,254 @@ namespace Fling
 			/** offsetY */ 0
 		);
 
-		OffscreenCmdBuf->Begin();
-		OffscreenCmdBuf->BeginRenderPass(*m_OffscreenFrameBuf, m_ClearValues);
+		// Split the batches into contiguous chunks, at most one per job system thread
+		const size_t BatchCount = m_Batches.size();
+		const size_t ChunkCount = std::min(m_RecordingThreads.size(), (BatchCount + MinBatchesPerChunk - 1) / MinBatchesPerChunk);
+		const size_t ChunkSize = ChunkCount > 0 ? (BatchCount + ChunkCount - 1) / ChunkCount : 0;
+
+		for (OffscreenRecordingThread& Thread : m_RecordingThreads)
+		{
+			Thread.UsedCount = 0;
+		}
 
-		OffscreenCmdBuf->SetViewport(0, { viewport });
-		OffscreenCmdBuf->SetScissor(0, { scissor });
+		std::vector<VkCommandBuffer> SecondaryCmdBufs(ChunkCount, VK_NULL_HANDLE);
+		std::vector<DrawListStats> ChunkStats(ChunkCount);
+		VkRenderPass RenderPass = m_OffscreenFrameBuf->GetRenderPassHandle();
+		VkFramebuffer FrameBuf = m_OffscreenFrameBuf->GetHandle();
+		VkBuffer InstanceBuffer = m_InstanceBuffer->GetVkBuffer();
+		VkBuffer IndirectBuffer = m_IndirectBuffer->GetVkBuffer();
 
-		vkCmdBindPipeline(OffscreenCmdBuf->GetHandle(), VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicsPipeline->GetPipeline());
+		// The regions of the buffers that belong to this frame never move until the batches change
+		const UINT32 ViewOffset = static_cast<UINT32>(m_ViewStride * t_ActiveFrame);
+		const VkDescriptorSet BindlessSets[2] = { m_BindlessViewSet, IsBindless() ? m_BindlessTextureSets[t_ActiveFrame] : VK_NULL_HANDLE };
+		const VkDeviceSize InstanceBufferOffset = static_cast<VkDeviceSize>(m_InstanceCapacity) * t_ActiveFrame * sizeof(InstanceData);
+		const VkDeviceSize IndirectOffset = static_cast<VkDeviceSize>(m_BatchCapacity) * MaxMeshLods * t_ActiveFrame * sizeof(VkDrawIndexedIndirectCommand);
 
-		VkDeviceSize offsets[1] = { 0 };
+		auto RecordChunk = [&](size_t Chunk)
+		{
+			const size_t First = Chunk * ChunkSize;
+			const size_t Last = std::min(First + ChunkSize, BatchCount);
 
-		OffscreenUBO CurrentUBO = {};
-		// Invert the project value to match the proper coordinate space compared to OpenGL
-		CurrentUBO.Projection = m_Camera->GetProjectionMatrix();
-		CurrentUBO.Projection[1][1] *= -1.0f;
-		CurrentUBO.View = m_Camera->GetViewMatrix();
+			CommandBuffer* SecondaryCmdBuf = GetSecondaryCommandBuffer(JobSystem::GetThreadIndex(), t_ActiveFrame);
+			assert(SecondaryCmdBuf);
 
-		// For every mesh bind it's model and descriptor set info
-		auto RenderGroup = t_reg.group<Transform>(entt::get<MeshRenderer, entt::tag<"Default"_hs>>);
+			// Secondary command buffers don't inherit any state from the primary
+			SecondaryCmdBuf->BeginSecondary(RenderPass, 0, FrameBuf);
+			SecondaryCmdBuf->SetViewport(0, { viewport });
+			SecondaryCmdBuf->SetScissor(0, { scissor });
 
-		RenderGroup.less([&](entt::entity ent, Transform& t_trans, MeshRenderer& t_MeshRend)
-		{
-			Fling::Model* Model = t_MeshRend.m_Model;
-			if (!Model)
+			VkCommandBuffer CmdHandle = SecondaryCmdBuf->GetHandle();
+			VkDeviceSize offsets[1] = { 0 };
+			DrawStateTracker State;
+
+			// Every batch reads it's model matrices from the same instance buffer with firstInstance
+			vkCmdBindVertexBuffers(CmdHandle, 1, 1, &InstanceBuffer, &InstanceBufferOffset);
+			++State.GetStats().VertexBufferBinds;
+
+			for (size_t i = First; i < Last; ++i)
 			{
-				return;
+				const OffscreenInstanceBatch& Batch = m_Batches[i];
+
+				// Each vertex format has it's own pipeline
+				const bool IsPacked = Batch.Model->GetVertexFormat() == VertexFormat::Packed;
+				const GraphicsPipeline* Pipeline = IsPacked ? m_PackedPipeline.get() : m_GraphicsPipeline;
+				if (State.SetPipeline(Pipeline->GetPipeline(), Pipeline->GetPipelineLayout()))
+				{
+					SecondaryCmdBuf->BindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, Pipeline->GetPipeline());
+
+					// The pipelines have different push constant ranges, so their layouts aren't compatible
+					if (IsBindless() && State.SetDescriptorSet(BindlessSets[0], ViewOffset))
+					{
+						vkCmdBindDescriptorSets(
+							CmdHandle,
+							VK_PIPELINE_BIND_POINT_GRAPHICS,
+							Pipeline->GetPipelineLayout(),
+							0,
+							2,
+							BindlessSets,
+							1,
+							&ViewOffset);
+					}
+				}
+
+				// Every stage that declares push constants shares the range, so they are pushed to all of them
+				const VkShaderStageFlags PushStages = Pipeline->GetPushConstantStages();
+				if (IsPacked)
+				{
+					const VertexDequantize Dequantize = Batch.Model->GetDequantize();
+					vkCmdPushConstants(CmdHandle, Pipeline->GetPipelineLayout(), PushStages, 0, sizeof(VertexDequantize), &Dequantize);
+				}
+
+				if (IsBindless())
+				{
+					// The material index sits right after the dequantize data, see mrt_bindless.frag
+					vkCmdPushConstants(CmdHandle, Pipeline->GetPipelineLayout(), PushStages, sizeof(VertexDequantize), sizeof(UINT32), &Batch.MaterialIndex);
+				}
+				else if (State.SetDescriptorSet(Batch.DescriptorSets[t_ActiveFrame], ViewOffset))
+				{
+					// Bind the material's descriptor set with the view data as the dynamic offset, batches are sorted by material
+					vkCmdBindDescriptorSets(
+						CmdHandle,
+						VK_PIPELINE_BIND_POINT_GRAPHICS,
+						Pipeline->GetPipelineLayout(),
+						0,
+						1,
+						&Batch.DescriptorSets[t_ActiveFrame],
+						1,
+						&ViewOffset);
+				}
+
+				// Batches of the same model next to each other share it's buffers, bindless batches are sorted by model
+				VkBuffer vertexBuffers[1] = { Batch.Model->GetVertexBuffer()->GetVkBuffer() };
+				if (State.SetVertexBuffer(vertexBuffers[0]))
+				{
+					vkCmdBindVertexBuffers(CmdHandle, 0, 1, vertexBuffers, offsets);
+				}
+				if (State.SetIndexBuffer(Batch.Model->GetIndexBuffer()->GetVkBuffer(), Batch.Model->GetIndexType()))
+				{
+					vkCmdBindIndexBuffer(CmdHandle, Batch.Model->GetIndexBuffer()->GetVkBuffer(), 0, Batch.Model->GetIndexType());
+				}
+
+				// Render every visible instance of the mesh with a draw per level of detail, the counts are written each frame.
+				// One draw at a time doesn't need the multi draw indirect feature
+				for (UINT32 Lod = 0; Lod < Batch.Model->GetLodCount(); ++Lod)
+				{
+					const VkDeviceSize DrawOffset = IndirectOffset + (i * MaxMeshLods + Lod) * sizeof(VkDrawIndexedIndirectCommand);
+					vkCmdDrawIndexedIndirect(CmdHandle, IndirectBuffer, DrawOffset, 1, sizeof(VkDrawIndexedIndirectCommand));
+					State.AddDraw();
+				}
 			}
 
-			// UPDATE UNIFORM BUF of the mesh --------
-			
-			Transform::CalculateWorldMatrix(t_trans);
-			CurrentUBO.Model = t_trans.GetWorldMatrix();
-			CurrentUBO.ObjPos = t_trans.GetPos();
-
-			// Memcpy to the buffer
-			Buffer* buf = t_MeshRend.m_UniformBuffer;
-			memcpy(
-				buf->m_MappedMem, 
-				&CurrentUBO,
-				buf->GetSize()
-			);
+			ChunkStats[Chunk] = State.GetStats();
+			SecondaryCmdBuf->End();
+			SecondaryCmdBufs[Chunk] = CmdHandle;
+		};
 
-			// If the mesh has no descriptor sets, then build them
-			// #TODO Investigate a better way to do this, probably by just moving the 
-			// descriptors off of the mesh
-			if (t_MeshRend.m_DescriptorSet == VK_NULL_HANDLE)
+		// Record every chunk across the job system, this will block until they are all done
+		JobSystem::ParallelFor(static_cast<UINT32>(ChunkCount), 1, [&RecordChunk](UINT32 t_Begin, UINT32 t_End)
+		{
+			for (UINT32 Chunk = t_Begin; Chunk < t_End; ++Chunk)
 			{
-				CreateMeshDescriptorSet(t_MeshRend, VK_NULL_HANDLE, *m_OffscreenFrameBuf);
+				RecordChunk(Chunk);
 			}
-
-			// Bind the descriptor set for rendering a mesh using the dynamic offset
-			vkCmdBindDescriptorSets(
-				OffscreenCmdBuf->GetHandle(),
-				VK_PIPELINE_BIND_POINT_GRAPHICS,
-				m_GraphicsPipeline->GetPipelineLayout(),
-				0,
-				1,
-				&t_MeshRend.m_DescriptorSet,
-				0,
-				nullptr);
-
-			VkBuffer vertexBuffers[1] = { Model->GetVertexBuffer()->GetVkBuffer() };
-			// Render the mesh
-			vkCmdBindVertexBuffers(OffscreenCmdBuf->GetHandle(), 0, 1, vertexBuffers, offsets);
-			vkCmdBindIndexBuffer(OffscreenCmdBuf->GetHandle(), Model->GetIndexBuffer()->GetVkBuffer(), 0, Model->GetIndexType());
-			vkCmdDrawIndexed(OffscreenCmdBuf->GetHandle(), Model->GetIndexCount(), 1, 0, 0, 0);
 		});
 
+		m_DrawStats = {};
+		for (const DrawListStats& Stats : ChunkStats)
+		{
+			m_DrawStats += Stats;
+		}
+
+		OffscreenCmdBuf->Begin();
+		if (m_RenderGraph)
+		{
+			m_RenderGraph->RecordBarriers(OffscreenCmdBuf->GetHandle(), m_GraphPass);
+		}
+		OffscreenCmdBuf->BeginRenderPass(*m_OffscreenFrameBuf, m_ClearValues, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		OffscreenCmdBuf->ExecuteCommands(SecondaryCmdBufs);
 		OffscreenCmdBuf->EndRenderPass();
 
 		OffscreenCmdBuf->End();
 	}
 
+	CommandBuffer* OffscreenSubpass::GetSecondaryCommandBuffer(UINT32 t_ThreadIndex, UINT32 t_ActiveFrame)
+	{
+		assert(t_ThreadIndex < m_RecordingThreads.size());
+		OffscreenRecordingThread& Thread = m_RecordingThreads[t_ThreadIndex];
+		std::vector<CommandBuffer*>& FrameBufs = Thread.SecondaryCmdBufs[t_ActiveFrame];
+
+		if (Thread.UsedCount >= FrameBufs.size())
+		{
+			FrameBufs.emplace_back(new CommandBuffer(m_Device, Thread.CommandPool, VK_COMMAND_BUFFER_LEVEL_SECONDARY));
+		}
+
+		return FrameBufs[Thread.UsedCount++];
+	}
+
 	void OffscreenSubpass::CreateDescriptorSets(VkDescriptorPool t_Pool, entt::registry& t_reg)
 	{
 		
 	}
 
-	void OffscreenSubpass::CreateMeshDescriptorSet(MeshRenderer& t_MeshRend, VkDescriptorPool t_Pool, FrameBuffer& t_FrameBuf)
+	const VkDescriptorSet* OffscreenSubpass::GetMaterialDescriptorSets(const Material* t_Mat)
 	{
-		// Only allocate new descriptor sets if there are none
-		// Some may exist if entt decides to re-use the component
-		if (t_MeshRend.m_DescriptorSet == VK_NULL_HANDLE)
+		// Ensure that we have a material to try and sample from
+		if (t_Mat == nullptr)
 		{
-			VkDescriptorSetLayout layout = m_GraphicsPipeline->GetDescriptorSetLayout();
-			VkDescriptorSetAllocateInfo allocInfo = {};
-			allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-			// If we have specified a specific pool then use that, otherwise use the one on the mesh
-			allocInfo.descriptorPool = m_DescriptorPool;
-			allocInfo.descriptorSetCount = 1;
-			allocInfo.pSetLayouts = &layout;
+			t_Mat = Material::GetDefaultMat().get();
+		}
+
+		// Descriptor pools are not thread safe, and this can be called while recording
+		std::lock_guard<std::mutex> lock(m_DescriptorPoolMutex);
 
-			VK_CHECK_RESULT(vkAllocateDescriptorSets(m_Device->GetVkDevice(), &allocInfo, &t_MeshRend.m_DescriptorSet));
+		auto it = m_MaterialDescriptorSets.find(t_Mat);
+		if (it != m_MaterialDescriptorSets.end())
+		{
+			return it->second.data();
 		}
 
-		// Ensure that we have a material to try and sample from
-		if (t_MeshRend.m_Material == nullptr)
+		// None of the frames have used the new sets yet, so they can all be written now
+		std::vector<VkDescriptorSet> Sets(VulkanApp::Get().GetFramesInFlight(), VK_NULL_HANDLE);
+		std::vector<VkDescriptorSetLayout> layouts(Sets.size(), m_GraphicsPipeline->GetDescriptorSetLayout());
+		VkDescriptorSetAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = m_DescriptorPool;
+		allocInfo.descriptorSetCount = static_cast<UINT32>(layouts.size());
+		allocInfo.pSetLayouts = layouts.data();
+
+		VK_CHECK_RESULT(vkAllocateDescriptorSets(m_Device->GetVkDevice(), &allocInfo, Sets.data()));
+
+		for (VkDescriptorSet Set : Sets)
 		{
-			t_MeshRend.m_Material = Material::GetDefaultMat().get();
+			WriteMaterialDescriptorSet(Set, *t_Mat);
 		}
-		
+		return m_MaterialDescriptorSets.emplace(t_Mat, std::move(Sets)).first->second.data();
+	}
+
+	void OffscreenSubpass::WriteMaterialDescriptorSet(VkDescriptorSet t_Set, const Material& t_Mat)
+	{
+		const PBRTextures& Textures = t_Mat.GetPBRTextures();
+
+		VkDescriptorBufferInfo ViewInfo = {};
+		ViewInfo.buffer = m_ViewBuffer->GetVkBuffer();
+		ViewInfo.offset = 0;
+		ViewInfo.range = sizeof(OffscreenUBO);
+
 		std::vector<VkWriteDescriptorSet> writeDescriptorSets =
 		{
-			// 0: UBO
-			Initializers::WriteDescriptorSetUniform(
-				t_MeshRend.m_UniformBuffer,
-				t_MeshRend.m_DescriptorSet,
-				0
+			// Dynamic UBO, each frame in flight binds it's own view uniforms
+			Initializers::WriteDescriptorSet(
+				t_Set,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+				m_GraphicsPipeline->GetBinding("ubo"),
+				&ViewInfo
 			),
-			// 1: Color map 
+			// Color map 
 			Initializers::WriteDescriptorSetImage(
-				t_MeshRend.m_Material->GetPBRTextures().m_AlbedoTexture,
-				t_MeshRend.m_DescriptorSet,
-				1),
-			// 2: Normal map
+				Textures.m_AlbedoTexture,
+				t_Set,
+				m_GraphicsPipeline->GetBinding("samplerColor")),
+			// Normal map
 			Initializers::WriteDescriptorSetImage(
-				t_MeshRend.m_Material->GetPBRTextures().m_NormalTexture,
-				t_MeshRend.m_DescriptorSet,
-				2),
-			// 3: Metal map
+				Textures.m_NormalTexture,
+				t_Set,
+				m_GraphicsPipeline->GetBinding("samplerNormalMap")),
+			// Metal map
 			Initializers::WriteDescriptorSetImage(
-				t_MeshRend.m_Material->GetPBRTextures().m_MetalTexture,
-				t_MeshRend.m_DescriptorSet,
-				3),
-			// 4: Roughness map
+				Textures.m_MetalTexture,
+				t_Set,
+				m_GraphicsPipeline->GetBinding("samplerMetalMap")),
+			// Roughness map
 			Initializers::WriteDescriptorSetImage(
-				t_MeshRend.m_Material->GetPBRTextures().m_RoughnessTexture,
-				t_MeshRend.m_DescriptorSet,
-				4)
+				Textures.m_RoughnessTexture,
+				t_Set,
+				m_GraphicsPipeline->GetBinding("samplerRoughnessMap"))
 			// Any other PBR textures or other samplers go HERE and you add to the MRT shader
 		};
 
 		vkUpdateDescriptorSets(m_Device->GetVkDevice(), static_cast<UINT32>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
 	}
 
-	void OffscreenSubpass::BuildOffscreenCommandBuffer(entt::registry& t_reg, UINT32 t_ActiveFrameInFlight)
-	{
-
-	}
-
 	void OffscreenSubpass::PrepareAttachments()
 	{
 		assert(m_OffscreenFrameBuf == nullptr);
@@ -308,12 +744,14 @@ namespace Fling
 		F_LOG_TRACE("Offscreen render pass created...");
 
 
-		// Create the descriptor pool for off screen things
-		UINT32 DescriptorCount = 2000 * m_SwapChain->GetImageViewCount();
+		// Create the descriptor pool for off screen things. Every set is per frame in flight, so this doesn't need
+		// the swap chain and the pass can record without one
+		UINT32 DescriptorCount = 2000 * VulkanApp::Get().GetFramesInFlight();
 
 		std::vector<VkDescriptorPoolSize> poolSizes =
 		{
 			Initializers::DescriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 		DescriptorCount),
+			Initializers::DescriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, DescriptorCount),
 			Initializers::DescriptorPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 			DescriptorCount),
 			Initializers::DescriptorPoolSize(VK_DESCRIPTOR_TYPE_SAMPLER, 				DescriptorCount),
 			Initializers::DescriptorPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, DescriptorCount),
@@ -324,21 +762,144 @@ namespace Fling
 		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 		poolInfo.poolSizeCount = static_cast<UINT32>(poolSizes.size());
 		poolInfo.pPoolSizes = poolSizes.data();
-		poolInfo.maxSets = to_u32(1000 * m_SwapChain->GetImageViewCount());
+		poolInfo.maxSets = to_u32(1000 * VulkanApp::Get().GetFramesInFlight());
 
 		if (vkCreateDescriptorPool(m_Device->GetVkDevice(), &poolInfo, nullptr, &m_DescriptorPool) != VK_SUCCESS)
 		{
 			F_LOG_FATAL("Failed to create descriptor pool");
 		}
+
+		if (IsBindless())
+		{
+			CreateBindlessDescriptorSets();
+		}
+	}
+
+	void OffscreenSubpass::CreateBindlessDescriptorSets()
+	{
+		assert(IsBindless() && m_DescriptorPool != VK_NULL_HANDLE);
+
+		// The texture arrays get written while command buffers that use them are recorded
+		const UINT32 FrameCount = VulkanApp::Get().GetFramesInFlight();
+		VkDescriptorPoolSize TextureSize = Initializers::DescriptorPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_BindlessTable->GetMaxTextures() * FrameCount);
+
+		VkDescriptorPoolCreateInfo PoolInfo = {};
+		PoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		PoolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+		PoolInfo.poolSizeCount = 1;
+		PoolInfo.pPoolSizes = &TextureSize;
+		PoolInfo.maxSets = FrameCount;
+
+		if (vkCreateDescriptorPool(m_Device->GetVkDevice(), &PoolInfo, nullptr, &m_BindlessPool) != VK_SUCCESS)
+		{
+			F_LOG_FATAL("Failed to create bindless descriptor pool");
+		}
+
+		// Both pipelines have the same set layouts, they come from the same shader interface
+		const std::vector<VkDescriptorSetLayout>& Layouts = m_GraphicsPipeline->GetDescriptorSetLayouts();
+		assert(Layouts.size() == 2 && Layouts == m_PackedPipeline->GetDescriptorSetLayouts());
+
+		VkDescriptorSetAllocateInfo AllocInfo = {};
+		AllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		AllocInfo.descriptorPool = m_DescriptorPool;
+		AllocInfo.descriptorSetCount = 1;
+		AllocInfo.pSetLayouts = &Layouts[0];
+		VK_CHECK_RESULT(vkAllocateDescriptorSets(m_Device->GetVkDevice(), &AllocInfo, &m_BindlessViewSet));
+
+		// Each frame in flight gets it's own texture array to write when textures finish loading
+		m_BindlessTextureSets.resize(FrameCount, VK_NULL_HANDLE);
+		m_WrittenTextureCounts.resize(FrameCount, 0);
+		const std::vector<VkDescriptorSetLayout> TextureLayouts(FrameCount, Layouts[1]);
+		AllocInfo.descriptorPool = m_BindlessPool;
+		AllocInfo.descriptorSetCount = FrameCount;
+		AllocInfo.pSetLayouts = TextureLayouts.data();
+		VK_CHECK_RESULT(vkAllocateDescriptorSets(m_Device->GetVkDevice(), &AllocInfo, m_BindlessTextureSets.data()));
+
+		VkDescriptorBufferInfo ViewInfo = {};
+		ViewInfo.buffer = m_ViewBuffer->GetVkBuffer();
+		ViewInfo.offset = 0;
+		ViewInfo.range = sizeof(OffscreenUBO);
+
+		VkDescriptorBufferInfo MaterialInfo = {};
+		MaterialInfo.buffer = m_MaterialBuffer->GetVkBuffer();
+		MaterialInfo.offset = 0;
+		MaterialInfo.range = VK_WHOLE_SIZE;
+
+		std::vector<VkWriteDescriptorSet> Writes =
+		{
+			// Dynamic UBO, each frame in flight binds it's own view uniforms
+			Initializers::WriteDescriptorSet(
+				m_BindlessViewSet,
+				VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+				m_GraphicsPipeline->GetBinding("ubo"),
+				&ViewInfo
+			),
+			// Every material, indexed by the pushed material index
+			Initializers::WriteDescriptorSet(
+				m_BindlessViewSet,
+				VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+				m_GraphicsPipeline->GetBinding("materials"),
+				&MaterialInfo
+			)
+		};
+
+		vkUpdateDescriptorSets(m_Device->GetVkDevice(), static_cast<UINT32>(Writes.size()), Writes.data(), 0, nullptr);
+	}
+
+	void OffscreenSubpass::UpdateBindlessDescriptors(UINT32 t_ActiveFrame)
+	{
+		assert(IsBindless() && m_BindlessTextureSets[t_ActiveFrame] != VK_NULL_HANDLE);
+
+		// Materials never change once they are added, so only the new ones are copied
+		const std::vector<BindlessMaterialData>& Materials = m_BindlessTable->GetMaterials();
+		if (m_WrittenMaterialCount < Materials.size())
+		{
+			BindlessMaterialData* Mapped = reinterpret_cast<BindlessMaterialData*>(m_MaterialBuffer->m_MappedMem);
+			std::memcpy(Mapped + m_WrittenMaterialCount, Materials.data() + m_WrittenMaterialCount, (Materials.size() - m_WrittenMaterialCount) * sizeof(BindlessMaterialData));
+			m_WrittenMaterialCount = static_cast<UINT32>(Materials.size());
+		}
+
+		UINT32& WrittenTextureCount = m_WrittenTextureCounts[t_ActiveFrame];
+		const std::vector<Texture*>& Textures = m_BindlessTable->GetTextures();
+		if (WrittenTextureCount >= Textures.size())
+		{
+			return;
+		}
+
+		// Slots are contiguous, so the new ones are written as a single range of the array
+		std::vector<VkDescriptorImageInfo> ImageInfos;
+		ImageInfos.reserve(Textures.size() - WrittenTextureCount);
+		for (size_t i = WrittenTextureCount; i < Textures.size(); ++i)
+		{
+			ImageInfos.push_back(*Textures[i]->GetDescriptorInfo());
+		}
+
+		VkWriteDescriptorSet Write = {};
+		Write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		Write.dstSet = m_BindlessTextureSets[t_ActiveFrame];
+		Write.dstBinding = m_GraphicsPipeline->GetBinding("textures");
+		Write.dstArrayElement = WrittenTextureCount;
+		Write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		Write.descriptorCount = static_cast<UINT32>(ImageInfos.size());
+		Write.pImageInfo = ImageInfos.data();
+
+		vkUpdateDescriptorSets(m_Device->GetVkDevice(), 1, &Write, 0, nullptr);
+		WrittenTextureCount = static_cast<UINT32>(Textures.size());
 	}
 
 	void OffscreenSubpass::CreateGraphicsPipeline()
+	{
+		CreateGBufferPipeline(m_GraphicsPipeline, VertexFormat::Full);
+		CreateGBufferPipeline(m_PackedPipeline.get(), VertexFormat::Packed);
+	}
+
+	void OffscreenSubpass::CreateGBufferPipeline(GraphicsPipeline* t_Pipeline, VertexFormat t_Format)
 	{
 		assert(m_OffscreenFrameBuf);
 		VkRenderPass RenderPass = m_OffscreenFrameBuf->GetRenderPassHandle();
 		assert(RenderPass != VK_NULL_HANDLE);
 
-		m_GraphicsPipeline->m_RasterizationState =
+		t_Pipeline->m_RasterizationState =
 			Initializers::PipelineRasterizationStateCreateInfo(
 				VK_POLYGON_MODE_FILL,
 				VK_CULL_MODE_BACK_BIT,
@@ -349,7 +910,7 @@ namespace Fling
 		// Blend attachment states required for all color attachments
 		// This is important, as color write mask will otherwise be 0x0 and you
 		// won't see anything rendered to the attachment
-		m_GraphicsPipeline->m_ColorBlendAttachmentStates = 
+		t_Pipeline->m_ColorBlendAttachmentStates = 
 		{
 			Initializers::PipelineColorBlendAttachmentState(0xf, VK_FALSE),
 			Initializers::PipelineColorBlendAttachmentState(0xf, VK_FALSE),
@@ -358,14 +919,18 @@ namespace Fling
 			Initializers::PipelineColorBlendAttachmentState(0xf, VK_FALSE)
 		};
 
-		m_GraphicsPipeline->m_ColorBlendState.attachmentCount =
-			static_cast<uint32_t>(m_GraphicsPipeline->m_ColorBlendAttachmentStates.size());
+		t_Pipeline->m_ColorBlendState.attachmentCount =
+			static_cast<uint32_t>(t_Pipeline->m_ColorBlendAttachmentStates.size());
 
-		m_GraphicsPipeline->m_ColorBlendState.pAttachments = 
-			m_GraphicsPipeline->m_ColorBlendAttachmentStates.data();
+		t_Pipeline->m_ColorBlendState.pAttachments = 
+			t_Pipeline->m_ColorBlendAttachmentStates.data();
 
-		m_GraphicsPipeline->m_MultisampleState =
+		t_Pipeline->m_MultisampleState =
 			Initializers::PipelineMultiSampleStateCreateInfo(VK_SAMPLE_COUNT_1_BIT, 0);
+
+		// Model matrices come from the instance buffer on binding 1
+		t_Pipeline->m_Instanced = true;
+		t_Pipeline->m_VertexFormat = t_Format;
 		
 		std::vector<VkDynamicState> dynamicStateEnables = 
 		{
@@ -373,19 +938,45 @@ namespace Fling
 			VK_DYNAMIC_STATE_SCISSOR
 		};
 
-		m_GraphicsPipeline->m_DynamicState =
+		t_Pipeline->m_DynamicState =
 			Initializers::PipelineDynamicStateCreateInfo(
 				dynamicStateEnables.data(), 
 				dynamicStateEnables.size(), 
 				0);
 
-		m_GraphicsPipeline->CreateGraphicsPipeline(RenderPass, nullptr);
+		t_Pipeline->CreateGraphicsPipeline(RenderPass, nullptr);
 	}
 
-	void OffscreenSubpass::GatherPresentDependencies(std::vector<CommandBuffer*>& t_CmdBuffs, std::vector<VkSemaphore>& t_Deps, UINT32 t_ActiveFrameIndex, UINT32 t_CurrentFrameInFlight)
+	void OffscreenSubpass::DeclareResources(RenderGraph& t_Graph, UINT32 t_Pass)
 	{
-		t_CmdBuffs.emplace_back(m_OffscreenCmdBufs[t_ActiveFrameIndex]);
-		t_Deps.emplace_back(m_OffscreenSemaphores[t_CurrentFrameInFlight]);
+		assert(m_OffscreenFrameBuf);
+		m_RenderGraph = &t_Graph;
+		m_GraphPass = t_Pass;
+
+		RenderGraphTextureDesc Desc = {};
+		Desc.Width = static_cast<UINT32>(m_OffscreenFrameBuf->GetWidth());
+		Desc.Height = static_cast<UINT32>(m_OffscreenFrameBuf->GetHeight());
+
+		// The render pass leaves the color attachments ready to be sampled and the depth read only
+		for (UINT32 i = 0; i <= GBufferColorCount; ++i)
+		{
+			const FrameBufferAttachment* Attachment = m_OffscreenFrameBuf->GetAttachmentAtIndex(i);
+			assert(Attachment);
+			Desc.Format = Attachment->GetFormat();
+
+			const bool IsDepth = i == GBufferColorCount;
+			RenderGraphResource Texture = t_Graph.ImportTexture(
+				IsDepth ? "GBuffer.Depth" : GBufferColorNames[i],
+				Desc,
+				Attachment->GetImageHandle(),
+				Attachment->GetSubresourceRange().aspectMask);
+
+			t_Graph.Write(
+				t_Pass,
+				Texture,
+				IsDepth ? RenderGraphUsage::DepthAttachment : RenderGraphUsage::ColorAttachment,
+				IsDepth ? RenderGraphUsage::DepthRead : RenderGraphUsage::ShaderRead);
+		}
 	}
 
 	void OffscreenSubpass::CleanUp(entt::registry& t_reg)
@@ -402,6 +993,21 @@ namespace Fling
 			vkDestroyDescriptorPool(m_Device->GetVkDevice(), m_DescriptorPool, nullptr);
 			m_DescriptorPool = VK_NULL_HANDLE;
 		}
+		m_MaterialDescriptorSets.clear();
+
+		if (m_BindlessPool != VK_NULL_HANDLE)
+		{
+			vkDestroyDescriptorPool(m_Device->GetVkDevice(), m_BindlessPool, nullptr);
+			m_BindlessPool = VK_NULL_HANDLE;
+		}
+		m_BindlessViewSet = VK_NULL_HANDLE;
+		m_BindlessTextureSets.clear();
+		m_WrittenTextureCounts.clear();
+		m_MaterialBuffer.reset();
+
+		m_ViewBuffer.reset();
+		m_InstanceBuffer.reset();
+		m_IndirectBuffer.reset();
 	}
 
 	void OffscreenSubpass::OnMeshRendererAdded(entt::entity t_Ent, entt::registry& t_Reg, MeshRenderer& t_MeshRend)
@@ -413,21 +1019,27 @@ namespace Fling
 
 		t_Reg.assign<entt::tag<"Default"_hs >>(t_Ent);
 
-		// Initialize and map the UBO of each mesh renderer
-		if (t_MeshRend.m_UniformBuffer == nullptr)
+		if (t_MeshRend.m_Material == nullptr)
 		{
-			VkDeviceSize bufferSize = sizeof(OffscreenUBO);
-			t_MeshRend.m_UniformBuffer = new Buffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-			t_MeshRend.m_UniformBuffer->MapMemory(bufferSize);
+			t_MeshRend.m_Material = Material::GetDefaultMat().get();
 		}
-		
-		// I would love to create some descriptor sets here		
-		assert(m_OffscreenFrameBuf);
-		CreateMeshDescriptorSet(t_MeshRend, VK_NULL_HANDLE, *m_OffscreenFrameBuf);
+		if (!IsBindless())
+		{
+			GetMaterialDescriptorSets(t_MeshRend.m_Material);
+		}
+		m_BatchesDirty = true;
+	}
+
+	void OffscreenSubpass::OnMeshRendererReplaced(entt::entity t_Ent, entt::registry& t_Reg, MeshRenderer& t_MeshRend)
+	{
+		// The new mesh or material could belong in a different batch, or not be drawn by this pass at all
+		t_Reg.reset<entt::tag<"Default"_hs>>(t_Ent);
+		OnMeshRendererAdded(t_Ent, t_Reg, t_MeshRend);
+		m_BatchesDirty = true;
 	}
 
-	void OffscreenSubpass::OnMeshRendererDestroyed(entt::registry& t_Reg, MeshRenderer& t_MeshRend)
+	void OffscreenSubpass::OnMeshRendererDestroyed(entt::entity t_Ent, entt::registry& t_Reg)
 	{
-		//t_MeshRend.Release();
+		m_BatchesDirty = true;
 	}
 }   // namespace Fling
\ No newline at end of file
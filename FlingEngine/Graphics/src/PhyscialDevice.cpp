@@ -2,6 +2,8 @@
 #include "PhyscialDevice.h"
 #include "Instance.h"
 
+#include <algorithm>
+
 // @note
 // Referenced the Acid Engine for some of the vendor numbers and scoring technique: 
 // https://github.com/EQMG/Acid/blob/master/Sources/Devices/PhysicalDevice.cpp
@@ -35,10 +37,64 @@ namespace Fling
 		vkGetPhysicalDeviceProperties(m_PhysicalDevice, &m_DeviceProperties);
 		vkGetPhysicalDeviceFeatures(m_PhysicalDevice, &m_DeviceFeatures);
 		vkGetPhysicalDeviceMemoryProperties(m_PhysicalDevice, &m_MemoryProperties);
+		QueryBindlessSupport();
 		
 		LogPhysicalDeviceInfo();
     }
 
+	void PhysicalDevice::QueryBindlessSupport()
+	{
+		m_SupportsBindless = false;
+		m_MaxBindlessTextures = 0;
+
+		// Features2 is core in 1.1, which the instance asks for
+		if (m_DeviceProperties.apiVersion < VK_API_VERSION_1_1)
+		{
+			return;
+		}
+
+		UINT32 ExtensionCount = 0;
+		vkEnumerateDeviceExtensionProperties(m_PhysicalDevice, nullptr, &ExtensionCount, nullptr);
+		std::vector<VkExtensionProperties> Extensions(ExtensionCount);
+		vkEnumerateDeviceExtensionProperties(m_PhysicalDevice, nullptr, &ExtensionCount, Extensions.data());
+
+		const bool HasExtension = std::any_of(Extensions.begin(), Extensions.end(), [](const VkExtensionProperties& Extension)
+		{
+			return strcmp(Extension.extensionName, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) == 0;
+		});
+		if (!HasExtension)
+		{
+			return;
+		}
+
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT IndexingFeatures = {};
+		IndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+		VkPhysicalDeviceFeatures2 Features = {};
+		Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		Features.pNext = &IndexingFeatures;
+		vkGetPhysicalDeviceFeatures2(m_PhysicalDevice, &Features);
+
+		VkPhysicalDeviceDescriptorIndexingPropertiesEXT IndexingProps = {};
+		IndexingProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+		VkPhysicalDeviceProperties2 Props = {};
+		Props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		Props.pNext = &IndexingProps;
+		vkGetPhysicalDeviceProperties2(m_PhysicalDevice, &Props);
+
+		m_SupportsBindless =
+			IndexingFeatures.runtimeDescriptorArray &&
+			IndexingFeatures.descriptorBindingPartiallyBound &&
+			IndexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+			IndexingFeatures.descriptorBindingUpdateUnusedWhilePending;
+
+		if (m_SupportsBindless)
+		{
+			m_MaxBindlessTextures = std::min(
+				IndexingProps.maxPerStageDescriptorUpdateAfterBindSampledImages, 
+				IndexingProps.maxDescriptorSetUpdateAfterBindSampledImages);
+		}
+	}
+
 	VkFormatProperties PhysicalDevice::GetFormatProperties(VkFormat t_Form) const
 	{
 		assert(m_PhysicalDevice != VK_NULL_HANDLE);
@@ -114,6 +170,8 @@ namespace Fling
 		DeviceInfo << "\n\tAPI Version: " << supportedVersion[0];
 		DeviceInfo << "." << supportedVersion[1];
 		DeviceInfo << "." << supportedVersion[2];
+
+		DeviceInfo << "\n\tBindless: " << (m_SupportsBindless ? "Yes" : "No");
 		
 		F_LOG_TRACE("{}\n", DeviceInfo.str());
 	}
@@ -0,0 +1,238 @@
+#include "pch.h"
+#include "PipelineCacheManager.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace Fling
+{
+	namespace
+	{
+		/** The header that every driver puts at the start of its cache data, VkPipelineCacheHeaderVersionOne */
+		struct DriverCacheHeader
+		{
+			UINT32 HeaderSize;
+			UINT32 HeaderVersion;
+			UINT32 VendorID;
+			UINT32 DeviceID;
+			UINT8 PipelineCacheUUID[VK_UUID_SIZE];
+		};
+		static_assert(sizeof(DriverCacheHeader) == 32, "Driver pipeline cache header is 32 bytes");
+	}
+
+	PipelineCacheManager::PipelineCacheManager(VkDevice t_Device, const VkPhysicalDeviceProperties& t_Props, const std::string& t_FilePath)
+		: m_Device(t_Device)
+		, m_DeviceProps(t_Props)
+		, m_FilePath(t_FilePath)
+	{
+		const std::vector<UINT8> CacheData = Load();
+		m_IsWarm = !CacheData.empty();
+
+		VkPipelineCacheCreateInfo CreateInfo = {};
+		CreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		CreateInfo.initialDataSize = CacheData.size();
+		CreateInfo.pInitialData = CacheData.empty() ? nullptr : CacheData.data();
+
+		if (vkCreatePipelineCache(m_Device, &CreateInfo, nullptr, &m_PipelineCache) != VK_SUCCESS)
+		{
+			// The driver already checked the header, but start empty rather than fail if it still doesn't like the data
+			F_LOG_WARN("Failed to create the pipeline cache from {}, starting with an empty one", m_FilePath);
+			m_IsWarm = false;
+			CreateInfo.initialDataSize = 0;
+			CreateInfo.pInitialData = nullptr;
+			if (vkCreatePipelineCache(m_Device, &CreateInfo, nullptr, &m_PipelineCache) != VK_SUCCESS)
+			{
+				F_LOG_FATAL("Failed to create pipeline cache");
+			}
+		}
+	}
+
+	PipelineCacheManager::~PipelineCacheManager()
+	{
+		Save();
+		vkDestroyPipelineCache(m_Device, m_PipelineCache, nullptr);
+	}
+
+	std::vector<UINT8> PipelineCacheManager::Load()
+	{
+		std::ifstream File(m_FilePath, std::ios::binary | std::ios::ate);
+		if (!File.is_open())
+		{
+			F_LOG_TRACE("No pipeline cache at {}, pipelines will be compiled from scratch", m_FilePath);
+			return {};
+		}
+
+		std::vector<UINT8> FileData(static_cast<size_t>(File.tellg()));
+		File.seekg(0);
+		File.read(reinterpret_cast<char*>(FileData.data()), static_cast<std::streamsize>(FileData.size()));
+		if (!File)
+		{
+			F_LOG_WARN("Failed to read the pipeline cache {}", m_FilePath);
+			return {};
+		}
+
+		const PipelineCacheFileHeader* Header = nullptr;
+		const UINT8* CacheData = Validate(FileData.data(), FileData.size(), m_DeviceProps, &Header);
+		if (!CacheData)
+		{
+			F_LOG_WARN("Pipeline cache {} is from another device or driver, pipelines will be compiled from scratch", m_FilePath);
+			return {};
+		}
+
+		m_ColdMicroseconds = Header->ColdCreationMicroseconds;
+		return std::vector<UINT8>(CacheData, CacheData + Header->DataSize);
+	}
+
+	bool PipelineCacheManager::Save()
+	{
+		size_t DataSize = 0;
+		if (vkGetPipelineCacheData(m_Device, m_PipelineCache, &DataSize, nullptr) != VK_SUCCESS || DataSize == 0)
+		{
+			return false;
+		}
+
+		std::vector<UINT8> CacheData(DataSize);
+		if (vkGetPipelineCacheData(m_Device, m_PipelineCache, &DataSize, CacheData.data()) != VK_SUCCESS)
+		{
+			F_LOG_WARN("Failed to get the pipeline cache data");
+			return false;
+		}
+		CacheData.resize(DataSize);
+
+		std::vector<UINT8> FileData;
+		Serialize(m_DeviceProps, CacheData, m_ColdMicroseconds, FileData);
+
+		// Write next to the real file and swap it in so that a crash can't leave half of a cache behind
+		const std::string TempPath = m_FilePath + ".tmp";
+		{
+			std::ofstream File(TempPath, std::ios::binary | std::ios::trunc);
+			if (!File.is_open() || !File.write(reinterpret_cast<const char*>(FileData.data()), static_cast<std::streamsize>(FileData.size())))
+			{
+				F_LOG_WARN("Failed to write the pipeline cache to {}", TempPath);
+				return false;
+			}
+		}
+
+		std::error_code Error;
+		std::filesystem::rename(TempPath, m_FilePath, Error);
+		if (Error)
+		{
+			F_LOG_WARN("Failed to save the pipeline cache to {}: {}", m_FilePath, Error.message());
+			return false;
+		}
+		return true;
+	}
+
+	VkResult PipelineCacheManager::CreateGraphicsPipelines(const VkGraphicsPipelineCreateInfo* t_CreateInfos, UINT32 t_Count, VkPipeline* t_OutPipelines)
+	{
+		const auto Start = std::chrono::high_resolution_clock::now();
+
+		const VkResult Result = vkCreateGraphicsPipelines(m_Device, m_PipelineCache, t_Count, t_CreateInfos, nullptr, t_OutPipelines);
+
+		const auto Elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - Start);
+		m_CreationMicroseconds.fetch_add(static_cast<UINT64>(Elapsed.count()), std::memory_order_relaxed);
+		m_CreatedCount.fetch_add(t_Count, std::memory_order_relaxed);
+		return Result;
+	}
+
+	void PipelineCacheManager::ReportCreationTime()
+	{
+		const UINT64 Microseconds = GetCreationMicroseconds();
+		const double Milliseconds = static_cast<double>(Microseconds) / 1000.0;
+
+		if (!m_IsWarm)
+		{
+			if (m_ColdMicroseconds == 0)
+			{
+				m_ColdMicroseconds = Microseconds;
+			}
+			F_LOG_TRACE("Created {} pipelines in {:.2f} ms with a cold pipeline cache", GetCreatedPipelineCount(), Milliseconds);
+		}
+		else if (m_ColdMicroseconds > 0)
+		{
+			const double ColdMilliseconds = static_cast<double>(m_ColdMicroseconds) / 1000.0;
+			F_LOG_TRACE("Created {} pipelines in {:.2f} ms with a warm pipeline cache, {:.2f} ms cold ({:.1f}x faster)",
+				GetCreatedPipelineCount(), Milliseconds, ColdMilliseconds, ColdMilliseconds / std::max(Milliseconds, 0.001));
+		}
+		else
+		{
+			F_LOG_TRACE("Created {} pipelines in {:.2f} ms with a warm pipeline cache", GetCreatedPipelineCount(), Milliseconds);
+		}
+	}
+
+	void PipelineCacheManager::Serialize(const VkPhysicalDeviceProperties& t_Props, const std::vector<UINT8>& t_CacheData, UINT64 t_ColdMicroseconds, std::vector<UINT8>& t_OutFile)
+	{
+		PipelineCacheFileHeader Header = {};
+		Header.Magic = Magic;
+		Header.Version = Version;
+		Header.VendorID = t_Props.vendorID;
+		Header.DeviceID = t_Props.deviceID;
+		Header.DriverVersion = t_Props.driverVersion;
+		Header.DataSize = static_cast<UINT32>(t_CacheData.size());
+		Header.DataHash = HashData(t_CacheData.data(), t_CacheData.size());
+		std::memcpy(Header.PipelineCacheUUID, t_Props.pipelineCacheUUID, VK_UUID_SIZE);
+		Header.ColdCreationMicroseconds = t_ColdMicroseconds;
+
+		t_OutFile.resize(sizeof(Header) + t_CacheData.size());
+		std::memcpy(t_OutFile.data(), &Header, sizeof(Header));
+		if (!t_CacheData.empty())
+		{
+			std::memcpy(t_OutFile.data() + sizeof(Header), t_CacheData.data(), t_CacheData.size());
+		}
+	}
+
+	const UINT8* PipelineCacheManager::Validate(const UINT8* t_File, size_t t_FileSize, const VkPhysicalDeviceProperties& t_Props, const PipelineCacheFileHeader** t_OutHeader)
+	{
+		if (!t_File || t_FileSize < sizeof(PipelineCacheFileHeader))
+		{
+			return nullptr;
+		}
+
+		PipelineCacheFileHeader Header;
+		std::memcpy(&Header, t_File, sizeof(Header));
+		if (Header.Magic != Magic || Header.Version != Version ||
+			Header.VendorID != t_Props.vendorID || Header.DeviceID != t_Props.deviceID || Header.DriverVersion != t_Props.driverVersion ||
+			std::memcmp(Header.PipelineCacheUUID, t_Props.pipelineCacheUUID, VK_UUID_SIZE) != 0 ||
+			Header.DataSize < sizeof(DriverCacheHeader) || Header.DataSize != t_FileSize - sizeof(Header))
+		{
+			return nullptr;
+		}
+
+		const UINT8* Data = t_File + sizeof(Header);
+		if (HashData(Data, Header.DataSize) != Header.DataHash)
+		{
+			return nullptr;
+		}
+
+		// Drivers are supposed to check this themselves, but some have crashed on caches from other versions
+		DriverCacheHeader DriverHeader;
+		std::memcpy(&DriverHeader, Data, sizeof(DriverHeader));
+		if (DriverHeader.HeaderSize < sizeof(DriverCacheHeader) || DriverHeader.HeaderSize > Header.DataSize ||
+			DriverHeader.HeaderVersion != static_cast<UINT32>(VK_PIPELINE_CACHE_HEADER_VERSION_ONE) ||
+			DriverHeader.VendorID != t_Props.vendorID || DriverHeader.DeviceID != t_Props.deviceID ||
+			std::memcmp(DriverHeader.PipelineCacheUUID, t_Props.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		{
+			return nullptr;
+		}
+
+		if (t_OutHeader)
+		{
+			*t_OutHeader = reinterpret_cast<const PipelineCacheFileHeader*>(t_File);
+		}
+		return Data;
+	}
+
+	UINT64 PipelineCacheManager::HashData(const UINT8* t_Data, size_t t_Size)
+	{
+		// FNV-1a, only here to catch files that were cut short or damaged on disk
+		UINT64 Hash = 14695981039346656037ull;
+		for (size_t i = 0; i < t_Size; ++i)
+		{
+			Hash ^= t_Data[i];
+			Hash *= 1099511628211ull;
+		}
+		return Hash;
+	}
+}   // namespace Fling
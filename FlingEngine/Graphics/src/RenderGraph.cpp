@@ -0,0 +1,814 @@
+#include "pch.h"
+#include "RenderGraph.h"
+#include "LogicalDevice.h"
+#include "GraphicsHelpers.h"
+
+#include <algorithm>
+
+namespace Fling
+{
+	namespace
+	{
+		/** What the GPU does to a texture for a usage */
+		struct UsageInfo
+		{
+			VkPipelineStageFlags Stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			VkAccessFlags Access = 0;
+			VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkImageUsageFlags ImageUsage = 0;
+		};
+
+		const VkAccessFlags WriteAccessMask =
+			VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+			VK_ACCESS_SHADER_WRITE_BIT |
+			VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		UsageInfo GetUsageInfo(RenderGraphUsage t_Usage)
+		{
+			const VkPipelineStageFlags ShaderStages =
+				VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			const VkPipelineStageFlags DepthStages =
+				VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+			UsageInfo Info = {};
+			switch (t_Usage)
+			{
+			case RenderGraphUsage::ColorAttachment:
+				Info.Stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+				Info.Access = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+				Info.Layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+				Info.ImageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+				break;
+			case RenderGraphUsage::DepthAttachment:
+				Info.Stages = DepthStages;
+				Info.Access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+				Info.Layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+				Info.ImageUsage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+				break;
+			case RenderGraphUsage::DepthRead:
+				Info.Stages = DepthStages | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+				Info.Access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+				Info.Layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+				Info.ImageUsage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+				break;
+			case RenderGraphUsage::ShaderRead:
+				Info.Stages = ShaderStages;
+				Info.Access = VK_ACCESS_SHADER_READ_BIT;
+				Info.Layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				Info.ImageUsage = VK_IMAGE_USAGE_SAMPLED_BIT;
+				break;
+			case RenderGraphUsage::StorageRead:
+				Info.Stages = ShaderStages;
+				Info.Access = VK_ACCESS_SHADER_READ_BIT;
+				Info.Layout = VK_IMAGE_LAYOUT_GENERAL;
+				Info.ImageUsage = VK_IMAGE_USAGE_STORAGE_BIT;
+				break;
+			case RenderGraphUsage::StorageWrite:
+				Info.Stages = ShaderStages;
+				Info.Access = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+				Info.Layout = VK_IMAGE_LAYOUT_GENERAL;
+				Info.ImageUsage = VK_IMAGE_USAGE_STORAGE_BIT;
+				break;
+			case RenderGraphUsage::TransferSrc:
+				Info.Stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+				Info.Access = VK_ACCESS_TRANSFER_READ_BIT;
+				Info.Layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+				Info.ImageUsage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+				break;
+			case RenderGraphUsage::TransferDst:
+				Info.Stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+				Info.Access = VK_ACCESS_TRANSFER_WRITE_BIT;
+				Info.Layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				Info.ImageUsage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+				break;
+			case RenderGraphUsage::Present:
+				Info.Stages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+				Info.Layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+				break;
+			default:
+				break;
+			}
+			return Info;
+		}
+
+		bool IsAttachment(RenderGraphUsage t_Usage)
+		{
+			return t_Usage == RenderGraphUsage::ColorAttachment || t_Usage == RenderGraphUsage::DepthAttachment;
+		}
+
+		VkImageAspectFlags GetAspect(VkFormat t_Format)
+		{
+			switch (t_Format)
+			{
+			case VK_FORMAT_D16_UNORM:
+			case VK_FORMAT_X8_D24_UNORM_PACK32:
+			case VK_FORMAT_D32_SFLOAT:
+				return VK_IMAGE_ASPECT_DEPTH_BIT;
+			case VK_FORMAT_D16_UNORM_S8_UINT:
+			case VK_FORMAT_D24_UNORM_S8_UINT:
+			case VK_FORMAT_D32_SFLOAT_S8_UINT:
+				return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+			default:
+				return VK_IMAGE_ASPECT_COLOR_BIT;
+			}
+		}
+
+		/** Synchronization state of a texture while walking the passes in execution order */
+		struct TextureState
+		{
+			bool Touched = false;
+			VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			RenderGraphUsage Usage = RenderGraphUsage::Undefined;
+			UINT32 LastPass = UINT32_MAX;
+
+			/** Stages and access of the last write, and of the layout transitions since then */
+			VkPipelineStageFlags WriteStages = 0;
+			VkAccessFlags WriteAccess = 0;
+
+			/** Stages that have read the texture since the last write */
+			VkPipelineStageFlags ReadStages = 0;
+
+			/** Stages and access that the last write has been made visible to */
+			VkPipelineStageFlags VisibleStages = 0;
+			VkAccessFlags VisibleAccess = 0;
+		};
+	}   // namespace
+
+	RenderGraph::~RenderGraph()
+	{
+		DestroyTransientResources();
+	}
+
+	UINT32 RenderGraph::AddPass(const std::string& t_Name, bool t_HasSideEffects)
+	{
+		RenderGraphPass Pass = {};
+		Pass.Name = t_Name;
+		Pass.HasSideEffects = t_HasSideEffects;
+		m_Passes.emplace_back(std::move(Pass));
+		return static_cast<UINT32>(m_Passes.size() - 1);
+	}
+
+	RenderGraphResource RenderGraph::CreateTexture(const std::string& t_Name, const RenderGraphTextureDesc& t_Desc)
+	{
+		assert(!FindTexture(t_Name).IsValid() && "Render graph textures need unique names");
+
+		RenderGraphTexture Tex = {};
+		Tex.Name = t_Name;
+		Tex.Desc = t_Desc;
+		Tex.Aspect = GetAspect(t_Desc.Format);
+		m_Textures.emplace_back(std::move(Tex));
+
+		RenderGraphResource Handle = {};
+		Handle.Index = static_cast<UINT32>(m_Textures.size() - 1);
+		return Handle;
+	}
+
+	RenderGraphResource RenderGraph::ImportTexture(
+		const std::string& t_Name,
+		const RenderGraphTextureDesc& t_Desc,
+		VkImage t_Image,
+		VkImageAspectFlags t_Aspect,
+		RenderGraphUsage t_InitialUsage)
+	{
+		RenderGraphResource Handle = CreateTexture(t_Name, t_Desc);
+		RenderGraphTexture& Tex = m_Textures[Handle.Index];
+		Tex.IsImported = true;
+		Tex.InitialUsage = t_InitialUsage;
+		Tex.Image = t_Image;
+		Tex.Aspect = t_Aspect;
+		return Handle;
+	}
+
+	RenderGraphResource RenderGraph::FindTexture(const std::string& t_Name) const
+	{
+		RenderGraphResource Handle = {};
+		for (size_t i = 0; i < m_Textures.size(); ++i)
+		{
+			if (m_Textures[i].Name == t_Name)
+			{
+				Handle.Index = static_cast<UINT32>(i);
+				Handle.Version = m_Textures[i].VersionCount - 1;
+				break;
+			}
+		}
+		return Handle;
+	}
+
+	void RenderGraph::Read(UINT32 t_Pass, RenderGraphResource t_Texture, RenderGraphUsage t_Usage)
+	{
+		assert(t_Pass < m_Passes.size() && t_Texture.IsValid() && t_Texture.Index < m_Textures.size());
+		assert(t_Texture.Version < m_Textures[t_Texture.Index].VersionCount);
+		assert(IsReadOnly(t_Usage) && "Use Write for usages that change the texture");
+
+		RenderGraphAccess Access = {};
+		Access.Texture = t_Texture.Index;
+		Access.Version = t_Texture.Version;
+		Access.Usage = t_Usage;
+		m_Passes[t_Pass].Accesses.emplace_back(Access);
+	}
+
+	RenderGraphResource RenderGraph::Write(UINT32 t_Pass, RenderGraphResource t_Texture, RenderGraphUsage t_Usage, RenderGraphUsage t_EndUsage)
+	{
+		assert(t_Pass < m_Passes.size() && t_Texture.IsValid() && t_Texture.Index < m_Textures.size());
+		assert(!IsReadOnly(t_Usage) && "Use Read for usages that don't change the texture");
+
+		RenderGraphTexture& Tex = m_Textures[t_Texture.Index];
+		assert(t_Texture.Version == Tex.VersionCount - 1 && "Only the latest version of a texture can be written");
+
+		RenderGraphAccess Access = {};
+		Access.Texture = t_Texture.Index;
+		Access.Version = t_Texture.Version;
+		Access.Usage = t_Usage;
+		Access.EndUsage = t_EndUsage;
+		Access.IsWrite = true;
+		m_Passes[t_Pass].Accesses.emplace_back(Access);
+
+		RenderGraphResource NewVersion = t_Texture;
+		NewVersion.Version = Tex.VersionCount++;
+		return NewVersion;
+	}
+
+	bool RenderGraph::Compile()
+	{
+		for (RenderGraphPass& Pass : m_Passes)
+		{
+			Pass.IsCulled = false;
+			Pass.Level = 0;
+			Pass.Barriers.clear();
+		}
+
+		for (RenderGraphTexture& Tex : m_Textures)
+		{
+			Tex.FirstUse = UINT32_MAX;
+			Tex.LastUse = 0;
+			Tex.ImageUsage = 0;
+			Tex.MemoryOffset = 0;
+			Tex.AliasedTextures.clear();
+		}
+
+		// Which pass wrote and read each version of every texture
+		std::vector<std::vector<UINT32>> Writers(m_Textures.size());
+		std::vector<std::vector<std::vector<UINT32>>> Readers(m_Textures.size());
+		for (size_t t = 0; t < m_Textures.size(); ++t)
+		{
+			Writers[t].resize(m_Textures[t].VersionCount, UINT32_MAX);
+			Readers[t].resize(m_Textures[t].VersionCount);
+		}
+
+		for (UINT32 p = 0; p < m_Passes.size(); ++p)
+		{
+			for (const RenderGraphAccess& Access : m_Passes[p].Accesses)
+			{
+				if (Access.IsWrite)
+				{
+					Writers[Access.Texture][Access.Version + 1] = p;
+				}
+				else
+				{
+					Readers[Access.Texture][Access.Version].emplace_back(p);
+				}
+			}
+		}
+
+		// A pass depends on the writer of every version it uses. Data dependencies are the ones
+		// that need the contents, writers also have to wait for earlier readers of the version they replace
+		std::vector<std::vector<UINT32>> Deps(m_Passes.size());
+		std::vector<std::vector<UINT32>> DataDeps(m_Passes.size());
+		for (UINT32 p = 0; p < m_Passes.size(); ++p)
+		{
+			for (const RenderGraphAccess& Access : m_Passes[p].Accesses)
+			{
+				const UINT32 Writer = Writers[Access.Texture][Access.Version];
+				if (Writer != UINT32_MAX && Writer != p)
+				{
+					Deps[p].emplace_back(Writer);
+					DataDeps[p].emplace_back(Writer);
+				}
+
+				if (Access.IsWrite)
+				{
+					for (UINT32 Reader : Readers[Access.Texture][Access.Version])
+					{
+						if (Reader != p)
+						{
+							Deps[p].emplace_back(Reader);
+						}
+					}
+				}
+			}
+
+			std::sort(Deps[p].begin(), Deps[p].end());
+			Deps[p].erase(std::unique(Deps[p].begin(), Deps[p].end()), Deps[p].end());
+		}
+
+		CullPasses(DataDeps);
+
+		if (!SortPasses(Deps))
+		{
+			F_LOG_ERROR("Render graph passes depend on each other in a cycle!");
+			return false;
+		}
+
+		// Lifetimes and image usage of every texture
+		for (UINT32 Pos = 0; Pos < m_ExecutionOrder.size(); ++Pos)
+		{
+			for (const RenderGraphAccess& Access : m_Passes[m_ExecutionOrder[Pos]].Accesses)
+			{
+				RenderGraphTexture& Tex = m_Textures[Access.Texture];
+				Tex.FirstUse = std::min(Tex.FirstUse, Pos);
+				Tex.LastUse = std::max(Tex.LastUse, Pos);
+				Tex.ImageUsage |= GetUsageInfo(Access.Usage).ImageUsage;
+			}
+		}
+
+		AliasTransientMemory();
+		PlaceBarriers();
+
+		return true;
+	}
+
+	void RenderGraph::CullPasses(const std::vector<std::vector<UINT32>>& t_DataDeps)
+	{
+		std::vector<UINT32> Stack;
+		std::vector<bool> Needed(m_Passes.size(), false);
+
+		for (UINT32 p = 0; p < m_Passes.size(); ++p)
+		{
+			bool IsRoot = m_Passes[p].HasSideEffects;
+			for (const RenderGraphAccess& Access : m_Passes[p].Accesses)
+			{
+				IsRoot |= Access.IsWrite && m_Textures[Access.Texture].IsImported;
+			}
+
+			if (IsRoot)
+			{
+				Needed[p] = true;
+				Stack.emplace_back(p);
+			}
+		}
+
+		while (!Stack.empty())
+		{
+			const UINT32 Pass = Stack.back();
+			Stack.pop_back();
+
+			for (UINT32 Dep : t_DataDeps[Pass])
+			{
+				if (!Needed[Dep])
+				{
+					Needed[Dep] = true;
+					Stack.emplace_back(Dep);
+				}
+			}
+		}
+
+		for (UINT32 p = 0; p < m_Passes.size(); ++p)
+		{
+			m_Passes[p].IsCulled = !Needed[p];
+		}
+	}
+
+	bool RenderGraph::SortPasses(const std::vector<std::vector<UINT32>>& t_Deps)
+	{
+		m_ExecutionOrder.clear();
+		m_Levels.clear();
+
+		// Kahn's algorithm, the level of a pass is the longest chain of passes before it
+		std::vector<UINT32> InDegree(m_Passes.size(), 0);
+		std::vector<std::vector<UINT32>> Dependents(m_Passes.size());
+		std::vector<UINT32> Ready;
+		UINT32 AliveCount = 0;
+
+		for (UINT32 p = 0; p < m_Passes.size(); ++p)
+		{
+			if (m_Passes[p].IsCulled)
+			{
+				continue;
+			}
+
+			++AliveCount;
+			for (UINT32 Dep : t_Deps[p])
+			{
+				if (!m_Passes[Dep].IsCulled)
+				{
+					++InDegree[p];
+					Dependents[Dep].emplace_back(p);
+				}
+			}
+
+			if (InDegree[p] == 0)
+			{
+				Ready.emplace_back(p);
+			}
+		}
+
+		std::vector<UINT32> Sorted;
+		Sorted.reserve(AliveCount);
+		while (!Ready.empty())
+		{
+			const UINT32 Pass = Ready.back();
+			Ready.pop_back();
+			Sorted.emplace_back(Pass);
+
+			for (UINT32 Dependent : Dependents[Pass])
+			{
+				m_Passes[Dependent].Level = std::max(m_Passes[Dependent].Level, m_Passes[Pass].Level + 1);
+				if (--InDegree[Dependent] == 0)
+				{
+					Ready.emplace_back(Dependent);
+				}
+			}
+		}
+
+		if (Sorted.size() != AliveCount)
+		{
+			return false;
+		}
+
+		// Run level by level so that passes that can be recorded together are next to each other,
+		// passes on the same level keep the order they were added in
+		std::sort(Sorted.begin(), Sorted.end(), [this](UINT32 A, UINT32 B)
+		{
+			return m_Passes[A].Level != m_Passes[B].Level ? m_Passes[A].Level < m_Passes[B].Level : A < B;
+		});
+
+		m_ExecutionOrder = std::move(Sorted);
+		for (UINT32 Pass : m_ExecutionOrder)
+		{
+			const UINT32 Level = m_Passes[Pass].Level;
+			if (Level >= m_Levels.size())
+			{
+				m_Levels.resize(Level + 1);
+			}
+			m_Levels[Level].emplace_back(Pass);
+		}
+
+		return true;
+	}
+
+	void RenderGraph::AliasTransientMemory()
+	{
+		m_TransientMemorySize = 0;
+
+		std::vector<UINT32> Transients;
+		for (UINT32 t = 0; t < m_Textures.size(); ++t)
+		{
+			if (!m_Textures[t].IsImported && m_Textures[t].IsUsed())
+			{
+				Transients.emplace_back(t);
+			}
+		}
+
+		std::sort(Transients.begin(), Transients.end(), [this](UINT32 A, UINT32 B)
+		{
+			return m_Textures[A].FirstUse != m_Textures[B].FirstUse ? m_Textures[A].FirstUse < m_Textures[B].FirstUse : A < B;
+		});
+
+		// Greedy first fit: place each texture in the lowest gap between the textures that are
+		// still alive when it is first used. Memory of textures that are already dead is reused
+		std::vector<UINT32> Placed;
+		std::vector<UINT32> Live;
+		for (UINT32 t : Transients)
+		{
+			RenderGraphTexture& Tex = m_Textures[t];
+			const VkDeviceSize Alignment = std::max<VkDeviceSize>(Tex.Desc.Alignment, 1);
+
+			Live.clear();
+			for (UINT32 Other : Placed)
+			{
+				if (m_Textures[Other].LastUse >= Tex.FirstUse)
+				{
+					Live.emplace_back(Other);
+				}
+			}
+
+			std::sort(Live.begin(), Live.end(), [this](UINT32 A, UINT32 B) { return m_Textures[A].MemoryOffset < m_Textures[B].MemoryOffset; });
+
+			VkDeviceSize Offset = 0;
+			for (UINT32 Other : Live)
+			{
+				const RenderGraphTexture& OtherTex = m_Textures[Other];
+				if (Offset + Tex.Desc.Size <= OtherTex.MemoryOffset)
+				{
+					break;
+				}
+				const VkDeviceSize End = OtherTex.MemoryOffset + OtherTex.Desc.Size;
+				Offset = std::max(Offset, (End + Alignment - 1) / Alignment * Alignment);
+			}
+
+			Tex.MemoryOffset = Offset;
+			m_TransientMemorySize = std::max(m_TransientMemorySize, Offset + Tex.Desc.Size);
+
+			// Dead textures that overlap this range have to finish before this one can use it
+			for (UINT32 Other : Placed)
+			{
+				const RenderGraphTexture& OtherTex = m_Textures[Other];
+				const bool Overlaps = OtherTex.MemoryOffset < Offset + Tex.Desc.Size && Offset < OtherTex.MemoryOffset + OtherTex.Desc.Size;
+				if (Overlaps && OtherTex.LastUse < Tex.FirstUse)
+				{
+					Tex.AliasedTextures.emplace_back(Other);
+				}
+			}
+
+			Placed.emplace_back(t);
+		}
+	}
+
+	void RenderGraph::PlaceBarriers()
+	{
+		std::vector<TextureState> States(m_Textures.size());
+
+		for (UINT32 Pass : m_ExecutionOrder)
+		{
+			RenderGraphPass& GraphPass = m_Passes[Pass];
+			for (const RenderGraphAccess& Access : GraphPass.Accesses)
+			{
+				const RenderGraphTexture& Tex = m_Textures[Access.Texture];
+				const UsageInfo Info = GetUsageInfo(Access.Usage);
+				TextureState& State = States[Access.Texture];
+
+				RenderGraphBarrier Barrier = {};
+				Barrier.Texture = Access.Texture;
+				Barrier.DstStages = Info.Stages;
+				Barrier.DstAccess = Info.Access;
+				Barrier.NewLayout = Info.Layout;
+				bool IsNeeded = false;
+
+				if (!State.Touched && Tex.IsImported && Tex.InitialUsage != RenderGraphUsage::Undefined)
+				{
+					// Start from whatever left the texture in its initial usage
+					const UsageInfo Initial = GetUsageInfo(Tex.InitialUsage);
+					State.Touched = true;
+					State.Layout = Initial.Layout;
+					State.Usage = Tex.InitialUsage;
+					if (IsReadOnly(Tex.InitialUsage))
+					{
+						State.ReadStages = Initial.Stages;
+					}
+					else
+					{
+						State.WriteStages = Initial.Stages;
+						State.WriteAccess = Initial.Access & WriteAccessMask;
+					}
+				}
+
+				if (!State.Touched)
+				{
+					// The contents are undefined. Render passes discard attachments like this on their
+					// own, anything else needs a transition out of the undefined layout
+					Barrier.OldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+					for (UINT32 Aliased : Tex.AliasedTextures)
+					{
+						Barrier.SrcStages |= States[Aliased].WriteStages | States[Aliased].ReadStages;
+						Barrier.SrcAccess |= States[Aliased].WriteAccess;
+					}
+					IsNeeded = !Tex.AliasedTextures.empty() || !IsAttachment(Access.Usage);
+				}
+				else
+				{
+					Barrier.SrcPass = State.LastPass;
+					Barrier.OldLayout = State.Layout;
+
+					const bool LayoutChanges = State.Layout != Info.Layout;
+					const bool PendingWrite = State.WriteStages != 0 &&
+						((Info.Stages & ~State.VisibleStages) != 0 || (Info.Access & ~State.VisibleAccess) != 0);
+					const bool WriteAfterRead = Access.IsWrite && State.ReadStages != 0;
+
+					// Attachments that stay in the same layout are ordered by the render pass dependencies
+					const bool SameAttachment = IsAttachment(Access.Usage) && State.Usage == Access.Usage && !LayoutChanges;
+
+					if (!SameAttachment && (LayoutChanges || PendingWrite || WriteAfterRead))
+					{
+						IsNeeded = true;
+						if (LayoutChanges || PendingWrite)
+						{
+							Barrier.SrcStages |= State.WriteStages;
+							Barrier.SrcAccess |= State.WriteAccess;
+						}
+						if (LayoutChanges || WriteAfterRead)
+						{
+							Barrier.SrcStages |= State.ReadStages;
+						}
+					}
+				}
+
+				if (IsNeeded)
+				{
+					if (Barrier.SrcStages == 0)
+					{
+						Barrier.SrcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+					}
+
+					State.VisibleStages |= Barrier.DstStages;
+					State.VisibleAccess |= Barrier.DstAccess;
+
+					// A layout transition is a write, later barriers have to chain after it
+					if (Barrier.OldLayout != Barrier.NewLayout)
+					{
+						State.WriteStages |= Barrier.DstStages;
+						State.ReadStages = 0;
+					}
+
+					GraphPass.Barriers.emplace_back(Barrier);
+				}
+
+				State.Touched = true;
+				State.LastPass = Pass;
+				State.Usage = Access.Usage;
+				State.Layout = Info.Layout;
+
+				if (Access.IsWrite)
+				{
+					State.WriteStages = Info.Stages;
+					State.WriteAccess = Info.Access & WriteAccessMask;
+					State.ReadStages = 0;
+					State.VisibleStages = 0;
+					State.VisibleAccess = 0;
+				}
+				else
+				{
+					State.ReadStages |= Info.Stages;
+				}
+
+				if (Access.EndUsage != RenderGraphUsage::Undefined)
+				{
+					State.Usage = Access.EndUsage;
+					State.Layout = GetUsageInfo(Access.EndUsage).Layout;
+				}
+			}
+		}
+	}
+
+	void RenderGraph::CreateTransientResources(const LogicalDevice* t_Device, DeviceMemoryAllocator* t_Allocator)
+	{
+		assert(t_Device && t_Allocator);
+		DestroyTransientResources();
+
+		m_Device = t_Device;
+		m_Allocator = t_Allocator;
+		VkDevice Device = m_Device->GetVkDevice();
+
+		VkMemoryRequirements HeapReqs = {};
+		HeapReqs.alignment = 1;
+		HeapReqs.memoryTypeBits = ~0u;
+		bool HasTransients = false;
+
+		for (RenderGraphTexture& Tex : m_Textures)
+		{
+			if (Tex.IsImported || !Tex.IsUsed())
+			{
+				continue;
+			}
+
+			VkImageCreateInfo ImageInfo = {};
+			ImageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			ImageInfo.imageType = VK_IMAGE_TYPE_2D;
+			ImageInfo.format = Tex.Desc.Format;
+			ImageInfo.extent = { Tex.Desc.Width, Tex.Desc.Height, 1 };
+			ImageInfo.mipLevels = 1;
+			ImageInfo.arrayLayers = 1;
+			ImageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			ImageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			ImageInfo.usage = Tex.ImageUsage;
+			ImageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			ImageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VK_CHECK_RESULT(vkCreateImage(Device, &ImageInfo, nullptr, &Tex.Image));
+
+			VkMemoryRequirements Reqs = {};
+			vkGetImageMemoryRequirements(Device, Tex.Image, &Reqs);
+			Tex.Desc.Size = Reqs.size;
+			Tex.Desc.Alignment = Reqs.alignment;
+
+			HeapReqs.alignment = std::max(HeapReqs.alignment, Reqs.alignment);
+			HeapReqs.memoryTypeBits &= Reqs.memoryTypeBits;
+			HasTransients = true;
+		}
+
+		if (!HasTransients)
+		{
+			return;
+		}
+
+		// Now that the real sizes are known, alias them again
+		Compile();
+		HeapReqs.size = m_TransientMemorySize;
+
+		if (HeapReqs.memoryTypeBits == 0 ||
+			!m_Allocator->Allocate(HeapReqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ResourceLayout::Optimal, m_TransientMemory))
+		{
+			F_LOG_FATAL("Failed to allocate {} bytes of transient render graph memory", HeapReqs.size);
+		}
+
+		for (RenderGraphTexture& Tex : m_Textures)
+		{
+			if (Tex.IsImported || Tex.Image == VK_NULL_HANDLE)
+			{
+				continue;
+			}
+
+			VK_CHECK_RESULT(vkBindImageMemory(Device, Tex.Image, m_TransientMemory.Memory, m_TransientMemory.Offset + Tex.MemoryOffset));
+			Tex.View = GraphicsHelpers::CreateVkImageView(Tex.Image, Tex.Desc.Format, (Tex.Aspect & VK_IMAGE_ASPECT_DEPTH_BIT) ? VK_IMAGE_ASPECT_DEPTH_BIT : Tex.Aspect);
+		}
+
+		F_LOG_TRACE("Render graph transient memory is {} bytes", m_TransientMemorySize);
+	}
+
+	void RenderGraph::DestroyTransientResources()
+	{
+		if (!m_Device)
+		{
+			return;
+		}
+
+		VkDevice Device = m_Device->GetVkDevice();
+		for (RenderGraphTexture& Tex : m_Textures)
+		{
+			if (Tex.IsImported)
+			{
+				continue;
+			}
+
+			if (Tex.View != VK_NULL_HANDLE)
+			{
+				vkDestroyImageView(Device, Tex.View, nullptr);
+				Tex.View = VK_NULL_HANDLE;
+			}
+
+			if (Tex.Image != VK_NULL_HANDLE)
+			{
+				vkDestroyImage(Device, Tex.Image, nullptr);
+				Tex.Image = VK_NULL_HANDLE;
+			}
+		}
+
+		if (m_TransientMemory.IsValid())
+		{
+			m_Allocator->Free(m_TransientMemory);
+		}
+	}
+
+	void RenderGraph::SetImage(RenderGraphResource t_Texture, VkImage t_Image)
+	{
+		assert(t_Texture.IsValid() && m_Textures[t_Texture.Index].IsImported);
+		m_Textures[t_Texture.Index].Image = t_Image;
+	}
+
+	void RenderGraph::RecordBarriers(VkCommandBuffer t_CmdBuf, UINT32 t_Pass) const
+	{
+		assert(t_Pass < m_Passes.size());
+
+		std::vector<VkImageMemoryBarrier> ImageBarriers;
+		VkPipelineStageFlags SrcStages = 0;
+		VkPipelineStageFlags DstStages = 0;
+
+		for (const RenderGraphBarrier& Barrier : m_Passes[t_Pass].Barriers)
+		{
+			const RenderGraphTexture& Tex = m_Textures[Barrier.Texture];
+			if (Tex.Image == VK_NULL_HANDLE)
+			{
+				continue;
+			}
+
+			VkImageMemoryBarrier ImageBarrier = {};
+			ImageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			ImageBarrier.srcAccessMask = Barrier.SrcAccess;
+			ImageBarrier.dstAccessMask = Barrier.DstAccess;
+			ImageBarrier.oldLayout = Barrier.OldLayout;
+			ImageBarrier.newLayout = Barrier.NewLayout;
+			ImageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			ImageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			ImageBarrier.image = Tex.Image;
+			ImageBarrier.subresourceRange = { Tex.Aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+			ImageBarriers.emplace_back(ImageBarrier);
+
+			SrcStages |= Barrier.SrcStages;
+			DstStages |= Barrier.DstStages;
+		}
+
+		if (!ImageBarriers.empty())
+		{
+			vkCmdPipelineBarrier(t_CmdBuf, SrcStages, DstStages, 0, 0, nullptr, 0, nullptr, static_cast<UINT32>(ImageBarriers.size()), ImageBarriers.data());
+		}
+	}
+
+	bool RenderGraph::IsReadOnly(RenderGraphUsage t_Usage)
+	{
+		switch (t_Usage)
+		{
+		case RenderGraphUsage::DepthRead:
+		case RenderGraphUsage::ShaderRead:
+		case RenderGraphUsage::StorageRead:
+		case RenderGraphUsage::TransferSrc:
+		case RenderGraphUsage::Present:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	VkImageLayout RenderGraph::GetLayout(RenderGraphUsage t_Usage)
+	{
+		return GetUsageInfo(t_Usage).Layout;
+	}
+}   // namespace Fling
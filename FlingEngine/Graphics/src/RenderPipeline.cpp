@@ -5,26 +5,47 @@
 #include "SwapChain.h"
 #include "FrameBuffer.h"
 #include "MeshRenderer.h"
+#include "JobSystem.h"
+#include "VulkanApp.h"
 
 namespace Fling
 {
-	RenderPipeline::RenderPipeline(entt::registry& t_Reg, LogicalDevice* t_Dev, Swapchain* t_Swap, std::vector<std::unique_ptr<Subpass>>& t_Subpasses)
+	RenderPipeline::RenderPipeline(entt::registry& t_Reg, LogicalDevice* t_Dev, Swapchain* t_Swap, DeviceMemoryAllocator* t_Allocator, std::vector<std::unique_ptr<Subpass>>& t_Subpasses)
 		: m_Subpasses ( std::move(t_Subpasses) )
 		, m_Device(t_Dev)
 		, m_SwapChain(t_Swap)
 	{
 		assert(m_Device && m_SwapChain);
 
-		// Create the graphics pipelines on each subpass now that we have render passes for them
+		// Create the graphics pipelines on each subpass now that we have render passes for them.
+		// The pipelines of different subpasses don't depend on each other, so the driver can compile them at the same time
+		std::vector<Subpass*> ParallelSubpasses;
 		for (const std::unique_ptr<Subpass>& pass : m_Subpasses)
 		{	
-			pass->CreateGraphicsPipeline();	
+			if (pass->CanCreatePipelineInParallel())
+			{
+				ParallelSubpasses.emplace_back(pass.get());
+			}
+			else
+			{
+				pass->CreateGraphicsPipeline();
+			}
 		}
+
+		JobSystem::ParallelFor(static_cast<UINT32>(ParallelSubpasses.size()), 1, [&](UINT32 t_Begin, UINT32 t_End)
+		{
+			for (UINT32 i = t_Begin; i < t_End; ++i)
+			{
+				ParallelSubpasses[i]->CreateGraphicsPipeline();
+			}
+		});
 		F_LOG_TRACE("Render pipeline Graphics Pipelines created...");
 
 		// Build Descriptor sets -------
 		CreateDescriptors(t_Reg);
 
+		BuildRenderGraph(t_Allocator);
+
 		F_LOG_TRACE("Render pipeline Creation done!");
 	}
 
@@ -38,36 +59,77 @@ namespace Fling
 		m_Subpasses.clear();
 	}
 
-	void RenderPipeline::Draw(CommandBuffer& t_CmdBuf, VkFramebuffer t_PresentFrameBuf, UINT32 t_ActiveFrameInFlight, entt::registry& t_Reg, float DeltaTime)
+	void RenderPipeline::RecordCommandBuffers(UINT32 t_ActiveFrame, entt::registry& t_Reg, float DeltaTime)
 	{
-		assert(!m_Subpasses.empty() && "Render pipeline should contain at least one sub-pass");
+		std::vector<Subpass*> LevelSubpasses;
+		for (const std::vector<UINT32>& Level : m_RenderGraph.GetLevels())
+		{
+			LevelSubpasses.clear();
+			for (UINT32 Pass : Level)
+			{
+				if (m_PassSubpasses[Pass]->GetCommandBuffer(t_ActiveFrame))
+				{
+					LevelSubpasses.emplace_back(m_PassSubpasses[Pass]);
+				}
+			}
+
+			auto RecordSubpass = [&](Subpass* t_Subpass)
+			{
+				CommandBuffer* CmdBuf = t_Subpass->GetCommandBuffer(t_ActiveFrame);
+				t_Subpass->Draw(*CmdBuf, VK_NULL_HANDLE, t_ActiveFrame, t_Reg, DeltaTime);
+			};
+
+			if (LevelSubpasses.size() == 1)
+			{
+				RecordSubpass(LevelSubpasses[0]);
+			}
+			else if (LevelSubpasses.size() > 1)
+			{
+				JobSystem::ParallelFor(static_cast<UINT32>(LevelSubpasses.size()), 1, [&](UINT32 t_Begin, UINT32 t_End)
+				{
+					for (UINT32 i = t_Begin; i < t_End; ++i)
+					{
+						RecordSubpass(LevelSubpasses[i]);
+					}
+				});
+			}
+		}
+	}
+
+	void RenderPipeline::RecordBarriers(CommandBuffer& t_CmdBuf, UINT32 t_ActiveSwapImage)
+	{
+		m_RenderGraph.SetImage(m_Backbuffer, m_SwapChain->GetImages()[t_ActiveSwapImage]);
+
+		for (UINT32 Pass : m_InlinePasses)
+		{
+			m_RenderGraph.RecordBarriers(t_CmdBuf.GetHandle(), Pass);
+		}
+	}
 
-		for (size_t i = 0; i < m_Subpasses.size(); ++i)
+	void RenderPipeline::Draw(CommandBuffer& t_CmdBuf, VkFramebuffer t_PresentFrameBuf, UINT32 t_ActiveFrame, entt::registry& t_Reg, float DeltaTime)
+	{
+		for (UINT32 Pass : m_InlinePasses)
 		{
-			// Build the subpasses for the active frame in flight	
-			m_Subpasses[i]->Draw(
+			m_PassSubpasses[Pass]->Draw(
 				t_CmdBuf, 
 				t_PresentFrameBuf,
-				t_ActiveFrameInFlight, 
+				t_ActiveFrame, 
 				t_Reg,
 				DeltaTime
 			);
 		}
 	}
 
-	void RenderPipeline::GatherPresentDependencies(std::vector<CommandBuffer*>& t_CmdBuffs, std::vector<VkSemaphore>& t_Deps, UINT32 t_ActiveFrameIndex, UINT32 t_CurrentFrameInFlight)
+	void RenderPipeline::GatherCommandBuffers(std::vector<CommandBuffer*>& t_Before, std::vector<CommandBuffer*>& t_After, UINT32 t_ActiveFrame)
 	{
-		for (const auto& subpass : m_Subpasses)
+		for (UINT32 Pass : m_PassesBefore)
 		{
-			subpass->GatherPresentDependencies(t_CmdBuffs, t_Deps, t_ActiveFrameIndex, t_CurrentFrameInFlight);
+			t_Before.emplace_back(m_PassSubpasses[Pass]->GetCommandBuffer(t_ActiveFrame));
 		}
-	}
 
-	void RenderPipeline::GatherPresentBuffers(std::vector<CommandBuffer*>& t_CmdBuffs, UINT32 t_ActiveFrameIndex)
-	{
-		for (const auto& subpass : m_Subpasses)
+		for (UINT32 Pass : m_PassesAfter)
 		{
-			subpass->GatherPresentBuffers(t_CmdBuffs, t_ActiveFrameIndex);
+			t_After.emplace_back(m_PassSubpasses[Pass]->GetCommandBuffer(t_ActiveFrame));
 		}
 	}
 
@@ -79,10 +141,21 @@ namespace Fling
 		}
 	}
 
+	DrawListStats RenderPipeline::GetDrawStats() const
+	{
+		DrawListStats Stats = {};
+		for (const auto& Sub : m_Subpasses)
+		{
+			Stats += Sub->GetDrawStats();
+		}
+		return Stats;
+	}
+
 	void RenderPipeline::CreateDescriptors(entt::registry& t_Reg)
 	{
 		// Create the descriptor pool for us to use -------
-		const UINT32 SwapImageCount = static_cast<UINT32>(m_SwapChain->GetImageCount());
+		// Subpasses allocate a set for each frame in flight from this pool
+		const UINT32 FrameCount = VulkanApp::Get().GetFramesInFlight();
 		UINT32 DescriptorCount = 1024;
 
 		std::vector<VkDescriptorPoolSize> poolSizes =
@@ -98,7 +171,7 @@ namespace Fling
 		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 		poolInfo.poolSizeCount = static_cast<UINT32>(poolSizes.size());
 		poolInfo.pPoolSizes = poolSizes.data();
-		poolInfo.maxSets = SwapImageCount;
+		poolInfo.maxSets = FrameCount;
 
 		VK_CHECK_RESULT(vkCreateDescriptorPool(m_Device->GetVkDevice(), &poolInfo, nullptr, &m_DescriptorPool));
 
@@ -110,4 +183,69 @@ namespace Fling
 			Pass->CreateDescriptorSets(m_DescriptorPool, t_Reg);
 		}
 	}
+
+	void RenderPipeline::BuildRenderGraph(DeviceMemoryAllocator* t_Allocator)
+	{
+		RenderGraphTextureDesc BackbufferDesc = {};
+		BackbufferDesc.Width = m_SwapChain->GetExtents().width;
+		BackbufferDesc.Height = m_SwapChain->GetExtents().height;
+		BackbufferDesc.Format = m_SwapChain->GetImageFormat();
+		m_Backbuffer = m_RenderGraph.ImportTexture(Subpass::BackbufferName, BackbufferDesc);
+
+		for (std::unique_ptr<Subpass>& Pass : m_Subpasses)
+		{
+			const UINT32 GraphPass = m_RenderGraph.AddPass(Pass->GetName());
+			Pass->DeclareResources(m_RenderGraph, GraphPass);
+			m_PassSubpasses.emplace_back(Pass.get());
+		}
+
+		if (!m_RenderGraph.Compile())
+		{
+			F_LOG_FATAL("Failed to compile the render graph!");
+		}
+
+		m_RenderGraph.CreateTransientResources(m_Device, t_Allocator);
+
+		for (UINT32 Pass = 0; Pass < m_RenderGraph.GetPassCount(); ++Pass)
+		{
+			if (m_RenderGraph.GetPass(Pass).IsCulled)
+			{
+				F_LOG_WARN("Render graph pass '{}' is not needed and will not be drawn", m_RenderGraph.GetPass(Pass).Name);
+			}
+		}
+
+		// Everything that draws into the swap chain shares one render pass, so those passes have to be next
+		// to each other and can't need barriers between each other
+		std::vector<bool> IsInline(m_RenderGraph.GetPassCount(), false);
+		for (UINT32 Pass : m_RenderGraph.GetExecutionOrder())
+		{
+			const RenderGraphPass& GraphPass = m_RenderGraph.GetPass(Pass);
+
+			if (m_PassSubpasses[Pass]->GetCommandBuffer(0))
+			{
+				(m_InlinePasses.empty() ? m_PassesBefore : m_PassesAfter).emplace_back(Pass);
+				continue;
+			}
+
+			if (!m_PassesAfter.empty())
+			{
+				F_LOG_ERROR("Render graph pass '{}' has to run after '{}', which is outside of the swap chain render pass",
+					GraphPass.Name, m_RenderGraph.GetPass(m_PassesAfter.back()).Name);
+			}
+
+			for (const RenderGraphBarrier& Barrier : GraphPass.Barriers)
+			{
+				if (Barrier.SrcPass != UINT32_MAX && IsInline[Barrier.SrcPass])
+				{
+					F_LOG_ERROR("Render graph pass '{}' needs a barrier after '{}' inside of the swap chain render pass",
+						GraphPass.Name, m_RenderGraph.GetPass(Barrier.SrcPass).Name);
+				}
+			}
+
+			IsInline[Pass] = true;
+			m_InlinePasses.emplace_back(Pass);
+		}
+
+		F_LOG_TRACE("Render graph compiled with {} passes on {} levels", m_RenderGraph.GetExecutionOrder().size(), m_RenderGraph.GetLevels().size());
+	}
 }
\ No newline at end of file
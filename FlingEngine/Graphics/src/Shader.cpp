@@ -2,19 +2,13 @@
 #include "Shader.h"
 #include "ResourceManager.h"
 #include "LogicalDevice.h"
+#include "VulkanApp.h"
+#include "DescriptorLayoutCache.h"
+
+#include <algorithm>
 
 namespace Fling
 {
-	// https://www.khronos.org/registry/spir-v/specs/1.0/SPIRV.pdf
-	struct Id
-	{
-		uint32_t opcode{};
-		uint32_t typeId{};
-		uint32_t storageClass{};
-		uint32_t binding{};
-		uint32_t set{};
-	};
-
     std::shared_ptr<Fling::Shader> Shader::Create(Guid t_ID, LogicalDevice* t_Dev)
     {
 		const auto& shader = ResourceManager::LoadResource<Shader>(t_ID, t_Dev);
@@ -35,8 +29,10 @@ namespace Fling
 
 		assert(RawCode.size() % 4 == 0);
 
-		UINT32 size = static_cast<UINT32>(RawCode.size() / 4);
-		ParseReflectionData(reinterpret_cast<const UINT32*>(RawCode.data()), size);
+		if (!ShaderReflection::Parse(reinterpret_cast<const UINT32*>(RawCode.data()), RawCode.size() / 4, m_Reflection))
+		{
+			F_LOG_ERROR("Failed to reflect shader {}", GetFilepathReleativeToAssets());
+		}
     }
 
     Shader::~Shader()
@@ -76,277 +72,73 @@ namespace Fling
         return RawShaderCode;
     }
 
-	namespace ParseHelpers
+	void Shader::Release()
 	{
-		static VkShaderStageFlagBits GetShaderStage(SpvExecutionModel executionModel)
+		if (m_Module != VK_NULL_HANDLE)
 		{
-			switch (executionModel)
-			{
-			case SpvExecutionModelVertex:
-				return VK_SHADER_STAGE_VERTEX_BIT;
-			case SpvExecutionModelFragment:
-				return VK_SHADER_STAGE_FRAGMENT_BIT;
-			case SpvExecutionModelGLCompute:
-				return VK_SHADER_STAGE_COMPUTE_BIT;
-				//case SpvExecutionModelTaskNV:
-				//	return VK_SHADER_STAGE_MESH_BIT_NV;
-				//case SpvExecutionModelMeshNV:
-				//	return VK_SHADER_STAGE_MESH_BIT_NV;
-
-			default:
-				assert(!"Unsupported execution model");
-				return VkShaderStageFlagBits(0);
-			}
+			vkDestroyShaderModule(m_Device->GetVkDevice(), m_Module, nullptr);
+			m_Module = VK_NULL_HANDLE;
 		}
-	}	// namespace ParseHelpers
-
-    void Shader::ParseReflectionData(const UINT32* t_Code, UINT32 t_Size)
-    {
-		assert(t_Code && t_Size > 0);
-		assert(t_Code[0] == SpvMagicNumber);
+	}
 
-		UINT32 idBound = t_Code[3];
-		std::vector<Id> ids(idBound);
-		const UINT32* insn = t_Code + 5;
+	VkPipelineLayout Shader::GetLayouts(const std::vector<Shader*>& t_Shaders, UINT32 t_DynamicUniformMask, UINT32 t_RuntimeArraySize, std::vector<VkDescriptorSetLayout>& t_OutSetLayouts)
+	{
+		DescriptorLayoutCache* LayoutCache = VulkanApp::Get().GetLayoutCache();
+		assert(LayoutCache);
 
-		// Find out what types of bindings this shader has
-		while (insn != t_Code + t_Size)
+		std::vector<const ShaderReflection*> Stages;
+		UINT32 SetCount = 1;
+		for (const Shader* shader : t_Shaders)
 		{
-			UINT16 opcode = UINT16(insn[0]);
-			UINT16 wordCount = UINT16(insn[0] >> 16);
-
-			switch (opcode)
-			{
-			case SpvOpEntryPoint:
-			{
-				assert(wordCount >= 2);
-				m_Stage = ParseHelpers::GetShaderStage(SpvExecutionModel(insn[1]));
-			} break;
-			case SpvOpExecutionMode:
-			{
-				assert(wordCount >= 3);
-				UINT32 mode = insn[2];
-
-				switch (mode)
-				{
-				case SpvExecutionModeLocalSize:
-					assert(wordCount == 6);
-					localSizeX = insn[3];
-					localSizeY = insn[4];
-					localSizeZ = insn[5];
-					break;
-				}
-			} break;
-			case SpvOpDecorate:
-			{
-				assert(wordCount >= 3);
-
-				UINT32 id = insn[1];
-				assert(id < idBound);
-
-				switch (insn[2])
-				{
-				case SpvDecorationDescriptorSet:
-					assert(wordCount == 4);
-					ids[id].set = insn[3];
-					break;
-				case SpvDecorationBinding:
-					assert(wordCount == 4);
-					ids[id].binding = insn[3];
-					break;
-				}
-			} break;
-			case SpvOpTypeStruct:
-			case SpvOpTypeImage:
-			case SpvOpTypeSampler:
-			case SpvOpTypeSampledImage:
-			{
-				assert(wordCount >= 2);
-
-				UINT32 id = insn[1];
-				assert(id < idBound);
-
-				assert(ids[id].opcode == 0);
-				ids[id].opcode = opcode;
-			} break;
-			case SpvOpTypePointer:
-			{
-				assert(wordCount == 4);
-
-				UINT32 id = insn[1];
-				assert(id < idBound);
-
-				assert(ids[id].opcode == 0);
-				ids[id].opcode = opcode;
-				ids[id].typeId = insn[3];
-				ids[id].storageClass = insn[2];
-			} break;
-			case SpvOpVariable:
-			{
-				assert(wordCount >= 4);
-
-				UINT32 id = insn[2];
-				assert(id < idBound);
-
-				assert(ids[id].opcode == 0);
-				ids[id].opcode = opcode;
-				ids[id].typeId = insn[1];
-				ids[id].storageClass = insn[3];
-			} break;
-			}
-
-			assert(insn + wordCount <= t_Code + t_Size);
-			insn += wordCount;
+			assert(shader);
+			Stages.push_back(&shader->GetReflection());
+			SetCount = std::max(SetCount, shader->GetReflection().GetSetCount());
 		}
 
-		// Find what resources we need for this shader (samplers, buffers, etc)
-		for (const auto& id : ids)
+		// Sets in between the ones that are used still need a layout, an empty one is fine
+		t_OutSetLayouts.clear();
+		std::vector<VkDescriptorSetLayoutBinding> Bindings;
+		std::vector<VkDescriptorBindingFlagsEXT> BindingFlags;
+		for (UINT32 Set = 0; Set < SetCount; ++Set)
 		{
-			if (id.opcode == SpvOpVariable && (id.storageClass == SpvStorageClassUniform || id.storageClass == SpvStorageClassUniformConstant || id.storageClass == SpvStorageClassStorageBuffer))
+			if (!ShaderReflection::GetSetBindings(Stages, Set, Set == 0 ? t_DynamicUniformMask : 0, Bindings))
 			{
-				assert(id.set == 0);
-				assert(id.binding < 32);
-				assert(ids[id.typeId].opcode == SpvOpTypePointer);
-
-				assert((m_ResourceMask & (1 << id.binding)) == 0);
-
-				uint32_t typeKind = ids[ids[id.typeId].typeId].opcode;
-
-				switch (typeKind)
-				{
-				case SpvOpTypeStruct:
-					//m_ResourceTypes[id.binding] = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-					m_ResourceTypes[id.binding] = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-
-					m_ResourceMask |= 1 << id.binding;
-					break;
-				case SpvOpTypeImage:
-					m_ResourceTypes[id.binding] = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-					m_ResourceMask |= 1 << id.binding;
-					break;
-				case SpvOpTypeSampler:
-					m_ResourceTypes[id.binding] = VK_DESCRIPTOR_TYPE_SAMPLER;
-					m_ResourceMask |= 1 << id.binding;
-					break;
-				case SpvOpTypeSampledImage:
-					m_ResourceTypes[id.binding] = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-					m_ResourceMask |= 1 << id.binding;
-					break;
-				default:
-					assert(!"Unknown resource type");
-				}
+				F_LOG_ERROR("Shader stages disagree on the bindings in descriptor set {}", Set);
 			}
 
-			if (id.opcode == SpvOpVariable && id.storageClass == SpvStorageClassPushConstant)
-			{
-				m_UsesPushConstants = true;
-			}
-		}
-    }
-
-	UINT32 Shader::GatherResources(const std::vector<Shader*>& t_Shaders, VkDescriptorType(&t_ResourceTypes)[32])
-	{
-		UINT32 ResourceMask = 0;
-
-		for (const Shader* shader : t_Shaders)
-		{
-			for (UINT32 i = 0; i < 32; ++i)
+			// Reflection reports runtime arrays with no descriptors, they are sized by the caller
+			VkDescriptorSetLayoutCreateFlags SetFlags = 0;
+			BindingFlags.clear();
+			for (size_t i = 0; i < Bindings.size(); ++i)
 			{
-				if (shader->m_ResourceMask & (1 << i))
+				if (Bindings[i].descriptorCount != 0)
 				{
-					if (ResourceMask & (1 << i))
-					{
-						assert(t_ResourceTypes[i] == shader->m_ResourceTypes[i]);
-					}
-					else
-					{
-						t_ResourceTypes[i] = shader->m_ResourceTypes[i];
-						ResourceMask |= 1 << i;
-					}
+					continue;
 				}
-			}
-		}			
-
-		return ResourceMask;
-	}
 
-	void Shader::Release()
-	{
-		if (m_Module != VK_NULL_HANDLE)
-		{
-			vkDestroyShaderModule(m_Device->GetVkDevice(), m_Module, nullptr);
-			m_Module = VK_NULL_HANDLE;
-		}
-	}
-
-	VkDescriptorSetLayout Shader::CreateSetLayout(VkDevice t_Dev, std::vector<Shader*>& t_Shaders, bool t_SupportPushDescriptor)
-	{
-		std::vector<VkDescriptorSetLayoutBinding> setBindings;
-
-		VkDescriptorType resourceTypes[32] = {};
-		UINT32 resourceMask = GatherResources(t_Shaders, resourceTypes);
-
-		for (UINT32 i = 0; i < 32; ++i)
-		{
-			if (resourceMask & (1 << i))
-			{
-				VkDescriptorSetLayoutBinding binding = {};
-				binding.binding = i;
-				binding.descriptorType = resourceTypes[i];
-				binding.descriptorCount = 1;
-
-				binding.stageFlags = 0;
-				for (const Shader* shader : t_Shaders)
+				if (t_RuntimeArraySize == 0)
 				{
-					if (shader && shader->m_ResourceMask & (1 << i))
-					{
-						binding.stageFlags |= shader->m_Stage;
-					}
+					F_LOG_ERROR("Descriptor set {} has a runtime sized array at binding {} but no size was given for it", Set, Bindings[i].binding);
+					continue;
 				}
 
-				setBindings.push_back(binding);
+				BindingFlags.resize(Bindings.size(), 0);
+				Bindings[i].descriptorCount = t_RuntimeArraySize;
+				// New slots are written while earlier frames that don't use them are still in flight
+				BindingFlags[i] = 
+					VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | 
+					VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT | 
+					VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+				SetFlags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
 			}
-		}
-
-		VkDescriptorSetLayoutCreateInfo setCreateInfo = {};
-		setCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-		setCreateInfo.flags = t_SupportPushDescriptor ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : 0;
-		setCreateInfo.bindingCount = uint32_t(setBindings.size());
-		setCreateInfo.pBindings = setBindings.data();
 
-		VkDescriptorSetLayout setLayout = 0;
-
-		if(vkCreateDescriptorSetLayout(t_Dev, &setCreateInfo, 0, &setLayout) != VK_SUCCESS)
-		{
-			F_LOG_FATAL("Failed to create descriptor set layout!");
-		}
-		return setLayout;
-	}
-
-	VkPipelineLayout Shader::CreatePipelineLayout(VkDevice t_Dev, VkDescriptorSetLayout t_SetLayout, VkShaderStageFlags t_PushConstantStages, size_t t_PushConstantSize)
-	{
-		VkPipelineLayoutCreateInfo createInfo = { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
-		createInfo.setLayoutCount = 1;
-		createInfo.pSetLayouts = &t_SetLayout;
-
-		VkPushConstantRange pushConstantRange = {};
-
-		if (t_PushConstantSize)
-		{
-			pushConstantRange.stageFlags = t_PushConstantStages;
-			pushConstantRange.size = UINT32(t_PushConstantSize);
-
-			createInfo.pushConstantRangeCount = 1;
-			createInfo.pPushConstantRanges = &pushConstantRange;
+			t_OutSetLayouts.push_back(LayoutCache->GetSetLayout(Bindings, SetFlags, BindingFlags));
 		}
 
-		VkPipelineLayout layout = 0;
-		if (vkCreatePipelineLayout(t_Dev, &createInfo, 0, &layout) != VK_SUCCESS)
-		{
-			F_LOG_FATAL("Failed to create pipeline layout!");
-		}
+		std::vector<VkPushConstantRange> PushConstantRanges;
+		ShaderReflection::GetPushConstantRanges(Stages, PushConstantRanges);
 
-		return layout;
+		return LayoutCache->GetPipelineLayout(t_OutSetLayouts, PushConstantRanges);
 	}
 
 }   // namespace Fling
\ No newline at end of file
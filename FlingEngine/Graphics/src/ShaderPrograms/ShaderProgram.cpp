@@ -12,15 +12,14 @@ namespace Fling
 
     ShaderProgram::~ShaderProgram()
     {
-        vkDestroyPipelineLayout(m_Device, m_PipelineLayout, nullptr);
-        vkDestroyDescriptorSetLayout(m_Device, m_DescriptorLayout, nullptr);
+        // The layouts are shared through the layout cache, which destroys them
     }
 
     void ShaderProgram::InitGraphicPipeline(VkRenderPass t_Renderpass, Multisampler* t_Sampler)
     {
         m_Pipeline->CreateGraphicsPipeline(t_Renderpass, t_Sampler);
-        m_DescriptorLayout = Shader::CreateSetLayout(m_Device, m_Shaders);
-        m_PipelineLayout = Shader::CreatePipelineLayout(m_Device, m_DescriptorLayout, 0, 0);
+        m_DescriptorLayout = m_Pipeline->GetDescriptorSetLayout();
+        m_PipelineLayout = m_Pipeline->GetPipelineLayout();
     }
 
 	ShaderProgramType ShaderProgram::ShaderProgramFromStr(std::string& t_Str)
@@ -0,0 +1,539 @@
+#include "pch.h"
+#include "ShaderReflection.h"
+
+#include "spirv.h"
+
+namespace Fling
+{
+	namespace
+	{
+		// https://www.khronos.org/registry/spir-v/specs/1.0/SPIRV.pdf
+		struct Id
+		{
+			UINT32 Opcode = 0;
+
+			/** Type of variables and constants, the pointee of pointers and the element of arrays, vectors and matrices */
+			UINT32 TypeId = 0;
+			UINT32 StorageClass = 0;
+
+			UINT32 Set = 0;
+			UINT32 Binding = 0;
+			UINT32 Location = 0;
+			bool HasLocation = false;
+
+			bool IsBufferBlock = false;
+			bool IsBuiltIn = false;
+
+			/** Bit width of scalars, component count of vectors and matrices, the length id of arrays and the value of constants */
+			UINT32 Value = 0;
+			UINT32 Signedness = 0;
+			UINT32 ArrayStride = 0;
+
+			/** Dimension of images and whether they are sampled (1) or storage (2) images */
+			UINT32 Dim = 0;
+			UINT32 Sampled = 0;
+
+			std::vector<UINT32> Members;
+			std::vector<UINT32> MemberOffsets;
+			std::vector<UINT32> MemberMatrixStrides;
+
+			std::string Name;
+		};
+
+		VkShaderStageFlagBits GetShaderStage(UINT32 t_ExecutionModel)
+		{
+			switch (t_ExecutionModel)
+			{
+			case SpvExecutionModelVertex:					return VK_SHADER_STAGE_VERTEX_BIT;
+			case SpvExecutionModelTessellationControl:		return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+			case SpvExecutionModelTessellationEvaluation:	return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+			case SpvExecutionModelGeometry:					return VK_SHADER_STAGE_GEOMETRY_BIT;
+			case SpvExecutionModelFragment:					return VK_SHADER_STAGE_FRAGMENT_BIT;
+			case SpvExecutionModelGLCompute:				return VK_SHADER_STAGE_COMPUTE_BIT;
+			default:										return VkShaderStageFlagBits(0);
+			}
+		}
+
+		/** Size of a type in bytes with the offsets and strides that the shader declares */
+		UINT32 GetTypeSize(const std::vector<Id>& t_Ids, UINT32 t_TypeId)
+		{
+			const Id& Type = t_Ids[t_TypeId];
+			switch (Type.Opcode)
+			{
+			case SpvOpTypeInt:
+			case SpvOpTypeFloat:
+				return Type.Value / 8;
+			case SpvOpTypeVector:
+			case SpvOpTypeMatrix:
+				return Type.Value * GetTypeSize(t_Ids, Type.TypeId);
+			case SpvOpTypeArray:
+			{
+				const UINT32 Length = t_Ids[Type.Value].Value;
+				return Length * (Type.ArrayStride ? Type.ArrayStride : GetTypeSize(t_Ids, Type.TypeId));
+			}
+			case SpvOpTypeStruct:
+			{
+				UINT32 Size = 0;
+				for (size_t i = 0; i < Type.Members.size(); ++i)
+				{
+					const Id& Member = t_Ids[Type.Members[i]];
+					const UINT32 Offset = i < Type.MemberOffsets.size() ? Type.MemberOffsets[i] : 0;
+					const UINT32 MatrixStride = i < Type.MemberMatrixStrides.size() ? Type.MemberMatrixStrides[i] : 0;
+					const UINT32 MemberSize = (Member.Opcode == SpvOpTypeMatrix && MatrixStride) ? Member.Value * MatrixStride : GetTypeSize(t_Ids, Type.Members[i]);
+					Size = std::max(Size, Offset + MemberSize);
+				}
+				return Size;
+			}
+			default:
+				// Runtime arrays don't have a size
+				return 0;
+			}
+		}
+
+		VkFormat GetVertexFormat(const Id& t_Scalar, UINT32 t_Components)
+		{
+			static const VkFormat FloatFormats[4] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+			static const VkFormat IntFormats[4] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+			static const VkFormat UintFormats[4] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+			if (t_Components == 0 || t_Components > 4 || t_Scalar.Value != 32)
+			{
+				return VK_FORMAT_UNDEFINED;
+			}
+
+			if (t_Scalar.Opcode == SpvOpTypeFloat)
+			{
+				return FloatFormats[t_Components - 1];
+			}
+			if (t_Scalar.Opcode == SpvOpTypeInt)
+			{
+				return t_Scalar.Signedness ? IntFormats[t_Components - 1] : UintFormats[t_Components - 1];
+			}
+			return VK_FORMAT_UNDEFINED;
+		}
+
+		/** Operand that holds the id an instruction defines or decorates, 0 for instructions that reflection skips */
+		UINT32 GetTargetWord(UINT32 t_Opcode)
+		{
+			switch (t_Opcode)
+			{
+			case SpvOpName:
+			case SpvOpDecorate:
+			case SpvOpMemberDecorate:
+			case SpvOpTypeInt:
+			case SpvOpTypeFloat:
+			case SpvOpTypeVector:
+			case SpvOpTypeMatrix:
+			case SpvOpTypeArray:
+			case SpvOpTypeRuntimeArray:
+			case SpvOpTypeSampledImage:
+			case SpvOpTypeImage:
+			case SpvOpTypeSampler:
+			case SpvOpTypeStruct:
+			case SpvOpTypePointer:
+				return 1;
+			case SpvOpConstant:
+			case SpvOpVariable:
+				return 2;
+			default:
+				return 0;
+			}
+		}
+
+		std::string ReadString(const UINT32* t_Words, UINT32 t_WordCount)
+		{
+			const char* Str = reinterpret_cast<const char*>(t_Words);
+			size_t Length = 0;
+			while (Length < t_WordCount * 4 && Str[Length] != '\0')
+			{
+				++Length;
+			}
+			return std::string(Str, Length);
+		}
+	}
+
+	bool ShaderReflection::Parse(const UINT32* t_Code, size_t t_WordCount, ShaderReflection& t_Out)
+	{
+		t_Out = ShaderReflection();
+
+		if (!t_Code || t_WordCount < 5 || t_Code[0] != SpvMagicNumber || t_Code[3] == 0)
+		{
+			return false;
+		}
+
+		const UINT32 IdBound = t_Code[3];
+		std::vector<Id> Ids(IdBound);
+		bool HasEntryPoint = false;
+
+		const UINT32* Insn = t_Code + 5;
+		const UINT32* End = t_Code + t_WordCount;
+
+		// Gather the types, decorations and variables that describe the interface of the shader
+		while (Insn < End)
+		{
+			const UINT16 Opcode = UINT16(Insn[0]);
+			const UINT16 WordCount = UINT16(Insn[0] >> 16);
+			if (WordCount == 0 || Insn + WordCount > End)
+			{
+				return false;
+			}
+
+			const UINT32 TargetWord = GetTargetWord(Opcode);
+			if (TargetWord != 0 && (TargetWord >= WordCount || Insn[TargetWord] >= IdBound))
+			{
+				return false;
+			}
+			Id& Result = Ids[TargetWord != 0 ? Insn[TargetWord] : 0];
+
+			switch (Opcode)
+			{
+			case SpvOpEntryPoint:
+				if (WordCount >= 3 && !HasEntryPoint)
+				{
+					t_Out.Stage = GetShaderStage(Insn[1]);
+					HasEntryPoint = true;
+				}
+				break;
+			case SpvOpExecutionMode:
+				if (WordCount == 6 && Insn[2] == SpvExecutionModeLocalSize)
+				{
+					t_Out.LocalSize[0] = Insn[3];
+					t_Out.LocalSize[1] = Insn[4];
+					t_Out.LocalSize[2] = Insn[5];
+				}
+				break;
+			case SpvOpName:
+				if (WordCount >= 3)
+				{
+					Result.Name = ReadString(Insn + 2, WordCount - 2);
+				}
+				break;
+			case SpvOpDecorate:
+				if (WordCount >= 3)
+				{
+					const UINT32 Value = WordCount >= 4 ? Insn[3] : 0;
+					switch (Insn[2])
+					{
+					case SpvDecorationDescriptorSet:	Result.Set = Value; break;
+					case SpvDecorationBinding:			Result.Binding = Value; break;
+					case SpvDecorationLocation:			Result.Location = Value; Result.HasLocation = true; break;
+					case SpvDecorationBufferBlock:		Result.IsBufferBlock = true; break;
+					case SpvDecorationBuiltIn:			Result.IsBuiltIn = true; break;
+					case SpvDecorationArrayStride:		Result.ArrayStride = Value; break;
+					}
+				}
+				break;
+			case SpvOpMemberDecorate:
+				if (WordCount >= 5)
+				{
+					const UINT32 Member = Insn[2];
+					if (Insn[3] == SpvDecorationOffset)
+					{
+						Result.MemberOffsets.resize(std::max<size_t>(Result.MemberOffsets.size(), Member + 1));
+						Result.MemberOffsets[Member] = Insn[4];
+					}
+					else if (Insn[3] == SpvDecorationMatrixStride)
+					{
+						Result.MemberMatrixStrides.resize(std::max<size_t>(Result.MemberMatrixStrides.size(), Member + 1));
+						Result.MemberMatrixStrides[Member] = Insn[4];
+					}
+				}
+				break;
+			case SpvOpTypeInt:
+				if (WordCount < 4) return false;
+				Result.Opcode = Opcode;
+				Result.Value = Insn[2];
+				Result.Signedness = Insn[3];
+				break;
+			case SpvOpTypeFloat:
+				if (WordCount < 3) return false;
+				Result.Opcode = Opcode;
+				Result.Value = Insn[2];
+				break;
+			case SpvOpTypeVector:
+			case SpvOpTypeMatrix:
+			case SpvOpTypeArray:
+				if (WordCount < 4 || Insn[2] >= IdBound || Insn[3] >= IdBound) return false;
+				Result.Opcode = Opcode;
+				Result.TypeId = Insn[2];
+				Result.Value = Insn[3];
+				break;
+			case SpvOpTypeRuntimeArray:
+			case SpvOpTypeSampledImage:
+				if (WordCount < 3 || Insn[2] >= IdBound) return false;
+				Result.Opcode = Opcode;
+				Result.TypeId = Insn[2];
+				break;
+			case SpvOpTypeImage:
+				if (WordCount < 9) return false;
+				Result.Opcode = Opcode;
+				Result.Dim = Insn[3];
+				Result.Sampled = Insn[7];
+				break;
+			case SpvOpTypeSampler:
+				Result.Opcode = Opcode;
+				break;
+			case SpvOpTypeStruct:
+				Result.Opcode = Opcode;
+				Result.Members.assign(Insn + 2, Insn + WordCount);
+				for (UINT32 Member : Result.Members)
+				{
+					if (Member >= IdBound) return false;
+				}
+				break;
+			case SpvOpTypePointer:
+				if (WordCount != 4 || Insn[3] >= IdBound) return false;
+				Result.Opcode = Opcode;
+				Result.StorageClass = Insn[2];
+				Result.TypeId = Insn[3];
+				break;
+			case SpvOpConstant:
+				if (WordCount < 4) return false;
+				Result.Opcode = Opcode;
+				Result.TypeId = Insn[1];
+				Result.Value = Insn[3];
+				break;
+			case SpvOpVariable:
+				if (WordCount < 4 || Insn[1] >= IdBound) return false;
+				Result.Opcode = Opcode;
+				Result.TypeId = Insn[1];
+				Result.StorageClass = Insn[3];
+				break;
+			}
+
+			Insn += WordCount;
+		}
+
+		if (!HasEntryPoint || t_Out.Stage == 0)
+		{
+			return false;
+		}
+
+		// Find what resources, push constants and vertex inputs the shader has
+		UINT32 PushConstantEnd = 0;
+		for (const Id& Var : Ids)
+		{
+			if (Var.Opcode != SpvOpVariable || Ids[Var.TypeId].Opcode != SpvOpTypePointer)
+			{
+				continue;
+			}
+
+			UINT32 TypeId = Ids[Var.TypeId].TypeId;
+
+			switch (Var.StorageClass)
+			{
+			case SpvStorageClassUniform:
+			case SpvStorageClassUniformConstant:
+			case SpvStorageClassStorageBuffer:
+			{
+				ShaderBinding Binding;
+				Binding.Set = Var.Set;
+				Binding.Binding = Var.Binding;
+
+				// Arrays of descriptors are a single binding
+				if (Ids[TypeId].Opcode == SpvOpTypeArray)
+				{
+					Binding.Count = Ids[Ids[TypeId].Value].Value;
+					TypeId = Ids[TypeId].TypeId;
+				}
+				else if (Ids[TypeId].Opcode == SpvOpTypeRuntimeArray)
+				{
+					Binding.Count = 0;
+					TypeId = Ids[TypeId].TypeId;
+				}
+
+				const Id& Type = Ids[TypeId];
+				Binding.Name = Var.Name.empty() ? Type.Name : Var.Name;
+
+				switch (Type.Opcode)
+				{
+				case SpvOpTypeStruct:
+					Binding.Type = (Var.StorageClass == SpvStorageClassStorageBuffer || Type.IsBufferBlock) ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+					Binding.Size = GetTypeSize(Ids, TypeId);
+					break;
+				case SpvOpTypeImage:
+					if (Type.Dim == SpvDimSubpassData)
+					{
+						Binding.Type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+					}
+					else if (Type.Dim == SpvDimBuffer)
+					{
+						Binding.Type = Type.Sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+					}
+					else
+					{
+						Binding.Type = Type.Sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+					}
+					break;
+				case SpvOpTypeSampler:
+					Binding.Type = VK_DESCRIPTOR_TYPE_SAMPLER;
+					break;
+				case SpvOpTypeSampledImage:
+					Binding.Type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+					break;
+				default:
+					// Not a descriptor, like a uniform constant that isn't a resource
+					continue;
+				}
+
+				t_Out.Bindings.emplace_back(std::move(Binding));
+			} break;
+			case SpvStorageClassPushConstant:
+			{
+				const Id& Type = Ids[TypeId];
+				UINT32 Offset = UINT32_MAX;
+				for (size_t i = 0; i < Type.Members.size(); ++i)
+				{
+					Offset = std::min(Offset, i < Type.MemberOffsets.size() ? Type.MemberOffsets[i] : 0u);
+				}
+
+				PushConstantEnd = std::max(PushConstantEnd, GetTypeSize(Ids, TypeId));
+				t_Out.PushConstantOffset = Offset == UINT32_MAX ? 0 : Offset;
+			} break;
+			case SpvStorageClassInput:
+			{
+				if (t_Out.Stage != VK_SHADER_STAGE_VERTEX_BIT || Var.IsBuiltIn || !Var.HasLocation)
+				{
+					continue;
+				}
+
+				// Matrices are read as one vector per column
+				const Id* Type = &Ids[TypeId];
+				UINT32 Columns = 1;
+				if (Type->Opcode == SpvOpTypeMatrix)
+				{
+					Columns = Type->Value;
+					Type = &Ids[Type->TypeId];
+				}
+
+				UINT32 Components = 1;
+				if (Type->Opcode == SpvOpTypeVector)
+				{
+					Components = Type->Value;
+					Type = &Ids[Type->TypeId];
+				}
+
+				const VkFormat Format = GetVertexFormat(*Type, Components);
+				for (UINT32 c = 0; c < Columns; ++c)
+				{
+					t_Out.VertexInputs.push_back({ Var.Location + c, Format, Var.Name });
+				}
+			} break;
+			}
+		}
+
+		if (PushConstantEnd > t_Out.PushConstantOffset)
+		{
+			t_Out.PushConstantSize = PushConstantEnd - t_Out.PushConstantOffset;
+		}
+
+		std::sort(t_Out.Bindings.begin(), t_Out.Bindings.end(), [](const ShaderBinding& A, const ShaderBinding& B)
+		{
+			return A.Set != B.Set ? A.Set < B.Set : A.Binding < B.Binding;
+		});
+
+		std::sort(t_Out.VertexInputs.begin(), t_Out.VertexInputs.end(), [](const ShaderVertexInput& A, const ShaderVertexInput& B)
+		{
+			return A.Location < B.Location;
+		});
+
+		return true;
+	}
+
+	const ShaderBinding* ShaderReflection::FindBinding(const std::string& t_Name) const
+	{
+		for (const ShaderBinding& Binding : Bindings)
+		{
+			if (Binding.Name == t_Name)
+			{
+				return &Binding;
+			}
+		}
+		return nullptr;
+	}
+
+	UINT32 ShaderReflection::GetSetCount() const
+	{
+		return Bindings.empty() ? 0 : Bindings.back().Set + 1;
+	}
+
+	bool ShaderReflection::GetSetBindings(const std::vector<const ShaderReflection*>& t_Stages, UINT32 t_Set, UINT32 t_DynamicUniformMask, std::vector<VkDescriptorSetLayoutBinding>& t_OutBindings)
+	{
+		t_OutBindings.clear();
+		bool Matches = true;
+
+		for (const ShaderReflection* Stage : t_Stages)
+		{
+			if (!Stage)
+			{
+				continue;
+			}
+
+			for (const ShaderBinding& Binding : Stage->Bindings)
+			{
+				if (Binding.Set != t_Set)
+				{
+					continue;
+				}
+
+				VkDescriptorType Type = Binding.Type;
+				if (Type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER && Binding.Binding < 32 && (t_DynamicUniformMask & (1u << Binding.Binding)))
+				{
+					Type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+				}
+
+				auto It = std::find_if(t_OutBindings.begin(), t_OutBindings.end(), [&](const VkDescriptorSetLayoutBinding& Existing)
+				{
+					return Existing.binding == Binding.Binding;
+				});
+
+				if (It == t_OutBindings.end())
+				{
+					VkDescriptorSetLayoutBinding LayoutBinding = {};
+					LayoutBinding.binding = Binding.Binding;
+					LayoutBinding.descriptorType = Type;
+					LayoutBinding.descriptorCount = Binding.Count;
+					LayoutBinding.stageFlags = Stage->Stage;
+					t_OutBindings.emplace_back(LayoutBinding);
+				}
+				else
+				{
+					Matches &= It->descriptorType == Type && It->descriptorCount == Binding.Count;
+					It->stageFlags |= Stage->Stage;
+				}
+			}
+		}
+
+		std::sort(t_OutBindings.begin(), t_OutBindings.end(), [](const VkDescriptorSetLayoutBinding& A, const VkDescriptorSetLayoutBinding& B)
+		{
+			return A.binding < B.binding;
+		});
+
+		return Matches;
+	}
+
+	void ShaderReflection::GetPushConstantRanges(const std::vector<const ShaderReflection*>& t_Stages, std::vector<VkPushConstantRange>& t_OutRanges)
+	{
+		t_OutRanges.clear();
+
+		VkPushConstantRange Range = {};
+		Range.offset = UINT32_MAX;
+		UINT32 End = 0;
+
+		for (const ShaderReflection* Stage : t_Stages)
+		{
+			if (Stage && Stage->PushConstantSize > 0)
+			{
+				Range.stageFlags |= Stage->Stage;
+				Range.offset = std::min(Range.offset, Stage->PushConstantOffset);
+				End = std::max(End, Stage->PushConstantOffset + Stage->PushConstantSize);
+			}
+		}
+
+		if (Range.stageFlags != 0)
+		{
+			Range.size = End - Range.offset;
+			t_OutRanges.emplace_back(Range);
+		}
+	}
+}   // namespace Fling
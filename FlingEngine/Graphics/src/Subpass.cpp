@@ -6,7 +6,7 @@
 
 namespace Fling
 {
-	Subpass::Subpass(const LogicalDevice* t_Dev, const Swapchain* t_Swap, std::shared_ptr<Fling::Shader> t_Vert, std::shared_ptr<Fling::Shader> t_Frag)
+	Subpass::Subpass(const LogicalDevice* t_Dev, const Swapchain* t_Swap, std::shared_ptr<Fling::Shader> t_Vert, std::shared_ptr<Fling::Shader> t_Frag, UINT32 t_DynamicUniformMask, UINT32 t_RuntimeArraySize)
 		: m_Device(t_Dev)
 		, m_SwapChain(t_Swap)
 		, m_VertexShader(t_Vert)
@@ -31,7 +31,9 @@ namespace Fling
             GraphicsPipeline::Depth::ReadWrite,
             VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
             VK_CULL_MODE_FRONT_BIT,
-            VK_FRONT_FACE_COUNTER_CLOCKWISE);
+            VK_FRONT_FACE_COUNTER_CLOCKWISE,
+            t_DynamicUniformMask,
+            t_RuntimeArraySize);
 	}
 
 	Subpass::~Subpass()
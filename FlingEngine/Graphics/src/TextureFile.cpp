@@ -0,0 +1,160 @@
+#include "pch.h"
+#include "TextureFile.h"
+
+#include <fstream>
+#include <filesystem>
+
+namespace Fling
+{
+	namespace
+	{
+		UINT64 AlignUp(UINT64 t_Value, UINT64 t_Alignment)
+		{
+			return (t_Value + t_Alignment - 1) & ~(t_Alignment - 1);
+		}
+
+		void WritePadding(std::ofstream& t_File, UINT64 t_To)
+		{
+			static const char Zeros[TextureFile::DataAlignment] = {};
+			const UINT64 Pos = static_cast<UINT64>(t_File.tellp());
+			if (t_To > Pos)
+			{
+				t_File.write(Zeros, static_cast<std::streamsize>(t_To - Pos));
+			}
+		}
+	}
+
+	VkFormat TextureFile::GetVkFormat(BlockFormat t_Format)
+	{
+		switch (t_Format)
+		{
+		case BlockFormat::BC1:	return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+		case BlockFormat::BC3:	return VK_FORMAT_BC3_UNORM_BLOCK;
+		case BlockFormat::BC4:	return VK_FORMAT_BC4_UNORM_BLOCK;
+		case BlockFormat::BC5:	return VK_FORMAT_BC5_UNORM_BLOCK;
+		case BlockFormat::BC7:	return VK_FORMAT_BC7_UNORM_BLOCK;
+		}
+		return VK_FORMAT_UNDEFINED;
+	}
+
+	bool TextureFile::Write(const std::string& t_FilePath, BlockFormat t_Format, UINT32 t_Width, UINT32 t_Height, const std::vector<std::vector<UINT8>>& t_Levels)
+	{
+		TextureFileHeader Header = {};
+		Header.Magic = Magic;
+		Header.Version = Version;
+		Header.Format = static_cast<UINT32>(GetVkFormat(t_Format));
+		Header.BlockFormat = static_cast<UINT32>(t_Format);
+		Header.Width = t_Width;
+		Header.Height = t_Height;
+		Header.MipCount = static_cast<UINT32>(t_Levels.size());
+
+		std::vector<TextureFileLevel> Levels(t_Levels.size());
+		UINT64 Offset = AlignUp(sizeof(TextureFileHeader) + sizeof(TextureFileLevel) * Levels.size(), DataAlignment);
+		for (size_t i = 0; i < Levels.size(); ++i)
+		{
+			Levels[i].Offset = Offset;
+			Levels[i].Size = t_Levels[i].size();
+			Offset = AlignUp(Offset + Levels[i].Size, DataAlignment);
+		}
+
+		std::ofstream File(t_FilePath, std::ios::binary | std::ios::trunc);
+		if (!File.is_open())
+		{
+			F_LOG_ERROR("Failed to open {} for writing", t_FilePath);
+			return false;
+		}
+
+		File.write(reinterpret_cast<const char*>(&Header), sizeof(Header));
+		File.write(reinterpret_cast<const char*>(Levels.data()), static_cast<std::streamsize>(sizeof(TextureFileLevel) * Levels.size()));
+		for (size_t i = 0; i < Levels.size(); ++i)
+		{
+			WritePadding(File, Levels[i].Offset);
+			File.write(reinterpret_cast<const char*>(t_Levels[i].data()), static_cast<std::streamsize>(t_Levels[i].size()));
+		}
+
+		return File.good();
+	}
+
+	std::string TextureFile::GetCookedPath(const std::string& t_SourcePath)
+	{
+		return std::filesystem::path(t_SourcePath).replace_extension(Extension).string();
+	}
+
+	bool TextureFile::IsUpToDate(const std::string& t_SourcePath, const std::string& t_CookedPath)
+	{
+		std::error_code Error;
+		const auto CookedTime = std::filesystem::last_write_time(t_CookedPath, Error);
+		if (Error)
+		{
+			return false;
+		}
+
+		// Shipped builds may only have the cooked file
+		const auto SourceTime = std::filesystem::last_write_time(t_SourcePath, Error);
+		return Error || CookedTime >= SourceTime;
+	}
+
+	bool TextureFile::Open(const std::string& t_FilePath)
+	{
+		Close();
+
+		if (!m_File.Open(t_FilePath) || m_File.GetSize() < sizeof(TextureFileHeader))
+		{
+			m_File.Close();
+			return false;
+		}
+
+		const TextureFileHeader* Header = reinterpret_cast<const TextureFileHeader*>(m_File.GetData());
+		const BlockFormat Format = static_cast<BlockFormat>(Header->BlockFormat);
+		if (Header->Magic != Magic || Header->Version != Version ||
+			Header->BlockFormat > static_cast<UINT32>(BlockFormat::BC7) || Header->Format != static_cast<UINT32>(GetVkFormat(Format)) ||
+			Header->Width == 0 || Header->Height == 0 || Header->MipCount == 0)
+		{
+			F_LOG_WARN("Cooked texture {} is from an older version and needs to be cooked again", t_FilePath);
+			m_File.Close();
+			return false;
+		}
+
+		const UINT64 FileSize = static_cast<UINT64>(m_File.GetSize());
+		if (sizeof(TextureFileHeader) + sizeof(TextureFileLevel) * static_cast<UINT64>(Header->MipCount) > FileSize)
+		{
+			F_LOG_ERROR("Cooked texture {} is truncated or corrupt", t_FilePath);
+			m_File.Close();
+			return false;
+		}
+
+		// Every level has to hold the whole mip, and the levels have to be back to back so they can be uploaded at once
+		const TextureFileLevel* Levels = reinterpret_cast<const TextureFileLevel*>(m_File.GetData() + sizeof(TextureFileHeader));
+		for (UINT32 i = 0; i < Header->MipCount; ++i)
+		{
+			const UINT32 Width = std::max(Header->Width >> i, 1u);
+			const UINT32 Height = std::max(Header->Height >> i, 1u);
+			const UINT64 ExpectedOffset = i == 0 ? Levels[0].Offset : AlignUp(Levels[i - 1].Offset + Levels[i - 1].Size, DataAlignment);
+			if (Levels[i].Offset % DataAlignment != 0 || Levels[i].Offset != ExpectedOffset ||
+				Levels[i].Size != BlockCompression::GetCompressedSize(Format, Width, Height) ||
+				Levels[i].Offset + Levels[i].Size > FileSize)
+			{
+				F_LOG_ERROR("Cooked texture {} is truncated or corrupt", t_FilePath);
+				m_File.Close();
+				return false;
+			}
+		}
+
+		m_Header = Header;
+		m_Levels = Levels;
+		return true;
+	}
+
+	void TextureFile::Close()
+	{
+		m_Header = nullptr;
+		m_Levels = nullptr;
+		m_File.Close();
+	}
+
+	UINT64 TextureFile::GetDataSize() const
+	{
+		const TextureFileLevel& Last = m_Levels[m_Header->MipCount - 1];
+		return Last.Offset + Last.Size - m_Levels[0].Offset;
+	}
+}   // namespace Fling
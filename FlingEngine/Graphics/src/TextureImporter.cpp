@@ -0,0 +1,151 @@
+#include "pch.h"
+#include "TextureImporter.h"
+#include "TextureFile.h"
+
+#include "stb_image.h"
+
+namespace Fling
+{
+	namespace TextureImporter
+	{
+		namespace
+		{
+			/** Average of up to 4 source pixels, clamped to the edge for odd sizes */
+			void Downsample(const TextureMip& t_Source, TextureUsage t_Usage, TextureMip& t_Out)
+			{
+				t_Out.Width = std::max(t_Source.Width / 2, 1u);
+				t_Out.Height = std::max(t_Source.Height / 2, 1u);
+				t_Out.Pixels.resize(static_cast<size_t>(t_Out.Width) * t_Out.Height * 4);
+
+				for (UINT32 y = 0; y < t_Out.Height; ++y)
+				{
+					const UINT32 Y0 = std::min(y * 2, t_Source.Height - 1);
+					const UINT32 Y1 = std::min(y * 2 + 1, t_Source.Height - 1);
+					for (UINT32 x = 0; x < t_Out.Width; ++x)
+					{
+						const UINT32 X0 = std::min(x * 2, t_Source.Width - 1);
+						const UINT32 X1 = std::min(x * 2 + 1, t_Source.Width - 1);
+						const UINT8* Corners[4] =
+						{
+							&t_Source.Pixels[(static_cast<size_t>(Y0) * t_Source.Width + X0) * 4],
+							&t_Source.Pixels[(static_cast<size_t>(Y0) * t_Source.Width + X1) * 4],
+							&t_Source.Pixels[(static_cast<size_t>(Y1) * t_Source.Width + X0) * 4],
+							&t_Source.Pixels[(static_cast<size_t>(Y1) * t_Source.Width + X1) * 4],
+						};
+
+						UINT8* Out = &t_Out.Pixels[(static_cast<size_t>(y) * t_Out.Width + x) * 4];
+						for (UINT32 c = 0; c < 4; ++c)
+						{
+							Out[c] = static_cast<UINT8>((Corners[0][c] + Corners[1][c] + Corners[2][c] + Corners[3][c] + 2) / 4);
+						}
+
+						// Averaged normals get shorter, push them back out to unit length
+						if (t_Usage == TextureUsage::Normal)
+						{
+							glm::vec3 Normal(0.0f);
+							for (const UINT8* Corner : Corners)
+							{
+								Normal += glm::vec3(Corner[0], Corner[1], Corner[2]) / 127.5f - glm::vec3(1.0f);
+							}
+
+							const float Length = glm::length(Normal);
+							Normal = Length > 0.0f ? Normal / Length : glm::vec3(0.0f, 0.0f, 1.0f);
+							for (UINT32 c = 0; c < 3; ++c)
+							{
+								Out[c] = static_cast<UINT8>(glm::clamp((Normal[c] + 1.0f) * 127.5f + 0.5f, 0.0f, 255.0f));
+							}
+						}
+					}
+				}
+			}
+		}
+
+		BlockFormat SelectBlockFormat(TextureUsage t_Usage, const TextureMip& t_Image, bool t_CompactColor)
+		{
+			switch (t_Usage)
+			{
+			case TextureUsage::Normal:
+				return BlockFormat::BC5;
+			case TextureUsage::Mask:
+				return BlockFormat::BC4;
+			default:
+				break;
+			}
+
+			if (!t_CompactColor)
+			{
+				return BlockFormat::BC7;
+			}
+			for (size_t i = 3; i < t_Image.Pixels.size(); i += 4)
+			{
+				if (t_Image.Pixels[i] != 255)
+				{
+					return BlockFormat::BC3;
+				}
+			}
+			return BlockFormat::BC1;
+		}
+
+		void GenerateMips(TextureMip t_Image, TextureUsage t_Usage, std::vector<TextureMip>& t_OutMips)
+		{
+			const UINT32 MipCount = static_cast<UINT32>(std::floor(std::log2(std::max(t_Image.Width, t_Image.Height)))) + 1;
+
+			t_OutMips.clear();
+			t_OutMips.reserve(MipCount);
+			t_OutMips.emplace_back(std::move(t_Image));
+			for (UINT32 i = 1; i < MipCount; ++i)
+			{
+				TextureMip Mip;
+				Downsample(t_OutMips.back(), t_Usage, Mip);
+				t_OutMips.emplace_back(std::move(Mip));
+			}
+		}
+
+		bool Cook(const std::string& t_SourcePath, const std::string& t_CookedPath, TextureUsage t_Usage, bool t_CompactColor, TextureCookStats* t_OutStats)
+		{
+			int Width = 0;
+			int Height = 0;
+			int Channels = 0;
+			stbi_uc* Pixels = stbi_load(t_SourcePath.c_str(), &Width, &Height, &Channels, STBI_rgb_alpha);
+			if (!Pixels)
+			{
+				F_LOG_ERROR("Failed to load image file: {}", t_SourcePath);
+				return false;
+			}
+
+			TextureMip Image;
+			Image.Width = static_cast<UINT32>(Width);
+			Image.Height = static_cast<UINT32>(Height);
+			Image.Pixels.assign(Pixels, Pixels + static_cast<size_t>(Width) * Height * 4);
+			stbi_image_free(Pixels);
+
+			const BlockFormat Format = SelectBlockFormat(t_Usage, Image, t_CompactColor);
+
+			std::vector<TextureMip> Mips;
+			GenerateMips(std::move(Image), t_Usage, Mips);
+
+			TextureCookStats Stats = {};
+			Stats.Format = Format;
+			Stats.MipCount = static_cast<UINT32>(Mips.size());
+
+			std::vector<std::vector<UINT8>> Levels(Mips.size());
+			for (size_t i = 0; i < Mips.size(); ++i)
+			{
+				BlockCompression::CompressImage(Format, Mips[i].Pixels.data(), Mips[i].Width, Mips[i].Height, Levels[i]);
+				Stats.SourceSize += Mips[i].Pixels.size();
+				Stats.CompressedSize += Levels[i].size();
+			}
+
+			std::vector<UINT8> Decoded;
+			BlockCompression::DecompressImage(Format, Levels[0].data(), Mips[0].Width, Mips[0].Height, Decoded);
+			Stats.PSNR = BlockCompression::ComputePSNR(Mips[0].Pixels.data(), Decoded.data(), Mips[0].Width * Mips[0].Height, BlockCompression::GetChannelCount(Format));
+
+			if (t_OutStats)
+			{
+				*t_OutStats = Stats;
+			}
+
+			return TextureFile::Write(t_CookedPath, Format, Mips[0].Width, Mips[0].Height, Levels);
+		}
+	}   // namespace TextureImporter
+}   // namespace Fling
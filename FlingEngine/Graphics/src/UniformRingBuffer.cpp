@@ -0,0 +1,66 @@
+#include "pch.h"
+#include "UniformRingBuffer.h"
+#include "Buffer.h"
+#include "VulkanApp.h"
+#include "PhyscialDevice.h"
+
+namespace Fling
+{
+    UniformRingBuffer::UniformRingBuffer(VkDeviceSize t_SizePerFrame, UINT32 t_FrameCount, VkBufferUsageFlags t_Usage)
+        : m_Ring(t_SizePerFrame * t_FrameCount, t_FrameCount)
+    {
+        if (t_Usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+        {
+            PhysicalDevice* PhysDev = VulkanApp::Get().GetPhysicalDevice();
+            assert(PhysDev);
+            m_Alignment = std::max<VkDeviceSize>(PhysDev->GetDeviceProps().limits.minUniformBufferOffsetAlignment, 1);
+        }
+        else
+        {
+            // Enough for any vertex attribute or std430 member
+            m_Alignment = 16;
+        }
+
+        m_Buffer = std::make_unique<Buffer>(
+            m_Ring.GetCapacity(),
+            t_Usage,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        );
+        m_Buffer->MapMemory();
+        assert(m_Buffer->m_MappedMem);
+    }
+
+    UniformRingBuffer::~UniformRingBuffer()
+    {
+        m_Buffer.reset();
+    }
+
+    void UniformRingBuffer::BeginFrame()
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        m_Ring.BeginFrame();
+    }
+
+    void* UniformRingBuffer::Allocate(VkDeviceSize t_Size, UINT32& t_OutDynamicOffset)
+    {
+        UINT64 Offset = 0;
+        {
+            std::lock_guard<std::mutex> Lock(m_Mutex);
+            if (!m_Ring.Allocate(AlignSize(t_Size), m_Alignment, Offset))
+            {
+                return nullptr;
+            }
+        }
+
+        t_OutDynamicOffset = static_cast<UINT32>(Offset);
+        return static_cast<char*>(m_Buffer->m_MappedMem) + Offset;
+    }
+
+    VkDescriptorBufferInfo* UniformRingBuffer::GetDescriptorInfo(VkDeviceSize t_Range)
+    {
+        m_DescriptorInfo.buffer = m_Buffer->GetVkBuffer();
+        m_DescriptorInfo.offset = 0;
+        m_DescriptorInfo.range = t_Range;
+        return &m_DescriptorInfo;
+    }
+}   // namespace Fling
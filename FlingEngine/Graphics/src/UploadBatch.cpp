@@ -0,0 +1,273 @@
+#include "pch.h"
+#include "UploadBatch.h"
+#include "GraphicsHelpers.h"
+#include "VulkanApp.h"
+#include "LogicalDevice.h"
+
+namespace Fling
+{
+	namespace
+	{
+		void RecordBarrier(VkCommandBuffer t_CmdBuf, VkPipelineStageFlags t_SrcStage, VkPipelineStageFlags t_DstStage, const VkImageMemoryBarrier& t_Barrier)
+		{
+			vkCmdPipelineBarrier(t_CmdBuf, t_SrcStage, t_DstStage, 0, 0, nullptr, 0, nullptr, 1, &t_Barrier);
+		}
+
+		void RecordBarrier(VkCommandBuffer t_CmdBuf, VkPipelineStageFlags t_SrcStage, VkPipelineStageFlags t_DstStage, const VkBufferMemoryBarrier& t_Barrier)
+		{
+			vkCmdPipelineBarrier(t_CmdBuf, t_SrcStage, t_DstStage, 0, 0, nullptr, 1, &t_Barrier, 0, nullptr);
+		}
+
+		/**
+		 * Make the copies into a resource visible to the graphics queue. With a dedicated transfer queue this
+		 * is a release on the copy command buffer and a matching acquire on the graphics one
+		 */
+		template<typename BarrierType>
+		void RecordHandOff(const UploadContext& t_Context, VkCommandBuffer t_CopyCmdBuf, VkCommandBuffer t_GraphicsCmdBuf, BarrierType t_Barrier, VkPipelineStageFlags t_DstStage, VkAccessFlags t_DstAccess)
+		{
+			t_Barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+			if (!t_Context.HasTransferQueue())
+			{
+				t_Barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				t_Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				t_Barrier.dstAccessMask = t_DstAccess;
+				RecordBarrier(t_CopyCmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, t_DstStage, t_Barrier);
+				return;
+			}
+
+			// Both halves have to describe the same transfer, only the access masks are ignored by the other queue
+			t_Barrier.srcQueueFamilyIndex = t_Context.GetTransferFamily();
+			t_Barrier.dstQueueFamilyIndex = t_Context.GetGraphicsFamily();
+			t_Barrier.dstAccessMask = 0;
+			RecordBarrier(t_CopyCmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, t_Barrier);
+
+			t_Barrier.srcAccessMask = 0;
+			t_Barrier.dstAccessMask = t_DstAccess;
+			RecordBarrier(t_GraphicsCmdBuf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, t_DstStage, t_Barrier);
+		}
+
+		VkCommandBuffer BeginCommandBuffer(VkDevice t_Device, VkCommandPool t_Pool)
+		{
+			VkCommandBufferAllocateInfo AllocInfo = {};
+			AllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			AllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			AllocInfo.commandPool = t_Pool;
+			AllocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer CmdBuf = VK_NULL_HANDLE;
+			VK_CHECK_RESULT(vkAllocateCommandBuffers(t_Device, &AllocInfo, &CmdBuf));
+
+			VkCommandBufferBeginInfo BeginInfo = {};
+			BeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			BeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			VK_CHECK_RESULT(vkBeginCommandBuffer(CmdBuf, &BeginInfo));
+			return CmdBuf;
+		}
+	}
+
+	UploadBatch::UploadBatch()
+	{
+		LogicalDevice* Dev = VulkanApp::Get().GetLogicalDevice();
+		assert(Dev);
+		VkDevice Device = Dev->GetVkDevice();
+
+		m_Context = VulkanApp::Get().GetUploadContext();
+		assert(m_Context);
+		m_BatchId = m_Context->BeginBatch();
+
+		m_CommandBuffer = BeginCommandBuffer(Device, m_Context->GetTransferPool());
+		m_GraphicsCommandBuffer = m_CommandBuffer;
+
+		if (m_Context->HasTransferQueue())
+		{
+			m_GraphicsCommandBuffer = BeginCommandBuffer(Device, m_Context->GetGraphicsPool());
+			m_CopiesComplete = GraphicsHelpers::CreateSemaphore(Device);
+		}
+
+		VkFenceCreateInfo FenceInfo = {};
+		FenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		VK_CHECK_RESULT(vkCreateFence(Device, &FenceInfo, nullptr, &m_Fence));
+	}
+
+	UploadBatch::~UploadBatch()
+	{
+		LogicalDevice* Dev = VulkanApp::Get().GetLogicalDevice();
+		assert(Dev);
+		VkDevice Device = Dev->GetVkDevice();
+
+		// The staging memory and command buffers can't be freed while the GPU is still using them
+		if (m_IsSubmitted)
+		{
+			Wait();
+		}
+
+		m_Context->ReleaseBatch(m_BatchId);
+		m_StagingBuffers.clear();
+
+		vkDestroyFence(Device, m_Fence, nullptr);
+		vkFreeCommandBuffers(Device, m_Context->GetTransferPool(), 1, &m_CommandBuffer);
+
+		if (m_Context->HasTransferQueue())
+		{
+			vkFreeCommandBuffers(Device, m_Context->GetGraphicsPool(), 1, &m_GraphicsCommandBuffer);
+			vkDestroySemaphore(Device, m_CopiesComplete, nullptr);
+		}
+	}
+
+	StagingAllocation UploadBatch::AllocateStaging(VkDeviceSize t_Size, VkDeviceSize t_Alignment)
+	{
+		assert(!m_IsSubmitted);
+
+		StagingAllocation Allocation = {};
+		if (m_Context->AllocateStaging(m_BatchId, t_Size, t_Alignment, Allocation))
+		{
+			return Allocation;
+		}
+
+		if (t_Size > m_Context->GetStagingCapacity())
+		{
+			F_LOG_WARN("Uploading {} bytes which is more than the staging ring can hold, raise StagingBufferSizeMB to avoid a buffer allocation", t_Size);
+		}
+
+		// The ring is full of uploads that are still in flight, so this one gets memory of it's own
+		std::unique_ptr<Buffer>& Staging = m_StagingBuffers.emplace_back(std::make_unique<Buffer>(
+			t_Size,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			nullptr,
+			AllocationStrategy::Linear)
+		);
+		Staging->MapMemory();
+
+		Allocation.Buffer = Staging->GetVkBuffer();
+		Allocation.Offset = 0;
+		Allocation.Data = Staging->m_MappedMem;
+		return Allocation;
+	}
+
+	StagingAllocation UploadBatch::StageData(const void* t_Data, VkDeviceSize t_Size, VkDeviceSize t_Alignment)
+	{
+		assert(t_Data);
+		StagingAllocation Allocation = AllocateStaging(t_Size, t_Alignment);
+		memcpy(Allocation.Data, t_Data, static_cast<size_t>(t_Size));
+		return Allocation;
+	}
+
+	void UploadBatch::CopyBuffer(const StagingAllocation& t_Src, Buffer* t_DstBuffer, VkDeviceSize t_Size)
+	{
+		assert(!m_IsSubmitted && t_Src.Buffer != VK_NULL_HANDLE && t_DstBuffer);
+
+		VkBufferCopy CopyRegion = {};
+		CopyRegion.srcOffset = t_Src.Offset;
+		CopyRegion.dstOffset = 0;
+		CopyRegion.size = t_Size;
+		vkCmdCopyBuffer(m_CommandBuffer, t_Src.Buffer, t_DstBuffer->GetVkBuffer(), 1, &CopyRegion);
+
+		VkBufferMemoryBarrier Barrier = {};
+		Barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		Barrier.buffer = t_DstBuffer->GetVkBuffer();
+		Barrier.offset = 0;
+		Barrier.size = VK_WHOLE_SIZE;
+
+		// Buffers can be used as anything after an upload, vertices, indices or uniforms
+		RecordHandOff(*m_Context, m_CommandBuffer, m_GraphicsCommandBuffer, Barrier, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_READ_BIT);
+	}
+
+	void UploadBatch::TransferImage(VkImage t_Image, VkImageLayout t_OldLayout, VkImageLayout t_NewLayout, UINT32 t_MipLevels, UINT32 t_LayerCount)
+	{
+		assert(!m_IsSubmitted && t_Image != VK_NULL_HANDLE);
+
+		VkImageMemoryBarrier Barrier = {};
+		Barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		Barrier.oldLayout = t_OldLayout;
+		Barrier.newLayout = t_NewLayout;
+		Barrier.image = t_Image;
+		Barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		Barrier.subresourceRange.baseMipLevel = 0;
+		Barrier.subresourceRange.levelCount = t_MipLevels;
+		Barrier.subresourceRange.baseArrayLayer = 0;
+		Barrier.subresourceRange.layerCount = t_LayerCount;
+
+		VkPipelineStageFlags DstStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		VkAccessFlags DstAccess = VK_ACCESS_MEMORY_READ_BIT;
+		if (t_NewLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+		{
+			DstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			DstAccess = VK_ACCESS_SHADER_READ_BIT;
+		}
+		else if (t_NewLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+		{
+			// More transfers on the graphics queue, like blitting the rest of the mip chain
+			DstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			DstAccess = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		}
+
+		RecordHandOff(*m_Context, m_CommandBuffer, m_GraphicsCommandBuffer, Barrier, DstStage, DstAccess);
+	}
+
+	void UploadBatch::Submit()
+	{
+		assert(!m_IsSubmitted);
+
+		VK_CHECK_RESULT(vkEndCommandBuffer(m_CommandBuffer));
+
+		VkSubmitInfo SubmitInfo = {};
+		SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		SubmitInfo.commandBufferCount = 1;
+		SubmitInfo.pCommandBuffers = &m_CommandBuffer;
+
+		if (!m_Context->HasTransferQueue())
+		{
+			VK_CHECK_RESULT(vkQueueSubmit(m_Context->GetGraphicsQueue(), 1, &SubmitInfo, m_Fence));
+			m_IsSubmitted = true;
+			return;
+		}
+
+		VK_CHECK_RESULT(vkEndCommandBuffer(m_GraphicsCommandBuffer));
+
+		// The copies run next to whatever the graphics queue is drawing, then the graphics work picks up after them
+		SubmitInfo.signalSemaphoreCount = 1;
+		SubmitInfo.pSignalSemaphores = &m_CopiesComplete;
+		VK_CHECK_RESULT(vkQueueSubmit(m_Context->GetTransferQueue(), 1, &SubmitInfo, VK_NULL_HANDLE));
+
+		const VkPipelineStageFlags WaitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		VkSubmitInfo GraphicsSubmitInfo = {};
+		GraphicsSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		GraphicsSubmitInfo.waitSemaphoreCount = 1;
+		GraphicsSubmitInfo.pWaitSemaphores = &m_CopiesComplete;
+		GraphicsSubmitInfo.pWaitDstStageMask = &WaitStage;
+		GraphicsSubmitInfo.commandBufferCount = 1;
+		GraphicsSubmitInfo.pCommandBuffers = &m_GraphicsCommandBuffer;
+
+		// The graphics submit can't finish before the copies, so one fence covers both
+		VK_CHECK_RESULT(vkQueueSubmit(m_Context->GetGraphicsQueue(), 1, &GraphicsSubmitInfo, m_Fence));
+		m_IsSubmitted = true;
+	}
+
+	bool UploadBatch::IsComplete() const
+	{
+		if (!m_IsSubmitted)
+		{
+			return false;
+		}
+
+		LogicalDevice* Dev = VulkanApp::Get().GetLogicalDevice();
+		assert(Dev);
+		return vkGetFenceStatus(Dev->GetVkDevice(), m_Fence) == VK_SUCCESS;
+	}
+
+	void UploadBatch::Wait() const
+	{
+		assert(m_IsSubmitted);
+		LogicalDevice* Dev = VulkanApp::Get().GetLogicalDevice();
+		assert(Dev);
+		vkWaitForFences(Dev->GetVkDevice(), 1, &m_Fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+	}
+
+	void UploadBatch::SubmitAndWait()
+	{
+		Submit();
+		Wait();
+	}
+}   // namespace Fling
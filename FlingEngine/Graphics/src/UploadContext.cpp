@@ -0,0 +1,73 @@
+#include "pch.h"
+#include "UploadContext.h"
+#include "GraphicsHelpers.h"
+#include "LogicalDevice.h"
+#include "Buffer.h"
+
+namespace Fling
+{
+	UploadContext::UploadContext(LogicalDevice* t_Device, VkDeviceSize t_StagingSize)
+		: m_Device(t_Device)
+		, m_Ring(t_StagingSize)
+	{
+		assert(m_Device);
+
+		m_TransferFamily = m_Device->GetTransferFamily();
+		m_GraphicsFamily = m_Device->GetGraphicsFamily();
+		m_TransferQueue = m_Device->GetTransferQueue();
+		m_GraphicsQueue = m_Device->GetGraphicsQueue();
+
+		// Batches are short lived and never reset, they are freed back to the pool
+		GraphicsHelpers::CreateCommandPool(&m_GraphicsPool, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, m_GraphicsFamily);
+		if (HasTransferQueue())
+		{
+			GraphicsHelpers::CreateCommandPool(&m_TransferPool, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, m_TransferFamily);
+		}
+
+		m_StagingBuffer = new Buffer(
+			t_StagingSize,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+		);
+		m_StagingBuffer->MapMemory();
+		assert(m_StagingBuffer->m_MappedMem);
+	}
+
+	UploadContext::~UploadContext()
+	{
+		assert(m_Ring.GetUsedSize() == 0 && "Every upload batch has to be destroyed before the upload context");
+
+		if (m_StagingBuffer)
+		{
+			m_StagingBuffer->UnmapMemory();
+			delete m_StagingBuffer;
+			m_StagingBuffer = nullptr;
+		}
+
+		VkDevice Device = m_Device->GetVkDevice();
+		if (m_TransferPool != VK_NULL_HANDLE)
+		{
+			vkDestroyCommandPool(Device, m_TransferPool, nullptr);
+		}
+		vkDestroyCommandPool(Device, m_GraphicsPool, nullptr);
+	}
+
+	bool UploadContext::AllocateStaging(UINT64 t_Batch, VkDeviceSize t_Size, VkDeviceSize t_Alignment, StagingAllocation& t_OutAllocation)
+	{
+		UINT64 Offset = 0;
+		if (!m_Ring.Allocate(t_Batch, t_Size, t_Alignment, Offset))
+		{
+			return false;
+		}
+
+		t_OutAllocation.Buffer = m_StagingBuffer->GetVkBuffer();
+		t_OutAllocation.Offset = Offset;
+		t_OutAllocation.Data = static_cast<char*>(m_StagingBuffer->m_MappedMem) + Offset;
+		return true;
+	}
+
+	void UploadContext::ReleaseBatch(UINT64 t_Batch)
+	{
+		m_Ring.Release(t_Batch);
+	}
+}   // namespace Fling
@@ -0,0 +1,200 @@
+#include "pch.h"
+#include "VertexQuantization.h"
+
+#include <cstring>
+
+namespace Fling
+{
+	namespace VertexQuantization
+	{
+		namespace
+		{
+			INT16 FloatToSnorm16(float t_Value)
+			{
+				return static_cast<INT16>(std::round(glm::clamp(t_Value, -1.0f, 1.0f) * 32767.0f));
+			}
+
+			/** Same as the SNORM vertex formats, where both -32768 and -32767 are -1 */
+			float Snorm16ToFloat(INT16 t_Value)
+			{
+				return std::max(static_cast<float>(t_Value) / 32767.0f, -1.0f);
+			}
+
+			float SignNotZero(float t_Value)
+			{
+				return t_Value >= 0.0f ? 1.0f : -1.0f;
+			}
+		}
+
+		UINT16 FloatToHalf(float t_Value)
+		{
+			UINT32 Bits = 0;
+			std::memcpy(&Bits, &t_Value, sizeof(Bits));
+
+			const UINT32 Sign = (Bits >> 16) & 0x8000;
+			const UINT32 Abs = Bits & 0x7FFFFFFF;
+
+			// Infinity and NaN, keeping NaNs quiet
+			if (Abs >= 0x7F800000)
+			{
+				return static_cast<UINT16>(Sign | 0x7C00 | (Abs > 0x7F800000 ? 0x0200 : 0));
+			}
+
+			// Too large for a half
+			if (Abs >= 0x47800000)
+			{
+				return static_cast<UINT16>(Sign | 0x7C00);
+			}
+
+			// Smaller than the smallest normal half, so this is a multiple of 2^-24
+			if (Abs < 0x38800000)
+			{
+				float AbsValue = 0.0f;
+				std::memcpy(&AbsValue, &Abs, sizeof(AbsValue));
+				return static_cast<UINT16>(Sign | static_cast<UINT32>(std::nearbyint(AbsValue * 16777216.0f)));
+			}
+
+			// Rebias the exponent and round the mantissa to nearest even, a carry moves up into the exponent
+			UINT32 Half = ((Abs >> 23) - 112) << 10 | ((Abs >> 13) & 0x3FF);
+			const UINT32 Rest = Abs & 0x1FFF;
+			if (Rest > 0x1000 || (Rest == 0x1000 && (Half & 1)))
+			{
+				++Half;
+			}
+			return static_cast<UINT16>(Sign | Half);
+		}
+
+		float HalfToFloat(UINT16 t_Half)
+		{
+			const UINT32 Sign = static_cast<UINT32>(t_Half & 0x8000) << 16;
+			const UINT32 Exponent = (t_Half >> 10) & 0x1F;
+			const UINT32 Mantissa = t_Half & 0x3FF;
+
+			if (Exponent == 0)
+			{
+				const float Value = static_cast<float>(Mantissa) / 16777216.0f;
+				return Sign ? -Value : Value;
+			}
+
+			UINT32 Bits = 0;
+			if (Exponent == 0x1F)
+			{
+				Bits = Sign | 0x7F800000 | (Mantissa << 13);
+			}
+			else
+			{
+				Bits = Sign | ((Exponent + 112) << 23) | (Mantissa << 13);
+			}
+
+			float Value = 0.0f;
+			std::memcpy(&Value, &Bits, sizeof(Value));
+			return Value;
+		}
+
+		void EncodeOctahedral(const glm::vec3& t_Dir, INT16 t_OutOct[2])
+		{
+			const float L1 = std::abs(t_Dir.x) + std::abs(t_Dir.y) + std::abs(t_Dir.z);
+			if (L1 <= 0.0f)
+			{
+				t_OutOct[0] = t_OutOct[1] = 0;
+				return;
+			}
+
+			float X = t_Dir.x / L1;
+			float Y = t_Dir.y / L1;
+
+			// Fold the lower half of the octahedron over the upper half
+			if (t_Dir.z < 0.0f)
+			{
+				const float FoldedX = (1.0f - std::abs(Y)) * SignNotZero(X);
+				const float FoldedY = (1.0f - std::abs(X)) * SignNotZero(Y);
+				X = FoldedX;
+				Y = FoldedY;
+			}
+
+			t_OutOct[0] = FloatToSnorm16(X);
+			t_OutOct[1] = FloatToSnorm16(Y);
+		}
+
+		glm::vec3 DecodeOctahedral(const INT16 t_Oct[2])
+		{
+			glm::vec3 Dir(Snorm16ToFloat(t_Oct[0]), Snorm16ToFloat(t_Oct[1]), 0.0f);
+			Dir.z = 1.0f - std::abs(Dir.x) - std::abs(Dir.y);
+
+			const float Fold = std::max(-Dir.z, 0.0f);
+			Dir.x += Dir.x >= 0.0f ? -Fold : Fold;
+			Dir.y += Dir.y >= 0.0f ? -Fold : Fold;
+
+			return glm::normalize(Dir);
+		}
+
+		VertexDequantize GetDequantize(const BoundingBox& t_Bounds)
+		{
+			VertexDequantize Dequantize = {};
+			if (t_Bounds.IsValid())
+			{
+				Dequantize.Offset = glm::vec4(t_Bounds.Min, 0.0f);
+				Dequantize.Scale = glm::vec4(t_Bounds.Max - t_Bounds.Min, 0.0f);
+			}
+			return Dequantize;
+		}
+
+		bool CanPack(const std::vector<Vertex>& t_Verts)
+		{
+			const glm::vec3 White(1.0f);
+			for (const Vertex& Vert : t_Verts)
+			{
+				if (Vert.Color != White)
+				{
+					return false;
+				}
+			}
+			return !t_Verts.empty();
+		}
+
+		PackedVertex Pack(const Vertex& t_Vert, const VertexDequantize& t_Dequantize)
+		{
+			PackedVertex Packed = {};
+			for (UINT32 i = 0; i < 3; ++i)
+			{
+				// Flat axes have no scale and always decode to the offset
+				const float Scale = t_Dequantize.Scale[i];
+				const float Normalized = Scale > 0.0f ? (t_Vert.Pos[i] - t_Dequantize.Offset[i]) / Scale : 0.0f;
+				Packed.Pos[i] = static_cast<UINT16>(std::round(glm::clamp(Normalized, 0.0f, 1.0f) * 65535.0f));
+			}
+
+			EncodeOctahedral(t_Vert.Normal, Packed.Normal);
+			EncodeOctahedral(t_Vert.Tangent, Packed.Tangent);
+
+			Packed.TexCoord[0] = FloatToHalf(t_Vert.TexCoord.x);
+			Packed.TexCoord[1] = FloatToHalf(t_Vert.TexCoord.y);
+
+			return Packed;
+		}
+
+		Vertex Unpack(const PackedVertex& t_Vert, const VertexDequantize& t_Dequantize)
+		{
+			Vertex Vert = {};
+			for (UINT32 i = 0; i < 3; ++i)
+			{
+				Vert.Pos[i] = t_Dequantize.Offset[i] + static_cast<float>(t_Vert.Pos[i]) / 65535.0f * t_Dequantize.Scale[i];
+			}
+
+			Vert.Color = glm::vec3(1.0f);
+			Vert.Normal = DecodeOctahedral(t_Vert.Normal);
+			Vert.Tangent = DecodeOctahedral(t_Vert.Tangent);
+			Vert.TexCoord = glm::vec2(HalfToFloat(t_Vert.TexCoord[0]), HalfToFloat(t_Vert.TexCoord[1]));
+
+			return Vert;
+		}
+
+		void PackVertices(const std::vector<Vertex>& t_Verts, const VertexDequantize& t_Dequantize, std::vector<PackedVertex>& t_OutVerts)
+		{
+			t_OutVerts.resize(t_Verts.size());
+			for (size_t i = 0; i < t_Verts.size(); ++i)
+			{
+				t_OutVerts[i] = Pack(t_Verts[i], t_Dequantize);
+			}
+		}
+	}   // namespace VertexQuantization
+}   // namespace Fling
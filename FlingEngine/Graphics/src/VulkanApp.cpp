@@ -17,6 +17,19 @@
 #include "GraphicsHelpers.h"
 #include "DepthBuffer.h"
 #include "BaseEditor.h"
+#include "DeviceMemoryAllocator.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
+#include "LodSelector.h"
+#include "PipelineCacheManager.h"
+#include "DescriptorLayoutCache.h"
+#include "GpuFrameTimer.h"
+#include "UploadContext.h"
+#include "Texture.h"
+#include "Stats.h"
+
+#include <algorithm>
+#include <chrono>
 
 namespace Fling
 {
@@ -26,13 +39,27 @@ namespace Fling
 
 		Prepare();
 
-		// #TODO Build VMA allocator
-
 		BuildRenderPipelines(t_Conf, t_Reg, t_Editor);
 
 		F_LOG_TRACE("Vulkan App Init!");
 	}
 
+	void VulkanApp::InitHeadless()
+	{
+		Singleton<VulkanApp>::Init();
+
+		m_Instance = new Instance(/* t_Presentable */ false);
+		assert(m_Instance);
+
+		PrepareDevices();
+
+		const float Width = static_cast<float>(FlingConfig::GetInt("Engine", "WindowWidth", FLING_DEFAULT_WINDOW_WIDTH));
+		const float Height = static_cast<float>(FlingConfig::GetInt("Engine", "WindowHeight", FLING_DEFAULT_WINDOW_HEIGHT));
+		PrepareFrameResources(Width / std::max(Height, 1.0f));
+
+		F_LOG_TRACE("Vulkan App Init headless!");
+	}
+
 	void VulkanApp::Prepare()
 	{
 		CreateGameWindow(
@@ -45,25 +72,85 @@ namespace Fling
 
 		m_CurrentWindow->CreateSurface(m_Instance->GetRawVkInstance(), &m_Surface);
 
+		PrepareDevices();
+
+		m_SwapChain = new Swapchain(ChooseSwapExtent(), m_LogicalDevice, m_PhysicalDevice, m_Surface);
+		assert(m_SwapChain);
+
+		PrepareFrameResources(m_CurrentWindow->GetAspectRatio());
+
+		BuildSwapChainResources();
+	}
+
+	void VulkanApp::PrepareDevices()
+	{
 		m_PhysicalDevice = new PhysicalDevice(m_Instance);
 		assert(m_PhysicalDevice);
 
+		// Textures pick between their cooked and source data on the loading threads, which can't query the device
+		Texture::CacheFormatSupport(m_PhysicalDevice);
+
 		m_LogicalDevice = new LogicalDevice(m_Instance, m_PhysicalDevice, m_Surface);
 		assert(m_LogicalDevice);
 
-		m_SwapChain = new Swapchain(ChooseSwapExtent(), m_LogicalDevice, m_PhysicalDevice, m_Surface);
-		assert(m_SwapChain);
+		m_MemoryAllocator = new DeviceMemoryAllocator(
+			m_PhysicalDevice->GetMemoryProperties(),
+			m_PhysicalDevice->GetDeviceProps().limits.nonCoherentAtomSize,
+			std::make_unique<VulkanMemoryBackend>(m_LogicalDevice->GetVkDevice())
+		);
+		assert(m_MemoryAllocator);
+
+		m_PipelineCache = new PipelineCacheManager(
+			m_LogicalDevice->GetVkDevice(),
+			m_PhysicalDevice->GetDeviceProps(),
+			FlingPaths::EngineConfigDir() + "/" + PipelineCacheManager::FileName
+		);
+		assert(m_PipelineCache);
 
+		m_LayoutCache = new DescriptorLayoutCache(m_LogicalDevice->GetVkDevice());
+		assert(m_LayoutCache);
+	}
+
+	void VulkanApp::PrepareFrameResources(float t_AspectRatio)
+	{
 		GraphicsHelpers::CreateCommandPool(&m_CommandPool, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
 
+		// Every upload is copied out of this ring, anything bigger gets a staging buffer of it's own
+		const INT32 StagingSizeMB = std::max(FlingConfig::GetInt("Vulkan", "StagingBufferSizeMB", 32), 1);
+		m_UploadContext = new UploadContext(m_LogicalDevice, static_cast<VkDeviceSize>(StagingSizeMB) * 1024ull * 1024ull);
+		assert(m_UploadContext);
+
+		// More frames in flight let the CPU run further ahead of the GPU at the cost of latency
+		const INT32 FramesInFlight = FlingConfig::GetInt("Vulkan", "FramesInFlight", 2);
+		m_FramesInFlight = static_cast<UINT32>(std::clamp(FramesInFlight, 1, VkConfig::MAX_FRAMES_IN_FLIGHT));
+		if (m_FramesInFlight != static_cast<UINT32>(FramesInFlight))
+		{
+			F_LOG_WARN("{} frames in flight is not supported, using {}", FramesInFlight, m_FramesInFlight);
+		}
+
 		CreateFrameSyncResources();
 
+		m_FrameTimer = new GpuFrameTimer(m_LogicalDevice, m_CommandPool, m_FramesInFlight);
+		assert(m_FrameTimer);
+
 		// Create the camera
 		float CamMoveSpeed = FlingConfig::GetFloat("Camera", "MoveSpeed", 10.0f);
 		float CamRotSpeed = FlingConfig::GetFloat("Camera", "RotationSpeed", 40.0f);
-		m_Camera = new FirstPersonCamera(m_CurrentWindow->GetAspectRatio(), CamMoveSpeed, CamRotSpeed);
+		m_Camera = new FirstPersonCamera(t_AspectRatio, CamMoveSpeed, CamRotSpeed);
 
-		BuildSwapChainResources();
+		m_FrustumCuller = new FrustumCuller();
+
+		m_OcclusionCuller = new OcclusionCuller(
+			static_cast<UINT32>(std::max(FlingConfig::GetInt("Culling", "OcclusionBufferWidth", 256), 1)),
+			static_cast<UINT32>(std::max(FlingConfig::GetInt("Culling", "OcclusionBufferHeight", 144), 1)),
+			static_cast<UINT32>(std::max(FlingConfig::GetInt("Culling", "MaxOccluders", 32), 0)),
+			FlingConfig::GetFloat("Culling", "MinOccluderSize", 0.2f));
+		m_OcclusionCuller->SetEnabled(FlingConfig::GetBool("Culling", "EnableOcclusionCulling", true));
+
+		m_LodSelector = new LodSelector(
+			FlingConfig::GetFloat("Lod", "MaxScreenError", 0.002f),
+			FlingConfig::GetFloat("Lod", "Hysteresis", 0.25f));
+		m_LodSelector->SetEnabled(FlingConfig::GetBool("Lod", "EnableLods", true));
 	}
 
 	void VulkanApp::BuildSwapChainResources()
@@ -72,8 +159,8 @@ namespace Fling
 		m_SwapChainClearVals[0].color = { 0.0f, 0.0f, 0.0f, 0.2F };
 		m_SwapChainClearVals[1].depthStencil = { 1.0f, ~0U };
 
-		// Build command buffers (one for each swap chain image)
-		for (size_t i = 0; i < m_SwapChain->GetImageViewCount(); ++i)
+		// Build command buffers (one for each frame in flight)
+		for (UINT32 i = 0; i < m_FramesInFlight; ++i)
 		{
 			m_DrawCmdBuffers.emplace_back(new CommandBuffer(m_LogicalDevice, m_CommandPool));
 		}
@@ -128,10 +215,11 @@ namespace Fling
 		VkSubpassDependency dependency = {};
 		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
 		dependency.dstSubpass = 0;
-		dependency.srcStageMask = m_WaitStages;
-		dependency.srcAccessMask = 0;
-		dependency.dstStageMask = m_WaitStages;
-		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		// The depth buffer is shared by every frame in flight, so clearing it has to wait for the last frame's depth tests
+		dependency.srcStageMask = m_WaitStages | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependency.dstStageMask = m_WaitStages | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
 		std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
 		VkRenderPassCreateInfo renderPassInfo = {};
@@ -181,15 +269,15 @@ namespace Fling
 	{
 		assert(m_LogicalDevice);
 
-		m_PresentCompleteSemaphores.resize(VkConfig::MAX_FRAMES_IN_FLIGHT);
-		m_RenderFinishedSemaphores.resize(VkConfig::MAX_FRAMES_IN_FLIGHT);
-		m_InFlightFences.resize(VkConfig::MAX_FRAMES_IN_FLIGHT);
+		m_PresentCompleteSemaphores.resize(m_FramesInFlight);
+		m_RenderFinishedSemaphores.resize(m_FramesInFlight);
+		m_InFlightFences.resize(m_FramesInFlight);
 
 		VkFenceCreateInfo fenceInfo = {};
 		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-		for (INT32 i = 0; i < VkConfig::MAX_FRAMES_IN_FLIGHT; i++)
+		for (UINT32 i = 0; i < m_FramesInFlight; i++)
 		{
 			m_PresentCompleteSemaphores[i] = GraphicsHelpers::CreateSemaphore(m_LogicalDevice->GetVkDevice());
 			m_RenderFinishedSemaphores[i] = GraphicsHelpers::CreateSemaphore(m_LogicalDevice->GetVkDevice());
@@ -239,30 +327,40 @@ namespace Fling
 
 	void VulkanApp::BuildRenderPipelines(PipelineFlags t_Conf, entt::registry& t_Reg, std::shared_ptr<Fling::BaseEditor> t_Editor)
 	{
+		// Every subpass goes into the same render graph, which orders them by what they read and write
+		std::vector<std::unique_ptr<Subpass>> Subpasses = {};
+
 		if (t_Conf & PipelineFlags::DEFERRED)
 		{
 			F_LOG_TRACE("Bulid DEFERRED render pipeline!");
-			std::vector<std::unique_ptr<Subpass>> Subpasses = {};
 
 			// Offscreen pipeline ------
-			// These shaders have vertex input and fill in the buffers that the final pass uses
-			std::shared_ptr<Fling::Shader> OffscreenVert = Shader::Create(HS("Shaders/Deferred/mrt_vert.spv"), m_LogicalDevice);
-			std::shared_ptr<Fling::Shader> OffscreenFrag = Shader::Create(HS("Shaders/Deferred/mrt_frag.spv"), m_LogicalDevice);
-			Subpasses.emplace_back(std::make_unique<OffscreenSubpass>(m_LogicalDevice, m_SwapChain, t_Reg, m_Camera, OffscreenVert, OffscreenFrag));
+			// These shaders have vertex and instance input and fill in the buffers that the final pass uses
+			std::shared_ptr<Fling::Shader> OffscreenVert = Shader::Create(HS("Shaders/Deferred/mrt_instanced_vert.spv"), m_LogicalDevice);
+			// Models with packed vertices are drawn with a variant of the vertex shader that unpacks them
+			std::shared_ptr<Fling::Shader> OffscreenPackedVert = Shader::Create(HS("Shaders/Deferred/mrt_instanced_packed_vert.spv"), m_LogicalDevice);
+
+			// Bindless materials sample from one big texture array, without descriptor indexing every material gets it's own set
+			UINT32 BindlessTextureCount = 0;
+			if (m_PhysicalDevice->SupportsBindless() && FlingConfig::GetBool("Vulkan", "EnableBindless", true))
+			{
+				BindlessTextureCount = std::min(m_PhysicalDevice->GetMaxBindlessTextures(), OffscreenSubpass::MaxBindlessTextures);
+			}
+			std::shared_ptr<Fling::Shader> OffscreenFrag = BindlessTextureCount > 0 ?
+				Shader::Create(HS("Shaders/Deferred/mrt_bindless_frag.spv"), m_LogicalDevice) :
+				Shader::Create(HS("Shaders/Deferred/mrt_frag.spv"), m_LogicalDevice);
+
+			std::unique_ptr<OffscreenSubpass> Offscreen = std::make_unique<OffscreenSubpass>(
+				m_LogicalDevice, m_SwapChain, t_Reg, m_Camera, m_OcclusionCuller, OffscreenVert, OffscreenFrag, OffscreenPackedVert, BindlessTextureCount);
 
 			// Create geometry pass ------
 			// These shaders do not have any vertex input and do the final processing to the screen
-			OffscreenSubpass* Offscreen = static_cast<OffscreenSubpass*>(Subpasses[0].get());
-			assert(Offscreen);
 			FrameBuffer* OffscreenBuf = Offscreen->GetOffscreenFrameBuffer();
+			Subpasses.emplace_back(std::move(Offscreen));
 			assert(OffscreenBuf);
 			std::shared_ptr<Fling::Shader> GeomVert = Shader::Create(HS("Shaders/Deferred/deferred_vert.spv"), m_LogicalDevice);
 			std::shared_ptr<Fling::Shader> GeomFrag = Shader::Create(HS("Shaders/Deferred/deferred_frag.spv"), m_LogicalDevice);
 			Subpasses.emplace_back(std::make_unique<GeometrySubpass>(m_LogicalDevice, m_SwapChain, t_Reg, m_RenderPass, m_Camera, OffscreenBuf, GeomVert, GeomFrag));
-
-			m_RenderPipelines.emplace_back(
-				new Fling::RenderPipeline(t_Reg, m_LogicalDevice, m_SwapChain, Subpasses)
-			);
 		}
 
 		if (t_Conf & PipelineFlags::REFLECTIONS)
@@ -279,35 +377,31 @@ namespace Fling
 		/*if (t_Conf & PipelineFlags::DEBUG)
 		{
 			F_LOG_WARN("Build DEBUG render pipeline!");
-			std::vector<std::unique_ptr<Subpass>> Subpasses = {};
-
 			std::shared_ptr<Fling::Shader> DebugVert = Shader::Create(HS("Shaders/Debug/debug_vert.spv"), m_LogicalDevice);
 			std::shared_ptr<Fling::Shader> DebugFrag = Shader::Create(HS("Shaders/Debug/debug_frag.spv"), m_LogicalDevice);
-			Subpasses.emplace_back(std::make_unique<DebugSubpass>(m_LogicalDevice, m_SwapChain, t_Reg, m_RenderPass, m_Camera, DebugVert, DebugFrag));
-
-			m_RenderPipelines.emplace_back(
-				new Fling::RenderPipeline(t_Reg, m_LogicalDevice, m_SwapChain, Subpasses)
-			);
+			Subpasses.emplace_back(std::make_unique<DebugSubpass>(m_LogicalDevice, m_SwapChain, t_Reg, m_RenderPass, m_Camera, m_FrustumCuller, DebugVert, DebugFrag));
 		}*/
 
 		if (t_Conf & PipelineFlags::IMGUI)
 		{
 #if WITH_IMGUI
 			F_LOG_TRACE("Bulid IMGUI render pipeline! ");
-			std::vector<std::unique_ptr<Subpass>> Subpasses = {};
 			std::shared_ptr<Fling::Shader> ImGuiVert = Shader::Create(HS("Shaders/imgui/ui.vert.spv"), m_LogicalDevice);
 			std::shared_ptr<Fling::Shader> ImGuiFrag = Shader::Create(HS("Shaders/imgui/ui.frag.spv"), m_LogicalDevice);
 			Subpasses.emplace_back(std::make_unique<ImGuiSubpass>(
 				m_LogicalDevice, m_SwapChain, t_Reg, m_CurrentWindow, m_RenderPass, t_Editor, ImGuiVert, ImGuiFrag)
 			);
-
-			m_RenderPipelines.emplace_back(
-				new Fling::RenderPipeline(t_Reg, m_LogicalDevice, m_SwapChain, Subpasses)
-			);
 #else
 			F_LOG_ERROR("IMGUI requested but failed because the CMake flag is not set!");
 #endif
 		}
+
+		assert(!Subpasses.empty() && "Render pipeline should contain at least one sub-pass");
+		m_RenderPipeline = new Fling::RenderPipeline(t_Reg, m_LogicalDevice, m_SwapChain, m_MemoryAllocator, Subpasses);
+
+		m_PipelineCache->ReportCreationTime();
+		F_LOG_TRACE("Created {} descriptor set layouts and {} pipeline layouts for {} requests", 
+			m_LayoutCache->GetSetLayoutCount(), m_LayoutCache->GetPipelineLayoutCount(), m_LayoutCache->GetRequestCount());
 	}
 
 	void VulkanApp::Update(float DeltaTime, entt::registry& t_Reg)
@@ -316,12 +410,32 @@ namespace Fling
 		m_CurrentWindow->Update();
 		m_Camera->Update(DeltaTime);
 
+		// Find what is visible before any of the subpasses record their draws
+		m_FrustumCuller->Cull(t_Reg, *m_Camera);
+		m_OcclusionCuller->Cull(t_Reg, *m_Camera, m_FrustumCuller->GetVisibleEntities());
+		m_LodSelector->Select(t_Reg, *m_Camera, m_OcclusionCuller->GetVisibleEntities());
+
+		// Command buffers and per frame buffers belong to the frame in flight, only the frame buffer and 
+		// the render graph back buffer belong to the swap chain image
+		const UINT32 ActiveFrame = static_cast<UINT32>(CurrentFrameIndex);
+
+		// Wait until the GPU is done with the last frame that used these resources. With more than one frame in 
+		// flight this is usually long done, and the CPU only blocks here if it is a whole frame budget ahead
+		const auto WaitStart = std::chrono::high_resolution_clock::now();
+		vkWaitForFences(m_LogicalDevice->GetVkDevice(), 1, &m_InFlightFences[ActiveFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+		const std::chrono::duration<float> WaitTime = std::chrono::high_resolution_clock::now() - WaitStart;
+		Stats::Frames::TickCpuWaitStats(WaitTime.count());
+
+		float GpuMilliseconds = 0.0f;
+		if (m_FrameTimer->ReadFrameTime(ActiveFrame, GpuMilliseconds))
+		{
+			Stats::Frames::TickGpuStats(GpuMilliseconds / 1000.0f);
+		}
+
 		// Aquire the active image index
-		VkResult iResult = m_SwapChain->AquireNextImage(m_PresentCompleteSemaphores[CurrentFrameIndex]);
+		VkResult iResult = m_SwapChain->AquireNextImage(m_PresentCompleteSemaphores[ActiveFrame]);
 		UINT32  ImageIndex = m_SwapChain->GetActiveImageIndex();
 
-		vkResetFences(m_LogicalDevice->GetVkDevice(), 1, &m_InFlightFences[CurrentFrameIndex]);
-
 		if (iResult == VK_ERROR_OUT_OF_DATE_KHR)
 		{
 			F_LOG_WARN("Swap chain out of date! ");
@@ -332,25 +446,27 @@ namespace Fling
 			F_LOG_FATAL("Failed to acquire swap chain image!");
 		}
 
-		// Fill this with the render pipelines
-		std::vector<VkSemaphore> SemaphoresToWaitOn = {};
-		std::vector<CommandBuffer*> DependentCmdBufs = {};
+		// Only reset the fence once something is going to be submitted with it
+		vkResetFences(m_LogicalDevice->GetVkDevice(), 1, &m_InFlightFences[ActiveFrame]);
 
-		// Vector of command buffers to be sent out with the final swap chain presentation
-		// the swap chain draw buffer is always first
-		std::vector<CommandBuffer*> FinalSubmissionBufs = {};
-		FinalSubmissionBufs.emplace_back(m_DrawCmdBuffers[ImageIndex]);
+		assert(m_RenderPipeline);
+
+		// Subpasses with their own command buffers record first, they don't need the swap chain render pass
+		m_RenderPipeline->RecordCommandBuffers(ActiveFrame, t_Reg, DeltaTime);
 
 		//vkResetCommandPool(m_LogicalDevice->GetVkDevice(), m_CommandPool, 0);
 
 		{
-			// Get the current drawing command buffer associated with the current swap chain image
-			CommandBuffer* CmdBuf = m_DrawCmdBuffers[ImageIndex];
+			// Get the current drawing command buffer of this frame and the frame buffer of the current swap chain image
+			CommandBuffer* CmdBuf = m_DrawCmdBuffers[ActiveFrame];
 			VkFramebuffer FrameBuf = m_SwapChainFrameBuffers[ImageIndex];
 			assert(CmdBuf && FrameBuf != VK_NULL_HANDLE);
 
 			CmdBuf->Begin();
 
+			// Barriers can't be recorded inside of the render pass, so wait for the earlier passes here
+			m_RenderPipeline->RecordBarriers(*CmdBuf, ImageIndex);
+
 			// Start a render pass using the global render pass settings
 			VkRenderPassBeginInfo renderPassBeginInfo = Initializers::RenderPassBeginInfo();
 			renderPassBeginInfo.renderPass = m_RenderPass;
@@ -373,11 +489,7 @@ namespace Fling
 			CmdBuf->SetViewport(0, { viewport });
 			CmdBuf->SetScissor(0, { scissor });
 
-			// Build the command buffers of the render pipelines
-			for (RenderPipeline* Pipeline : m_RenderPipelines)
-			{		
-				Pipeline->Draw(*CmdBuf, FrameBuf, ImageIndex, t_Reg, DeltaTime);
-			}
+			m_RenderPipeline->Draw(*CmdBuf, FrameBuf, ActiveFrame, t_Reg, DeltaTime);
 
 			CmdBuf->EndRenderPass();
 
@@ -385,83 +497,54 @@ namespace Fling
 			CmdBuf->End();
 		}
 
-		// Gather deps for the current frame only
-		for (RenderPipeline* Pipeline : m_RenderPipelines)
+		// Everything goes to the same queue in graph order, so the render graph barriers are all the
+		// synchronization that the passes need between each other
+		std::vector<CommandBuffer*> CmdBufsBefore = {};
+		std::vector<CommandBuffer*> CmdBufsAfter = {};
+		m_RenderPipeline->GatherCommandBuffers(CmdBufsBefore, CmdBufsAfter, ActiveFrame);
+
+		std::vector<VkCommandBuffer> submitCommandBuffers = {};
+		if (m_FrameTimer->IsSupported())
+		{
+			submitCommandBuffers.emplace_back(m_FrameTimer->GetBeginCommandBuffer(ActiveFrame));
+		}
+		for (CommandBuffer* Buf : CmdBufsBefore)
 		{
-			// Gather the dependencies 
-			Pipeline->GatherPresentDependencies(DependentCmdBufs, SemaphoresToWaitOn, ImageIndex, CurrentFrameIndex);
-			Pipeline->GatherPresentBuffers(FinalSubmissionBufs, ImageIndex);
+			submitCommandBuffers.emplace_back(Buf->GetHandle());
+		}
+		submitCommandBuffers.emplace_back(m_DrawCmdBuffers[ActiveFrame]->GetHandle());
+		for (CommandBuffer* Buf : CmdBufsAfter)
+		{
+			submitCommandBuffers.emplace_back(Buf->GetHandle());
+		}
+		if (m_FrameTimer->IsSupported())
+		{
+			submitCommandBuffers.emplace_back(m_FrameTimer->GetEndCommandBuffer(ActiveFrame));
 		}
 
 		// Wait for the color attachment to be done 
 		VkPipelineStageFlags waitStages[] = { m_WaitStages };
 
-		// Submit any PIPELINE command buffers for work		
 		VkSubmitInfo FinalScreenSubmitInfo = {};
 		FinalScreenSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 		FinalScreenSubmitInfo.pWaitDstStageMask = waitStages;
-
-		// If There are dependent semaphores, then wait for them
-		// otherwise wait for the present 
-		if (!SemaphoresToWaitOn.empty() && !DependentCmdBufs.empty())
-		{
-			// Submit sub pass command buffers with their waits
-			VkSubmitInfo OffscreenSubmission = {};
-			OffscreenSubmission.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-			OffscreenSubmission.pWaitDstStageMask = waitStages;
-			// Wait on Present complete
-			OffscreenSubmission.pWaitSemaphores = &m_PresentCompleteSemaphores[CurrentFrameIndex];
-			OffscreenSubmission.waitSemaphoreCount = 1;
-
-			// Signal that the dependent semaphores are done when this is complete
-			OffscreenSubmission.pSignalSemaphores = SemaphoresToWaitOn.data();
-			OffscreenSubmission.signalSemaphoreCount = (UINT32)SemaphoresToWaitOn.size();
-
-			// Mark the draw command buffer at this frame for submission
-			std::vector<VkCommandBuffer> submitCommandBuffers = {};
-			
-			for (CommandBuffer* Buf : DependentCmdBufs)
-			{
-				submitCommandBuffers.emplace_back(Buf->GetHandle());
-			}
-
-			OffscreenSubmission.pCommandBuffers = submitCommandBuffers.data();
-			OffscreenSubmission.commandBufferCount = (UINT32)submitCommandBuffers.size();
-			// Signal off screen semaphore when this is completed
-			VK_CHECK_RESULT(vkQueueSubmit(m_LogicalDevice->GetGraphicsQueue(), 1, &OffscreenSubmission, VK_NULL_HANDLE));
-
-			// Wait for dependent semaphores
-			FinalScreenSubmitInfo.waitSemaphoreCount = (UINT32)SemaphoresToWaitOn.size();
-			FinalScreenSubmitInfo.pWaitSemaphores = SemaphoresToWaitOn.data();
-		}
-		else
-		{
-			// Track any semaphores that we may need to wait on for the render pipeline
-			FinalScreenSubmitInfo.waitSemaphoreCount = 1;
-			FinalScreenSubmitInfo.pWaitSemaphores = &m_PresentCompleteSemaphores[CurrentFrameIndex];
-		}
-		
-		// Collect any addition command buffers that we want to submit, but are not dependent on offscreen
-		std::vector<VkCommandBuffer> submitCommandBuffers = {};
-		for (CommandBuffer* buf : FinalSubmissionBufs)
-		{
-			submitCommandBuffers.emplace_back(buf->GetHandle());
-		}
+		FinalScreenSubmitInfo.waitSemaphoreCount = 1;
+		FinalScreenSubmitInfo.pWaitSemaphores = &m_PresentCompleteSemaphores[ActiveFrame];
 
 		FinalScreenSubmitInfo.pCommandBuffers = submitCommandBuffers.data();
 		FinalScreenSubmitInfo.commandBufferCount = (UINT32)submitCommandBuffers.size();
 
 		// Actually present the swap chain queue. This is always going to be the signal for the final semaphore
 		FinalScreenSubmitInfo.signalSemaphoreCount = 1;
-		FinalScreenSubmitInfo.pSignalSemaphores = &m_RenderFinishedSemaphores[CurrentFrameIndex];
+		FinalScreenSubmitInfo.pSignalSemaphores = &m_RenderFinishedSemaphores[ActiveFrame];
+
+		// The fence is waited on the next time this frame comes around, not here, so the CPU can 
+		// start on the next frame while the GPU draws this one
+		VK_CHECK_RESULT(vkQueueSubmit(m_LogicalDevice->GetGraphicsQueue(), 1, &FinalScreenSubmitInfo, m_InFlightFences[ActiveFrame]));
+		m_FrameTimer->OnSubmitted(ActiveFrame);
 
-		VK_CHECK_RESULT(vkQueueSubmit(m_LogicalDevice->GetGraphicsQueue(), 1, &FinalScreenSubmitInfo, m_InFlightFences[CurrentFrameIndex]));
-		
-		// Finish up the frame by setting the in flight fences to wait -----
-		vkWaitForFences(m_LogicalDevice->GetVkDevice(), 1, &m_InFlightFences[CurrentFrameIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
-	
 		// Present the swap chain with the renderer finished semaphore
-		iResult = m_SwapChain->QueuePresent(m_LogicalDevice->GetPresentQueue(), m_RenderFinishedSemaphores[CurrentFrameIndex]);
+		iResult = m_SwapChain->QueuePresent(m_LogicalDevice->GetPresentQueue(), m_RenderFinishedSemaphores[ActiveFrame]);
 		
 		// Check if the swap chain is out of date and needs to be rebuilt
 		if (iResult == VK_ERROR_OUT_OF_DATE_KHR || iResult == VK_SUBOPTIMAL_KHR)
@@ -474,7 +557,7 @@ namespace Fling
 		}
 
 		// Update the current in flight frame index!
-		CurrentFrameIndex = (CurrentFrameIndex + 1) % VkConfig::MAX_FRAMES_IN_FLIGHT;
+		CurrentFrameIndex = (CurrentFrameIndex + 1) % m_FramesInFlight;
 	}
 	
 	VkExtent2D VulkanApp::ChooseSwapExtent()
@@ -511,17 +594,13 @@ namespace Fling
 		// Wait for the device to be ready before shutting down
 		m_LogicalDevice->WaitForIdle();
 
-		// Cleanup render pipelines (created in BuildRenderPipelines) -----------------
-		for (RenderPipeline* pipeline : m_RenderPipelines)
+		// Cleanup the render pipeline (created in BuildRenderPipelines) -----------------
+		if (m_RenderPipeline)
 		{
-			if (pipeline)
-			{
-				pipeline->CleanUp(t_Reg);
-				delete pipeline;
-				pipeline = nullptr;
-			}
+			m_RenderPipeline->CleanUp(t_Reg);
+			delete m_RenderPipeline;
+			m_RenderPipeline = nullptr;
 		}
-		m_RenderPipelines.clear();
 
 		for (size_t i = 0; i < m_SwapChainFrameBuffers.size(); i++)
 		{
@@ -537,6 +616,24 @@ namespace Fling
 			m_Camera = nullptr;
 		}
 
+		if (m_FrustumCuller)
+		{
+			delete m_FrustumCuller;
+			m_FrustumCuller = nullptr;
+		}
+
+		if (m_OcclusionCuller)
+		{
+			delete m_OcclusionCuller;
+			m_OcclusionCuller = nullptr;
+		}
+
+		if (m_LodSelector)
+		{
+			delete m_LodSelector;
+			m_LodSelector = nullptr;
+		}
+
 		// Destroy swap chain (created in Prepare) -----------
 		if (m_SwapChain)
 		{
@@ -550,16 +647,20 @@ namespace Fling
 			m_DepthBuffer = nullptr;
 		}
 
-		// #TODO Cleanup VMA allocator -------------
-
 		// Clean up Frame sync resources (created in CreateFrameSyncResources) --------------
-		for (size_t i = 0; i < VkConfig::MAX_FRAMES_IN_FLIGHT; i++)
+		for (size_t i = 0; i < m_InFlightFences.size(); i++)
 		{
 			vkDestroySemaphore(m_LogicalDevice->GetVkDevice(), m_RenderFinishedSemaphores[i], nullptr);
 			vkDestroySemaphore(m_LogicalDevice->GetVkDevice(), m_PresentCompleteSemaphores[i], nullptr);
 			vkDestroyFence(m_LogicalDevice->GetVkDevice(), m_InFlightFences[i], nullptr);
 		}
 
+		if (m_FrameTimer)
+		{
+			delete m_FrameTimer;
+			m_FrameTimer = nullptr;
+		}
+
 		// Clean up command buffers and command pool -------------
 		for (CommandBuffer* CmdBuf : m_DrawCmdBuffers)
 		{
@@ -573,6 +674,33 @@ namespace Fling
 
 		vkDestroyCommandPool(m_LogicalDevice->GetVkDevice(), m_CommandPool, nullptr);
 
+		// Every resource has finished uploading by now
+		if (m_UploadContext)
+		{
+			delete m_UploadContext;
+			m_UploadContext = nullptr;
+		}
+
+		// Saves the cache for the next run, every pipeline that uses it is gone by now
+		if (m_PipelineCache)
+		{
+			delete m_PipelineCache;
+			m_PipelineCache = nullptr;
+		}
+
+		if (m_LayoutCache)
+		{
+			delete m_LayoutCache;
+			m_LayoutCache = nullptr;
+		}
+
+		// Every resource has to give back it's memory before this ------------
+		if (m_MemoryAllocator)
+		{
+			delete m_MemoryAllocator;
+			m_MemoryAllocator = nullptr;
+		}
+
 		// Clean up devices and surface (created in Prepare) --------------
 		if (m_LogicalDevice)
 		{
@@ -580,7 +708,11 @@ namespace Fling
 			m_LogicalDevice = nullptr;
 		}
 
-		vkDestroySurfaceKHR(m_Instance->GetRawVkInstance(), m_Surface, nullptr);
+		if (m_Surface != VK_NULL_HANDLE)
+		{
+			vkDestroySurfaceKHR(m_Instance->GetRawVkInstance(), m_Surface, nullptr);
+			m_Surface = VK_NULL_HANDLE;
+		}
 
 		if (m_PhysicalDevice)
 		{
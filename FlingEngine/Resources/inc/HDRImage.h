@@ -2,6 +2,7 @@
 
 #include "Resource.h"
 #include "stb_image.h"
+#include "DeviceMemoryAllocator.h"
 
 namespace Fling
 {
@@ -52,9 +53,10 @@ namespace Fling
 
         void CreateTextureSampler();
 
-        void CopyBufferToImage(VkBuffer t_Buffer);
+        /** Copy the first mip level from staging memory that starts at t_Offset */
+        void CopyBufferToImage(VkCommandBuffer t_CommandBuffer, VkBuffer t_Buffer, VkDeviceSize t_Offset);
 
-        void GenerateMipMaps(VkFormat t_ImageFormat);
+        void GenerateMipMaps(VkCommandBuffer t_CommandBuffer, VkFormat t_ImageFormat);
 		const LogicalDevice* m_Device;
         VkImage m_Image;
 
@@ -62,7 +64,7 @@ namespace Fling
 
         VkSampler m_TextureSampler;
 
-        VkDeviceMemory m_Memory;
+        DeviceAllocation m_Memory;
 
         VkDescriptorImageInfo m_ImageInfo = {};
 
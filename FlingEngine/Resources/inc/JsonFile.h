@@ -6,6 +6,7 @@
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <functional>
 #include <nlohmann/json.hpp>
 
 namespace Fling
@@ -19,6 +20,9 @@ namespace Fling
 
 		static std::shared_ptr<Fling::JsonFile> Create(Guid t_ID);
 
+		/** Start loading a JSON file in the background. The data is empty until it is ready */
+		static std::shared_ptr<Fling::JsonFile> CreateAsync(Guid t_ID, std::function<void(std::shared_ptr<JsonFile>)> t_OnLoaded = nullptr);
+
         /**
          * @brief Construct a new JsonFile object
          * 
@@ -26,6 +30,9 @@ namespace Fling
          */
         explicit JsonFile(Guid t_ID);
 
+		/** Construct a JsonFile that will be loaded by the ResourceManager's loading threads */
+		JsonFile(Guid t_ID, AsyncLoadTag);
+
 		virtual ~JsonFile() = default;
         
         /**
@@ -43,10 +50,13 @@ namespace Fling
 
 		nlohmann::json m_JsonData;
 
+		virtual bool LoadFromDisk() override { return LoadJsonFile(); }
+
         /**
          * @brief Loads the JsonFile based on Guid path.
          * @note All Guid paths are relative to the assets directory. 
+         * @return True if the file was opened and parsed
          */
-        void LoadJsonFile();
+        bool LoadJsonFile();
     };
 }   // namespace Fling
\ No newline at end of file
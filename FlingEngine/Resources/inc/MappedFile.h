@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Platform.h"
+#include "FlingTypes.h"
+#include "NonCopyable.hpp"
+
+#include <string>
+
+namespace Fling
+{
+	/**
+	 * @brief	A read only view of a whole file that is mapped into memory by the OS. Pages are
+	 *			read in on demand, so there is no copy into a buffer of our own before using the data.
+	 */
+	class MappedFile : public NonCopyable
+	{
+	public:
+
+		MappedFile() = default;
+
+		/** Map the given file, @see IsOpen to check if it worked */
+		explicit MappedFile(const std::string& t_FilePath);
+
+		~MappedFile();
+
+		MappedFile(MappedFile&&) = delete;
+		MappedFile& operator=(MappedFile&&) = delete;
+
+		/**
+		 * @brief	Map a file, closing any file that is already mapped
+		 * @return	True if the file could be mapped. Empty files can't be mapped.
+		 */
+		bool Open(const std::string& t_FilePath);
+
+		void Close();
+
+		FORCEINLINE bool IsOpen() const { return m_Data != nullptr; }
+
+		FORCEINLINE const UINT8* GetData() const { return m_Data; }
+
+		FORCEINLINE size_t GetSize() const { return m_Size; }
+
+	private:
+
+		const UINT8* m_Data = nullptr;
+
+		size_t m_Size = 0;
+
+#if FLING_WINDOWS
+		HANDLE m_File = INVALID_HANDLE_VALUE;
+		HANDLE m_Mapping = nullptr;
+#endif
+	};
+}   // namespace Fling
@@ -3,8 +3,21 @@
 #include "Platform.h"
 #include "FlingTypes.h"
 
+#include <atomic>
+
 namespace Fling
 {
+	class UploadBatch;
+
+	/**
+	 * @brief	Tag type for resource constructors that should not load anything themselves because
+	 *			the ResourceManager is going to load them on a background thread
+	 * @see ResourceManager::LoadResourceAsync
+	 */
+	struct AsyncLoadTag {};
+
+	static constexpr AsyncLoadTag AsyncLoad {};
+
 	/**
 	* Base class that represents a loaded resource in the engine
 	*/
@@ -13,6 +26,15 @@ namespace Fling
 		friend class ResourceManager;
 
 	public:
+
+		enum class LoadState : UINT8
+		{
+			/** Still being loaded in the background, any placeholder data may be in use */
+			Loading,
+			Ready,
+			Failed
+		};
+
         explicit Resource(Fling::Guid t_ID)
             : m_Guid(t_ID)
         { 
@@ -41,10 +63,36 @@ namespace Fling
          */
         std::string GetFilepathReleativeToAssets() const;
 
+		LoadState GetLoadState() const { return m_LoadState.load(std::memory_order_acquire); }
+
+		/** True once this resource has been fully loaded and any GPU data has been uploaded */
+		bool IsReady() const { return GetLoadState() == LoadState::Ready; }
+
     protected:
 
+		/**
+		 * @brief	Read and decode this resource into CPU memory. Called from a resource loading
+		 *			thread for async loads, so this must not touch Vulkan or any other resource.
+		 * @return	True if the resource was loaded successfully
+		 */
+		virtual bool LoadFromDisk() { return true; }
+
+		/** True if this resource has GPU data that has to be uploaded after LoadFromDisk */
+		virtual bool RequiresUpload() const { return false; }
+
+		/**
+		 * @brief	Record the commands to upload this resource to the GPU into the given batch.
+		 *			Called on the main thread after LoadFromDisk.
+		 */
+		virtual void RecordUpload(UploadBatch& t_Batch) {}
+
+		/** Called on the main thread once the upload of this resource has completed on the GPU */
+		virtual void OnUploadComplete() {}
+
         Fling::Guid m_Guid;
 
 		std::string m_HumanReadableName;
+
+		std::atomic<LoadState> m_LoadState { LoadState::Ready };
 	};
-}	// namespace Fling
\ No newline at end of file
+}	// namespace Fling
@@ -7,6 +7,12 @@
 #include <fstream>
 #include <vector>
 #include <map>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 namespace Fling
 {
@@ -16,6 +22,9 @@ namespace Fling
 	 * as well as a hashed string for easy passing around of information. Each resource is only 
 	 * ever loaded into memory ONCE.
 	 * 
+	 * Resources can also be loaded asynchronously, in which case they are decoded on a loading 
+	 * thread and any GPU uploads are batched together on the main thread during Update.
+	 * 
 	 * @see Fling::Guid
 	 * @see Fling::Guid_Handle
 	 * @see Fling::Resource
@@ -28,12 +37,47 @@ namespace Fling
 
 		virtual void Shutdown() override;
 
+		/** Number of background threads that decode async resources */
+		static constexpr UINT32 LOADER_THREAD_COUNT = 2;
+
 		template<class T, class ...ARGS>
 		static std::shared_ptr<T> LoadResource(Guid t_ID, ARGS&& ... args)
 		{
 			return ResourceManager::Get().LoadResourceImpl<T>(t_ID, std::forward<ARGS>(args)...);
 		}
 
+		/**
+		 * @brief	Start loading a resource in the background and return it right away. The returned
+		 *			resource is not ready to use until IsReady() is true, until then it will use any
+		 *			placeholder data that the resource type provides. Only call from the main thread.
+		 *			T must have a constructor that takes (Guid, AsyncLoadTag).
+		 *
+		 * @param t_OnLoaded 	Optional callback that is called on the main thread once the resource
+		 *						has finished loading, or failed to load. Called immediately if the
+		 *						resource has already been loaded.
+		 */
+		template<class T>
+		static std::shared_ptr<T> LoadResourceAsync(Guid t_ID, std::function<void(std::shared_ptr<T>)> t_OnLoaded = nullptr)
+		{
+			return ResourceManager::Get().LoadResourceAsyncImpl<T>(t_ID, std::move(t_OnLoaded));
+		}
+
+		/**
+		 * @brief	Finish any async loads. Submits the GPU uploads of newly decoded resources and
+		 *			calls the completion callbacks of any resources that are done. Call once per frame
+		 *			from the main thread.
+		 */
+		void Update();
+
+		/** Block until every pending async load has finished */
+		void WaitForAsyncLoads();
+
+		/** Number of async loads that have not been finished yet */
+		FORCEINLINE size_t GetPendingLoadCount() const { return m_PendingCallbacks.size(); }
+
+		/** Incremented every time an async load has finished, useful to know when to refresh descriptors */
+		FORCEINLINE UINT64 GetLoadGeneration() const { return m_LoadGeneration; }
+
 		template <class T>
 		std::shared_ptr<T> GetResourceOfType(Guid_Handle t_ID) const;
 
@@ -56,11 +100,61 @@ namespace Fling
 		template<class T, class ...ARGS>
 		std::shared_ptr<T> LoadResourceImpl(Guid t_ID, ARGS&& ... args);
 
+		template<class T>
+		std::shared_ptr<T> LoadResourceAsyncImpl(Guid t_ID, std::function<void(std::shared_ptr<T>)> t_OnLoaded);
+
+		typedef std::function<void(const std::shared_ptr<Resource>&)> LoadCallback;
+
+		/** Add a callback for when the given resource has finished loading */
+		void AddLoadCallback(const std::shared_ptr<Resource>& t_Resource, LoadCallback t_Callback);
+
+		/** Push the resource onto the queue of the loading threads */
+		void QueueAsyncLoad(const std::shared_ptr<Resource>& t_Resource);
+
+		/** Set the final state of a resource and call any of it's callbacks */
+		void FinishAsyncLoad(const std::shared_ptr<Resource>& t_Resource, Resource::LoadState t_State);
+
+		void LoaderThread();
+
+		struct DecodedResource
+		{
+			std::shared_ptr<Resource> Res;
+			bool Succeeded = false;
+		};
+
+		/** Resources whose GPU uploads are in flight in a single batch */
+		struct InFlightUpload
+		{
+			// Shared so that the batch type can stay incomplete in this header
+			std::shared_ptr<UploadBatch> Batch;
+			std::vector<std::shared_ptr<Resource>> Resources;
+		};
+
 		typedef std::map<Fling::Guid_Handle, std::shared_ptr<Resource>>::iterator ResourceMapIt;
 		typedef std::map<Fling::Guid_Handle, std::shared_ptr<Resource>>::const_iterator ResourceMapConstIt;
         
 		///** Map of currently loaded resources */
 		std::map<Fling::Guid_Handle, std::shared_ptr<Resource>> m_ResourceMap;
+
+		/** Callbacks of each resource that is currently being loaded async. Main thread only */
+		std::map<Fling::Guid_Handle, std::vector<LoadCallback>> m_PendingCallbacks;
+
+		std::vector<std::thread> m_LoaderThreads;
+
+		/** Guards the load queue, decoded resources and running flag */
+		std::mutex m_LoadMutex;
+
+		std::condition_variable m_LoadCondition;
+
+		std::deque<std::shared_ptr<Resource>> m_LoadQueue;
+
+		std::vector<DecodedResource> m_DecodedResources;
+
+		bool m_IsLoading = false;
+
+		std::vector<InFlightUpload> m_InFlightUploads;
+
+		UINT64 m_LoadGeneration = 0;
 	};
 
 
@@ -82,6 +176,44 @@ namespace Fling
 		return std::static_pointer_cast<T>( NewResource );
 	}
 
+	template<class T>
+	inline std::shared_ptr<T> ResourceManager::LoadResourceAsyncImpl(Guid t_ID, std::function<void(std::shared_ptr<T>)> t_OnLoaded)
+	{
+		LoadCallback Callback = nullptr;
+		if (t_OnLoaded)
+		{
+			Callback = [OnLoaded = std::move(t_OnLoaded)](const std::shared_ptr<Resource>& t_Res)
+			{
+				OnLoaded(std::static_pointer_cast<T>(t_Res));
+			};
+		}
+
+		// If this resource exists already then just wait for it to finish
+		if (std::shared_ptr<T> Existing = GetResourceOfType<T>(t_ID))
+		{
+			if (Callback)
+			{
+				AddLoadCallback(Existing, std::move(Callback));
+			}
+			return Existing;
+		}
+
+		std::shared_ptr<T> NewResource = std::make_shared<T>(t_ID, AsyncLoad);
+		NewResource->m_LoadState.store(Resource::LoadState::Loading, std::memory_order_release);
+
+		m_ResourceMap[t_ID] = NewResource;
+
+		// Having an entry in the pending map is what marks this resource as loading
+		std::vector<LoadCallback>& Callbacks = m_PendingCallbacks[t_ID];
+		if (Callback)
+		{
+			Callbacks.emplace_back(std::move(Callback));
+		}
+
+		QueueAsyncLoad(NewResource);
+		return NewResource;
+	}
+
 	template<class T>
 	inline std::shared_ptr<T> ResourceManager::GetResourceOfType(Guid_Handle t_ID) const
 	{
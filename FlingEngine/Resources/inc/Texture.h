@@ -2,9 +2,13 @@
 
 #include "Resource.h"
 #include "stb_image.h"
+#include "DeviceMemoryAllocator.h"
+#include "TextureFile.h"
 
 namespace Fling
 {
+	class PhysicalDevice;
+
     /**
      * @brief   An image represents a 2D file that has data about each pixel in the image
      */
@@ -14,7 +18,29 @@ namespace Fling
 
 		static std::shared_ptr<Fling::Texture> Create(Guid t_ID);
 
+		/** Start loading a texture in the background, it will sample the placeholder texture until it is ready */
+		static std::shared_ptr<Fling::Texture> CreateAsync(Guid t_ID);
+
+		/** A small white texture that is used in place of textures that are loading or failed to load */
+		static std::shared_ptr<Fling::Texture> Placeholder();
+
+		/**
+		 * @brief	Query which block compressed formats the device can sample. Call once the physical device
+		 *			exists and before any textures load, the loading threads only read the cached result
+		 */
+		static void CacheFormatSupport(const PhysicalDevice* t_Device);
+
         explicit Texture(Guid t_ID);
+
+		/** Construct a texture that will be loaded by the ResourceManager's loading threads */
+		Texture(Guid t_ID, AsyncLoadTag);
+
+		/**
+		 * @brief	Create a texture from RGBA8 pixel data in memory
+		 * @param t_ID		The GUID that represents a unique name for this texture. It's up to the user to ensure uniqueness
+		 */
+		Texture(Guid t_ID, UINT32 t_Width, UINT32 t_Height, const void* t_Pixels);
+
         virtual ~Texture();
 
 		FORCEINLINE UINT32 GetWidth() const { return m_Width; }
@@ -46,12 +72,28 @@ namespace Fling
 		*/
 		void Release();
 
+	protected:
+
+		/** Map the cooked texture if there is one that the GPU can sample, otherwise load the pixel data with stb image */
+		virtual bool LoadFromDisk() override;
+
+		virtual bool RequiresUpload() const override { return true; }
+
+		/**
+		 * @brief	Create the Vulkan image and record the copy of the pixel data and the mip map generation.
+		 *			Cooked textures copy every compressed mip level straight out of the file instead.
+		 */
+		virtual void RecordUpload(UploadBatch& t_Batch) override;
+
+		/** Create the image view and sampler now that the image has been uploaded */
+		virtual void OnUploadComplete() override;
+
     private:
 
 		/**
-		* @brief	Loads the Vulkan resources needed for this image
+		* @brief	Upload the pixel data and block until it is on the GPU
 		*/
-		void LoadVulkanImage();
+		void UploadImmediate();
 
         /**
          * @brief Create a Image View object that is needed to sample this image from the swap chain
@@ -60,9 +102,16 @@ namespace Fling
 
 		void CreateTextureSampler();
 
-		void CopyBufferToImage(VkBuffer t_Buffer);
+		/** Copy the first mip level from staging memory that starts at t_Offset */
+		void CopyBufferToImage(VkCommandBuffer t_CommandBuffer, VkBuffer t_Buffer, VkDeviceSize t_Offset);
+
+		/** Copy every mip level of the cooked file from staging memory that starts at t_Offset */
+		void CopyLevelsToImage(VkCommandBuffer t_CommandBuffer, VkBuffer t_Buffer, VkDeviceSize t_Offset);
 
-        void GenerateMipMaps(VkFormat imageFormat);
+		/** True if the device can sample this block compressed format. Safe to call from the loading threads */
+		static bool IsFormatSupported(BlockFormat t_Format);
+
+        void GenerateMipMaps(VkCommandBuffer t_CommandBuffer, VkFormat imageFormat);
 
         /** Width of this image */
 		UINT32 m_Width = 0;
@@ -76,20 +125,23 @@ namespace Fling
         INT32 m_Channels = 0;
 
 		/** The Vulkan image data */
-		VkImage m_vVkImage;
+		VkImage m_vVkImage = VK_NULL_HANDLE;
 
         /** The view of this image for the swap chain */
-        VkImageView m_ImageView;
+        VkImageView m_ImageView = VK_NULL_HANDLE;
 
-		VkSampler m_TextureSampler;
+		VkSampler m_TextureSampler = VK_NULL_HANDLE;
 
 		/** The Vulkan memory resource for this image */
-		VkDeviceMemory m_VkMemory;
+		DeviceAllocation m_VkMemory = {};
 
 		VkDescriptorImageInfo m_ImageInfo{};
         
         /** Pixel data of image **/
-        stbi_uc* m_PixelData;
+        stbi_uc* m_PixelData = nullptr;
+
+		/** The compressed mip chain of a cooked texture, used instead of the pixel data */
+		std::unique_ptr<TextureFile> m_TextureFile;
 
         VkFormat m_Format = VK_FORMAT_R8G8B8A8_UNORM;
     };
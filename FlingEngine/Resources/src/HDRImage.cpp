@@ -6,6 +6,8 @@
 #include "ResourceManager.h"
 #include "GraphicsHelpers.h"
 #include "Buffer.h"
+#include "VulkanApp.h"
+#include "UploadBatch.h"
 
 namespace Fling
 {
@@ -76,14 +78,13 @@ namespace Fling
             m_Memory
         );
 
+        // Copies into the image have to start on a whole texel, which is 3 half floats
+        UploadBatch Batch;
         VkDeviceSize ImageSize = GetImageSize();
-        Buffer StagingBuffer(
-            ImageSize, 
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
-            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, 
-            m_PixelData);
+        StagingAllocation Staging = m_PixelData ? Batch.StageData(m_PixelData, ImageSize, 12) : Batch.AllocateStaging(ImageSize, 12);
 
         GraphicsHelpers::TransitionImageLayout(
+            Batch.GetCommandBuffer(),
             m_Image,
             m_Format,
             VK_IMAGE_LAYOUT_UNDEFINED,
@@ -91,9 +92,13 @@ namespace Fling
             m_MipLevels
         );
 
-        CopyBufferToImage(StagingBuffer.GetVkBuffer());
+        CopyBufferToImage(Batch.GetCommandBuffer(), Staging.Buffer, Staging.Offset);
 
-        GenerateMipMaps(m_Format);
+        // Mip maps are blitted, which needs the graphics queue
+        Batch.TransferImage(m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, m_MipLevels);
+        GenerateMipMaps(Batch.GetGraphicsCommandBuffer(), m_Format);
+
+        Batch.SubmitAndWait();
     }
 
     void HDRImage::CreateImageView()
@@ -120,17 +125,16 @@ namespace Fling
             m_TextureSampler);
     }
 
-    void HDRImage::CopyBufferToImage(VkBuffer t_Buffer)
+    void HDRImage::CopyBufferToImage(VkCommandBuffer t_CommandBuffer, VkBuffer t_Buffer, VkDeviceSize t_Offset)
     {
-        VkCommandBuffer CommandBuffer = GraphicsHelpers::BeginSingleTimeCommands();
-
         VkBufferImageCopy region = {};
-        region.bufferOffset = 0;
+        region.bufferOffset = t_Offset;
         region.bufferRowLength = 0;
         region.bufferImageHeight = 0;
 
+        // The rest of the mip levels are blitted from the first one
         region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.imageSubresource.mipLevel = m_MipLevels;
+        region.imageSubresource.mipLevel = 0;
         region.imageSubresource.baseArrayLayer = 0;
         region.imageSubresource.layerCount = 1;
 
@@ -142,18 +146,16 @@ namespace Fling
         };
 
         vkCmdCopyBufferToImage(
-            CommandBuffer,
+            t_CommandBuffer,
             t_Buffer,
             m_Image,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
             1,
             &region
         );
-
-        GraphicsHelpers::EndSingleTimeCommands(CommandBuffer);
     }
 
-    void HDRImage::GenerateMipMaps(VkFormat t_ImageFormat)
+    void HDRImage::GenerateMipMaps(VkCommandBuffer t_CommandBuffer, VkFormat t_ImageFormat)
     {
         // Check that we have linear filtering support on this device
         VkFormatProperties formatProperties = m_Device->GetPhysicalDevice()->GetFormatProperties(t_ImageFormat);
@@ -163,7 +165,7 @@ namespace Fling
             F_LOG_FATAL("Texture image format does not support linear blitting!");
         }
 
-        VkCommandBuffer commandBuffer = GraphicsHelpers::BeginSingleTimeCommands();
+        VkCommandBuffer commandBuffer = t_CommandBuffer;
 
         VkImageMemoryBarrier barrier = {};
         barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -247,8 +249,6 @@ namespace Fling
             0, nullptr,
             0, nullptr,
             1, &barrier);
-
-        GraphicsHelpers::EndSingleTimeCommands(commandBuffer);
     }
 
     void HDRImage::Release()
@@ -271,10 +271,9 @@ namespace Fling
             m_Image = VK_NULL_HANDLE;
         }
 
-        if (m_Memory != VK_NULL_HANDLE)
+        if (m_Memory.IsValid())
         {
-            vkFreeMemory(Device, m_Memory, nullptr);
-            m_Memory = VK_NULL_HANDLE;
+            VulkanApp::Get().GetMemoryAllocator()->Free(m_Memory);
         }
         if (m_TextureSampler != VK_NULL_HANDLE)
         {
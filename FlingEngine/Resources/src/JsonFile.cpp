@@ -9,12 +9,25 @@ namespace Fling
 		return ResourceManager::LoadResource<Fling::JsonFile>(t_ID);
 	}
 
+	std::shared_ptr<Fling::JsonFile> JsonFile::CreateAsync(Guid t_ID, std::function<void(std::shared_ptr<JsonFile>)> t_OnLoaded)
+	{
+		return ResourceManager::LoadResourceAsync<Fling::JsonFile>(t_ID, std::move(t_OnLoaded));
+	}
+
 	JsonFile::JsonFile(Guid t_ID)
         : Resource(t_ID)
     {
-        LoadJsonFile();
+        if (!LoadJsonFile())
+		{
+			m_LoadState = LoadState::Failed;
+		}
     }
 
+	JsonFile::JsonFile(Guid t_ID, AsyncLoadTag)
+		: Resource(t_ID)
+	{
+	}
+
 	void JsonFile::Write()
 	{
 		const std::string FilePath = GetFilepathReleativeToAssets();
@@ -33,7 +46,7 @@ namespace Fling
 		OutStream.close();
 	}
 
-	void JsonFile::LoadJsonFile()
+	bool JsonFile::LoadJsonFile()
     {
         const std::string FilePath = GetFilepathReleativeToAssets();
         std::ifstream ifs(FilePath.c_str());
@@ -46,9 +59,10 @@ namespace Fling
         else
         {
             F_LOG_ERROR( "Failed to load JSON File: {}", FilePath);
+			return false;
         }
 
         ifs.close();
-
+		return true;
     }
 } // namespace Fling
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "pch.h"
+#include "MappedFile.h"
+
+#if FLING_LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace Fling
+{
+	MappedFile::MappedFile(const std::string& t_FilePath)
+	{
+		Open(t_FilePath);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	bool MappedFile::Open(const std::string& t_FilePath)
+	{
+		Close();
+
+#if FLING_WINDOWS
+		m_File = CreateFileA(t_FilePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (m_File == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER FileSize = {};
+		if (!GetFileSizeEx(m_File, &FileSize) || FileSize.QuadPart == 0)
+		{
+			Close();
+			return false;
+		}
+
+		m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_Mapping == nullptr)
+		{
+			Close();
+			return false;
+		}
+
+		m_Data = static_cast<const UINT8*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+		if (m_Data == nullptr)
+		{
+			Close();
+			return false;
+		}
+		m_Size = static_cast<size_t>(FileSize.QuadPart);
+
+#elif FLING_LINUX
+		int FileDesc = open(t_FilePath.c_str(), O_RDONLY);
+		if (FileDesc < 0)
+		{
+			return false;
+		}
+
+		struct stat FileStat = {};
+		if (fstat(FileDesc, &FileStat) != 0 || FileStat.st_size == 0)
+		{
+			close(FileDesc);
+			return false;
+		}
+
+		// The mapping keeps its own reference to the file, so we can close it right away
+		void* Data = mmap(nullptr, static_cast<size_t>(FileStat.st_size), PROT_READ, MAP_PRIVATE, FileDesc, 0);
+		close(FileDesc);
+		if (Data == MAP_FAILED)
+		{
+			return false;
+		}
+
+		// We read the whole file front to back when uploading it
+		madvise(Data, static_cast<size_t>(FileStat.st_size), MADV_SEQUENTIAL);
+
+		m_Data = static_cast<const UINT8*>(Data);
+		m_Size = static_cast<size_t>(FileStat.st_size);
+#endif
+
+		return IsOpen();
+	}
+
+	void MappedFile::Close()
+	{
+#if FLING_WINDOWS
+		if (m_Data)
+		{
+			UnmapViewOfFile(m_Data);
+		}
+		if (m_Mapping)
+		{
+			CloseHandle(m_Mapping);
+			m_Mapping = nullptr;
+		}
+		if (m_File != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(m_File);
+			m_File = INVALID_HANDLE_VALUE;
+		}
+#elif FLING_LINUX
+		if (m_Data)
+		{
+			munmap(const_cast<UINT8*>(m_Data), m_Size);
+		}
+#endif
+
+		m_Data = nullptr;
+		m_Size = 0;
+	}
+}   // namespace Fling
@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "ResourceManager.h"
+#include "UploadBatch.h"
 
 namespace Fling
 {
@@ -21,15 +22,219 @@ namespace Fling
 
 		char currentDir[1024] = {};
 		FlingPaths::GetCurrentWorkingDir(currentDir, 1024);
+
+		// Start the threads that decode any async resources
+		{
+			std::lock_guard<std::mutex> Lock(m_LoadMutex);
+			if (m_IsLoading)
+			{
+				return;
+			}
+			m_IsLoading = true;
+		}
+
+		m_LoaderThreads.reserve(LOADER_THREAD_COUNT);
+		for (UINT32 i = 0; i < LOADER_THREAD_COUNT; ++i)
+		{
+			m_LoaderThreads.emplace_back(&ResourceManager::LoaderThread, this);
+		}
 	}
 
 	void ResourceManager::Shutdown()
 	{
+		// Stop the loading threads, any resources that have not been decoded yet are dropped
+		{
+			std::lock_guard<std::mutex> Lock(m_LoadMutex);
+			m_IsLoading = false;
+			m_LoadQueue.clear();
+		}
+		m_LoadCondition.notify_all();
+
+		for (std::thread& Thread : m_LoaderThreads)
+		{
+			if (Thread.joinable())
+			{
+				Thread.join();
+			}
+		}
+		m_LoaderThreads.clear();
+		m_DecodedResources.clear();
+
+		// Upload batches will wait for the GPU before freeing their staging buffers
+		m_InFlightUploads.clear();
+		m_PendingCallbacks.clear();
+
 		// Unload all assets BB
 		// This will remove all owning references to the shared_ptr's
 		m_ResourceMap.clear();
 	}
 
+	void ResourceManager::Update()
+	{
+		// Finish any resources whose uploads the GPU is done with
+		std::vector<InFlightUpload> CompletedUploads;
+		for (auto It = m_InFlightUploads.begin(); It != m_InFlightUploads.end();)
+		{
+			if (It->Batch->IsComplete())
+			{
+				CompletedUploads.emplace_back(std::move(*It));
+				It = m_InFlightUploads.erase(It);
+			}
+			else
+			{
+				++It;
+			}
+		}
+
+		for (InFlightUpload& Upload : CompletedUploads)
+		{
+			// Free the staging memory before anything else gets loaded
+			Upload.Batch.reset();
+
+			for (const std::shared_ptr<Resource>& Res : Upload.Resources)
+			{
+				Res->OnUploadComplete();
+				FinishAsyncLoad(Res, Resource::LoadState::Ready);
+			}
+		}
+
+		// Grab anything that the loading threads have finished decoding
+		std::vector<DecodedResource> Decoded;
+		{
+			std::lock_guard<std::mutex> Lock(m_LoadMutex);
+			Decoded.swap(m_DecodedResources);
+		}
+
+		if (Decoded.empty())
+		{
+			return;
+		}
+
+		// Record the uploads of every decoded resource into one batch so that there is only a single submit
+		InFlightUpload NewUpload = {};
+		for (DecodedResource& Res : Decoded)
+		{
+			if (!Res.Succeeded)
+			{
+				F_LOG_ERROR("Failed to async load resource {}", Res.Res->GetGuidString());
+				FinishAsyncLoad(Res.Res, Resource::LoadState::Failed);
+			}
+			else if (Res.Res->RequiresUpload())
+			{
+				if (!NewUpload.Batch)
+				{
+					NewUpload.Batch = std::make_shared<UploadBatch>();
+				}
+				Res.Res->RecordUpload(*NewUpload.Batch);
+				NewUpload.Resources.emplace_back(std::move(Res.Res));
+			}
+			else
+			{
+				FinishAsyncLoad(Res.Res, Resource::LoadState::Ready);
+			}
+		}
+
+		if (NewUpload.Batch)
+		{
+			NewUpload.Batch->Submit();
+			m_InFlightUploads.emplace_back(std::move(NewUpload));
+		}
+	}
+
+	void ResourceManager::WaitForAsyncLoads()
+	{
+		while (!m_PendingCallbacks.empty())
+		{
+			Update();
+
+			for (InFlightUpload& Upload : m_InFlightUploads)
+			{
+				Upload.Batch->Wait();
+			}
+
+			std::this_thread::yield();
+		}
+		Update();
+	}
+
+	void ResourceManager::AddLoadCallback(const std::shared_ptr<Resource>& t_Resource, LoadCallback t_Callback)
+	{
+		auto It = m_PendingCallbacks.find(t_Resource->GetGuidHandle());
+		if (It != m_PendingCallbacks.end())
+		{
+			It->second.emplace_back(std::move(t_Callback));
+		}
+		else
+		{
+			// This resource is already done loading
+			t_Callback(t_Resource);
+		}
+	}
+
+	void ResourceManager::QueueAsyncLoad(const std::shared_ptr<Resource>& t_Resource)
+	{
+		{
+			std::lock_guard<std::mutex> Lock(m_LoadMutex);
+			assert(m_IsLoading && "The ResourceManager has to be initialized before loading async resources");
+			m_LoadQueue.emplace_back(t_Resource);
+		}
+		m_LoadCondition.notify_one();
+	}
+
+	void ResourceManager::FinishAsyncLoad(const std::shared_ptr<Resource>& t_Resource, Resource::LoadState t_State)
+	{
+		t_Resource->m_LoadState.store(t_State, std::memory_order_release);
+		++m_LoadGeneration;
+
+		auto It = m_PendingCallbacks.find(t_Resource->GetGuidHandle());
+		if (It == m_PendingCallbacks.end())
+		{
+			return;
+		}
+
+		// Callbacks are allowed to load more resources, so take them out of the map first
+		std::vector<LoadCallback> Callbacks = std::move(It->second);
+		m_PendingCallbacks.erase(It);
+
+		for (LoadCallback& Callback : Callbacks)
+		{
+			Callback(t_Resource);
+		}
+	}
+
+	void ResourceManager::LoaderThread()
+	{
+		while (true)
+		{
+			std::shared_ptr<Resource> Res;
+			{
+				std::unique_lock<std::mutex> Lock(m_LoadMutex);
+				m_LoadCondition.wait(Lock, [this]() { return !m_IsLoading || !m_LoadQueue.empty(); });
+
+				if (!m_IsLoading)
+				{
+					return;
+				}
+
+				Res = std::move(m_LoadQueue.front());
+				m_LoadQueue.pop_front();
+			}
+
+			bool Succeeded = false;
+			try
+			{
+				Succeeded = Res->LoadFromDisk();
+			}
+			catch (std::exception& e)
+			{
+				F_LOG_ERROR("Exception while loading {} : {}", Res->GetGuidString(), e.what());
+			}
+
+			std::lock_guard<std::mutex> Lock(m_LoadMutex);
+			m_DecodedResources.push_back({ std::move(Res), Succeeded });
+		}
+	}
+
 	std::shared_ptr<Resource> ResourceManager::GetResource(Guid_Handle t_ID) const
 	{
 		ResourceMapConstIt It = m_ResourceMap.find(t_ID);
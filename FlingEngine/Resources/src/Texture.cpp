@@ -13,6 +13,7 @@
 #include "ResourceManager.h"
 #include "GraphicsHelpers.h"
 #include "Buffer.h"
+#include "UploadBatch.h"
 
 namespace Fling
 {
@@ -21,25 +22,115 @@ namespace Fling
 		return ResourceManager::LoadResource<Fling::Texture>(t_ID);
 	}
 
+	std::shared_ptr<Fling::Texture> Texture::CreateAsync(Guid t_ID)
+	{
+		return ResourceManager::LoadResourceAsync<Fling::Texture>(t_ID);
+	}
+
+	std::shared_ptr<Fling::Texture> Texture::Placeholder()
+	{
+		static const UINT8 WhitePixel[4] = { 255, 255, 255, 255 };
+		return ResourceManager::LoadResource<Fling::Texture>(HS("Fling_Placeholder_Texture"), 1u, 1u, WhitePixel);
+	}
+
 	Texture::Texture(Guid t_ID)
         : Resource(t_ID)
     {
-        LoadVulkanImage();
+		if (LoadFromDisk())
+		{
+			UploadImmediate();
+		}
+		else
+		{
+			m_LoadState = LoadState::Failed;
+			m_ImageInfo = *Placeholder()->GetDescriptorInfo();
+		}
+	}
 
-        // Create the image views for sampling
-        CreateImageView();
+	Texture::Texture(Guid t_ID, AsyncLoadTag)
+		: Resource(t_ID)
+	{
+		// Sample from the placeholder until our own image has been uploaded
+		m_ImageInfo = *Placeholder()->GetDescriptorInfo();
+	}
 
-		CreateTextureSampler();
+	Texture::Texture(Guid t_ID, UINT32 t_Width, UINT32 t_Height, const void* t_Pixels)
+		: Resource(t_ID)
+		, m_Width(t_Width)
+		, m_Height(t_Height)
+		, m_MipLevels(1)
+		, m_Channels(4)
+	{
+		assert(t_Pixels);
 
-		m_ImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		m_ImageInfo.imageView = m_ImageView;
-		m_ImageInfo.sampler = m_TextureSampler;
+		// Keep our own copy of the pixels, stbi_image_free will free it like any other image
+		m_PixelData = static_cast<stbi_uc*>(malloc(GetImageSize()));
+		memcpy(m_PixelData, t_Pixels, GetImageSize());
+
+		UploadImmediate();
+	}
+
+	void Texture::UploadImmediate()
+	{
+		UploadBatch Batch;
+		RecordUpload(Batch);
+		Batch.SubmitAndWait();
+
+		OnUploadComplete();
+	}
+
+	namespace
+	{
+		/** Bit for each BlockFormat that the device can sample, written once before any textures load */
+		std::atomic<UINT32> SupportedBlockFormats { 0 };
+	}
+
+	void Texture::CacheFormatSupport(const PhysicalDevice* t_Device)
+	{
+		assert(t_Device);
+
+		UINT32 Supported = 0;
+		if (t_Device->GetDeivceFeatures().textureCompressionBC)
+		{
+			for (BlockFormat Format : { BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC4, BlockFormat::BC5, BlockFormat::BC7 })
+			{
+				const VkFormatProperties Props = t_Device->GetFormatProperties(TextureFile::GetVkFormat(Format));
+				if (Props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
+				{
+					Supported |= 1u << static_cast<UINT32>(Format);
+				}
+			}
+		}
+		SupportedBlockFormats.store(Supported, std::memory_order_release);
+	}
+
+	bool Texture::IsFormatSupported(BlockFormat t_Format)
+	{
+		return (SupportedBlockFormats.load(std::memory_order_acquire) & (1u << static_cast<UINT32>(t_Format))) != 0;
 	}
 
-    void Texture::LoadVulkanImage()
+	bool Texture::LoadFromDisk()
     {
         const std::string Filepath = GetFilepathReleativeToAssets();
-
+		const std::string CookedPath = TextureFile::GetCookedPath(Filepath);
+
+		if (TextureFile::IsUpToDate(Filepath, CookedPath))
+		{
+			std::unique_ptr<TextureFile> Cooked = std::make_unique<TextureFile>();
+			if (Cooked->Open(CookedPath) && IsFormatSupported(Cooked->GetBlockFormat()))
+			{
+				m_Width = Cooked->GetWidth();
+				m_Height = Cooked->GetHeight();
+				m_MipLevels = Cooked->GetMipCount();
+				m_Channels = static_cast<INT32>(BlockCompression::GetChannelCount(Cooked->GetBlockFormat()));
+				m_Format = Cooked->GetVkFormat();
+				m_TextureFile = std::move(Cooked);
+
+				return true;
+			}
+		}
+
+		// Fall back to the source image if this texture hasn't been cooked
         // Load the image from STB
         int Width = 0;
         int Height = 0;
@@ -51,15 +142,54 @@ namespace Fling
             STBI_rgb_alpha
         );
 
-        m_Width = static_cast<UINT32>(Width);
-        m_Height = static_cast<UINT32>(Height);
-        m_MipLevels = static_cast<UINT32>(std::floor(std::log2(std::max(m_Width, m_Height)))) + 1;
-
         if (!m_PixelData)
         {
             F_LOG_ERROR("Failed to load image file: {}", Filepath);
+			return false;
         }
 
+        m_Width = static_cast<UINT32>(Width);
+        m_Height = static_cast<UINT32>(Height);
+        m_MipLevels = static_cast<UINT32>(std::floor(std::log2(std::max(m_Width, m_Height)))) + 1;
+
+		return true;
+	}
+
+	void Texture::RecordUpload(UploadBatch& t_Batch)
+	{
+		if (m_TextureFile)
+		{
+			GraphicsHelpers::CreateVkImage(
+				VulkanApp::Get().GetLogicalDevice()->GetVkDevice(),
+				m_Width,
+				m_Height,
+				m_MipLevels,
+				/* Depth */ 1,
+				/* Array Layers */ 1,
+				/* Format */ m_Format,
+				/* Tiling */ VK_IMAGE_TILING_OPTIMAL,
+				/* Usage */ VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+				/* Props */ VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				/* Flags */ 0,
+				m_vVkImage,
+				m_VkMemory
+			);
+
+			// Every mip level is already in the file, so there is nothing to blit and the graphics queue only has to take ownership
+			StagingAllocation Staging = t_Batch.StageData(m_TextureFile->GetData(), m_TextureFile->GetDataSize());
+			VkCommandBuffer CommandBuffer = t_Batch.GetCommandBuffer();
+
+			GraphicsHelpers::TransitionImageLayout(CommandBuffer, m_vVkImage, m_Format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, m_MipLevels);
+			CopyLevelsToImage(CommandBuffer, Staging.Buffer, Staging.Offset);
+			t_Batch.TransferImage(m_vVkImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, m_MipLevels);
+
+			// The staging memory has its own copy now
+			m_TextureFile.reset();
+			return;
+		}
+
+		assert(m_PixelData);
+
         GraphicsHelpers::CreateVkImage(
 			VulkanApp::Get().GetLogicalDevice()->GetVkDevice(),
             m_Width,
@@ -76,25 +206,40 @@ namespace Fling
             m_VkMemory
         );
 
-        // Put the image data in a staging buffer for Vulkan
+        // Put the image data in staging memory for Vulkan
         VkDeviceSize ImageSize = GetImageSize();
-        Buffer StagingBuffer(ImageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_PixelData);
+        StagingAllocation Staging = t_Batch.StageData(m_PixelData, ImageSize);
+        VkCommandBuffer CommandBuffer = t_Batch.GetCommandBuffer();
         
         // Transition and copy the image layout to the staging buffer
         GraphicsHelpers::TransitionImageLayout(
+            CommandBuffer,
             m_vVkImage, 
             VK_FORMAT_R8G8B8A8_UNORM, 
             VK_IMAGE_LAYOUT_UNDEFINED, 
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
             m_MipLevels
         );
-        CopyBufferToImage(StagingBuffer.GetVkBuffer());
+        CopyBufferToImage(CommandBuffer, Staging.Buffer, Staging.Offset);
 
-        // Transition to image layout happens while generating mip maps
-        GenerateMipMaps(VK_FORMAT_R8G8B8A8_UNORM);
+        // Blits need the graphics queue, the transition to the final layout happens while generating mip maps
+        t_Batch.TransferImage(m_vVkImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, m_MipLevels);
+        GenerateMipMaps(t_Batch.GetGraphicsCommandBuffer(), VK_FORMAT_R8G8B8A8_UNORM);
     }
 
-    void Texture::GenerateMipMaps(VkFormat imageFormat)
+	void Texture::OnUploadComplete()
+	{
+        // Create the image views for sampling
+        CreateImageView();
+
+		CreateTextureSampler();
+
+		m_ImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		m_ImageInfo.imageView = m_ImageView;
+		m_ImageInfo.sampler = m_TextureSampler;
+	}
+
+    void Texture::GenerateMipMaps(VkCommandBuffer t_CommandBuffer, VkFormat imageFormat)
     {
         // Check that we have linear filtering support on this device
         VkFormatProperties formatProperties = VulkanApp::Get().GetPhysicalDevice()->GetFormatProperties(imageFormat);
@@ -104,7 +249,7 @@ namespace Fling
             F_LOG_FATAL("Texture image format does not support linear blitting!");
         }
 
-        VkCommandBuffer commandBuffer = GraphicsHelpers::BeginSingleTimeCommands();
+        VkCommandBuffer commandBuffer = t_CommandBuffer;
 
         VkImageMemoryBarrier barrier = {};
         barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -188,16 +333,13 @@ namespace Fling
             0, nullptr,
             0, nullptr,
             1, &barrier);
-
-        GraphicsHelpers::EndSingleTimeCommands(commandBuffer);
     }
 
-    void Texture::CopyBufferToImage(VkBuffer t_Buffer)
+    void Texture::CopyBufferToImage(VkCommandBuffer t_CommandBuffer, VkBuffer t_Buffer, VkDeviceSize t_Offset)
     {
-        VkCommandBuffer commandBuffer = GraphicsHelpers::BeginSingleTimeCommands();
 
         VkBufferImageCopy region = {};
-        region.bufferOffset = 0;
+        region.bufferOffset = t_Offset;
         region.bufferRowLength = 0;
         region.bufferImageHeight = 0;
 
@@ -214,22 +356,48 @@ namespace Fling
         };
 
         vkCmdCopyBufferToImage(
-            commandBuffer,
+            t_CommandBuffer,
             t_Buffer,
             m_vVkImage,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
             1,
             &region
         );
-
-        GraphicsHelpers::EndSingleTimeCommands(commandBuffer);
     }
 
+	void Texture::CopyLevelsToImage(VkCommandBuffer t_CommandBuffer, VkBuffer t_Buffer, VkDeviceSize t_Offset)
+	{
+		const UINT64 BaseOffset = m_TextureFile->GetLevel(0).Offset;
+
+		std::vector<VkBufferImageCopy> Regions(m_MipLevels);
+		for (UINT32 i = 0; i < m_MipLevels; ++i)
+		{
+			VkBufferImageCopy& Region = Regions[i];
+			Region = {};
+			Region.bufferOffset = t_Offset + m_TextureFile->GetLevel(i).Offset - BaseOffset;
+			Region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			Region.imageSubresource.mipLevel = i;
+			Region.imageSubresource.baseArrayLayer = 0;
+			Region.imageSubresource.layerCount = 1;
+			Region.imageOffset = { 0, 0, 0 };
+			Region.imageExtent = { std::max(m_Width >> i, 1u), std::max(m_Height >> i, 1u), 1 };
+		}
+
+		vkCmdCopyBufferToImage(
+			t_CommandBuffer,
+			t_Buffer,
+			m_vVkImage,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<UINT32>(Regions.size()),
+			Regions.data()
+		);
+	}
+
     void Texture::CreateImageView()
     {
         m_ImageView = GraphicsHelpers::CreateVkImageView(
             m_vVkImage,
-            VK_FORMAT_R8G8B8A8_UNORM, 
+            m_Format, 
             VK_IMAGE_ASPECT_COLOR_BIT,
             m_MipLevels
         );
@@ -273,6 +441,8 @@ namespace Fling
     {
         // We don't need this stbi pixel data any more
         stbi_image_free(m_PixelData);
+        m_PixelData = nullptr;
+		m_TextureFile.reset();
         
 		LogicalDevice* LogDevice = VulkanApp::Get().GetLogicalDevice();
 		assert(LogDevice);
@@ -292,10 +462,9 @@ namespace Fling
             m_vVkImage = VK_NULL_HANDLE;
         }
         
-        if (m_VkMemory != VK_NULL_HANDLE)
+        if (m_VkMemory.IsValid())
         {
-            vkFreeMemory(Device, m_VkMemory, nullptr);
-            m_VkMemory = VK_NULL_HANDLE;
+            VulkanApp::Get().GetMemoryAllocator()->Free(m_VkMemory);
         }
         if (m_TextureSampler != VK_NULL_HANDLE)
         {
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "FlingTypes.h"
+
+#include <deque>
+
+namespace Fling
+{
+    /**
+     * @brief   Hands out offsets into a ring of memory that is shared by batches of work, like staging
+     *          memory that GPU uploads are copied out of. Every allocation belongs to a batch, and a batch
+     *          gives back everything it allocated at once when it is released.
+     *
+     *          Batches can be released in any order, but space is only reclaimed from the oldest end of
+     *          the ring, so a batch that is released early waits for the ones that allocated before it.
+     *
+     *          Only keeps track of offsets, so it can be used for any kind of memory. Not thread safe.
+     */
+    class BatchRingAllocator
+    {
+    public:
+
+        /** @param t_Capacity    Size of the ring in bytes */
+        explicit BatchRingAllocator(UINT64 t_Capacity);
+
+        /**
+         * @brief   Allocate a range that is contiguous, it will never wrap around the end of the ring
+         *
+         * @param t_Batch       Batch that owns the range
+         * @param t_Alignment   Alignment of the returned offset, does not have to be a power of 2
+         * @return  False if the batches that haven't been released don't leave enough space
+         */
+        bool Allocate(UINT64 t_Batch, UINT64 t_Size, UINT64 t_Alignment, UINT64& t_OutOffset);
+
+        /** Free everything that was allocated by this batch. Does nothing if it didn't allocate anything */
+        void Release(UINT64 t_Batch);
+
+        inline UINT64 GetCapacity() const { return m_Capacity; }
+
+        /** Bytes that are in use by batches, including any alignment padding and ranges waiting on older batches */
+        inline UINT64 GetUsedSize() const { return m_UsedSize; }
+
+    private:
+
+        /** Bytes that one batch took from the ring in a row */
+        struct Span
+        {
+            UINT64 Batch = 0;
+            UINT64 Size = 0;
+            bool IsReleased = false;
+        };
+
+        UINT64 m_Capacity = 0;
+
+        /** Where the next allocation will start searching from */
+        UINT64 m_Head = 0;
+
+        UINT64 m_UsedSize = 0;
+
+        /** Ordered from the oldest to the newest */
+        std::deque<Span> m_Spans;
+    };
+}   // namespace Fling
@@ -0,0 +1,267 @@
+#pragma once
+
+#include "Singleton.hpp"
+#include "FlingTypes.h"
+#include "CircularBuffer.hpp"
+#include "WorkStealingQueue.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <algorithm>
+
+namespace Fling
+{
+	struct Job;
+
+	/** Function that a job will execute. Data points to the user data stored inside of the job */
+	using JobFunction = void(*)(Job* t_Job, const void* t_Data);
+
+	/**
+	 * @brief	A single unit of work for the job system. Jobs are fixed size so that they can
+	 *			be allocated from a ring buffer, and any user data is stored inline.
+	 *			A job is finished once it and all of it's children have been executed.
+	 */
+	struct alignas(64) Job
+	{
+		static constexpr size_t DATA_SIZE = 96;
+
+		JobFunction Function = nullptr;
+
+		Job* Parent = nullptr;
+
+		/** Counter of this job plus every child that has not been executed yet */
+		std::atomic<INT32> UnfinishedJobs { 0 };
+
+		alignas(16) char Data[DATA_SIZE];
+	};
+
+	/**
+	 * @brief	Engine wide job system with a worker thread per core. Each thread has it's own
+	 *			ring buffer of jobs and a lock free work stealing queue, idle threads steal work
+	 *			from the queues of others.
+	 *
+	 *			Jobs can only be created from the main thread or from inside of another job.
+	 *			Allocated jobs are never freed, they are overwritten once the ring buffer wraps
+	 *			around, so a thread cannot have more than MAX_JOB_COUNT jobs in flight.
+	 *
+	 * @see https://blog.molecular-matters.com/2015/08/24/job-system-2-0-lock-free-work-stealing-part-1-basics/
+	 */
+	class JobSystem : public Singleton<JobSystem>
+	{
+	public:
+
+		/** Max number of jobs that each thread can have in flight. Must be a power of 2 */
+		static constexpr size_t MAX_JOB_COUNT = 4096;
+
+		/** Start a worker thread for every core other than the main thread */
+		virtual void Init() override;
+
+		/**
+		 * @brief Start the job system with a specific number of threads.
+		 * @param t_ThreadCount 	Total number of threads that will execute jobs, including the calling thread
+		 */
+		void Init(UINT32 t_ThreadCount);
+
+		/** Stop and join all worker threads. Any jobs that have not been run are dropped */
+		virtual void Shutdown() override;
+
+		/**
+		 * @brief Create a job that will execute the given callable. The callable can either
+		 *			take no arguments or a Job* to the job that is running it (for adding children)
+		 */
+		template<typename F>
+		static Job* CreateJob(F&& t_Func);
+
+		/**
+		 * @brief Create a job that the given parent will not be finished without
+		 */
+		template<typename F>
+		static Job* CreateJobAsChild(Job* t_Parent, F&& t_Func);
+
+		/** Push the job onto the queue of the calling thread */
+		static void Run(Job* t_Job);
+
+		/** Execute other jobs on the calling thread until the given job is finished */
+		static void Wait(const Job* t_Job);
+
+		static bool IsFinished(const Job* t_Job);
+
+		/**
+		 * @brief 	Split the range [0, t_Count) into jobs of at least t_Grain elements and wait
+		 *			for all of them to complete. Threads outside of the job system, like the resource
+		 *			loaders, and callers before Init run the whole range inline instead.
+		 *
+		 * @param t_Func 	Callable with the signature void(UINT32 t_Begin, UINT32 t_End)
+		 */
+		template<typename F>
+		static void ParallelFor(UINT32 t_Count, UINT32 t_Grain, const F& t_Func);
+
+		/**
+		 * @brief 	Call the function for every entity in the given entt view or group in parallel.
+		 *			Works with anything that has a contiguous data() and size(), like single
+		 *			component views and groups. Blocks until every entity has been visited.
+		 *
+		 * @param t_Func 	Callable with the signature void(entt::entity)
+		 */
+		template<typename TView, typename F>
+		static void ParallelForEach(const TView& t_View, const F& t_Func, UINT32 t_Grain = 64);
+
+		/** Index of the calling thread in the job system, the main thread is always 0 */
+		static UINT32 GetThreadIndex();
+
+		/** Total number of threads that execute jobs, including the main thread */
+		inline UINT32 GetThreadCount() const { return static_cast<UINT32>(m_Threads.size()); }
+
+	private:
+
+		/** The job queue and job allocator of a single thread */
+		struct ThreadData
+		{
+			WorkStealingQueue<Job, MAX_JOB_COUNT> Queue;
+
+			CircularBuffer<Job, MAX_JOB_COUNT> JobAllocator;
+		};
+
+		template<typename F>
+		struct ParallelForRange
+		{
+			const F* Func;
+			UINT32 Begin;
+			UINT32 Count;
+			UINT32 Grain;
+
+			void operator()(Job* t_Job) const;
+		};
+
+		template<typename F>
+		static void InvokeFunctor(Job* t_Job, const void* t_Data);
+
+		template<typename F>
+		static Job* CreateJobImpl(Job* t_Parent, F&& t_Func);
+
+		static Job* AllocateJob(JobFunction t_Function, Job* t_Parent);
+
+		/** Get a job from our own queue or try and steal one from another thread */
+		Job* GetJob();
+
+		void Execute(Job* t_Job);
+
+		void Finish(Job* t_Job);
+
+		void WorkerThread(UINT32 t_ThreadIndex);
+
+		/** Index 0 is the main thread, which does not have a std::thread */
+		std::vector<std::unique_ptr<ThreadData>> m_Threads;
+
+		std::vector<std::thread> m_Workers;
+
+		std::atomic<bool> m_IsRunning { false };
+
+		/** Idle workers sleep on this until new jobs are pushed */
+		std::mutex m_WakeMutex;
+
+		std::condition_variable m_WakeCondition;
+
+		std::atomic<UINT32> m_SleepingWorkers { 0 };
+	};
+
+	template<typename F>
+	inline Job* JobSystem::CreateJob(F&& t_Func)
+	{
+		return CreateJobImpl(nullptr, std::forward<F>(t_Func));
+	}
+
+	template<typename F>
+	inline Job* JobSystem::CreateJobAsChild(Job* t_Parent, F&& t_Func)
+	{
+		assert(t_Parent);
+		t_Parent->UnfinishedJobs.fetch_add(1, std::memory_order_relaxed);
+		return CreateJobImpl(t_Parent, std::forward<F>(t_Func));
+	}
+
+	template<typename F>
+	inline Job* JobSystem::CreateJobImpl(Job* t_Parent, F&& t_Func)
+	{
+		using Functor = typename std::decay<F>::type;
+		static_assert(sizeof(Functor) <= Job::DATA_SIZE, "Job functor is too large to fit inside of a job, capture less");
+		static_assert(alignof(Functor) <= 16, "Job functor alignment is too large");
+		static_assert(std::is_trivially_destructible<Functor>::value, "Job functors are never destroyed, so they must be trivially destructible");
+
+		Job* NewJob = AllocateJob(&JobSystem::InvokeFunctor<Functor>, t_Parent);
+		new (NewJob->Data) Functor(std::forward<F>(t_Func));
+		return NewJob;
+	}
+
+	template<typename F>
+	inline void JobSystem::InvokeFunctor(Job* t_Job, const void* t_Data)
+	{
+		const F& Func = *static_cast<const F*>(t_Data);
+		if constexpr (std::is_invocable<const F&, Job*>::value)
+		{
+			Func(t_Job);
+		}
+		else
+		{
+			Func();
+		}
+	}
+
+	template<typename F>
+	inline void JobSystem::ParallelForRange<F>::operator()(Job* t_Job) const
+	{
+		if (Count > Grain)
+		{
+			// Split the range in half and let other threads steal the halves
+			const UINT32 LeftCount = Count / 2;
+			JobSystem::Run(JobSystem::CreateJobAsChild(t_Job, ParallelForRange<F> { Func, Begin, LeftCount, Grain }));
+			JobSystem::Run(JobSystem::CreateJobAsChild(t_Job, ParallelForRange<F> { Func, Begin + LeftCount, Count - LeftCount, Grain }));
+		}
+		else
+		{
+			(*Func)(Begin, Begin + Count);
+		}
+	}
+
+	template<typename F>
+	inline void JobSystem::ParallelFor(UINT32 t_Count, UINT32 t_Grain, const F& t_Func)
+	{
+		if (t_Count == 0)
+		{
+			return;
+		}
+
+		if (GetThreadIndex() >= Get().GetThreadCount())
+		{
+			t_Func(0, t_Count);
+			return;
+		}
+
+		// Make sure that splitting the range can't wrap around a thread's job ring buffer
+		const UINT32 MinGrain = static_cast<UINT32>(t_Count / (MAX_JOB_COUNT / 4)) + 1;
+		const UINT32 Grain = std::max(t_Grain, MinGrain);
+
+		Job* Root = CreateJob(ParallelForRange<F> { &t_Func, 0, t_Count, Grain });
+		Run(Root);
+		Wait(Root);
+	}
+
+	template<typename TView, typename F>
+	inline void JobSystem::ParallelForEach(const TView& t_View, const F& t_Func, UINT32 t_Grain)
+	{
+		const auto* Entities = t_View.data();
+		ParallelFor(static_cast<UINT32>(t_View.size()), t_Grain, [Entities, &t_Func](UINT32 t_Begin, UINT32 t_End)
+		{
+			for (UINT32 i = t_Begin; i < t_End; ++i)
+			{
+				t_Func(Entities[i]);
+			}
+		});
+	}
+}   // namespace Fling
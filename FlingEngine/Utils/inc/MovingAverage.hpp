@@ -18,7 +18,7 @@ namespace Fling
         /** Push a value onto the buffer to be calculated */
         void Push(T t_Element);
 
-        /** Get the average (Sum / num elements) */
+        /** Get the average (Sum / num elements), or 0 if nothing has been pushed */
         T GetAverage() const;
     
     private:
@@ -55,6 +55,11 @@ namespace Fling
         T Average = {};
 
         size_t Range = (m_Count < m_MaxSize ? m_Count : m_MaxSize);
+        if (Range == 0)
+        {
+            return Average;
+        }
+
         for (size_t i = 0; i < Range; ++i)
         {
             Average += m_Buffer[i];
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "FlingTypes.h"
+
+#include <vector>
+
+namespace Fling
+{
+    /**
+     * @brief   Hands out offsets into a ring of memory that is reused every few frames, like a
+     *          persistently mapped buffer that the GPU reads from. Everything that was allocated
+     *          during a frame is freed at once when that frame comes back around, so frames are
+     *          always retired in the same order that they were started.
+     *
+     *          Only keeps track of offsets, so it can be used for any kind of memory. Not thread safe.
+     */
+    class RingAllocator
+    {
+    public:
+
+        /**
+         * @param t_Capacity    Size of the ring in bytes
+         * @param t_FrameCount  Number of frames that can be using the ring at once
+         */
+        RingAllocator(UINT64 t_Capacity, UINT32 t_FrameCount);
+
+        /** Start a new frame. Frees everything that was allocated t_FrameCount frames ago */
+        void BeginFrame();
+
+        /**
+         * @brief   Allocate a range that is contiguous, it will never wrap around the end of the ring
+         *
+         * @param t_Alignment   Alignment of the returned offset, must be a power of 2
+         * @return  False if the frames that are in flight don't leave enough space
+         */
+        bool Allocate(UINT64 t_Size, UINT64 t_Alignment, UINT64& t_OutOffset);
+
+        inline UINT64 GetCapacity() const { return m_Capacity; }
+
+        /** Bytes that are in use by frames in flight, including any alignment padding */
+        inline UINT64 GetUsedSize() const { return m_UsedSize; }
+
+        inline UINT32 GetFrameIndex() const { return m_FrameIndex; }
+
+    private:
+
+        UINT64 m_Capacity = 0;
+
+        /** Where the next allocation will start searching from */
+        UINT64 m_Head = 0;
+
+        UINT64 m_UsedSize = 0;
+
+        /** Bytes that each frame has taken from the ring */
+        std::vector<UINT64> m_FrameSizes;
+
+        UINT32 m_FrameIndex = 0;
+    };
+}   // namespace Fling
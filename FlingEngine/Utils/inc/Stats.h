@@ -18,9 +18,23 @@ namespace Fling
         
             static void TickStats(float t_DeltaTime);
 
+            /** Time that the CPU was blocked waiting for the GPU to finish a frame in flight, in seconds */
+            static float GetAverageCpuWaitTime();
+
+            /** Time that the GPU spent drawing a frame, in seconds. 0 if the GPU can't measure it */
+            static float GetAverageGpuTime();
+
+            static void TickCpuWaitStats(float t_CpuWaitTime);
+
+            static void TickGpuStats(float t_GpuTime);
+
 		private:
 
             static MovingAverage<float, 100> FPSCounter;
+
+            static MovingAverage<float, 128> CpuWaitCounter;
+
+            static MovingAverage<float, 128> GpuTimeCounter;
         };
     }
 }
\ No newline at end of file
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "FlingTypes.h"
+
+#include <atomic>
+#include <cassert>
+
+namespace Fling
+{
+	/**
+	 * @brief	A lock-free, fixed size work stealing deque of pointers. The owning thread
+	 *			pushes and pops from the bottom (LIFO) while any other thread can steal from
+	 *			the top (FIFO).
+	 *
+	 *			Based on the Chase-Lev deque with the C11 memory orderings from
+	 *			"Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al.)
+	 * @see https://blog.molecular-matters.com/2015/09/25/job-system-2-0-lock-free-work-stealing-part-3-going-lock-free/
+	 *
+	 * @tparam T 			Type that is pointed to by the items in this queue
+	 * @tparam t_NumElms 	Max number of items in the queue, must be a power of 2!
+	 */
+	template<typename T, size_t t_NumElms>
+	class WorkStealingQueue
+	{
+	public:
+
+		WorkStealingQueue();
+
+		~WorkStealingQueue() = default;
+
+		/** Push an item onto the bottom of the queue. Only call from the owning thread */
+		void Push(T* t_Item);
+
+		/** Pop an item from the bottom of the queue. Only call from the owning thread */
+		T* Pop();
+
+		/** Steal an item from the top of the queue. Can be called from any thread */
+		T* Steal();
+
+		/** Approximate number of items in the queue, only exact from the owning thread */
+		size_t Size() const;
+
+	private:
+
+		// Same as the % operator for power of 2 sizes
+		static constexpr INT64 Mask = static_cast<INT64>(t_NumElms) - 1;
+
+		std::atomic<T*> m_Items[t_NumElms];
+
+		// Keep top and bottom on separate cache lines because they are written by different threads
+		alignas(64) std::atomic<INT64> m_Top;
+
+		alignas(64) std::atomic<INT64> m_Bottom;
+	};
+
+	template<typename T, size_t t_NumElms>
+	inline WorkStealingQueue<T, t_NumElms>::WorkStealingQueue()
+		: m_Top(0)
+		, m_Bottom(0)
+	{
+		static_assert((t_NumElms != 0 && (t_NumElms & (t_NumElms - 1)) == 0), "WorkStealingQueue::t_NumElms must be a power of 2!");
+
+		for (size_t i = 0; i < t_NumElms; ++i)
+		{
+			m_Items[i].store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	template<typename T, size_t t_NumElms>
+	inline void WorkStealingQueue<T, t_NumElms>::Push(T* t_Item)
+	{
+		const INT64 Bottom = m_Bottom.load(std::memory_order_relaxed);
+		const INT64 Top = m_Top.load(std::memory_order_acquire);
+		assert(Bottom - Top < static_cast<INT64>(t_NumElms) && "WorkStealingQueue is full!");
+		(void)Top;
+
+		m_Items[Bottom & Mask].store(t_Item, std::memory_order_relaxed);
+		// Release so that a thief that sees the new bottom also sees the item and what it points to
+		m_Bottom.store(Bottom + 1, std::memory_order_release);
+	}
+
+	template<typename T, size_t t_NumElms>
+	inline T* WorkStealingQueue<T, t_NumElms>::Pop()
+	{
+		const INT64 Bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+		m_Bottom.store(Bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		INT64 Top = m_Top.load(std::memory_order_relaxed);
+
+		if (Top <= Bottom)
+		{
+			T* Item = m_Items[Bottom & Mask].load(std::memory_order_relaxed);
+			if (Top == Bottom)
+			{
+				// This is the last item in the queue, so we race against any stealing threads
+				if (!m_Top.compare_exchange_strong(Top, Top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				{
+					Item = nullptr;
+				}
+				m_Bottom.store(Bottom + 1, std::memory_order_relaxed);
+			}
+			return Item;
+		}
+
+		// The queue was already empty
+		m_Bottom.store(Bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	template<typename T, size_t t_NumElms>
+	inline T* WorkStealingQueue<T, t_NumElms>::Steal()
+	{
+		INT64 Top = m_Top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const INT64 Bottom = m_Bottom.load(std::memory_order_acquire);
+
+		if (Top < Bottom)
+		{
+			T* Item = m_Items[Top & Mask].load(std::memory_order_relaxed);
+			// Another thread may have stolen or popped this item before us
+			if (!m_Top.compare_exchange_strong(Top, Top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				return nullptr;
+			}
+			return Item;
+		}
+
+		return nullptr;
+	}
+
+	template<typename T, size_t t_NumElms>
+	inline size_t WorkStealingQueue<T, t_NumElms>::Size() const
+	{
+		const INT64 Bottom = m_Bottom.load(std::memory_order_relaxed);
+		const INT64 Top = m_Top.load(std::memory_order_relaxed);
+		return Bottom >= Top ? static_cast<size_t>(Bottom - Top) : 0;
+	}
+}   // namespace Fling
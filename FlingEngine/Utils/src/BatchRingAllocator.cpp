@@ -0,0 +1,75 @@
+#include "pch.h"
+#include "BatchRingAllocator.h"
+
+namespace Fling
+{
+    BatchRingAllocator::BatchRingAllocator(UINT64 t_Capacity)
+        : m_Capacity(t_Capacity)
+    {
+    }
+
+    bool BatchRingAllocator::Allocate(UINT64 t_Batch, UINT64 t_Size, UINT64 t_Alignment, UINT64& t_OutOffset)
+    {
+        assert(t_Alignment != 0);
+
+        UINT64 Offset = ((m_Head + t_Alignment - 1) / t_Alignment) * t_Alignment;
+        UINT64 Consumed = 0;
+
+        if (Offset + t_Size > m_Capacity)
+        {
+            // Skip the space at the end of the ring and start over at the front
+            Consumed = (m_Capacity - m_Head) + t_Size;
+            Offset = 0;
+        }
+        else
+        {
+            Consumed = (Offset - m_Head) + t_Size;
+        }
+
+        // The free part of the ring runs from the head up to the oldest span that is still in use
+        if (t_Size > m_Capacity || m_UsedSize + Consumed > m_Capacity)
+        {
+            return false;
+        }
+
+        m_Head = Offset + t_Size;
+        m_UsedSize += Consumed;
+
+        if (!m_Spans.empty() && m_Spans.back().Batch == t_Batch && !m_Spans.back().IsReleased)
+        {
+            m_Spans.back().Size += Consumed;
+        }
+        else
+        {
+            m_Spans.push_back({ t_Batch, Consumed, false });
+        }
+
+        t_OutOffset = Offset;
+        return true;
+    }
+
+    void BatchRingAllocator::Release(UINT64 t_Batch)
+    {
+        for (Span& S : m_Spans)
+        {
+            if (S.Batch == t_Batch)
+            {
+                S.IsReleased = true;
+            }
+        }
+
+        while (!m_Spans.empty() && m_Spans.front().IsReleased)
+        {
+            assert(m_UsedSize >= m_Spans.front().Size);
+            m_UsedSize -= m_Spans.front().Size;
+            m_Spans.pop_front();
+        }
+
+        // Nothing is in use, so start from the beginning again to avoid wasting space on a wrap
+        if (m_Spans.empty())
+        {
+            m_UsedSize = 0;
+            m_Head = 0;
+        }
+    }
+}   // namespace Fling
@@ -0,0 +1,207 @@
+#include "pch.h"
+#include "JobSystem.h"
+
+namespace Fling
+{
+	static_assert(sizeof(Job) == 128, "Jobs should be exactly two cache lines");
+
+	namespace
+	{
+		/** Index of this thread in the job system. Threads outside of the job system are invalid */
+		constexpr UINT32 INVALID_THREAD_INDEX = ~0u;
+		thread_local UINT32 g_ThreadIndex = INVALID_THREAD_INDEX;
+
+		/** Cheap xorshift so that each thread picks a different victim to steal from */
+		thread_local UINT32 g_StealSeed = 0;
+
+		/** How many times a worker will try to find a job before going to sleep */
+		constexpr UINT32 IDLE_SPIN_COUNT = 64;
+
+		UINT32 NextRandom()
+		{
+			UINT32 x = g_StealSeed;
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+			g_StealSeed = x;
+			return x;
+		}
+	}
+
+	void JobSystem::Init()
+	{
+		Init(std::max(std::thread::hardware_concurrency(), 1u));
+	}
+
+	void JobSystem::Init(UINT32 t_ThreadCount)
+	{
+		assert(!m_IsRunning && "Job system has already been initialized");
+		t_ThreadCount = std::max(t_ThreadCount, 1u);
+
+		m_Threads.clear();
+		for (UINT32 i = 0; i < t_ThreadCount; ++i)
+		{
+			m_Threads.emplace_back(std::make_unique<ThreadData>());
+		}
+
+		// The thread that initializes the job system is the main thread
+		g_ThreadIndex = 0;
+		g_StealSeed = 0x9E3779B9u;
+
+		m_IsRunning = true;
+		for (UINT32 i = 1; i < t_ThreadCount; ++i)
+		{
+			m_Workers.emplace_back(&JobSystem::WorkerThread, this, i);
+		}
+
+		F_LOG_TRACE("Job system started with {} threads", t_ThreadCount);
+	}
+
+	void JobSystem::Shutdown()
+	{
+		m_IsRunning = false;
+		{
+			std::lock_guard<std::mutex> lock(m_WakeMutex);
+			m_WakeCondition.notify_all();
+		}
+
+		for (std::thread& Worker : m_Workers)
+		{
+			if (Worker.joinable())
+			{
+				Worker.join();
+			}
+		}
+		m_Workers.clear();
+		m_Threads.clear();
+	}
+
+	UINT32 JobSystem::GetThreadIndex()
+	{
+		return g_ThreadIndex;
+	}
+
+	Job* JobSystem::AllocateJob(JobFunction t_Function, Job* t_Parent)
+	{
+		JobSystem& System = JobSystem::Get();
+		assert(g_ThreadIndex < System.m_Threads.size() && "Jobs can only be created from the main thread or other jobs");
+
+		Job* NewJob = System.m_Threads[g_ThreadIndex]->JobAllocator.GetItem();
+		NewJob->Function = t_Function;
+		NewJob->Parent = t_Parent;
+		NewJob->UnfinishedJobs.store(1, std::memory_order_relaxed);
+		return NewJob;
+	}
+
+	void JobSystem::Run(Job* t_Job)
+	{
+		JobSystem& System = JobSystem::Get();
+		assert(g_ThreadIndex < System.m_Threads.size() && "Jobs can only be run from the main thread or other jobs");
+
+		System.m_Threads[g_ThreadIndex]->Queue.Push(t_Job);
+
+		if (System.m_SleepingWorkers.load(std::memory_order_relaxed) > 0)
+		{
+			System.m_WakeCondition.notify_one();
+		}
+	}
+
+	void JobSystem::Wait(const Job* t_Job)
+	{
+		JobSystem& System = JobSystem::Get();
+		assert(g_ThreadIndex < System.m_Threads.size() && "Only the main thread or other jobs can wait on a job");
+
+		// Help out with other jobs while we wait instead of blocking this thread
+		while (!IsFinished(t_Job))
+		{
+			if (Job* NextJob = System.GetJob())
+			{
+				System.Execute(NextJob);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	bool JobSystem::IsFinished(const Job* t_Job)
+	{
+		return t_Job->UnfinishedJobs.load(std::memory_order_acquire) == 0;
+	}
+
+	Job* JobSystem::GetJob()
+	{
+		ThreadData& Mine = *m_Threads[g_ThreadIndex];
+
+		if (Job* OwnJob = Mine.Queue.Pop())
+		{
+			return OwnJob;
+		}
+
+		const UINT32 ThreadCount = GetThreadCount();
+		if (ThreadCount < 2)
+		{
+			return nullptr;
+		}
+
+		// Our queue is empty, pick another thread at random and try to steal from it
+		UINT32 Victim = NextRandom() % ThreadCount;
+		if (Victim == g_ThreadIndex)
+		{
+			Victim = (Victim + 1) % ThreadCount;
+		}
+		return m_Threads[Victim]->Queue.Steal();
+	}
+
+	void JobSystem::Execute(Job* t_Job)
+	{
+		(t_Job->Function)(t_Job, t_Job->Data);
+		Finish(t_Job);
+	}
+
+	void JobSystem::Finish(Job* t_Job)
+	{
+		// Read the parent before we finish, once the counter hits zero the waiting thread
+		// is free to recycle this job
+		Job* Parent = t_Job->Parent;
+		const INT32 UnfinishedJobs = t_Job->UnfinishedJobs.fetch_sub(1, std::memory_order_acq_rel) - 1;
+
+		if (UnfinishedJobs == 0 && Parent)
+		{
+			Finish(Parent);
+		}
+	}
+
+	void JobSystem::WorkerThread(UINT32 t_ThreadIndex)
+	{
+		g_ThreadIndex = t_ThreadIndex;
+		g_StealSeed = 0x9E3779B9u * (t_ThreadIndex + 1);
+
+		UINT32 IdleCount = 0;
+		while (m_IsRunning.load(std::memory_order_acquire))
+		{
+			if (Job* NextJob = GetJob())
+			{
+				Execute(NextJob);
+				IdleCount = 0;
+			}
+			else if (++IdleCount < IDLE_SPIN_COUNT)
+			{
+				std::this_thread::yield();
+			}
+			else
+			{
+				// Nothing to do for a while, sleep until a job is pushed. Use a timeout because 
+				// Run does not take the lock and a wake up could be missed
+				std::unique_lock<std::mutex> lock(m_WakeMutex);
+				m_SleepingWorkers.fetch_add(1, std::memory_order_relaxed);
+				m_WakeCondition.wait_for(lock, std::chrono::milliseconds(1));
+				m_SleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+				IdleCount = 0;
+			}
+		}
+
+		g_ThreadIndex = INVALID_THREAD_INDEX;
+	}
+}   // namespace Fling
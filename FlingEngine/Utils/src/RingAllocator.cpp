@@ -0,0 +1,62 @@
+#include "pch.h"
+#include "RingAllocator.h"
+
+namespace Fling
+{
+    RingAllocator::RingAllocator(UINT64 t_Capacity, UINT32 t_FrameCount)
+        : m_Capacity(t_Capacity)
+        , m_FrameSizes(t_FrameCount, 0)
+    {
+        assert(t_FrameCount > 0);
+        // Start on the last frame so that the first BeginFrame lands on frame 0
+        m_FrameIndex = t_FrameCount - 1;
+    }
+
+    void RingAllocator::BeginFrame()
+    {
+        m_FrameIndex = (m_FrameIndex + 1) % static_cast<UINT32>(m_FrameSizes.size());
+
+        // The frame that used this slot last time is done, so the oldest part of the ring is free
+        assert(m_UsedSize >= m_FrameSizes[m_FrameIndex]);
+        m_UsedSize -= m_FrameSizes[m_FrameIndex];
+        m_FrameSizes[m_FrameIndex] = 0;
+
+        // Nothing is in flight, so start from the beginning again to avoid wasting space on a wrap
+        if (m_UsedSize == 0)
+        {
+            m_Head = 0;
+        }
+    }
+
+    bool RingAllocator::Allocate(UINT64 t_Size, UINT64 t_Alignment, UINT64& t_OutOffset)
+    {
+        assert(t_Alignment != 0 && (t_Alignment & (t_Alignment - 1)) == 0);
+
+        UINT64 Offset = (m_Head + t_Alignment - 1) & ~(t_Alignment - 1);
+        UINT64 Consumed = 0;
+
+        if (Offset + t_Size > m_Capacity)
+        {
+            // Skip the space at the end of the ring and start over at the front
+            Consumed = (m_Capacity - m_Head) + t_Size;
+            Offset = 0;
+        }
+        else
+        {
+            Consumed = (Offset - m_Head) + t_Size;
+        }
+
+        // The free part of the ring runs from the head up to the oldest frame that is still in flight
+        if (t_Size > m_Capacity || m_UsedSize + Consumed > m_Capacity)
+        {
+            return false;
+        }
+
+        m_Head = Offset + t_Size;
+        m_UsedSize += Consumed;
+        m_FrameSizes[m_FrameIndex] += Consumed;
+
+        t_OutOffset = Offset;
+        return true;
+    }
+}   // namespace Fling
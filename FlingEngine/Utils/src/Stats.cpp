@@ -6,6 +6,8 @@ namespace Fling
     namespace Stats
     {
         MovingAverage<float, 100> Frames::FPSCounter = {};
+        MovingAverage<float, 128> Frames::CpuWaitCounter = {};
+        MovingAverage<float, 128> Frames::GpuTimeCounter = {};
 
         float Frames::GetAverageFrameTime()
         {
@@ -21,5 +23,25 @@ namespace Fling
         {
             FPSCounter.Push(t_DeltaTime);
         }
+
+        float Frames::GetAverageCpuWaitTime()
+        {
+            return CpuWaitCounter.GetAverage();
+        }
+
+        float Frames::GetAverageGpuTime()
+        {
+            return GpuTimeCounter.GetAverage();
+        }
+
+        void Frames::TickCpuWaitStats(float t_CpuWaitTime)
+        {
+            CpuWaitCounter.Push(t_CpuWaitTime);
+        }
+
+        void Frames::TickGpuStats(float t_GpuTime)
+        {
+            GpuTimeCounter.Push(t_GpuTime);
+        }
     }
 }
\ No newline at end of file
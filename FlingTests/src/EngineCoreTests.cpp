@@ -5,6 +5,38 @@
 #include "pch.h"
 
 #include "Engine.h"
+#include "JobSystem.h"
+#include "TransformSystem.h"
+#include "TransformKernels.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+/**
+ * The SIMD kernels don't give the exact same bits as glm, so compare with a tolerance relative
+ * to the size of each column (the scale of that axis)
+ */
+static bool MatricesNearlyEqual(const glm::mat4& A, const glm::mat4& B, float t_Tolerance = 1e-5f)
+{
+    for (int c = 0; c < 4; ++c)
+    {
+        float Scale = 1.0f;
+        for (int r = 0; r < 4; ++r)
+        {
+            Scale = std::max(Scale, std::fabs(B[c][r]));
+        }
+
+        for (int r = 0; r < 4; ++r)
+        {
+            if (std::fabs(A[c][r] - B[c][r]) > t_Tolerance * Scale)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
 
 TEST_CASE("Smoke test", "[core]")
 {
@@ -25,4 +57,215 @@ TEST_CASE("Smoke test", "[core]")
         REQUIRE(true);
     }
 
-}
\ No newline at end of file
+}
+
+TEST_CASE("Transform System", "[core]")
+{
+    using namespace Fling;
+
+    JobSystem::Get().Init(2);
+
+    entt::registry Reg;
+    TransformSystem System(Reg);
+
+    const glm::mat4 Sentinel = glm::mat4(7.0f);
+
+    SECTION("Dirty transforms are calculated once")
+    {
+        entt::entity Ent = Reg.create();
+        Transform& Trans = Reg.assign<Transform>(Ent);
+        Trans.SetPos(glm::vec3(1.0f, 2.0f, 3.0f));
+        REQUIRE(Trans.IsDirty());
+
+        System.Update(Reg);
+        REQUIRE_FALSE(Trans.IsDirty());
+        REQUIRE(MatricesNearlyEqual(Trans.GetWorldMat(), Trans.GetLocalMatrix()));
+
+        // Nothing moved, so the cached matrix should be left alone
+        Trans.m_worldMat = Sentinel;
+        System.Update(Reg);
+        REQUIRE(Trans.GetWorldMat() == Sentinel);
+
+        Trans.SetScale(glm::vec3(2.0f));
+        System.Update(Reg);
+        REQUIRE(MatricesNearlyEqual(Trans.GetWorldMat(), Trans.GetLocalMatrix()));
+    }
+
+    SECTION("Children follow their parent")
+    {
+        entt::entity Root = Reg.create();
+        entt::entity Child = Reg.create();
+        Reg.assign<Transform>(Root).SetPos(glm::vec3(5.0f, 0.0f, 0.0f));
+        Reg.assign<Transform>(Child).SetPos(glm::vec3(0.0f, 1.0f, 0.0f));
+        Reg.assign<Parent>(Child, Root);
+
+        System.Update(Reg);
+
+        Transform& RootTrans = Reg.get<Transform>(Root);
+        Transform& ChildTrans = Reg.get<Transform>(Child);
+        REQUIRE(ChildTrans.GetWorldMat() == RootTrans.GetWorldMat() * ChildTrans.GetLocalMatrix());
+
+        RootTrans.SetPos(glm::vec3(-3.0f, 0.0f, 0.0f));
+        System.Update(Reg);
+        REQUIRE(ChildTrans.GetWorldMat() == RootTrans.GetWorldMat() * ChildTrans.GetLocalMatrix());
+
+        // Removing the parent makes the child a root again
+        Reg.remove<Parent>(Child);
+        System.Update(Reg);
+        REQUIRE(MatricesNearlyEqual(ChildTrans.GetWorldMat(), ChildTrans.GetLocalMatrix()));
+    }
+
+    SECTION("Hierarchy order does not depend on creation order")
+    {
+        // Create the chain backwards so the grandchild is first in the registry
+        entt::entity GrandChild = Reg.create();
+        entt::entity Child = Reg.create();
+        entt::entity Root = Reg.create();
+        Reg.assign<Transform>(GrandChild).SetRotation(glm::vec3(0.0f, 90.0f, 0.0f));
+        Reg.assign<Transform>(Child).SetPos(glm::vec3(0.0f, 0.0f, 2.0f));
+        Reg.assign<Transform>(Root).SetScale(glm::vec3(3.0f));
+        Reg.assign<Parent>(GrandChild, Child);
+        Reg.assign<Parent>(Child, Root);
+
+        System.Update(Reg);
+
+        const Transform& RootTrans = Reg.get<Transform>(Root);
+        const Transform& ChildTrans = Reg.get<Transform>(Child);
+        const Transform& GrandChildTrans = Reg.get<Transform>(GrandChild);
+        REQUIRE(MatricesNearlyEqual(GrandChildTrans.GetWorldMat(), RootTrans.GetLocalMatrix() * ChildTrans.GetLocalMatrix() * GrandChildTrans.GetLocalMatrix()));
+
+        // A static child of a static parent is not touched
+        Reg.get<Transform>(GrandChild).m_worldMat = Sentinel;
+        System.Update(Reg);
+        REQUIRE(GrandChildTrans.GetWorldMat() == Sentinel);
+    }
+
+    JobSystem::Get().Shutdown();
+}
+
+
+/** Random transforms in component arrays, with their matrices calculated by glm for reference */
+struct RandomTransforms
+{
+    explicit RandomTransforms(UINT32 t_Count)
+    {
+        std::mt19937 Rng(1234);
+        std::uniform_real_distribution<float> Pos(-1000.0f, 1000.0f);
+        std::uniform_real_distribution<float> Rot(-720.0f, 720.0f);
+        std::uniform_real_distribution<float> Scale(0.01f, 10.0f);
+
+        for (auto& Stream : Streams)
+        {
+            Stream.resize(t_Count);
+        }
+        Transforms.resize(t_Count);
+        Out.resize(t_Count);
+        OutPtrs.resize(t_Count);
+
+        for (UINT32 i = 0; i < t_Count; ++i)
+        {
+            Fling::Transform& T = Transforms[i];
+            T.SetPos(glm::vec3(Pos(Rng), Pos(Rng), Pos(Rng)));
+            T.SetRotation(glm::vec3(Rot(Rng), Rot(Rng), Rot(Rng)));
+            T.SetScale(glm::vec3(Scale(Rng), Scale(Rng), Scale(Rng)));
+
+            for (int c = 0; c < 3; ++c)
+            {
+                Streams[0 + c][i] = T.GetPos()[c];
+                Streams[3 + c][i] = T.GetRotation()[c];
+                Streams[6 + c][i] = T.GetScale()[c];
+            }
+            OutPtrs[i] = &Out[i];
+        }
+
+        In.PosX = Streams[0].data();
+        In.PosY = Streams[1].data();
+        In.PosZ = Streams[2].data();
+        In.RotX = Streams[3].data();
+        In.RotY = Streams[4].data();
+        In.RotZ = Streams[5].data();
+        In.ScaleX = Streams[6].data();
+        In.ScaleY = Streams[7].data();
+        In.ScaleZ = Streams[8].data();
+    }
+
+    std::vector<float> Streams[9];
+    std::vector<Fling::Transform> Transforms;
+    std::vector<glm::mat4> Out;
+    std::vector<glm::mat4*> OutPtrs;
+    Fling::TransformStreams In;
+};
+
+TEST_CASE("Transform Kernels", "[core]")
+{
+    using namespace Fling;
+
+    // Not a multiple of any SIMD width so that the padded tail is covered too
+    RandomTransforms Data(1003);
+
+    for (UINT8 i = 0; i < static_cast<UINT8>(TransformKernels::Isa::Count); ++i)
+    {
+        const TransformKernels::Isa Isa = static_cast<TransformKernels::Isa>(i);
+        if (!TransformKernels::IsSupported(Isa))
+        {
+            continue;
+        }
+
+        std::fill(Data.Out.begin(), Data.Out.end(), glm::mat4(0.0f));
+        TransformKernels::UpdateWorldMatrices(Isa, Data.In, static_cast<UINT32>(Data.Transforms.size()), Data.OutPtrs.data());
+
+        UINT32 Mismatches = 0;
+        for (size_t t = 0; t < Data.Transforms.size(); ++t)
+        {
+            if (!MatricesNearlyEqual(Data.Out[t], Data.Transforms[t].GetLocalMatrix()))
+            {
+                ++Mismatches;
+            }
+        }
+        INFO(TransformKernels::GetIsaName(Isa));
+        REQUIRE(Mismatches == 0);
+    }
+
+    REQUIRE(TransformKernels::IsSupported(TransformKernels::GetBestIsa()));
+}
+
+TEST_CASE("Transform Kernels 100k transforms", "[core][.benchmark]")
+{
+    using namespace Fling;
+    using Clock = std::chrono::high_resolution_clock;
+
+    const UINT32 Count = 100000;
+    const int Iterations = 20;
+    RandomTransforms Data(Count);
+
+    auto Start = Clock::now();
+    for (int It = 0; It < Iterations; ++It)
+    {
+        for (Transform& T : Data.Transforms)
+        {
+            Transform::CalculateWorldMatrix(T);
+        }
+    }
+    const double BaselineMs = std::chrono::duration<double, std::milli>(Clock::now() - Start).count() / Iterations;
+    std::cout << "[Benchmark] CalculateWorldMatrix on " << Count << " transforms: " << BaselineMs << " ms" << std::endl;
+
+    for (UINT8 i = 0; i < static_cast<UINT8>(TransformKernels::Isa::Count); ++i)
+    {
+        const TransformKernels::Isa Isa = static_cast<TransformKernels::Isa>(i);
+        if (!TransformKernels::IsSupported(Isa))
+        {
+            continue;
+        }
+
+        Start = Clock::now();
+        for (int It = 0; It < Iterations; ++It)
+        {
+            TransformKernels::UpdateWorldMatrices(Isa, Data.In, Count, Data.OutPtrs.data());
+        }
+        const double KernelMs = std::chrono::duration<double, std::milli>(Clock::now() - Start).count() / Iterations;
+        std::cout << "[Benchmark] TransformKernels " << TransformKernels::GetIsaName(Isa) << ": " << KernelMs
+            << " ms (" << BaselineMs / KernelMs << "x)" << std::endl;
+    }
+
+    REQUIRE(true);
+}
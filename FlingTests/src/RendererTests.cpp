@@ -1,6 +1,50 @@
 #include "catch2/catch.hpp"
 
 #include "pch.h"
+#include "FlingVulkan.h"
+#include "JobSystem.h"
+#include "DeviceMemoryAllocator.h"
+#include "Vertex.h"
+#include "Frustum.h"
+#include "RenderGraph.h"
+#include "MeshFile.h"
+#include "MeshImporter.h"
+#include "MeshOptimizer.h"
+#include "VertexQuantization.h"
+#include "BlockCompression.h"
+#include "TextureFile.h"
+#include "TextureImporter.h"
+#include "PipelineCacheManager.h"
+#include "ShaderReflection.h"
+#include "DescriptorLayoutCache.h"
+#include "BindlessMaterials.h"
+#include "GpuFrameTimer.h"
+#include "LogicalDevice.h"
+#include "Material.h"
+#include "LightClusterGrid.h"
+#include "OcclusionBuffer.h"
+#include "OcclusionCuller.h"
+#include "MeshSimplifier.h"
+#include "LodSelector.h"
+#include "DrawList.h"
+#include "MeshRenderer.h"
+#include "Components/Transform.h"
+#include "VulkanApp.h"
+#include "OffscreenSubpass.h"
+#include "FrustumCuller.h"
+#include "Shader.h"
+#include "ResourceManager.h"
+#include "FlingConfig.h"
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <map>
+#include <random>
 
 TEST_CASE("Renderer", "[Renderer]")
 {
@@ -8,4 +52,2930 @@ TEST_CASE("Renderer", "[Renderer]")
     {
         REQUIRE(true);
     }
-}
\ No newline at end of file
+}
+
+namespace
+{
+	/** Fake driver memory so that the allocator can be tested without a device */
+	class MockMemoryBackend : public Fling::DeviceMemoryBackend
+	{
+	public:
+
+		virtual VkDeviceMemory AllocateMemory(UINT32 t_MemoryTypeIndex, VkDeviceSize t_Size) override
+		{
+			if (FailAllocations)
+			{
+				return VK_NULL_HANDLE;
+			}
+			VkDeviceMemory Memory = (VkDeviceMemory)(uintptr_t)(NextHandle++);
+			Live[Memory] = std::vector<char>(static_cast<size_t>(t_Size));
+			++TotalAllocations;
+			return Memory;
+		}
+
+		virtual void FreeMemory(VkDeviceMemory t_Memory) override
+		{
+			REQUIRE(Live.erase(t_Memory) == 1);
+		}
+
+		virtual void* MapMemory(VkDeviceMemory t_Memory) override { return Live[t_Memory].data(); }
+
+		virtual void UnmapMemory(VkDeviceMemory t_Memory) override {}
+
+		std::map<VkDeviceMemory, std::vector<char>> Live;
+		UINT32 TotalAllocations = 0;
+		uintptr_t NextHandle = 1;
+		bool FailAllocations = false;
+	};
+
+	/** 0: Device local, 1: Host visible and coherent, 2: Host visible but not coherent */
+	VkPhysicalDeviceMemoryProperties MockMemoryProperties()
+	{
+		VkPhysicalDeviceMemoryProperties Props = {};
+		Props.memoryHeapCount = 2;
+		Props.memoryHeaps[0].size = 1024ull * 1024ull * 1024ull;
+		Props.memoryHeaps[0].flags = VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+		Props.memoryHeaps[1].size = 256ull * 1024ull * 1024ull;
+
+		Props.memoryTypeCount = 3;
+		Props.memoryTypes[0] = { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0 };
+		Props.memoryTypes[1] = { VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 1 };
+		Props.memoryTypes[2] = { VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, 1 };
+		return Props;
+	}
+
+	VkMemoryRequirements MemReqs(VkDeviceSize t_Size, VkDeviceSize t_Alignment, UINT32 t_TypeBits = 0x7)
+	{
+		VkMemoryRequirements Reqs = {};
+		Reqs.size = t_Size;
+		Reqs.alignment = t_Alignment;
+		Reqs.memoryTypeBits = t_TypeBits;
+		return Reqs;
+	}
+}
+
+TEST_CASE("Instanced vertex input", "[Renderer]")
+{
+	using namespace Fling;
+
+	std::array<VkVertexInputBindingDescription, 2> Bindings = Vertex::GetInstancedBindingDescriptions();
+	REQUIRE(Bindings[0].binding == 0);
+	REQUIRE(Bindings[0].inputRate == VK_VERTEX_INPUT_RATE_VERTEX);
+	REQUIRE(Bindings[1].binding == 1);
+	REQUIRE(Bindings[1].stride == sizeof(InstanceData));
+	REQUIRE(Bindings[1].inputRate == VK_VERTEX_INPUT_RATE_INSTANCE);
+
+	std::array<VkVertexInputAttributeDescription, 9> Attributes = Vertex::GetInstancedAttributeDescriptions();
+	std::array<VkVertexInputAttributeDescription, 5> VertexAttributes = Vertex::GetAttributeDescriptions();
+
+	// The per vertex attributes are unchanged
+	for (size_t i = 0; i < VertexAttributes.size(); ++i)
+	{
+		REQUIRE(Attributes[i].location == VertexAttributes[i].location);
+		REQUIRE(Attributes[i].offset == VertexAttributes[i].offset);
+		REQUIRE(Attributes[i].binding == 0);
+	}
+
+	// The model matrix takes one location per column
+	for (UINT32 Column = 0; Column < 4; ++Column)
+	{
+		const VkVertexInputAttributeDescription& Attrib = Attributes[VertexAttributes.size() + Column];
+		REQUIRE(Attrib.binding == 1);
+		REQUIRE(Attrib.location == 5 + Column);
+		REQUIRE(Attrib.format == VK_FORMAT_R32G32B32A32_SFLOAT);
+		REQUIRE(Attrib.offset == Column * sizeof(glm::vec4));
+	}
+}
+
+TEST_CASE("Frustum culling", "[Renderer]")
+{
+	using namespace Fling;
+
+	// 90 degree camera at the origin looking down -Z
+	const glm::mat4 Proj = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f);
+	const glm::mat4 View = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	const Frustum Frust(Proj * View);
+
+	SECTION("Planes are normalized")
+	{
+		for (UINT32 p = 0; p < Frustum::Plane::Count; ++p)
+		{
+			REQUIRE(glm::length(glm::vec3(Frust.GetPlane(static_cast<Frustum::Plane>(p)))) == Approx(1.0f));
+		}
+		REQUIRE(Frust.GetPlane(Frustum::Near).w == Approx(-0.1f));
+		REQUIRE(Frust.GetPlane(Frustum::Far).w == Approx(100.0f));
+	}
+
+	SECTION("Spheres")
+	{
+		REQUIRE(Frust.Intersects(BoundingSphere { { 0.0f, 0.0f, -10.0f }, 1.0f }));
+		// Behind the camera and past the far plane
+		REQUIRE_FALSE(Frust.Intersects(BoundingSphere { { 0.0f, 0.0f, 10.0f }, 1.0f }));
+		REQUIRE_FALSE(Frust.Intersects(BoundingSphere { { 0.0f, 0.0f, -200.0f }, 1.0f }));
+		// Off to the side, the frustum is 10 units wide on each side at this depth
+		REQUIRE_FALSE(Frust.Intersects(BoundingSphere { { 50.0f, 0.0f, -10.0f }, 1.0f }));
+		REQUIRE_FALSE(Frust.Intersects(BoundingSphere { { 0.0f, -50.0f, -10.0f }, 1.0f }));
+		// Center is outside but the sphere crosses the left and near planes
+		REQUIRE(Frust.Intersects(BoundingSphere { { -10.5f, 0.0f, -10.0f }, 1.0f }));
+		REQUIRE(Frust.Intersects(BoundingSphere { { 0.0f, 0.0f, 0.5f }, 1.0f }));
+	}
+
+	SECTION("Boxes")
+	{
+		BoundingBox Box = {};
+		Box.Expand({ -1.0f, -1.0f, -11.0f });
+		Box.Expand({ 1.0f, 1.0f, -9.0f });
+		REQUIRE(Frust.Intersects(Box));
+
+		BoundingBox Right = {};
+		Right.Expand({ 40.0f, -1.0f, -11.0f });
+		Right.Expand({ 42.0f, 1.0f, -9.0f });
+		REQUIRE_FALSE(Frust.Intersects(Right));
+
+		// Contains the whole frustum
+		BoundingBox Huge = {};
+		Huge.Expand(glm::vec3(-1000.0f));
+		Huge.Expand(glm::vec3(1000.0f));
+		REQUIRE(Frust.Intersects(Huge));
+	}
+
+	SECTION("Bounding volumes")
+	{
+		BoundingBox Box = {};
+		REQUIRE_FALSE(Box.IsValid());
+		Box.Expand(glm::vec3(-1.0f));
+		Box.Expand(glm::vec3(1.0f));
+		REQUIRE(Box.IsValid());
+
+		BoundingSphere Sphere = BoundingSphere::FromBox(Box);
+		REQUIRE(Sphere.Radius == Approx(std::sqrt(3.0f)));
+
+		// Non uniform scale takes the biggest axis
+		BoundingSphere Unit = { { 1.0f, 0.0f, 0.0f }, 1.0f };
+		const glm::mat4 World = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -5.0f)), glm::vec3(1.0f, 3.0f, 1.0f));
+		BoundingSphere Moved = Unit.Transformed(World);
+		REQUIRE(Moved.Center.x == Approx(1.0f));
+		REQUIRE(Moved.Center.z == Approx(-5.0f));
+		REQUIRE(Moved.Radius == Approx(3.0f));
+	}
+
+	SECTION("Batched spheres match the single sphere test")
+	{
+		// Not a multiple of the SIMD width so the remainder is tested too
+		const UINT32 Count = 1003;
+		std::vector<float> X(Count), Y(Count), Z(Count), R(Count);
+
+		std::mt19937 Gen(1234);
+		std::uniform_real_distribution<float> Pos(-60.0f, 60.0f);
+		std::uniform_real_distribution<float> Rad(0.0f, 5.0f);
+
+		std::vector<UINT32> Expected;
+		for (UINT32 i = 0; i < Count; ++i)
+		{
+			X[i] = Pos(Gen);
+			Y[i] = Pos(Gen);
+			Z[i] = Pos(Gen);
+			R[i] = Rad(Gen);
+			if (Frust.Intersects(BoundingSphere { { X[i], Y[i], Z[i] }, R[i] }))
+			{
+				Expected.emplace_back(i);
+			}
+		}
+
+		std::vector<UINT32> Visible(Count);
+		const UINT32 VisibleCount = Frust.CullSpheres(X.data(), Y.data(), Z.data(), R.data(), Count, Visible.data());
+		Visible.resize(VisibleCount);
+
+		REQUIRE(!Expected.empty());
+		REQUIRE(Expected.size() < Count);
+		REQUIRE(Visible == Expected);
+	}
+}
+
+TEST_CASE("Frustum culling 100k spheres", "[Renderer][.benchmark]")
+{
+	using namespace Fling;
+
+	const glm::mat4 Proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 500.0f);
+	const glm::mat4 View = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	const Frustum Frust(Proj * View);
+
+	const UINT32 Count = 100000;
+	std::vector<float> X(Count), Y(Count), Z(Count), R(Count);
+	std::vector<UINT32> Visible(Count);
+
+	std::mt19937 Gen(42);
+	std::uniform_real_distribution<float> Pos(-500.0f, 500.0f);
+	std::uniform_real_distribution<float> Rad(0.5f, 2.0f);
+	for (UINT32 i = 0; i < Count; ++i)
+	{
+		X[i] = Pos(Gen);
+		Y[i] = Pos(Gen);
+		Z[i] = Pos(Gen);
+		R[i] = Rad(Gen);
+	}
+
+	const INT32 Iterations = 200;
+	UINT32 VisibleCount = 0;
+
+	auto Start = std::chrono::high_resolution_clock::now();
+	for (INT32 i = 0; i < Iterations; ++i)
+	{
+		VisibleCount = Frust.CullSpheres(X.data(), Y.data(), Z.data(), R.data(), Count, Visible.data());
+	}
+	auto End = std::chrono::high_resolution_clock::now();
+
+	const double Seconds = std::chrono::duration<double>(End - Start).count();
+	std::cout << "[Benchmark] Culled " << Count << " spheres (" << VisibleCount << " visible) in "
+		<< (Seconds / Iterations * 1000.0) << " ms" << std::endl;
+}
+
+TEST_CASE("Device Memory Allocator", "[Renderer]")
+{
+	using namespace Fling;
+	// Logger HAS to be initalized first
+	Logger::Get().Init();
+
+	DeviceMemoryAllocator::Config Conf = {};
+	Conf.BlockSize = 1024 * 1024;
+	Conf.MinAllocationSize = 256;
+
+	MockMemoryBackend* Backend = new MockMemoryBackend();
+	std::unique_ptr<DeviceMemoryAllocator> Allocator = std::make_unique<DeviceMemoryAllocator>(MockMemoryProperties(), 64, std::unique_ptr<DeviceMemoryBackend>(Backend), Conf);
+
+	SECTION("Buddy allocator splits and merges")
+	{
+		BuddySubAllocator Buddy(4096, 256);
+		VkDeviceSize A = 0, B = 0, C = 0;
+		REQUIRE(Buddy.Allocate(1000, 16, A));
+		REQUIRE(Buddy.Allocate(256, 256, B));
+		REQUIRE(Buddy.Allocate(2048, 2048, C));
+		REQUIRE(A == 0);
+		REQUIRE(B == 1024);
+		REQUIRE(C == 2048);
+		REQUIRE(Buddy.GetReservedSize() == 1024 + 256 + 2048);
+
+		VkDeviceSize D = 0;
+		REQUIRE_FALSE(Buddy.Allocate(1024, 1, D));
+
+		// Once everything is freed the whole block is one node again
+		Buddy.Free(B);
+		Buddy.Free(A);
+		Buddy.Free(C);
+		REQUIRE(Buddy.IsEmpty());
+		REQUIRE(Buddy.Allocate(4096, 1, D));
+		REQUIRE(D == 0);
+	}
+
+	SECTION("Linear allocator rewinds when empty")
+	{
+		LinearSubAllocator Linear(1024);
+		VkDeviceSize A = 0, B = 0, C = 0;
+		REQUIRE(Linear.Allocate(100, 4, A));
+		REQUIRE(Linear.Allocate(100, 64, B));
+		REQUIRE(B == 128);
+		REQUIRE_FALSE(Linear.Allocate(1024, 1, C));
+
+		Linear.Free(A);
+		REQUIRE(Linear.GetReservedSize() == 228);
+		Linear.Free(B);
+		REQUIRE(Linear.GetReservedSize() == 0);
+		REQUIRE(Linear.Allocate(1024, 1, C));
+	}
+
+	SECTION("Allocations share blocks")
+	{
+		std::vector<DeviceAllocation> Allocs(64);
+		for (DeviceAllocation& Alloc : Allocs)
+		{
+			REQUIRE(Allocator->Allocate(MemReqs(1000, 256), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ResourceLayout::Linear, Alloc));
+			REQUIRE(Alloc.MemoryTypeIndex == 0);
+			REQUIRE(Alloc.Offset % 256 == 0);
+			REQUIRE(Alloc.MappedData == nullptr);
+		}
+
+		REQUIRE(Backend->TotalAllocations == 1);
+		for (size_t i = 1; i < Allocs.size(); ++i)
+		{
+			REQUIRE(Allocs[i].Memory == Allocs[0].Memory);
+			REQUIRE(Allocs[i].Offset != Allocs[i - 1].Offset);
+		}
+
+		DeviceMemoryStats Stats = Allocator->GetStats();
+		REQUIRE(Stats.BlockCount == 1);
+		REQUIRE(Stats.AllocationCount == 64);
+		REQUIRE(Stats.UsedBytes == 64 * 1000);
+		REQUIRE(Stats.AllocatedBytes == Conf.BlockSize);
+
+		for (DeviceAllocation& Alloc : Allocs)
+		{
+			Allocator->Free(Alloc);
+			REQUIRE_FALSE(Alloc.IsValid());
+		}
+
+		// One empty block is kept around so that we don't thrash the driver
+		Stats = Allocator->GetStats();
+		REQUIRE(Stats.AllocationCount == 0);
+		REQUIRE(Stats.BlockCount == 1);
+	}
+
+	SECTION("Memory types and mapping")
+	{
+		DeviceAllocation Host = {};
+		REQUIRE(Allocator->Allocate(MemReqs(100, 4), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, ResourceLayout::Linear, Host));
+		REQUIRE(Host.MemoryTypeIndex == 1);
+		REQUIRE(Host.MappedData != nullptr);
+
+		// Memory type bits have to be respected even if another type has the properties
+		DeviceAllocation NonCoherent = {};
+		REQUIRE(Allocator->Allocate(MemReqs(100, 4, 0x4), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, ResourceLayout::Linear, NonCoherent));
+		REQUIRE(NonCoherent.MemoryTypeIndex == 2);
+
+		// Non coherent memory is padded to the atom size so flushes don't touch other allocations
+		REQUIRE(NonCoherent.Size == 128);
+		REQUIRE(NonCoherent.Offset % 64 == 0);
+
+		DeviceAllocation None = {};
+		REQUIRE_FALSE(Allocator->Allocate(MemReqs(100, 4, 0x1), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, ResourceLayout::Linear, None));
+
+		Allocator->Free(Host);
+		Allocator->Free(NonCoherent);
+	}
+
+	SECTION("Linear and optimal resources never share a block")
+	{
+		DeviceAllocation Buf = {};
+		DeviceAllocation Image = {};
+		REQUIRE(Allocator->Allocate(MemReqs(1000, 256), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ResourceLayout::Linear, Buf));
+		REQUIRE(Allocator->Allocate(MemReqs(1000, 256), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ResourceLayout::Optimal, Image));
+		REQUIRE(Buf.Memory != Image.Memory);
+
+		Allocator->Free(Buf);
+		Allocator->Free(Image);
+	}
+
+	SECTION("Large allocations are dedicated")
+	{
+		DeviceAllocation Big = {};
+		REQUIRE(Allocator->Allocate(MemReqs(Conf.BlockSize, 256), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ResourceLayout::Optimal, Big));
+		REQUIRE(Big.Block == nullptr);
+		REQUIRE(Big.Offset == 0);
+		REQUIRE(Allocator->GetStats(0).DedicatedAllocationCount == 1);
+
+		Allocator->Free(Big);
+		REQUIRE(Allocator->GetStats(0).DedicatedAllocationCount == 0);
+		REQUIRE(Backend->Live.empty());
+	}
+
+	SECTION("Out of memory")
+	{
+		Backend->FailAllocations = true;
+		DeviceAllocation Alloc = {};
+		REQUIRE_FALSE(Allocator->Allocate(MemReqs(1000, 256), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ResourceLayout::Linear, Alloc));
+		REQUIRE_FALSE(Alloc.IsValid());
+	}
+
+	SECTION("Defragmentation moves allocations out of sparse blocks")
+	{
+		// Fill up the first block and spill into a second one
+		const VkDeviceSize AllocSize = Conf.BlockSize / 4;
+		std::vector<DeviceAllocation> Allocs(5);
+		for (DeviceAllocation& Alloc : Allocs)
+		{
+			REQUIRE(Allocator->Allocate(MemReqs(AllocSize, 256), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ResourceLayout::Linear, Alloc));
+		}
+		REQUIRE(Allocator->GetStats().BlockCount == 2);
+
+		// Make room in the first block, the allocation in the second one should move there
+		Allocator->Free(Allocs[0]);
+
+		UINT32 CallbackCount = 0;
+		Allocator->SetMoveCallback(Allocs[4], [&](const DeviceAllocation& t_From, const DeviceAllocation& t_To)
+		{
+			++CallbackCount;
+			REQUIRE(t_From.Memory == Allocs[4].Memory);
+			REQUIRE(t_To.Memory == Allocs[1].Memory);
+			Allocs[4] = t_To;
+			return true;
+		});
+
+		REQUIRE(Allocator->Defragment() == 1);
+		REQUIRE(CallbackCount == 1);
+		REQUIRE(Allocs[4].Memory == Allocs[1].Memory);
+		REQUIRE(Allocator->GetStats().BlockCount == 1);
+
+		for (size_t i = 1; i < Allocs.size(); ++i)
+		{
+			Allocator->Free(Allocs[i]);
+		}
+		REQUIRE(Allocator->GetStats().AllocationCount == 0);
+	}
+
+	Allocator.reset();
+	Logger::Get().Shutdown();
+}
+
+namespace
+{
+	/**
+	 * True if the Vulkan loader can find a device. Run with a software ICD (i.e.
+	 * VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json) on machines without a GPU
+	 */
+	bool HasVulkanDevice()
+	{
+		VkApplicationInfo appInfo = {};
+		appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+		appInfo.apiVersion = VK_API_VERSION_1_1;
+
+		VkInstanceCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+		createInfo.pApplicationInfo = &appInfo;
+
+		VkInstance Instance = VK_NULL_HANDLE;
+		if (vkCreateInstance(&createInfo, nullptr, &Instance) != VK_SUCCESS)
+		{
+			return false;
+		}
+
+		UINT32 DeviceCount = 0;
+		vkEnumeratePhysicalDevices(Instance, &DeviceCount, nullptr);
+		vkDestroyInstance(Instance, nullptr);
+		return DeviceCount > 0;
+	}
+}
+
+TEST_CASE("Offscreen pass recording", "[Renderer][.benchmark]")
+{
+	using namespace Fling;
+
+	if (!HasVulkanDevice())
+	{
+		WARN("No Vulkan device available, skipping the offscreen recording benchmark");
+		return;
+	}
+
+	Logger::Get().Init();
+	ResourceManager::Get().Init();
+	FlingConfig::Get().Init();
+	VulkanApp::Get().InitHeadless();
+
+	LogicalDevice* Device = VulkanApp::Get().GetLogicalDevice();
+	std::shared_ptr<Shader> Vert = Shader::Create(HS("Shaders/Deferred/mrt_instanced_vert.spv"), Device);
+	std::shared_ptr<Shader> PackedVert = Shader::Create(HS("Shaders/Deferred/mrt_instanced_packed_vert.spv"), Device);
+	std::shared_ptr<Shader> Frag = Shader::Create(HS("Shaders/Deferred/mrt_frag.spv"), Device);
+	Material* DefaultMat = Material::GetDefaultMat().get();
+
+	// Every model is a batch of its own, so there are enough batches for the pass to split them between threads
+	const UINT32 ModelCount = 1024;
+	std::vector<std::string> ModelNames(ModelCount);
+	std::vector<std::shared_ptr<Model>> Models(ModelCount);
+	for (UINT32 i = 0; i < ModelCount; ++i)
+	{
+		std::vector<Vertex> Verts(4);
+		for (UINT32 c = 0; c < 4; ++c)
+		{
+			Verts[c].Pos = { static_cast<float>(c & 1), static_cast<float>(c >> 1), 0.0f };
+			Verts[c].TexCoord = { static_cast<float>(c & 1), static_cast<float>(c >> 1) };
+			Verts[c].Color = { 1.0f, 1.0f, 1.0f };
+			Verts[c].Normal = { 0.0f, 0.0f, 1.0f };
+		}
+
+		ModelNames[i] = "Benchmark_Quad_" + std::to_string(i);
+		Models[i] = std::make_shared<Model>(HS(ModelNames[i].c_str()), Verts, std::vector<UINT32> { 0, 1, 3, 0, 3, 2 });
+	}
+
+	// Everything is visible, so every batch is drawn
+	const Frustum Everything(glm::ortho(-1000.0f, 1000.0f, -1000.0f, 1000.0f, -1000.0f, 1000.0f));
+	FrustumCuller FrustCuller;
+	OcclusionCuller Culler;
+	Culler.SetEnabled(false);
+
+	const std::vector<UINT32> ThreadCounts = { 1, 2, 4, 8 };
+	const std::vector<UINT32> EntityCounts = { 1000, 10000, 100000 };
+	const UINT32 FramesInFlight = VulkanApp::Get().GetFramesInFlight();
+	const UINT32 Iterations = 10;
+
+	for (UINT32 ThreadCount : ThreadCounts)
+	{
+		// The pass makes a command pool for every job system thread when it is created
+		JobSystem::Get().Init(ThreadCount);
+
+		for (UINT32 EntityCount : EntityCounts)
+		{
+			entt::registry Reg;
+			std::unique_ptr<OffscreenSubpass> Offscreen = std::make_unique<OffscreenSubpass>(
+				Device, nullptr, Reg, VulkanApp::Get().GetCamera(), &Culler, Vert, Frag, PackedVert);
+			Offscreen->CreateGraphicsPipeline();
+
+			std::vector<entt::entity> Entities(EntityCount);
+			for (UINT32 i = 0; i < EntityCount; ++i)
+			{
+				Entities[i] = Reg.create();
+				Reg.assign<Transform>(Entities[i]);
+				Reg.assign<MeshRenderer>(Entities[i], Models[i % ModelCount].get(), DefaultMat);
+			}
+
+			auto DrawFrame = [&](UINT32 t_Frame)
+			{
+				FrustCuller.Cull(Reg, Everything);
+				Culler.Cull(Reg, glm::mat4(1.0f), FrustCuller.GetVisibleEntities());
+
+				auto Start = std::chrono::high_resolution_clock::now();
+				Offscreen->Draw(*Offscreen->GetCommandBuffer(t_Frame), VK_NULL_HANDLE, t_Frame, Reg, 0.0f);
+				auto End = std::chrono::high_resolution_clock::now();
+				return std::chrono::duration<double, std::milli>(End - Start).count();
+			};
+
+			// The first draw of each frame creates the instance buffers and secondary command buffers
+			for (UINT32 Frame = 0; Frame < FramesInFlight; ++Frame)
+			{
+				DrawFrame(Frame);
+			}
+
+			double TotalMs = 0.0;
+			for (UINT32 Iter = 0; Iter < Iterations; ++Iter)
+			{
+				// Replacing a mesh renderer makes the pass rebuild its batches and record the frame again
+				const entt::entity Ent = Entities[Iter % EntityCount];
+				Reg.replace<MeshRenderer>(Ent, Reg.get<MeshRenderer>(Ent).m_Model, DefaultMat);
+
+				TotalMs += DrawFrame(Iter % FramesInFlight);
+			}
+
+			const DrawListStats Stats = Offscreen->GetDrawStats();
+			REQUIRE(Stats.Draws == std::min(EntityCount, ModelCount));
+
+			std::cout << "[Benchmark] Recorded " << Stats.Draws << " batches of " << EntityCount << " meshes on "
+				<< ThreadCount << " threads in " << (TotalMs / Iterations) << " ms" << std::endl;
+
+			// Destroy the meshes while the pass is still listening for them
+			for (entt::entity Ent : Entities)
+			{
+				Reg.destroy(Ent);
+			}
+			Offscreen->CleanUp(Reg);
+			Offscreen.reset();
+		}
+
+		JobSystem::Get().Shutdown();
+	}
+
+	Models.clear();
+	Vert.reset();
+	PackedVert.reset();
+	Frag.reset();
+
+	// Same order as the engine, resources give back their memory before the devices are destroyed
+	entt::registry EmptyReg;
+	ResourceManager::Get().Shutdown();
+	VulkanApp::Get().Shutdown(EmptyReg);
+	FlingConfig::Get().Shutdown();
+	Logger::Get().Shutdown();
+}
+
+TEST_CASE("Render graph", "[Renderer]")
+{
+	using namespace Fling;
+	Logger::Get().Init();
+
+	RenderGraphTextureDesc Desc = {};
+	Desc.Width = 256;
+	Desc.Height = 256;
+	Desc.Format = VK_FORMAT_R8G8B8A8_UNORM;
+	Desc.Size = 1024;
+	Desc.Alignment = 256;
+
+	RenderGraph Graph;
+
+	SECTION("Deferred passes")
+	{
+		// The same passes that the engine uses, the G-Buffer render pass leaves it ready to sample
+		RenderGraphResource Backbuffer = Graph.ImportTexture("Backbuffer", Desc);
+		RenderGraphResource Albedo = Graph.ImportTexture("GBuffer.Albedo", Desc, (VkImage)(uintptr_t)1);
+
+		UINT32 GBuffer = Graph.AddPass("G-Buffer");
+		UINT32 Lighting = Graph.AddPass("Deferred Lighting");
+		UINT32 UI = Graph.AddPass("ImGui");
+
+		Albedo = Graph.Write(GBuffer, Albedo, RenderGraphUsage::ColorAttachment, RenderGraphUsage::ShaderRead);
+		Graph.Read(Lighting, Albedo, RenderGraphUsage::ShaderRead);
+		Backbuffer = Graph.Write(Lighting, Backbuffer, RenderGraphUsage::ColorAttachment);
+		Backbuffer = Graph.Write(UI, Backbuffer, RenderGraphUsage::ColorAttachment);
+
+		REQUIRE(Graph.Compile());
+		REQUIRE(Graph.GetExecutionOrder() == std::vector<UINT32> { GBuffer, Lighting, UI });
+		REQUIRE(Graph.GetLevels().size() == 3);
+
+		// Attachments with undefined contents are transitioned by their render pass
+		REQUIRE(Graph.GetPass(GBuffer).Barriers.empty());
+		REQUIRE(Graph.GetPass(UI).Barriers.empty());
+
+		const std::vector<RenderGraphBarrier>& Barriers = Graph.GetPass(Lighting).Barriers;
+		REQUIRE(Barriers.size() == 1);
+		REQUIRE(Barriers[0].Texture == Albedo.Index);
+		REQUIRE(Barriers[0].SrcPass == GBuffer);
+		REQUIRE(Barriers[0].SrcStages == VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		REQUIRE(Barriers[0].SrcAccess == VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+		REQUIRE((Barriers[0].DstStages & VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT) != 0);
+		REQUIRE(Barriers[0].DstAccess == VK_ACCESS_SHADER_READ_BIT);
+		REQUIRE(Barriers[0].OldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		REQUIRE(Barriers[0].NewLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	}
+
+	SECTION("Passes are ordered by what they use and unused passes are culled")
+	{
+		RenderGraphResource Output = Graph.ImportTexture("Output", Desc);
+		RenderGraphResource Shadow = Graph.CreateTexture("Shadow", Desc);
+		RenderGraphResource Unused = Graph.CreateTexture("Unused", Desc);
+
+		// Added in the opposite order that they have to run in
+		UINT32 Composite = Graph.AddPass("Composite");
+		UINT32 Debug = Graph.AddPass("Debug");
+		UINT32 ShadowPass = Graph.AddPass("Shadow");
+
+		RenderGraphResource ShadowMap = Graph.Write(ShadowPass, Shadow, RenderGraphUsage::DepthAttachment);
+		Graph.Read(Composite, ShadowMap, RenderGraphUsage::DepthRead);
+		Graph.Write(Composite, Output, RenderGraphUsage::ColorAttachment);
+		Graph.Write(Debug, Unused, RenderGraphUsage::ColorAttachment);
+
+		REQUIRE(Graph.FindTexture("Shadow").Version == 1);
+		REQUIRE_FALSE(Graph.FindTexture("Missing").IsValid());
+
+		REQUIRE(Graph.Compile());
+		REQUIRE(Graph.GetExecutionOrder() == std::vector<UINT32> { ShadowPass, Composite });
+		REQUIRE(Graph.GetPass(Debug).IsCulled);
+		REQUIRE_FALSE(Graph.GetTexture(Unused).IsUsed());
+
+		// Passes with side effects always run
+		RenderGraph SideEffects;
+		UINT32 Readback = SideEffects.AddPass("Readback", true);
+		SideEffects.Write(Readback, SideEffects.CreateTexture("Scratch", Desc), RenderGraphUsage::TransferDst);
+		REQUIRE(SideEffects.Compile());
+		REQUIRE(SideEffects.GetExecutionOrder() == std::vector<UINT32> { Readback });
+	}
+
+	SECTION("Independent passes share a level")
+	{
+		RenderGraphResource Output = Graph.ImportTexture("Output", Desc);
+		RenderGraphResource A = Graph.CreateTexture("A", Desc);
+		RenderGraphResource B = Graph.CreateTexture("B", Desc);
+
+		UINT32 PassA = Graph.AddPass("A");
+		UINT32 PassB = Graph.AddPass("B");
+		UINT32 Combine = Graph.AddPass("Combine");
+
+		A = Graph.Write(PassA, A, RenderGraphUsage::StorageWrite);
+		B = Graph.Write(PassB, B, RenderGraphUsage::StorageWrite);
+		Graph.Read(Combine, A, RenderGraphUsage::ShaderRead);
+		Graph.Read(Combine, B, RenderGraphUsage::ShaderRead);
+		Graph.Write(Combine, Output, RenderGraphUsage::ColorAttachment);
+
+		REQUIRE(Graph.Compile());
+		REQUIRE(Graph.GetLevels().size() == 2);
+		REQUIRE(Graph.GetLevels()[0] == std::vector<UINT32> { PassA, PassB });
+		REQUIRE(Graph.GetLevels()[1] == std::vector<UINT32> { Combine });
+		REQUIRE(Graph.GetPass(Combine).Level == 1);
+	}
+
+	SECTION("Layout transitions and write after read")
+	{
+		RenderGraphResource Output = Graph.ImportTexture("Output", Desc, VK_NULL_HANDLE, VK_IMAGE_ASPECT_COLOR_BIT, RenderGraphUsage::Present);
+		RenderGraphResource Scratch = Graph.CreateTexture("Scratch", Desc);
+
+		UINT32 W = Graph.AddPass("Write");
+		UINT32 R = Graph.AddPass("Read");
+		UINT32 C = Graph.AddPass("Copy", true);
+
+		Scratch = Graph.Write(W, Scratch, RenderGraphUsage::StorageWrite);
+		Graph.Read(R, Scratch, RenderGraphUsage::ShaderRead);
+		RenderGraphResource Out = Graph.Write(R, Output, RenderGraphUsage::ColorAttachment);
+
+		// The copy overwrites what the read pass uses, so it has to wait for it
+		Scratch = Graph.Write(C, Scratch, RenderGraphUsage::TransferDst);
+		Graph.Read(C, Out, RenderGraphUsage::TransferSrc);
+
+		REQUIRE(Graph.Compile());
+		REQUIRE(Graph.GetExecutionOrder() == std::vector<UINT32> { W, R, C });
+
+		// Storage images don't have a render pass, so the first use transitions out of undefined
+		const std::vector<RenderGraphBarrier>& First = Graph.GetPass(W).Barriers;
+		REQUIRE(First.size() == 1);
+		REQUIRE(First[0].OldLayout == VK_IMAGE_LAYOUT_UNDEFINED);
+		REQUIRE(First[0].NewLayout == VK_IMAGE_LAYOUT_GENERAL);
+		REQUIRE(First[0].SrcPass == UINT32_MAX);
+
+		// The output starts out presented, so it needs to become an attachment
+		const std::vector<RenderGraphBarrier>& Second = Graph.GetPass(R).Barriers;
+		REQUIRE(Second.size() == 2);
+		REQUIRE(Second[0].OldLayout == VK_IMAGE_LAYOUT_GENERAL);
+		REQUIRE(Second[0].NewLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		REQUIRE(Second[0].SrcAccess == VK_ACCESS_SHADER_WRITE_BIT);
+		REQUIRE(Second[1].OldLayout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+		REQUIRE(Second[1].NewLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+
+		const std::vector<RenderGraphBarrier>& Third = Graph.GetPass(C).Barriers;
+		REQUIRE(Third.size() == 2);
+		REQUIRE(Third[0].SrcPass == R);
+		REQUIRE(Third[0].OldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		REQUIRE(Third[0].NewLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+		REQUIRE((Third[0].SrcStages & VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT) != 0);
+		REQUIRE(Third[0].DstAccess == VK_ACCESS_TRANSFER_WRITE_BIT);
+		REQUIRE(Third[1].SrcAccess == VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+		REQUIRE(Third[1].NewLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+		// The image usage covers every access
+		REQUIRE(Graph.GetTexture(Scratch).ImageUsage == (VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT));
+	}
+
+	SECTION("Transient textures alias memory once they are dead")
+	{
+		RenderGraphResource Output = Graph.ImportTexture("Output", Desc);
+		RenderGraphResource A = Graph.CreateTexture("A", Desc);
+		RenderGraphResource B = Graph.CreateTexture("B", Desc);
+		RenderGraphResource C = Graph.CreateTexture("C", Desc);
+
+		UINT32 Pass0 = Graph.AddPass("0");
+		UINT32 Pass1 = Graph.AddPass("1");
+		UINT32 Pass2 = Graph.AddPass("2");
+		UINT32 Pass3 = Graph.AddPass("3");
+
+		// A lives for passes 0 and 1, B and C for 2 and 3
+		A = Graph.Write(Pass0, A, RenderGraphUsage::ColorAttachment);
+		Graph.Read(Pass1, A, RenderGraphUsage::ShaderRead);
+		RenderGraphResource Out = Graph.Write(Pass1, Output, RenderGraphUsage::ColorAttachment);
+		B = Graph.Write(Pass2, B, RenderGraphUsage::ColorAttachment);
+		C = Graph.Write(Pass2, C, RenderGraphUsage::ColorAttachment);
+		Out = Graph.Write(Pass2, Out, RenderGraphUsage::ColorAttachment);
+		Graph.Read(Pass3, B, RenderGraphUsage::ShaderRead);
+		Graph.Read(Pass3, C, RenderGraphUsage::ShaderRead);
+		Graph.Write(Pass3, Out, RenderGraphUsage::ColorAttachment);
+
+		REQUIRE(Graph.Compile());
+		REQUIRE(Graph.GetExecutionOrder() == std::vector<UINT32> { Pass0, Pass1, Pass2, Pass3 });
+		REQUIRE(Graph.GetTexture(A).FirstUse == 0);
+		REQUIRE(Graph.GetTexture(A).LastUse == 1);
+
+		REQUIRE(Graph.GetTexture(A).MemoryOffset == 0);
+		REQUIRE(Graph.GetTexture(B).MemoryOffset == 0);
+		REQUIRE(Graph.GetTexture(C).MemoryOffset == 1024);
+		REQUIRE(Graph.GetTransientMemorySize() == 2048);
+		REQUIRE(Graph.GetTexture(B).AliasedTextures == std::vector<UINT32> { A.Index });
+		REQUIRE(Graph.GetTexture(C).AliasedTextures.empty());
+
+		// B has to wait for the last read of A before it can reuse the memory
+		const std::vector<RenderGraphBarrier>& Barriers = Graph.GetPass(Pass2).Barriers;
+		REQUIRE(Barriers.size() == 1);
+		REQUIRE(Barriers[0].Texture == B.Index);
+		REQUIRE(Barriers[0].OldLayout == VK_IMAGE_LAYOUT_UNDEFINED);
+		REQUIRE(Barriers[0].NewLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+		REQUIRE((Barriers[0].SrcStages & VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT) != 0);
+	}
+
+	SECTION("Cycles fail to compile")
+	{
+		RenderGraphResource A = Graph.ImportTexture("A", Desc);
+		RenderGraphResource B = Graph.ImportTexture("B", Desc);
+
+		UINT32 Pass0 = Graph.AddPass("0");
+		UINT32 Pass1 = Graph.AddPass("1");
+
+		A = Graph.Write(Pass0, A, RenderGraphUsage::ColorAttachment);
+		B = Graph.Write(Pass1, B, RenderGraphUsage::ColorAttachment);
+		Graph.Read(Pass0, B, RenderGraphUsage::ShaderRead);
+		Graph.Read(Pass1, A, RenderGraphUsage::ShaderRead);
+
+		REQUIRE_FALSE(Graph.Compile());
+	}
+}
+
+TEST_CASE("Cooked mesh files", "[Renderer]")
+{
+	using namespace Fling;
+	Logger::Get().Init();
+
+	const std::string CookedPath = (std::filesystem::temp_directory_path() / "FlingTestMesh.flmesh").string();
+
+	std::vector<Vertex> Verts(3);
+	Verts[0].Pos = { 0.0f, 0.0f, 0.0f };
+	Verts[1].Pos = { 1.0f, 0.0f, 0.0f };
+	Verts[2].Pos = { 0.0f, 2.0f, -1.0f };
+	Verts[2].TexCoord = { 0.5f, 1.0f };
+	std::vector<UINT32> Indices = { 0, 1, 2 };
+
+	SECTION("Cooked path sits next to the source")
+	{
+		REQUIRE(MeshFile::GetCookedPath("Models/cube.obj") == "Models/cube.flmesh");
+		REQUIRE(MeshFile::GetCookedPath("Models/cube.flmesh") == "Models/cube.flmesh");
+	}
+
+	SECTION("Round trip")
+	{
+		REQUIRE(MeshFile::Write(CookedPath, Verts, Indices, MeshImporter::CalculateBounds(Verts)));
+
+		MeshFile File;
+		REQUIRE(File.Open(CookedPath));
+		REQUIRE(File.GetVertexCount() == 3);
+		REQUIRE(File.GetIndexCount() == 3);
+		REQUIRE(std::memcmp(File.GetVertices(), Verts.data(), sizeof(Vertex) * Verts.size()) == 0);
+		REQUIRE(File.GetIndexSize() == sizeof(UINT16));
+		const UINT16* FileIndices = static_cast<const UINT16*>(File.GetIndexData());
+		REQUIRE(std::vector<UINT32>(FileIndices, FileIndices + 3) == Indices);
+		REQUIRE(reinterpret_cast<uintptr_t>(File.GetVertices()) % MeshFile::DataAlignment == 0);
+
+		BoundingBox Bounds = File.GetBounds();
+		REQUIRE(Bounds.Min == glm::vec3(0.0f, 0.0f, -1.0f));
+		REQUIRE(Bounds.Max == glm::vec3(1.0f, 2.0f, 0.0f));
+	}
+
+	SECTION("Stale and truncated files are rejected")
+	{
+		REQUIRE(MeshFile::Write(CookedPath, Verts, Indices, MeshImporter::CalculateBounds(Verts)));
+
+		// Pretend the file came from an older version
+		{
+			std::fstream Stream(CookedPath, std::ios::in | std::ios::out | std::ios::binary);
+			const UINT32 OldVersion = MeshFile::Version - 1;
+			Stream.seekp(offsetof(MeshFileHeader, Version));
+			Stream.write(reinterpret_cast<const char*>(&OldVersion), sizeof(OldVersion));
+		}
+		MeshFile File;
+		REQUIRE_FALSE(File.Open(CookedPath));
+
+		REQUIRE(MeshFile::Write(CookedPath, Verts, Indices, MeshImporter::CalculateBounds(Verts)));
+		std::filesystem::resize_file(CookedPath, std::filesystem::file_size(CookedPath) - 4);
+		REQUIRE_FALSE(File.Open(CookedPath));
+
+		REQUIRE_FALSE(File.Open(CookedPath + ".missing"));
+	}
+
+	SECTION("Indices past the vertices are rejected")
+	{
+		const std::vector<UINT32> BadIndices = { 0, 1, 3 };
+		REQUIRE(MeshFile::Write(CookedPath, Verts, BadIndices, MeshImporter::CalculateBounds(Verts)));
+
+		MeshFile File;
+		REQUIRE_FALSE(File.Open(CookedPath));
+	}
+
+	SECTION("Cooked models match the obj")
+	{
+		const std::string SourcePath = FlingPaths::EngineAssetsDir() + "/Models/cube.obj";
+		REQUIRE(MeshImporter::Cook(SourcePath, CookedPath));
+		REQUIRE(MeshFile::IsUpToDate(SourcePath, CookedPath));
+
+		std::vector<Vertex> ObjVerts;
+		std::vector<UINT32> ObjIndices;
+		REQUIRE(MeshImporter::Import(SourcePath, ObjVerts, ObjIndices));
+
+		MeshFile File;
+		REQUIRE(File.Open(CookedPath));
+		REQUIRE(File.GetVertexCount() == ObjVerts.size());
+		REQUIRE(File.GetIndexCount() == ObjIndices.size());
+		REQUIRE(File.GetBounds().Max == MeshImporter::CalculateBounds(ObjVerts).Max);
+
+		// The obj has no vertex colors
+		REQUIRE(File.GetVertexFormat() == VertexFormat::Packed);
+	}
+
+	std::filesystem::remove(CookedPath);
+}
+
+namespace
+{
+	/** Flat grid of quads with one vertex per index, like a mesh straight out of an obj */
+	void BuildUnweldedGrid(UINT32 t_Size, std::vector<Fling::Vertex>& t_OutVerts, std::vector<UINT32>& t_OutIndices)
+	{
+		using namespace Fling;
+		auto AddVertex = [&](UINT32 x, UINT32 y)
+		{
+			Vertex Vert = {};
+			Vert.Pos = glm::vec3(static_cast<float>(x), static_cast<float>(y), 0.0f);
+			Vert.Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+			Vert.TexCoord = glm::vec2(static_cast<float>(x) / t_Size, static_cast<float>(y) / t_Size);
+			t_OutIndices.push_back(static_cast<UINT32>(t_OutVerts.size()));
+			t_OutVerts.push_back(Vert);
+		};
+
+		for (UINT32 y = 0; y < t_Size; ++y)
+		{
+			for (UINT32 x = 0; x < t_Size; ++x)
+			{
+				AddVertex(x, y);
+				AddVertex(x + 1, y);
+				AddVertex(x + 1, y + 1);
+
+				AddVertex(x, y);
+				AddVertex(x + 1, y + 1);
+				AddVertex(x, y + 1);
+			}
+		}
+	}
+
+	/** Triangles as sorted vertex positions, so that meshes can be compared after they are reordered */
+	std::vector<std::array<float, 9>> GetTriangles(const std::vector<Fling::Vertex>& t_Verts, const std::vector<UINT32>& t_Indices)
+	{
+		std::vector<std::array<float, 9>> Triangles;
+		for (size_t i = 0; i < t_Indices.size(); i += 3)
+		{
+			std::array<std::array<float, 3>, 3> Corners;
+			for (size_t c = 0; c < 3; ++c)
+			{
+				const glm::vec3& Pos = t_Verts[t_Indices[i + c]].Pos;
+				Corners[c] = { Pos.x, Pos.y, Pos.z };
+			}
+			// Rotate so that the smallest corner is first, which keeps the winding
+			const size_t First = std::min_element(Corners.begin(), Corners.end()) - Corners.begin();
+			std::array<float, 9> Tri;
+			for (size_t c = 0; c < 3; ++c)
+			{
+				std::copy(Corners[(First + c) % 3].begin(), Corners[(First + c) % 3].end(), Tri.begin() + c * 3);
+			}
+			Triangles.push_back(Tri);
+		}
+		std::sort(Triangles.begin(), Triangles.end());
+		return Triangles;
+	}
+}
+
+TEST_CASE("Mesh optimizer", "[Renderer]")
+{
+	using namespace Fling;
+
+	std::vector<Vertex> Verts;
+	std::vector<UINT32> Indices;
+	BuildUnweldedGrid(16, Verts, Indices);
+	const std::vector<std::array<float, 9>> SourceTriangles = GetTriangles(Verts, Indices);
+
+	SECTION("Welding")
+	{
+		REQUIRE(MeshOptimizer::WeldVertices(Verts, Indices) == 17 * 17);
+		REQUIRE(Verts.size() == 17 * 17);
+		REQUIRE(GetTriangles(Verts, Indices) == SourceTriangles);
+
+		// Vertices on a hard edge have different normals and must stay split
+		std::vector<Vertex> Edge(2);
+		Edge[1].Normal = glm::vec3(0.0f, 1.0f, 0.0f);
+		std::vector<UINT32> EdgeIndices = { 0, 1 };
+		REQUIRE(MeshOptimizer::WeldVertices(Edge, EdgeIndices) == 2);
+	}
+
+	SECTION("Vertex cache order")
+	{
+		MeshOptimizer::WeldVertices(Verts, Indices);
+		const UINT32 VertCount = static_cast<UINT32>(Verts.size());
+		const UINT32 IndexCount = static_cast<UINT32>(Indices.size());
+
+		// Welded meshes reuse vertices from the cache
+		REQUIRE(MeshOptimizer::CalculateACMR(Indices.data(), IndexCount, VertCount) < 3.0f);
+
+		// Shuffle the triangles to get a bad order to start from
+		std::vector<UINT32> Order(IndexCount / 3);
+		std::iota(Order.begin(), Order.end(), 0);
+		std::shuffle(Order.begin(), Order.end(), std::mt19937(42));
+		std::vector<UINT32> Shuffled;
+		for (UINT32 Tri : Order)
+		{
+			Shuffled.insert(Shuffled.end(), Indices.begin() + Tri * 3, Indices.begin() + Tri * 3 + 3);
+		}
+		const float Before = MeshOptimizer::CalculateACMR(Shuffled.data(), IndexCount, VertCount);
+
+		MeshOptimizer::OptimizeVertexCache(Shuffled.data(), IndexCount, VertCount);
+		const float After = MeshOptimizer::CalculateACMR(Shuffled.data(), IndexCount, VertCount);
+		INFO("ACMR before " << Before << " after " << After);
+		REQUIRE(After < Before);
+		REQUIRE(After < 1.0f);
+		REQUIRE(GetTriangles(Verts, Shuffled) == SourceTriangles);
+	}
+
+	SECTION("Vertex fetch order")
+	{
+		MeshOptimizer::WeldVertices(Verts, Indices);
+		std::reverse(Indices.begin(), Indices.end());
+
+		// Add a vertex that nothing uses
+		Verts.push_back(Vertex {});
+		REQUIRE(MeshOptimizer::OptimizeVertexFetch(Verts, Indices) == 17 * 17);
+
+		UINT32 NextNew = 0;
+		for (UINT32 Index : Indices)
+		{
+			REQUIRE(Index <= NextNew);
+			NextNew = std::max(NextNew, Index + 1);
+		}
+	}
+
+	SECTION("Whole pipeline")
+	{
+		MeshOptimizeStats Stats = {};
+		MeshOptimizer::Optimize(Verts, Indices, &Stats);
+		REQUIRE(Stats.SourceVertexCount == 16 * 16 * 6);
+		REQUIRE(Stats.VertexCount == 17 * 17);
+		REQUIRE(Stats.IndexCount == Indices.size());
+		REQUIRE(Stats.ACMRAfter <= Stats.ACMRBefore);
+		REQUIRE(GetTriangles(Verts, Indices) == SourceTriangles);
+
+		REQUIRE(MeshOptimizer::CanUse16BitIndices(Stats.VertexCount));
+		REQUIRE(MeshOptimizer::CanUse16BitIndices(0x10000));
+		REQUIRE_FALSE(MeshOptimizer::CanUse16BitIndices(0x10001));
+	}
+}
+
+TEST_CASE("Vertex quantization", "[Renderer]")
+{
+	using namespace Fling;
+
+	std::mt19937 Rng(7);
+	std::uniform_real_distribution<float> Dist(-1.0f, 1.0f);
+	auto RandomDir = [&]()
+	{
+		glm::vec3 Dir(0.0f);
+		while (glm::dot(Dir, Dir) < 1e-4f)
+		{
+			Dir = glm::vec3(Dist(Rng), Dist(Rng), Dist(Rng));
+		}
+		return glm::normalize(Dir);
+	};
+
+	SECTION("Half floats")
+	{
+		// Exactly representable values survive
+		for (float Value : { 0.0f, 1.0f, -2.5f, 0.5f, 1024.0f, 65504.0f, -65504.0f, 6.103515625e-05f, 5.9604644775390625e-08f })
+		{
+			INFO(Value);
+			REQUIRE(VertexQuantization::HalfToFloat(VertexQuantization::FloatToHalf(Value)) == Value);
+		}
+		REQUIRE(VertexQuantization::FloatToHalf(1.0f) == 0x3C00);
+		REQUIRE(VertexQuantization::FloatToHalf(-0.0f) == 0x8000);
+
+		// Everything else rounds to the nearest half, which is within half a unit in the last place
+		for (UINT32 i = 0; i < 10000; ++i)
+		{
+			const float Value = Dist(Rng) * 100.0f;
+			const float RoundTrip = VertexQuantization::HalfToFloat(VertexQuantization::FloatToHalf(Value));
+			INFO(Value << " -> " << RoundTrip);
+			REQUIRE(std::abs(RoundTrip - Value) <= std::abs(Value) * (1.0f / 2048.0f) + 3e-8f);
+		}
+
+		// Ties go to even and large values overflow to infinity
+		REQUIRE(VertexQuantization::FloatToHalf(1.0f + 1.0f / 2048.0f) == 0x3C00);
+		REQUIRE(VertexQuantization::FloatToHalf(1.0f + 3.0f / 2048.0f) == 0x3C02);
+		REQUIRE(VertexQuantization::FloatToHalf(65520.0f) == 0x7C00);
+		REQUIRE(std::isinf(VertexQuantization::HalfToFloat(VertexQuantization::FloatToHalf(-1e10f))));
+		REQUIRE(std::isnan(VertexQuantization::HalfToFloat(VertexQuantization::FloatToHalf(std::nanf("")))));
+	}
+
+	SECTION("Octahedral directions")
+	{
+		// Axes land on the corners and edges of the octahedron exactly
+		for (const glm::vec3& Axis : { glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1) })
+		{
+			INT16 Oct[2] = {};
+			VertexQuantization::EncodeOctahedral(Axis, Oct);
+			REQUIRE(VertexQuantization::DecodeOctahedral(Oct) == Axis);
+		}
+
+		// 32 bits is well under a hundredth of a degree of error. The chord between the directions
+		// is the angle in radians at this size, and doesn't lose precision like acos does near 1
+		float MaxError = 0.0f;
+		for (UINT32 i = 0; i < 10000; ++i)
+		{
+			const glm::vec3 Dir = RandomDir();
+			INT16 Oct[2] = {};
+			VertexQuantization::EncodeOctahedral(Dir, Oct);
+			const glm::vec3 Decoded = VertexQuantization::DecodeOctahedral(Oct);
+			REQUIRE(std::abs(glm::length(Decoded) - 1.0f) < 1e-5f);
+			MaxError = std::max(MaxError, glm::length(Decoded - Dir));
+		}
+		INFO("Largest error " << glm::degrees(MaxError) << " degrees");
+		REQUIRE(MaxError < glm::radians(0.01f));
+	}
+
+	SECTION("Vertices")
+	{
+		std::vector<Vertex> Verts(1000);
+		for (Vertex& Vert : Verts)
+		{
+			Vert.Pos = glm::vec3(Dist(Rng) * 10.0f, Dist(Rng) * 0.5f, 3.0f);
+			Vert.Color = glm::vec3(1.0f);
+			Vert.Normal = RandomDir();
+			Vert.Tangent = RandomDir();
+			Vert.TexCoord = glm::vec2(Dist(Rng) + 1.0f, Dist(Rng) * 4.0f);
+		}
+		REQUIRE(VertexQuantization::CanPack(Verts));
+
+		const BoundingBox Bounds = MeshImporter::CalculateBounds(Verts);
+		const VertexDequantize Dequantize = VertexQuantization::GetDequantize(Bounds);
+
+		std::vector<PackedVertex> Packed;
+		VertexQuantization::PackVertices(Verts, Dequantize, Packed);
+		REQUIRE(Packed.size() == Verts.size());
+
+		// Positions are within half a step of the bounds on each axis, the flat z axis is exact
+		const glm::vec3 MaxPosError = (Bounds.Max - Bounds.Min) * (0.5f / 65535.0f) + glm::vec3(1e-5f);
+		for (size_t i = 0; i < Verts.size(); ++i)
+		{
+			const Vertex Unpacked = VertexQuantization::Unpack(Packed[i], Dequantize);
+			REQUIRE(glm::all(glm::lessThanEqual(glm::abs(Unpacked.Pos - Verts[i].Pos), MaxPosError)));
+			REQUIRE(Unpacked.Pos.z == 3.0f);
+			REQUIRE(Unpacked.Color == glm::vec3(1.0f));
+			REQUIRE(glm::dot(Unpacked.Normal, Verts[i].Normal) > 0.99999f);
+			REQUIRE(glm::dot(Unpacked.Tangent, Verts[i].Tangent) > 0.99999f);
+			REQUIRE(glm::all(glm::lessThanEqual(glm::abs(Unpacked.TexCoord - Verts[i].TexCoord), glm::abs(Verts[i].TexCoord) * (1.0f / 2048.0f) + glm::vec2(3e-8f))));
+		}
+
+		// The corners of the bounds are exact
+		REQUIRE(VertexQuantization::Unpack(VertexQuantization::Pack(Vertex { Bounds.Min }, Dequantize), Dequantize).Pos == Bounds.Min);
+
+		// Any vertex color means the mesh needs full vertices
+		Verts[500].Color = glm::vec3(1.0f, 0.0f, 0.0f);
+		REQUIRE_FALSE(VertexQuantization::CanPack(Verts));
+	}
+
+	SECTION("Cooked packed meshes")
+	{
+		const std::string CookedPath = (std::filesystem::temp_directory_path() / "FlingTestPackedMesh.flmesh").string();
+
+		std::vector<Vertex> Verts(3);
+		Verts[0].Pos = { 0.0f, 0.0f, 0.0f };
+		Verts[1].Pos = { 1.0f, 0.0f, 0.0f };
+		Verts[2].Pos = { 0.0f, 2.0f, -1.0f };
+		for (Vertex& Vert : Verts)
+		{
+			Vert.Color = glm::vec3(1.0f);
+			Vert.Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+			Vert.Tangent = glm::vec3(1.0f, 0.0f, 0.0f);
+		}
+		std::vector<UINT32> Indices = { 0, 1, 2 };
+		const BoundingBox Bounds = MeshImporter::CalculateBounds(Verts);
+
+		REQUIRE(MeshFile::Write(CookedPath, Verts, Indices, Bounds, VertexFormat::Packed));
+
+		MeshFile File;
+		REQUIRE(File.Open(CookedPath));
+		REQUIRE(File.GetVertexFormat() == VertexFormat::Packed);
+		REQUIRE(File.GetVertexCount() == 3);
+
+		const PackedVertex* FileVerts = static_cast<const PackedVertex*>(File.GetVertexData());
+		const VertexDequantize Dequantize = VertexQuantization::GetDequantize(File.GetBounds());
+		for (size_t i = 0; i < Verts.size(); ++i)
+		{
+			REQUIRE(VertexQuantization::Unpack(FileVerts[i], Dequantize) == Verts[i]);
+		}
+
+		File.Close();
+		std::filesystem::remove(CookedPath);
+	}
+}
+
+TEST_CASE("Mesh import Assets/Models", "[Renderer][.benchmark]")
+{
+	using namespace Fling;
+	using Clock = std::chrono::high_resolution_clock;
+	Logger::Get().Init();
+
+	for (const auto& Entry : std::filesystem::directory_iterator(FlingPaths::EngineAssetsDir() + "/Models"))
+	{
+		if (Entry.path().extension() != ".obj")
+		{
+			continue;
+		}
+
+		std::vector<Vertex> Verts;
+		std::vector<UINT32> Indices;
+		auto Start = Clock::now();
+		REQUIRE(MeshImporter::LoadObj(Entry.path().string(), Verts, Indices));
+		const double LoadMs = std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+
+		MeshOptimizeStats Stats = {};
+		Start = Clock::now();
+		MeshOptimizer::Optimize(Verts, Indices, &Stats);
+		const double OptimizeMs = std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+
+		std::cout << "[Benchmark] " << Entry.path().filename().string()
+			<< ": " << Stats.SourceVertexCount << " -> " << Stats.VertexCount << " vertices"
+			<< ", ACMR " << Stats.ACMRBefore << " -> " << Stats.ACMRAfter
+			<< ", parse " << LoadMs << " ms, optimize " << OptimizeMs << " ms" << std::endl;
+
+		REQUIRE(Stats.VertexCount <= Stats.SourceVertexCount);
+	}
+}
+
+namespace
+{
+	/** Unwelded cube around the origin with outward winding and no normals */
+	void BuildCubeWithoutNormals(std::vector<Fling::Vertex>& t_OutVerts, std::vector<UINT32>& t_OutIndices)
+	{
+		using namespace Fling;
+		for (UINT32 Axis = 0; Axis < 3; ++Axis)
+		{
+			for (float Side : { -1.0f, 1.0f })
+			{
+				glm::vec3 Quad[4];
+				for (UINT32 i = 0; i < 4; ++i)
+				{
+					Quad[i][Axis] = Side;
+					Quad[i][(Axis + 1) % 3] = (i == 1 || i == 2) ? 1.0f : -1.0f;
+					Quad[i][(Axis + 2) % 3] = (i >= 2) ? 1.0f : -1.0f;
+				}
+				if (glm::dot(glm::cross(Quad[1] - Quad[0], Quad[2] - Quad[0]), Quad[0]) < 0.0f)
+				{
+					std::swap(Quad[1], Quad[3]);
+				}
+
+				for (UINT32 Corner : { 0u, 1u, 2u, 0u, 2u, 3u })
+				{
+					Vertex Vert = {};
+					Vert.Pos = Quad[Corner];
+					t_OutIndices.push_back(static_cast<UINT32>(t_OutVerts.size()));
+					t_OutVerts.push_back(Vert);
+				}
+			}
+		}
+	}
+}
+
+TEST_CASE("Tangent generation", "[Renderer]")
+{
+	using namespace Fling;
+	Logger::Get().Init();
+
+	SECTION("Tangents follow U and are orthogonal to the normal")
+	{
+		std::vector<Vertex> Verts;
+		std::vector<UINT32> Indices;
+		BuildUnweldedGrid(8, Verts, Indices);
+		MeshOptimizer::WeldVertices(Verts, Indices);
+		MeshImporter::CalculateVertexTangents(Verts.data(), static_cast<UINT32>(Verts.size()), Indices.data(), static_cast<UINT32>(Indices.size()));
+
+		for (const Vertex& Vert : Verts)
+		{
+			REQUIRE(Vert.Tangent.x == Approx(1.0f));
+			REQUIRE(Vert.Tangent.y == Approx(0.0f).margin(1e-6f));
+			REQUIRE(glm::dot(Vert.Tangent, Vert.Normal) == Approx(0.0f).margin(1e-6f));
+		}
+	}
+
+	SECTION("Same result on any number of threads")
+	{
+		std::vector<Vertex> Source;
+		std::vector<UINT32> Indices;
+		BuildUnweldedGrid(128, Source, Indices);
+
+		// Bend the grid so that every vertex has a different normal and tangent
+		for (Vertex& Vert : Source)
+		{
+			Vert.Pos.z = std::sin(Vert.Pos.x * 0.3f) * std::cos(Vert.Pos.y * 0.2f) * 4.0f;
+			Vert.Normal = glm::vec3(0.0f);
+		}
+		MeshOptimizer::WeldVertices(Source, Indices);
+
+		auto Generate = [&]()
+		{
+			std::vector<Vertex> Verts = Source;
+			MeshImporter::CalculateSmoothNormals(Verts.data(), static_cast<UINT32>(Verts.size()), Indices.data(), static_cast<UINT32>(Indices.size()));
+			MeshImporter::CalculateVertexTangents(Verts.data(), static_cast<UINT32>(Verts.size()), Indices.data(), static_cast<UINT32>(Indices.size()));
+			return Verts;
+		};
+
+		const std::vector<Vertex> Serial = Generate();
+		for (UINT32 ThreadCount : { 1u, 4u })
+		{
+			JobSystem::Get().Init(ThreadCount);
+			const std::vector<Vertex> Parallel = Generate();
+			JobSystem::Get().Shutdown();
+
+			REQUIRE(std::memcmp(Serial.data(), Parallel.data(), sizeof(Vertex) * Serial.size()) == 0);
+		}
+	}
+
+	SECTION("Smooth normals of a cube point along the diagonals")
+	{
+		std::vector<Vertex> Verts;
+		std::vector<UINT32> Indices;
+		BuildCubeWithoutNormals(Verts, Indices);
+		MeshImporter::CalculateSmoothNormals(Verts.data(), static_cast<UINT32>(Verts.size()), Indices.data(), static_cast<UINT32>(Indices.size()));
+
+		for (const Vertex& Vert : Verts)
+		{
+			const glm::vec3 Diagonal = glm::normalize(Vert.Pos);
+			REQUIRE(glm::dot(Vert.Normal, Diagonal) == Approx(1.0f));
+		}
+
+		// Normals that are already there are kept
+		Verts[0].Normal = glm::vec3(0.0f, 1.0f, 0.0f);
+		MeshImporter::CalculateSmoothNormals(Verts.data(), static_cast<UINT32>(Verts.size()), Indices.data(), static_cast<UINT32>(Indices.size()));
+		REQUIRE(Verts[0].Normal == glm::vec3(0.0f, 1.0f, 0.0f));
+	}
+
+	SECTION("Obj files without normals or UVs")
+	{
+		const std::string ObjPath = (std::filesystem::temp_directory_path() / "FlingTestNoNormals.obj").string();
+		{
+			std::ofstream Obj(ObjPath, std::ios::trunc);
+			Obj << "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nf 1 2 3\nf 1 3 4\n";
+		}
+
+		std::vector<Vertex> Verts;
+		std::vector<UINT32> Indices;
+		REQUIRE(MeshImporter::Import(ObjPath, Verts, Indices));
+		REQUIRE(Verts.size() == 4);
+		for (const Vertex& Vert : Verts)
+		{
+			REQUIRE(Vert.Normal == glm::vec3(0.0f, 0.0f, 1.0f));
+			REQUIRE(glm::length(Vert.Tangent) == Approx(1.0f));
+			REQUIRE(glm::dot(Vert.Tangent, Vert.Normal) == Approx(0.0f).margin(1e-6f));
+		}
+
+		std::filesystem::remove(ObjPath);
+	}
+}
+
+TEST_CASE("Tangent generation Assets/Models", "[Renderer][.benchmark]")
+{
+	using namespace Fling;
+	using Clock = std::chrono::high_resolution_clock;
+	Logger::Get().Init();
+
+	for (const auto& Entry : std::filesystem::directory_iterator(FlingPaths::EngineAssetsDir() + "/Models"))
+	{
+		if (Entry.path().extension() != ".obj")
+		{
+			continue;
+		}
+
+		std::vector<Vertex> Verts;
+		std::vector<UINT32> Indices;
+		REQUIRE(MeshImporter::LoadObj(Entry.path().string(), Verts, Indices));
+		MeshOptimizer::Optimize(Verts, Indices);
+
+		const UINT32 VertCount = static_cast<UINT32>(Verts.size());
+		const UINT32 IndexCount = static_cast<UINT32>(Indices.size());
+
+		// Without the job system the whole mesh is done on this thread
+		auto Start = Clock::now();
+		MeshImporter::CalculateVertexTangents(Verts.data(), VertCount, Indices.data(), IndexCount);
+		const double SerialMs = std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+
+		JobSystem::Get().Init();
+		Start = Clock::now();
+		MeshImporter::CalculateVertexTangents(Verts.data(), VertCount, Indices.data(), IndexCount);
+		const double ParallelMs = std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+		const UINT32 ThreadCount = JobSystem::Get().GetThreadCount();
+		JobSystem::Get().Shutdown();
+
+		std::cout << "[Benchmark] " << Entry.path().filename().string()
+			<< ": " << Indices.size() / 3 << " triangles, tangents " << SerialMs << " ms on 1 thread, "
+			<< ParallelMs << " ms on " << ThreadCount << " threads" << std::endl;
+	}
+}
+
+namespace
+{
+	/** Smooth gradients with some noise and a hard edge through the middle, like a typical albedo */
+	Fling::TextureMip BuildTestImage(UINT32 t_Width, UINT32 t_Height)
+	{
+		Fling::TextureMip Image;
+		Image.Width = t_Width;
+		Image.Height = t_Height;
+		Image.Pixels.resize(static_cast<size_t>(t_Width) * t_Height * 4);
+
+		std::mt19937 Rng(3);
+		std::uniform_int_distribution<INT32> Noise(-4, 4);
+		for (UINT32 y = 0; y < t_Height; ++y)
+		{
+			for (UINT32 x = 0; x < t_Width; ++x)
+			{
+				const float U = static_cast<float>(x) / t_Width;
+				const float V = static_cast<float>(y) / t_Height;
+				const float Edge = x > t_Width / 2 ? 60.0f : 0.0f;
+				const float Channels[4] = { 40.0f + 150.0f * U + Edge, 90.0f + 100.0f * V, 200.0f - 120.0f * U * V, 255.0f - 80.0f * V };
+				for (UINT32 c = 0; c < 4; ++c)
+				{
+					Image.Pixels[(static_cast<size_t>(y) * t_Width + x) * 4 + c] = static_cast<UINT8>(glm::clamp(Channels[c] + Noise(Rng), 0.0f, 255.0f));
+				}
+			}
+		}
+		return Image;
+	}
+
+	double RoundTripPSNR(Fling::BlockFormat t_Format, const Fling::TextureMip& t_Image)
+	{
+		using namespace Fling;
+		std::vector<UINT8> Blocks;
+		std::vector<UINT8> Decoded;
+		BlockCompression::CompressImage(t_Format, t_Image.Pixels.data(), t_Image.Width, t_Image.Height, Blocks);
+		BlockCompression::DecompressImage(t_Format, Blocks.data(), t_Image.Width, t_Image.Height, Decoded);
+		return BlockCompression::ComputePSNR(t_Image.Pixels.data(), Decoded.data(), t_Image.Width * t_Image.Height, BlockCompression::GetChannelCount(t_Format));
+	}
+}
+
+TEST_CASE("Block compression", "[Renderer]")
+{
+	using namespace Fling;
+	Logger::Get().Init();
+
+	const TextureMip Image = BuildTestImage(64, 64);
+
+	SECTION("Quality")
+	{
+		REQUIRE(RoundTripPSNR(BlockFormat::BC1, Image) > 36.0);
+		REQUIRE(RoundTripPSNR(BlockFormat::BC3, Image) > 36.0);
+		REQUIRE(RoundTripPSNR(BlockFormat::BC4, Image) > 42.0);
+		REQUIRE(RoundTripPSNR(BlockFormat::BC5, Image) > 42.0);
+		REQUIRE(RoundTripPSNR(BlockFormat::BC7, Image) > 40.0);
+	}
+
+	SECTION("Solid blocks")
+	{
+		// A color that every format can hit exactly: it fits in 565 and every channel is odd, so BC7 can share a low bit
+		UINT8 Pixels[64];
+		for (UINT32 i = 0; i < 16; ++i)
+		{
+			Pixels[i * 4 + 0] = 189;
+			Pixels[i * 4 + 1] = 81;
+			Pixels[i * 4 + 2] = 41;
+			Pixels[i * 4 + 3] = 255;
+		}
+
+		for (BlockFormat Format : { BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC4, BlockFormat::BC5, BlockFormat::BC7 })
+		{
+			UINT8 Block[16] = {};
+			UINT8 Decoded[64] = {};
+			BlockCompression::EncodeBlock(Format, Pixels, Block);
+			BlockCompression::DecodeBlock(Format, Block, Decoded);
+			REQUIRE(std::isinf(BlockCompression::ComputePSNR(Pixels, Decoded, 16, BlockCompression::GetChannelCount(Format))));
+		}
+	}
+
+	SECTION("Partial blocks at the edges")
+	{
+		const TextureMip Small = BuildTestImage(6, 5);
+		REQUIRE(BlockCompression::GetCompressedSize(BlockFormat::BC7, 6, 5) == 4 * 16);
+		REQUIRE(BlockCompression::GetCompressedSize(BlockFormat::BC4, 1, 1) == 8);
+		// Most of this image is the block with the hard edge in it, which a single BC7 subset can't follow
+		REQUIRE(RoundTripPSNR(BlockFormat::BC7, Small) > 25.0);
+		REQUIRE(RoundTripPSNR(BlockFormat::BC4, Small) > 40.0);
+	}
+
+	SECTION("Same blocks on any number of threads")
+	{
+		std::vector<UINT8> Serial;
+		BlockCompression::CompressImage(BlockFormat::BC7, Image.Pixels.data(), Image.Width, Image.Height, Serial);
+
+		JobSystem::Get().Init(4);
+		std::vector<UINT8> Parallel;
+		BlockCompression::CompressImage(BlockFormat::BC7, Image.Pixels.data(), Image.Width, Image.Height, Parallel);
+		JobSystem::Get().Shutdown();
+
+		REQUIRE(Serial == Parallel);
+	}
+
+	SECTION("Mip chains")
+	{
+		std::vector<TextureMip> Mips;
+		TextureImporter::GenerateMips(BuildTestImage(8, 4), TextureUsage::Color, Mips);
+		REQUIRE(Mips.size() == 4);
+		REQUIRE(Mips[1].Width == 4);
+		REQUIRE(Mips[1].Height == 2);
+		REQUIRE(Mips[3].Width == 1);
+		REQUIRE(Mips[3].Height == 1);
+
+		// Two normals leaning opposite ways average out to straight up, not to a short vector
+		TextureMip Normals;
+		Normals.Width = 2;
+		Normals.Height = 1;
+		Normals.Pixels = { 218, 128, 218, 255, 38, 128, 218, 255 };
+		TextureImporter::GenerateMips(Normals, TextureUsage::Normal, Mips);
+		REQUIRE(Mips.size() == 2);
+		REQUIRE(Mips[1].Pixels[0] == 128);
+		REQUIRE(Mips[1].Pixels[2] == 255);
+	}
+
+	SECTION("Block formats of each usage")
+	{
+		REQUIRE(TextureImporter::SelectBlockFormat(TextureUsage::Color, Image, false) == BlockFormat::BC7);
+		REQUIRE(TextureImporter::SelectBlockFormat(TextureUsage::Color, Image, true) == BlockFormat::BC3);
+		REQUIRE(TextureImporter::SelectBlockFormat(TextureUsage::Normal, Image, false) == BlockFormat::BC5);
+		REQUIRE(TextureImporter::SelectBlockFormat(TextureUsage::Mask, Image, false) == BlockFormat::BC4);
+
+		TextureMip Opaque = Image;
+		for (size_t i = 3; i < Opaque.Pixels.size(); i += 4)
+		{
+			Opaque.Pixels[i] = 255;
+		}
+		REQUIRE(TextureImporter::SelectBlockFormat(TextureUsage::Color, Opaque, true) == BlockFormat::BC1);
+	}
+
+	SECTION("Cooked texture files")
+	{
+		const std::string CookedPath = (std::filesystem::temp_directory_path() / "FlingTestTexture.fltex").string();
+
+		std::vector<TextureMip> Mips;
+		TextureImporter::GenerateMips(BuildTestImage(20, 12), TextureUsage::Color, Mips);
+		std::vector<std::vector<UINT8>> Levels(Mips.size());
+		for (size_t i = 0; i < Mips.size(); ++i)
+		{
+			BlockCompression::CompressImage(BlockFormat::BC7, Mips[i].Pixels.data(), Mips[i].Width, Mips[i].Height, Levels[i]);
+		}
+		REQUIRE(TextureFile::Write(CookedPath, BlockFormat::BC7, 20, 12, Levels));
+
+		{
+			TextureFile File;
+			REQUIRE(File.Open(CookedPath));
+			REQUIRE(File.GetWidth() == 20);
+			REQUIRE(File.GetHeight() == 12);
+			REQUIRE(File.GetMipCount() == 5);
+			REQUIRE(File.GetVkFormat() == VK_FORMAT_BC7_UNORM_BLOCK);
+			for (UINT32 i = 0; i < File.GetMipCount(); ++i)
+			{
+				REQUIRE(File.GetLevel(i).Offset % TextureFile::DataAlignment == 0);
+				REQUIRE(std::memcmp(File.GetLevelData(i), Levels[i].data(), Levels[i].size()) == 0);
+			}
+			REQUIRE(File.GetData() + File.GetDataSize() == File.GetLevelData(4) + Levels[4].size());
+		}
+
+		// Cut off the smallest mip
+		std::filesystem::resize_file(CookedPath, std::filesystem::file_size(CookedPath) - 1);
+		TextureFile Truncated;
+		REQUIRE_FALSE(Truncated.Open(CookedPath));
+
+		std::filesystem::remove(CookedPath);
+	}
+}
+
+TEST_CASE("Block compression Assets/Textures", "[Renderer][.benchmark]")
+{
+	using namespace Fling;
+	using Clock = std::chrono::high_resolution_clock;
+	Logger::Get().Init();
+	JobSystem::Get().Init();
+
+	for (const auto& Entry : std::filesystem::recursive_directory_iterator(FlingPaths::EngineAssetsDir() + "/Textures"))
+	{
+		if (Entry.path().extension() != ".png")
+		{
+			continue;
+		}
+
+		int Width = 0;
+		int Height = 0;
+		int Channels = 0;
+		stbi_uc* Pixels = stbi_load(Entry.path().string().c_str(), &Width, &Height, &Channels, STBI_rgb_alpha);
+		REQUIRE(Pixels);
+
+		TextureMip Image;
+		Image.Width = static_cast<UINT32>(Width);
+		Image.Height = static_cast<UINT32>(Height);
+		Image.Pixels.assign(Pixels, Pixels + static_cast<size_t>(Width) * Height * 4);
+		stbi_image_free(Pixels);
+
+		std::cout << "[Benchmark] " << Entry.path().filename().string() << " " << Width << "x" << Height;
+		for (BlockFormat Format : { BlockFormat::BC1, BlockFormat::BC4, BlockFormat::BC5, BlockFormat::BC7 })
+		{
+			const auto Start = Clock::now();
+			const double PSNR = RoundTripPSNR(Format, Image);
+			const double Ms = std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+			std::cout << ", " << BlockCompression::GetFormatName(Format) << " " << PSNR << " dB " << Ms << " ms";
+		}
+		std::cout << " on " << JobSystem::Get().GetThreadCount() << " threads" << std::endl;
+	}
+
+	JobSystem::Get().Shutdown();
+}
+
+namespace
+{
+	VkPhysicalDeviceProperties BuildTestDeviceProps()
+	{
+		VkPhysicalDeviceProperties Props = {};
+		Props.vendorID = 0x10DE;
+		Props.deviceID = 0x1B80;
+		Props.driverVersion = 0x1A2B3C4D;
+		for (UINT8 i = 0; i < VK_UUID_SIZE; ++i)
+		{
+			Props.pipelineCacheUUID[i] = static_cast<UINT8>(i * 17 + 3);
+		}
+		return Props;
+	}
+
+	/** Cache data the way a driver would return it, a VkPipelineCacheHeaderVersionOne and then its own blob */
+	std::vector<UINT8> BuildDriverCacheData(const VkPhysicalDeviceProperties& t_Props, size_t t_BlobSize)
+	{
+		const UINT32 Header[4] = { 32, VK_PIPELINE_CACHE_HEADER_VERSION_ONE, t_Props.vendorID, t_Props.deviceID };
+
+		std::vector<UINT8> Data(32 + t_BlobSize);
+		std::memcpy(Data.data(), Header, sizeof(Header));
+		std::memcpy(Data.data() + sizeof(Header), t_Props.pipelineCacheUUID, VK_UUID_SIZE);
+		for (size_t i = 32; i < Data.size(); ++i)
+		{
+			Data[i] = static_cast<UINT8>(i * 31);
+		}
+		return Data;
+	}
+}
+
+TEST_CASE("Pipeline cache files", "[Renderer]")
+{
+	using namespace Fling;
+
+	const VkPhysicalDeviceProperties Props = BuildTestDeviceProps();
+	const std::vector<UINT8> CacheData = BuildDriverCacheData(Props, 1000);
+
+	std::vector<UINT8> File;
+	PipelineCacheManager::Serialize(Props, CacheData, 123456, File);
+	REQUIRE(File.size() == sizeof(PipelineCacheFileHeader) + CacheData.size());
+
+	SECTION("Round trip")
+	{
+		const PipelineCacheFileHeader* Header = nullptr;
+		const UINT8* Data = PipelineCacheManager::Validate(File.data(), File.size(), Props, &Header);
+		REQUIRE(Data);
+		REQUIRE(Header);
+		REQUIRE(Header->DataSize == CacheData.size());
+		REQUIRE(Header->ColdCreationMicroseconds == 123456);
+		REQUIRE(std::memcmp(Data, CacheData.data(), CacheData.size()) == 0);
+	}
+
+	SECTION("Other drivers and devices are rejected")
+	{
+		VkPhysicalDeviceProperties Other = Props;
+		Other.driverVersion += 1;
+		REQUIRE_FALSE(PipelineCacheManager::Validate(File.data(), File.size(), Other));
+
+		Other = Props;
+		Other.pipelineCacheUUID[7] ^= 0xFF;
+		REQUIRE_FALSE(PipelineCacheManager::Validate(File.data(), File.size(), Other));
+
+		Other = Props;
+		Other.deviceID += 1;
+		REQUIRE_FALSE(PipelineCacheManager::Validate(File.data(), File.size(), Other));
+	}
+
+	SECTION("Driver header has to match the device")
+	{
+		// Our header is right but the data inside of it came from another GPU
+		VkPhysicalDeviceProperties Other = Props;
+		Other.vendorID = 0x1002;
+		PipelineCacheManager::Serialize(Props, BuildDriverCacheData(Other, 1000), 0, File);
+		REQUIRE_FALSE(PipelineCacheManager::Validate(File.data(), File.size(), Props));
+	}
+
+	SECTION("Corrupt and truncated files are rejected")
+	{
+		std::vector<UINT8> Corrupt = File;
+		Corrupt[sizeof(PipelineCacheFileHeader) + 500] ^= 0x01;
+		REQUIRE_FALSE(PipelineCacheManager::Validate(Corrupt.data(), Corrupt.size(), Props));
+
+		REQUIRE_FALSE(PipelineCacheManager::Validate(File.data(), File.size() - 1, Props));
+		REQUIRE_FALSE(PipelineCacheManager::Validate(File.data(), sizeof(PipelineCacheFileHeader) - 1, Props));
+		REQUIRE_FALSE(PipelineCacheManager::Validate(nullptr, 0, Props));
+	}
+
+	SECTION("Empty cache data is not written as a warm cache")
+	{
+		PipelineCacheManager::Serialize(Props, {}, 0, File);
+		REQUIRE_FALSE(PipelineCacheManager::Validate(File.data(), File.size(), Props));
+	}
+}
+
+namespace
+{
+	std::vector<UINT32> LoadSpirv(const std::string& t_Path)
+	{
+		std::ifstream File(t_Path, std::ios::binary | std::ios::ate);
+		std::vector<UINT32> Code;
+		if (File.is_open())
+		{
+			Code.resize(static_cast<size_t>(File.tellg()) / sizeof(UINT32));
+			File.seekg(0);
+			File.read(reinterpret_cast<char*>(Code.data()), static_cast<std::streamsize>(Code.size() * sizeof(UINT32)));
+		}
+		return Code;
+	}
+
+	Fling::ShaderReflection ReflectAsset(const std::string& t_Path)
+	{
+		const std::vector<UINT32> Code = LoadSpirv(Fling::FlingPaths::EngineAssetsDir() + "/Shaders/" + t_Path);
+		REQUIRE_FALSE(Code.empty());
+
+		Fling::ShaderReflection Reflection;
+		REQUIRE(Fling::ShaderReflection::Parse(Code.data(), Code.size(), Reflection));
+		return Reflection;
+	}
+}
+
+TEST_CASE("Shader reflection", "[Renderer]")
+{
+	using namespace Fling;
+
+	SECTION("Descriptor types, sizes and names")
+	{
+		const ShaderReflection Deferred = ReflectAsset("Deferred/deferred_frag.spv");
+		REQUIRE(Deferred.Stage == VK_SHADER_STAGE_FRAGMENT_BIT);
+		REQUIRE(Deferred.GetSetCount() == 1);
+		REQUIRE(Deferred.Bindings.size() == 7);
+		REQUIRE(Deferred.PushConstantSize == 0);
+
+		for (size_t i = 0; i < Deferred.Bindings.size(); ++i)
+		{
+			REQUIRE(Deferred.Bindings[i].Binding == i + 1);
+		}
+
+		const ShaderBinding* Position = Deferred.FindBinding("samplerposition");
+		REQUIRE(Position);
+		REQUIRE(Position->Binding == 1);
+		REQUIRE(Position->Type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+		REQUIRE(Position->Count == 1);
+
+		// 2 counts, 8 directional lights and 128 point lights, see GeometrySubpass.h
+		const ShaderBinding* Lights = Deferred.FindBinding("lights");
+		REQUIRE(Lights);
+		REQUIRE(Lights->Binding == 6);
+		REQUIRE(Lights->Type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+		REQUIRE(Lights->Size == 6544);
+
+		const ShaderBinding* Camera = Deferred.FindBinding("ubo");
+		REQUIRE(Camera);
+		REQUIRE(Camera->Binding == 7);
+		REQUIRE(Camera->Size == 152);
+
+		REQUIRE_FALSE(Deferred.FindBinding("samplerMissing"));
+	}
+
+	SECTION("Push constants and vertex inputs")
+	{
+		const ShaderReflection UI = ReflectAsset("imgui/ui.vert.spv");
+		REQUIRE(UI.Stage == VK_SHADER_STAGE_VERTEX_BIT);
+		REQUIRE(UI.PushConstantOffset == 0);
+		REQUIRE(UI.PushConstantSize == 16);
+		REQUIRE(UI.Bindings.empty());
+
+		REQUIRE(UI.VertexInputs.size() == 3);
+		REQUIRE(UI.VertexInputs[0].Location == 0);
+		REQUIRE(UI.VertexInputs[0].Format == VK_FORMAT_R32G32_SFLOAT);
+		REQUIRE(UI.VertexInputs[1].Format == VK_FORMAT_R32G32_SFLOAT);
+		REQUIRE(UI.VertexInputs[2].Location == 2);
+		REQUIRE(UI.VertexInputs[2].Format == VK_FORMAT_R32G32B32A32_SFLOAT);
+
+		std::vector<VkPushConstantRange> Ranges;
+		ShaderReflection::GetPushConstantRanges({ &UI }, Ranges);
+		REQUIRE(Ranges.size() == 1);
+		REQUIRE(Ranges[0].stageFlags == VK_SHADER_STAGE_VERTEX_BIT);
+		REQUIRE(Ranges[0].offset == 0);
+		REQUIRE(Ranges[0].size == 16);
+
+		// Stages that use a different part of the block still share one range
+		ShaderReflection Frag;
+		Frag.Stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+		Frag.PushConstantOffset = 16;
+		Frag.PushConstantSize = 32;
+		ShaderReflection::GetPushConstantRanges({ &UI, &Frag }, Ranges);
+		REQUIRE(Ranges.size() == 1);
+		REQUIRE(Ranges[0].stageFlags == (VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT));
+		REQUIRE(Ranges[0].offset == 0);
+		REQUIRE(Ranges[0].size == 48);
+
+		const ShaderReflection Deferred = ReflectAsset("Deferred/deferred_frag.spv");
+		ShaderReflection::GetPushConstantRanges({ &Deferred }, Ranges);
+		REQUIRE(Ranges.empty());
+	}
+
+	SECTION("Stages are merged into one set layout")
+	{
+		const ShaderReflection Vert = ReflectAsset("Deferred/mrt_vert.spv");
+		const ShaderReflection Frag = ReflectAsset("Deferred/mrt_frag.spv");
+		REQUIRE(Vert.VertexInputs.size() == 5);
+
+		std::vector<VkDescriptorSetLayoutBinding> Bindings;
+		REQUIRE(ShaderReflection::GetSetBindings({ &Vert, &Frag }, 0, 1 << 0, Bindings));
+		REQUIRE(Bindings.size() == 5);
+		REQUIRE(Bindings[0].binding == 0);
+		REQUIRE(Bindings[0].descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
+		REQUIRE(Bindings[0].stageFlags == VK_SHADER_STAGE_VERTEX_BIT);
+		for (UINT32 i = 1; i < 5; ++i)
+		{
+			REQUIRE(Bindings[i].binding == i);
+			REQUIRE(Bindings[i].descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+			REQUIRE(Bindings[i].stageFlags == VK_SHADER_STAGE_FRAGMENT_BIT);
+		}
+
+		// A binding that both stages read is visible to both
+		ShaderReflection SharedFrag = Frag;
+		SharedFrag.Bindings.push_back(*Vert.FindBinding("ubo"));
+		REQUIRE(ShaderReflection::GetSetBindings({ &Vert, &SharedFrag }, 0, 0, Bindings));
+		REQUIRE(Bindings[0].descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+		REQUIRE(Bindings[0].stageFlags == (VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT));
+
+		// Nothing lives in set 1
+		REQUIRE(ShaderReflection::GetSetBindings({ &Vert, &Frag }, 1, 0, Bindings));
+		REQUIRE(Bindings.empty());
+	}
+
+	SECTION("Stages that disagree on a binding are caught")
+	{
+		const ShaderReflection Frag = ReflectAsset("Deferred/mrt_frag.spv");
+		ShaderReflection Other = Frag;
+		Other.Stage = VK_SHADER_STAGE_VERTEX_BIT;
+		Other.Bindings[0].Type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+
+		std::vector<VkDescriptorSetLayoutBinding> Bindings;
+		REQUIRE_FALSE(ShaderReflection::GetSetBindings({ &Frag, &Other }, 0, 0, Bindings));
+
+		Other = Frag;
+		Other.Bindings[0].Count = 4;
+		REQUIRE_FALSE(ShaderReflection::GetSetBindings({ &Frag, &Other }, 0, 0, Bindings));
+	}
+
+	SECTION("Invalid code is rejected")
+	{
+		std::vector<UINT32> Code = LoadSpirv(FlingPaths::EngineAssetsDir() + "/Shaders/Deferred/mrt_frag.spv");
+		REQUIRE_FALSE(Code.empty());
+
+		ShaderReflection Reflection;
+		REQUIRE_FALSE(ShaderReflection::Parse(Code.data(), 4, Reflection));
+		REQUIRE_FALSE(ShaderReflection::Parse(nullptr, 0, Reflection));
+
+		// Ids past the bound in the header
+		const UINT32 IdBound = Code[3];
+		Code[3] = 2;
+		REQUIRE_FALSE(ShaderReflection::Parse(Code.data(), Code.size(), Reflection));
+		Code[3] = IdBound;
+
+		// An instruction that claims to run past the end of the module
+		Code[5] = (Code[5] & 0xFFFF) | (static_cast<UINT32>(Code.size()) << 16);
+		REQUIRE_FALSE(ShaderReflection::Parse(Code.data(), Code.size(), Reflection));
+
+		Code[0] = 0xDEADBEEF;
+		REQUIRE_FALSE(ShaderReflection::Parse(Code.data(), Code.size(), Reflection));
+	}
+
+	SECTION("Layout keys ignore binding order")
+	{
+		const ShaderReflection Vert = ReflectAsset("Deferred/mrt_vert.spv");
+		const ShaderReflection Frag = ReflectAsset("Deferred/mrt_frag.spv");
+
+		DescriptorLayoutCache::SetLayoutKey A;
+		REQUIRE(ShaderReflection::GetSetBindings({ &Vert, &Frag }, 0, 1 << 0, A.Bindings));
+
+		DescriptorLayoutCache::SetLayoutKey B;
+		REQUIRE(ShaderReflection::GetSetBindings({ &Frag, &Vert }, 0, 1 << 0, B.Bindings));
+		std::reverse(B.Bindings.begin(), B.Bindings.end());
+		DescriptorLayoutCache::SortBindings(B.Bindings);
+
+		const DescriptorLayoutCache::KeyHash Hash;
+		REQUIRE(A == B);
+		REQUIRE(Hash(A) == Hash(B));
+
+		// Without the dynamic offset it's a different layout
+		DescriptorLayoutCache::SetLayoutKey C;
+		REQUIRE(ShaderReflection::GetSetBindings({ &Vert, &Frag }, 0, 0, C.Bindings));
+		REQUIRE_FALSE(A == C);
+
+		C = A;
+		C.Bindings[2].stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
+		REQUIRE_FALSE(A == C);
+	}
+}
+
+TEST_CASE("Bindless materials", "[Renderer]")
+{
+	using namespace Fling;
+
+	// Only the addresses are used, as keys
+	UINT8 Storage[16] = {};
+	Texture* Textures[6];
+	for (UINT32 i = 0; i < 6; ++i)
+	{
+		Textures[i] = reinterpret_cast<Texture*>(Storage + i);
+	}
+	const Material* MatA = reinterpret_cast<const Material*>(Storage + 8);
+	const Material* MatB = reinterpret_cast<const Material*>(Storage + 9);
+	const Material* MatC = reinterpret_cast<const Material*>(Storage + 10);
+
+	PBRTextures TexA = {};
+	TexA.m_AlbedoTexture = Textures[0];
+	TexA.m_NormalTexture = Textures[1];
+	TexA.m_MetalTexture = Textures[2];
+	TexA.m_RoughnessTexture = Textures[2];
+
+	// Shares the normal and metal maps with A
+	PBRTextures TexB = TexA;
+	TexB.m_AlbedoTexture = Textures[3];
+
+	SECTION("Materials and textures are added once")
+	{
+		BindlessMaterialTable Table(16, 4);
+		REQUIRE(Table.AddMaterial(MatA, TexA) == 0);
+		REQUIRE(Table.AddMaterial(MatB, TexB) == 1);
+		REQUIRE(Table.AddMaterial(MatA, TexA) == 0);
+
+		REQUIRE(Table.GetMaterials().size() == 2);
+		REQUIRE(Table.GetTextures().size() == 4);
+
+		const BindlessMaterialData& A = Table.GetMaterials()[0];
+		REQUIRE(A.AlbedoIndex == 0);
+		REQUIRE(A.NormalIndex == 1);
+		REQUIRE(A.MetalIndex == 2);
+		REQUIRE(A.RoughnessIndex == 2);
+
+		const BindlessMaterialData& B = Table.GetMaterials()[1];
+		REQUIRE(B.AlbedoIndex == 3);
+		REQUIRE(B.NormalIndex == A.NormalIndex);
+		REQUIRE(B.MetalIndex == A.MetalIndex);
+
+		// Slots are handed out in order, so they can be written as one range
+		for (UINT32 i = 0; i < Table.GetTextures().size(); ++i)
+		{
+			REQUIRE(Table.AddTexture(Table.GetTextures()[i]) == i);
+		}
+	}
+
+	SECTION("Full tables fall back to the first entry")
+	{
+		BindlessMaterialTable Table(4, 2);
+		REQUIRE(Table.AddMaterial(MatA, TexA) == 0);
+		REQUIRE(Table.AddMaterial(MatB, TexB) == 1);
+		REQUIRE(Table.GetTextures().size() == 4);
+		REQUIRE(Table.AddTexture(Textures[5]) == 0);
+
+		PBRTextures TexC = TexA;
+		TexC.m_AlbedoTexture = Textures[4];
+		REQUIRE(Table.AddMaterial(MatC, TexC) == 0);
+		REQUIRE(Table.GetMaterials().size() == 2);
+	}
+
+	SECTION("Binding flags are part of the layout key")
+	{
+		DescriptorLayoutCache::SetLayoutKey A;
+		A.Bindings.resize(2);
+		A.Bindings[0].binding = 1;
+		A.Bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		A.Bindings[0].descriptorCount = 1;
+		A.Bindings[1].binding = 0;
+		A.Bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		A.Bindings[1].descriptorCount = 4096;
+		A.BindingFlags = { 0, VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT };
+
+		// The flags move along with their binding
+		DescriptorLayoutCache::SortBindings(A.Bindings, &A.BindingFlags);
+		REQUIRE(A.Bindings[0].binding == 0);
+		REQUIRE(A.BindingFlags[0] == (VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT));
+		REQUIRE(A.BindingFlags[1] == 0);
+
+		DescriptorLayoutCache::SetLayoutKey B = A;
+		B.BindingFlags.clear();
+		REQUIRE_FALSE(A == B);
+		REQUIRE(DescriptorLayoutCache::KeyHash()(A) != DescriptorLayoutCache::KeyHash()(B));
+	}
+}
+
+TEST_CASE("GPU frame timestamps", "[Renderer]")
+{
+	using namespace Fling;
+
+	SECTION("Ticks are scaled by the timestamp period")
+	{
+		// 1 ns per tick
+		REQUIRE(GpuFrameTimer::TicksToMilliseconds(1000, 2001000, 64, 1.0f) == Approx(2.0f));
+		// 52.08 ns per tick, like some integrated GPUs
+		REQUIRE(GpuFrameTimer::TicksToMilliseconds(0, 192000, 64, 52.08f) == Approx(10.0f).epsilon(0.001));
+		REQUIRE(GpuFrameTimer::TicksToMilliseconds(500, 500, 64, 1.0f) == 0.0f);
+	}
+
+	SECTION("Counters that wrap around")
+	{
+		// 36 valid bits, the end timestamp wrapped past zero
+		const UINT64 Max = (1ull << 36) - 1;
+		REQUIRE(GpuFrameTimer::TicksToMilliseconds(Max - 999999, 1000000, 36, 1.0f) == Approx(2.0f));
+
+		// Bits above the valid ones are ignored
+		REQUIRE(GpuFrameTimer::TicksToMilliseconds(1ull << 40, (1ull << 40) + 3000000, 36, 1.0f) == Approx(3.0f));
+	}
+}
+
+TEST_CASE("Transfer queue family", "[Renderer]")
+{
+	using namespace Fling;
+
+	auto Family = [](VkQueueFlags t_Flags, UINT32 t_Count = 1)
+	{
+		VkQueueFamilyProperties Props = {};
+		Props.queueFlags = t_Flags;
+		Props.queueCount = t_Count;
+		return Props;
+	};
+
+	const VkQueueFlags Graphics = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
+	const VkQueueFlags Compute = VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
+
+	SECTION("Prefers a family that can only copy")
+	{
+		std::vector<VkQueueFamilyProperties> Families = { Family(Graphics), Family(Compute), Family(VK_QUEUE_TRANSFER_BIT | VK_QUEUE_SPARSE_BINDING_BIT) };
+		REQUIRE(LogicalDevice::FindTransferFamily(Families, 0) == 2);
+	}
+
+	SECTION("Falls back to compute")
+	{
+		// Compute families can copy even if they don't have the transfer bit
+		std::vector<VkQueueFamilyProperties> Families = { Family(Graphics), Family(VK_QUEUE_COMPUTE_BIT) };
+		REQUIRE(LogicalDevice::FindTransferFamily(Families, 0) == 1);
+	}
+
+	SECTION("Uses graphics if nothing else can copy")
+	{
+		std::vector<VkQueueFamilyProperties> Families = { Family(VK_QUEUE_SPARSE_BINDING_BIT), Family(Graphics), Family(VK_QUEUE_TRANSFER_BIT, 0) };
+		REQUIRE(LogicalDevice::FindTransferFamily(Families, 1) == 1);
+
+		// A second graphics family would compete with the first one
+		Families.push_back(Family(Graphics));
+		REQUIRE(LogicalDevice::FindTransferFamily(Families, 1) == 1);
+	}
+}
+
+TEST_CASE("Light clusters", "[Renderer]")
+{
+	using namespace Fling;
+
+	const float Near = 0.1f;
+	const float Far = 100.0f;
+	const glm::mat4 Proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, Near, Far);
+	const glm::mat4 View = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	LightClusterGrid Grid(64);
+
+	// Every light in a cluster's list
+	auto GetClusterLights = [&Grid](UINT32 t_Cluster)
+	{
+		const LightCluster& Cluster = Grid.GetClusters()[t_Cluster];
+		return std::vector<UINT32>(Grid.GetLightIndices().begin() + Cluster.Offset, Grid.GetLightIndices().begin() + Cluster.Offset + Cluster.Count);
+	};
+
+	SECTION("Slices are exponential")
+	{
+		Grid.Build(View, Proj, Near, Far, nullptr, 0);
+
+		REQUIRE(Grid.GetSlice(0.01f) == 0);
+		REQUIRE(Grid.GetSlice(Near) == 0);
+		REQUIRE(Grid.GetSlice(Far * 2.0f) == LightClusterGrid::Slices - 1);
+
+		// The middle of each slice, they get deeper the further they are from the camera
+		for (UINT32 s = 0; s < LightClusterGrid::Slices; ++s)
+		{
+			const float Depth = Near * std::pow(Far / Near, (s + 0.5f) / LightClusterGrid::Slices);
+			REQUIRE(Grid.GetSlice(Depth) == s);
+		}
+
+		REQUIRE(Grid.GetLightIndices().empty());
+		REQUIRE(Grid.GetOverflowCount() == 0);
+	}
+
+	SECTION("Lights only go in the clusters that they reach")
+	{
+		const std::vector<glm::vec4> Lights =
+		{
+			{ 0.0f, 0.0f, -10.0f, 1.0f },
+			// Behind the camera, past the far plane and off to the side
+			{ 0.0f, 0.0f, 10.0f, 1.0f },
+			{ 0.0f, 0.0f, -200.0f, 1.0f },
+			{ 100.0f, 0.0f, -10.0f, 1.0f },
+		};
+		Grid.Build(View, Proj, Near, Far, Lights.data(), static_cast<UINT32>(Lights.size()));
+
+		REQUIRE(GetClusterLights(Grid.FindCluster({ 0.0f, 0.0f, -10.0f })) == std::vector<UINT32> { 0 });
+		REQUIRE(GetClusterLights(Grid.FindCluster({ 0.5f, 0.5f, -9.5f })) == std::vector<UINT32> { 0 });
+		REQUIRE(GetClusterLights(Grid.FindCluster({ 0.0f, 0.0f, -50.0f })).empty());
+		REQUIRE(GetClusterLights(Grid.FindCluster({ -5.0f, 0.0f, -10.0f })).empty());
+
+		// A small light only covers a handful of clusters
+		REQUIRE(!Grid.GetLightIndices().empty());
+		REQUIRE(Grid.GetLightIndices().size() < 32);
+	}
+
+	SECTION("Every light that reaches a point is in it's cluster")
+	{
+		std::mt19937 Gen(1234);
+		std::uniform_real_distribution<float> Side(-40.0f, 40.0f);
+		std::uniform_real_distribution<float> Depth(-90.0f, 5.0f);
+		std::uniform_real_distribution<float> Range(0.5f, 8.0f);
+
+		std::vector<glm::vec4> Lights(500);
+		for (glm::vec4& Light : Lights)
+		{
+			Light = glm::vec4(Side(Gen), Side(Gen), Depth(Gen), Range(Gen));
+		}
+		Grid.Build(View, Proj, Near, Far, Lights.data(), static_cast<UINT32>(Lights.size()));
+		REQUIRE(Grid.GetOverflowCount() == 0);
+
+		const Frustum Frust(Proj * View);
+		UINT32 PointsTested = 0;
+		for (UINT32 p = 0; p < 5000; ++p)
+		{
+			const glm::vec3 Point(Side(Gen), Side(Gen), Depth(Gen));
+			if (!Frust.Intersects(BoundingSphere { Point, 0.0f }))
+			{
+				continue;
+			}
+			++PointsTested;
+
+			const std::vector<UINT32> Binned = GetClusterLights(Grid.FindCluster(Point));
+			REQUIRE(std::is_sorted(Binned.begin(), Binned.end()));
+
+			for (UINT32 i = 0; i < Lights.size(); ++i)
+			{
+				if (glm::length(glm::vec3(Lights[i]) - Point) < Lights[i].w)
+				{
+					REQUIRE(std::binary_search(Binned.begin(), Binned.end(), i));
+				}
+			}
+		}
+		REQUIRE(PointsTested > 100);
+
+		// Clusters should only have a small part of the lights in them
+		REQUIRE(Grid.GetLightIndices().size() < Lights.size() * LightClusterGrid::ClusterCount / 50);
+	}
+
+	SECTION("Full clusters drop lights")
+	{
+		LightClusterGrid Small(4);
+		const std::vector<glm::vec4> Lights(10, glm::vec4(0.0f, 0.0f, -10.0f, 0.5f));
+		Small.Build(View, Proj, Near, Far, Lights.data(), static_cast<UINT32>(Lights.size()));
+
+		const LightCluster& Cluster = Small.GetClusters()[Small.FindCluster({ 0.0f, 0.0f, -10.0f })];
+		REQUIRE(Cluster.Count == 4);
+		REQUIRE(Small.GetOverflowCount() > 0);
+		REQUIRE(Small.GetLightIndices().size() <= Small.GetMaxLightIndices());
+	}
+}
+
+TEST_CASE("Light clustering 4096 lights", "[Renderer][.benchmark]")
+{
+	using namespace Fling;
+
+	const glm::mat4 Proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+	const glm::mat4 View = glm::lookAt(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(0.0f, 2.0f, -10.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	// Lights scattered over a level in front of the camera
+	const UINT32 Count = 4096;
+	std::vector<glm::vec4> Lights(Count);
+	std::mt19937 Gen(42);
+	std::uniform_real_distribution<float> Side(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> Height(0.0f, 10.0f);
+	std::uniform_real_distribution<float> Range(1.0f, 6.0f);
+	for (glm::vec4& Light : Lights)
+	{
+		Light = glm::vec4(Side(Gen), Height(Gen), Side(Gen), Range(Gen));
+	}
+
+	const std::vector<UINT32> ThreadCounts = { 1, 4 };
+	const INT32 Iterations = 100;
+
+	for (UINT32 ThreadCount : ThreadCounts)
+	{
+		JobSystem::Get().Init(ThreadCount);
+
+		LightClusterGrid Grid;
+		Grid.Build(View, Proj, 0.1f, 1000.0f, Lights.data(), Count);
+
+		auto Start = std::chrono::high_resolution_clock::now();
+		for (INT32 i = 0; i < Iterations; ++i)
+		{
+			Grid.Build(View, Proj, 0.1f, 1000.0f, Lights.data(), Count);
+		}
+		auto End = std::chrono::high_resolution_clock::now();
+
+		const double Seconds = std::chrono::duration<double>(End - Start).count();
+		std::cout << "[Benchmark] Binned " << Count << " lights (" << Grid.GetLightIndices().size() << " cluster entries, "
+			<< Grid.GetOverflowCount() << " dropped) on " << ThreadCount << " threads in " << (Seconds / Iterations * 1000.0) << " ms" << std::endl;
+
+		JobSystem::Get().Shutdown();
+	}
+}
+
+TEST_CASE("Occlusion culling", "[Renderer]")
+{
+	using namespace Fling;
+
+	const glm::mat4 ViewProj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f) *
+		glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	// A 10x10 wall facing the camera 10 units away
+	const std::vector<glm::vec3> Wall = {
+		{ -5.0f, -5.0f, -10.0f }, { 5.0f, -5.0f, -10.0f }, { 5.0f, 5.0f, -10.0f }, { -5.0f, 5.0f, -10.0f }
+	};
+	const std::vector<UINT32> WallIndices = { 0, 1, 2, 0, 2, 3 };
+
+	auto MakeBox = [](const glm::vec3& t_Center, float t_HalfSize)
+	{
+		BoundingBox Box;
+		Box.Expand(t_Center - glm::vec3(t_HalfSize));
+		Box.Expand(t_Center + glm::vec3(t_HalfSize));
+		return Box;
+	};
+
+	auto RasterizeWall = [&](OcclusionBuffer& t_Buffer)
+	{
+		std::vector<OccluderTriangle> Triangles;
+		t_Buffer.SetupTriangles(ViewProj, Wall.data(), WallIndices.data(), static_cast<UINT32>(WallIndices.size()), Triangles);
+		REQUIRE(Triangles.size() == 2);
+		t_Buffer.Rasterize(&Triangles, 1);
+	};
+
+	SECTION("Size is rounded up to whole tiles")
+	{
+		OcclusionBuffer Buffer(100, 50);
+		REQUIRE(Buffer.GetWidth() % OcclusionBuffer::TileWidth == 0);
+		REQUIRE(Buffer.GetHeight() % OcclusionBuffer::TileHeight == 0);
+		REQUIRE(Buffer.GetWidth() >= 100);
+		REQUIRE(Buffer.GetHeight() >= 50);
+		REQUIRE(Buffer.GetDepthData().size() == Buffer.GetWidth() * Buffer.GetHeight());
+	}
+
+	SECTION("Empty buffer hides nothing")
+	{
+		OcclusionBuffer Buffer(256, 144);
+		Buffer.Rasterize(nullptr, 0);
+
+		REQUIRE(Buffer.IsVisible(ViewProj, MakeBox({ 0.0f, 0.0f, -50.0f }, 1.0f)));
+		REQUIRE(Buffer.IsVisible(ViewProj, MakeBox({ 0.0f, 0.0f, -99.0f }, 0.5f)));
+		REQUIRE(Buffer.GetTileMaxDepth(0, 0) == 1.0f);
+	}
+
+	SECTION("Boxes behind a wall are hidden")
+	{
+		OcclusionBuffer Buffer(256, 144);
+		RasterizeWall(Buffer);
+
+		// Behind the middle of the wall
+		REQUIRE_FALSE(Buffer.IsVisible(ViewProj, MakeBox({ 0.0f, 0.0f, -20.0f }, 1.0f)));
+		REQUIRE_FALSE(Buffer.IsVisible(ViewProj, MakeBox({ 1.0f, -1.0f, -60.0f }, 3.0f)));
+
+		// In front of the wall, off to the side, and peeking out past the edge
+		REQUIRE(Buffer.IsVisible(ViewProj, MakeBox({ 0.0f, 0.0f, -5.0f }, 1.0f)));
+		REQUIRE(Buffer.IsVisible(ViewProj, MakeBox({ 20.0f, 0.0f, -20.0f }, 1.0f)));
+		REQUIRE(Buffer.IsVisible(ViewProj, MakeBox({ 10.0f, 0.0f, -20.0f }, 1.0f)));
+
+		// Boxes that go through the wall, or that the camera is inside of
+		REQUIRE(Buffer.IsVisible(ViewProj, MakeBox({ 0.0f, 0.0f, -10.0f }, 1.0f)));
+		REQUIRE(Buffer.IsVisible(ViewProj, MakeBox({ 0.0f, 0.0f, 0.0f }, 1.0f)));
+
+		// The wall's own bounds are never hidden by the wall
+		BoundingBox WallBox;
+		for (const glm::vec3& Pos : Wall)
+		{
+			WallBox.Expand(Pos);
+		}
+		REQUIRE(Buffer.IsVisible(ViewProj, WallBox));
+	}
+
+	SECTION("Tile max depth")
+	{
+		OcclusionBuffer Buffer(256, 144);
+		RasterizeWall(Buffer);
+
+		// The middle of the screen is covered by the wall and the corners are not
+		const float WallDepth = Buffer.GetDepth(Buffer.GetWidth() / 2, Buffer.GetHeight() / 2);
+		REQUIRE(WallDepth < 1.0f);
+		REQUIRE(Buffer.GetTileMaxDepth(Buffer.GetTilesX() / 2, Buffer.GetTilesY() / 2) == Approx(WallDepth));
+		REQUIRE(Buffer.GetTileMaxDepth(0, 0) == 1.0f);
+
+		for (UINT32 y = 0; y < Buffer.GetTilesY(); ++y)
+		{
+			for (UINT32 x = 0; x < Buffer.GetTilesX(); ++x)
+			{
+				float Max = 0.0f;
+				for (UINT32 py = 0; py < OcclusionBuffer::TileHeight; ++py)
+				{
+					for (UINT32 px = 0; px < OcclusionBuffer::TileWidth; ++px)
+					{
+						Max = std::max(Max, Buffer.GetDepth(x * OcclusionBuffer::TileWidth + px, y * OcclusionBuffer::TileHeight + py));
+					}
+				}
+				REQUIRE(Buffer.GetTileMaxDepth(x, y) == Max);
+			}
+		}
+	}
+
+	SECTION("Triangles through the near plane are clipped")
+	{
+		// A floor that goes under the camera and off into the distance
+		const std::vector<glm::vec3> Floor = {
+			{ -50.0f, -1.0f, 10.0f }, { 50.0f, -1.0f, 10.0f }, { 50.0f, -1.0f, -90.0f }, { -50.0f, -1.0f, -90.0f }
+		};
+
+		OcclusionBuffer Buffer(256, 144);
+		std::vector<OccluderTriangle> Triangles;
+		Buffer.SetupTriangles(ViewProj, Floor.data(), WallIndices.data(), static_cast<UINT32>(WallIndices.size()), Triangles);
+		REQUIRE(Triangles.size() >= 2);
+		Buffer.Rasterize(&Triangles, 1);
+
+		// The bottom of the screen is covered and the sky is not
+		REQUIRE(Buffer.GetDepth(Buffer.GetWidth() / 2, Buffer.GetHeight() - 1) < 1.0f);
+		REQUIRE(Buffer.GetDepth(Buffer.GetWidth() / 2, 0) == 1.0f);
+
+		// Under the floor is hidden, above it is not
+		REQUIRE_FALSE(Buffer.IsVisible(ViewProj, MakeBox({ 0.0f, -5.0f, -20.0f }, 1.0f)));
+		REQUIRE(Buffer.IsVisible(ViewProj, MakeBox({ 0.0f, 1.0f, -20.0f }, 1.0f)));
+	}
+
+	SECTION("Parallel rasterizing matches serial")
+	{
+		std::mt19937 Gen(7);
+		std::uniform_real_distribution<float> Side(-20.0f, 20.0f);
+		std::uniform_real_distribution<float> Depth(-60.0f, -2.0f);
+
+		std::vector<glm::vec3> Positions(300);
+		for (glm::vec3& Pos : Positions)
+		{
+			Pos = glm::vec3(Side(Gen), Side(Gen), Depth(Gen));
+		}
+		std::vector<UINT32> Indices(Positions.size());
+		std::iota(Indices.begin(), Indices.end(), 0);
+
+		OcclusionBuffer Serial(256, 144);
+		std::vector<OccluderTriangle> Triangles;
+		Serial.SetupTriangles(ViewProj, Positions.data(), Indices.data(), static_cast<UINT32>(Indices.size()), Triangles);
+		Serial.Rasterize(&Triangles, 1);
+
+		JobSystem::Get().Init(4);
+		OcclusionBuffer Parallel(256, 144);
+		Parallel.Rasterize(&Triangles, 1);
+		JobSystem::Get().Shutdown();
+
+		REQUIRE(Serial.GetDepthData() == Parallel.GetDepthData());
+	}
+
+	SECTION("Culler keeps every candidate without occluders")
+	{
+		entt::registry Reg;
+		std::vector<entt::entity> Candidates;
+		for (UINT32 i = 0; i < 16; ++i)
+		{
+			const entt::entity Ent = Reg.create();
+			Reg.assign<Transform>(Ent);
+			Reg.assign<MeshRenderer>(Ent);
+			Candidates.emplace_back(Ent);
+		}
+
+		OcclusionCuller Culler;
+		Culler.Cull(Reg, ViewProj, Candidates);
+		REQUIRE(Culler.GetVisibleEntities() == Candidates);
+		REQUIRE(Culler.GetOccluderCount() == 0);
+		REQUIRE(Culler.GetOccludedCount() == 0);
+
+		Culler.SetEnabled(false);
+		Culler.Cull(Reg, ViewProj, Candidates);
+		REQUIRE(Culler.GetVisibleEntities() == Candidates);
+	}
+}
+
+TEST_CASE("Occlusion culling 64 occluders", "[Renderer][.benchmark]")
+{
+	using namespace Fling;
+
+	const glm::mat4 ViewProj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f) *
+		glm::lookAt(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 2.0f, -10.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	// Walls of a city block made of boxes, 12 triangles each
+	std::mt19937 Gen(42);
+	std::uniform_real_distribution<float> Side(-60.0f, 60.0f);
+	std::uniform_real_distribution<float> Depth(-120.0f, -5.0f);
+	std::uniform_real_distribution<float> Size(1.0f, 8.0f);
+
+	const UINT32 OccluderCount = 64;
+	const UINT32 BoxIndices[] = {
+		0, 1, 3, 0, 3, 2, 4, 6, 7, 4, 7, 5, 0, 4, 5, 0, 5, 1,
+		2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 5, 7, 1, 7, 3
+	};
+	std::vector<std::vector<OccluderTriangle>> Triangles(OccluderCount);
+	std::vector<std::vector<glm::vec3>> Occluders(OccluderCount);
+	for (std::vector<glm::vec3>& Corners : Occluders)
+	{
+		const glm::vec3 Center(Side(Gen), 0.0f, Depth(Gen));
+		const glm::vec3 Extents(Size(Gen), Size(Gen) * 2.0f, Size(Gen));
+		for (UINT32 c = 0; c < 8; ++c)
+		{
+			Corners.emplace_back(
+				(c & 1) ? Center.x + Extents.x : Center.x - Extents.x,
+				(c & 2) ? Center.y + Extents.y : Center.y - Extents.y,
+				(c & 4) ? Center.z + Extents.z : Center.z - Extents.z);
+		}
+	}
+
+	// Small props scattered between them
+	const UINT32 BoxCount = 10000;
+	std::vector<BoundingBox> Boxes(BoxCount);
+	for (BoundingBox& Box : Boxes)
+	{
+		const glm::vec3 Center(Side(Gen), 0.5f, Depth(Gen) * 2.0f);
+		Box.Expand(Center - glm::vec3(0.5f));
+		Box.Expand(Center + glm::vec3(0.5f));
+	}
+
+	const std::vector<UINT32> ThreadCounts = { 1, 4 };
+	const INT32 Iterations = 100;
+
+	for (UINT32 ThreadCount : ThreadCounts)
+	{
+		JobSystem::Get().Init(ThreadCount);
+
+		OcclusionBuffer Buffer(256, 144);
+		std::vector<UINT8> IsVisible(BoxCount);
+		UINT32 VisibleCount = 0;
+
+		auto Start = std::chrono::high_resolution_clock::now();
+		for (INT32 i = 0; i < Iterations; ++i)
+		{
+			JobSystem::ParallelFor(OccluderCount, 1, [&](UINT32 t_Begin, UINT32 t_End)
+			{
+				for (UINT32 o = t_Begin; o < t_End; ++o)
+				{
+					Triangles[o].clear();
+					Buffer.SetupTriangles(ViewProj, Occluders[o].data(), BoxIndices, 36, Triangles[o]);
+				}
+			});
+			Buffer.Rasterize(Triangles.data(), OccluderCount);
+
+			JobSystem::ParallelFor(BoxCount, 64, [&](UINT32 t_Begin, UINT32 t_End)
+			{
+				for (UINT32 b = t_Begin; b < t_End; ++b)
+				{
+					IsVisible[b] = Buffer.IsVisible(ViewProj, Boxes[b]) ? 1 : 0;
+				}
+			});
+			VisibleCount = std::accumulate(IsVisible.begin(), IsVisible.end(), 0u);
+		}
+		auto End = std::chrono::high_resolution_clock::now();
+
+		const double Seconds = std::chrono::duration<double>(End - Start).count();
+		std::cout << "[Benchmark] Rasterized " << OccluderCount << " occluders and tested " << BoxCount << " boxes (" << VisibleCount
+			<< " visible) on " << ThreadCount << " threads in " << (Seconds / Iterations * 1000.0) << " ms" << std::endl;
+
+		JobSystem::Get().Shutdown();
+	}
+}
+
+namespace
+{
+	/** Closed torus around the z axis with wrapped indices, so it has no seams or borders */
+	void BuildTorus(UINT32 t_Rings, UINT32 t_Sides, float t_Radius, float t_TubeRadius, std::vector<Fling::Vertex>& t_OutVerts, std::vector<UINT32>& t_OutIndices)
+	{
+		using namespace Fling;
+		for (UINT32 i = 0; i < t_Rings; ++i)
+		{
+			for (UINT32 j = 0; j < t_Sides; ++j)
+			{
+				const float U = glm::pi<float>() * 2.0f * i / t_Rings;
+				const float V = glm::pi<float>() * 2.0f * j / t_Sides;
+				Vertex Vert = {};
+				Vert.Pos = glm::vec3((t_Radius + t_TubeRadius * std::cos(V)) * std::cos(U), (t_Radius + t_TubeRadius * std::cos(V)) * std::sin(U), t_TubeRadius * std::sin(V));
+				t_OutVerts.push_back(Vert);
+			}
+		}
+
+		for (UINT32 i = 0; i < t_Rings; ++i)
+		{
+			for (UINT32 j = 0; j < t_Sides; ++j)
+			{
+				const UINT32 A = i * t_Sides + j;
+				const UINT32 B = ((i + 1) % t_Rings) * t_Sides + j;
+				const UINT32 C = ((i + 1) % t_Rings) * t_Sides + (j + 1) % t_Sides;
+				const UINT32 D = i * t_Sides + (j + 1) % t_Sides;
+				for (UINT32 Index : { A, B, C, A, C, D })
+				{
+					t_OutIndices.push_back(Index);
+				}
+			}
+		}
+	}
+
+	/** Distance from a point to the closest of the triangles */
+	float GetDistanceToTriangles(const glm::vec3& t_Point, const std::vector<Fling::Vertex>& t_Verts, const UINT32* t_Indices, UINT32 t_IndexCount)
+	{
+		float Closest = FLT_MAX;
+		for (UINT32 i = 0; i < t_IndexCount; i += 3)
+		{
+			const glm::vec3 A = t_Verts[t_Indices[i + 0]].Pos;
+			const glm::vec3 B = t_Verts[t_Indices[i + 1]].Pos;
+			const glm::vec3 C = t_Verts[t_Indices[i + 2]].Pos;
+
+			const glm::vec3 Normal = glm::normalize(glm::cross(B - A, C - A));
+			const float PlaneDist = glm::dot(t_Point - A, Normal);
+			const glm::vec3 Projected = t_Point - Normal * PlaneDist;
+			auto IsInside = [&](const glm::vec3& t_From, const glm::vec3& t_To)
+			{
+				return glm::dot(glm::cross(t_To - t_From, Projected - t_From), Normal) >= 0.0f;
+			};
+			if (IsInside(A, B) && IsInside(B, C) && IsInside(C, A))
+			{
+				Closest = std::min(Closest, std::abs(PlaneDist));
+				continue;
+			}
+
+			for (const auto& Edge : { std::make_pair(A, B), std::make_pair(B, C), std::make_pair(C, A) })
+			{
+				const glm::vec3 Dir = Edge.second - Edge.first;
+				const float T = glm::clamp(glm::dot(t_Point - Edge.first, Dir) / glm::dot(Dir, Dir), 0.0f, 1.0f);
+				Closest = std::min(Closest, glm::length(t_Point - (Edge.first + Dir * T)));
+			}
+		}
+		return Closest;
+	}
+}
+
+TEST_CASE("Mesh simplification", "[Renderer]")
+{
+	using namespace Fling;
+
+	SECTION("Torus levels of detail")
+	{
+		std::vector<Vertex> Verts;
+		std::vector<UINT32> Indices;
+		BuildTorus(48, 24, 2.0f, 0.5f, Verts, Indices);
+		const UINT32 FullIndexCount = static_cast<UINT32>(Indices.size());
+
+		std::vector<MeshLod> Lods;
+		const UINT32 LodCount = MeshSimplifier::GenerateLods(Verts, Indices, Lods);
+		REQUIRE(LodCount > 2);
+		REQUIRE(LodCount <= MaxMeshLods);
+		REQUIRE(Lods.size() == LodCount);
+
+		REQUIRE(Lods[0].FirstIndex == 0);
+		REQUIRE(Lods[0].IndexCount == FullIndexCount);
+		REQUIRE(Lods[0].Error == 0.0f);
+
+		for (UINT32 Level = 1; Level < LodCount; ++Level)
+		{
+			const MeshLod& Lod = Lods[Level];
+			REQUIRE(Lod.FirstIndex == Lods[Level - 1].FirstIndex + Lods[Level - 1].IndexCount);
+			REQUIRE(Lod.IndexCount % 3 == 0);
+			REQUIRE(Lod.IndexCount < Lods[Level - 1].IndexCount);
+			REQUIRE(Lod.Error >= Lods[Level - 1].Error);
+			REQUIRE(Lod.Error < 0.5f);
+
+			// Every vertex of the full mesh is within the error of the simplified one
+			float MaxDistance = 0.0f;
+			for (const Vertex& Vert : Verts)
+			{
+				MaxDistance = std::max(MaxDistance, GetDistanceToTriangles(Vert.Pos, Verts, Indices.data() + Lod.FirstIndex, Lod.IndexCount));
+			}
+			REQUIRE(MaxDistance <= Lod.Error + 1e-4f);
+		}
+
+		REQUIRE(Indices.size() == Lods.back().FirstIndex + Lods.back().IndexCount);
+		REQUIRE(std::all_of(Indices.begin(), Indices.end(), [&](UINT32 t_Index) { return t_Index < Verts.size(); }));
+	}
+
+	SECTION("Borders are kept")
+	{
+		std::vector<Vertex> Verts;
+		std::vector<UINT32> Indices;
+		BuildUnweldedGrid(16, Verts, Indices);
+		MeshOptimizer::WeldVertices(Verts, Indices);
+
+		std::vector<UINT32> Simplified;
+		const float Error = MeshSimplifier::Simplify(
+			Verts.data(), static_cast<UINT32>(Verts.size()),
+			Indices.data(), static_cast<UINT32>(Indices.size()),
+			static_cast<UINT32>(Indices.size()) / 4, FLT_MAX, Simplified);
+		REQUIRE(Simplified.size() < Indices.size());
+
+		// The grid is flat so nothing moves off of it
+		REQUIRE(Error == Approx(0.0f).margin(1e-5f));
+
+		std::vector<bool> IsUsed(Verts.size(), false);
+		for (UINT32 Index : Simplified)
+		{
+			IsUsed[Index] = true;
+		}
+		for (UINT32 i = 0; i < Verts.size(); ++i)
+		{
+			const glm::vec3& Pos = Verts[i].Pos;
+			if (Pos.x == 0.0f || Pos.y == 0.0f || Pos.x == 16.0f || Pos.y == 16.0f)
+			{
+				REQUIRE(IsUsed[i]);
+			}
+		}
+
+		// The same area is still covered
+		float Area = 0.0f;
+		for (size_t i = 0; i < Simplified.size(); i += 3)
+		{
+			const glm::vec3 A = Verts[Simplified[i + 0]].Pos;
+			const glm::vec3 B = Verts[Simplified[i + 1]].Pos;
+			const glm::vec3 C = Verts[Simplified[i + 2]].Pos;
+			Area += glm::cross(B - A, C - A).z * 0.5f;
+		}
+		REQUIRE(Area == Approx(16.0f * 16.0f));
+	}
+
+	SECTION("Meshes that can't be simplified keep one level")
+	{
+		std::vector<Vertex> Verts;
+		std::vector<UINT32> Indices;
+		BuildCubeWithoutNormals(Verts, Indices);
+
+		std::vector<MeshLod> Lods;
+		REQUIRE(MeshSimplifier::GenerateLods(Verts, Indices, Lods) == 1);
+		REQUIRE(Indices.size() == 36);
+		REQUIRE(Lods[0].IndexCount == 36);
+	}
+
+	SECTION("Level selection")
+	{
+		const MeshLod Lods[3] = { { 0, 300, 0.0f }, { 300, 150, 0.01f }, { 450, 75, 0.04f } };
+		const float MaxError = 0.002f;
+		const float Hysteresis = 0.25f;
+
+		// Errors on screen are Error * ScreenSize / Radius, with a radius of 1
+		REQUIRE(LodSelector::SelectLod(Lods, 3, 1.0f, 1.0f, 0, MaxError, Hysteresis) == 0);
+		REQUIRE(LodSelector::SelectLod(Lods, 3, 0.01f, 1.0f, 0, MaxError, Hysteresis) == 2);
+		REQUIRE(LodSelector::SelectLod(Lods, 3, 0.1f, 1.0f, 0, MaxError, Hysteresis) == 1);
+
+		// Level 1 is 0.0019 on screen here, under the max error but inside the hysteresis band
+		REQUIRE(LodSelector::SelectLod(Lods, 3, 0.19f, 1.0f, 0, MaxError, Hysteresis) == 0);
+		REQUIRE(LodSelector::SelectLod(Lods, 3, 0.19f, 1.0f, 1, MaxError, Hysteresis) == 1);
+
+		// Going back to a finer level doesn't wait
+		REQUIRE(LodSelector::SelectLod(Lods, 3, 0.21f, 1.0f, 1, MaxError, Hysteresis) == 0);
+
+		REQUIRE(LodSelector::SelectLod(Lods, 1, 0.0001f, 1.0f, 0, MaxError, Hysteresis) == 0);
+	}
+
+	SECTION("Cooked levels of detail")
+	{
+		Logger::Get().Init();
+		const std::string CookedPath = (std::filesystem::temp_directory_path() / "FlingTestLodMesh.flmesh").string();
+
+		std::vector<Vertex> Verts;
+		std::vector<UINT32> Indices;
+		BuildTorus(32, 16, 2.0f, 0.5f, Verts, Indices);
+		const BoundingBox Bounds = MeshImporter::CalculateBounds(Verts);
+
+		MeshFile File;
+		REQUIRE(MeshFile::Write(CookedPath, Verts, Indices, Bounds));
+		REQUIRE(File.Open(CookedPath));
+		REQUIRE(File.GetLodCount() == 1);
+		REQUIRE(File.GetLod(0).FirstIndex == 0);
+		REQUIRE(File.GetLod(0).IndexCount == Indices.size());
+
+		std::vector<MeshLod> Lods;
+		const UINT32 LodCount = MeshSimplifier::GenerateLods(Verts, Indices, Lods);
+		REQUIRE(MeshFile::Write(CookedPath, Verts, Indices, Bounds, VertexFormat::Full, Lods));
+		REQUIRE(File.Open(CookedPath));
+		REQUIRE(File.GetIndexCount() == Indices.size());
+		REQUIRE(File.GetLodCount() == LodCount);
+		for (UINT32 i = 0; i < LodCount; ++i)
+		{
+			REQUIRE(File.GetLod(i).FirstIndex == Lods[i].FirstIndex);
+			REQUIRE(File.GetLod(i).IndexCount == Lods[i].IndexCount);
+			REQUIRE(File.GetLod(i).Error == Lods[i].Error);
+		}
+
+		std::filesystem::remove(CookedPath);
+	}
+}
+
+TEST_CASE("Mesh simplification Assets/Models", "[Renderer][.benchmark]")
+{
+	using namespace Fling;
+	using Clock = std::chrono::high_resolution_clock;
+	Logger::Get().Init();
+
+	for (const auto& Entry : std::filesystem::directory_iterator(FlingPaths::EngineAssetsDir() + "/Models"))
+	{
+		if (Entry.path().extension() != ".obj")
+		{
+			continue;
+		}
+
+		std::vector<Vertex> Verts;
+		std::vector<UINT32> Indices;
+		REQUIRE(MeshImporter::Import(Entry.path().string(), Verts, Indices));
+
+		std::vector<MeshLod> Lods;
+		auto Start = Clock::now();
+		const UINT32 LodCount = MeshSimplifier::GenerateLods(Verts, Indices, Lods);
+		const double Ms = std::chrono::duration<double, std::milli>(Clock::now() - Start).count();
+
+		std::cout << "[Benchmark] " << Entry.path().filename().string() << ": " << LodCount << " levels,";
+		for (const MeshLod& Lod : Lods)
+		{
+			std::cout << " " << Lod.IndexCount / 3 << " (" << Lod.Error << ")";
+		}
+		std::cout << " triangles in " << Ms << " ms" << std::endl;
+	}
+}
+
+TEST_CASE("Draw list", "[Renderer]")
+{
+	using namespace Fling;
+
+	SECTION("Sort keys")
+	{
+		// Every field outranks all of the fields after it
+		REQUIRE(DrawList::MakeKey(1, 0, 0, 0, 0.0f) > DrawList::MakeKey(0, 0xFFF, 0xFFFF, 0xFFFF, FLT_MAX));
+		REQUIRE(DrawList::MakeKey(0, 1, 0, 0, 0.0f) > DrawList::MakeKey(0, 0, 0xFFFF, 0xFFFF, FLT_MAX));
+		REQUIRE(DrawList::MakeKey(0, 0, 1, 0, 0.0f) > DrawList::MakeKey(0, 0, 0, 0xFFFF, FLT_MAX));
+		REQUIRE(DrawList::MakeKey(0, 0, 0, 1, 0.0f) > DrawList::MakeKey(0, 0, 0, 0, FLT_MAX));
+
+		// Ids that are too big for their field don't spill into the others
+		REQUIRE(DrawList::MakeKey(0, 0, 0, 0x10000, 0.0f) == DrawList::MakeKey(0, 0, 0, 0, 0.0f));
+		REQUIRE(DrawList::MakeKey(0x10, 0x1000, 0, 0, 0.0f) == 0);
+
+		// Closer draws sort first
+		float LastDepth = 0.0f;
+		for (float Depth = 0.001f; Depth < 10000.0f; Depth *= 1.5f)
+		{
+			REQUIRE(DrawList::QuantizeDepth(Depth) >= DrawList::QuantizeDepth(LastDepth));
+			REQUIRE(DrawList::QuantizeDepth(Depth) < (1u << DrawList::DepthBits));
+			LastDepth = Depth;
+		}
+		REQUIRE(DrawList::QuantizeDepth(1.0f) < DrawList::QuantizeDepth(2.0f));
+		REQUIRE(DrawList::QuantizeDepth(-1.0f) == 0);
+
+		const int Objects[2] = {};
+		REQUIRE(DrawList::GetSortId(&Objects[0], DrawList::MeshBits) == DrawList::GetSortId(&Objects[0], DrawList::MeshBits));
+		REQUIRE(DrawList::GetSortId(&Objects[1], 8) < 256);
+		REQUIRE(DrawList::GetSortId(&Objects[1], 0) == 0);
+	}
+
+	SECTION("Radix sort matches a stable sort")
+	{
+		std::mt19937_64 Gen(7);
+		for (UINT32 ThreadCount : { 1u, 4u })
+		{
+			JobSystem::Get().Init(ThreadCount);
+
+			for (UINT32 Count : { 0u, 1u, 100u, 5000u, 100000u })
+			{
+				// Few distinct values in some of the bytes, so there are equal keys and skipped passes
+				std::vector<DrawListItem> Items(Count);
+				for (UINT32 i = 0; i < Count; ++i)
+				{
+					Items[i].Key = DrawList::MakeKey(0, Gen() % 4, Gen() % 64, Gen() % 16, 0.0f) | (Gen() & 0xFF);
+					Items[i].Command = i;
+				}
+
+				std::vector<DrawListItem> Expected = Items;
+				std::stable_sort(Expected.begin(), Expected.end(), [](const DrawListItem& t_A, const DrawListItem& t_B) { return t_A.Key < t_B.Key; });
+
+				std::vector<DrawListItem> Scratch;
+				DrawList::RadixSort(Items, Scratch);
+				REQUIRE(Items.size() == Count);
+
+				bool IsSame = true;
+				for (UINT32 i = 0; i < Count; ++i)
+				{
+					IsSame &= Items[i].Key == Expected[i].Key && Items[i].Command == Expected[i].Command;
+				}
+				REQUIRE(IsSame);
+			}
+
+			JobSystem::Get().Shutdown();
+		}
+	}
+
+	SECTION("Draws are grouped by state and go front to back")
+	{
+		int Pipelines[2] = {};
+		int Mesh = 0;
+
+		DrawList List;
+		const float Depths[4] = { 8.0f, 2.0f, 4.0f, 1.0f };
+		for (UINT32 i = 0; i < 4; ++i)
+		{
+			DrawCommand Command = {};
+			Command.FirstInstance = i;
+			const UINT32 PipelineId = DrawList::GetSortId(&Pipelines[i % 2], DrawList::PipelineBits);
+			const UINT32 MeshId = DrawList::GetSortId(&Mesh, DrawList::MeshBits);
+			List.Add(DrawList::MakeKey(0, PipelineId, 0, MeshId, Depths[i]), Command);
+		}
+		REQUIRE(List.GetSize() == 4);
+
+		List.Sort();
+		const std::vector<DrawListItem>& Items = List.GetItems();
+		for (UINT32 i = 1; i < 4; ++i)
+		{
+			REQUIRE(Items[i - 1].Key <= Items[i].Key);
+		}
+
+		// Draws with the same pipeline end up next to each other, closest first
+		for (UINT32 i = 0; i < 4; i += 2)
+		{
+			const DrawCommand& First = List.GetCommand(Items[i].Command);
+			const DrawCommand& Second = List.GetCommand(Items[i + 1].Command);
+			REQUIRE(First.FirstInstance % 2 == Second.FirstInstance % 2);
+			REQUIRE(Depths[First.FirstInstance] < Depths[Second.FirstInstance]);
+		}
+
+		List.Clear();
+		REQUIRE(List.GetSize() == 0);
+	}
+
+	SECTION("Descriptor sets are only bound again when they change")
+	{
+		// The tracker only compares handles, so any address will do
+		int Objects[6] = {};
+		VkPipeline Pipeline = reinterpret_cast<VkPipeline>(&Objects[0]);
+		VkPipelineLayout Layout = reinterpret_cast<VkPipelineLayout>(&Objects[1]);
+		VkDescriptorSet Materials[4] = {};
+		for (UINT32 i = 0; i < 4; ++i)
+		{
+			Materials[i] = reinterpret_cast<VkDescriptorSet>(&Objects[i + 2]);
+		}
+
+		// Batches that alternate between materials, like the order they were created in
+		DrawList List;
+		for (UINT32 i = 0; i < 16; ++i)
+		{
+			DrawCommand Command = {};
+			Command.DescriptorSet = Materials[i % 4];
+			List.Add(DrawList::MakeKey(0, 0, DrawList::GetSortId(Command.DescriptorSet, DrawList::MaterialBits), 0, 0.0f), Command);
+		}
+
+		auto CountSetBinds = [&]()
+		{
+			DrawStateTracker State;
+			for (const DrawListItem& Item : List.GetItems())
+			{
+				State.SetPipeline(Pipeline, Layout);
+				State.SetDescriptorSet(List.GetCommand(Item.Command).DescriptorSet, 256);
+				State.AddDraw();
+			}
+			REQUIRE(State.GetStats().PipelineBinds == 1);
+			REQUIRE(State.GetStats().Draws == 16);
+			return State.GetStats().DescriptorSetBinds;
+		};
+
+		const UINT32 UnsortedBinds = CountSetBinds();
+		REQUIRE(UnsortedBinds == 16);
+
+		List.Sort();
+		const UINT32 SortedBinds = CountSetBinds();
+		REQUIRE(SortedBinds == 4);
+		REQUIRE(SortedBinds < UnsortedBinds);
+
+		// A different dynamic offset or pipeline needs the set bound again
+		DrawStateTracker State;
+		REQUIRE(State.SetPipeline(Pipeline, Layout));
+		REQUIRE(State.SetDescriptorSet(Materials[0], 0));
+		REQUIRE_FALSE(State.SetDescriptorSet(Materials[0], 0));
+		REQUIRE(State.SetDescriptorSet(Materials[0], 256));
+		REQUIRE_FALSE(State.SetPipeline(Pipeline, Layout));
+		REQUIRE_FALSE(State.SetDescriptorSet(Materials[0], 256));
+		REQUIRE(State.SetPipeline(reinterpret_cast<VkPipeline>(&Objects[1]), Layout));
+		REQUIRE(State.SetDescriptorSet(Materials[0], 256));
+		REQUIRE(State.GetStats().DescriptorSetBinds == 3);
+	}
+}
+
+TEST_CASE("Draw list sort 100k draws", "[Renderer][.benchmark]")
+{
+	using namespace Fling;
+
+	// A scene's worth of draws spread over a handful of pipelines, materials and meshes
+	const UINT32 DrawCount = 100000;
+	std::mt19937 Gen(3);
+	std::uniform_real_distribution<float> Depth(0.1f, 500.0f);
+	std::vector<DrawListItem> Source(DrawCount);
+	for (UINT32 i = 0; i < DrawCount; ++i)
+	{
+		Source[i].Key = DrawList::MakeKey(0, Gen() % 8, Gen() % 256, Gen() % 1024, Depth(Gen));
+		Source[i].Command = i;
+	}
+
+	const std::vector<UINT32> ThreadCounts = { 1, 4 };
+	const INT32 Iterations = 100;
+
+	std::vector<DrawListItem> Items;
+	std::vector<DrawListItem> Scratch;
+	for (UINT32 ThreadCount : ThreadCounts)
+	{
+		JobSystem::Get().Init(ThreadCount);
+
+		double Seconds = 0.0;
+		for (INT32 i = 0; i < Iterations; ++i)
+		{
+			Items = Source;
+			auto Start = std::chrono::high_resolution_clock::now();
+			DrawList::RadixSort(Items, Scratch);
+			Seconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - Start).count();
+		}
+		REQUIRE(std::is_sorted(Items.begin(), Items.end(), [](const DrawListItem& t_A, const DrawListItem& t_B) { return t_A.Key < t_B.Key; }));
+
+		std::cout << "[Benchmark] Radix sorted " << DrawCount << " draws on " << ThreadCount << " threads in " << (Seconds / Iterations * 1000.0)
+			<< " ms (" << (DrawCount * Iterations / Seconds / 1000000.0) << " M draws/s)" << std::endl;
+
+		JobSystem::Get().Shutdown();
+	}
+
+	double Seconds = 0.0;
+	for (INT32 i = 0; i < Iterations; ++i)
+	{
+		Items = Source;
+		auto Start = std::chrono::high_resolution_clock::now();
+		std::sort(Items.begin(), Items.end(), [](const DrawListItem& t_A, const DrawListItem& t_B) { return t_A.Key < t_B.Key; });
+		Seconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - Start).count();
+	}
+	std::cout << "[Benchmark] std::sort of " << DrawCount << " draws in " << (Seconds / Iterations * 1000.0) << " ms" << std::endl;
+}
@@ -4,6 +4,7 @@
 #include "Singleton.hpp"
 #include "FlingConfig.h"
 #include "ResourceManager.h"
+#include "JsonFile.h"
 
 // @see TestConf.ini
 
@@ -56,4 +57,58 @@ TEST_CASE("Engine Config File", "[resource]")
     ResourceManager::Get().Shutdown();
     Logger::Get().Shutdown();
     FlingConfig::Get().Shutdown();
-}
\ No newline at end of file
+}
+TEST_CASE("Async Resource Loading", "[resource]")
+{
+    using namespace Fling;
+    Logger::Get().Init();
+    ResourceManager::Get().Init();
+
+    SECTION("Load JSON file async")
+    {
+        bool CallbackFired = false;
+        std::shared_ptr<JsonFile> CallbackFile = nullptr;
+
+        std::shared_ptr<JsonFile> File = JsonFile::CreateAsync(HS("Levels/EmptyLevel.json"), [&](std::shared_ptr<JsonFile> t_File)
+        {
+            CallbackFired = true;
+            CallbackFile = t_File;
+        });
+        REQUIRE(File);
+
+        // Callbacks only ever fire on the main thread during Update
+        REQUIRE_FALSE(CallbackFired);
+
+        ResourceManager::Get().WaitForAsyncLoads();
+        REQUIRE(CallbackFired);
+        REQUIRE(CallbackFile == File);
+        REQUIRE(File->IsReady());
+        REQUIRE_FALSE(File->GetJsonData().empty());
+        REQUIRE(ResourceManager::Get().GetPendingLoadCount() == 0);
+
+        // Loading something that is already loaded calls back right away with the same resource
+        bool SecondCallbackFired = false;
+        std::shared_ptr<JsonFile> Again = JsonFile::CreateAsync(HS("Levels/EmptyLevel.json"), [&](std::shared_ptr<JsonFile> t_File)
+        {
+            SecondCallbackFired = (t_File == File);
+        });
+        REQUIRE(Again == File);
+        REQUIRE(SecondCallbackFired);
+    }
+
+    SECTION("Missing file fails")
+    {
+        bool CallbackFired = false;
+        std::shared_ptr<JsonFile> File = JsonFile::CreateAsync(HS("Levels/ThisFileDoesNotExist.json"), [&](std::shared_ptr<JsonFile> t_File)
+        {
+            CallbackFired = true;
+        });
+
+        ResourceManager::Get().WaitForAsyncLoads();
+        REQUIRE(CallbackFired);
+        REQUIRE(File->GetLoadState() == Resource::LoadState::Failed);
+    }
+
+    ResourceManager::Get().Shutdown();
+    Logger::Get().Shutdown();
+}
@@ -10,6 +10,16 @@
 #include "StackAllocator.h"
 #include "Memory.h"
 #include "CircularBuffer.hpp"
+#include "WorkStealingQueue.hpp"
+#include "JobSystem.h"
+#include "RingAllocator.h"
+#include "BatchRingAllocator.h"
+#include "MovingAverage.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <entt/entity/registry.hpp>
 
 TEST_CASE("Timing", "[utils]")
 {
@@ -103,4 +113,432 @@ TEST_CASE("Circular Buffer", "[utils]")
     // Circular buffer of char's 
     Fling::CircularBuffer<INT32, 128> CircBuf {};
 
-}
\ No newline at end of file
+}
+
+TEST_CASE("Work Stealing Queue", "[utils]")
+{
+	using namespace Fling;
+
+	WorkStealingQueue<INT32, 64> Queue {};
+	INT32 Items[3] = { 0, 1, 2 };
+
+	SECTION("Empty queue")
+	{
+		REQUIRE(Queue.Pop() == nullptr);
+		REQUIRE(Queue.Steal() == nullptr);
+	}
+
+	SECTION("Pop is LIFO and steal is FIFO")
+	{
+		Queue.Push(&Items[0]);
+		Queue.Push(&Items[1]);
+		Queue.Push(&Items[2]);
+		REQUIRE(Queue.Size() == 3);
+
+		REQUIRE(Queue.Pop() == &Items[2]);
+		REQUIRE(Queue.Steal() == &Items[0]);
+		REQUIRE(Queue.Pop() == &Items[1]);
+		REQUIRE(Queue.Pop() == nullptr);
+	}
+
+	SECTION("Concurrent steals take every item exactly once")
+	{
+		const INT32 ItemCount = 100000;
+		std::vector<INT32> Values(ItemCount, 0);
+		std::vector<std::atomic<INT32>> TimesTaken(ItemCount);
+		WorkStealingQueue<INT32, 1024>* BigQueue = new WorkStealingQueue<INT32, 1024>();
+		std::atomic<bool> Done { false };
+
+		auto Take = [&](INT32* t_Item)
+		{
+			if (t_Item)
+			{
+				TimesTaken[t_Item - Values.data()]++;
+			}
+		};
+
+		std::vector<std::thread> Thieves;
+		for (INT32 i = 0; i < 4; ++i)
+		{
+			Thieves.emplace_back([&]()
+			{
+				while (!Done)
+				{
+					Take(BigQueue->Steal());
+				}
+			});
+		}
+
+		for (INT32 i = 0; i < ItemCount; ++i)
+		{
+			// Keep the queue from filling up by popping some ourselves
+			if (BigQueue->Size() > 512)
+			{
+				Take(BigQueue->Pop());
+			}
+			BigQueue->Push(&Values[i]);
+		}
+
+		while (INT32* Item = BigQueue->Pop())
+		{
+			Take(Item);
+		}
+
+		Done = true;
+		for (std::thread& Thief : Thieves)
+		{
+			Thief.join();
+		}
+		delete BigQueue;
+
+		for (INT32 i = 0; i < ItemCount; ++i)
+		{
+			REQUIRE(TimesTaken[i] == 1);
+		}
+	}
+}
+
+TEST_CASE("Job System", "[utils]")
+{
+	using namespace Fling;
+	JobSystem::Get().Init(4);
+
+	SECTION("Every child job runs before the parent is finished")
+	{
+		std::atomic<INT32> Counter { 0 };
+
+		for (INT32 Iter = 0; Iter < 100; ++Iter)
+		{
+			Job* Root = JobSystem::CreateJob([] {});
+			for (INT32 i = 0; i < 1000; ++i)
+			{
+				JobSystem::Run(JobSystem::CreateJobAsChild(Root, [&Counter] { Counter++; }));
+			}
+			JobSystem::Run(Root);
+			JobSystem::Wait(Root);
+
+			REQUIRE(JobSystem::IsFinished(Root));
+			REQUIRE(Counter == (Iter + 1) * 1000);
+		}
+	}
+
+	SECTION("Jobs can spawn their own children")
+	{
+		std::atomic<INT32> Counter { 0 };
+
+		Job* Root = JobSystem::CreateJob([&Counter](Job* t_Job)
+		{
+			for (INT32 i = 0; i < 100; ++i)
+			{
+				JobSystem::Run(JobSystem::CreateJobAsChild(t_Job, [&Counter] { Counter++; }));
+			}
+		});
+		JobSystem::Run(Root);
+		JobSystem::Wait(Root);
+
+		REQUIRE(Counter == 100);
+	}
+
+	SECTION("Parallel for visits every index once")
+	{
+		const UINT32 Count = 1000000;
+		std::vector<UINT8> Visited(Count, 0);
+
+		JobSystem::ParallelFor(Count, 128, [&Visited](UINT32 t_Begin, UINT32 t_End)
+		{
+			for (UINT32 i = t_Begin; i < t_End; ++i)
+			{
+				Visited[i]++;
+			}
+		});
+
+		bool AllVisitedOnce = true;
+		for (UINT8 Visits : Visited)
+		{
+			AllVisitedOnce &= (Visits == 1);
+		}
+		REQUIRE(AllVisitedOnce);
+	}
+
+	SECTION("Parallel for runs inline off the job threads")
+	{
+		UINT32 Calls = 0;
+		UINT32 Visited = 0;
+		std::thread Loader([&Calls, &Visited]()
+		{
+			JobSystem::ParallelFor(1000, 10, [&Calls, &Visited](UINT32 t_Begin, UINT32 t_End)
+			{
+				++Calls;
+				Visited += t_End - t_Begin;
+			});
+		});
+		Loader.join();
+
+		REQUIRE(Calls == 1);
+		REQUIRE(Visited == 1000);
+	}
+
+	SECTION("Parallel for each over an entt view")
+	{
+		entt::registry Registry;
+		for (INT32 i = 0; i < 10000; ++i)
+		{
+			entt::entity Ent = Registry.create();
+			Registry.assign<INT32>(Ent, i);
+		}
+
+		auto View = Registry.view<INT32>();
+		JobSystem::ParallelForEach(View, [&View](entt::entity t_Ent)
+		{
+			View.get(t_Ent) *= 2;
+		});
+
+		bool AllDoubled = true;
+		INT64 Sum = 0;
+		View.each([&](INT32& t_Val) { Sum += t_Val; AllDoubled &= (t_Val % 2 == 0); });
+		REQUIRE(AllDoubled);
+		REQUIRE(Sum == 2 * (9999LL * 10000LL / 2));
+	}
+
+	JobSystem::Get().Shutdown();
+}
+
+TEST_CASE("Job System throughput", "[utils][.benchmark]")
+{
+	using namespace Fling;
+
+	const UINT32 MaxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	const INT32 JobsPerBatch = 1000;
+	const INT32 Batches = 1000;
+
+	for (UINT32 ThreadCount = 1; ThreadCount <= MaxThreads; ThreadCount *= 2)
+	{
+		JobSystem::Get().Init(ThreadCount);
+
+		auto Start = std::chrono::high_resolution_clock::now();
+		for (INT32 Batch = 0; Batch < Batches; ++Batch)
+		{
+			Job* Root = JobSystem::CreateJob([] {});
+			for (INT32 i = 0; i < JobsPerBatch; ++i)
+			{
+				JobSystem::Run(JobSystem::CreateJobAsChild(Root, [] {}));
+			}
+			JobSystem::Run(Root);
+			JobSystem::Wait(Root);
+		}
+		auto End = std::chrono::high_resolution_clock::now();
+
+		const double Seconds = std::chrono::duration<double>(End - Start).count();
+		std::cout << "[Benchmark] " << ThreadCount << " threads: "
+			<< (static_cast<double>(Batches) * (JobsPerBatch + 1) / Seconds / 1000000.0) << " million empty jobs per second" << std::endl;
+
+		JobSystem::Get().Shutdown();
+	}
+}
+
+TEST_CASE("Ring Allocator", "[utils]")
+{
+	using namespace Fling;
+
+	// 2 frames in flight, just like the renderer
+	RingAllocator Ring(1024, 2);
+	Ring.BeginFrame();
+	REQUIRE(Ring.GetFrameIndex() == 0);
+
+	SECTION("Aligned offsets")
+	{
+		UINT64 Offset = 0;
+		REQUIRE(Ring.Allocate(10, 256, Offset));
+		REQUIRE(Offset == 0);
+		REQUIRE(Ring.Allocate(10, 256, Offset));
+		REQUIRE(Offset == 256);
+		// Padding between the two counts as used
+		REQUIRE(Ring.GetUsedSize() == 266);
+	}
+
+	SECTION("Fails when the frames in flight use everything")
+	{
+		UINT64 Offset = 0;
+		REQUIRE(Ring.Allocate(512, 16, Offset));
+
+		Ring.BeginFrame();
+		REQUIRE(Ring.Allocate(512, 16, Offset));
+		REQUIRE(Offset == 512);
+
+		// Both frames are still in flight
+		REQUIRE_FALSE(Ring.Allocate(16, 16, Offset));
+		REQUIRE(Ring.GetUsedSize() == 1024);
+	}
+
+	SECTION("Frames are freed when they come back around")
+	{
+		UINT64 Offset = 0;
+		REQUIRE(Ring.Allocate(512, 16, Offset));
+		Ring.BeginFrame();
+		REQUIRE(Ring.Allocate(256, 16, Offset));
+
+		// Frame 0 is done, frame 1 is still using [512, 768)
+		Ring.BeginFrame();
+		REQUIRE(Ring.GetFrameIndex() == 0);
+		REQUIRE(Ring.GetUsedSize() == 256);
+	}
+
+	SECTION("Wraps to the front without splitting a range")
+	{
+		UINT64 Offset = 0;
+		REQUIRE(Ring.Allocate(768, 16, Offset));
+		Ring.BeginFrame();
+		REQUIRE(Ring.Allocate(128, 16, Offset));
+		REQUIRE(Offset == 768);
+
+		// Frame 0 is done, there are 128 bytes at the end which is not enough
+		Ring.BeginFrame();
+		REQUIRE(Ring.Allocate(256, 16, Offset));
+		REQUIRE(Offset == 0);
+		// The skipped tail is counted until this frame is freed
+		REQUIRE(Ring.GetUsedSize() == 128 + 128 + 256);
+
+		// Can't run into the range that frame 1 is still using
+		REQUIRE_FALSE(Ring.Allocate(640, 16, Offset));
+		REQUIRE(Ring.Allocate(512, 16, Offset));
+		REQUIRE(Offset == 256);
+
+		Ring.BeginFrame();
+		Ring.BeginFrame();
+		REQUIRE(Ring.GetUsedSize() == 0);
+	}
+
+	SECTION("Starts at the front when nothing is in flight")
+	{
+		UINT64 Offset = 0;
+		REQUIRE(Ring.Allocate(100, 16, Offset));
+		Ring.BeginFrame();
+		Ring.BeginFrame();
+		REQUIRE(Ring.GetUsedSize() == 0);
+
+		REQUIRE(Ring.Allocate(1024, 16, Offset));
+		REQUIRE(Offset == 0);
+	}
+
+	SECTION("Too big for the ring")
+	{
+		UINT64 Offset = 0;
+		REQUIRE_FALSE(Ring.Allocate(2048, 16, Offset));
+		REQUIRE(Ring.GetUsedSize() == 0);
+	}
+}
+
+TEST_CASE("Moving average", "[utils]")
+{
+	using namespace Fling;
+
+	MovingAverage<float, 4> Average;
+
+	SECTION("Empty")
+	{
+		REQUIRE(Average.GetAverage() == 0.0f);
+	}
+
+	SECTION("Averages the newest samples")
+	{
+		Average.Push(1.0f);
+		Average.Push(3.0f);
+		REQUIRE(Average.GetAverage() == Approx(2.0f));
+
+		for (int i = 0; i < 4; ++i)
+		{
+			Average.Push(10.0f);
+		}
+		REQUIRE(Average.GetAverage() == Approx(10.0f));
+	}
+}
+
+TEST_CASE("Batch Ring Allocator", "[utils]")
+{
+	using namespace Fling;
+
+	BatchRingAllocator Ring(1024);
+
+	SECTION("Offsets can be aligned to any size")
+	{
+		UINT64 Offset = 0;
+		REQUIRE(Ring.Allocate(0, 10, 16, Offset));
+		REQUIRE(Offset == 0);
+		// Texels of 3 half floats need a multiple of 12
+		REQUIRE(Ring.Allocate(0, 10, 12, Offset));
+		REQUIRE(Offset == 12);
+		REQUIRE(Ring.GetUsedSize() == 22);
+	}
+
+	SECTION("Releasing every batch frees the whole ring")
+	{
+		UINT64 Offset = 0;
+		REQUIRE(Ring.Allocate(0, 512, 16, Offset));
+		REQUIRE(Ring.Allocate(1, 512, 16, Offset));
+		REQUIRE_FALSE(Ring.Allocate(2, 16, 16, Offset));
+
+		Ring.Release(0);
+		REQUIRE(Ring.GetUsedSize() == 512);
+		Ring.Release(1);
+		REQUIRE(Ring.GetUsedSize() == 0);
+
+		REQUIRE(Ring.Allocate(2, 1024, 16, Offset));
+		REQUIRE(Offset == 0);
+	}
+
+	SECTION("Newer batches wait for older ones")
+	{
+		UINT64 Offset = 0;
+		REQUIRE(Ring.Allocate(0, 256, 16, Offset));
+		REQUIRE(Ring.Allocate(1, 256, 16, Offset));
+
+		// Batch 1 finished first, but batch 0 is still in front of it
+		Ring.Release(1);
+		REQUIRE(Ring.GetUsedSize() == 512);
+
+		Ring.Release(0);
+		REQUIRE(Ring.GetUsedSize() == 0);
+	}
+
+	SECTION("Batches that record at the same time")
+	{
+		UINT64 Offset = 0;
+		REQUIRE(Ring.Allocate(0, 256, 16, Offset));
+		REQUIRE(Ring.Allocate(1, 256, 16, Offset));
+		REQUIRE(Ring.Allocate(0, 256, 16, Offset));
+		REQUIRE(Offset == 512);
+
+		// Batch 0 owns both ends, its second range can't be freed until 1 is done
+		Ring.Release(0);
+		REQUIRE(Ring.GetUsedSize() == 512);
+		Ring.Release(1);
+		REQUIRE(Ring.GetUsedSize() == 0);
+	}
+
+	SECTION("Wraps to the front without splitting a range")
+	{
+		UINT64 Offset = 0;
+		REQUIRE(Ring.Allocate(0, 768, 16, Offset));
+		REQUIRE(Ring.Allocate(1, 128, 16, Offset));
+		Ring.Release(0);
+
+		// 128 bytes are left at the end which is not enough
+		REQUIRE(Ring.Allocate(2, 256, 16, Offset));
+		REQUIRE(Offset == 0);
+		REQUIRE(Ring.GetUsedSize() == 128 + 128 + 256);
+
+		// Can't run into the range that batch 1 is still using
+		REQUIRE_FALSE(Ring.Allocate(2, 640, 16, Offset));
+		REQUIRE(Ring.Allocate(2, 512, 16, Offset));
+		REQUIRE(Offset == 256);
+	}
+
+	SECTION("Releasing a batch that never allocated")
+	{
+		UINT64 Offset = 0;
+		REQUIRE(Ring.Allocate(0, 100, 16, Offset));
+		Ring.Release(5);
+		REQUIRE(Ring.GetUsedSize() == 100);
+		REQUIRE_FALSE(Ring.Allocate(1, 2048, 16, Offset));
+	}
+}
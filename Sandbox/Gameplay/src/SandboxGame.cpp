@@ -156,8 +156,9 @@ namespace Sandbox
 
 		AddFloor("Models/cube.obj", "Materials/Cobblestone.mat", glm::vec3(40.0f, 0.1f, 40.0f));
 
-		// Add a bunch of random light bois
-		for (size_t i = 0; i < DeferredLightSettings::MaxPointLights; i++)
+		// Add a bunch of random light bois, lights are clustered so this can go way up
+		const UINT32 PointLightCount = 128;
+		for (UINT32 i = 0; i < PointLightCount; i++)
 		{
 			AddRandomPointLight();
 		}
@@ -308,6 +309,8 @@ namespace Sandbox
     {
         float AvgFrameTime = Fling::Stats::Frames::GetAverageFrameTime();
         F_LOG_TRACE("Frame time: {} FPS: {}", AvgFrameTime, (1.0f / AvgFrameTime));
+        F_LOG_TRACE("CPU waiting on GPU: {:.3f} ms GPU busy: {:.3f} ms", 
+            Fling::Stats::Frames::GetAverageCpuWaitTime() * 1000.0f, Fling::Stats::Frames::GetAverageGpuTime() * 1000.0f);
   }
 
 	void Game::SetWindowFullscreen()
@@ -0,0 +1,98 @@
+#include "pch.h"
+#include "MeshFile.h"
+#include "MeshImporter.h"
+#include "JobSystem.h"
+
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	bool CookModel(const fs::path& t_Source, bool t_Force, Fling::MeshImporter::NormalMode t_Normals, UINT32& t_OutCooked)
+	{
+		const std::string SourcePath = t_Source.string();
+		const std::string CookedPath = Fling::MeshFile::GetCookedPath(SourcePath);
+
+		if (!t_Force && Fling::MeshFile::IsUpToDate(SourcePath, CookedPath))
+		{
+			return true;
+		}
+
+		if (!Fling::MeshImporter::Cook(SourcePath, CookedPath, t_Normals))
+		{
+			F_LOG_ERROR("Failed to cook {}", SourcePath);
+			return false;
+		}
+
+		F_LOG_TRACE("Cooked {}", CookedPath);
+		++t_OutCooked;
+		return true;
+	}
+}
+
+/**
+* Cooks .obj models into .flmesh files next to them. Cooks every model in the
+* engine assets directory if no paths are given. --smooth-normals ignores the
+* normals in the models and generates smooth ones.
+*
+* Usage: MeshCooker [--force] [--smooth-normals] [files or directories...]
+*/
+int main(int argc, char* argv[])
+{
+	Fling::Logger::Get().Init();
+
+	// Normals and tangents are generated on the job system
+	Fling::JobSystem::Get().Init();
+
+	bool Force = false;
+	Fling::MeshImporter::NormalMode Normals = Fling::MeshImporter::NormalMode::FromFile;
+	std::vector<fs::path> Paths;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--force") == 0)
+		{
+			Force = true;
+		}
+		else if (std::strcmp(argv[i], "--smooth-normals") == 0)
+		{
+			Normals = Fling::MeshImporter::NormalMode::Smooth;
+		}
+		else
+		{
+			Paths.emplace_back(argv[i]);
+		}
+	}
+
+	if (Paths.empty())
+	{
+		Paths.emplace_back(Fling::FlingPaths::EngineAssetsDir());
+	}
+
+	bool Succeeded = true;
+	UINT32 Cooked = 0;
+	for (const fs::path& Path : Paths)
+	{
+		if (fs::is_directory(Path))
+		{
+			for (const fs::directory_entry& Entry : fs::recursive_directory_iterator(Path))
+			{
+				if (Entry.is_regular_file() && Entry.path().extension() == ".obj")
+				{
+					Succeeded &= CookModel(Entry.path(), Force, Normals, Cooked);
+				}
+			}
+		}
+		else
+		{
+			Succeeded &= CookModel(Path, Force, Normals, Cooked);
+		}
+	}
+
+	F_LOG_TRACE("Cooked {} models", Cooked);
+
+	Fling::JobSystem::Get().Shutdown();
+	Fling::Logger::Get().Shutdown();
+
+	return Succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
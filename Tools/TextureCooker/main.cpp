@@ -0,0 +1,146 @@
+#include "pch.h"
+#include "TextureFile.h"
+#include "TextureImporter.h"
+#include "JobSystem.h"
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <nlohmann/json.hpp>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	/** How each texture slot of a material is sampled */
+	const std::pair<const char*, Fling::TextureUsage> MaterialSlots[] =
+	{
+		{ "albedo",	Fling::TextureUsage::Color },
+		{ "normal",	Fling::TextureUsage::Normal },
+		{ "metal",	Fling::TextureUsage::Mask },
+		{ "rough",	Fling::TextureUsage::Mask },
+	};
+
+	/** Find the textures of a material and what they are used as */
+	bool GatherTextures(const fs::path& t_Material, std::map<std::string, Fling::TextureUsage>& t_OutTextures)
+	{
+		try
+		{
+			std::ifstream File(t_Material);
+			nlohmann::json Json;
+			File >> Json;
+
+			for (const auto& Slot : MaterialSlots)
+			{
+				const auto It = Json.find(Slot.first);
+				if (It != Json.end())
+				{
+					// Material paths are relative to the assets, the same as resource GUIDs
+					const std::string TexturePath = Fling::FlingPaths::EngineAssetsDir() + "/" + It->get<std::string>();
+					t_OutTextures.emplace(TexturePath, Slot.second);
+				}
+			}
+		}
+		catch (std::exception& e)
+		{
+			F_LOG_ERROR("Failed to read material {} : {}", t_Material.string(), e.what());
+			return false;
+		}
+		return true;
+	}
+
+	bool CookTexture(const std::string& t_SourcePath, Fling::TextureUsage t_Usage, bool t_Force, bool t_CompactColor, UINT32& t_OutCooked)
+	{
+		const std::string CookedPath = Fling::TextureFile::GetCookedPath(t_SourcePath);
+
+		if (!t_Force && Fling::TextureFile::IsUpToDate(t_SourcePath, CookedPath))
+		{
+			return true;
+		}
+
+		Fling::TextureCookStats Stats = {};
+		if (!Fling::TextureImporter::Cook(t_SourcePath, CookedPath, t_Usage, t_CompactColor, &Stats))
+		{
+			F_LOG_ERROR("Failed to cook {}", t_SourcePath);
+			return false;
+		}
+
+		F_LOG_TRACE("Cooked {} as {} with {} mips, {} KB -> {} KB, {:.2f} dB", CookedPath,
+			Fling::BlockCompression::GetFormatName(Stats.Format), Stats.MipCount, Stats.SourceSize / 1024, Stats.CompressedSize / 1024, Stats.PSNR);
+		++t_OutCooked;
+		return true;
+	}
+}
+
+/**
+* Cooks the textures of materials into .fltex files next to them. Albedo is
+* encoded as BC7, normal maps as BC5 and metal and roughness as BC4. Cooks the
+* textures of every material in the engine assets directory if no paths are given.
+* --compact-color uses BC1, or BC3 with alpha, for albedo instead of BC7.
+*
+* Usage: TextureCooker [--force] [--compact-color] [materials or directories...]
+*/
+int main(int argc, char* argv[])
+{
+	Fling::Logger::Get().Init();
+
+	// Blocks are encoded on the job system
+	Fling::JobSystem::Get().Init();
+
+	bool Force = false;
+	bool CompactColor = false;
+	std::vector<fs::path> Paths;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--force") == 0)
+		{
+			Force = true;
+		}
+		else if (std::strcmp(argv[i], "--compact-color") == 0)
+		{
+			CompactColor = true;
+		}
+		else
+		{
+			Paths.emplace_back(argv[i]);
+		}
+	}
+
+	if (Paths.empty())
+	{
+		Paths.emplace_back(Fling::FlingPaths::EngineAssetsDir() + "/Materials");
+	}
+
+	bool Succeeded = true;
+	std::map<std::string, Fling::TextureUsage> Textures;
+	for (const fs::path& Path : Paths)
+	{
+		if (fs::is_directory(Path))
+		{
+			for (const fs::directory_entry& Entry : fs::recursive_directory_iterator(Path))
+			{
+				if (Entry.is_regular_file() && Entry.path().extension() == ".mat")
+				{
+					Succeeded &= GatherTextures(Entry.path(), Textures);
+				}
+			}
+		}
+		else
+		{
+			Succeeded &= GatherTextures(Path, Textures);
+		}
+	}
+
+	UINT32 Cooked = 0;
+	for (const auto& Texture : Textures)
+	{
+		Succeeded &= CookTexture(Texture.first, Texture.second, Force, CompactColor, Cooked);
+	}
+
+	F_LOG_TRACE("Cooked {} textures", Cooked);
+
+	Fling::JobSystem::Get().Shutdown();
+	Fling::Logger::Get().Shutdown();
+
+	return Succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}